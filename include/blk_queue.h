@@ -0,0 +1,131 @@
+/* IKOS Block Queue - request merging and ordering above a block device
+ *
+ * Every storage user (FAT, the checkpoint and keyframe stores, the journal)
+ * calls a fat_block_device_t directly, one synchronous command per call:
+ * a checkpoint goes out as one 1-sector metadata write and one 8-sector
+ * page write per record, and FAT copies are synced run by run, in whatever
+ * order the caller happens to produce.
+ *
+ * A blk_queue stacks on such a device and presents the same interface. While
+ * it is unplugged it writes through, so callers that depend on ordering (a
+ * superblock flip, a journal commit) see no difference. Between plug and
+ * unplug, writes are copied into the queue instead:
+ *
+ *   - a write touching the end of a queued request is appended to it (back
+ *     merge), one touching its start is prepended (front merge), and one
+ *     bridging two requests joins them, up to max_sectors per request;
+ *   - a write over sectors already queued updates the queued copy, so the
+ *     newest data is what reaches the disk whatever the dispatch order;
+ *   - unplug dispatches in one ascending sweep from where the head last
+ *     stopped (C-SCAN), except that a request queued longer than
+ *     `write_expire` ticks goes first, so a sweep cannot starve it.
+ *
+ * Reads always go straight to the device, with any queued sectors in the
+ * range copied over the result. The queue dispatches on its own when it
+ * holds max_requests requests; a write it has no memory for is written
+ * through after the queue is dispatched.
+ *
+ * Every command the device completes is timed into a log2 latency
+ * histogram, per direction; for queued writes the time runs from the first
+ * write merged into the request.
+ *
+ * Pure: the lower device and a clock come in through ops, so the host test
+ * runs it over an array. Callers serialize access.
+ */
+
+#ifndef BLK_QUEUE_H
+#define BLK_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "fat.h"   /* fat_block_device_t */
+
+#define BLK_QUEUE_MAX_SECTORS       128     /* Largest merged request (64 KiB) */
+#define BLK_QUEUE_MAX_REQUESTS      64      /* Queued requests before dispatch */
+#define BLK_QUEUE_WRITE_EXPIRE      100     /* Ticks before a write jumps the sweep */
+#define BLK_LATENCY_BUCKETS         16      /* Bucket i: [2^(i-1), 2^i) ticks; last is open */
+
+/* Result codes */
+#define BLK_QUEUE_OK                0
+#define BLK_QUEUE_EIO               -1
+#define BLK_QUEUE_EINVAL            -2
+#define BLK_QUEUE_ENOMEM            -3
+
+typedef struct blk_request {
+    struct blk_request* next;           /* Queue, by start sector */
+    uint32_t sector;
+    uint32_t count;
+    uint32_t capacity;                  /* Sectors the buffer holds */
+    uint64_t queued_at;                 /* Tick of the oldest write merged in */
+    uint8_t* data;
+} blk_request_t;
+
+typedef struct blk_queue_ops {
+    uint64_t (*now)(void* ctx);         /* Monotonic ticks */
+    void* (*alloc)(size_t size);
+    void (*free)(void* ptr);
+    void* ctx;
+} blk_queue_ops_t;
+
+typedef struct blk_queue_stats {
+    uint64_t reads;                     /* Read calls */
+    uint64_t writes;                    /* Write calls */
+    uint64_t sectors_read;
+    uint64_t sectors_written;
+    uint64_t back_merges;
+    uint64_t front_merges;
+    uint64_t overwrites;                /* Writes over sectors still queued */
+    uint64_t dispatched;                /* Write commands sent to the device */
+    uint64_t expired;                   /* Of those, sent out of sweep order */
+    uint64_t errors;
+    uint32_t max_depth;
+    uint64_t read_latency[BLK_LATENCY_BUCKETS];
+    uint64_t write_latency[BLK_LATENCY_BUCKETS];
+} blk_queue_stats_t;
+
+typedef struct blk_queue {
+    fat_block_device_t dev;             /* What callers use */
+    fat_block_device_t* lower;
+    blk_queue_ops_t ops;
+    blk_request_t* head;                /* Queued writes, ascending, disjoint */
+    uint32_t depth;
+    uint32_t plugged;                   /* Nesting count */
+    uint32_t position;                  /* Sector after the last dispatch */
+    uint32_t max_sectors;
+    uint32_t max_requests;
+    uint64_t write_expire;
+    int error;                          /* First dispatch error since unplug */
+    blk_queue_stats_t stats;
+} blk_queue_t;
+
+/* Stack `q` on `lower`; callers then use &q->dev. Default limits. */
+int blk_queue_init(blk_queue_t* q, fat_block_device_t* lower, const blk_queue_ops_t* ops);
+
+/* Dispatch anything queued and release it. */
+int blk_queue_destroy(blk_queue_t* q);
+
+/* Hold writes back until the matching unplug; plugs nest. */
+void blk_queue_plug(blk_queue_t* q);
+
+/* Leave one plug level; the last one dispatches the queue and returns the
+ * first error any dispatch hit while plugged. */
+int blk_queue_unplug(blk_queue_t* q);
+
+/* Dispatch the queue without unplugging. */
+int blk_queue_run(blk_queue_t* q);
+
+void blk_queue_get_stats(const blk_queue_t* q, blk_queue_stats_t* stats);
+
+/* Plug and unplug any block device; no-ops on devices without a queue. */
+static inline void blk_plug(fat_block_device_t* dev) {
+    if (dev && dev->plug) {
+        dev->plug(dev->private_data);
+    }
+}
+
+static inline int blk_unplug(fat_block_device_t* dev) {
+    return (dev && dev->unplug) ? dev->unplug(dev->private_data) : 0;
+}
+
+#endif /* BLK_QUEUE_H */
@@ -96,6 +96,26 @@ int checkpoint_capture_page(uint32_t pid, uint64_t virt_addr,
  * address-space page. Restore hands these to the kernel-state reassembler
  * (process table, VFS, IPC, ...; #140+) rather than mapping them as memory. */
 #define CHECKPOINT_REC_KERNEL   0x4
+/* Record flag marking further mappings of a read-only page that is persisted
+ * only once (e.g. text shared by every instance of a binary). The
+ * record's pid / virt_addr name that page's own record, written earlier in the
+ * same checkpoint; its data is a checkpoint_alias_page_t. Restore gives each
+ * listed (pid, virt_addr) a read-only copy of the page. */
+#define CHECKPOINT_REC_ALIAS    0x8
+
+#define CHECKPOINT_ALIAS_MAX    255     /* Aliases per record (fills a page) */
+
+typedef struct {
+    uint32_t pid;
+    uint32_t reserved;
+    uint64_t virt_addr;
+} checkpoint_alias_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t reserved;
+    checkpoint_alias_t entries[CHECKPOINT_ALIAS_MAX];
+} checkpoint_alias_page_t;
 
 /* What writeback should do with one page of an address space, given whether its
  * region is writable and its PTE. The decision core of #131, exposed for tests. */
@@ -0,0 +1,113 @@
+/* IKOS Dentry Cache - name lookups without asking the filesystem
+ *
+ * Path lookup used to scan the parent's child list with strcmp for every
+ * component and call the filesystem on every miss, including for names that
+ * do not exist. Here every cached name sits in one hash table keyed by
+ * (parent, name): a component costs one hash of its bytes and a short chain
+ * walk, however many entries the directory has.
+ *
+ * A name the filesystem did not find is cached too, as a negative entry, so
+ * repeated lookups of missing names (a shell searching PATH) are answered
+ * without going to the disk. Whoever creates the name must clear `negative`
+ * (or remove the entry) before anyone looks it up again.
+ *
+ * Entries are reference counted. One with no references left goes on an
+ * LRU list; past max_unused, dcache_put() evicts from the cold end, and
+ * dcache_shrink() does the same on demand. A cached child holds a reference
+ * on its parent, so directories leave the cache only after their children.
+ *
+ * Pure: entries are embedded in the caller's objects and names point at the
+ * caller's storage; eviction hands the entry back through ops->evict. The
+ * host test runs it over plain structs. Callers serialize access.
+ */
+
+#ifndef DCACHE_H
+#define DCACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define DCACHE_DEFAULT_BUCKETS      1024    /* Rounded down to a power of two */
+
+/* Result codes */
+#define DCACHE_OK                   0
+#define DCACHE_ENOMEM               -1
+
+typedef struct dcache_entry {
+    struct dcache_entry* hash_next;     /* Chain in the bucket */
+    struct dcache_entry* lru_prev;      /* On the LRU while unused */
+    struct dcache_entry* lru_next;
+    struct dcache_entry* parent;        /* Key, with the name */
+    const char* name;                   /* Owner's storage; len bytes */
+    uint32_t len;
+    uint32_t hash;
+    uint32_t refs;
+    bool hashed;
+    bool negative;                      /* The name does not exist */
+} dcache_entry_t;
+
+typedef struct dcache_ops {
+    /* An unused entry leaving the cache, already unhashed: free its owner.
+     * Its parent reference is dropped after this returns. */
+    void (*evict)(void* ctx, dcache_entry_t* entry);
+    void* (*alloc)(size_t size);
+    void (*free)(void* ptr);
+    void* ctx;
+} dcache_ops_t;
+
+typedef struct dcache_stats {
+    uint64_t lookups;
+    uint64_t hits;
+    uint64_t negative_hits;             /* Hits on names known not to exist */
+    uint64_t misses;
+    uint64_t evictions;
+} dcache_stats_t;
+
+typedef struct dcache {
+    dcache_entry_t** buckets;
+    uint32_t mask;                      /* Buckets - 1 */
+    dcache_entry_t* lru_head;           /* Coldest unused entry */
+    dcache_entry_t* lru_tail;
+    uint32_t nr_entries;                /* Hashed */
+    uint32_t nr_unused;                 /* On the LRU */
+    uint32_t max_unused;
+    dcache_ops_t ops;
+    dcache_stats_t stats;
+} dcache_t;
+
+/* An empty cache with `buckets` chains; at most max_unused unused entries. */
+int dcache_init(dcache_t* cache, const dcache_ops_t* ops, uint32_t buckets, uint32_t max_unused);
+
+/* Free the hash table. Entries still cached are left to their owners. */
+void dcache_destroy(dcache_t* cache);
+
+/* Hash of `name` (len bytes, not terminated) under `parent`. */
+uint32_t dcache_hash(const dcache_entry_t* parent, const char* name, uint32_t len);
+
+/* An unhashed entry holding one reference for the caller. */
+void dcache_entry_init(dcache_entry_t* entry, const char* name, uint32_t len);
+
+/* The cached child `name` of `parent` with a reference taken, or NULL when
+ * the filesystem has to be asked. `hash` is dcache_hash() of the name. */
+dcache_entry_t* dcache_lookup(dcache_t* cache, const dcache_entry_t* parent, const char* name,
+                              uint32_t len, uint32_t hash);
+
+/* Cache `entry` as a child of `parent`; the entry keeps the caller's
+ * reference and takes one on the parent. */
+void dcache_add(dcache_t* cache, dcache_entry_t* parent, dcache_entry_t* entry, uint32_t hash,
+                bool negative);
+
+void dcache_get(dcache_t* cache, dcache_entry_t* entry);
+
+/* Drop a reference; may evict unused entries past max_unused. */
+void dcache_put(dcache_t* cache, dcache_entry_t* entry);
+
+/* Take an entry out of the cache (its name changed or went away) and drop
+ * its parent reference. The entry's own references are the caller's. */
+void dcache_remove(dcache_t* cache, dcache_entry_t* entry);
+
+/* Evict up to nr_entries unused entries; returns how many went. */
+uint32_t dcache_shrink(dcache_t* cache, uint32_t nr_entries);
+
+#endif /* DCACHE_H */
@@ -154,6 +154,20 @@ int elf_load_process(const void* elf_data, size_t size, uint64_t* entry_point);
 int elf64_parse_headers(const elf64_header_t* header, elf64_program_header_t** phdrs);
 int elf64_load_segment(const void* elf_data, const elf64_program_header_t* phdr, uint64_t base_addr);
 
+/* Shared, demand-paged executable images (see elf_image_cache.h). Mapping
+ * creates one region per PT_LOAD segment and no pages; elf_data may be NULL
+ * when key names an image the cache already holds. */
+struct vm_space;
+struct vm_region;
+struct elf_image;
+struct elf_image_key;
+int elf_map_image(struct vm_space* space, const struct elf_image_key* key,
+                  const void* elf_data, size_t size, uint64_t* entry_point);
+int elf_image_cached(const struct elf_image_key* key);
+int elf_image_fault(struct vm_space* space, struct vm_region* region, uint64_t fault_addr);
+void elf_image_get(struct elf_image* image);
+void elf_image_put(struct elf_image* image);
+
 /* Kernel Loading Constants */
 #define KERNEL_LOAD_ADDRESS     0x100000    /* 1MB - Standard kernel load address */
 #define KERNEL_MAX_SIZE         0x400000    /* 4MB - Maximum kernel size */
@@ -0,0 +1,133 @@
+/* IKOS ELF Image Cache - executable pages shared across processes
+ *
+ * Loading a process used to allocate fresh pages for every PT_LOAD segment
+ * and copy the file into them, so N instances of one binary held N copies of
+ * identical text. Here a loaded image is cached, keyed by file identity, and
+ * every process mapping it is backed by the same frames:
+ *   - read-only segments map the image's frame directly, read-only;
+ *   - writable segments map the same pristine frame copy-on-write, so a
+ *     process only pays for the data pages it actually writes;
+ *   - pages that hold nothing from the file (pure .bss) are left to the
+ *     caller as ordinary anonymous zero pages.
+ * Nothing is mapped at load time: frames are filled on the first fault of
+ * any process and reused by the rest.
+ *
+ * The cache holds one reference on every frame it filled; each mapping holds
+ * another, so a frame outlives the image only while someone still maps it.
+ * Images no region uses stay cached on an LRU list so a short-lived program
+ * run over and over keeps its frames, up to ELF_IMAGE_CACHE_MAX_IDLE.
+ *
+ * Pure: frames and memory come from the caller's ops, so the kernel passes
+ * its frame allocator and the host test a simulated physical memory.
+ */
+
+#ifndef ELF_IMAGE_CACHE_H
+#define ELF_IMAGE_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define ELF_IMAGE_MAX_SEGMENTS      8
+#define ELF_IMAGE_CACHE_BUCKETS     64
+#define ELF_IMAGE_CACHE_MAX_IDLE    16      /* Unused images kept for reuse */
+
+/* Key device for images known only by content: ino is a hash of the bytes */
+#define ELF_IMAGE_DEV_ANON          0xFFFFFFFFFFFFFFFFULL
+
+/* Result codes */
+#define ELF_IMAGE_OK                0
+#define ELF_IMAGE_ENOEXEC           -1      /* Not a loadable 64-bit executable */
+#define ELF_IMAGE_ENOMEM            -2
+#define ELF_IMAGE_EFAULT            -3      /* Address not inside the image */
+
+/* Which file an image came from. Two keys name the same image only if every
+ * field matches, so a rewritten file (new mtime or size) loads afresh. */
+typedef struct elf_image_key {
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t mtime;
+    uint64_t size;
+} elf_image_key_t;
+
+typedef struct elf_image_segment {
+    uint64_t vaddr;                 /* p_vaddr */
+    uint64_t offset;                /* p_offset */
+    uint64_t filesz;                /* Bytes backed by the file */
+    uint64_t memsz;                 /* Bytes mapped (the rest is zero) */
+    uint64_t page_start;            /* vaddr rounded down to a page */
+    uint32_t page_count;
+    uint32_t flags;                 /* PF_R / PF_W / PF_X */
+    uint64_t* frames;               /* Pristine frame per page; 0 until filled */
+} elf_image_segment_t;
+
+typedef struct elf_image {
+    elf_image_key_t key;
+    uint64_t entry;                 /* e_entry */
+    uint32_t segment_count;
+    elf_image_segment_t segments[ELF_IMAGE_MAX_SEGMENTS];
+    void* data;                     /* Cache's copy of the file: source of fills */
+    size_t size;
+    uint32_t users;                 /* Regions mapping the image */
+    struct elf_image* hash_next;
+    struct elf_image* idle_prev;    /* LRU of images with no users */
+    struct elf_image* idle_next;
+} elf_image_t;
+
+typedef struct elf_image_ops {
+    uint64_t (*alloc_frame)(void);  /* Zeroed frame, one reference; 0 if none */
+    void (*get_frame)(uint64_t phys);
+    void (*put_frame)(uint64_t phys);   /* Drops a reference, frees at zero */
+    void* (*frame_ptr)(uint64_t phys);  /* Kernel pointer to a frame */
+    void* (*alloc)(size_t size);
+    void (*free)(void* ptr);
+} elf_image_ops_t;
+
+typedef struct elf_image_stats {
+    uint64_t hits;                  /* Loads served by a cached image */
+    uint64_t misses;                /* Loads that parsed a new image */
+    uint64_t evictions;             /* Idle images dropped */
+    uint64_t page_fills;            /* Frames filled from the file */
+    uint64_t page_shares;           /* Faults served by an already filled frame */
+} elf_image_stats_t;
+
+typedef struct elf_image_cache {
+    elf_image_ops_t ops;
+    elf_image_t* buckets[ELF_IMAGE_CACHE_BUCKETS];
+    elf_image_t* idle_head;         /* Most recently released */
+    elf_image_t* idle_tail;
+    uint32_t idle_count;
+    uint32_t image_count;
+    elf_image_stats_t stats;
+} elf_image_cache_t;
+
+void elf_image_cache_init(elf_image_cache_t* cache, const elf_image_ops_t* ops);
+
+/* Key for an image known only by its bytes (no file behind it). */
+void elf_image_key_from_data(elf_image_key_t* key, const void* data, size_t size);
+
+/* Look the image up by key, or parse data (size bytes) into a new one. On
+ * success *out has one more user; the caller may free data straight away. */
+int elf_image_acquire(elf_image_cache_t* cache, const elf_image_key_t* key,
+                      const void* data, size_t size, elf_image_t** out);
+
+/* Another user of an image already in use (a region copied by fork or split). */
+void elf_image_retain(elf_image_t* image);
+
+/* Drop a user. The last one parks the image on the idle list, evicting the
+ * least recently used idle image beyond ELF_IMAGE_CACHE_MAX_IDLE. */
+void elf_image_release(elf_image_cache_t* cache, elf_image_t* image);
+
+/* Segment containing vaddr, or NULL. */
+const elf_image_segment_t* elf_image_segment_at(const elf_image_t* image, uint64_t vaddr);
+
+/* Frame backing the page at vaddr, filled from the file on first use, with a
+ * reference taken for the caller's mapping. *phys is 0 for a page holding
+ * nothing from the file, which the caller maps as a fresh zero page. */
+int elf_image_page(elf_image_cache_t* cache, elf_image_t* image, uint64_t vaddr,
+                   uint64_t* phys);
+
+/* Drop every idle image. Images in use are untouched. */
+void elf_image_cache_shrink(elf_image_cache_t* cache);
+
+#endif /* ELF_IMAGE_CACHE_H */
@@ -13,6 +13,8 @@
 #define EXT2_H
 
 #include "vfs.h"
+#include "ext2_blockmap.h"
+#include "ext2_groups.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -321,6 +323,7 @@ typedef struct ext2_fs_info {
     /* Caching */
     void* block_cache;                  /* Block cache */
     void* inode_cache;                  /* Inode cache */
+    ext2_groups_t groups;               /* Cached allocation bitmaps */
 } ext2_fs_info_t;
 
 /* ext2/ext4 inode information */
@@ -333,6 +336,8 @@ typedef struct ext2_inode_info {
     uint32_t block_count;               /* Number of allocated blocks */
     bool is_extent_based;               /* Uses extent tree */
     ext4_extent_header_t* extent_root;  /* Root of extent tree */
+    ext2_blockmap_t block_map;          /* Cached pointer walks (non-extent files) */
+    ext2_prealloc_t prealloc;           /* Blocks reserved for appends */
 } ext2_inode_info_t;
 
 /* Block device interface */
@@ -388,11 +393,13 @@ int ext2_setattr(vfs_dentry_t* dentry, const vfs_stat_t* stat);
 /* File operations */
 ssize_t ext2_read(vfs_file_t* file, char* buffer, size_t count, uint64_t* pos);
 ssize_t ext2_write(vfs_file_t* file, const char* buffer, size_t count, uint64_t* pos);
+int ext2_release(vfs_inode_t* inode, vfs_file_t* file);
 int ext2_readdir(vfs_file_t* file, vfs_dirent_t* dirent);
 uint64_t ext2_llseek(vfs_file_t* file, uint64_t offset, int whence);
 
 /* Block and inode management */
 int ext2_read_block(ext2_fs_info_t* fs, uint64_t block, void* buffer);
+int ext2_read_blocks(ext2_fs_info_t* fs, uint64_t block, uint32_t count, void* buffer);
 int ext2_write_block(ext2_fs_info_t* fs, uint64_t block, const void* buffer);
 int ext2_read_inode(ext2_fs_info_t* fs, uint32_t inode_num, ext2_inode_t* inode);
 int ext2_write_inode(ext2_fs_info_t* fs, uint32_t inode_num, const ext2_inode_t* inode);
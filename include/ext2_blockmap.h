@@ -0,0 +1,109 @@
+/* IKOS ext2 Block Map - file blocks to disk blocks through indirect blocks
+ *
+ * An ext2 inode holds 15 block pointers: 12 point at data, the 13th at a
+ * block of pointers to data (indirect), the 14th at a block of pointers to
+ * indirect blocks (double), and the 15th one level deeper again (triple).
+ * With 4 KiB blocks that reaches 1024 + 1024^2 + 1024^3 blocks past the 12
+ * direct ones.
+ *
+ * Walking that tree for every block read would cost up to three extra disk
+ * reads per data block, so each inode keeps a small cache:
+ *
+ *   - the indirect blocks it has read, so neighbouring lookups under the
+ *     same pointer block cost no I/O, and
+ *   - the mappings it has resolved, merged into runs of consecutive disk
+ *     blocks:
+ *
+ *         file blocks 0..11    -> disk blocks 5000..5011
+ *         file blocks 12..1035 -> disk blocks 5013..6036
+ *
+ * A lookup answers with the whole run from the requested block, so a large
+ * read becomes one device request per run.
+ *
+ * With `create`, missing data and pointer blocks are allocated (pointer
+ * blocks zeroed and written at once) and the inode's pointers updated;
+ * i_block_dirty tells the caller to write the inode.
+ *
+ * Pure: disk access and allocation go through the caller's ops, so the host
+ * test runs it over an in-memory disk. Callers serialize access per inode.
+ */
+
+#ifndef EXT2_BLOCKMAP_H
+#define EXT2_BLOCKMAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define EXT2_BLOCKMAP_NDIR          12      /* Direct pointers in the inode */
+#define EXT2_BLOCKMAP_IND           12      /* i_block slot of the indirect block */
+#define EXT2_BLOCKMAP_DIND          13      /* ... double indirect */
+#define EXT2_BLOCKMAP_TIND          14      /* ... triple indirect */
+
+#define EXT2_BLOCKMAP_EXTENTS       32      /* Runs remembered per inode */
+#define EXT2_BLOCKMAP_IND_CACHE     4       /* Pointer blocks kept per inode */
+
+/* Result codes */
+#define EXT2_BLOCKMAP_OK            0
+#define EXT2_BLOCKMAP_EIO           -1
+#define EXT2_BLOCKMAP_ENOMEM        -2
+#define EXT2_BLOCKMAP_ENOSPC        -3
+#define EXT2_BLOCKMAP_EFBIG         -4      /* Past the triple indirect range */
+
+typedef struct ext2_blockmap_extent {
+    uint32_t file_block;                /* First block of the run, in the file */
+    uint32_t disk_block;                /* Its block number on disk */
+    uint32_t length;                    /* Consecutive blocks in the run */
+} ext2_blockmap_extent_t;
+
+typedef struct ext2_blockmap_ind {
+    uint32_t block;                     /* Disk block held (0 = slot free) */
+    uint32_t* pointers;                 /* Its block_size / 4 pointers */
+    uint32_t last_used;
+} ext2_blockmap_ind_t;
+
+typedef struct ext2_blockmap_stats {
+    uint64_t lookups;
+    uint64_t extent_hits;               /* Answered from the runs, no tree walk */
+    uint64_t ind_reads;                 /* Pointer blocks read from disk */
+    uint64_t allocations;               /* Data and pointer blocks allocated */
+} ext2_blockmap_stats_t;
+
+typedef struct ext2_blockmap {
+    uint32_t* i_block;                  /* The inode's 15 pointers */
+    uint32_t block_size;
+    ext2_blockmap_extent_t extents[EXT2_BLOCKMAP_EXTENTS];     /* In file order */
+    uint32_t nextents;
+    ext2_blockmap_ind_t ind[EXT2_BLOCKMAP_IND_CACHE];
+    uint32_t clock;                     /* Ticks for last_used */
+    bool i_block_dirty;                 /* A pointer in the inode changed */
+    ext2_blockmap_stats_t stats;
+} ext2_blockmap_t;
+
+typedef struct ext2_blockmap_ops {
+    int (*read_block)(void* ctx, uint32_t block, void* buffer);         /* 0 on success */
+    int (*write_block)(void* ctx, uint32_t block, const void* buffer);  /* 0 on success */
+    uint32_t (*alloc_block)(void* ctx, uint32_t goal);  /* 0 when full; goal is a hint */
+    void* (*alloc)(size_t size);
+    void (*free)(void* ptr);
+    void* ctx;
+} ext2_blockmap_ops_t;
+
+/* An empty cache over the inode's pointers. */
+void ext2_blockmap_init(ext2_blockmap_t* map, uint32_t* i_block, uint32_t block_size);
+
+/* Blocks a file can address with this block size. */
+uint64_t ext2_blockmap_max_blocks(uint32_t block_size);
+
+/* Disk block of file block `file_block` in *disk_block (0: a hole), and in
+ * *run how many consecutive disk blocks start there, at most max_blocks (a
+ * hole counts 1). With `create` a hole is filled with a new block. */
+int ext2_blockmap_map(ext2_blockmap_t* map, const ext2_blockmap_ops_t* ops, uint64_t file_block,
+                      uint32_t max_blocks, bool create, uint32_t* disk_block, uint32_t* run);
+
+/* Forget every cached run and free the cached pointer blocks: the pointers
+ * changed under the cache (truncate, inode reread), or the inode is going
+ * away. */
+void ext2_blockmap_invalidate(ext2_blockmap_t* map, const ext2_blockmap_ops_t* ops);
+
+#endif /* EXT2_BLOCKMAP_H */
@@ -0,0 +1,139 @@
+/* IKOS ext2 Group Allocator - block and inode bitmaps per block group
+ *
+ * An ext2 volume is cut into block groups, each with one bitmap block for
+ * its blocks and one for its inodes. The allocator loads a group's bitmaps
+ * the first time it needs them and keeps them in memory; changes stay
+ * there, marked dirty, until ext2_groups_sync() writes them back and the
+ * caller copies the free counts into the group descriptors and superblock.
+ *
+ * Placement follows the goal the caller passes:
+ *
+ *   - blocks: the goal itself if free, else the next free block within 64
+ *     of it, else the start of a free 8-block run later in the group, else
+ *     any free block in the group, then the other groups in order. The goal
+ *     is usually the block after the file's previous one, so files stay
+ *     contiguous.
+ *   - inodes: a file goes into its directory's group while that group has
+ *     free inodes and blocks, else a group found by quadratic probing from
+ *     there. A new directory goes to the group with the most free blocks
+ *     among those with at least the average number of free inodes, which
+ *     spreads directory trees across the disk.
+ *
+ * An appending file also reserves the next few blocks after each new one:
+ * a preallocation window, marked used so no other file takes them. The
+ * file's next allocation comes straight from the window. Whatever is left
+ * is released by ext2_groups_discard() when the file is done with it, or
+ * as soon as the file allocates somewhere else. Windows never reach the
+ * disk: ext2_groups_sync() gives every one back before writing the
+ * bitmaps, so the counts copied afterwards only cover blocks in use.
+ *
+ * Pure: bitmap blocks move through the caller's ops, so the host test runs
+ * it over an in-memory disk. Callers serialize access per filesystem.
+ */
+
+#ifndef EXT2_GROUPS_H
+#define EXT2_GROUPS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define EXT2_GROUPS_NEAR_SCAN       64      /* Blocks past the goal tried first */
+#define EXT2_GROUPS_PREALLOC        8       /* Window reserved after an appending block */
+
+/* Result codes */
+#define EXT2_GROUPS_OK              0
+#define EXT2_GROUPS_EIO             -1
+#define EXT2_GROUPS_ENOMEM          -2
+
+typedef struct ext2_groups_geometry {
+    uint32_t block_size;
+    uint32_t blocks_count;
+    uint32_t first_data_block;          /* 1 for 1 KiB blocks, else 0 */
+    uint32_t blocks_per_group;
+    uint32_t inodes_per_group;
+    uint32_t inodes_count;
+    uint32_t first_ino;                 /* First inode not reserved */
+    uint32_t groups_count;
+} ext2_groups_geometry_t;
+
+typedef struct ext2_group {
+    uint32_t block_bitmap;              /* Disk block of the block bitmap */
+    uint32_t inode_bitmap;              /* ... and of the inode bitmap */
+    uint32_t free_blocks;
+    uint32_t free_inodes;
+    uint32_t used_dirs;
+    uint8_t* blocks;                    /* Cached block bitmap, NULL until loaded */
+    uint8_t* inodes;                    /* Cached inode bitmap */
+    bool blocks_dirty;
+    bool inodes_dirty;
+    bool counts_dirty;                  /* Descriptor counts changed */
+} ext2_group_t;
+
+/* A file's preallocation window: blocks [next, next + count) */
+typedef struct ext2_prealloc {
+    uint32_t next;
+    uint32_t count;
+    struct ext2_prealloc* link;         /* Next window holding blocks */
+    bool listed;                        /* On the allocator's window list */
+} ext2_prealloc_t;
+
+typedef struct ext2_groups_ops {
+    int (*read_block)(void* ctx, uint32_t block, void* buffer);         /* 0 on success */
+    int (*write_block)(void* ctx, uint32_t block, const void* buffer);  /* 0 on success */
+    void* (*alloc)(size_t size);
+    void (*free)(void* ptr);
+    void* ctx;
+} ext2_groups_ops_t;
+
+typedef struct ext2_groups_stats {
+    uint64_t block_allocs;
+    uint64_t goal_hits;                 /* Allocations that got exactly the goal */
+    uint64_t prealloc_hits;             /* ... served from a window */
+    uint64_t bitmap_reads;
+    uint64_t bitmap_writes;
+} ext2_groups_stats_t;
+
+typedef struct ext2_groups {
+    ext2_groups_geometry_t geo;
+    ext2_groups_ops_t ops;
+    ext2_group_t* groups;
+    uint32_t free_blocks;               /* Totals for the superblock */
+    uint32_t free_inodes;
+    ext2_prealloc_t* windows;           /* Windows that have reserved blocks */
+    ext2_groups_stats_t stats;
+} ext2_groups_t;
+
+/* Allocate the per-group table. Fill each group with ext2_groups_set()
+ * before allocating. */
+int ext2_groups_init(ext2_groups_t* groups, const ext2_groups_geometry_t* geo,
+                     const ext2_groups_ops_t* ops);
+
+/* Descriptor fields of group `group`. */
+void ext2_groups_set(ext2_groups_t* groups, uint32_t group, uint32_t block_bitmap,
+                     uint32_t inode_bitmap, uint32_t free_blocks, uint32_t free_inodes,
+                     uint32_t used_dirs);
+
+/* A free block, as near `goal` as possible (0: no preference), or 0 when the
+ * volume is full. With a window, an appending allocation is served from it
+ * and a new one reserved after the block returned. */
+uint32_t ext2_groups_alloc_block(ext2_groups_t* groups, ext2_prealloc_t* window, uint32_t goal);
+
+void ext2_groups_free_block(ext2_groups_t* groups, uint32_t block);
+
+/* Give back what is left of a window. */
+void ext2_groups_discard(ext2_groups_t* groups, ext2_prealloc_t* window);
+
+/* A free inode number for a child of `parent_ino`, or 0 when none is left. */
+uint32_t ext2_groups_alloc_inode(ext2_groups_t* groups, uint32_t parent_ino, bool is_dir);
+
+void ext2_groups_free_inode(ext2_groups_t* groups, uint32_t ino, bool is_dir);
+
+/* Discard every window, then write every dirty bitmap back. Group counts_dirty flags stay set for the
+ * caller, which clears them after copying the counts to the descriptors. */
+int ext2_groups_sync(ext2_groups_t* groups);
+
+/* Free the cached bitmaps and the table (sync first). */
+void ext2_groups_destroy(ext2_groups_t* groups);
+
+#endif /* EXT2_GROUPS_H */
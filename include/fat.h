@@ -9,6 +9,8 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include "vfs.h"
+#include "fat_extent.h"
+#include "fat_bitmap.h"
 
 /* Type definitions for compatibility */
 typedef long long ssize_t;              /* Signed size type */
@@ -139,6 +141,8 @@ typedef struct {
     uint8_t* fat_table;                 /* Cached FAT table */
     uint32_t fat_table_size;            /* FAT table size in bytes */
     bool fat_dirty;                     /* FAT table needs writing */
+    fat_bitmap_t free_map;              /* Set bit = cluster free */
+    fat_bitmap_t dirty_map;             /* Set bit = FAT sector changed since last sync */
     
     /* Block device information */
     void* block_device;                 /* Block device handle */
@@ -154,6 +158,7 @@ typedef struct {
     uint32_t cluster_offset;            /* Offset within current cluster */
     bool is_directory;                  /* Directory flag */
     fat_dir_entry_t dir_entry;          /* Original directory entry */
+    fat_extent_map_t extents;           /* Cluster chain as runs, built on first use */
 } fat_inode_info_t;
 
 /* FAT File Information */
@@ -161,6 +166,7 @@ typedef struct {
     uint32_t current_cluster;           /* Current cluster for I/O */
     uint32_t cluster_offset;            /* Offset within current cluster */
     uint32_t file_position;             /* Current file position */
+    fat_cursor_t cursor;                /* Run of the last cluster looked up */
 } fat_file_info_t;
 
 /* Function prototypes */
@@ -203,18 +209,23 @@ int fat_write_sectors(fat_fs_info_t* fat_info, uint32_t sector,
 
 /* FAT table operations */
 int fat_load_fat_table(fat_fs_info_t* fat_info);
+void fat_unload_fat_table(fat_fs_info_t* fat_info);
 int fat_write_fat_table(fat_fs_info_t* fat_info);
 uint32_t fat_get_cluster_value(fat_fs_info_t* fat_info, uint32_t cluster);
 int fat_set_cluster_value(fat_fs_info_t* fat_info, uint32_t cluster, uint32_t value);
 uint32_t fat_find_free_cluster(fat_fs_info_t* fat_info);
-int fat_allocate_cluster_chain(fat_fs_info_t* fat_info, uint32_t start_cluster, 
-                               uint32_t num_clusters);
-int fat_free_cluster_chain(fat_fs_info_t* fat_info, uint32_t start_cluster);
+int fat_allocate_cluster_chain(fat_fs_info_t* fat_info, fat_inode_info_t* owner,
+                               uint32_t start_cluster, uint32_t num_clusters);
+int fat_free_cluster_chain(fat_fs_info_t* fat_info, fat_inode_info_t* owner,
+                           uint32_t start_cluster);
 
 /* Cluster operations */
 uint32_t fat_sector_to_cluster(fat_fs_info_t* fat_info, uint32_t sector);
 uint32_t fat_cluster_to_sector(fat_fs_info_t* fat_info, uint32_t cluster);
 uint32_t fat_next_cluster(fat_fs_info_t* fat_info, uint32_t cluster);
+uint32_t fat_file_cluster(fat_fs_info_t* fat_info, fat_inode_info_t* inode_info,
+                          fat_cursor_t* cursor, uint32_t index, uint32_t* run);
+void fat_invalidate_extents(fat_inode_info_t* inode_info);
 bool fat_is_cluster_free(fat_fs_info_t* fat_info, uint32_t cluster);
 bool fat_is_cluster_eof(fat_fs_info_t* fat_info, uint32_t cluster);
 bool fat_is_cluster_bad(fat_fs_info_t* fat_info, uint32_t cluster);
@@ -269,6 +280,7 @@ void fat_get_stats(fat_fs_info_t* fat_info, void* stats);
 #define FAT_ERROR_FILE_EXISTS       -8
 #define FAT_ERROR_NOT_FOUND         -9
 #define FAT_ERROR_NOT_EMPTY         -10
+#define FAT_ERROR_NO_MEMORY         -11
 
 /* Block device interface */
 typedef struct {
@@ -277,6 +289,11 @@ typedef struct {
     uint32_t sector_size;
     uint32_t total_sectors;
     void* private_data;
+    /* Optional batching (blk_queue.h): writes between plug and unplug may
+     * be held back and merged; unplug issues them and returns the first
+     * error. NULL on devices that write through. */
+    void (*plug)(void* device);
+    int (*unplug)(void* device);
 } fat_block_device_t;
 
 #endif /* FAT_H */
@@ -0,0 +1,57 @@
+/* IKOS FAT Bitmaps - free clusters and dirty FAT sectors
+ *
+ * The FAT itself says which clusters are free, but only one entry at a time:
+ * finding a free cluster meant scanning the table from cluster 2. The free
+ * map keeps one bit per cluster (set = free) next to the cached table, so a
+ * search skips 64 used clusters per word, and it remembers where the last
+ * allocation ended (next-fit) so consecutive allocations come out
+ * consecutive and a growing file stays in one run.
+ *
+ * The same structure tracks which sectors of the cached FAT were modified
+ * (set = dirty), so a sync writes those sectors, merged into runs, instead of
+ * every FAT copy in full.
+ *
+ * Pure: the caller owns the word storage (FAT_BITMAP_WORDS(nbits) words).
+ */
+
+#ifndef FAT_BITMAP_H
+#define FAT_BITMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FAT_BITMAP_WORDS(nbits)     (((nbits) + 63) / 64)
+#define FAT_BITMAP_NONE             0xFFFFFFFFU
+
+typedef struct fat_bitmap {
+    uint64_t* words;                    /* Bit n of word n / 64 */
+    uint32_t nbits;                     /* Bits in use */
+    uint32_t set_count;                 /* Bits currently set */
+    uint32_t hint;                      /* Next-fit: where the next search starts */
+} fat_bitmap_t;
+
+/* All bits clear. */
+void fat_bitmap_init(fat_bitmap_t* bm, uint64_t* words, uint32_t nbits);
+
+void fat_bitmap_set(fat_bitmap_t* bm, uint32_t bit);
+void fat_bitmap_clear(fat_bitmap_t* bm, uint32_t bit);
+bool fat_bitmap_test(const fat_bitmap_t* bm, uint32_t bit);
+
+/* Clear every bit. */
+void fat_bitmap_reset(fat_bitmap_t* bm);
+
+/* First set bit at or after `from`, or FAT_BITMAP_NONE. */
+uint32_t fat_bitmap_next_set(const fat_bitmap_t* bm, uint32_t from);
+
+/* Next run of set bits at or after `from`: returns its start (or
+ * FAT_BITMAP_NONE) and its length in *len. */
+uint32_t fat_bitmap_next_run(const fat_bitmap_t* bm, uint32_t from, uint32_t* len);
+
+/* Next-fit search for `want` consecutive set bits, starting at the hint and
+ * wrapping once. The first run long enough wins; failing that, the longest
+ * run seen. Returns the start (FAT_BITMAP_NONE if no bit is set) with the
+ * run length, at most `want`, in *got. The bits are left set; the hint moves
+ * past the run. */
+uint32_t fat_bitmap_find_run(fat_bitmap_t* bm, uint32_t want, uint32_t* got);
+
+#endif /* FAT_BITMAP_H */
@@ -0,0 +1,74 @@
+/* IKOS FAT Extent Map - cluster chains as contiguous runs
+ *
+ * A FAT file is a linked list of clusters, so finding the cluster at some
+ * file offset means following the chain from the start. The extent map walks
+ * the chain once and records it as runs of consecutive clusters:
+ *
+ *     file clusters 0..9   -> disk clusters 120..129
+ *     file clusters 10..11 -> disk clusters 400..401
+ *
+ * A lookup is then a binary search over the runs, and a per-open-file cursor
+ * remembers the run of the last lookup so sequential reads and short seeks
+ * cost O(1). Each run can be read with one multi-sector request.
+ *
+ * The map is owned by the inode and dropped whenever its chain changes.
+ * Pure: the chain and memory come from the caller's ops, so the host test
+ * runs it against an in-memory FAT.
+ */
+
+#ifndef FAT_EXTENT_H
+#define FAT_EXTENT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct fat_extent {
+    uint32_t file_cluster;              /* First cluster of the run, as an index into the file */
+    uint32_t disk_cluster;              /* Its cluster number on disk */
+    uint32_t length;                    /* Consecutive clusters in the run */
+} fat_extent_t;
+
+typedef struct fat_extent_map {
+    fat_extent_t* extents;              /* Runs in file order */
+    uint32_t count;                     /* Runs in use */
+    uint32_t total_clusters;            /* Clusters in the chain */
+    bool valid;                         /* Built and still matches the chain */
+} fat_extent_map_t;
+
+/* Position of the last lookup through an open file */
+typedef struct fat_cursor {
+    uint32_t extent;                    /* Run holding the last cluster looked up */
+    uint32_t file_cluster;              /* That cluster's index in the file */
+    uint32_t disk_cluster;              /* And its number on disk (0 = none yet) */
+} fat_cursor_t;
+
+typedef struct fat_extent_ops {
+    uint32_t (*next_cluster)(void* ctx, uint32_t cluster);  /* 0 at end of chain */
+    void* (*alloc)(size_t size);
+    void (*free)(void* ptr);
+    void* ctx;
+} fat_extent_ops_t;
+
+/* Empty, invalid map. */
+void fat_extent_map_init(fat_extent_map_t* map);
+
+/* Walk the chain from first_cluster into runs. A chain longer than
+ * max_clusters is treated as corrupt (a loop). first_cluster 0 is an empty
+ * file. Returns FAT_SUCCESS, FAT_ERROR_CLUSTER_CHAIN or FAT_ERROR_NO_MEMORY. */
+int fat_extent_map_build(fat_extent_map_t* map, uint32_t first_cluster,
+                         uint32_t max_clusters, const fat_extent_ops_t* ops);
+
+/* Free the runs and mark the map invalid, e.g. after the chain changed. */
+void fat_extent_map_clear(fat_extent_map_t* map, const fat_extent_ops_t* ops);
+
+/* Start a cursor at the beginning of the file. */
+void fat_cursor_reset(fat_cursor_t* cursor);
+
+/* Disk cluster holding file cluster `index`, or 0 past the end of the chain.
+ * *run (if not NULL) receives how many consecutive disk clusters start there.
+ * The cursor, if given, is moved to the result and used as the search hint. */
+uint32_t fat_extent_lookup(const fat_extent_map_t* map, fat_cursor_t* cursor,
+                           uint32_t index, uint32_t* run);
+
+#endif /* FAT_EXTENT_H */
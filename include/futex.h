@@ -0,0 +1,106 @@
+/* IKOS Threading - Futex wait queues
+ *
+ * Lets user-space synchronization keep its state in a 32-bit word in its own
+ * memory and enter the kernel only to sleep or wake on contention. The
+ * uncontended paths are a single atomic instruction in user/pthread.c.
+ *
+ * Sleepers are kept in a fixed hash table of wait queues keyed by
+ * (address-space key, user address), so unrelated words almost never share
+ * a queue and there is no global lock: each bucket has its own spinlock.
+ *
+ * futex_queue() compares the user word against the value the caller saw
+ * while holding the bucket lock, and futex_wake() takes the same lock, so a
+ * wake issued after the word changes can never be missed.
+ *
+ * The table only links and unlinks waiters; blocking and readying the owning
+ * thread is left to the caller through the wake callback. Pure and
+ * dependency-free: host-testable with no kernel stubs.
+ */
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Hash table geometry */
+#define FUTEX_HASH_BITS         8
+#define FUTEX_HASH_SIZE         (1U << FUTEX_HASH_BITS)
+
+/* Operation flags */
+#define FUTEX_PRIVATE           0x1     /* Word is private to one address space */
+
+/* Error codes */
+#define FUTEX_OK                0
+#define FUTEX_ERR_PARAM         -1
+#define FUTEX_ERR_AGAIN         -2      /* Word no longer holds the expected value */
+
+struct futex_bucket;
+
+/* One sleeping thread. Lives in the thread's control block. */
+typedef struct futex_waiter {
+    uint64_t space;                     /* Address-space key (0 = shared/physical) */
+    uint64_t addr;                      /* User address, or physical if shared */
+    void* owner;                        /* Thread to ready on wake */
+    struct futex_bucket* bucket;        /* Queue the waiter is linked on */
+    struct futex_waiter* next;
+    struct futex_waiter* prev;
+    bool queued;                        /* Cleared by the waker */
+} futex_waiter_t;
+
+typedef struct futex_bucket {
+    volatile uint32_t lock;
+    uint32_t count;                     /* Waiters on this queue */
+    futex_waiter_t* head;
+    futex_waiter_t* tail;
+} futex_bucket_t;
+
+typedef struct futex_stats {
+    uint64_t waits;                     /* Waiters queued */
+    uint64_t wait_again;                /* Waits refused because the word changed */
+    uint64_t wakes;                     /* Waiters woken */
+    uint64_t empty_wakes;               /* Wake calls that found nobody */
+    uint64_t requeues;                  /* Sleepers moved here from another queue */
+} futex_stats_t;
+
+typedef struct futex_table {
+    futex_bucket_t buckets[FUTEX_HASH_SIZE];
+    futex_stats_t stats;
+} futex_table_t;
+
+/* Called for each waiter a wake removes, with its bucket lock held. */
+typedef void (*futex_wake_fn)(void* owner);
+
+/* Empty table. */
+void futex_table_init(futex_table_t* table);
+
+/* Bucket a (space, addr) key hashes to. */
+futex_bucket_t* futex_hash(futex_table_t* table, uint64_t space, uint64_t addr);
+
+/* If *word still equals `expected`, link `waiter` on the queue for
+ * (space, addr) and return FUTEX_OK; the caller then sleeps until its owner
+ * is woken. Otherwise return FUTEX_ERR_AGAIN without queueing. The caller
+ * must already be marked blocked, so a wake racing with the sleep is kept. */
+int futex_queue(futex_table_t* table, futex_waiter_t* waiter, uint64_t space,
+                uint64_t addr, const volatile uint32_t* word, uint32_t expected,
+                void* owner);
+
+/* Link a thread that is already asleep elsewhere (a condition variable's
+ * kernel queue) onto (space, addr) without checking any word, so a later
+ * futex_wake() on that address wakes it. Used for requeue on broadcast. */
+void futex_enqueue(futex_table_t* table, futex_waiter_t* waiter, uint64_t space,
+                   uint64_t addr, void* owner);
+
+/* Remove a waiter that is still queued (timeout, signal, teardown).
+ * Returns true if it was queued, false if a wake got there first. */
+bool futex_unqueue(futex_table_t* table, futex_waiter_t* waiter);
+
+/* Wake up to `count` waiters on (space, addr) in FIFO order, calling `wake`
+ * for each. Returns the number woken. */
+uint32_t futex_wake(futex_table_t* table, uint64_t space, uint64_t addr,
+                    uint32_t count, futex_wake_fn wake);
+
+/* Number of waiters currently queued on (space, addr). */
+uint32_t futex_waiters(futex_table_t* table, uint64_t space, uint64_t addr);
+
+#endif /* FUTEX_H */
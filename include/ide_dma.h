@@ -0,0 +1,139 @@
+/* IKOS IDE DMA - bus-master transfers queued per channel
+ *
+ * PIO moves every word of every sector through the data port while the CPU
+ * polls for DRQ. With PCI bus-master IDE the controller reads or writes
+ * memory itself: the driver hands it a table of physical regions (PRDs),
+ * issues READ DMA or WRITE DMA, and is interrupted once when the whole
+ * transfer is done.
+ *
+ * A PRD describes at most 64 KiB of physically contiguous memory that does
+ * not cross a 64 KiB boundary, and the last one carries the end-of-table
+ * bit. ide_dma_build_prd() walks a buffer a page at a time through
+ * ops->virt_to_phys, so a buffer that is virtually contiguous but scattered
+ * over frames still goes out as one command; frames that happen to be
+ * adjacent share an entry.
+ *
+ * Transfers are asynchronous. ide_dma_submit() queues a request on the
+ * channel and starts it if the channel is idle; the channel's interrupt
+ * calls ide_dma_interrupt(), which completes the active request (setting
+ * `complete` and calling `done`, from interrupt context) and starts the
+ * next. A request the channel cannot do by DMA - DMA is off, the buffer
+ * cannot be described, or the drive refuses - is done by ops->pio instead,
+ * synchronously, and completed the same way. A caller that serializes by
+ * turning interrupts off sets `defer_pio`: such a request is then parked
+ * on the channel, and the caller takes it with ide_dma_pio_take(), runs
+ * ops->pio with interrupts back on and hands the result to
+ * ide_dma_pio_done(). Nothing else starts while it is parked.
+ *
+ * Pure: the controller is reached only through ops, so the host test runs
+ * the queue and the PRD builder over a simulated bus master. One channel
+ * carries one command at a time; callers serialize submission with the
+ * channel interrupt.
+ */
+
+#ifndef IDE_DMA_H
+#define IDE_DMA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define IDE_DMA_PRD_MAX         64          /* Entries in one table (512 bytes) */
+#define IDE_DMA_PRD_EOT         0x8000      /* Last entry of the table */
+#define IDE_DMA_PRD_BOUNDARY    0x10000     /* No entry crosses 64 KiB */
+#define IDE_DMA_PAGE_SIZE       4096
+#define IDE_DMA_MAX_SECTORS     256         /* One 28-bit READ/WRITE DMA */
+#define IDE_DMA_NO_PHYS         UINT64_MAX  /* virt_to_phys: not mapped */
+
+/* Result codes */
+#define IDE_DMA_OK              0
+#define IDE_DMA_EINVAL          -1
+#define IDE_DMA_ERANGE          -2          /* Buffer cannot be described by PRDs */
+#define IDE_DMA_EIO             -3
+
+/* One physical region, as the bus master reads it */
+typedef struct ide_prd {
+    uint32_t phys;                      /* Even, below 4 GiB */
+    uint16_t bytes;                     /* 0 means 64 KiB */
+    uint16_t flags;                     /* IDE_DMA_PRD_EOT on the last */
+} __attribute__((packed)) ide_prd_t;
+
+typedef struct ide_dma_request {
+    struct ide_dma_request* next;       /* Channel queue */
+    uint8_t drive;                      /* 0 = master, 1 = slave */
+    bool write;
+    uint16_t count;                     /* Sectors, 1..IDE_DMA_MAX_SECTORS */
+    uint64_t lba;
+    void* buffer;                       /* count * 512 bytes, word aligned */
+    /* Called once when the request finishes, possibly from the IRQ */
+    void (*done)(struct ide_dma_request* req);
+    void* ctx;
+    int status;                         /* IDE_DMA_OK or the failure */
+    bool used_pio;                      /* Served by the PIO fallback */
+    volatile bool complete;
+} ide_dma_request_t;
+
+typedef struct ide_dma_ops {
+    /* Physical address of a kernel virtual address, or IDE_DMA_NO_PHYS */
+    uint64_t (*virt_to_phys)(void* ctx, const void* addr);
+    /* Point the bus master at the table and issue the command. Anything
+     * but IDE_DMA_OK sends the request to PIO. */
+    int (*start)(void* ctx, const ide_dma_request_t* req, uint32_t prd_phys);
+    /* After the interrupt: stop the bus master and report the outcome. */
+    int (*finish)(void* ctx, const ide_dma_request_t* req);
+    /* Do the whole transfer by PIO. */
+    int (*pio)(void* ctx, ide_dma_request_t* req);
+    void* ctx;
+} ide_dma_ops_t;
+
+typedef struct ide_dma_stats {
+    uint64_t dma_requests;
+    uint64_t pio_requests;
+    uint64_t prd_entries;               /* Over all DMA requests */
+    uint64_t errors;
+    uint64_t spurious;                  /* Interrupts with nothing active */
+    uint64_t bytes;
+} ide_dma_stats_t;
+
+typedef struct ide_dma_channel {
+    ide_prd_t* prd;                     /* IDE_DMA_PRD_MAX entries, 4-byte aligned */
+    uint32_t prd_phys;
+    bool enabled;                       /* Bus master present and set up */
+    bool dispatching;                   /* Starting requests; submit only queues */
+    bool defer_pio;                     /* Park PIO requests for the caller */
+    ide_dma_request_t* active;
+    ide_dma_request_t* pio;             /* Parked for, or under, deferred PIO */
+    bool pio_running;                   /* ... and taken by a caller */
+    ide_dma_request_t* head;
+    ide_dma_request_t* tail;
+    ide_dma_ops_t ops;
+    ide_dma_stats_t stats;
+} ide_dma_channel_t;
+
+/* Fill `prd` (max entries) for `bytes` of `buffer`. Returns the entries
+ * used, or IDE_DMA_ERANGE when the buffer is odd, unmapped, above 4 GiB or
+ * needs more than `max` entries. */
+int ide_dma_build_prd(ide_prd_t* prd, uint32_t max, const void* buffer, uint32_t bytes,
+                      const ide_dma_ops_t* ops);
+
+/* An idle channel; `prd` may be NULL (and `enabled` false) for PIO only. */
+void ide_dma_channel_init(ide_dma_channel_t* ch, ide_prd_t* prd, uint32_t prd_phys, bool enabled,
+                          const ide_dma_ops_t* ops);
+
+/* Queue `req`; starts it at once if the channel is idle. */
+int ide_dma_submit(ide_dma_channel_t* ch, ide_dma_request_t* req);
+
+/* The channel's interrupt: complete the active request, start the next. */
+void ide_dma_interrupt(ide_dma_channel_t* ch);
+
+/* The parked PIO request, now the caller's to run, or NULL if there is
+ * none or another caller is running it. */
+ide_dma_request_t* ide_dma_pio_take(ide_dma_channel_t* ch);
+
+/* Complete a taken PIO request with ops->pio's result, start the next. */
+void ide_dma_pio_done(ide_dma_channel_t* ch, ide_dma_request_t* req, int status);
+
+/* Whether anything is active or queued. */
+bool ide_dma_busy(const ide_dma_channel_t* ch);
+
+#endif /* IDE_DMA_H */
@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "device_manager.h"
+#include "ide_dma.h"
 
 /* ================================
  * IDE/ATA Constants
@@ -63,6 +64,8 @@
 #define IDE_CMD_READ_SECTORS_EXT 0x24
 #define IDE_CMD_WRITE_SECTORS   0x30
 #define IDE_CMD_WRITE_SECTORS_EXT 0x34
+#define IDE_CMD_READ_DMA        0xC8
+#define IDE_CMD_WRITE_DMA       0xCA
 #define IDE_CMD_IDENTIFY        0xEC
 #define IDE_CMD_IDENTIFY_PACKET 0xA1
 #define IDE_CMD_FLUSH_CACHE     0xE7
@@ -77,6 +80,25 @@
 #define IDE_CTRL_nIEN           0x02    /* Interrupt enable (negated) */
 #define IDE_CTRL_SRST           0x04    /* Software reset */
 
+/* PCI IDE controller (class 01h, subclass 01h): bus master registers at
+ * BAR4, eight ports per channel */
+#define IDE_PCI_CLASS           0x01
+#define IDE_PCI_SUBCLASS        0x01
+#define IDE_PCI_BM_BAR          4
+#define IDE_BM_SECONDARY        0x08
+#define IDE_BM_REG_COMMAND      0x00
+#define IDE_BM_REG_STATUS       0x02
+#define IDE_BM_REG_PRDT         0x04
+
+/* Bus master command bits */
+#define IDE_BM_CMD_START        0x01
+#define IDE_BM_CMD_READ         0x08    /* Device to memory */
+
+/* Bus master status bits */
+#define IDE_BM_STATUS_ACTIVE    0x01
+#define IDE_BM_STATUS_ERROR     0x02    /* Write 1 to clear */
+#define IDE_BM_STATUS_IRQ       0x04    /* Write 1 to clear */
+
 /* ================================
  * Data Structures
  * ================================ */
@@ -113,6 +135,8 @@ typedef struct {
     bool initialized;           /* Controller initialized */
     uint32_t access_count;      /* Access counter */
     uint64_t last_access_time;  /* Last access timestamp */
+    uint16_t bm_base;           /* Bus master registers; 0 = PIO only */
+    ide_dma_channel_t dma;      /* Request queue for this channel */
 } ide_device_t;
 
 /* ================================
@@ -153,6 +177,16 @@ int ide_write_sectors(ide_device_t* ide_dev, uint8_t drive, uint64_t lba,
                       uint16_t count, const void* buffer);
 int ide_flush_cache(ide_device_t* ide_dev, uint8_t drive);
 
+/* Asynchronous transfers (ide_dma.h): bus-master DMA with completion from
+ * the channel IRQ where the controller and drive allow it, PIO otherwise.
+ * ide_setup_dma() finds the PCI bus master for a controller and enables
+ * it; without it requests still work, by PIO. */
+int ide_setup_dma(ide_device_t* ide_dev);
+int ide_enable_dma(ide_device_t* ide_dev, uint16_t bm_base);
+int ide_submit(ide_device_t* ide_dev, ide_dma_request_t* req);
+int ide_wait_request(ide_device_t* ide_dev, ide_dma_request_t* req);
+void ide_irq(uint8_t irq);  /* IRQ 14/15 from the interrupt dispatcher */
+
 /* Drive identification and information */
 int ide_identify_drive(ide_device_t* ide_dev, uint8_t drive);
 int ide_get_drive_info(ide_device_t* ide_dev, uint8_t drive, ide_drive_info_t* info);
@@ -185,6 +219,8 @@ typedef struct {
     uint32_t write_errors;
     uint64_t bytes_read;
     uint64_t bytes_written;
+    uint32_t dma_transfers;     /* Completed by the bus master */
+    uint32_t dma_errors;
 } ide_stats_t;
 
 void ide_get_stats(ide_stats_t* stats);
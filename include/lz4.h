@@ -0,0 +1,58 @@
+/* IKOS LZ4 block codec
+ *
+ * A freestanding implementation of the LZ4 block format (no frame header,
+ * no checksums), used by the memory compression pools to squeeze reclaimed
+ * pages. Output is byte-compatible with the reference LZ4 block format, so
+ * blocks can be inspected with standard tooling.
+ *
+ * The compressor is the classic single-pass greedy matcher: a small hash table
+ * of 4-byte prefixes finds candidate matches, which are extended forwards and
+ * backwards. Positions are stored as 16-bit offsets, which limits a single
+ * block to LZ4_MAX_INPUT_SIZE bytes - far more than a page.
+ *
+ * The decompressor is bounds-checked against both the input and the output,
+ * so a corrupted block fails cleanly instead of writing out of range. Where
+ * there is slack at the end of the output it copies in 8-byte strides
+ * ("wildcopy") and falls back to exact copies near the buffer edges.
+ */
+
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Largest input a single block may hold (16-bit match positions). */
+#define LZ4_MAX_INPUT_SIZE      65535
+
+/* Hash table size for the match finder: 2^LZ4_HASH_LOG 16-bit slots. Kept
+ * small so the table fits comfortably on a kernel stack. */
+#define LZ4_HASH_LOG            10
+
+/* Worst-case compressed size for an input of n bytes (incompressible data). */
+#define LZ4_COMPRESS_BOUND(n)   ((n) + ((n) / 255) + 16)
+
+/* Result codes (negative); successful calls return a byte count. */
+#define LZ4_ERROR_INVALID       -1   /* Bad arguments or input too large */
+#define LZ4_ERROR_NOSPACE       -2   /* Output buffer too small */
+#define LZ4_ERROR_CORRUPT       -3   /* Malformed compressed block */
+
+/* Match-finder state. Callers may keep one per context to avoid putting it on
+ * the stack; its contents need no initialisation between calls. */
+typedef struct lz4_workmem {
+    uint16_t table[1 << LZ4_HASH_LOG];
+} lz4_workmem_t;
+
+/* Compress src_size bytes into dst (capacity dst_capacity). Returns the
+ * compressed size, or LZ4_ERROR_NOSPACE if the result would not fit - pass a
+ * capacity below src_size to reject data that does not compress. */
+int lz4_compress_block(const void* src, size_t src_size,
+                       void* dst, size_t dst_capacity,
+                       lz4_workmem_t* workmem);
+
+/* Decompress a block into dst (capacity dst_capacity). Returns the number of
+ * bytes produced, or LZ4_ERROR_CORRUPT / LZ4_ERROR_NOSPACE. */
+int lz4_decompress_block(const void* src, size_t src_size,
+                         void* dst, size_t dst_capacity);
+
+#endif /* LZ4_H */
@@ -449,6 +449,35 @@ typedef struct compression_stats {
 /* Compression statistics */
 void get_compression_stats(compression_stats_t* stats);
 
+/* Keyed compressed tier: pages are stored under a caller key (e.g. their swap
+ * entry), loaded back on fault, and evicted in LRU order through a writeback
+ * hook when the pool exceeds its budget. Pools come from create_compression_pool. */
+typedef int (*compression_writeback_t)(uint64_t key, const void* page, void* ctx);
+
+typedef struct compression_pool_stats {
+    uint32_t stored_pages;          /* Entries resident in the pool */
+    uint32_t max_pages;             /* Entry budget */
+    uint64_t pool_bytes;            /* Compressed bytes held */
+    uint64_t budget_bytes;          /* Byte budget */
+    uint64_t stores;                /* Pages accepted */
+    uint64_t store_rejects;         /* Incompressible or no room */
+    uint64_t load_hits;             /* Loads served from the pool */
+    uint64_t load_misses;           /* Loads that found no entry */
+    uint64_t writebacks;            /* Cold entries handed to the writeback hook */
+    uint64_t writeback_failures;    /* Writebacks that failed (entry kept) */
+    uint32_t compression_ratio;     /* Compressed size as % of original */
+} compression_pool_stats_t;
+
+int  create_compression_pool(const char* name, uint32_t algorithm,
+                             size_t memory_size, uint32_t max_pages);
+int  destroy_compression_pool_by_id(int pool_id);
+int  compression_pool_set_writeback(int pool_id, compression_writeback_t writeback, void* ctx);
+uint32_t compression_pool_shrink(int pool_id, uint32_t nr);
+int  pool_store_page(int pool_id, uint64_t key, const void* page);
+int  pool_load_page(int pool_id, uint64_t key, void* output);
+void pool_invalidate_page(int pool_id, uint64_t key);
+int  get_compression_pool_stats(int pool_id, compression_pool_stats_t* stats);
+
 /* ========================== NUMA Support API ========================== */
 
 /* NUMA topology */
@@ -540,6 +569,12 @@ bool page_is_free(struct page* page);
 int try_to_free_pages(gfp_t gfp_mask, unsigned int order, int node);
 void wakeup_kswapd(void);
 
+/* Demand paging and the compressed RAM tier in front of swap (demand_paging.c) */
+int demand_paging_init(void);
+int memory_compression_init(void);
+int zswap_enable(size_t budget_bytes, uint32_t max_pages);
+int zswap_disable(void);
+
 /* Error codes */
 #define ENOMEM_ADVANCED     (-1000)     /* Advanced memory manager error base */
 #define EINVAL_ZONE         (-1001)     /* Invalid memory zone */
@@ -33,6 +33,7 @@
 #define DNS_DEFAULT_TTL         3600    /* Default TTL (1 hour) */
 #define DNS_MAX_RETRIES         3       /* Maximum query retries */
 #define DNS_QUERY_TIMEOUT       5000    /* Query timeout in ms */
+#define DNS_CACHE_SWEEP_SECS    60      /* Interval between expired-entry sweeps */
 
 /* DNS Classes */
 #define DNS_CLASS_IN            1       /* Internet class */
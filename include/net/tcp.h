@@ -13,6 +13,7 @@
 #include "network.h"
 #include "ip.h"
 #include "socket.h"
+#include "timer_wheel.h"
 
 /* ================================
  * TCP Constants
@@ -159,7 +160,8 @@ typedef struct tcp_socket {
     uint32_t backoff;          /* Exponential backoff counter */
     
     /* Timers */
-    uint32_t retrans_timer;    /* Retransmission timer */
+    ktimer_t retrans_timer;    /* Retransmission timer (RTO) */
+    volatile bool retransmit_due; /* RTO expired; handled by tcp_timer_tick() */
     uint32_t keepalive_timer;  /* Keep-alive timer */
     uint32_t timewait_timer;   /* TIME_WAIT timer */
     
@@ -297,7 +299,7 @@ int tcp_retransmit_segment(tcp_socket_t* sock);
 void tcp_reset_retransmission_timer(tcp_socket_t* sock);
 
 /* Timer Management */
-void tcp_timer_tick(void);
+void tcp_timer_tick(void);  /* Run expired RTOs; process context, not the IRQ */
 void tcp_start_timer(tcp_socket_t* sock, int timer_type, uint32_t timeout);
 void tcp_stop_timer(tcp_socket_t* sock, int timer_type);
 
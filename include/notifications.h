@@ -11,6 +11,7 @@
 
 #include "gui.h"
 #include "process.h"
+#include "timer_wheel.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -114,6 +115,8 @@ typedef struct notification {
     time_t shown_time;
     time_t dismissed_time;
     uint32_t timeout_ms;    /* 0 = no timeout */
+    ktimer_t expiry_timer;  /* Runs timeout_ms from being shown */
+    volatile bool timeout_fired;
     
     /* Actions */
     notification_action_t actions[NOTIFICATION_MAX_ACTIONS];
@@ -0,0 +1,227 @@
+/* IKOS Page Cache - file pages kept in memory under the VFS
+ *
+ * vfs_read used to go straight to the filesystem, so every read of a file
+ * went to the disk again. Here each inode has a mapping: a radix tree of the
+ * file's pages, keyed by page index, that reads fill from the filesystem on
+ * a miss and later reads are served from. Writes land in the cached page and
+ * mark it dirty; the filesystem sees them when the mapping is written back
+ * (fsync, sync, unmount, or eviction of a dirty page).
+ *
+ * The radix tree has 64 slots per node and grows in height with the largest
+ * index, so small files cost one node and lookups cost one step per 6 bits
+ * of page index.
+ *
+ * Pages of every mapping share one budget and one LRU list. Inserting past
+ * max_pages, or page_cache_shrink() under memory pressure, evicts from the
+ * cold end with a second chance for pages read since they were last passed
+ * over. A mapping whose filesystem has no backing store (no readpage) is the
+ * only copy of its data: its pages stay off the LRU and are never evicted.
+ *
+ * Sequential readers get readahead: each open file carries a page_cache_ra_t
+ * that notices when reads follow on from the last one and keeps a window of
+ * pages filled ahead of the reader. The window starts at 16 KiB and doubles
+ * each time the reader reaches its second half, up to 512 KiB, so a stream
+ * turns into a few large filesystem reads instead of one per page. Reads
+ * that jump elsewhere drop the window and are served page by page.
+ *
+ * Pure: page memory comes from the caller's ops, and file I/O goes through
+ * each mapping's aops, so the host test runs it over a simulated disk.
+ * Callers serialize access to a cache and its mappings.
+ */
+
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define PAGE_CACHE_SHIFT            12
+#define PAGE_CACHE_SIZE             (1U << PAGE_CACHE_SHIFT)
+
+#define PAGE_CACHE_RADIX_SHIFT      6
+#define PAGE_CACHE_RADIX_SLOTS      (1U << PAGE_CACHE_RADIX_SHIFT)
+#define PAGE_CACHE_RADIX_MAX_HEIGHT 9       /* 54 bits of page index */
+
+/* Pages examined per evicted page before giving up */
+#define PAGE_CACHE_EVICT_SCAN       16
+
+/* Readahead window bounds, in pages */
+#define PAGE_CACHE_RA_MIN_PAGES     4       /* 16 KiB */
+#define PAGE_CACHE_RA_MAX_PAGES     128     /* 512 KiB */
+
+/* Result codes */
+#define PAGE_CACHE_OK               0
+#define PAGE_CACHE_ENOMEM           -1
+#define PAGE_CACHE_EIO              -2
+#define PAGE_CACHE_ENOSPC           -3
+
+/* Page flags */
+#define PAGE_CACHE_DIRTY            0x01    /* Newer than the filesystem */
+#define PAGE_CACHE_REFERENCED       0x02    /* Read since the LRU last passed it */
+#define PAGE_CACHE_READAHEAD        0x04    /* Read ahead, not yet used */
+#define PAGE_CACHE_DETACHED         0x08    /* Deleted while pinned; freed on unpin */
+
+struct page_cache;
+struct page_cache_mapping;
+
+typedef struct page_cache_page {
+    struct page_cache_mapping* mapping;
+    uint64_t index;                     /* Page number within the file */
+    void* data;                         /* PAGE_CACHE_SIZE bytes */
+    uint32_t flags;
+    uint32_t pins;                      /* Actors using data; never evicted or freed */
+    struct page_cache_page* lru_prev;   /* Towards the hot end */
+    struct page_cache_page* lru_next;   /* Towards the cold end */
+} page_cache_page_t;
+
+typedef struct page_cache_node {
+    void* slots[PAGE_CACHE_RADIX_SLOTS];    /* Child nodes, or pages at the bottom */
+    uint32_t count;                         /* Non-empty slots */
+} page_cache_node_t;
+
+/* How a filesystem moves pages between its storage and the cache. `host` is
+ * the mapping's host (the VFS passes the inode). */
+typedef struct page_cache_aops {
+    /* Fill page `index` (PAGE_CACHE_SIZE bytes, zeroed) from the file. NULL:
+     * no backing store; missing pages read as zeros and are never evicted. */
+    int (*readpage)(void* host, uint64_t index, void* page);
+
+    /* Write page `index` back. The filesystem writes only the bytes inside
+     * the file. NULL: nothing to write back. */
+    int (*writepage)(void* host, uint64_t index, const void* page);
+
+    /* How many of the `len` bytes at `pos` the file can take (0: none).
+     * NULL: no limit. */
+    size_t (*write_limit)(void* host, uint64_t pos, size_t len);
+
+    /* Fill `nr` consecutive pages from `index` into `buffer` (nr *
+     * PAGE_CACHE_SIZE bytes, zeroed), in as few device requests as the
+     * layout allows. Used for readahead. NULL: readpage one at a time. */
+    int (*readpages)(void* host, uint64_t index, uint32_t nr, void* buffer);
+} page_cache_aops_t;
+
+typedef struct page_cache_mapping {
+    struct page_cache* cache;
+    const page_cache_aops_t* aops;      /* NULL: not cached */
+    void* host;                         /* Passed to the aops */
+    void* owner;                        /* Groups mappings for sync (the superblock) */
+    page_cache_node_t* root;
+    uint32_t height;                    /* Tree levels; 0 when empty */
+    uint32_t nrpages;
+    uint32_t nrdirty;
+    struct page_cache_mapping* dirty_prev;  /* Cache's list of mappings with dirty pages */
+    struct page_cache_mapping* dirty_next;
+} page_cache_mapping_t;
+
+/* Per-open-file readahead state. The window is [start, start + size); when
+ * the reader reaches its last async_size pages the next window is read. */
+typedef struct page_cache_ra {
+    uint64_t start;
+    uint32_t size;                      /* 0: no window (random access) */
+    uint32_t async_size;
+    uint64_t next_index;                /* Page after the previous read */
+} page_cache_ra_t;
+
+typedef struct page_cache_ops {
+    void* (*alloc_page)(void* ctx);     /* PAGE_CACHE_SIZE bytes, or NULL */
+    void (*free_page)(void* ctx, void* page);
+    void* (*alloc)(size_t size);
+    void (*free)(void* ptr);
+    void* ctx;
+} page_cache_ops_t;
+
+typedef struct page_cache_stats {
+    uint64_t hits;                      /* Page lookups served from memory */
+    uint64_t misses;                    /* Page lookups that needed a new page */
+    uint64_t fills;                     /* readpage/readpages calls */
+    uint64_t writebacks;                /* writepage calls */
+    uint64_t evictions;                 /* Pages dropped to make room */
+    uint64_t readahead;                 /* Pages filled ahead of the reader */
+    uint32_t pages;                     /* Pages cached now */
+    uint32_t dirty;                     /* Of which dirty */
+} page_cache_stats_t;
+
+typedef struct page_cache {
+    page_cache_ops_t ops;
+    page_cache_page_t* lru_head;        /* Most recently used */
+    page_cache_page_t* lru_tail;
+    page_cache_mapping_t* dirty_head;
+    uint32_t nrpages;
+    uint32_t nrdirty;
+    uint32_t max_pages;                 /* 0: no limit */
+    page_cache_stats_t stats;
+} page_cache_t;
+
+void page_cache_init(page_cache_t* cache, const page_cache_ops_t* ops, uint32_t max_pages);
+
+/* An empty mapping. aops NULL leaves the file uncached. */
+void page_cache_mapping_init(page_cache_mapping_t* mapping, page_cache_t* cache,
+                             const page_cache_aops_t* aops, void* host, void* owner);
+
+static inline bool page_cache_mapping_cached(const page_cache_mapping_t* mapping) {
+    return mapping && mapping->cache && mapping->aops;
+}
+
+/* Cached page `index`, or NULL. Does not fill or count as a hit. */
+page_cache_page_t* page_cache_find(page_cache_mapping_t* mapping, uint64_t index);
+
+/* Copy up to `count` bytes at `pos` of a file `size` bytes long, filling
+ * missing pages. Returns the bytes copied or a PAGE_CACHE_E* code. */
+int64_t page_cache_read(page_cache_mapping_t* mapping, uint64_t pos, void* buffer,
+                        size_t count, uint64_t size);
+
+/* A file just opened: the first read at offset 0 counts as sequential. */
+void page_cache_ra_init(page_cache_ra_t* ra);
+
+/* page_cache_read for an open file: sequential reads grow `ra`'s window and
+ * fill it ahead of the reader. */
+int64_t page_cache_read_ra(page_cache_mapping_t* mapping, page_cache_ra_t* ra, uint64_t pos,
+                           void* buffer, size_t count, uint64_t size);
+
+/* Consumer of cached file data: takes up to len bytes straight from a
+ * cached page and returns how many it used, or a negative error. Using
+ * fewer than len ends the read. */
+typedef int64_t (*page_cache_actor_t)(void* ctx, const void* data, size_t len);
+
+/* page_cache_read_ra handing the bytes of each page to `actor` where they
+ * lie instead of copying them into a buffer (sendfile). The page is pinned
+ * while the actor runs, so the actor may drop the caller's lock around slow
+ * work: eviction passes the page over, and a truncate that deletes it only
+ * frees it once the actor returns. Returns the bytes the actor used, or an
+ * error if it used none. */
+int64_t page_cache_read_actor(page_cache_mapping_t* mapping, page_cache_ra_t* ra, uint64_t pos,
+                              size_t count, uint64_t size, page_cache_actor_t actor, void* ctx);
+
+/* Copy `count` bytes into the file at `pos` and mark the pages dirty. Pages
+ * written only in part are filled first if they hold file data. Returns the
+ * bytes written; the caller grows the file size past pos + result. */
+int64_t page_cache_write(page_cache_mapping_t* mapping, uint64_t pos, const void* buffer,
+                         size_t count, uint64_t size);
+
+/* Write every dirty page of the mapping back, in index order. */
+int page_cache_writeback(page_cache_mapping_t* mapping);
+
+/* Write back every mapping with dirty pages whose owner is `owner` (NULL:
+ * every mapping). */
+int page_cache_sync(page_cache_t* cache, void* owner);
+
+/* The file shrank to `size`: drop pages past it, unwritten, and zero the
+ * tail of the last one. */
+void page_cache_truncate(page_cache_mapping_t* mapping, uint64_t size);
+
+/* Drop every page without writing it back (the inode is going away; the
+ * caller writes back first if the data matters). */
+void page_cache_mapping_release(page_cache_mapping_t* mapping);
+
+/* Drop every page the LRU holds for mappings of `owner`, unwritten (the
+ * filesystem is being unmounted and was synced first). */
+void page_cache_invalidate_owner(page_cache_t* cache, void* owner);
+
+/* Evict up to nr_pages from the cold end, writing dirty ones back first.
+ * Returns the number evicted. */
+uint32_t page_cache_shrink(page_cache_t* cache, uint32_t nr_pages);
+
+void page_cache_get_stats(const page_cache_t* cache, page_cache_stats_t* stats);
+
+#endif /* PAGE_CACHE_H */
@@ -157,6 +157,9 @@ typedef struct process {
     struct process* zombie_children;    /* List of zombie children */
     struct process* next_zombie;        /* Next in zombie list */
     
+    /* vfork: parent suspended while this child borrows its memory */
+    struct process* vfork_parent;       /* Cleared on execve or exit */
+    
     /* Wait queue support */
     struct process* waiting_for_child;  /* Process waiting for this child */
     int* wait_status_ptr;               /* Where to store exit status */
@@ -169,12 +172,19 @@ typedef struct process {
     /* Process arguments */
     char** argv;                        /* Command line arguments */
     char** envp;                        /* Environment variables */
+    
+    /* Threads (linked through kthread_t.next/prev) */
+    struct kthread* threads;            /* Threads of this process */
+    uint32_t thread_count;              /* Threads on that list */
 } process_t;
 
 /* Process management functions */
 int process_init(void);
 process_t* process_create(const char* name, const char* path);
 process_t* process_create_from_elf(const char* name, void* elf_data, size_t size);
+struct elf_image_key;
+process_t* process_create_from_image(const char* name, const struct elf_image_key* key,
+                                     const void* elf_data, size_t size);
 int process_exec(process_t* proc, const char* path, char* const argv[]);
 
 /* Process termination functions (Issue #18) */
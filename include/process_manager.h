@@ -137,6 +137,9 @@ pm_state_t pm_get_state(void);
 /* Process creation and destruction */
 int pm_create_process(const pm_create_params_t* params, uint32_t* pid_out);
 int pm_create_process_from_elf(const char* name, void* elf_data, size_t elf_size, uint32_t* pid_out);
+struct elf_image_key;
+int pm_create_process_from_image(const char* name, const struct elf_image_key* key,
+                                 void* elf_data, size_t elf_size, uint32_t* pid_out);
 int pm_terminate_process(uint32_t pid, int exit_code);
 int pm_kill_process(uint32_t pid, int signal);
 
@@ -101,7 +101,7 @@ typedef struct {
     uint32_t type;                  /* Mutex type */
     uint32_t owner;                 /* Owner thread ID */
     uint32_t lock_count;            /* Lock count (for recursive mutexes) */
-    uint32_t waiters;               /* Number of waiting threads */
+    uint32_t futex;                 /* Lock word: 0 free, 1 locked, 2 locked with waiters */
     void* wait_queue;               /* Queue of waiting threads */
     uint64_t creation_time;         /* Creation timestamp */
     uint32_t flags;                 /* Mutex flags */
@@ -133,10 +133,11 @@ typedef struct {
     uint64_t creation_time;         /* Creation timestamp */
     uint32_t flags;                 /* Condition variable flags */
     uint32_t broadcast_seq;         /* Broadcast sequence number */
+    uint32_t kernel_id;             /* Kernel object (0 = created on first use) */
 } pthread_cond_t;
 
 /* Condition variable constants */
-#define PTHREAD_COND_INITIALIZER    {0x434F4E44, 0, NULL, 0, 0, 0}
+#define PTHREAD_COND_INITIALIZER    {0x434F4E44, 0, NULL, 0, 0, 0, 0}
 
 /* ================================
  * Semaphore Support
@@ -151,6 +152,7 @@ typedef struct {
     void* wait_queue;               /* Queue of waiting threads */
     uint64_t creation_time;         /* Creation timestamp */
     uint32_t flags;                 /* Semaphore flags */
+    uint32_t kernel_id;             /* Kernel object */
 } sem_t;
 
 /* Semaphore constants */
@@ -178,10 +180,11 @@ typedef struct {
     void* write_wait_queue;         /* Queue of threads waiting to write */
     uint64_t creation_time;         /* Creation timestamp */
     uint32_t flags;                 /* Lock flags */
+    uint32_t kernel_id;             /* Kernel object (0 = created on first use) */
 } pthread_rwlock_t;
 
 /* Read-write lock constants */
-#define PTHREAD_RWLOCK_INITIALIZER  {0x52574C4B, 0, 0, 0, 0, 0, NULL, NULL, 0, 0}
+#define PTHREAD_RWLOCK_INITIALIZER  {0x52574C4B, 0, 0, 0, 0, 0, NULL, NULL, 0, 0, 0}
 
 /* ================================
  * Thread Cancellation
@@ -347,6 +350,7 @@ typedef struct {
     uint32_t generation;            /* Current generation number */
     void* wait_queue;               /* Queue of waiting threads */
     uint64_t creation_time;         /* Creation timestamp */
+    uint32_t kernel_id;             /* Kernel object */
 } pthread_barrier_t;
 
 typedef struct {
@@ -0,0 +1,71 @@
+/* IKOS Preemptive Task Scheduler - Per-CPU run queue
+ *
+ * One run queue per CPU replaces the global round-robin list and the
+ * ready_queues[] array that priority_pick_next() scanned level by level.
+ *
+ * Each queue keeps a FIFO of ready tasks per priority level plus a bitmap
+ * with one bit per non-empty level, so picking the highest-priority task is
+ * a find-first-set over SCHED_PRIO_LEVELS / 64 words instead of a 256-step
+ * scan. Enqueue and dequeue are O(1).
+ *
+ * Work stealing is split the same way as the rest of the scheduler: this
+ * module only chooses the busiest queue and detaches a task from it; the
+ * scheduler owns the per-CPU locks and decides when an idle CPU pulls.
+ *
+ * Pure and dependency-free beyond task_t: host-testable with no kernel stubs.
+ */
+
+#ifndef SCHED_RUNQUEUE_H
+#define SCHED_RUNQUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* CPUs the scheduler can manage (matches CHECKPOINT_BARRIER_MAX_CPUS) */
+#define SCHED_MAX_CPUS          8
+
+/* One queue level per task priority (0 = highest) */
+#define SCHED_PRIO_LEVELS       256
+#define SCHED_BITMAP_WORDS      (SCHED_PRIO_LEVELS / 64)
+
+struct task;
+
+typedef struct sched_runqueue {
+    struct task* head[SCHED_PRIO_LEVELS];   /* Next task to run at each level */
+    struct task* tail[SCHED_PRIO_LEVELS];   /* Last queued task at each level */
+    uint64_t bitmap[SCHED_BITMAP_WORDS];    /* Bit set = level non-empty */
+    uint32_t nr_ready;                      /* Tasks queued at all levels */
+    uint32_t cpu;                           /* Owning CPU */
+} sched_runqueue_t;
+
+/* Empty queue owned by `cpu`. */
+void sched_rq_init(sched_runqueue_t* rq, uint32_t cpu);
+
+/* Append a task to the FIFO at `level` and mark it queued on rq->cpu.
+ * A task that is already queued is left where it is. */
+void sched_rq_enqueue(sched_runqueue_t* rq, struct task* task, uint8_t level);
+
+/* Unlink a queued task from its level. No-op if the task is not queued. */
+void sched_rq_dequeue(sched_runqueue_t* rq, struct task* task);
+
+/* Highest non-empty level, or -1 if the queue is empty. */
+int sched_rq_highest_level(const sched_runqueue_t* rq);
+
+/* Highest-priority task without removing it (NULL if empty). */
+struct task* sched_rq_peek(const sched_runqueue_t* rq);
+
+/* Remove and return the highest-priority task (NULL if empty). */
+struct task* sched_rq_pop(sched_runqueue_t* rq);
+
+/* Index of the queue in rqs[0..n) other than `self` with the most ready
+ * tasks, considering only queues holding at least `min_ready`. Ties go to
+ * the lowest index so the choice is reproducible. Returns n if none. */
+uint32_t sched_rq_find_busiest(const sched_runqueue_t* rqs, uint32_t n,
+                               uint32_t self, uint32_t min_ready);
+
+/* Detach the task `dst_cpu` should run from the busiest queue `src`: the
+ * longest-waiting task at src's highest level, the one least likely to still
+ * be cache-hot there. Returns NULL if src is empty. */
+struct task* sched_rq_steal(sched_runqueue_t* src, uint32_t dst_cpu);
+
+#endif /* SCHED_RUNQUEUE_H */
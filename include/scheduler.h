@@ -1,5 +1,6 @@
 /* IKOS Preemptive Task Scheduler
- * Implements Round Robin and Priority-based preemptive scheduling
+ * Implements Round Robin and Priority-based preemptive scheduling over
+ * per-CPU run queues (see sched_runqueue.h)
  */
 
 #ifndef SCHEDULER_H
@@ -8,6 +9,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "sched_record.h"
+#include "sched_runqueue.h"
 
 /* Task States */
 typedef enum {
@@ -70,12 +72,17 @@ typedef struct task {
     uint64_t start_time;            /* Task start time */
     uint32_t switches;              /* Number of context switches */
     
+    /* Run queue placement */
+    uint32_t cpu;                   /* CPU whose queue holds / last ran the task */
+    uint8_t rq_level;               /* Queue level while on_rq */
+    bool on_rq;                     /* Linked into a run queue */
+    
     /* Linked list pointers */
     struct task *next;              /* Next task in queue */
     struct task *prev;              /* Previous task in queue */
 } task_t;
 
-/* Scheduler statistics */
+/* Scheduler statistics (per CPU, or summed over CPUs by get_scheduler_stats) */
 typedef struct {
     uint64_t total_switches;        /* Total context switches */
     uint64_t total_interrupts;      /* Total timer interrupts */
@@ -83,6 +90,9 @@ typedef struct {
     uint32_t ready_tasks;           /* Number of ready tasks */
     sched_policy_t policy;          /* Current scheduling policy */
     uint32_t time_slice;            /* Current time slice */
+    uint64_t idle_ticks;            /* Ticks spent in the idle task */
+    uint64_t steals;                /* Tasks pulled from another CPU's queue */
+    uint64_t stolen;                /* Tasks other CPUs pulled from this queue */
 } scheduler_stats_t;
 
 /* Function prototypes */
@@ -92,6 +102,12 @@ int scheduler_init(sched_policy_t policy, uint32_t time_slice);
 void scheduler_start(void);
 void scheduler_stop(void);
 
+/* SMP: an application processor calls scheduler_cpu_online() on itself once
+ * it can take timer interrupts; CPU 0 is brought online by scheduler_init(). */
+int scheduler_cpu_online(uint32_t cpu);
+uint32_t scheduler_this_cpu(void);
+uint32_t scheduler_online_cpus(void);
+
 /* Task management */
 task_t* task_create(const char* name, void* entry_point, uint8_t priority, uint32_t stack_size);
 int task_destroy(uint32_t pid);
@@ -136,6 +152,12 @@ void     scheduler_preempt_set_mode(sched_rec_mode_t mode);
 uint32_t scheduler_preempt_points(const uint64_t** out);
 int      scheduler_preempt_load(uint64_t epoch, const uint64_t* pts, uint32_t n);
 
+/* Each CPU records its own switch points against its own logical clock. The
+ * calls above address CPU 0, the boot CPU; these address any online CPU. */
+uint32_t scheduler_preempt_points_cpu(uint32_t cpu, const uint64_t** out);
+int      scheduler_preempt_load_cpu(uint32_t cpu, uint64_t epoch,
+                                    const uint64_t* pts, uint32_t n);
+
 /* System calls */
 void sys_yield(void);
 void sys_sleep(uint32_t milliseconds);
@@ -143,6 +165,7 @@ void sys_exit(int status);
 
 /* Statistics and debugging */
 scheduler_stats_t* get_scheduler_stats(void);
+scheduler_stats_t* get_cpu_scheduler_stats(uint32_t cpu);
 void print_task_list(void);
 void print_scheduler_stats(void);
 
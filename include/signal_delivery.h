@@ -53,7 +53,7 @@ typedef struct {
 
 /* ========================== Constants and Limits ========================== */
 
-#define SIGNAL_QUEUE_MAX_SIZE       1024    /* Maximum signals per queue */
+#define SIGNAL_RT_QUEUE_SIZE        64      /* Queued realtime signals per process */
 #define SIGNAL_MAX_RT_SIGNALS       32      /* Maximum RT signals (32-63) */
 #define SIGNAL_MAX_PENDING          10000   /* Maximum pending signals per process */
 #define SIGNAL_DELIVERY_TIMEOUT_MS  5000    /* Signal delivery timeout */
@@ -111,37 +111,39 @@ union sigval {
 };
 
 /**
- * Signal queue entry
+ * Pending signal set
+ *
+ * Standard signals (1-31) are one bit each and coalesce: a second SIGCHLD
+ * while the first is pending only keeps the first one's info. Realtime
+ * signals (32-63) queue every instance in slots preallocated with the set,
+ * FIFO per signal, so generating a signal never allocates or sorts. The
+ * lowest-numbered pending realtime signal is delivered first.
  */
-typedef struct signal_queue_entry {
-    int signal;                             /* Signal number */
-    siginfo_t info;                         /* Signal information */
-    uint8_t priority;                       /* Signal priority */
-    uint32_t flags;                         /* Delivery flags */
-    uint64_t timestamp;                     /* Enqueue timestamp */
-    struct signal_queue_entry* next;        /* Next in queue */
-    struct signal_queue_entry* prev;        /* Previous in queue */
-} signal_queue_entry_t;
+#define SIGNAL_STD_COUNT            32
+#define SIGNAL_RT_MASK              0xFFFFFFFF00000000ULL
+#define SIGNAL_RT_SLOT_NONE         0xFFFF
 
-/**
- * Per-signal queue with priority ordering
- */
-typedef struct signal_queue {
-    signal_queue_entry_t* head;             /* First entry */
-    signal_queue_entry_t* tail;             /* Last entry */
-    uint32_t count;                         /* Number of entries */
-    uint32_t max_size;                      /* Maximum queue size */
-    uint8_t priority;                       /* Queue priority */
-    bool is_realtime;                       /* RT signal queue */
-    kernel_spinlock_t lock;                        /* Queue protection */
-} signal_queue_t;
+typedef struct signal_rt_slot {
+    siginfo_t info;                         /* Queued signal information */
+    uint16_t next;                          /* Next slot of this signal, or free list */
+} signal_rt_slot_t;
+
+typedef struct signal_pending {
+    uint64_t mask;                          /* Bit n set = signal n pending */
+    siginfo_t std_info[SIGNAL_STD_COUNT];   /* Info of each pending standard signal */
+    signal_rt_slot_t rt_slots[SIGNAL_RT_QUEUE_SIZE];
+    uint16_t rt_head[SIGNAL_MAX_RT_SIGNALS];    /* Oldest queued slot per signal */
+    uint16_t rt_tail[SIGNAL_MAX_RT_SIGNALS];    /* Newest queued slot per signal */
+    uint16_t rt_count[SIGNAL_MAX_RT_SIGNALS];   /* Instances queued per signal */
+    uint16_t rt_free;                       /* First unused slot */
+    uint16_t rt_queued;                     /* Slots in use */
+} signal_pending_t;
 
 /**
  * Process signal delivery state
  */
 typedef struct signal_delivery_state {
-    signal_queue_t* queues[64];             /* Per-signal queues (1-63) */
-    uint64_t pending_mask;                  /* Bitmask of pending signals */
+    signal_pending_t pending;               /* Pending signals (1-63) */
     uint64_t blocked_mask;                  /* Bitmask of blocked signals */
     uint32_t total_pending;                 /* Total pending signals */
     uint32_t max_pending;                   /* Maximum allowed pending */
@@ -251,66 +253,81 @@ bool signal_is_pending(process_t* proc, int signal);
  */
 int signal_get_next_pending(process_t* proc, siginfo_t* info);
 
-/* ========================== Signal Queue Management ========================== */
+/* ========================== Pending Signal Set ========================== */
+
+/* Results of signal_pending_add() */
+#define SIGNAL_PENDING_QUEUED       1       /* New pending instance */
+#define SIGNAL_PENDING_COALESCED    0       /* Standard signal already pending */
 
 /**
- * Create a signal queue for a specific signal
- * @param signal Signal number
- * @param max_size Maximum queue size
- * @param is_realtime Whether this is an RT signal queue
- * @return Pointer to queue, NULL on error
+ * Initialize an empty pending set
+ * @param set Pending set
  */
-signal_queue_t* signal_queue_create(int signal, uint32_t max_size, bool is_realtime);
+void signal_pending_init(signal_pending_t* set);
 
 /**
- * Destroy a signal queue
- * @param queue Queue to destroy
+ * Mark a signal pending
+ * @param set Pending set
+ * @param signal Signal number (1-63)
+ * @param info Signal information
+ * @return SIGNAL_PENDING_QUEUED, SIGNAL_PENDING_COALESCED, or -1 if the
+ *         signal is invalid or the realtime slots are exhausted
  */
-void signal_queue_destroy(signal_queue_t* queue);
+int signal_pending_add(signal_pending_t* set, int signal, const siginfo_t* info);
 
 /**
- * Enqueue a signal entry
- * @param queue Target queue
+ * Check whether a signal is pending
+ * @param set Pending set
+ * @param signal Signal number (0 for any signal)
+ * @return true if pending, false otherwise
+ */
+bool signal_pending_has(const signal_pending_t* set, int signal);
+
+/**
+ * Number of pending instances of a signal (at most 1 for standard signals)
+ * @param set Pending set
  * @param signal Signal number
- * @param info Signal information
- * @param priority Signal priority
- * @param flags Delivery flags
- * @return 0 on success, -1 on error
+ * @return Instance count
  */
-int signal_queue_enqueue(signal_queue_t* queue, int signal, const siginfo_t* info,
-                        uint8_t priority, uint32_t flags);
+uint32_t signal_pending_count(const signal_pending_t* set, int signal);
 
 /**
- * Dequeue the next signal entry
- * @param queue Source queue
- * @param info Buffer for signal information
- * @return Signal number, 0 if queue empty
+ * Choose the next signal to deliver: the lowest-numbered pending signal of
+ * the first class in order[] that has one, among signals in allowed
+ * @param set Pending set
+ * @param allowed Signals that may be delivered (not blocked)
+ * @param order Signal masks by decreasing priority
+ * @param levels Number of masks in order
+ * @return Signal number, 0 if none is deliverable
  */
-int signal_queue_dequeue(signal_queue_t* queue, siginfo_t* info);
+int signal_pending_select(const signal_pending_t* set, uint64_t allowed,
+                          const uint64_t* order, int levels);
 
 /**
- * Peek at the next signal without removing it
- * @param queue Source queue
+ * Copy the oldest pending instance of a signal without removing it
+ * @param set Pending set
+ * @param signal Signal number
  * @param info Buffer for signal information
- * @return Signal number, 0 if queue empty
+ * @return Signal number, 0 if not pending
  */
-int signal_queue_peek(signal_queue_t* queue, siginfo_t* info);
+int signal_pending_peek(const signal_pending_t* set, int signal, siginfo_t* info);
 
 /**
- * Clear all entries from a signal queue
- * @param queue Queue to clear
- * @return Number of entries removed
+ * Remove the oldest pending instance of a signal
+ * @param set Pending set
+ * @param signal Signal number
+ * @param info Buffer for signal information (can be NULL)
+ * @return Signal number, 0 if not pending
  */
-int signal_queue_clear(signal_queue_t* queue);
+int signal_pending_take(signal_pending_t* set, int signal, siginfo_t* info);
 
 /**
- * Get queue statistics
- * @param queue Target queue
- * @param count Current entry count
- * @param max_size Maximum queue size
- * @return 0 on success, -1 on error
+ * Drop every pending instance of a signal
+ * @param set Pending set
+ * @param signal Signal number
+ * @return Number of instances removed
  */
-int signal_queue_get_stats(signal_queue_t* queue, uint32_t* count, uint32_t* max_size);
+int signal_pending_discard(signal_pending_t* set, int signal);
 
 /* ========================== Signal Priority and Ordering ========================== */
 
@@ -336,14 +353,6 @@ int signal_compare_priority(int sig1, int sig2);
  */
 bool signal_can_coalesce(int signal);
 
-/**
- * Coalesce identical signals in queue
- * @param queue Target queue
- * @param signal Signal number
- * @return Number of signals coalesced
- */
-int signal_coalesce_in_queue(signal_queue_t* queue, int signal);
-
 /* ========================== Signal Masking and Blocking ========================== */
 
 /**
@@ -448,34 +457,6 @@ void signal_set_tracing(bool enabled, uint64_t trace_mask);
 
 /* ========================== Internal Helper Functions ========================== */
 
-/**
- * Allocate a signal queue entry
- * @return Pointer to entry, NULL on error
- */
-signal_queue_entry_t* signal_alloc_entry(void);
-
-/**
- * Free a signal queue entry
- * @param entry Entry to free
- */
-void signal_free_entry(signal_queue_entry_t* entry);
-
-/**
- * Insert entry into queue maintaining priority order
- * @param queue Target queue
- * @param entry Entry to insert
- * @return 0 on success, -1 on error
- */
-int signal_queue_insert_ordered(signal_queue_t* queue, signal_queue_entry_t* entry);
-
-/**
- * Remove specific entry from queue
- * @param queue Source queue
- * @param entry Entry to remove
- * @return 0 on success, -1 on error
- */
-int signal_queue_remove_entry(signal_queue_t* queue, signal_queue_entry_t* entry);
-
 /**
  * Validate signal number
  * @param signal Signal number to validate
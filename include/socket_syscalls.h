@@ -38,6 +38,12 @@ long sys_sendto(int sockfd, const void* buf, size_t len, int flags,
 long sys_recvfrom(int sockfd, void* buf, size_t len, int flags,
                   void* src_addr, uint32_t* addrlen);
 
+/* Vectored I/O on sockets and files, and file-to-socket transfer */
+struct vfs_iovec;
+long sys_readv(int fd, const struct vfs_iovec* iov, int iovcnt);
+long sys_writev(int fd, const struct vfs_iovec* iov, int iovcnt);
+long sys_sendfile(int out_fd, int in_fd, uint64_t* offset, size_t count);
+
 /* Socket Control */
 long sys_shutdown(int sockfd, int how);
 long sys_setsockopt(int sockfd, int level, int optname, 
@@ -0,0 +1,119 @@
+/* IKOS Demand Paging - Block-device swap area
+ *
+ * Backs a swap area with a region of a fat_block_device_t, replacing the
+ * zero-fill simulation demand_paging.c used for swap-in/swap-out. The area
+ * is an array of page-sized slots tracked by an allocation bitmap.
+ *
+ * Three things keep swap I/O cheap on a sector-at-a-time device:
+ *
+ *   - Clustered allocation. Slots are handed out from runs of
+ *     SWAP_CLUSTER_PAGES adjacent free slots, so pages reclaimed together
+ *     land next to each other on disk.
+ *   - Batched writeout. Writes to consecutive slots accumulate in a buffer
+ *     of up to SWAP_BATCH_PAGES pages and reach the device as a single
+ *     multi-sector command, either when the run breaks or on swap_flush().
+ *   - Readahead. A swap-in that misses reads the faulting slot together with
+ *     the allocated slots following it (up to SWAP_READAHEAD_PAGES) in one
+ *     command; subsequent faults on those neighbours are served from memory.
+ *
+ * Pages still sitting in the write batch are always served from the batch,
+ * so a read never sees stale disk contents.
+ */
+
+#ifndef SWAP_DEVICE_H
+#define SWAP_DEVICE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fat.h"   /* fat_block_device_t */
+
+/* Geometry */
+#define SWAP_PAGE_SIZE          4096
+#define SWAP_CLUSTER_PAGES      16      /* Slots reserved per allocation cluster */
+#define SWAP_BATCH_PAGES        16      /* Max pages per writeout command */
+#define SWAP_READAHEAD_PAGES    8       /* Max pages per swap-in command */
+
+/* Error codes */
+#define SWAP_OK                 0
+#define SWAP_ERR_PARAM          -1
+#define SWAP_ERR_IO             -2
+#define SWAP_ERR_NOMEM          -3
+#define SWAP_ERR_FULL           -4      /* No free slot */
+
+typedef struct swap_device_stats {
+    uint64_t pages_written;         /* Pages sent to the device */
+    uint64_t write_commands;        /* Multi-sector write commands issued */
+    uint64_t pages_read;            /* Pages read from the device (incl. readahead) */
+    uint64_t read_commands;         /* Multi-sector read commands issued */
+    uint64_t readahead_pages;       /* Neighbour pages pulled in speculatively */
+    uint64_t readahead_hits;        /* Swap-ins served from the readahead window */
+    uint64_t batch_hits;            /* Swap-ins served from the pending write batch */
+    uint64_t cluster_allocs;        /* New allocation clusters opened */
+    uint64_t io_errors;             /* Device commands that failed */
+} swap_device_stats_t;
+
+typedef struct swap_device {
+    fat_block_device_t* dev;
+    uint32_t first_sector;          /* First sector of the swap area */
+    uint32_t sectors_per_page;      /* SWAP_PAGE_SIZE / dev->sector_size */
+    uint32_t pages;                 /* Number of slots */
+    uint32_t free_pages;            /* Unallocated slots */
+    uint64_t* bitmap;               /* One bit per slot, set = allocated */
+
+    /* Clustered allocation */
+    uint32_t cluster_next;          /* Next slot in the open cluster */
+    uint32_t cluster_end;           /* End (exclusive) of the open cluster */
+    uint32_t scan_hint;             /* Where the next cluster search starts */
+
+    /* Pending writeout: batch_count pages destined for slots batch_start.. */
+    uint8_t* batch_buf;
+    uint32_t batch_start;
+    uint32_t batch_count;
+
+    /* Readahead window: ra_count pages read from slots ra_start.. */
+    uint8_t* ra_buf;
+    uint32_t ra_start;
+    uint32_t ra_count;
+
+    swap_device_stats_t stats;
+    bool initialized;
+} swap_device_t;
+
+/* Bind a swap area of `pages` slots starting at first_sector of dev. The
+ * device's sector size must divide SWAP_PAGE_SIZE and the area must fit on
+ * the device. All slots start free; nothing is written. */
+int swap_device_init(swap_device_t* swap, fat_block_device_t* dev,
+                     uint32_t first_sector, uint32_t pages);
+
+/* Flush pending writes and release the bitmap and buffers. */
+void swap_device_release(swap_device_t* swap);
+
+/* Allocate a slot, preferring the slot after the last one handed out so that
+ * consecutive reclaims stay adjacent. Returns SWAP_ERR_FULL when exhausted. */
+int swap_slot_alloc(swap_device_t* swap, uint32_t* slot);
+
+/* Return a slot to the free pool. */
+void swap_slot_free(swap_device_t* swap, uint32_t slot);
+
+/* Queue a page for writeout to an allocated slot. The page is copied, so the
+ * caller may reuse the frame immediately. Consecutive slots are coalesced
+ * into one device command; the batch is flushed when the run breaks or fills. */
+int swap_write_page(swap_device_t* swap, uint32_t slot, const void* page);
+
+/* Issue any pending batched writes to the device. */
+int swap_flush(swap_device_t* swap);
+
+/* Read an allocated slot into page, serving it from the write batch or the
+ * readahead window when possible and otherwise reading ahead from disk. */
+int swap_read_page(swap_device_t* swap, uint32_t slot, void* page);
+
+/* Is the slot currently allocated? */
+bool swap_slot_in_use(const swap_device_t* swap, uint32_t slot);
+
+/* Swap areas built on this module (demand_paging.c). swapon() returns the
+ * area's index, or -1 if demand paging is off or the region does not fit. */
+int swapon(const char* path, fat_block_device_t* dev, uint32_t first_sector,
+           uint32_t pages, uint32_t priority);
+int swapoff(const char* path);
+
+#endif /* SWAP_DEVICE_H */
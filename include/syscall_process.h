@@ -16,6 +16,8 @@
 #define SYSCALL_EXECVE      3   /* execve() - Execute program */
 #define SYSCALL_WAIT        4   /* wait() - Wait for child */
 #define SYSCALL_WAITPID     5   /* waitpid() - Wait for specific child */
+#define SYSCALL_SPAWN       6   /* spawn() - Create child from an executable */
+#define SYSCALL_VFORK       7   /* vfork() - Create child sharing parent memory */
 
 /* ========================== Wait Options ========================== */
 
@@ -59,6 +61,11 @@
 #define ENOEXEC     8       /* Exec format error */
 #define E2BIG       7       /* Argument list too long */
 #define ECHILD      10      /* No child processes */
+#define EBADF       9       /* Bad file descriptor */
+
+/* ========================== Descriptor Flags ========================== */
+
+#define FD_CLOEXEC          0x08000000  /* Close on exec (and spawn); between the VFS_O_* bits and the extstate kind */
 
 /* ========================== Process Lifecycle State ========================== */
 
@@ -97,6 +104,42 @@ typedef struct {
     uint64_t heap_base;         /* Heap base address */
 } exec_context_t;
 
+/* ========================== Spawn Attributes ========================== */
+
+/*
+ * spawn() builds a new process straight from an executable, so nothing of
+ * the caller's address space is duplicated. The child holds the caller's
+ * descriptors except those marked FD_CLOEXEC, then the file actions run in
+ * order against the child's table, as they would between fork() and exec().
+ * Descriptor numbers are VFS-wide in this kernel, so an inherited descriptor
+ * keeps its number and there is no dup2-style renumbering.
+ */
+
+#define SPAWN_MAX_FILE_ACTIONS  16
+
+/* File actions */
+#define SPAWN_FA_CLOSE      1   /* Drop inherited descriptor fd */
+#define SPAWN_FA_OPEN       2   /* Open path into the child; fd is set to it */
+
+/* Attribute flags */
+#define SPAWN_SETSIGMASK    0x01    /* Child starts with sigmask */
+#define SPAWN_SETSIGDEF     0x02    /* Signals in sigdefault reset to SIG_DFL */
+
+typedef struct {
+    uint32_t op;                /* SPAWN_FA_* */
+    int fd;                     /* CLOSE: descriptor; OPEN: result */
+    uint32_t oflag;             /* OPEN flags (VFS_O_*) */
+    const char* path;           /* OPEN path */
+} spawn_file_action_t;
+
+typedef struct {
+    uint32_t flags;             /* SPAWN_SET* */
+    uint64_t sigmask;           /* Initial blocked signals */
+    uint64_t sigdefault;        /* Ignored signals to reset to default */
+    uint32_t action_count;      /* Entries used in actions[] */
+    spawn_file_action_t actions[SPAWN_MAX_FILE_ACTIONS];
+} spawn_attr_t;
+
 /* ========================== Wait Context ========================== */
 
 typedef struct {
@@ -123,6 +166,10 @@ typedef struct {
     uint64_t zombies_created;   /* Zombie processes created */
     uint64_t zombies_reaped;    /* Zombie processes reaped */
     uint64_t orphans_adopted;   /* Orphaned processes adopted */
+    uint64_t total_spawns;      /* Total spawn operations */
+    uint64_t successful_spawns; /* Successful spawns */
+    uint64_t failed_spawns;     /* Failed spawns */
+    uint64_t total_vforks;      /* vfork operations */
 } process_lifecycle_stats_t;
 
 /* ========================== System Call Prototypes ========================== */
@@ -135,6 +182,30 @@ typedef struct {
  */
 long sys_fork(void);
 
+/**
+ * Spawn system call - Create process from executable
+ * Loads the program into a fresh address space; the caller's memory is
+ * never copied. Equivalent to fork() + file actions + execve() in the child.
+ * 
+ * @param path Path to executable file
+ * @param argv Argument vector (NULL-terminated)
+ * @param envp Environment vector (NULL-terminated, may be NULL)
+ * @param attr File actions and signal setup (may be NULL); OPEN actions
+ *             report the descriptor the child received
+ * @return long Child PID, negative error code on failure
+ */
+long sys_spawn(const char* path, char* const argv[], char* const envp[],
+               spawn_attr_t* attr);
+
+/**
+ * Vfork system call - Create child that borrows parent memory
+ * The child runs in the parent's address space and the parent is suspended
+ * until the child calls execve() or exits. The child must do nothing else.
+ * 
+ * @return long Child PID in parent, 0 in child, negative error on failure
+ */
+long sys_vfork(void);
+
 /**
  * Execve system call - Execute program
  * Replace current process image with new program
@@ -238,6 +309,11 @@ int add_child_process(process_t* parent, process_t* child);
  */
 int remove_child_process(process_t* parent, process_t* child);
 
+/**
+ * Resume the parent of a vfork child (called on its execve or exit)
+ */
+void vfork_release(process_t* child);
+
 /**
  * Find child process by PID
  */
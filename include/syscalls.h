@@ -31,6 +31,9 @@
 #define SYS_GETSOCKOPT          711
 #define SYS_GETSOCKNAME         712
 #define SYS_GETPEERNAME         713
+#define SYS_READV               714
+#define SYS_WRITEV              715
+#define SYS_SENDFILE            716
 
 /* Threading and concurrency syscalls (Issue #52) */
 #define SYS_THREAD_CREATE       720
@@ -50,6 +53,8 @@
 #define SYS_MUTEX_TRYLOCK       733
 #define SYS_MUTEX_UNLOCK        734
 #define SYS_MUTEX_TIMEDLOCK     735
+#define SYS_FUTEX_WAIT          736
+#define SYS_FUTEX_WAKE          737
 
 #define SYS_COND_INIT           740
 #define SYS_COND_DESTROY        741
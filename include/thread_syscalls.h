@@ -12,6 +12,17 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include "process.h"
+#include "futex.h"
+#include "timer_wheel.h"
+
+/* Same layout and guard as pthread.h, which this header does not pull in */
+#ifndef _TIMESPEC_DEFINED
+struct timespec {
+    long tv_sec;                    /* Seconds */
+    long tv_nsec;                   /* Nanoseconds */
+};
+#define _TIMESPEC_DEFINED
+#endif
 
 /* Thread system call numbers (extending from existing syscalls) */
 #define SYS_THREAD_CREATE       720
@@ -31,6 +42,8 @@
 #define SYS_MUTEX_TRYLOCK       733
 #define SYS_MUTEX_UNLOCK        734
 #define SYS_MUTEX_TIMEDLOCK     735
+#define SYS_FUTEX_WAIT          736
+#define SYS_FUTEX_WAKE          737
 
 #define SYS_COND_INIT           740
 #define SYS_COND_DESTROY        741
@@ -81,6 +94,7 @@
 #define THREAD_EINVAL          -22
 #define THREAD_EPERM           -1
 #define THREAD_ESRCH           -3
+#define THREAD_EINTR           -4
 #define THREAD_EDEADLK         -35
 #define THREAD_ENOMEM          -12
 #define THREAD_EBUSY           -16
@@ -93,6 +107,8 @@
 #define MAX_SEMAPHORES_PER_PROCESS 256
 #define MAX_CONDITION_VARS_PER_PROCESS 256
 #define MAX_TLS_KEYS_GLOBAL     256
+#define KSEM_VALUE_MAX          32767   /* Matches SEM_VALUE_MAX */
+#define KBARRIER_SERIAL_THREAD  1       /* Returned to the thread that releases a barrier */
 
 #define THREAD_NAME_MAX         32
 #define THREAD_STACK_MIN        (16 * 1024)
@@ -159,6 +175,9 @@ typedef struct kthread {
     void* blocking_on;              /* Object thread is blocked on */
     uint32_t blocking_type;         /* Type of blocking object */
     struct kthread* blocker_next;   /* Next in blocker queue */
+    futex_waiter_t futex_wait;      /* Futex queue entry while in sys_futex_wait */
+    ktimer_t wait_timer;            /* Sleep / wait timeout */
+    volatile bool timed_out;        /* Set when wait_timer fired */
     
     /* Parent process */
     process_t* process;             /* Parent process */
@@ -166,6 +185,7 @@ typedef struct kthread {
     /* Thread list management */
     struct kthread* next;           /* Next thread in process */
     struct kthread* prev;           /* Previous thread in process */
+    struct kthread* tid_next;       /* Next in TID hash chain */
     struct kthread* next_global;    /* Next in global thread list */
     struct kthread* prev_global;    /* Previous in global thread list */
     
@@ -194,15 +214,28 @@ struct cleanup_handler {
  * Synchronization Structures
  * ================================ */
 
+/* FIFO of blocked threads, linked through kthread_t.blocker_next. Every
+ * blocking object below keeps its sleepers in one of these. */
+typedef struct {
+    kthread_t* head;                /* Next thread to wake */
+    kthread_t* tail;                /* Most recent sleeper */
+    uint32_t count;                 /* Threads queued */
+} kwait_queue_t;
+
+/* Object magic numbers, also used to dispatch thread_wake_all_waiters() */
+#define KMUTEX_MAGIC            0x4D555458  /* "MUTX" */
+#define KCOND_MAGIC             0x434F4E44  /* "COND" */
+#define KSEM_MAGIC              0x53454D41  /* "SEMA" */
+#define KRWLOCK_MAGIC           0x52574C4B  /* "RWLK" */
+#define KBARRIER_MAGIC          0x42415252  /* "BARR" */
+
 /* Kernel mutex structure */
 typedef struct {
     uint32_t magic;                 /* Magic number for validation */
     uint32_t type;                  /* Mutex type */
     uint32_t owner_tid;             /* Owner thread ID */
     uint32_t lock_count;            /* Lock count (for recursive mutexes) */
-    uint32_t waiters_count;         /* Number of waiting threads */
-    kthread_t* wait_queue_head;     /* Head of wait queue */
-    kthread_t* wait_queue_tail;     /* Tail of wait queue */
+    kwait_queue_t waiters;          /* Threads waiting to lock */
     uint64_t creation_time;         /* Creation timestamp */
     uint32_t flags;                 /* Mutex flags */
 } kmutex_t;
@@ -210,12 +243,15 @@ typedef struct {
 /* Kernel condition variable structure */
 typedef struct {
     uint32_t magic;                 /* Magic number for validation */
-    uint32_t waiters_count;         /* Number of waiting threads */
-    kthread_t* wait_queue_head;     /* Head of wait queue */
-    kthread_t* wait_queue_tail;     /* Tail of wait queue */
+    kwait_queue_t waiters;          /* Threads waiting for a signal */
     uint64_t creation_time;         /* Creation timestamp */
     uint32_t flags;                 /* Condition variable flags */
     uint32_t broadcast_seq;         /* Broadcast sequence number */
+    /* User mutex the current waiters released, for requeue on broadcast */
+    uint32_t* mutex_word;           /* Lock word in user memory */
+    uint32_t mutex_pid;             /* Process whose address space maps it */
+    uint64_t mutex_space;           /* Its futex key */
+    uint64_t mutex_addr;
 } kcond_t;
 
 /* Kernel semaphore structure */
@@ -223,9 +259,7 @@ typedef struct {
     uint32_t magic;                 /* Magic number for validation */
     uint32_t value;                 /* Current semaphore value */
     uint32_t max_value;             /* Maximum semaphore value */
-    uint32_t waiters_count;         /* Number of waiting threads */
-    kthread_t* wait_queue_head;     /* Head of wait queue */
-    kthread_t* wait_queue_tail;     /* Tail of wait queue */
+    kwait_queue_t waiters;          /* Threads waiting for a post */
     uint64_t creation_time;         /* Creation timestamp */
     uint32_t flags;                 /* Semaphore flags */
 } ksem_t;
@@ -235,11 +269,9 @@ typedef struct {
     uint32_t magic;                 /* Magic number for validation */
     uint32_t readers;               /* Number of active readers */
     uint32_t writers;               /* Number of active writers (0 or 1) */
-    uint32_t read_waiters;          /* Number of threads waiting to read */
-    uint32_t write_waiters;         /* Number of threads waiting to write */
     uint32_t writer_tid;            /* ID of thread holding write lock */
-    kthread_t* read_wait_queue;     /* Queue of threads waiting to read */
-    kthread_t* write_wait_queue;    /* Queue of threads waiting to write */
+    kwait_queue_t read_waiters;     /* Threads waiting to read */
+    kwait_queue_t write_waiters;    /* Threads waiting to write */
     uint64_t creation_time;         /* Creation timestamp */
     uint32_t flags;                 /* Lock flags */
 } krwlock_t;
@@ -250,8 +282,7 @@ typedef struct {
     uint32_t count;                 /* Total number of threads */
     uint32_t waiting;               /* Number of waiting threads */
     uint32_t generation;            /* Current generation number */
-    kthread_t* wait_queue_head;     /* Head of wait queue */
-    kthread_t* wait_queue_tail;     /* Tail of wait queue */
+    kwait_queue_t waiters;          /* Threads waiting for the rest */
     uint64_t creation_time;         /* Creation timestamp */
 } kbarrier_t;
 
@@ -281,6 +312,9 @@ int sys_thread_cancel(uint32_t tid);
 int sys_thread_kill(uint32_t tid, int sig);
 int sys_thread_setname(uint32_t tid, const char* name);
 
+/* Absolute timeouts (abstime) below are on the kernel clock: time since boot,
+ * kept by the timer wheel at KTIMER_HZ resolution. */
+
 /* Mutex syscalls */
 int sys_mutex_init(uint32_t* mutex_id, const pthread_mutexattr_t* attr);
 int sys_mutex_destroy(uint32_t mutex_id);
@@ -289,11 +323,17 @@ int sys_mutex_trylock(uint32_t mutex_id);
 int sys_mutex_unlock(uint32_t mutex_id);
 int sys_mutex_timedlock(uint32_t mutex_id, const struct timespec* abstime);
 
+/* Futex syscalls: the contended slow path of user-space mutexes */
+int sys_futex_wait(uint32_t* uaddr, uint32_t expected, const struct timespec* abstime,
+                   uint32_t flags);
+int sys_futex_wake(uint32_t* uaddr, uint32_t count, uint32_t flags);
+
 /* Condition variable syscalls */
 int sys_cond_init(uint32_t* cond_id, const pthread_condattr_t* attr);
 int sys_cond_destroy(uint32_t cond_id);
-int sys_cond_wait(uint32_t cond_id, uint32_t mutex_id);
-int sys_cond_timedwait(uint32_t cond_id, uint32_t mutex_id, const struct timespec* abstime);
+int sys_cond_wait(uint32_t cond_id, uint32_t* mutex_word, uint32_t flags);
+int sys_cond_timedwait(uint32_t cond_id, uint32_t* mutex_word, uint32_t flags,
+                       const struct timespec* abstime);
 int sys_cond_signal(uint32_t cond_id);
 int sys_cond_broadcast(uint32_t cond_id);
 
@@ -361,6 +401,15 @@ int thread_dequeue_wait(kthread_t* thread);
 kthread_t* thread_dequeue_first_waiter(void* sync_object);
 int thread_wake_all_waiters(void* sync_object);
 
+/* Wait queues */
+void wait_queue_init(kwait_queue_t* queue);
+void wait_queue_add(kwait_queue_t* queue, kthread_t* thread);
+kthread_t* wait_queue_pop(kwait_queue_t* queue);
+bool wait_queue_remove(kwait_queue_t* queue, kthread_t* thread);
+uint32_t wait_queue_wake(kwait_queue_t* queue, uint32_t count);
+void thread_ready(kthread_t* thread);
+void thread_wake(kthread_t* thread);
+
 /* Thread context switching */
 void thread_context_switch(kthread_t* prev, kthread_t* next);
 void thread_save_context(kthread_t* thread);
@@ -436,6 +485,7 @@ typedef struct {
     uint64_t context_switches;      /* Total context switches */
     uint64_t mutex_operations;      /* Total mutex operations */
     uint64_t cond_operations;       /* Total condition variable operations */
+    uint64_t cond_requeues;         /* Broadcast waiters moved to the mutex queue */
     uint64_t sem_operations;        /* Total semaphore operations */
     uint64_t rwlock_operations;     /* Total read-write lock operations */
     uint64_t spinlock_operations;   /* Total spinlock operations */
@@ -0,0 +1,120 @@
+/* IKOS Kernel Timers - Hierarchical timer wheel
+ *
+ * Replaces polling loops and periodic scans with timers that fire at a given
+ * tick. The wheel has TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SLOTS slots;
+ * level 0 covers the next 64 ticks one slot per tick, each level above covers
+ * 64 times the span of the one below. A timer is linked on the slot its
+ * expiry falls in, so arming and cancelling are O(1) list operations. When
+ * level 0 wraps, the next slot of level 1 is cascaded (re-spread over level
+ * 0), and so on up; each timer is cascaded at most once per level.
+ *
+ * Expiry is batched: each tick splices its whole level-0 slot off at once and
+ * fires everything on it. Callbacks run with the wheel lock dropped, so they
+ * may re-arm or cancel timers, but they run in timer-interrupt context and
+ * must not sleep.
+ *
+ * The wheel functions are pure and host-testable; the ktimer_* functions
+ * operate on the single kernel wheel that scheduler_tick() advances.
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Kernel tick rate: the wheel advances once per timer interrupt */
+#define KTIMER_HZ               1000
+
+/* Wheel geometry */
+#define TIMER_WHEEL_LEVELS      4
+#define TIMER_WHEEL_BITS        6
+#define TIMER_WHEEL_SLOTS       (1U << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK        (TIMER_WHEEL_SLOTS - 1)
+/* Longest delay placed directly (~4.6 hours at 1 kHz); longer timers are
+ * parked in the top level and re-filed each time it comes round. */
+#define TIMER_WHEEL_MAX_DELAY   ((1ULL << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS)) - 1)
+
+/* Called when a timer fires, with the wheel lock dropped */
+typedef void (*ktimer_fn)(void* data);
+
+typedef struct ktimer {
+    uint64_t expires;                   /* Absolute tick to fire at */
+    uint64_t period;                    /* Re-arm interval, 0 = one-shot */
+    ktimer_fn fn;
+    void* data;
+    struct ktimer* next;
+    struct ktimer** pprev;              /* Link pointing at us, NULL if idle */
+} ktimer_t;
+
+typedef struct timer_wheel_stats {
+    uint64_t started;                   /* Timers armed */
+    uint64_t cancelled;                 /* Pending timers cancelled */
+    uint64_t expired;                   /* Callbacks run */
+    uint64_t cascaded;                  /* Timers moved down a level */
+} timer_wheel_stats_t;
+
+typedef struct timer_wheel {
+    volatile uint32_t lock;
+    uint64_t now;                       /* Last tick processed */
+    uint32_t pending;                   /* Timers currently armed */
+    ktimer_t* running;                  /* Timer whose callback is executing */
+    ktimer_t* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    timer_wheel_stats_t stats;
+} timer_wheel_t;
+
+/* Empty wheel whose clock reads `now`. */
+void timer_wheel_init(timer_wheel_t* wheel, uint64_t now);
+
+/* Idle timer that will call fn(data) when it fires. */
+void ktimer_init(ktimer_t* timer, ktimer_fn fn, void* data);
+
+/* Arm `timer` to fire `delay` ticks from now (at least one), then every
+ * `period` ticks if period is non-zero. Re-arms a timer that is already
+ * pending. */
+void timer_wheel_add(timer_wheel_t* wheel, ktimer_t* timer, uint64_t delay, uint64_t period);
+
+/* Disarm a pending timer. Returns true if it was pending, false if it had
+ * already fired (or was never armed). Does not wait for a running callback. */
+bool timer_wheel_cancel(timer_wheel_t* wheel, ktimer_t* timer);
+
+/* Move the clock forward to `now`, firing every timer that expires on the
+ * way in tick order. Returns the number of callbacks run. */
+uint32_t timer_wheel_advance(timer_wheel_t* wheel, uint64_t now);
+
+/* Whether `timer` is armed and has not fired yet. */
+static inline bool ktimer_pending(const ktimer_t* timer) {
+    return timer->pprev != 0;
+}
+
+/* Whole ticks covering `ms` milliseconds, rounded up. */
+static inline uint64_t ktimer_ms_to_ticks(uint64_t ms) {
+    return (ms * KTIMER_HZ + 999) / 1000;
+}
+
+/* ---- Kernel wheel ---- */
+
+/* Current kernel tick count since boot. */
+uint64_t ktimer_now(void);
+
+/* Fire once, `delay` ticks from now. */
+void ktimer_start(ktimer_t* timer, uint64_t delay);
+
+/* Fire every `period` ticks, starting one period from now. */
+void ktimer_start_periodic(ktimer_t* timer, uint64_t period);
+
+/* Disarm; see timer_wheel_cancel(). */
+bool ktimer_cancel(ktimer_t* timer);
+
+/* Disarm and, if the callback is running on another CPU, wait for it to
+ * finish. After this returns the callback no longer touches its data.
+ * Must not be called from the timer's own callback. */
+bool ktimer_cancel_sync(ktimer_t* timer);
+
+/* Advance the kernel wheel by one tick; called by scheduler_tick(). */
+void ktimer_tick(void);
+
+/* Kernel wheel statistics. */
+timer_wheel_stats_t ktimer_get_stats(void);
+
+#endif /* TIMER_WHEEL_H */
@@ -9,6 +9,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "vm_interval_tree.h"
 
 /* Basic atomic types for user space testing */
 typedef struct { volatile int counter; } atomic_t;
@@ -138,8 +139,8 @@ typedef struct vm_area_struct {
     struct vm_area_struct* vm_next;             /* Next VMA in list */
     struct vm_area_struct* vm_prev;             /* Previous VMA in list */
     
-    /* Red-black tree for fast lookup */
-    struct vm_area_struct* vm_rb_node;          /* RB tree node */
+    /* Augmented interval tree for fast lookup */
+    vm_itree_node_t        vm_rb;                /* Link in mm->mm_rb */
     
     /* Operations */
     struct vm_operations*  vm_ops;               /* VMA operations */
@@ -174,8 +175,8 @@ typedef struct mm_struct {
     vm_area_struct_t*      mmap_cache;           /* Last accessed VMA */
     uint32_t               map_count;            /* Number of VMAs */
     
-    /* Red-black tree for fast VMA lookup */
-    void*                  mm_rb;                /* RB tree root */
+    /* Augmented interval tree for fast VMA lookup and gap search */
+    vm_itree_t             mm_rb;                /* VMA index (mirrors mmap list) */
     
     /* Address space layout */
     uint64_t               task_size;            /* Task virtual address space size */
@@ -8,6 +8,8 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "page_cache.h"
+#include "dcache.h"
 
 /* Type definitions for compatibility */
 typedef long long ssize_t;              /* Signed size type */
@@ -19,6 +21,9 @@ typedef long long ssize_t;              /* Signed size type */
 #define VFS_MAX_OPEN_FILES          1024    /* Maximum open files globally */
 #define VFS_MAX_FILESYSTEMS         16      /* Maximum registered filesystems */
 #define VFS_MAX_DEVICES             64      /* Maximum block devices */
+#define VFS_PAGE_CACHE_MAX_PAGES    4096    /* Page cache budget (16 MB) */
+#define VFS_DCACHE_MAX_UNUSED       1024    /* Unused dentries kept cached */
+#define VFS_MAX_IOV                 1024    /* Segments per readv/writev */
 
 /* File types */
 typedef enum {
@@ -114,6 +119,12 @@ typedef struct vfs_stat {
     uint32_t st_rdev;               /* Device ID for special files */
 } vfs_stat_t;
 
+/* One segment of a vectored read or write */
+typedef struct vfs_iovec {
+    void* iov_base;                 /* Segment start */
+    size_t iov_len;                 /* Segment length */
+} vfs_iovec_t;
+
 /* Directory entry structure */
 typedef struct vfs_dirent {
     uint64_t d_ino;                         /* Inode number */
@@ -210,6 +221,7 @@ typedef struct vfs_inode {
     void* i_private;                    /* Filesystem-specific data */
     uint32_t i_state;                   /* Inode state flags */
     uint32_t i_count;                   /* Reference count */
+    page_cache_mapping_t i_data;        /* Cached pages (no aops: uncached) */
 } vfs_inode_t;
 
 /* Directory entry structure */
@@ -223,6 +235,7 @@ typedef struct vfs_dentry {
     uint32_t d_flags;                       /* Dentry flags */
     uint32_t d_count;                       /* Reference count */
     void* d_fsdata;                         /* Filesystem-specific data */
+    dcache_entry_t d_hash;                  /* Dentry cache linkage and references */
 } vfs_dentry_t;
 
 /* File structure */
@@ -236,6 +249,7 @@ typedef struct vfs_file {
     uint32_t f_count;                   /* Reference count */
     uint32_t f_owner;                   /* Owner process ID */
     void* f_private_data;               /* Filesystem-specific data */
+    page_cache_ra_t f_ra;               /* Readahead state for cached reads */
 } vfs_file_t;
 
 /* Superblock structure */
@@ -320,8 +334,11 @@ vfs_mount_t* vfs_get_mount(const char* path);
 /* File operations */
 int vfs_open(const char* path, uint32_t flags, uint32_t mode);
 int vfs_close(int fd);
+int vfs_retain(int fd);
 ssize_t vfs_read(int fd, void* buffer, size_t count);
 ssize_t vfs_write(int fd, const void* buffer, size_t count);
+ssize_t vfs_readv(int fd, const vfs_iovec_t* iov, int iovcnt);
+ssize_t vfs_writev(int fd, const vfs_iovec_t* iov, int iovcnt);
 int vfs_flush(int fd);
 int vfs_fsync(int fd);
 uint64_t vfs_lseek(int fd, uint64_t offset, int whence);
@@ -363,12 +380,35 @@ int vfs_path_walk(const char* path, vfs_dentry_t** dentry);
 vfs_dentry_t* vfs_alloc_dentry(const char* name);
 void vfs_free_dentry(vfs_dentry_t* dentry);
 vfs_dentry_t* vfs_dentry_lookup(vfs_dentry_t* parent, const char* name);
+void vfs_dentry_add_child(vfs_dentry_t* parent, vfs_dentry_t* child);
+void vfs_dput(vfs_dentry_t* dentry);
+
+/* Dentry cache: lookups and the dentries they return hold a reference,
+ * dropped with vfs_dput(); unused dentries are evicted LRU */
+uint32_t vfs_dcache_shrink(uint32_t nr_dentries);
+void vfs_get_dcache_stats(dcache_stats_t* stats);
 
 /* Inode operations */
 vfs_inode_t* vfs_alloc_inode(vfs_superblock_t* sb);
 void vfs_free_inode(vfs_inode_t* inode);
 int vfs_inode_permission(vfs_inode_t* inode, int mask);
 
+/* Page cache: a filesystem sets aops on its regular files to have
+ * vfs_read/vfs_write served from memory */
+void vfs_inode_set_aops(vfs_inode_t* inode, const page_cache_aops_t* aops);
+int vfs_sync_fs(vfs_superblock_t* sb);
+int vfs_sync(void);
+uint32_t vfs_page_cache_shrink(uint32_t nr_pages);
+
+/* Hand up to `count` bytes of the file to `actor` straight from the page
+ * cache (sendfile). Reads from *offset and advances it, or from and past
+ * the file position when offset is NULL. The actor runs with the cache
+ * locked and must not re-enter the VFS; files that are not cached are
+ * passed through a one-page bounce buffer. Returns the bytes consumed or
+ * the actor's error if it consumed none. */
+ssize_t vfs_read_actor(int fd, uint64_t* offset, size_t count, page_cache_actor_t actor, void* ctx);
+void vfs_get_page_cache_stats(page_cache_stats_t* stats);
+
 /* File descriptor management */
 int vfs_alloc_fd(void);
 void vfs_free_fd(int fd);
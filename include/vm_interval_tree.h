@@ -0,0 +1,99 @@
+/* IKOS Virtual Memory - Augmented interval tree for address-space lookup
+ *
+ * An intrusive red-black tree of non-overlapping [start, end) intervals, keyed
+ * by start address. It backs both the VMM region list (vm_space_t) and the
+ * user-space VMA list (mm_struct_t), replacing their linear walks on the page
+ * fault path with O(log n) lookup.
+ *
+ * Every node is augmented with the free gap that precedes it (the distance from
+ * its predecessor's end, or from the tree's low bound) and with the largest such
+ * gap in its subtree. That lets vm_itree_find_gap() place a new mapping by
+ * descending only into subtrees that can hold it, instead of probing the
+ * address space page by page.
+ *
+ * The node is embedded in the owning structure and recovered with
+ * VM_ITREE_ENTRY(); the tree never allocates. Callers keep their own sorted
+ * linked lists for in-order walks; the tree only answers positional queries.
+ * Nodes keep private copies of start/end: when an owner trims or grows an
+ * interval in place it must call vm_itree_resize() so the gaps stay correct.
+ */
+
+#ifndef VM_INTERVAL_TREE_H
+#define VM_INTERVAL_TREE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Result codes */
+#define VM_ITREE_OK          0
+#define VM_ITREE_EINVAL     -1   /* Bad arguments or empty interval */
+#define VM_ITREE_EOVERLAP   -2   /* Interval overlaps an existing node */
+
+typedef struct vm_itree_node {
+    struct vm_itree_node* parent;
+    struct vm_itree_node* left;
+    struct vm_itree_node* right;
+    uint64_t start;                 /* Interval start (inclusive) */
+    uint64_t end;                   /* Interval end (exclusive) */
+    uint64_t gap;                   /* Free bytes between predecessor's end and start */
+    uint64_t subtree_gap;           /* Largest gap anywhere in this subtree */
+    uint8_t  color;                 /* VM_ITREE_RED / VM_ITREE_BLACK */
+} vm_itree_node_t;
+
+typedef struct vm_itree {
+    vm_itree_node_t* root;
+    uint64_t low;                   /* Lowest usable address (gap base for the first node) */
+    uint64_t high;                  /* End of the usable range (bounds the trailing gap) */
+    uint32_t count;                 /* Number of nodes */
+} vm_itree_t;
+
+/* Recover the owning structure from an embedded node. */
+#define VM_ITREE_ENTRY(ptr, type, member) \
+    ((type*)((char*)(ptr) - offsetof(type, member)))
+
+/* Initialise an empty tree covering the usable range [low, high). */
+void vm_itree_init(vm_itree_t* tree, uint64_t low, uint64_t high);
+
+/* Insert node covering [start, end). Fails with VM_ITREE_EOVERLAP if any part
+ * of the interval is already present. */
+int vm_itree_insert(vm_itree_t* tree, vm_itree_node_t* node,
+                    uint64_t start, uint64_t end);
+
+/* Remove node from the tree. The node must currently be linked into tree. */
+void vm_itree_remove(vm_itree_t* tree, vm_itree_node_t* node);
+
+/* Change a linked node's bounds in place (trim, grow, or split the tail off).
+ * The new interval must not overlap its neighbours or change its order. */
+int vm_itree_resize(vm_itree_t* tree, vm_itree_node_t* node,
+                    uint64_t start, uint64_t end);
+
+/* Node whose interval contains addr, or NULL. */
+vm_itree_node_t* vm_itree_find(const vm_itree_t* tree, uint64_t addr);
+
+/* First node with end > addr (the node containing addr, or the next one above
+ * it). This is the classic find_vma() contract. */
+vm_itree_node_t* vm_itree_lower_bound(const vm_itree_t* tree, uint64_t addr);
+
+/* First node intersecting [start, end), or NULL. Continue a range walk with
+ * vm_itree_next() while node->start < end. */
+vm_itree_node_t* vm_itree_first_overlap(const vm_itree_t* tree,
+                                        uint64_t start, uint64_t end);
+
+/* In-order neighbours and extremes. */
+vm_itree_node_t* vm_itree_first(const vm_itree_t* tree);
+vm_itree_node_t* vm_itree_last(const vm_itree_t* tree);
+vm_itree_node_t* vm_itree_next(const vm_itree_node_t* node);
+vm_itree_node_t* vm_itree_prev(const vm_itree_node_t* node);
+
+/* Lowest address a >= floor such that [a, a + len) is entirely free and lies
+ * below ceiling (both clipped to the tree's [low, high)). Returns true and
+ * stores the address in *out, or false if no such gap exists. */
+bool vm_itree_find_gap(const vm_itree_t* tree, uint64_t len,
+                       uint64_t floor, uint64_t ceiling, uint64_t* out);
+
+/* Walk the whole tree checking ordering, red-black and gap invariants.
+ * Returns true if consistent; intended for debug and tests. */
+bool vm_itree_validate(const vm_itree_t* tree);
+
+#endif /* VM_INTERVAL_TREE_H */
@@ -0,0 +1,79 @@
+/* IKOS Virtual Memory - Leaf page tables shared across fork
+ *
+ * Fork used to walk every mapped page, write-protect it in the parent, map it
+ * in the child and bump its frame's reference count, so its cost grew with
+ * the size of the address space. Here the child's PD entries instead point at
+ * the parent's leaf (PT-level) tables. Both PD entries are write-protected and
+ * tagged PAGE_PT_SHARED, and the reference count of the table's own frame
+ * (page_frame_t.ref_count) counts the spaces using it. Fork touches one PD
+ * entry per 2MB of mapped space and no PTEs at all.
+ *
+ * A space must own its table before changing anything under it. On the first
+ * write fault, mapping or unmapping below a shared entry, vm_pt_unshare():
+ *   - copies the table if others still use it. Every mapped frame gains a
+ *     reference, and its writable entries are write-protected in both the
+ *     copy and the original, so the frames fall back to the usual per-page
+ *     copy-on-write;
+ *   - or, for the last user, just takes the table back. Its entries are then
+ *     exactly as fork left them, or as a copier write-protected them.
+ * A space tearing down a whole 2MB span calls vm_pt_drop() instead, which
+ * releases its reference without copying anything.
+ *
+ * Huge (2MB) PD entries have no table below them; fork shares them directly,
+ * write-protected, with one reference per frame, as before.
+ *
+ * Pure: frames are reached through the caller's ops, so the kernel passes its
+ * frame database and the host test a simulated physical memory.
+ */
+
+#ifndef VM_PT_SHARE_H
+#define VM_PT_SHARE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "vmm.h"
+
+#define VM_PT_ENTRIES       512
+
+/* Result codes */
+#define VM_PT_OK            0
+#define VM_PT_ENOMEM        -1
+
+typedef struct vm_pt_share_stats {
+    uint64_t shared;                /* Leaf tables shared by fork */
+    uint64_t huge_shared;           /* Huge PD entries shared by fork */
+    uint64_t copied;                /* Shared tables copied on first change */
+    uint64_t reused;                /* Tables taken back by their last user */
+    uint64_t dropped;               /* References released without copying */
+} vm_pt_share_stats_t;
+
+typedef struct vm_pt_share {
+    pte_t* (*table)(uint64_t phys);             /* Kernel pointer to a table page */
+    uint32_t* (*ref_count)(uint64_t phys);      /* Reference count of a frame */
+    uint64_t (*alloc_table)(void);              /* Zeroed page, one reference; 0 if none */
+    vm_pt_share_stats_t stats;
+} vm_pt_share_t;
+
+/* Whether a PD entry points at a leaf table shared by fork. */
+static inline bool vm_pt_is_shared(pte_t pde) {
+    return (pde & (PAGE_PRESENT | PAGE_LARGE | PAGE_PT_SHARED)) ==
+           (PAGE_PRESENT | PAGE_PT_SHARED);
+}
+
+/* Share PD entries [first, last) of src_pd with dst_pd: leaf tables by
+ * reference, huge pages frame by frame. Entries already shared (a fork of a
+ * fork) just gain another reference. Returns the number of entries shared. */
+uint32_t vm_pt_share_fork(vm_pt_share_t* pt, pte_t* src_pd, pte_t* dst_pd,
+                          uint32_t first, uint32_t last);
+
+/* Give the space owning `pde` a private, writable leaf table. No-op unless
+ * the entry is shared. The caller flushes the 2MB span from the TLB. */
+int vm_pt_unshare(vm_pt_share_t* pt, pte_t* pde);
+
+/* Release a shared leaf table that the caller is about to unmap whole.
+ * Returns true if other spaces still use it: the reference is gone and the
+ * entry cleared, nothing more to do. Returns false if the caller owns the
+ * table (it is made private) and must unmap its pages as usual. */
+bool vm_pt_drop(vm_pt_share_t* pt, pte_t* pde);
+
+#endif /* VM_PT_SHARE_H */
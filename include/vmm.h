@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "vm_interval_tree.h"
 
 /* Page size and alignment */
 #define PAGE_SIZE           4096
@@ -14,6 +15,10 @@
 #define PAGE_FRAME(addr)    ((addr) >> 12)
 #define FRAME_ADDR(frame)   ((frame) << 12)
 
+/* Huge (2MB) pages, mapped by a PD entry with PAGE_LARGE set */
+#define HUGE_PAGE_SIZE      0x200000ULL
+#define HUGE_PAGE_FRAMES    (HUGE_PAGE_SIZE / PAGE_SIZE)
+
 /* Virtual memory layout */
 #define KERNEL_VIRTUAL_BASE     0xFFFFFFFF80000000ULL  /* -2GB */
 #define USER_VIRTUAL_BASE       0x0000000000400000ULL  /* 4MB */
@@ -39,6 +44,7 @@
 #define PAGE_GLOBAL         0x100   /* Global page (not flushed on CR3 reload) */
 /* Bits 9-11 are available for software use and ignored by the CPU. */
 #define PAGE_SNAPSHOT_COW   0x200   /* Page is copy-on-write for a checkpoint snapshot (issue #111) */
+#define PAGE_PT_SHARED      0x400   /* PD entry: leaf table shared by fork, write-protected until first write */
 #define PAGE_NX             0x8000000000000000ULL /* No-execute bit */
 #define PAGE_NO_EXECUTE     0x8000000000000000ULL /* NX bit */
 
@@ -51,6 +57,7 @@
 #define VMM_FLAG_COW        0x20    /* Copy-on-write */
 #define VMM_FLAG_LAZY       0x40    /* Lazy allocation */
 #define VMM_FLAG_LOCKED     0x80    /* Memory locked (no swap) */
+#define VMM_FLAG_HUGE       0x100   /* Back aligned 2MB spans with huge pages */
 
 /* Memory protection flags */
 #define VMM_PROT_READ       0x1     /* Memory is readable */
@@ -91,16 +98,19 @@ typedef struct vm_region {
     uint32_t flags;                 /* Region flags */
     vmm_region_type_t type;         /* Region type */
     uint32_t file_offset;           /* Offset in backing file (if any) */
+    struct elf_image* image;        /* Shared executable image backing the pages (if any) */
     char name[32];                  /* Region name */
     struct vm_region* next;         /* Next region */
     struct vm_region* prev;         /* Previous region */
+    vm_itree_node_t tree_node;      /* Link in the space's region_tree */
 } vm_region_t;
 
 /* Virtual address space */
 typedef struct vm_space {
     uint64_t pml4_phys;             /* Physical address of PML4 table */
     pte_t* pml4_virt;               /* Virtual address of PML4 table */
-    vm_region_t* regions;           /* List of memory regions */
+    vm_region_t* regions;           /* List of memory regions (sorted by address) */
+    vm_itree_t region_tree;         /* Interval index over the same regions */
     uint64_t heap_start;            /* Heap start address */
     uint64_t heap_end;              /* Current heap end */
     uint64_t stack_start;           /* Stack start address */
@@ -136,6 +146,15 @@ typedef struct vmm_stats {
     uint64_t cow_faults;            /* Copy-on-write faults */
     uint64_t swap_pages;            /* Pages swapped out */
     uint64_t memory_usage;          /* Total memory usage */
+    uint64_t huge_pages;            /* 2MB mappings currently installed */
+    uint64_t huge_allocs;           /* 2MB frame runs handed out */
+    uint64_t huge_fallbacks;        /* Huge requests served with 4KB pages */
+    uint64_t huge_splits;           /* 2MB mappings split into 4KB PTEs */
+    uint64_t huge_cow_reuses;       /* COW faults resolved without splitting */
+    uint64_t pt_shared;             /* Leaf page tables shared by fork */
+    uint64_t pt_copied;             /* Shared tables copied on first write */
+    uint64_t pt_reused;             /* Shared tables taken back by their last user */
+    uint64_t pt_dropped;            /* Shared references released without copying */
 } vmm_stats_t;
 
 /* VMM initialization and management */
@@ -154,14 +173,30 @@ vm_region_t* vmm_create_region(vm_space_t* space, uint64_t start, uint64_t size,
 int vmm_destroy_region(vm_space_t* space, uint64_t start);
 vm_region_t* vmm_find_region(vm_space_t* space, uint64_t addr);
 int vmm_expand_region(vm_space_t* space, vm_region_t* region, uint64_t new_size);
+int vmm_set_region_bounds(vm_space_t* space, vm_region_t* region, uint64_t start, uint64_t end);
 int vmm_split_region(vm_space_t* space, uint64_t split_addr);
+int vmm_protect_region(vm_space_t* space, uint64_t addr, uint64_t size, uint32_t new_flags);
+int vmm_protect_pages(vm_space_t* space, uint64_t start, uint64_t end, uint32_t new_flags);
 
 /* Page allocation and mapping */
 uint64_t vmm_alloc_page(void);
 void vmm_free_page(uint64_t phys_addr);
 int vmm_map_page(vm_space_t* space, uint64_t virt_addr, uint64_t phys_addr, uint32_t flags);
 int vmm_unmap_page(vm_space_t* space, uint64_t virt_addr);
+int vmm_unmap_range(vm_space_t* space, uint64_t start, uint64_t end);
 uint64_t vmm_get_physical_addr(vm_space_t* space, uint64_t virt_addr);
+page_frame_t* vmm_get_frame(uint64_t phys_addr);
+uint32_t vmm_frame_ref_count(uint64_t phys_addr);
+
+/* Huge page support. A huge page is HUGE_PAGE_FRAMES physically contiguous,
+ * 2MB-aligned frames, each keeping its own reference count, so a split
+ * mapping needs no further accounting. vmm_get_page_table() with create set
+ * splits a huge mapping that sits above the requested level. */
+uint64_t vmm_alloc_huge_page(void);
+void vmm_free_huge_page(uint64_t phys_addr);
+int vmm_map_huge_page(vm_space_t* space, uint64_t virt_addr, uint64_t phys_addr, uint32_t flags);
+pte_t* vmm_get_huge_entry(vm_space_t* space, uint64_t virt_addr);
+int vmm_split_huge_page(vm_space_t* space, uint64_t virt_addr);
 
 /* Memory allocation functions */
 void* vmm_alloc_virtual(vm_space_t* space, uint64_t size, uint32_t flags);
@@ -182,6 +217,16 @@ void vmm_page_fault_handler(uint64_t fault_addr, uint64_t error_code);
 int vmm_mark_cow(vm_space_t* space, uint64_t start, uint64_t size);
 int vmm_handle_cow_fault(vm_space_t* space, uint64_t fault_addr);
 
+/* Fork shares leaf page tables instead of copying them: each PD entry of the
+ * child points at the parent's table, both write-protected and tagged
+ * PAGE_PT_SHARED, and the table's frame reference count says how many spaces
+ * use it. The first write or mapping change under a shared entry gives that
+ * space its own copy (see vm_pt_share.h), so fork costs one step per table
+ * rather than one per page. */
+int vmm_share_page_tables(vm_space_t* dest, vm_space_t* src);
+int vmm_unshare_page_table(vm_space_t* space, uint64_t virt_addr);
+vm_space_t* vmm_copy_address_space(vm_space_t* src_space, uint32_t new_pid);
+
 /* Process memory management */
 int vmm_setup_user_space(vm_space_t* space);
 int vmm_clone_address_space(vm_space_t* dest, vm_space_t* src);
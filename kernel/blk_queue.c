@@ -0,0 +1,413 @@
+/* IKOS Block Queue
+ * See include/blk_queue.h. Callers serialize access.
+ */
+
+#include "blk_queue.h"
+
+static void copy_bytes(void* dst, const void* src, size_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+    for (size_t i = 0; i < n; i++) {
+        d[i] = s[i];
+    }
+}
+
+static uint64_t queue_now(blk_queue_t* q) {
+    return q->ops.now ? q->ops.now(q->ops.ctx) : 0;
+}
+
+static uint32_t request_end(const blk_request_t* req) {
+    return req->sector + req->count;
+}
+
+/* ================================
+ * Latency histograms
+ * ================================ */
+
+static void record_latency(uint64_t* hist, uint64_t ticks) {
+    uint32_t bucket = 0;
+    while (ticks && bucket < BLK_LATENCY_BUCKETS - 1) {
+        ticks >>= 1;
+        bucket++;
+    }
+    hist[bucket]++;
+}
+
+/* ================================
+ * Device commands
+ * ================================ */
+
+static int lower_write(blk_queue_t* q, uint32_t sector, uint32_t count, const void* data,
+                       uint64_t since) {
+    fat_block_device_t* lower = q->lower;
+    int rc = lower->write_sectors(lower->private_data, sector, count, data);
+    record_latency(q->stats.write_latency, queue_now(q) - since);
+    q->stats.dispatched++;
+    q->position = sector + count;
+    if (rc != 0) {
+        q->stats.errors++;
+        return BLK_QUEUE_EIO;
+    }
+    return BLK_QUEUE_OK;
+}
+
+static void free_request(blk_queue_t* q, blk_request_t* req) {
+    q->ops.free(req->data);
+    q->ops.free(req);
+}
+
+/**
+ * The next request to dispatch: an expired one if there is one, otherwise
+ * the first at or past the head, wrapping to the lowest
+ */
+static blk_request_t* pick_request(blk_queue_t* q, uint64_t now, bool* expired) {
+    blk_request_t* oldest = q->head;
+    blk_request_t* ahead = NULL;
+    for (blk_request_t* req = q->head; req; req = req->next) {
+        if (req->queued_at < oldest->queued_at) {
+            oldest = req;
+        }
+        if (!ahead && req->sector >= q->position) {
+            ahead = req;
+        }
+    }
+
+    *expired = now - oldest->queued_at >= q->write_expire;
+    if (*expired) {
+        return oldest;
+    }
+    return ahead ? ahead : q->head;
+}
+
+static void unlink_request(blk_queue_t* q, blk_request_t* req) {
+    blk_request_t** link = &q->head;
+    while (*link != req) {
+        link = &(*link)->next;
+    }
+    *link = req->next;
+    q->depth--;
+}
+
+int blk_queue_run(blk_queue_t* q) {
+    if (!q || !q->lower) {
+        return BLK_QUEUE_EINVAL;
+    }
+
+    int result = BLK_QUEUE_OK;
+    while (q->head) {
+        bool expired;
+        blk_request_t* req = pick_request(q, queue_now(q), &expired);
+        unlink_request(q, req);
+        if (expired) {
+            q->stats.expired++;
+        }
+
+        /* A failed write is dropped; the error reaches whoever unplugs */
+        if (lower_write(q, req->sector, req->count, req->data, req->queued_at) != BLK_QUEUE_OK) {
+            result = BLK_QUEUE_EIO;
+            if (q->error == BLK_QUEUE_OK) {
+                q->error = BLK_QUEUE_EIO;
+            }
+        }
+        free_request(q, req);
+    }
+    return result;
+}
+
+/* ================================
+ * Queueing and merging
+ * ================================ */
+
+/* Give `req` room for `count` sectors starting `shift` sectors into a new
+ * buffer; the old contents move along */
+static int resize_request(blk_queue_t* q, blk_request_t* req, uint32_t count, uint32_t shift) {
+    uint32_t sector_size = q->dev.sector_size;
+    if (shift == 0 && count <= req->capacity) {
+        return BLK_QUEUE_OK;
+    }
+
+    /* Appends double the buffer so a request built one write at a time is
+     * copied a logarithmic number of times */
+    uint32_t capacity = req->capacity * 2;
+    if (capacity > q->max_sectors) {
+        capacity = q->max_sectors;
+    }
+    if (capacity < count) {
+        capacity = count;
+    }
+
+    uint8_t* data = (uint8_t*)q->ops.alloc((size_t)capacity * sector_size);
+    if (!data) {
+        return BLK_QUEUE_ENOMEM;
+    }
+    copy_bytes(data + (size_t)shift * sector_size, req->data, (size_t)req->count * sector_size);
+    q->ops.free(req->data);
+    req->data = data;
+    req->capacity = capacity;
+    return BLK_QUEUE_OK;
+}
+
+/* Append `count` sectors to `req` */
+static int append_request(blk_queue_t* q, blk_request_t* req, uint32_t count, const void* data,
+                          uint64_t queued_at) {
+    int rc = resize_request(q, req, req->count + count, 0);
+    if (rc != BLK_QUEUE_OK) {
+        return rc;
+    }
+    copy_bytes(req->data + (size_t)req->count * q->dev.sector_size, data,
+               (size_t)count * q->dev.sector_size);
+    req->count += count;
+    if (queued_at < req->queued_at) {
+        req->queued_at = queued_at;
+    }
+    return BLK_QUEUE_OK;
+}
+
+/**
+ * Queue sectors nothing queued covers yet, merging with a neighbour that
+ * ends where they start or starts where they end
+ */
+static int insert_range(blk_queue_t* q, uint32_t sector, uint32_t count, const uint8_t* data,
+                        uint64_t now) {
+    blk_request_t* prev = NULL;
+    blk_request_t* next = q->head;
+    while (next && next->sector < sector) {
+        prev = next;
+        next = next->next;
+    }
+
+    if (prev && request_end(prev) == sector && prev->count + count <= q->max_sectors) {
+        int rc = append_request(q, prev, count, data, now);
+        if (rc != BLK_QUEUE_OK) {
+            return rc;
+        }
+        q->stats.back_merges++;
+
+        /* The write may have closed the gap to the next request */
+        if (next && request_end(prev) == next->sector &&
+            prev->count + next->count <= q->max_sectors &&
+            append_request(q, prev, next->count, next->data, next->queued_at) == BLK_QUEUE_OK) {
+            prev->next = next->next;
+            q->depth--;
+            free_request(q, next);
+        }
+        return BLK_QUEUE_OK;
+    }
+
+    if (next && next->sector == sector + count && next->count + count <= q->max_sectors) {
+        int rc = resize_request(q, next, next->count + count, count);
+        if (rc != BLK_QUEUE_OK) {
+            return rc;
+        }
+        copy_bytes(next->data, data, (size_t)count * q->dev.sector_size);
+        next->sector = sector;
+        next->count += count;
+        q->stats.front_merges++;
+        return BLK_QUEUE_OK;
+    }
+
+    blk_request_t* req = (blk_request_t*)q->ops.alloc(sizeof(blk_request_t));
+    if (!req) {
+        return BLK_QUEUE_ENOMEM;
+    }
+    req->data = (uint8_t*)q->ops.alloc((size_t)count * q->dev.sector_size);
+    if (!req->data) {
+        q->ops.free(req);
+        return BLK_QUEUE_ENOMEM;
+    }
+    copy_bytes(req->data, data, (size_t)count * q->dev.sector_size);
+    req->sector = sector;
+    req->count = count;
+    req->capacity = count;
+    req->queued_at = now;
+    req->next = next;
+    if (prev) {
+        prev->next = req;
+    } else {
+        q->head = req;
+    }
+    q->depth++;
+    if (q->depth > q->stats.max_depth) {
+        q->stats.max_depth = q->depth;
+    }
+    return BLK_QUEUE_OK;
+}
+
+/**
+ * Queue a write: sectors already queued take the new data in place, the
+ * gaps between them are inserted
+ */
+static int queue_write(blk_queue_t* q, uint32_t sector, uint32_t count, const uint8_t* data) {
+    uint32_t sector_size = q->dev.sector_size;
+    uint32_t end = sector + count;
+    uint32_t cursor = sector;
+    uint64_t now = queue_now(q);
+    bool overwrote = false;
+
+    while (cursor < end) {
+        /* First queued request still ending past the cursor */
+        blk_request_t* req = q->head;
+        while (req && request_end(req) <= cursor) {
+            req = req->next;
+        }
+
+        if (req && req->sector <= cursor) {
+            uint32_t stop = request_end(req) < end ? request_end(req) : end;
+            copy_bytes(req->data + (size_t)(cursor - req->sector) * sector_size,
+                       data + (size_t)(cursor - sector) * sector_size,
+                       (size_t)(stop - cursor) * sector_size);
+            overwrote = true;
+            cursor = stop;
+            continue;
+        }
+
+        uint32_t stop = (req && req->sector < end) ? req->sector : end;
+        if (stop - cursor > q->max_sectors) {
+            stop = cursor + q->max_sectors;
+        }
+        int rc = insert_range(q, cursor, stop - cursor, data + (size_t)(cursor - sector) * sector_size,
+                              now);
+        if (rc != BLK_QUEUE_OK) {
+            return rc;
+        }
+        cursor = stop;
+    }
+
+    if (overwrote) {
+        q->stats.overwrites++;
+    }
+    return BLK_QUEUE_OK;
+}
+
+/* ================================
+ * The stacked device
+ * ================================ */
+
+static int queue_read_sectors(void* device, uint32_t sector, uint32_t count, void* buffer) {
+    blk_queue_t* q = (blk_queue_t*)device;
+    if (!q || !buffer || (uint64_t)sector + count > q->dev.total_sectors) {
+        return BLK_QUEUE_EIO;
+    }
+    q->stats.reads++;
+    q->stats.sectors_read += count;
+
+    uint64_t start = queue_now(q);
+    int rc = q->lower->read_sectors(q->lower->private_data, sector, count, buffer);
+    record_latency(q->stats.read_latency, queue_now(q) - start);
+    if (rc != 0) {
+        q->stats.errors++;
+        return BLK_QUEUE_EIO;
+    }
+
+    /* Queued writes are newer than the disk */
+    uint32_t sector_size = q->dev.sector_size;
+    uint32_t end = sector + count;
+    for (blk_request_t* req = q->head; req && req->sector < end; req = req->next) {
+        if (request_end(req) <= sector) {
+            continue;
+        }
+        uint32_t from = req->sector > sector ? req->sector : sector;
+        uint32_t to = request_end(req) < end ? request_end(req) : end;
+        copy_bytes((uint8_t*)buffer + (size_t)(from - sector) * sector_size,
+                   req->data + (size_t)(from - req->sector) * sector_size,
+                   (size_t)(to - from) * sector_size);
+    }
+    return BLK_QUEUE_OK;
+}
+
+static int queue_write_sectors(void* device, uint32_t sector, uint32_t count, const void* buffer) {
+    blk_queue_t* q = (blk_queue_t*)device;
+    if (!q || !buffer || (uint64_t)sector + count > q->dev.total_sectors) {
+        return BLK_QUEUE_EIO;
+    }
+    q->stats.writes++;
+    q->stats.sectors_written += count;
+
+    if (q->plugged && count > 0) {
+        if (queue_write(q, sector, count, (const uint8_t*)buffer) == BLK_QUEUE_OK) {
+            if (q->depth >= q->max_requests) {
+                blk_queue_run(q);
+            }
+            return BLK_QUEUE_OK;
+        }
+        /* Out of memory: whatever part was queued goes out first, so the
+         * write below is the last word on every sector */
+        blk_queue_run(q);
+    }
+    return lower_write(q, sector, count, buffer, queue_now(q));
+}
+
+static void queue_plug(void* device) {
+    blk_queue_plug((blk_queue_t*)device);
+}
+
+static int queue_unplug(void* device) {
+    return blk_queue_unplug((blk_queue_t*)device);
+}
+
+/* ================================
+ * Public interface
+ * ================================ */
+
+int blk_queue_init(blk_queue_t* q, fat_block_device_t* lower, const blk_queue_ops_t* ops) {
+    if (!q || !lower || !lower->read_sectors || !lower->write_sectors || !ops ||
+        !ops->alloc || !ops->free || lower->sector_size == 0) {
+        return BLK_QUEUE_EINVAL;
+    }
+
+    q->dev.read_sectors = queue_read_sectors;
+    q->dev.write_sectors = queue_write_sectors;
+    q->dev.sector_size = lower->sector_size;
+    q->dev.total_sectors = lower->total_sectors;
+    q->dev.private_data = q;
+    q->dev.plug = queue_plug;
+    q->dev.unplug = queue_unplug;
+    q->lower = lower;
+    q->ops = *ops;
+    q->head = NULL;
+    q->depth = 0;
+    q->plugged = 0;
+    q->position = 0;
+    q->max_sectors = BLK_QUEUE_MAX_SECTORS;
+    q->max_requests = BLK_QUEUE_MAX_REQUESTS;
+    q->write_expire = BLK_QUEUE_WRITE_EXPIRE;
+    q->error = BLK_QUEUE_OK;
+    q->stats = (blk_queue_stats_t){ 0 };
+    return BLK_QUEUE_OK;
+}
+
+int blk_queue_destroy(blk_queue_t* q) {
+    if (!q || !q->lower) {
+        return BLK_QUEUE_EINVAL;
+    }
+    int rc = blk_queue_run(q);
+    q->plugged = 0;
+    q->error = BLK_QUEUE_OK;
+    return rc;
+}
+
+void blk_queue_plug(blk_queue_t* q) {
+    if (q) {
+        q->plugged++;
+    }
+}
+
+int blk_queue_unplug(blk_queue_t* q) {
+    if (!q || q->plugged == 0) {
+        return BLK_QUEUE_OK;
+    }
+    if (--q->plugged > 0) {
+        return BLK_QUEUE_OK;
+    }
+
+    blk_queue_run(q);
+    int rc = q->error;
+    q->error = BLK_QUEUE_OK;
+    return rc;
+}
+
+void blk_queue_get_stats(const blk_queue_t* q, blk_queue_stats_t* stats) {
+    if (q && stats) {
+        *stats = q->stats;
+    }
+}
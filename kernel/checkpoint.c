@@ -7,6 +7,7 @@
 #include "checkpoint.h"
 #include "checkpoint_extstate.h"
 #include "checkpoint_barrier.h"
+#include "blk_queue.h"
 #include "process_manager.h"
 #include <stddef.h>
 
@@ -132,18 +133,42 @@ int checkpoint_mark_space(vm_space_t* space, uint64_t epoch) {
 
         for (uint64_t addr = region->start_addr; addr < region->end_addr;
              addr += PAGE_SIZE) {
-            pte_t* pte = vmm_get_page_table(space, addr, PT_LEVEL, false);
+            /* A 2MB mapping is marked through its PD entry as a whole and
+             * split on the first write (see checkpoint_handle_write_fault). */
+            uint64_t pages = 1;
+            pte_t* pte = vmm_get_page_table(space, addr, PD_LEVEL, false);
+            if (pte && (*pte & PAGE_PRESENT) && (*pte & PAGE_LARGE)) {
+                pages = (HUGE_PAGE_SIZE - (addr & (HUGE_PAGE_SIZE - 1))) / PAGE_SIZE;
+            } else {
+                pte = vmm_get_page_table(space, addr, PT_LEVEL, false);
+                /* Tagging a table fork still shares would protect the
+                 * sibling's pages too: take a private copy first */
+                if (pte && (*pte & PAGE_PRESENT) && (*pte & PAGE_WRITABLE) &&
+                    vmm_unshare_page_table(space, addr) == VMM_SUCCESS) {
+                    pte = vmm_get_page_table(space, addr, PT_LEVEL, false);
+                }
+            }
             if (!pte) {
                 continue; /* not mapped */
             }
-            if (checkpoint_mark_pte(pte)) {
+            /* A frame still shared copy-on-write is read-only already; the
+             * tag alone makes its first write go through the capture */
+            if (pages == 1 && (*pte & PAGE_PRESENT) &&
+                !(*pte & (PAGE_WRITABLE | PAGE_SNAPSHOT_COW)) &&
+                vmm_frame_ref_count(*pte & 0x000FFFFFFFFFF000ULL) > 1) {
+                *pte |= PAGE_SNAPSHOT_COW;
                 marked++;
+                continue;
+            }
+            if (checkpoint_mark_pte(pte)) {
+                marked += (int)pages;
                 /* Only the active address space has live TLB entries to
                  * invalidate; others are flushed on their next CR3 load. */
                 if (space == current) {
                     vmm_flush_tlb_page(addr);
                 }
             }
+            addr += (pages - 1) * PAGE_SIZE;
         }
     }
 
@@ -282,11 +307,28 @@ bool checkpoint_handle_write_fault(vm_space_t* space, uint64_t fault_addr) {
     }
     uint64_t page_addr = fault_addr & ~((uint64_t)PAGE_SIZE - 1);
 
-    pte_t* pte = vmm_get_page_table(space, page_addr, PT_LEVEL, false);
+    /* A marked 2MB mapping is split on its first write: the 4KB entries
+     * inherit the snapshot tag, so only the page written now is captured
+     * and the rest stay protected. */
+    pte_t* pde = vmm_get_page_table(space, page_addr, PD_LEVEL, false);
+    bool split = pde && (*pde & PAGE_PRESENT) && (*pde & PAGE_LARGE) &&
+                 (*pde & PAGE_SNAPSHOT_COW);
+
+    pte_t* pte = vmm_get_page_table(space, page_addr, PT_LEVEL, split);
     if (!pte || !(*pte & PAGE_PRESENT) || !(*pte & PAGE_SNAPSHOT_COW)) {
         return false; /* not a snapshot-COW fault */
     }
 
+    /* Resolving the tag rewrites the PTE; never in a table a sibling
+     * still shares since fork */
+    if (vmm_unshare_page_table(space, page_addr) != VMM_SUCCESS) {
+        return false;
+    }
+    pte = vmm_get_page_table(space, page_addr, PT_LEVEL, false);
+    if (!pte || !(*pte & PAGE_SNAPSHOT_COW)) {
+        return false;
+    }
+
     /* The faulting page is mapped at page_addr in the current address space,
      * so its current contents are readable there. */
     int rc = checkpoint_capture_page(space->owner_pid, page_addr,
@@ -295,17 +337,175 @@ bool checkpoint_handle_write_fault(vm_space_t* space, uint64_t fault_addr) {
         return false;
     }
 
+    /* A frame the unshare left with other users stays read-only, so the
+     * retried write takes the ordinary copy-on-write path */
+    if (vmm_frame_ref_count(*pte & 0x000FFFFFFFFFF000ULL) > 1) {
+        *pte &= ~(pte_t)PAGE_WRITABLE;
+    }
+
     vmm_flush_tlb_page(page_addr);
     return true;
 }
 
 /* ----- Writeback ----- */
 
+/* Read-only frames already persisted in this pass. A frame mapped by many
+ * processes (text shared by every instance of a binary) is written once;
+ * its other mappings are collected here and go out as CHECKPOINT_REC_ALIAS
+ * lists. Open addressing on the frame address. */
+#define RO_SET_INITIAL  256
+#define RO_ALIAS_NONE   0xFFFFFFFFu
+
+typedef struct {
+    uint64_t phys;                  /* 0: empty slot */
+    uint64_t virt_addr;             /* Mapping whose record holds the page */
+    uint32_t pid;
+    uint32_t first_alias;           /* Chain through ro_alias_t.next */
+    uint32_t last_alias;
+} ro_frame_t;
+
+typedef struct {
+    checkpoint_alias_t alias;
+    uint32_t next;
+} ro_alias_t;
+
+typedef struct {
+    ro_frame_t* slots;
+    uint32_t capacity;              /* Power of two */
+    uint32_t used;
+    ro_alias_t* aliases;
+    uint32_t alias_count;
+    uint32_t alias_capacity;
+} ro_frame_set_t;
+
+static bool ro_set_init(ro_frame_set_t* set) {
+    set->slots = (ro_frame_t*)kmalloc(RO_SET_INITIAL * sizeof(ro_frame_t));
+    if (!set->slots) {
+        return false;
+    }
+    memset(set->slots, 0, RO_SET_INITIAL * sizeof(ro_frame_t));
+    set->capacity = RO_SET_INITIAL;
+    set->used = 0;
+    set->aliases = 0;
+    set->alias_count = 0;
+    set->alias_capacity = 0;
+    return true;
+}
+
+static void ro_set_free(ro_frame_set_t* set) {
+    kfree(set->slots);
+    if (set->aliases) {
+        kfree(set->aliases);
+    }
+}
+
+static ro_frame_t* ro_set_slot(ro_frame_t* slots, uint32_t capacity, uint64_t phys) {
+    uint32_t i = (uint32_t)((phys >> 12) * 0x9E3779B1u) & (capacity - 1);
+    while (slots[i].phys && slots[i].phys != phys) {
+        i = (i + 1) & (capacity - 1);
+    }
+    return &slots[i];
+}
+
+static bool ro_set_grow(ro_frame_set_t* set) {
+    uint32_t capacity = set->capacity * 2;
+    ro_frame_t* slots = (ro_frame_t*)kmalloc(capacity * sizeof(ro_frame_t));
+    if (!slots) {
+        return false;
+    }
+    memset(slots, 0, capacity * sizeof(ro_frame_t));
+    for (uint32_t i = 0; i < set->capacity; i++) {
+        if (set->slots[i].phys) {
+            *ro_set_slot(slots, capacity, set->slots[i].phys) = set->slots[i];
+        }
+    }
+    kfree(set->slots);
+    set->slots = slots;
+    set->capacity = capacity;
+    return true;
+}
+
+static bool ro_set_add_alias(ro_frame_set_t* set, ro_frame_t* frame,
+                             uint32_t pid, uint64_t virt_addr) {
+    if (set->alias_count == set->alias_capacity) {
+        uint32_t capacity = set->alias_capacity ? set->alias_capacity * 2 : RO_SET_INITIAL;
+        ro_alias_t* aliases = (ro_alias_t*)kmalloc(capacity * sizeof(ro_alias_t));
+        if (!aliases) {
+            return false;
+        }
+        if (set->aliases) {
+            memcpy(aliases, set->aliases, set->alias_count * sizeof(ro_alias_t));
+            kfree(set->aliases);
+        }
+        set->aliases = aliases;
+        set->alias_capacity = capacity;
+    }
+
+    uint32_t index = set->alias_count++;
+    ro_alias_t* a = &set->aliases[index];
+    a->alias.pid = pid;
+    a->alias.reserved = 0;
+    a->alias.virt_addr = virt_addr;
+    a->next = RO_ALIAS_NONE;
+    if (frame->first_alias == RO_ALIAS_NONE) {
+        frame->first_alias = index;
+    } else {
+        set->aliases[frame->last_alias].next = index;
+    }
+    frame->last_alias = index;
+    return true;
+}
+
+/* True if the frame was already persisted and (pid, virt_addr) is now one of
+ * its aliases; false if the caller must write the page (first sighting, or
+ * no memory to track it). */
+static bool ro_set_seen(ro_frame_set_t* set, uint64_t phys, uint32_t pid, uint64_t virt_addr) {
+    if (set->used * 2 >= set->capacity && !ro_set_grow(set)) {
+        return false;
+    }
+
+    ro_frame_t* frame = ro_set_slot(set->slots, set->capacity, phys);
+    if (frame->phys) {
+        return ro_set_add_alias(set, frame, pid, virt_addr);
+    }
+
+    frame->phys = phys;
+    frame->pid = pid;
+    frame->virt_addr = virt_addr;
+    frame->first_alias = RO_ALIAS_NONE;
+    set->used++;
+    return false;
+}
+
+static int ro_set_flush(ro_frame_set_t* set, snapshot_writer_t* writer, uint8_t* buf) {
+    checkpoint_alias_page_t* page = (checkpoint_alias_page_t*)buf;
+
+    for (uint32_t i = 0; i < set->capacity; i++) {
+        ro_frame_t* frame = &set->slots[i];
+        uint32_t next = frame->phys ? frame->first_alias : RO_ALIAS_NONE;
+
+        while (next != RO_ALIAS_NONE) {
+            memset(buf, 0, PAGE_SIZE);
+            while (next != RO_ALIAS_NONE && page->count < CHECKPOINT_ALIAS_MAX) {
+                page->entries[page->count++] = set->aliases[next].alias;
+                next = set->aliases[next].next;
+            }
+            if (snapshot_writer_add_page(writer, frame->pid, frame->virt_addr,
+                                         CHECKPOINT_REC_READONLY | CHECKPOINT_REC_ALIAS,
+                                         buf) != SNAPSHOT_OK) {
+                return CHECKPOINT_ERR_IO;
+            }
+        }
+    }
+    return CHECKPOINT_OK;
+}
+
 /* Persist the pages of every live user space that are not already streamed via
  * a capture: clean (unmodified) writable pages, whose frames still hold the
  * checkpoint-time content, and read-only pages (e.g. code), which never change.
  * Read-only pages are tagged CHECKPOINT_REC_READONLY so restore re-maps them
- * without write permission. */
+ * without write permission; a read-only frame mapped by several processes is
+ * written once, its other mappings following as alias records. */
 static int writeback_clean_pages(snapshot_writer_t* writer) {
     uint32_t pids[PM_MAX_PROCESSES];
     uint32_t count = 0;
@@ -318,6 +518,10 @@ static int writeback_clean_pages(snapshot_writer_t* writer) {
         return CHECKPOINT_ERR_PARAM;
     }
 
+    /* Without memory to track shared frames, every mapping is written out */
+    ro_frame_set_t shared;
+    bool dedup = ro_set_init(&shared);
+
     for (uint32_t i = 0; i < count; i++) {
         process_t* proc = pm_get_process(pids[i]);
         if (!proc || !proc->address_space) {
@@ -331,7 +535,11 @@ static int writeback_clean_pages(snapshot_writer_t* writer) {
                  addr += PAGE_SIZE) {
                 pte_t* pte = vmm_get_page_table(space, addr, PT_LEVEL, false);
                 if (!pte) {
-                    continue; /* unmapped */
+                    /* Pages of a 2MB mapping share its PD entry's state. */
+                    pte = vmm_get_page_table(space, addr, PD_LEVEL, false);
+                    if (!pte || !(*pte & PAGE_LARGE)) {
+                        continue; /* unmapped */
+                    }
                 }
                 checkpoint_page_action_t action = checkpoint_page_action(writable, *pte);
                 if (action == CHECKPOINT_PAGE_SKIP) {
@@ -341,6 +549,10 @@ static int writeback_clean_pages(snapshot_writer_t* writer) {
                 if (!phys) {
                     continue;
                 }
+                if (action == CHECKPOINT_PAGE_PERSIST_RO && dedup &&
+                    ro_set_seen(&shared, phys, space->owner_pid, addr)) {
+                    continue;
+                }
                 /* Physical frames are directly addressable in the kernel, the
                  * same convention vmm.c uses to walk page tables. */
                 memcpy(buf, (const void*)phys, PAGE_SIZE);
@@ -348,6 +560,9 @@ static int writeback_clean_pages(snapshot_writer_t* writer) {
                                      ? CHECKPOINT_REC_READONLY : 0;
                 if (snapshot_writer_add_page(writer, space->owner_pid, addr, flags,
                                              buf) != SNAPSHOT_OK) {
+                    if (dedup) {
+                        ro_set_free(&shared);
+                    }
                     kfree(buf);
                     return CHECKPOINT_ERR_IO;
                 }
@@ -355,8 +570,13 @@ static int writeback_clean_pages(snapshot_writer_t* writer) {
         }
     }
 
+    int rc = CHECKPOINT_OK;
+    if (dedup) {
+        rc = ro_set_flush(&shared, writer, buf);
+        ro_set_free(&shared);
+    }
     kfree(buf);
-    return CHECKPOINT_OK;
+    return rc;
 }
 
 int checkpoint_stream_pages(snapshot_writer_t* writer) {
@@ -400,7 +620,14 @@ int checkpoint_writeback(snapshot_store_t* store) {
         return CHECKPOINT_ERR_IO;
     }
 
+    /* The records are written under a plug so the queue can merge and
+     * sort them; unplugging issues them all before the commit writes,
+     * which go out in order behind them */
+    blk_plug(store->dev);
     int rc = checkpoint_stream_pages(&writer);
+    if (blk_unplug(store->dev) != 0 && rc == CHECKPOINT_OK) {
+        rc = CHECKPOINT_ERR_IO;
+    }
     if (rc != CHECKPOINT_OK) {
         return rc;
     }
@@ -497,6 +724,38 @@ static checkpoint_restored_process_t* restore_entry_for(checkpoint_restore_ctx_t
     return e;
 }
 
+/* Page record: ensure the process has an address space, then map a fresh
+ * frame holding data at virt_addr. */
+static int restore_map_page(checkpoint_restored_process_t* e, uint64_t virt_addr,
+                            const void* data, uint32_t rec_flags) {
+    if (!e->space) {
+        e->space = vmm_create_address_space(e->pid);
+        if (!e->space) {
+            return CHECKPOINT_ERR_PARAM;
+        }
+    }
+
+    uint64_t phys = vmm_alloc_page();
+    if (!phys) {
+        return CHECKPOINT_ERR_PARAM;
+    }
+
+    /* Physical frames are directly addressable in the kernel (same convention
+     * vmm.c uses); load the checkpointed page contents into the new frame. */
+    memcpy((void*)phys, data, PAGE_SIZE);
+
+    /* Read-only pages (code) are re-mapped without write permission so they keep
+     * their original protection; writable pages get PAGE_WRITABLE. */
+    uint32_t page_flags = PAGE_PRESENT | PAGE_USER;
+    if (!(rec_flags & CHECKPOINT_REC_READONLY)) {
+        page_flags |= PAGE_WRITABLE;
+    }
+    if (vmm_map_page(e->space, virt_addr, phys, page_flags) != 0) {
+        return CHECKPOINT_ERR_PARAM;
+    }
+    return CHECKPOINT_OK;
+}
+
 static int checkpoint_restore_apply_kernel(void* ctx, const snapshot_page_record_t* rec) {
     checkpoint_restore_ctx_t* c = (checkpoint_restore_ctx_t*)ctx;
 
@@ -520,33 +779,32 @@ static int checkpoint_restore_apply_kernel(void* ctx, const snapshot_page_record
         return CHECKPOINT_OK;
     }
 
-    /* Page record: ensure the process has an address space, then map it. */
-    if (!e->space) {
-        e->space = vmm_create_address_space(rec->pid);
-        if (!e->space) {
+    /* Alias records: the page was persisted once under (rec->pid,
+     * rec->virt_addr); give every other mapping of it a copy. */
+    if (rec->flags & CHECKPOINT_REC_ALIAS) {
+        uint64_t src = e->space ? vmm_get_physical_addr(e->space, rec->virt_addr) : 0;
+        if (!src) {
+            return CHECKPOINT_ERR_PARAM; /* its page record did not come first */
+        }
+        const checkpoint_alias_page_t* page = (const checkpoint_alias_page_t*)rec->page_data;
+        if (page->count > CHECKPOINT_ALIAS_MAX) {
             return CHECKPOINT_ERR_PARAM;
         }
+        for (uint32_t i = 0; i < page->count; i++) {
+            checkpoint_restored_process_t* a = restore_entry_for(c, page->entries[i].pid);
+            if (!a) {
+                return CHECKPOINT_ERR_PARAM;
+            }
+            int rc = restore_map_page(a, page->entries[i].virt_addr, (const void*)src,
+                                      CHECKPOINT_REC_READONLY);
+            if (rc != CHECKPOINT_OK) {
+                return rc;
+            }
+        }
+        return CHECKPOINT_OK;
     }
 
-    uint64_t phys = vmm_alloc_page();
-    if (!phys) {
-        return CHECKPOINT_ERR_PARAM;
-    }
-
-    /* Physical frames are directly addressable in the kernel (same convention
-     * vmm.c uses); load the checkpointed page contents into the new frame. */
-    memcpy((void*)phys, rec->page_data, PAGE_SIZE);
-
-    /* Read-only pages (code) are re-mapped without write permission so they keep
-     * their original protection; writable pages get PAGE_WRITABLE. */
-    uint32_t page_flags = PAGE_PRESENT | PAGE_USER;
-    if (!(rec->flags & CHECKPOINT_REC_READONLY)) {
-        page_flags |= PAGE_WRITABLE;
-    }
-    if (vmm_map_page(e->space, rec->virt_addr, phys, page_flags) != 0) {
-        return CHECKPOINT_ERR_PARAM;
-    }
-    return CHECKPOINT_OK;
+    return restore_map_page(e, rec->virt_addr, rec->page_data, rec->flags);
 }
 
 /* Kernel registrar: put each reconstructed process into the process table with
@@ -1,20 +1,43 @@
 /* IKOS Orthogonal Persistence - IDE-backed checkpoint store (#130)
  *
  * See include/checkpoint_ide.h. Bridges fat_block_device_t sector I/O to the
- * IDE driver's ide_read_sectors/ide_write_sectors.
+ * IDE driver's request queue: each chunk is submitted (bus-master DMA where
+ * the controller has it, PIO otherwise) and waited for, since the block
+ * device interface is synchronous.
  */
 
 #include "checkpoint_ide.h"
-#include "ide_driver.h"   /* ide_device_t, ide_read_sectors/ide_write_sectors, IDE_SUCCESS */
+#include "ide_driver.h"   /* ide_device_t, ide_submit/ide_wait_request, IDE_SUCCESS */
+
+static int ide_bdev_transfer(checkpoint_ide_binding_t* b, bool write, uint32_t sector,
+                             uint32_t count, void* buffer) {
+    ide_device_t* ide = (ide_device_t*)b->ide;
+    uint8_t* p = (uint8_t*)buffer;
+    while (count > 0) {
+        uint32_t n = count < IDE_DMA_MAX_SECTORS ? count : IDE_DMA_MAX_SECTORS;
+        ide_dma_request_t req = { 0 };
+        req.drive = b->drive;
+        req.write = write;
+        req.count = (uint16_t)n;
+        req.lba = sector;
+        req.buffer = p;
+        if (ide_submit(ide, &req) != IDE_SUCCESS ||
+            ide_wait_request(ide, &req) != IDE_SUCCESS) {
+            return -1;
+        }
+        sector += n;
+        count -= n;
+        p += n * 512;
+    }
+    return 0;
+}
 
 static int ide_bdev_read(void* device, uint32_t sector, uint32_t count, void* buffer) {
     checkpoint_ide_binding_t* b = (checkpoint_ide_binding_t*)device;
     if (!b || !b->ide || !buffer) {
         return -1;
     }
-    int rc = ide_read_sectors((ide_device_t*)b->ide, b->drive,
-                              (uint64_t)sector, (uint16_t)count, buffer);
-    return rc == IDE_SUCCESS ? 0 : -1;
+    return ide_bdev_transfer(b, false, sector, count, buffer);
 }
 
 static int ide_bdev_write(void* device, uint32_t sector, uint32_t count, const void* buffer) {
@@ -22,9 +45,8 @@ static int ide_bdev_write(void* device, uint32_t sector, uint32_t count, const v
     if (!b || !b->ide || !buffer) {
         return -1;
     }
-    int rc = ide_write_sectors((ide_device_t*)b->ide, b->drive,
-                               (uint64_t)sector, (uint16_t)count, buffer);
-    return rc == IDE_SUCCESS ? 0 : -1;
+    /* A write request only reads the buffer */
+    return ide_bdev_transfer(b, true, sector, count, (void*)buffer);
 }
 
 fat_block_device_t* checkpoint_ide_bind(fat_block_device_t* bdev,
@@ -26,6 +26,8 @@ fat_block_device_t* checkpoint_ide_boot_bind(void) {
     }
     /* Best-effort IDENTIFY; presence is checked per drive below regardless. */
     ide_identify_drives(&g_ide);
+    /* Best-effort too: without a PCI bus master the store runs over PIO. */
+    ide_setup_dma(&g_ide);
 
     for (uint8_t drive = 0; drive < 2; drive++) {
         if (!ide_drive_present(&g_ide, drive)) {
@@ -4,6 +4,7 @@
 
 #include "../include/user_space_memory.h"
 #include "../include/memory_advanced.h"
+#include "../include/vmm.h"
 #include <string.h>
 
 /* COW page tracking */
@@ -14,98 +15,22 @@ static struct {
     uint64_t memory_saved;
 } cow_stats = {0};
 
-/* COW page structure for tracking shared pages */
-typedef struct cow_page {
-    struct page*           page;                 /* Physical page */
-    atomic_t               refcount;             /* Reference count */
-    uint64_t               original_addr;        /* Original virtual address */
-    uint32_t               flags;                /* COW flags */
-    struct cow_page*       next;                 /* Next in hash chain */
-} cow_page_t;
+extern void kernel_print(const char* format, ...);
 
-/* Simple hash table for COW page tracking */
-#define COW_HASH_SIZE 256
-static cow_page_t* cow_hash_table[COW_HASH_SIZE] = {0};
-static volatile int cow_hash_lock = 0;
-
-/* COW flags */
-#define COW_FLAG_SHARED        0x01              /* Page is shared */
-#define COW_FLAG_WRITTEN       0x02              /* Page has been written */
-#define COW_FLAG_READONLY      0x04              /* Page is read-only */
-
-/* ========================== COW Hash Table Management ========================== */
-
-static uint32_t cow_hash_function(struct page* page) {
-    uint64_t addr = (uint64_t)page;
-    return (addr >> 12) % COW_HASH_SIZE;
+/* Sharing is counted where the VMM already counts frame users: the
+ * reference count in page_frame_t. A struct page here is the page's
+ * address in the kernel mapping, as handed out by the page allocator. */
+static uint64_t cow_page_phys(struct page* page) {
+    return (uint64_t)page - KERNEL_VIRTUAL_BASE;
 }
 
-static cow_page_t* cow_find_page(struct page* page) {
-    uint32_t hash = cow_hash_function(page);
-    cow_page_t* cow_page;
-    
-    for (cow_page = cow_hash_table[hash]; cow_page; cow_page = cow_page->next) {
-        if (cow_page->page == page) {
-            return cow_page;
-        }
-    }
-    
-    return NULL;
-}
-
-static int cow_add_page(struct page* page, uint64_t addr) {
-    uint32_t hash = cow_hash_function(page);
-    cow_page_t* cow_page;
-    
-    /* Allocate COW page structure */
-    cow_page = kmalloc_new(sizeof(cow_page_t), GFP_KERNEL);
-    if (!cow_page) {
-        return -USMM_ENOMEM;
-    }
-    
-    /* Initialize COW page */
-    cow_page->page = page;
-    atomic_set(&cow_page->refcount, 1);
-    cow_page->original_addr = addr;
-    cow_page->flags = COW_FLAG_SHARED | COW_FLAG_READONLY;
-    
-    /* Add to hash table */
-    cow_page->next = cow_hash_table[hash];
-    cow_hash_table[hash] = cow_page;
-    
-    cow_stats.cow_pages_created++;
-    
-    return USMM_SUCCESS;
-}
-
-static void cow_remove_page(struct page* page) {
-    uint32_t hash = cow_hash_function(page);
-    cow_page_t* cow_page, *prev;
-    
-    prev = NULL;
-    for (cow_page = cow_hash_table[hash]; cow_page; cow_page = cow_page->next) {
-        if (cow_page->page == page) {
-            /* Remove from hash table */
-            if (prev) {
-                prev->next = cow_page->next;
-            } else {
-                cow_hash_table[hash] = cow_page->next;
-            }
-            
-            /* Free COW page structure */
-            kfree_new(cow_page);
-            return;
-        }
-        prev = cow_page;
-    }
+static page_frame_t* cow_frame(struct page* page) {
+    return vmm_get_frame(cow_page_phys(page));
 }
 
 /* ========================== COW Page Management ========================== */
 
 int setup_cow_mapping(vm_area_struct_t* vma) {
-    uint64_t addr;
-    struct page* page;
-    
     if (!vma) {
         return -USMM_EINVAL;
     }
@@ -118,56 +43,39 @@ int setup_cow_mapping(vm_area_struct_t* vma) {
     /* Mark VMA as COW */
     vma->vm_flags |= VM_DONTCOPY; /* Don't copy on fork by default */
     
-    /* For each page in the VMA, setup COW tracking */
-    for (addr = vma->vm_start; addr < vma->vm_end; addr += 4096) {
-        /* In real implementation, would get the physical page */
-        page = (struct page*)addr; /* Placeholder */
-        
-        if (page) {
-            cow_add_page(page, addr);
-        }
-    }
-    
+    /* Nothing per page: frames are write-protected and counted when the
+     * page tables stop being shared (vm_pt_share.h), or in cow_page_dup() */
     return USMM_SUCCESS;
 }
 
 void cow_page_dup(struct page* page) {
-    cow_page_t* cow_page;
+    page_frame_t* frame;
     
     if (!page) {
         return;
     }
     
-    cow_page = cow_find_page(page);
-    if (cow_page) {
-        atomic_inc(&cow_page->refcount);
+    frame = cow_frame(page);
+    if (frame) {
+        frame->ref_count++;
+        cow_stats.cow_pages_created++;
+        cow_stats.memory_saved += 4096;
     }
 }
 
 void cow_page_free(struct page* page) {
-    cow_page_t* cow_page;
-    
-    if (!page) {
+    if (!page || !cow_frame(page)) {
         return;
     }
     
-    cow_page = cow_find_page(page);
-    if (cow_page) {
-        if (atomic_dec_and_test(&cow_page->refcount)) {
-            /* Last reference - remove from tracking */
-            cow_remove_page(page);
-            
-            /* Free the actual page (in real implementation) */
-            /* buddy_free_pages(page, 0); */
-        }
-    }
+    /* Drops one reference; the last one returns the frame */
+    vmm_free_page(cow_page_phys(page));
 }
 
 int cow_page_fault(vm_area_struct_t* vma, uint64_t address) {
-    struct page* old_page, *new_page;
-    cow_page_t* cow_page;
-    uint64_t page_addr;
-    void* old_data, *new_data;
+    vm_space_t* space;
+    pte_t* pte;
+    uint64_t page_addr, old_phys;
     
     if (!vma) {
         return -USMM_EINVAL;
@@ -178,65 +86,33 @@ int cow_page_fault(vm_area_struct_t* vma, uint64_t address) {
         return -USMM_EACCES;
     }
     
-    page_addr = address & ~0xFFF;
-    
-    /* Get the current page */
-    old_page = (struct page*)page_addr; /* Placeholder - would look up in page table */
-    
-    if (!old_page) {
+    space = vmm_get_current_space();
+    if (!space) {
         return -USMM_EFAULT;
     }
     
-    /* Check if this page is shared */
-    cow_page = cow_find_page(old_page);
-    if (!cow_page) {
-        /* Not a COW page - regular page fault */
+    /* The frame comes from the faulting PTE; no PTE means no page to share */
+    page_addr = address & ~0xFFFULL;
+    pte = vmm_get_page_table(space, page_addr, PT_LEVEL, false);
+    if (!pte || !(*pte & PAGE_PRESENT) || !vmm_get_frame(*pte & 0x000FFFFFFFFFF000ULL)) {
         return -USMM_EFAULT;
     }
+    old_phys = *pte & 0x000FFFFFFFFFF000ULL;
     
-    /* Check if page is still shared */
-    if (atomic_read(&cow_page->refcount) == 1) {
-        /* Last reference - can write directly */
-        cow_page->flags &= ~COW_FLAG_READONLY;
-        cow_page->flags |= COW_FLAG_WRITTEN;
-        
-        /* Make page writable in page table */
-        /* set_page_writable(address); */
-        
-        return USMM_SUCCESS;
-    }
-    
-    /* Page is shared - need to copy */
-    
-    /* Allocate new page */
-    new_page = (struct page*)kmalloc_new(4096, GFP_KERNEL);
-    if (!new_page) {
+    /* The VMM copies the page, or just makes it writable for its last
+     * user, and unshares the leaf table first if fork still shares it */
+    if (vmm_handle_cow_fault(space, page_addr) != VMM_SUCCESS) {
         return -USMM_ENOMEM;
     }
     
-    /* Copy page contents */
-    old_data = (void*)old_page; /* Map old page */
-    new_data = (void*)new_page; /* Map new page */
-    memcpy(new_data, old_data, 4096);
-    
-    /* Update page table to point to new page */
-    /* update_page_table(address, new_page); */
-    
-    /* Decrease reference count on old page */
-    atomic_dec(&cow_page->refcount);
-    
-    /* Add new page to COW tracking */
-    cow_add_page(new_page, address);
-    cow_page = cow_find_page(new_page);
-    if (cow_page) {
-        cow_page->flags &= ~COW_FLAG_READONLY;
-        cow_page->flags |= COW_FLAG_WRITTEN;
-    }
-    
-    /* Update statistics */
     cow_stats.cow_faults_handled++;
-    cow_stats.cow_pages_copied++;
-    cow_stats.memory_saved += 4096; /* Saved memory until copy */
+    pte = vmm_get_page_table(space, page_addr, PT_LEVEL, false);
+    if (pte && (*pte & 0x000FFFFFFFFFF000ULL) != old_phys) {
+        cow_stats.cow_pages_copied++;
+        if (cow_stats.memory_saved >= 4096) {
+            cow_stats.memory_saved -= 4096;
+        }
+    }
     
     return USMM_SUCCESS;
 }
@@ -259,7 +135,9 @@ int copy_mm(struct process* child, struct process* parent) {
         return -USMM_ENOMEM;
     }
     
-    /* Set up COW for all writable private mappings */
+    /* Set up COW for all writable private mappings. This is VMA-level
+     * bookkeeping only; the pages themselves are shared through the leaf
+     * page tables when the VMM clones the address space. */
     for (vma = new_mm->mmap; vma; vma = vma->vm_next) {
         if ((vma->vm_flags & (VM_WRITE | VM_SHARED)) == VM_WRITE) {
             /* This is a writable private mapping - set up COW */
@@ -270,9 +148,6 @@ int copy_mm(struct process* child, struct process* parent) {
             if (new_vma) {
                 setup_cow_mapping(new_vma);
             }
-            
-            /* Mark pages as read-only in both processes */
-            /* mark_pages_readonly(vma->vm_start, vma->vm_end); */
         }
     }
     
@@ -284,9 +159,6 @@ int copy_mm(struct process* child, struct process* parent) {
 
 void exit_mm(struct process* task) {
     mm_struct_t* mm;
-    vm_area_struct_t* vma;
-    uint64_t addr;
-    struct page* page;
     
     if (!task || !task->mm) {
         return;
@@ -294,17 +166,9 @@ void exit_mm(struct process* task) {
     
     mm = task->mm;
     
-    /* Release COW references for all pages */
-    for (vma = mm->mmap; vma; vma = vma->vm_next) {
-        for (addr = vma->vm_start; addr < vma->vm_end; addr += 4096) {
-            /* Get the page at this address */
-            page = (struct page*)addr; /* Placeholder */
-            
-            if (page) {
-                cow_page_free(page);
-            }
-        }
-    }
+    /* Frame references go with the page tables when the VMM tears the
+     * space down: a shared table just loses one user, a private one
+     * returns its frames. Nothing is tracked per page here. */
     
     /* Free the address space */
     mm_free(mm);
@@ -424,34 +288,36 @@ void reset_cow_stats(void) {
 /* ========================== Debugging Support ========================== */
 
 void dump_cow_pages(void) {
-    cow_page_t* cow_page;
-    int i, total_pages = 0;
-    
-    for (i = 0; i < COW_HASH_SIZE; i++) {
-        for (cow_page = cow_hash_table[i]; cow_page; cow_page = cow_page->next) {
-            total_pages++;
-            /* In real implementation, would print page details */
+    vmm_stats_t* vmm = vmm_get_stats();
+    uint64_t shared_frames = 0, extra_refs = 0;
+    
+    /* A frame with more than one reference is mapped copy-on-write */
+    for (uint64_t i = 0; i < vmm->total_pages; i++) {
+        uint32_t refs = vmm_frame_ref_count(i * PAGE_SIZE);
+        if (refs > 1) {
+            shared_frames++;
+            extra_refs += refs - 1;
         }
     }
     
-    /* Print summary */
-    /* printf("Total COW pages: %d\n", total_pages); */
+    kernel_print("COW: %lu shared frames, %lu pages saved\n", shared_frames, extra_refs);
+    kernel_print("COW tables: %lu shared, %lu copied, %lu reused, %lu dropped\n",
+                 vmm->pt_shared, vmm->pt_copied, vmm->pt_reused, vmm->pt_dropped);
+    kernel_print("COW faults: %lu handled, %lu copied\n",
+                 cow_stats.cow_faults_handled, cow_stats.cow_pages_copied);
 }
 
 int validate_cow_consistency(void) {
-    cow_page_t* cow_page;
-    int i, errors = 0;
-    
-    for (i = 0; i < COW_HASH_SIZE; i++) {
-        for (cow_page = cow_hash_table[i]; cow_page; cow_page = cow_page->next) {
-            /* Validate COW page structure */
-            if (!cow_page->page) {
-                errors++;
-            }
-            if (atomic_read(&cow_page->refcount) <= 0) {
-                errors++;
-            }
-        }
+    vmm_stats_t* vmm = vmm_get_stats();
+    int errors = 0;
+    
+    /* Every shared table reference is released at most once, by a copy or
+     * a drop; the last user takes the table back without releasing one */
+    if (vmm->pt_copied + vmm->pt_dropped > vmm->pt_shared) {
+        errors++;
+    }
+    if (cow_stats.cow_pages_copied > cow_stats.cow_faults_handled) {
+        errors++;
     }
     
     return errors;
@@ -0,0 +1,267 @@
+/* IKOS Dentry Cache
+ * See include/dcache.h. Callers serialize access.
+ */
+
+#include "dcache.h"
+
+/* ================================
+ * LRU of unused entries
+ * ================================ */
+
+static void lru_append(dcache_t* cache, dcache_entry_t* entry) {
+    entry->lru_next = NULL;
+    entry->lru_prev = cache->lru_tail;
+    if (cache->lru_tail) {
+        cache->lru_tail->lru_next = entry;
+    } else {
+        cache->lru_head = entry;
+    }
+    cache->lru_tail = entry;
+    cache->nr_unused++;
+}
+
+static void lru_unlink(dcache_t* cache, dcache_entry_t* entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        cache->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        cache->lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+    cache->nr_unused--;
+}
+
+/* Hashed entries with no references are exactly the ones on the LRU */
+static bool on_lru(const dcache_entry_t* entry) {
+    return entry->hashed && entry->refs == 0;
+}
+
+/* Drop a reference without evicting anything */
+static void release_ref(dcache_t* cache, dcache_entry_t* entry) {
+    if (entry->refs == 0) {
+        return;
+    }
+    entry->refs--;
+    if (on_lru(entry)) {
+        lru_append(cache, entry);
+    }
+}
+
+/* ================================
+ * Hash table
+ * ================================ */
+
+static void unhash(dcache_t* cache, dcache_entry_t* entry) {
+    dcache_entry_t** link = &cache->buckets[entry->hash & cache->mask];
+    while (*link && *link != entry) {
+        link = &(*link)->hash_next;
+    }
+    if (*link) {
+        *link = entry->hash_next;
+    }
+    entry->hash_next = NULL;
+    entry->hashed = false;
+    cache->nr_entries--;
+}
+
+static bool name_equal(const char* a, const char* b, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int dcache_init(dcache_t* cache, const dcache_ops_t* ops, uint32_t buckets, uint32_t max_unused) {
+    if (!cache || !ops) {
+        return DCACHE_ENOMEM;
+    }
+
+    uint32_t n = 1;
+    while (n * 2 <= buckets) {
+        n *= 2;
+    }
+
+    cache->buckets = (dcache_entry_t**)ops->alloc(n * sizeof(dcache_entry_t*));
+    if (!cache->buckets) {
+        return DCACHE_ENOMEM;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        cache->buckets[i] = NULL;
+    }
+    cache->mask = n - 1;
+    cache->lru_head = NULL;
+    cache->lru_tail = NULL;
+    cache->nr_entries = 0;
+    cache->nr_unused = 0;
+    cache->max_unused = max_unused;
+    cache->ops = *ops;
+    cache->stats = (dcache_stats_t){ 0 };
+    return DCACHE_OK;
+}
+
+void dcache_destroy(dcache_t* cache) {
+    if (!cache || !cache->buckets) {
+        return;
+    }
+    cache->ops.free(cache->buckets);
+    cache->buckets = NULL;
+}
+
+/**
+ * FNV-1a over the name, seeded with the parent so equal names in different
+ * directories land in different chains
+ */
+uint32_t dcache_hash(const dcache_entry_t* parent, const char* name, uint32_t len) {
+    uintptr_t p = (uintptr_t)parent;
+    uint32_t hash = 2166136261u ^ (uint32_t)(p >> 4) ^ (uint32_t)((uint64_t)p >> 32);
+    for (uint32_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+    /* Fold the high bits down: the bucket index uses the low ones */
+    return hash ^ (hash >> 15);
+}
+
+void dcache_entry_init(dcache_entry_t* entry, const char* name, uint32_t len) {
+    if (!entry) {
+        return;
+    }
+    entry->hash_next = NULL;
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+    entry->parent = NULL;
+    entry->name = name;
+    entry->len = len;
+    entry->hash = 0;
+    entry->refs = 1;
+    entry->hashed = false;
+    entry->negative = false;
+}
+
+/* ================================
+ * Lookup and references
+ * ================================ */
+
+dcache_entry_t* dcache_lookup(dcache_t* cache, const dcache_entry_t* parent, const char* name,
+                              uint32_t len, uint32_t hash) {
+    if (!cache || !cache->buckets || !name) {
+        return NULL;
+    }
+    cache->stats.lookups++;
+
+    for (dcache_entry_t* entry = cache->buckets[hash & cache->mask]; entry;
+         entry = entry->hash_next) {
+        if (entry->hash == hash && entry->parent == parent && entry->len == len &&
+            name_equal(entry->name, name, len)) {
+            dcache_get(cache, entry);
+            cache->stats.hits++;
+            if (entry->negative) {
+                cache->stats.negative_hits++;
+            }
+            return entry;
+        }
+    }
+
+    cache->stats.misses++;
+    return NULL;
+}
+
+void dcache_add(dcache_t* cache, dcache_entry_t* parent, dcache_entry_t* entry, uint32_t hash,
+                bool negative) {
+    if (!cache || !cache->buckets || !entry || entry->hashed) {
+        return;
+    }
+
+    entry->parent = parent;
+    entry->hash = hash;
+    entry->negative = negative;
+    if (parent) {
+        dcache_get(cache, parent);
+    }
+
+    dcache_entry_t** bucket = &cache->buckets[hash & cache->mask];
+    entry->hash_next = *bucket;
+    *bucket = entry;
+    entry->hashed = true;
+    cache->nr_entries++;
+
+    if (entry->refs == 0) {
+        lru_append(cache, entry);
+    }
+}
+
+void dcache_get(dcache_t* cache, dcache_entry_t* entry) {
+    if (!cache || !entry) {
+        return;
+    }
+    if (on_lru(entry)) {
+        lru_unlink(cache, entry);
+    }
+    entry->refs++;
+}
+
+/**
+ * Evict the coldest unused entry; its parent may become unused in turn
+ */
+static void evict_one(dcache_t* cache) {
+    dcache_entry_t* entry = cache->lru_head;
+    lru_unlink(cache, entry);
+    unhash(cache, entry);
+
+    dcache_entry_t* parent = entry->parent;
+    entry->parent = NULL;
+    cache->stats.evictions++;
+    if (cache->ops.evict) {
+        cache->ops.evict(cache->ops.ctx, entry);
+    }
+
+    if (parent) {
+        release_ref(cache, parent);
+    }
+}
+
+void dcache_put(dcache_t* cache, dcache_entry_t* entry) {
+    if (!cache || !entry) {
+        return;
+    }
+    release_ref(cache, entry);
+
+    while (cache->nr_unused > cache->max_unused) {
+        evict_one(cache);
+    }
+}
+
+void dcache_remove(dcache_t* cache, dcache_entry_t* entry) {
+    if (!cache || !entry || !entry->hashed) {
+        return;
+    }
+    if (on_lru(entry)) {
+        lru_unlink(cache, entry);
+    }
+    unhash(cache, entry);
+
+    dcache_entry_t* parent = entry->parent;
+    entry->parent = NULL;
+    if (parent) {
+        release_ref(cache, parent);
+    }
+}
+
+uint32_t dcache_shrink(dcache_t* cache, uint32_t nr_entries) {
+    if (!cache) {
+        return 0;
+    }
+    uint32_t evicted = 0;
+    while (evicted < nr_entries && cache->lru_head) {
+        evict_one(cache);
+        evicted++;
+    }
+    return evicted;
+}
@@ -7,6 +7,9 @@
 #include "process.h"
 #include "checkpoint.h"
 #include "interrupts.h"
+#include "swap_device.h"
+#include "vfs.h"
+#include "vm_pt_share.h"
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -16,7 +19,6 @@
 #define SWAP_MAGIC              0xDEADBEEF  /* Swap file magic number */
 #define SWAP_MAX_FILES          8           /* Maximum swap files */
 #define SWAP_BLOCK_SIZE         4096        /* Swap block size (page size) */
-#define SWAP_BLOCKS_PER_FILE    (1024 * 1024) /* 4GB per swap file */
 
 /* Page fault error codes */
 #define PF_PROT                 0x01        /* Protection violation */
@@ -31,6 +33,23 @@
 #define SWAP_OFFSET_SHIFT       12
 #define SWAP_OFFSET_MASK        0xFFFFFFFFFULL /* 36 bits for offset */
 
+/* A swapped-out page's PTE holds its swap entry with the present bit clear;
+ * bit 1 marks it so that type 0, offset 0 is still distinguishable from an
+ * empty PTE. */
+#define SWAP_PTE_MARKER         0x2
+#define PAGE_FRAME_MASK         0x000FFFFFFFFFF000ULL
+
+/* LRU aging and reclaim batching */
+#define LRU_AGE_BATCH           32          /* Active pages aged per kswapd pass */
+#define LRU_VICTIM_SCAN         32          /* Max inactive pages checked per victim */
+#define RECLAIM_BATCH           32          /* Pages reclaimed per pressure round */
+#define INACTIVE_RATIO          2           /* Keep inactive >= active / ratio */
+
+/* Which replacement list a frame is on */
+#define LRU_NONE                0
+#define LRU_ACTIVE              1
+#define LRU_INACTIVE            2
+
 /* Page replacement algorithms */
 typedef enum {
     REPLACEMENT_LRU,        /* Least Recently Used */
@@ -41,14 +60,10 @@ typedef enum {
 
 /* ========================== Data Structures ========================== */
 
-/* Swap file descriptor */
+/* Swap area descriptor */
 typedef struct swap_file {
-    int                 fd;                 /* File descriptor */
-    char                path[256];          /* File path */
-    uint64_t            size;               /* File size in bytes */
-    uint32_t            pages;              /* Total pages in swap file */
-    uint32_t            free_pages;         /* Free pages available */
-    uint8_t*            bitmap;             /* Allocation bitmap */
+    char                path[256];          /* Name the area was enabled under */
+    swap_device_t       device;             /* Slots, write batch and readahead window */
     uint32_t            priority;           /* Swap priority */
     bool                active;             /* Is swap file active */
     volatile int        lock;               /* Swap file lock */
@@ -62,7 +77,8 @@ typedef struct page_frame {
     uint64_t            access_time;        /* Last access time */
     uint32_t            access_count;       /* Access counter */
     bool                dirty;              /* Has been modified */
-    bool                referenced;         /* Recently referenced */
+    bool                referenced;         /* Software reference hint */
+    uint8_t             lru;                /* LRU_NONE / LRU_ACTIVE / LRU_INACTIVE */
     struct page_frame*  next;               /* Next in replacement list */
     struct page_frame*  prev;               /* Previous in replacement list */
 } page_frame_t;
@@ -77,6 +93,11 @@ typedef struct paging_stats {
     uint64_t            pages_reclaimed;    /* Pages reclaimed */
     uint64_t            oom_kills;          /* Out of memory kills */
     uint64_t            thrashing_events;   /* Thrashing detection */
+    uint64_t            lru_scanned;        /* Frames whose accessed bit was harvested */
+    uint64_t            lru_activated;      /* Inactive frames promoted on reference */
+    uint64_t            lru_deactivated;    /* Active frames aged onto the inactive list */
+    uint64_t            zswap_stores;       /* Victims kept compressed instead of swapped */
+    uint64_t            zswap_loads;        /* Swap-ins served from the compressed tier */
 } paging_stats_t;
 
 /* ========================== Global State ========================== */
@@ -87,21 +108,29 @@ static replacement_algorithm_t replacement_algo = REPLACEMENT_LRU;
 static bool demand_paging_enabled = false;
 static volatile int paging_lock = 0;
 
-/* Page replacement lists */
+/* Page replacement lists: most recently used at the head, reclaim from the
+ * inactive tail. Both are doubly linked so every move is O(1). */
 static page_frame_t* active_list_head = NULL;
+static page_frame_t* active_list_tail = NULL;
 static page_frame_t* inactive_list_head = NULL;
+static page_frame_t* inactive_list_tail = NULL;
 static uint32_t active_pages = 0;
 static uint32_t inactive_pages = 0;
 
+/* Compressed tier in front of swap: pool id, or -1 when disabled */
+static int zswap_pool = -1;
+
 /* Statistics */
 static paging_stats_t paging_stats = {0};
 
 /* LRU clock for page replacement */
 static uint64_t global_clock = 0;
 
-/* Memory pressure thresholds */
-static uint32_t low_memory_threshold = 10;     /* % of free memory */
-static uint32_t high_memory_threshold = 5;     /* % of free memory */
+/* Free-memory watermarks (% of total pages). Below low, reclaim runs until
+ * free memory is back above high; below min, it reclaims in larger batches. */
+static uint32_t min_watermark_percent = 5;
+static uint32_t low_watermark_percent = 10;
+static uint32_t high_watermark_percent = 15;
 
 /* ========================== Helper Functions ========================== */
 
@@ -144,11 +173,24 @@ static void debug_print(const char* format, ...) {
 
 /* ========================== Swap Management ========================== */
 
+static inline pte_t swap_entry_to_pte(uint64_t swap_entry) {
+    return (swap_entry & ~(uint64_t)PAGE_PRESENT) | SWAP_PTE_MARKER;
+}
+
+/* Swap entry held by a non-present PTE, or 0 if it holds none */
+static inline uint64_t pte_to_swap_entry(pte_t pte) {
+    if ((pte & PAGE_PRESENT) || !(pte & SWAP_PTE_MARKER)) {
+        return 0;
+    }
+    return (pte & ~(uint64_t)SWAP_PTE_MARKER) | 1;
+}
+
 /**
- * Initialize a swap file
+ * Initialize a swap area on a block device region
  */
-static int init_swap_file(const char* path, uint32_t priority) {
-    if (!path || active_swap_files >= SWAP_MAX_FILES) {
+static int init_swap_file(const char* path, fat_block_device_t* dev,
+                          uint32_t first_sector, uint32_t pages, uint32_t priority) {
+    if (!path || !dev || active_swap_files >= SWAP_MAX_FILES) {
         return -1;
     }
     
@@ -167,32 +209,20 @@ static int init_swap_file(const char* path, uint32_t priority) {
     
     swap_file_t* swap = &swap_files[slot];
     
-    /* TODO: Open swap file with proper filesystem interface */
-    /* For now, simulate file operations */
-    swap->fd = slot + 100;  /* Dummy file descriptor */
+    if (swap_device_init(&swap->device, dev, first_sector, pages) != SWAP_OK) {
+        return -1;
+    }
+    
     strncpy(swap->path, path, sizeof(swap->path) - 1);
     swap->path[sizeof(swap->path) - 1] = '\0';
-    
-    swap->size = SWAP_BLOCKS_PER_FILE * SWAP_BLOCK_SIZE;
-    swap->pages = SWAP_BLOCKS_PER_FILE;
-    swap->free_pages = swap->pages;
     swap->priority = priority;
     swap->active = true;
     swap->lock = 0;
     
-    /* Allocate bitmap for tracking used blocks */
-    uint32_t bitmap_size = (swap->pages + 7) / 8;
-    swap->bitmap = (uint8_t*)kmalloc(bitmap_size, GFP_KERNEL);
-    if (!swap->bitmap) {
-        swap->active = false;
-        return -1;
-    }
-    
-    memset(swap->bitmap, 0, bitmap_size);
-    
     active_swap_files++;
     
-    debug_print("Paging: Initialized swap file %s with %u pages\n", path, swap->pages);
+    debug_print("Paging: Initialized swap area %s with %u pages at sector %u\n",
+                path, pages, first_sector);
     
     return slot;
 }
@@ -208,7 +238,7 @@ static uint64_t allocate_swap_slot(void) {
     
     for (int i = 0; i < SWAP_MAX_FILES; i++) {
         swap_file_t* swap = &swap_files[i];
-        if (swap->active && swap->free_pages > 0 && swap->priority >= highest_priority) {
+        if (swap->active && swap->device.free_pages > 0 && swap->priority >= highest_priority) {
             best_swap = swap;
             best_idx = i;
             highest_priority = swap->priority;
@@ -219,37 +249,17 @@ static uint64_t allocate_swap_slot(void) {
         return 0;  /* No swap space available */
     }
     
+    /* Slots come from per-device clusters, so successive reclaims land in
+     * adjacent slots and their writeout coalesces into one command. */
+    uint32_t page_idx;
     swap_file_lock(best_swap);
+    int rc = swap_slot_alloc(&best_swap->device, &page_idx);
+    swap_file_unlock(best_swap);
     
-    /* Find first free bit in bitmap */
-    uint32_t bitmap_size = (best_swap->pages + 7) / 8;
-    uint32_t page_idx = 0;
-    bool found = false;
-    
-    for (uint32_t byte_idx = 0; byte_idx < bitmap_size && !found; byte_idx++) {
-        if (best_swap->bitmap[byte_idx] != 0xFF) {
-            for (int bit = 0; bit < 8; bit++) {
-                if (!(best_swap->bitmap[byte_idx] & (1 << bit))) {
-                    page_idx = byte_idx * 8 + bit;
-                    if (page_idx < best_swap->pages) {
-                        best_swap->bitmap[byte_idx] |= (1 << bit);
-                        found = true;
-                        break;
-                    }
-                }
-            }
-        }
-    }
-    
-    if (!found) {
-        swap_file_unlock(best_swap);
+    if (rc != SWAP_OK) {
         return 0;
     }
     
-    best_swap->free_pages--;
-    
-    swap_file_unlock(best_swap);
-    
     /* Encode swap entry: type (5 bits) | offset (36 bits) */
     uint64_t swap_entry = ((uint64_t)best_idx << SWAP_TYPE_SHIFT) | 
                          ((uint64_t)page_idx << SWAP_OFFSET_SHIFT) | 1;
@@ -276,21 +286,19 @@ static void free_swap_slot(uint64_t swap_entry) {
     }
     
     swap_file_t* swap = &swap_files[swap_type];
-    if (!swap->active || page_idx >= swap->pages) {
+    if (!swap->active) {
         return;
     }
     
-    swap_file_lock(swap);
-    
-    /* Clear bit in bitmap */
-    uint32_t byte_idx = page_idx / 8;
-    uint32_t bit_idx = page_idx % 8;
-    
-    if (swap->bitmap[byte_idx] & (1 << bit_idx)) {
-        swap->bitmap[byte_idx] &= ~(1 << bit_idx);
-        swap->free_pages++;
+    /* Drop the compressed copy keyed by this slot first: this waits out a
+     * writeback still headed for the slot, which must land before the slot
+     * can be handed to another page */
+    if (zswap_pool >= 0) {
+        pool_invalidate_page(zswap_pool, swap_entry);
     }
     
+    swap_file_lock(swap);
+    swap_slot_free(&swap->device, page_idx);
     swap_file_unlock(swap);
     
     debug_print("Paging: Freed swap slot %lu\n", swap_entry);
@@ -312,14 +320,28 @@ static int swap_in_page(uint64_t swap_entry, struct page* page) {
     }
     
     swap_file_t* swap = &swap_files[swap_type];
-    if (!swap->active || page_idx >= swap->pages) {
+    if (!swap->active) {
         return -1;
     }
     
-    /* TODO: Implement actual disk I/O */
-    /* For now, simulate reading from swap */
-    void* page_data = (void*)page;
-    memset(page_data, 0, PAGE_SIZE);  /* Zero-fill for simulation */
+    /* Pages parked in the compressed tier never reached the disk */
+    if (zswap_pool >= 0 && pool_load_page(zswap_pool, swap_entry, (void*)page) == 0) {
+        paging_stats.swap_ins++;
+        paging_stats.zswap_loads++;
+        debug_print("Paging: Swapped in page from compressed tier (slot %lu)\n", swap_entry);
+        return 0;
+    }
+    
+    /* Served from the pending write batch or readahead window when possible;
+     * a miss reads the slot and its allocated neighbours in one command. */
+    swap_file_lock(swap);
+    int rc = swap_read_page(&swap->device, page_idx, (void*)page);
+    swap_file_unlock(swap);
+    
+    if (rc != SWAP_OK) {
+        debug_print("Paging: Swap-in from slot %lu failed (%d)\n", swap_entry, rc);
+        return -1;
+    }
     
     paging_stats.swap_ins++;
     
@@ -344,12 +366,21 @@ static int swap_out_page(struct page* page, uint64_t swap_entry) {
     }
     
     swap_file_t* swap = &swap_files[swap_type];
-    if (!swap->active || page_idx >= swap->pages) {
+    if (!swap->active) {
         return -1;
     }
     
-    /* TODO: Implement actual disk I/O */
-    /* For now, simulate writing to swap */
+    /* The page is copied into the device's write batch, so the frame can be
+     * reused as soon as this returns; the batch goes out as one multi-sector
+     * command when the run of adjacent slots breaks or swap_flush_all() runs. */
+    swap_file_lock(swap);
+    int rc = swap_write_page(&swap->device, page_idx, (const void*)page);
+    swap_file_unlock(swap);
+    
+    if (rc != SWAP_OK) {
+        debug_print("Paging: Swap-out to slot %lu failed (%d)\n", swap_entry, rc);
+        return -1;
+    }
     
     paging_stats.swap_outs++;
     
@@ -358,28 +389,134 @@ static int swap_out_page(struct page* page, uint64_t swap_entry) {
     return 0;
 }
 
+/**
+ * Writeback hook for the compressed tier: a cold entry goes to the swap slot
+ * that was reserved for it when it was stored.
+ */
+static int zswap_writeback(uint64_t key, const void* page, void* ctx) {
+    (void)ctx;
+    return swap_out_page((struct page*)page, key);
+}
+
+/**
+ * Push every device's pending write batch to disk
+ */
+static int swap_flush_all(void) {
+    int result = 0;
+    
+    for (int i = 0; i < SWAP_MAX_FILES; i++) {
+        swap_file_t* swap = &swap_files[i];
+        if (!swap->active) {
+            continue;
+        }
+        swap_file_lock(swap);
+        if (swap_flush(&swap->device) != SWAP_OK) {
+            result = -1;
+        }
+        swap_file_unlock(swap);
+    }
+    
+    return result;
+}
+
 /* ========================== Page Replacement ========================== */
 
 /**
- * Add page to replacement list
+ * Unlink a frame from whichever list it is on. Caller holds paging_lock.
  */
-static void add_to_replacement_list(page_frame_t* frame) {
-    if (!frame) {
+static void lru_unlink(page_frame_t* frame) {
+    page_frame_t** head;
+    page_frame_t** tail;
+    
+    if (frame->lru == LRU_ACTIVE) {
+        head = &active_list_head;
+        tail = &active_list_tail;
+        active_pages--;
+    } else if (frame->lru == LRU_INACTIVE) {
+        head = &inactive_list_head;
+        tail = &inactive_list_tail;
+        inactive_pages--;
+    } else {
         return;
     }
     
-    paging_global_lock();
+    if (frame->prev) {
+        frame->prev->next = frame->next;
+    } else {
+        *head = frame->next;
+    }
+    if (frame->next) {
+        frame->next->prev = frame->prev;
+    } else {
+        *tail = frame->prev;
+    }
+    
+    frame->next = NULL;
+    frame->prev = NULL;
+    frame->lru = LRU_NONE;
+}
+
+/**
+ * Push a frame onto the head of a list. Caller holds paging_lock.
+ */
+static void lru_add_head(page_frame_t* frame, uint8_t list) {
+    page_frame_t** head = (list == LRU_ACTIVE) ? &active_list_head : &inactive_list_head;
+    page_frame_t** tail = (list == LRU_ACTIVE) ? &active_list_tail : &inactive_list_tail;
     
-    /* Add to active list initially */
-    frame->next = active_list_head;
     frame->prev = NULL;
+    frame->next = *head;
+    if (*head) {
+        (*head)->prev = frame;
+    } else {
+        *tail = frame;
+    }
+    *head = frame;
+    frame->lru = list;
     
-    if (active_list_head) {
-        active_list_head->prev = frame;
+    if (list == LRU_ACTIVE) {
+        active_pages++;
+    } else {
+        inactive_pages++;
     }
+}
+
+/**
+ * Harvest and clear a frame's accessed state. Caller holds paging_lock.
+ *
+ * The hardware accessed bit is cleared without a TLB flush: a stale TLB entry
+ * only delays the next time the bit gets set, which is harmless for aging and
+ * avoids a shootdown per scanned page.
+ */
+static bool lru_test_and_clear_young(page_frame_t* frame) {
+    bool young = frame->referenced;
+    frame->referenced = false;
     
-    active_list_head = frame;
-    active_pages++;
+    vm_space_t* space = frame->process ? frame->process->address_space : NULL;
+    if (space) {
+        pte_t* pte = vmm_get_page_table(space, frame->virt_addr, PT_LEVEL, false);
+        if (pte && (*pte & PAGE_PRESENT) && (*pte & PAGE_ACCESSED)) {
+            *pte &= ~(pte_t)PAGE_ACCESSED;
+            young = true;
+        }
+    }
+    
+    paging_stats.lru_scanned++;
+    return young;
+}
+
+/**
+ * Add page to replacement list
+ */
+static void add_to_replacement_list(page_frame_t* frame) {
+    if (!frame) {
+        return;
+    }
+    
+    paging_global_lock();
+    
+    /* New pages start on the active list */
+    frame->lru = LRU_NONE;
+    lru_add_head(frame, LRU_ACTIVE);
     
     frame->access_time = get_current_time();
     frame->referenced = true;
@@ -396,27 +533,7 @@ static void remove_from_replacement_list(page_frame_t* frame) {
     }
     
     paging_global_lock();
-    
-    /* Remove from current list */
-    if (frame->prev) {
-        frame->prev->next = frame->next;
-    }
-    if (frame->next) {
-        frame->next->prev = frame->prev;
-    }
-    
-    /* Update head pointers */
-    if (active_list_head == frame) {
-        active_list_head = frame->next;
-        active_pages--;
-    } else if (inactive_list_head == frame) {
-        inactive_list_head = frame->next;
-        inactive_pages--;
-    }
-    
-    frame->next = NULL;
-    frame->prev = NULL;
-    
+    lru_unlink(frame);
     paging_global_unlock();
 }
 
@@ -430,64 +547,86 @@ static void deactivate_page(page_frame_t* frame) {
     
     paging_global_lock();
     
-    /* Remove from active list */
-    if (frame->prev) {
-        frame->prev->next = frame->next;
-    }
-    if (frame->next) {
-        frame->next->prev = frame->prev;
-    }
-    
-    if (active_list_head == frame) {
-        active_list_head = frame->next;
-    }
-    active_pages--;
+    lru_unlink(frame);
+    lru_add_head(frame, LRU_INACTIVE);
+    frame->referenced = false;
+    paging_stats.lru_deactivated++;
     
-    /* Add to inactive list */
-    frame->next = inactive_list_head;
-    frame->prev = NULL;
+    paging_global_unlock();
+}
+
+/**
+ * Age up to nr_scan pages off the active tail. Caller holds paging_lock.
+ *
+ * Referenced pages rotate back to the active head; the rest drop to the
+ * inactive head, where they get one more chance to be referenced before
+ * reaching the inactive tail.
+ */
+static uint32_t lru_age_active(uint32_t nr_scan) {
+    uint32_t deactivated = 0;
     
-    if (inactive_list_head) {
-        inactive_list_head->prev = frame;
+    for (uint32_t i = 0; i < nr_scan && active_list_tail; i++) {
+        page_frame_t* frame = active_list_tail;
+        bool young = lru_test_and_clear_young(frame);
+        
+        lru_unlink(frame);
+        if (young) {
+            lru_add_head(frame, LRU_ACTIVE);
+        } else {
+            lru_add_head(frame, LRU_INACTIVE);
+            paging_stats.lru_deactivated++;
+            deactivated++;
+        }
     }
     
-    inactive_list_head = frame;
-    inactive_pages++;
-    
-    frame->referenced = false;
-    
+    return deactivated;
+}
+
+/**
+ * Keep the inactive list large enough to supply victims. Called in batches
+ * from kswapd rather than on every reclaim.
+ */
+static void lru_balance(void) {
+    paging_global_lock();
+    if (inactive_pages * INACTIVE_RATIO < active_pages) {
+        lru_age_active(LRU_AGE_BATCH);
+    }
     paging_global_unlock();
 }
 
 /**
  * Select page for replacement using LRU algorithm
+ *
+ * Takes the inactive tail, promoting at most LRU_VICTIM_SCAN referenced pages
+ * on the way, so the cost is bounded regardless of how much memory is
+ * resident. If the inactive list runs dry one batch of active pages is aged.
  */
 static page_frame_t* select_lru_victim(void) {
     page_frame_t* victim = NULL;
-    uint64_t oldest_time = UINT64_MAX;
     
     paging_global_lock();
     
-    /* Check inactive list first */
-    page_frame_t* frame = inactive_list_head;
-    while (frame) {
-        if (frame->access_time < oldest_time) {
-            oldest_time = frame->access_time;
+    if (!inactive_list_tail) {
+        lru_age_active(LRU_AGE_BATCH);
+    }
+    
+    for (uint32_t scanned = 0; inactive_list_tail; scanned++) {
+        page_frame_t* frame = inactive_list_tail;
+        
+        if (scanned >= LRU_VICTIM_SCAN || !lru_test_and_clear_young(frame)) {
             victim = frame;
+            break;
         }
-        frame = frame->next;
+        
+        /* Referenced while inactive: give it another round on the active list */
+        lru_unlink(frame);
+        lru_add_head(frame, LRU_ACTIVE);
+        paging_stats.lru_activated++;
     }
     
-    /* If no inactive pages, check active list */
+    /* Everything was hot: fall back to the coldest active page */
     if (!victim) {
-        frame = active_list_head;
-        while (frame) {
-            if (frame->access_time < oldest_time) {
-                oldest_time = frame->access_time;
-                victim = frame;
-            }
-            frame = frame->next;
-        }
+        victim = active_list_tail;
     }
     
     paging_global_unlock();
@@ -548,7 +687,7 @@ static page_frame_t* select_replacement_victim(void) {
             return select_clock_victim();
         case REPLACEMENT_FIFO:
             /* Use oldest page in inactive list */
-            return inactive_list_head;
+            return inactive_list_tail;
         case REPLACEMENT_RANDOM:
             /* TODO: Implement random selection */
             return select_lru_victim();  /* Fallback to LRU */
@@ -559,6 +698,13 @@ static page_frame_t* select_replacement_victim(void) {
 
 /**
  * Reclaim a page for reuse
+ *
+ * The victim is unmapped from its owner before anything else: the PTE is
+ * cleared and flushed so no further write can land, then a dirty page is
+ * written out and the PTE refilled with its swap entry. A clean page was
+ * never written since it was zero-filled or swapped in, so dropping the
+ * mapping is enough. Frames that other spaces still map are rotated back
+ * to the active list instead.
  */
 static struct page* reclaim_page(void) {
     page_frame_t* victim = select_replacement_victim();
@@ -566,33 +712,65 @@ static struct page* reclaim_page(void) {
         return NULL;
     }
     
-    /* If page is dirty, write to swap */
-    if (victim->dirty) {
+    vm_space_t* space = victim->process ? victim->process->address_space : NULL;
+    uint64_t phys = (uint64_t)victim->page - KERNEL_VIRTUAL_BASE;
+    pte_t* pte = NULL;
+    
+    if (space) {
+        pte_t* pde = vmm_get_page_table(space, victim->virt_addr, PD_LEVEL, false);
+        if ((pde && vm_pt_is_shared(*pde)) || vmm_frame_ref_count(phys) > 1) {
+            paging_global_lock();
+            lru_unlink(victim);
+            lru_add_head(victim, LRU_ACTIVE);
+            paging_global_unlock();
+            return NULL;
+        }
+        pte = vmm_get_page_table(space, victim->virt_addr, PT_LEVEL, false);
+    }
+    
+    /* The owner already unmapped the page and will free it itself */
+    if (!pte || !(*pte & PAGE_PRESENT) || (*pte & PAGE_FRAME_MASK) != phys) {
+        remove_from_replacement_list(victim);
+        kfree(victim);
+        return NULL;
+    }
+    
+    pte_t old_pte = *pte;
+    *pte = 0;
+    vmm_flush_tlb_page(victim->virt_addr);
+    
+    if (victim->dirty || (old_pte & PAGE_DIRTY)) {
+        /* The slot is reserved even when the page only goes to the compressed
+         * tier, so a later writeback from the pool always has somewhere to go. */
         uint64_t swap_entry = allocate_swap_slot();
-        if (swap_entry) {
-            if (swap_out_page(victim->page, swap_entry) == 0) {
-                /* Update page table entry to point to swap */
-                /* TODO: Update page table with swap entry */
-            } else {
-                free_swap_slot(swap_entry);
-                return NULL;  /* Failed to swap out */
-            }
-        } else {
+        if (!swap_entry) {
+            *pte = old_pte;
             return NULL;  /* No swap space available */
         }
+        
+        if (zswap_pool >= 0 && pool_store_page(zswap_pool, swap_entry, victim->page) == 0) {
+            paging_stats.zswap_stores++;
+        } else if (swap_out_page(victim->page, swap_entry) != 0) {
+            free_swap_slot(swap_entry);
+            *pte = old_pte;
+            return NULL;  /* Failed to swap out */
+        }
+        
+        *pte = swap_entry_to_pte(swap_entry);
     }
     
     /* Remove from replacement list */
     remove_from_replacement_list(victim);
     
     /* Free page frame descriptor */
+    struct page* page = victim->page;
     kfree(victim);
     
     paging_stats.pages_reclaimed++;
     
-    debug_print("Paging: Reclaimed page %p\n", victim->page);
+    debug_print("Paging: Reclaimed page %p\n", page);
     
-    return victim->page;
+    return page;
 }
 
 /* ========================== Page Fault Handler ========================== */
@@ -628,16 +806,28 @@ static int handle_page_fault(uintptr_t fault_addr, uint32_t error_code, struct p
     
     /* Page not present - demand loading */
     if (!is_present) {
-        /* Check if page is swapped out */
-        /* TODO: Check page table for swap entry */
-        uint64_t swap_entry = 0;  /* Would get from page table */
+        vm_space_t* space = process->address_space;
+        uintptr_t page_addr = fault_addr & ~(PAGE_SIZE - 1);
+        vm_region_t* region = space ? vmm_find_region(space, page_addr) : NULL;
+        if (!region) {
+            return -1;  /* No region covers the address */
+        }
+        
+        uint32_t page_flags = PAGE_PRESENT;
+        if (region->flags & VMM_FLAG_WRITE) page_flags |= PAGE_WRITABLE;
+        if (region->flags & VMM_FLAG_USER) page_flags |= PAGE_USER;
         
+        /* A PTE left behind by reclaim_page() holds the page's swap entry */
+        pte_t* pte = vmm_get_page_table(space, page_addr, PT_LEVEL, false);
+        uint64_t swap_entry = pte ? pte_to_swap_entry(*pte) : 0;
+        
+        struct page* page;
         if (swap_entry) {
             /* Major fault - load from swap */
             paging_stats.major_faults++;
             
             /* Allocate physical page */
-            struct page* page = alloc_pages(GFP_KERNEL, 0);
+            page = alloc_pages(GFP_KERNEL, 0);
             if (!page) {
                 /* Try to reclaim a page */
                 page = reclaim_page();
@@ -653,30 +843,12 @@ static int handle_page_fault(uintptr_t fault_addr, uint32_t error_code, struct p
                 __free_pages(page, 0);
                 return -1;
             }
-            
-            /* Free swap slot */
-            free_swap_slot(swap_entry);
-            
-            /* Map page in page table */
-            /* TODO: Update page table mapping */
-            
-            /* Add to replacement tracking */
-            page_frame_t* frame = (page_frame_t*)kmalloc(sizeof(page_frame_t), GFP_KERNEL);
-            if (frame) {
-                frame->page = page;
-                frame->virt_addr = fault_addr & ~(PAGE_SIZE - 1);
-                frame->process = process;
-                frame->dirty = false;
-                frame->access_count = 1;
-                add_to_replacement_list(frame);
-            }
-            
         } else {
             /* Minor fault - allocate new page */
             paging_stats.minor_faults++;
             
             /* Allocate and zero page */
-            struct page* page = alloc_pages(GFP_KERNEL | GFP_ZERO, 0);
+            page = alloc_pages(GFP_KERNEL | GFP_ZERO, 0);
             if (!page) {
                 page = reclaim_page();
                 if (!page) {
@@ -685,20 +857,30 @@ static int handle_page_fault(uintptr_t fault_addr, uint32_t error_code, struct p
                 }
                 memset((void*)page, 0, PAGE_SIZE);
             }
-            
-            /* Map page in page table */
-            /* TODO: Update page table mapping */
-            
-            /* Add to replacement tracking */
-            page_frame_t* frame = (page_frame_t*)kmalloc(sizeof(page_frame_t), GFP_KERNEL);
-            if (frame) {
-                frame->page = page;
-                frame->virt_addr = fault_addr & ~(PAGE_SIZE - 1);
-                frame->process = process;
-                frame->dirty = false;
-                frame->access_count = 1;
-                add_to_replacement_list(frame);
-            }
+        }
+        
+        /* Map page in page table; the swap PTE is overwritten in place */
+        if (vmm_unshare_page_table(space, page_addr) != VMM_SUCCESS ||
+            vmm_map_page(space, page_addr, (uint64_t)page - KERNEL_VIRTUAL_BASE,
+                         page_flags) != VMM_SUCCESS) {
+            __free_pages(page, 0);
+            return -1;
+        }
+        
+        /* The slot is only released once nothing points at it */
+        if (swap_entry) {
+            free_swap_slot(swap_entry);
+        }
+        
+        /* Add to replacement tracking */
+        page_frame_t* frame = (page_frame_t*)kmalloc(sizeof(page_frame_t), GFP_KERNEL);
+        if (frame) {
+            frame->page = page;
+            frame->virt_addr = page_addr;
+            frame->process = process;
+            frame->dirty = false;
+            frame->access_count = 1;
+            add_to_replacement_list(frame);
         }
         
         return 0;
@@ -741,35 +923,49 @@ void page_fault_handler(registers_t* regs) {
 static void check_memory_pressure(void) {
     uint32_t free_pages = get_free_page_count();
     uint32_t total_pages = get_total_page_count();
-    uint32_t free_percent = (free_pages * 100) / total_pages;
+    if (total_pages == 0) {
+        return;
+    }
+    
+    uint32_t min_pages = (uint32_t)(((uint64_t)total_pages * min_watermark_percent) / 100);
+    uint32_t low_pages = (uint32_t)(((uint64_t)total_pages * low_watermark_percent) / 100);
+    uint32_t high_pages = (uint32_t)(((uint64_t)total_pages * high_watermark_percent) / 100);
+    
+    if (free_pages > low_pages) {
+        return;
+    }
+    
+    /* Below min, reclaim in double-size batches to catch up faster */
+    uint32_t batch = (free_pages <= min_pages) ? RECLAIM_BATCH * 2 : RECLAIM_BATCH;
+    uint32_t target = high_pages - free_pages;
+    
+    debug_print("Paging: %u free pages (low %u), reclaiming %u in batches of %u\n",
+                free_pages, low_pages, target, batch);
+    
+    /* File pages first: clean ones are dropped without any I/O */
+    uint32_t dropped = vfs_page_cache_shrink(target);
+    target = dropped < target ? target - dropped : 0;
     
-    if (free_percent <= high_memory_threshold) {
-        /* High memory pressure - aggressive reclaim */
-        debug_print("Paging: High memory pressure (%u%% free), starting aggressive reclaim\n", 
-                   free_percent);
+    while (target > 0) {
+        uint32_t round = target < batch ? target : batch;
+        uint32_t reclaimed = 0;
         
-        /* Reclaim multiple pages */
-        for (int i = 0; i < 16 && free_percent <= high_memory_threshold; i++) {
-            struct page* reclaimed = reclaim_page();
-            if (!reclaimed) {
+        for (uint32_t i = 0; i < round; i++) {
+            struct page* page = reclaim_page();
+            if (!page) {
                 break;
             }
-            free_pages++;
-            free_percent = (free_pages * 100) / total_pages;
+            __free_pages(page, 0);
+            reclaimed++;
         }
         
-    } else if (free_percent <= low_memory_threshold) {
-        /* Low memory pressure - gentle reclaim */
-        debug_print("Paging: Low memory pressure (%u%% free), starting gentle reclaim\n", 
-                   free_percent);
+        /* Victims were queued in adjacent slots; write them out together. */
+        swap_flush_all();
         
-        /* Reclaim a few pages */
-        for (int i = 0; i < 4; i++) {
-            struct page* reclaimed = reclaim_page();
-            if (!reclaimed) {
-                break;
-            }
+        if (reclaimed == 0) {
+            break;  /* Nothing reclaimable left */
         }
+        target -= reclaimed;
     }
 }
 
@@ -778,6 +974,8 @@ static void check_memory_pressure(void) {
  */
 void kswapd_thread(void) {
     while (demand_paging_enabled) {
+        /* Harvest accessed bits in one batch, then reclaim to the watermark */
+        lru_balance();
         check_memory_pressure();
         
         /* Sleep for a while */
@@ -804,7 +1002,9 @@ int demand_paging_init(void) {
     
     /* Initialize replacement lists */
     active_list_head = NULL;
+    active_list_tail = NULL;
     inactive_list_head = NULL;
+    inactive_list_tail = NULL;
     active_pages = 0;
     inactive_pages = 0;
     
@@ -843,14 +1043,14 @@ void demand_paging_shutdown(void) {
     debug_print("  Pages reclaimed: %lu\n", paging_stats.pages_reclaimed);
     debug_print("  OOM kills: %lu\n", paging_stats.oom_kills);
     
-    /* Clean up swap files */
+    /* Write the compressed tier back before its swap slots go away */
+    zswap_disable();
+    
+    /* Clean up swap areas (flushes any pending writeout) */
     for (int i = 0; i < SWAP_MAX_FILES; i++) {
         swap_file_t* swap = &swap_files[i];
         if (swap->active) {
-            if (swap->bitmap) {
-                kfree(swap->bitmap);
-            }
-            /* TODO: Close swap file */
+            swap_device_release(&swap->device);
             swap->active = false;
         }
     }
@@ -874,14 +1074,65 @@ void demand_paging_shutdown(void) {
 }
 
 /**
- * Enable swap file
+ * Enable swap on `pages` page-sized slots of dev starting at first_sector
  */
-int swapon(const char* path, uint32_t priority) {
-    if (!path || !demand_paging_enabled) {
+int swapon(const char* path, fat_block_device_t* dev, uint32_t first_sector,
+           uint32_t pages, uint32_t priority) {
+    if (!path || !dev || !demand_paging_enabled) {
+        return -1;
+    }
+    
+    return init_swap_file(path, dev, first_sector, pages, priority);
+}
+
+/**
+ * Put a compressed RAM tier in front of swap
+ *
+ * Reclaimed dirty pages are compressed into a pool of at most budget_bytes /
+ * max_pages instead of being written out; faults on them decompress from
+ * memory. When the pool is full its coldest entries are written back to their
+ * swap slots.
+ */
+int zswap_enable(size_t budget_bytes, uint32_t max_pages) {
+    if (!demand_paging_enabled || zswap_pool >= 0) {
+        return -1;
+    }
+    
+    int pool = create_compression_pool("zswap", COMPRESSION_LZ4, budget_bytes, max_pages);
+    if (pool < 0) {
         return -1;
     }
     
-    return init_swap_file(path, priority);
+    if (compression_pool_set_writeback(pool, zswap_writeback, NULL) != 0) {
+        destroy_compression_pool_by_id(pool);
+        return -1;
+    }
+    
+    zswap_pool = pool;
+    debug_print("Paging: Compressed tier enabled (%lu bytes, %u pages)\n",
+                budget_bytes, max_pages);
+    return 0;
+}
+
+/**
+ * Write every compressed page back to swap and remove the tier
+ */
+int zswap_disable(void) {
+    if (zswap_pool < 0) {
+        return 0;
+    }
+    
+    compression_pool_stats_t pool_stats;
+    if (get_compression_pool_stats(zswap_pool, &pool_stats) == 0 &&
+        compression_pool_shrink(zswap_pool, pool_stats.stored_pages) != pool_stats.stored_pages) {
+        swap_flush_all();
+        return -1;  /* Writeback failed; keep the tier so nothing is lost */
+    }
+    swap_flush_all();
+    
+    destroy_compression_pool_by_id(zswap_pool);
+    zswap_pool = -1;
+    return 0;
 }
 
 /**
@@ -900,9 +1151,7 @@ int swapoff(const char* path) {
             
             /* TODO: Move all pages from this swap file back to memory */
             
-            if (swap->bitmap) {
-                kfree(swap->bitmap);
-            }
+            swap_device_release(&swap->device);
             
             swap->active = false;
             active_swap_files--;
@@ -917,6 +1166,35 @@ int swapoff(const char* path) {
     return -1;  /* Swap file not found */
 }
 
+/* Paging statistics snapshot returned by get_paging_stats() */
+struct demand_paging_stats {
+    uint64_t page_faults;
+    uint64_t major_faults;
+    uint64_t minor_faults;
+    uint64_t swap_ins;
+    uint64_t swap_outs;
+    uint64_t pages_reclaimed;
+    uint32_t active_pages;
+    uint32_t inactive_pages;
+    uint32_t total_swap_pages;
+    uint32_t free_swap_pages;
+    uint64_t swap_write_commands;   /* Multi-sector writeout commands */
+    uint64_t swap_read_commands;    /* Multi-sector swap-in commands */
+    uint64_t swap_readahead_pages;  /* Neighbours read speculatively */
+    uint64_t swap_readahead_hits;   /* Swap-ins served without I/O */
+    uint64_t swap_cluster_allocs;   /* Slot clusters opened */
+    uint64_t swap_io_errors;        /* Failed device commands */
+    uint64_t lru_scanned;           /* Accessed bits harvested */
+    uint64_t lru_activated;         /* Inactive pages promoted on reference */
+    uint64_t lru_deactivated;       /* Active pages aged to inactive */
+    uint64_t zswap_stores;          /* Victims kept compressed in RAM */
+    uint64_t zswap_loads;           /* Swap-ins served from RAM */
+    uint64_t zswap_writebacks;      /* Cold compressed pages written to swap */
+    uint32_t zswap_stored_pages;    /* Pages resident in the compressed tier */
+    uint64_t zswap_pool_bytes;      /* Compressed bytes held */
+    uint32_t zswap_ratio;           /* Compressed size as % of original */
+};
+
 /**
  * Get paging statistics
  */
@@ -933,14 +1211,44 @@ void get_paging_stats(struct demand_paging_stats* stats) {
     stats->pages_reclaimed = paging_stats.pages_reclaimed;
     stats->active_pages = active_pages;
     stats->inactive_pages = inactive_pages;
+    stats->lru_scanned = paging_stats.lru_scanned;
+    stats->lru_activated = paging_stats.lru_activated;
+    stats->lru_deactivated = paging_stats.lru_deactivated;
+    stats->zswap_stores = paging_stats.zswap_stores;
+    stats->zswap_loads = paging_stats.zswap_loads;
+    stats->zswap_writebacks = 0;
+    stats->zswap_stored_pages = 0;
+    stats->zswap_pool_bytes = 0;
+    stats->zswap_ratio = 0;
+    
+    compression_pool_stats_t pool_stats;
+    if (zswap_pool >= 0 && get_compression_pool_stats(zswap_pool, &pool_stats) == 0) {
+        stats->zswap_writebacks = pool_stats.writebacks;
+        stats->zswap_stored_pages = pool_stats.stored_pages;
+        stats->zswap_pool_bytes = pool_stats.pool_bytes;
+        stats->zswap_ratio = pool_stats.compression_ratio;
+    }
     stats->total_swap_pages = 0;
     stats->free_swap_pages = 0;
-    
-    /* Calculate swap usage */
+    stats->swap_write_commands = 0;
+    stats->swap_read_commands = 0;
+    stats->swap_readahead_pages = 0;
+    stats->swap_readahead_hits = 0;
+    stats->swap_cluster_allocs = 0;
+    stats->swap_io_errors = 0;
+    
+    /* Calculate swap usage and I/O efficiency */
     for (int i = 0; i < SWAP_MAX_FILES; i++) {
+        const swap_device_t* dev = &swap_files[i].device;
         if (swap_files[i].active) {
-            stats->total_swap_pages += swap_files[i].pages;
-            stats->free_swap_pages += swap_files[i].free_pages;
+            stats->total_swap_pages += dev->pages;
+            stats->free_swap_pages += dev->free_pages;
+            stats->swap_write_commands += dev->stats.write_commands;
+            stats->swap_read_commands += dev->stats.read_commands;
+            stats->swap_readahead_pages += dev->stats.readahead_pages;
+            stats->swap_readahead_hits += dev->stats.readahead_hits + dev->stats.batch_hits;
+            stats->swap_cluster_allocs += dev->stats.cluster_allocs;
+            stats->swap_io_errors += dev->stats.io_errors;
         }
     }
 }
@@ -952,17 +1260,3 @@ void set_replacement_algorithm(replacement_algorithm_t algo) {
     replacement_algo = algo;
     debug_print("Paging: Set replacement algorithm to %d\n", algo);
 }
-
-/* Temporary stub for missing structure */
-struct demand_paging_stats {
-    uint64_t page_faults;
-    uint64_t major_faults;
-    uint64_t minor_faults;
-    uint64_t swap_ins;
-    uint64_t swap_outs;
-    uint64_t pages_reclaimed;
-    uint32_t active_pages;
-    uint32_t inactive_pages;
-    uint32_t total_swap_pages;
-    uint32_t free_swap_pages;
-};
@@ -0,0 +1,322 @@
+/* IKOS ELF Image Cache - executable pages shared across processes
+ *
+ * See include/elf_image_cache.h. Callers serialize access to the cache.
+ */
+
+#include "elf_image_cache.h"
+#include "elf.h"
+#include "vmm.h"
+
+#define FNV_OFFSET      0xCBF29CE484222325ULL
+#define FNV_PRIME       0x100000001B3ULL
+
+static void copy_bytes(void* dst, const void* src, size_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+    while (n--) {
+        *d++ = *s++;
+    }
+}
+
+static uint32_t key_bucket(const elf_image_key_t* key) {
+    uint64_t h = key->ino ^ (key->dev * FNV_PRIME) ^ key->size ^ (key->mtime << 17);
+    h ^= h >> 29;
+    return (uint32_t)(h % ELF_IMAGE_CACHE_BUCKETS);
+}
+
+static bool key_equal(const elf_image_key_t* a, const elf_image_key_t* b) {
+    return a->dev == b->dev && a->ino == b->ino &&
+           a->mtime == b->mtime && a->size == b->size;
+}
+
+/* ----- Idle list ----- */
+
+static void idle_unlink(elf_image_cache_t* cache, elf_image_t* image) {
+    if (image->idle_prev) {
+        image->idle_prev->idle_next = image->idle_next;
+    } else {
+        cache->idle_head = image->idle_next;
+    }
+    if (image->idle_next) {
+        image->idle_next->idle_prev = image->idle_prev;
+    } else {
+        cache->idle_tail = image->idle_prev;
+    }
+    image->idle_prev = image->idle_next = NULL;
+    cache->idle_count--;
+}
+
+static void idle_push(elf_image_cache_t* cache, elf_image_t* image) {
+    image->idle_prev = NULL;
+    image->idle_next = cache->idle_head;
+    if (cache->idle_head) {
+        cache->idle_head->idle_prev = image;
+    } else {
+        cache->idle_tail = image;
+    }
+    cache->idle_head = image;
+    cache->idle_count++;
+}
+
+/* ----- Image lifetime ----- */
+
+static void image_free(elf_image_cache_t* cache, elf_image_t* image) {
+    for (uint32_t s = 0; s < image->segment_count; s++) {
+        elf_image_segment_t* seg = &image->segments[s];
+        if (!seg->frames) {
+            continue;
+        }
+        for (uint32_t p = 0; p < seg->page_count; p++) {
+            if (seg->frames[p]) {
+                cache->ops.put_frame(seg->frames[p]);
+            }
+        }
+        cache->ops.free(seg->frames);
+    }
+    if (image->data) {
+        cache->ops.free(image->data);
+    }
+    cache->ops.free(image);
+}
+
+static void image_evict(elf_image_cache_t* cache, elf_image_t* image) {
+    idle_unlink(cache, image);
+
+    elf_image_t** link = &cache->buckets[key_bucket(&image->key)];
+    while (*link && *link != image) {
+        link = &(*link)->hash_next;
+    }
+    if (*link) {
+        *link = image->hash_next;
+    }
+
+    cache->image_count--;
+    cache->stats.evictions++;
+    image_free(cache, image);
+}
+
+/* Check the headers and record the PT_LOAD segments. Only what the loader
+ * itself needs is checked; elf_validate() stays the policy gate. */
+static int image_parse(elf_image_t* image, const void* data, size_t size) {
+    const elf64_header_t* hdr = (const elf64_header_t*)data;
+    if (size < sizeof(elf64_header_t) || !ELF_IS_VALID(hdr) || !ELF_IS_64BIT(hdr) ||
+        !ELF_IS_LITTLE_ENDIAN(hdr) || !ELF_IS_EXECUTABLE(hdr) || hdr->e_entry == 0) {
+        return ELF_IMAGE_ENOEXEC;
+    }
+    if (hdr->e_phnum == 0 || hdr->e_phentsize != sizeof(elf64_program_header_t) ||
+        hdr->e_phoff > size ||
+        (size - hdr->e_phoff) / sizeof(elf64_program_header_t) < hdr->e_phnum) {
+        return ELF_IMAGE_ENOEXEC;
+    }
+
+    const elf64_program_header_t* phdrs =
+        (const elf64_program_header_t*)((const uint8_t*)data + hdr->e_phoff);
+    image->entry = hdr->e_entry;
+    image->segment_count = 0;
+
+    for (uint32_t i = 0; i < hdr->e_phnum; i++) {
+        const elf64_program_header_t* ph = &phdrs[i];
+        if (ph->p_type != PT_LOAD || ph->p_memsz == 0) {
+            continue;
+        }
+        if (image->segment_count == ELF_IMAGE_MAX_SEGMENTS ||
+            ph->p_filesz > ph->p_memsz || ph->p_offset > size ||
+            ph->p_filesz > size - ph->p_offset ||
+            ph->p_vaddr + ph->p_memsz < ph->p_vaddr) {
+            return ELF_IMAGE_ENOEXEC;
+        }
+
+        elf_image_segment_t* seg = &image->segments[image->segment_count++];
+        seg->vaddr = ph->p_vaddr;
+        seg->offset = ph->p_offset;
+        seg->filesz = ph->p_filesz;
+        seg->memsz = ph->p_memsz;
+        seg->flags = ph->p_flags;
+        seg->page_start = ph->p_vaddr & ~((uint64_t)PAGE_SIZE - 1);
+        seg->page_count = (uint32_t)((PAGE_ALIGN(ph->p_vaddr + ph->p_memsz) - seg->page_start) /
+                                     PAGE_SIZE);
+        seg->frames = NULL;
+    }
+
+    return image->segment_count ? ELF_IMAGE_OK : ELF_IMAGE_ENOEXEC;
+}
+
+/* ----- API ----- */
+
+void elf_image_cache_init(elf_image_cache_t* cache, const elf_image_ops_t* ops) {
+    if (!cache || !ops) {
+        return;
+    }
+    cache->ops = *ops;
+    for (uint32_t i = 0; i < ELF_IMAGE_CACHE_BUCKETS; i++) {
+        cache->buckets[i] = NULL;
+    }
+    cache->idle_head = cache->idle_tail = NULL;
+    cache->idle_count = 0;
+    cache->image_count = 0;
+    cache->stats = (elf_image_stats_t){0};
+}
+
+void elf_image_key_from_data(elf_image_key_t* key, const void* data, size_t size) {
+    const uint8_t* p = (const uint8_t*)data;
+    uint64_t h = FNV_OFFSET;
+    for (size_t i = 0; i < size; i++) {
+        h = (h ^ p[i]) * FNV_PRIME;
+    }
+    key->dev = ELF_IMAGE_DEV_ANON;
+    key->ino = h;
+    key->mtime = 0;
+    key->size = size;
+}
+
+int elf_image_acquire(elf_image_cache_t* cache, const elf_image_key_t* key,
+                      const void* data, size_t size, elf_image_t** out) {
+    if (!cache || !key || !out) {
+        return ELF_IMAGE_EFAULT;
+    }
+
+    uint32_t bucket = key_bucket(key);
+    for (elf_image_t* image = cache->buckets[bucket]; image; image = image->hash_next) {
+        if (key_equal(&image->key, key)) {
+            if (image->users++ == 0) {
+                idle_unlink(cache, image);
+            }
+            cache->stats.hits++;
+            *out = image;
+            return ELF_IMAGE_OK;
+        }
+    }
+
+    if (!data) {
+        return ELF_IMAGE_EFAULT;
+    }
+
+    elf_image_t* image = (elf_image_t*)cache->ops.alloc(sizeof(elf_image_t));
+    if (!image) {
+        return ELF_IMAGE_ENOMEM;
+    }
+    *image = (elf_image_t){0};
+    image->key = *key;
+
+    int rc = image_parse(image, data, size);
+    if (rc != ELF_IMAGE_OK) {
+        image->segment_count = 0;
+        image_free(cache, image);
+        return rc;
+    }
+
+    image->data = cache->ops.alloc(size);
+    if (!image->data) {
+        image->segment_count = 0;
+        image_free(cache, image);
+        return ELF_IMAGE_ENOMEM;
+    }
+    copy_bytes(image->data, data, size);
+    image->size = size;
+
+    for (uint32_t s = 0; s < image->segment_count; s++) {
+        elf_image_segment_t* seg = &image->segments[s];
+        seg->frames = (uint64_t*)cache->ops.alloc(seg->page_count * sizeof(uint64_t));
+        if (!seg->frames) {
+            image_free(cache, image);
+            return ELF_IMAGE_ENOMEM;
+        }
+        for (uint32_t p = 0; p < seg->page_count; p++) {
+            seg->frames[p] = 0;
+        }
+    }
+
+    image->users = 1;
+    image->hash_next = cache->buckets[bucket];
+    cache->buckets[bucket] = image;
+    cache->image_count++;
+    cache->stats.misses++;
+    *out = image;
+    return ELF_IMAGE_OK;
+}
+
+void elf_image_retain(elf_image_t* image) {
+    if (image) {
+        image->users++;
+    }
+}
+
+void elf_image_release(elf_image_cache_t* cache, elf_image_t* image) {
+    if (!cache || !image || image->users == 0) {
+        return;
+    }
+    if (--image->users > 0) {
+        return;
+    }
+
+    idle_push(cache, image);
+    while (cache->idle_count > ELF_IMAGE_CACHE_MAX_IDLE) {
+        image_evict(cache, cache->idle_tail);
+    }
+}
+
+const elf_image_segment_t* elf_image_segment_at(const elf_image_t* image, uint64_t vaddr) {
+    if (!image) {
+        return NULL;
+    }
+    for (uint32_t s = 0; s < image->segment_count; s++) {
+        const elf_image_segment_t* seg = &image->segments[s];
+        if (vaddr >= seg->page_start &&
+            vaddr < seg->page_start + (uint64_t)seg->page_count * PAGE_SIZE) {
+            return seg;
+        }
+    }
+    return NULL;
+}
+
+int elf_image_page(elf_image_cache_t* cache, elf_image_t* image, uint64_t vaddr,
+                   uint64_t* phys) {
+    if (!cache || !phys) {
+        return ELF_IMAGE_EFAULT;
+    }
+
+    elf_image_segment_t* seg = (elf_image_segment_t*)elf_image_segment_at(image, vaddr);
+    if (!seg) {
+        return ELF_IMAGE_EFAULT;
+    }
+
+    uint64_t page = vaddr & ~((uint64_t)PAGE_SIZE - 1);
+    uint32_t index = (uint32_t)((page - seg->page_start) / PAGE_SIZE);
+
+    /* File bytes that land on this page: [lo, hi) in virtual addresses */
+    uint64_t lo = seg->vaddr > page ? seg->vaddr : page;
+    uint64_t file_end = seg->vaddr + seg->filesz;
+    uint64_t hi = file_end < page + PAGE_SIZE ? file_end : page + PAGE_SIZE;
+    if (lo >= hi) {
+        *phys = 0;          /* Pure .bss: an ordinary zero page */
+        return ELF_IMAGE_OK;
+    }
+
+    if (seg->frames[index]) {
+        cache->stats.page_shares++;
+    } else {
+        uint64_t frame = cache->ops.alloc_frame();
+        if (!frame) {
+            return ELF_IMAGE_ENOMEM;
+        }
+        uint8_t* dst = (uint8_t*)cache->ops.frame_ptr(frame);
+        copy_bytes(dst + (lo - page),
+                   (const uint8_t*)image->data + seg->offset + (lo - seg->vaddr),
+                   hi - lo);
+        seg->frames[index] = frame;
+        cache->stats.page_fills++;
+    }
+
+    cache->ops.get_frame(seg->frames[index]);
+    *phys = seg->frames[index];
+    return ELF_IMAGE_OK;
+}
+
+void elf_image_cache_shrink(elf_image_cache_t* cache) {
+    if (!cache) {
+        return;
+    }
+    while (cache->idle_tail) {
+        image_evict(cache, cache->idle_tail);
+    }
+}
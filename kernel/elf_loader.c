@@ -3,9 +3,12 @@
  */
 
 #include "elf.h"
+#include "elf_image_cache.h"
 #include "process.h"
 #include "vmm.h"
+#include "memory.h"
 #include <stdint.h>
+#include <string.h>
 
 /* Function declarations */
 static void debug_print(const char* format, ...);
@@ -202,6 +205,178 @@ int elf64_load_segment(const void* elf_data, const elf64_program_header_t* phdr,
     return 0;
 }
 
+/* ========================== Shared Images ========================== */
+
+/* Physical frames are directly addressable in the kernel, the same
+ * convention vmm.c uses to walk page tables. */
+static uint64_t image_alloc_frame(void) {
+    uint64_t phys = vmm_alloc_page();
+    if (phys) {
+        memset((void*)phys, 0, PAGE_SIZE);
+    }
+    return phys;
+}
+
+static void image_get_frame(uint64_t phys) {
+    page_frame_t* frame = vmm_get_frame(phys);
+    if (frame) {
+        frame->ref_count++;
+    }
+}
+
+static void* image_frame_ptr(uint64_t phys) {
+    return (void*)phys;
+}
+
+static const elf_image_ops_t image_ops = {
+    .alloc_frame = image_alloc_frame,
+    .get_frame = image_get_frame,
+    .put_frame = vmm_free_page,
+    .frame_ptr = image_frame_ptr,
+    .alloc = kmalloc,
+    .free = kfree,
+};
+
+static elf_image_cache_t image_cache;
+static bool image_cache_ready = false;
+
+static elf_image_cache_t* get_image_cache(void) {
+    if (!image_cache_ready) {
+        elf_image_cache_init(&image_cache, &image_ops);
+        image_cache_ready = true;
+    }
+    return &image_cache;
+}
+
+/**
+ * Map an executable into an address space without loading any page: each
+ * PT_LOAD segment becomes a region backed by the shared image
+ */
+int elf_map_image(vm_space_t* space, const elf_image_key_t* key,
+                  const void* elf_data, size_t size, uint64_t* entry_point) {
+    if (!space || !key || !entry_point) {
+        return -1;
+    }
+    
+    elf_image_t* image;
+    if (elf_image_acquire(get_image_cache(), key, elf_data, size, &image) != ELF_IMAGE_OK) {
+        debug_print("Failed to load ELF image\n");
+        return -1;
+    }
+    
+    uint32_t mapped = 0;
+    for (uint32_t i = 0; i < image->segment_count; i++) {
+        const elf_image_segment_t* seg = &image->segments[i];
+        
+        if (seg->page_start < USER_SPACE_START ||
+            seg->vaddr + seg->memsz > USER_SPACE_END) {
+            debug_print("ELF segment outside user space\n");
+            goto fail;
+        }
+        
+        /* Text maps the image's frames read-only; data maps them
+         * copy-on-write, so only the pages a process writes are its own */
+        uint32_t flags = VMM_FLAG_USER | VMM_FLAG_READ;
+        if (seg->flags & PF_W) {
+            flags |= VMM_FLAG_WRITE | VMM_FLAG_COW;
+        }
+        if (seg->flags & PF_X) {
+            flags |= VMM_FLAG_EXEC;
+        }
+        
+        vm_region_t* region = vmm_create_region(space, seg->page_start,
+                                                (uint64_t)seg->page_count * PAGE_SIZE, flags,
+                                                (seg->flags & PF_X) ? VMM_REGION_CODE : VMM_REGION_DATA,
+                                                (seg->flags & PF_X) ? "text" : "data");
+        if (!region) {
+            debug_print("Failed to create region for ELF segment\n");
+            goto fail;
+        }
+        
+        /* Every region holds its own use of the image */
+        if (mapped++ > 0) {
+            elf_image_retain(image);
+        }
+        region->image = image;
+        region->file_offset = (uint32_t)seg->offset;
+    }
+    
+    *entry_point = image->entry;
+    return 0;
+    
+fail:
+    /* Regions already created keep their use of the image and go with the
+     * address space; only an image no region took is dropped here */
+    if (mapped == 0) {
+        elf_image_release(get_image_cache(), image);
+    }
+    return -1;
+}
+
+/**
+ * Whether key names an image the cache holds, so the file need not be read
+ */
+int elf_image_cached(const elf_image_key_t* key) {
+    elf_image_t* image;
+    if (!key || elf_image_acquire(get_image_cache(), key, NULL, 0, &image) != ELF_IMAGE_OK) {
+        return 0;
+    }
+    elf_image_release(get_image_cache(), image);
+    return 1;
+}
+
+/**
+ * Resolve a not-present fault in an image-backed region
+ */
+int elf_image_fault(vm_space_t* space, vm_region_t* region, uint64_t fault_addr) {
+    if (!space || !region || !region->image) {
+        return VMM_ERROR_INVALID_ADDR;
+    }
+    
+    uint64_t page_addr = vmm_align_down(fault_addr, PAGE_SIZE);
+    uint64_t phys;
+    int rc = elf_image_page(get_image_cache(), region->image, page_addr, &phys);
+    if (rc == ELF_IMAGE_ENOMEM) {
+        return VMM_ERROR_NOMEM;
+    }
+    if (rc != ELF_IMAGE_OK) {
+        return VMM_ERROR_FAULT;
+    }
+    
+    uint32_t page_flags = PAGE_PRESENT | PAGE_USER;
+    if (!phys) {
+        /* Nothing from the file on this page: private zero page */
+        phys = image_alloc_frame();
+        if (!phys) {
+            return VMM_ERROR_NOMEM;
+        }
+        if (region->flags & VMM_FLAG_WRITE) {
+            page_flags |= PAGE_WRITABLE;
+        }
+    }
+    /* Shared frames stay read-only; a write to data takes the COW path */
+    
+    rc = vmm_map_page(space, page_addr, phys, page_flags);
+    if (rc != VMM_SUCCESS) {
+        vmm_free_page(phys);
+    }
+    return rc;
+}
+
+/**
+ * Another region uses the image (fork, region split)
+ */
+void elf_image_get(struct elf_image* image) {
+    elf_image_retain(image);
+}
+
+/**
+ * A region backed by the image is gone
+ */
+void elf_image_put(struct elf_image* image) {
+    elf_image_release(get_image_cache(), image);
+}
+
 /**
  * Create a simple ELF file for testing
  * This creates a minimal "Hello World" user program
@@ -43,9 +43,27 @@ static vfs_filesystem_t ext4_fs_type = {
 /* Forward declarations */
 static int ext2_read_superblock(ext2_fs_info_t* fs);
 static int ext2_read_group_descriptors(ext2_fs_info_t* fs);
+static int ext2_load_groups(ext2_fs_info_t* fs);
 static int ext2_validate_superblock(const ext2_superblock_t* sb);
 static uint64_t ext2_get_block_64(const ext2_group_desc_t* gd, uint32_t field);
 static void ext2_set_block_64(ext2_group_desc_t* gd, uint32_t field, uint64_t value);
+static ssize_t ext2_read_range(vfs_inode_t* inode, char* buffer, size_t count, uint64_t pos);
+static ssize_t ext2_write_range(vfs_inode_t* inode, const char* buffer, size_t count, uint64_t pos);
+static void ext2_blockmap_ops_init(ext2_blockmap_ops_t* ops, vfs_inode_t* inode);
+static int ext2_bmap(vfs_inode_t* inode, uint64_t file_block, uint32_t max_blocks, bool create,
+                     uint64_t* phys_block, uint32_t* run);
+static int ext2_readpage(void* host, uint64_t index, void* page);
+static int ext2_readpages(void* host, uint64_t index, uint32_t nr, void* buffer);
+static int ext2_writepage(void* host, uint64_t index, const void* page);
+static size_t ext2_write_limit(void* host, uint64_t pos, size_t len);
+
+/* Page cache hooks for regular files */
+static const page_cache_aops_t ext2_aops = {
+    .readpage = ext2_readpage,
+    .writepage = ext2_writepage,
+    .write_limit = ext2_write_limit,
+    .readpages = ext2_readpages,
+};
 
 /* ================================
  * Filesystem Initialization
@@ -97,7 +115,7 @@ int ext2_init(void) {
     ext2_file_ops.write = ext2_write;
     ext2_file_ops.fsync = NULL;     /* TODO: Implement */
     ext2_file_ops.open = NULL;      /* Default VFS handling */
-    ext2_file_ops.release = NULL;   /* Default VFS handling */
+    ext2_file_ops.release = ext2_release;
     ext2_file_ops.readdir = NULL;   /* Not used for files */
     ext2_file_ops.llseek = ext2_llseek;
     ext2_file_ops.mmap = NULL;      /* TODO: Implement */
@@ -198,6 +216,7 @@ vfs_superblock_t* ext2_mount(vfs_filesystem_t* fs, uint32_t flags,
     vfs_superblock_t* sb = (vfs_superblock_t*)kmalloc(sizeof(vfs_superblock_t));
     if (!sb) {
         printf("[EXT2] Failed to allocate VFS superblock\n");
+        ext2_groups_destroy(&fs_info->groups);
         if (fs_info->group_desc) {
             kfree(fs_info->group_desc);
         }
@@ -222,6 +241,7 @@ vfs_superblock_t* ext2_mount(vfs_filesystem_t* fs, uint32_t flags,
     vfs_inode_t* root_inode = ext2_alloc_inode(sb);
     if (!root_inode) {
         printf("[EXT2] Failed to create root inode\n");
+        ext2_groups_destroy(&fs_info->groups);
         if (fs_info->group_desc) {
             kfree(fs_info->group_desc);
         }
@@ -237,6 +257,7 @@ vfs_superblock_t* ext2_mount(vfs_filesystem_t* fs, uint32_t flags,
     if (result != EXT2_SUCCESS) {
         printf("[EXT2] Failed to read root inode\n");
         ext2_destroy_inode(root_inode);
+        ext2_groups_destroy(&fs_info->groups);
         if (fs_info->group_desc) {
             kfree(fs_info->group_desc);
         }
@@ -258,6 +279,7 @@ vfs_superblock_t* ext2_mount(vfs_filesystem_t* fs, uint32_t flags,
     if (!root_dentry) {
         printf("[EXT2] Failed to create root dentry\n");
         ext2_destroy_inode(root_inode);
+        ext2_groups_destroy(&fs_info->groups);
         if (fs_info->group_desc) {
             kfree(fs_info->group_desc);
         }
@@ -289,6 +311,10 @@ void ext2_kill_sb(vfs_superblock_t* sb) {
     
     ext2_fs_info_t* fs_info = (ext2_fs_info_t*)sb->s_fs_info;
     if (fs_info) {
+        /* Flush the allocation bitmaps and counts, then drop them */
+        ext2_sync_fs(sb);
+        ext2_groups_destroy(&fs_info->groups);
+        
         /* Free group descriptors */
         if (fs_info->group_desc) {
             kfree(fs_info->group_desc);
@@ -358,6 +384,14 @@ vfs_inode_t* ext2_alloc_inode(vfs_superblock_t* sb) {
     ext2_info->is_extent_based = false;
     ext2_info->extent_root = NULL;
     
+    /* i_block is 4-byte aligned within the packed inode, which starts the
+     * kmalloc'd info */
+    ext2_fs_info_t* fs_info = (ext2_fs_info_t*)sb->s_fs_info;
+    uint32_t* i_block = (uint32_t*)((uint8_t*)&ext2_info->raw_inode +
+                                    offsetof(ext2_inode_t, i_block));
+    ext2_blockmap_init(&ext2_info->block_map, i_block,
+                       fs_info ? fs_info->block_size : EXT2_MIN_BLOCK_SIZE);
+    
     inode->i_private = ext2_info;
     return inode;
 }
@@ -382,6 +416,15 @@ void ext2_destroy_inode(vfs_inode_t* inode) {
             kfree(ext2_info->extent_root);
         }
         
+        /* Free cached pointer blocks and unused preallocated blocks */
+        ext2_blockmap_ops_t ops;
+        ext2_blockmap_ops_init(&ops, inode);
+        ext2_blockmap_invalidate(&ext2_info->block_map, &ops);
+        ext2_fs_info_t* fs_info = (ext2_fs_info_t*)inode->i_sb->s_fs_info;
+        if (fs_info) {
+            ext2_groups_discard(&fs_info->groups, &ext2_info->prealloc);
+        }
+        
         kfree(ext2_info);
     }
     
@@ -430,6 +473,29 @@ int ext2_sync_fs(vfs_superblock_t* sb) {
         return EXT2_ERROR_INVALID;
     }
     
+    ext2_fs_info_t* fs_info = (ext2_fs_info_t*)sb->s_fs_info;
+    if (!fs_info) {
+        return EXT2_ERROR_INVALID;
+    }
+    
+    /* Dirty allocation bitmaps first, then the counts that describe them */
+    if (ext2_groups_sync(&fs_info->groups) != EXT2_GROUPS_OK) {
+        printf("[EXT2] Failed to write allocation bitmaps\n");
+        return EXT2_ERROR_IO;
+    }
+    for (uint32_t i = 0; fs_info->groups.groups && i < fs_info->groups_count; i++) {
+        ext2_group_t* group = &fs_info->groups.groups[i];
+        if (!group->counts_dirty) {
+            continue;
+        }
+        fs_info->group_desc[i].bg_free_blocks_count_lo = (uint16_t)group->free_blocks;
+        fs_info->group_desc[i].bg_free_inodes_count_lo = (uint16_t)group->free_inodes;
+        fs_info->group_desc[i].bg_used_dirs_count_lo = (uint16_t)group->used_dirs;
+        group->counts_dirty = false;
+    }
+    fs_info->superblock.s_free_blocks_count_lo = fs_info->groups.free_blocks;
+    fs_info->superblock.s_free_inodes_count = fs_info->groups.free_inodes;
+    
     /* Write superblock and group descriptors */
     return ext2_write_super(sb);
 }
@@ -471,6 +537,7 @@ int ext2_create(vfs_inode_t* dir, vfs_dentry_t* dentry, uint32_t mode, bool excl
     new_inode->i_fop = &ext2_file_ops;
     new_inode->i_size = 0;
     new_inode->i_nlink = 1;
+    vfs_inode_set_aops(new_inode, &ext2_aops);
     
     /* Set up ext2 inode info */
     ext2_inode_info_t* ext2_info = (ext2_inode_info_t*)new_inode->i_private;
@@ -555,6 +622,7 @@ vfs_dentry_t* ext2_lookup(vfs_inode_t* dir, vfs_dentry_t* dentry) {
         inode->i_mode = VFS_FILE_TYPE_REGULAR;
         inode->i_op = &ext2_file_inode_ops;
         inode->i_fop = &ext2_file_ops;
+        vfs_inode_set_aops(inode, &ext2_aops);
     }
     
     /* Set up ext2 inode info */
@@ -614,22 +682,130 @@ int ext2_getattr(vfs_dentry_t* dentry, vfs_stat_t* stat) {
  * Read from a file
  */
 ssize_t ext2_read(vfs_file_t* file, char* buffer, size_t count, uint64_t* pos) {
-    if (!file || !buffer || !pos) {
+    if (!file || !buffer || !pos || !file->f_inode) {
         return -1;
     }
     
-    vfs_inode_t* inode = file->f_inode;
-    if (!inode) {
+    ssize_t bytes_read = ext2_read_range(file->f_inode, buffer, count, *pos);
+    if (bytes_read > 0) {
+        *pos += bytes_read;
+    }
+    return bytes_read;
+}
+
+/**
+ * Write to a file
+ */
+ssize_t ext2_write(vfs_file_t* file, const char* buffer, size_t count, uint64_t* pos) {
+    if (!file || !buffer || !pos || !file->f_inode) {
         return -1;
     }
     
+    ssize_t bytes_written = ext2_write_range(file->f_inode, buffer, count, *pos);
+    if (bytes_written > 0) {
+        *pos += bytes_written;
+    }
+    return bytes_written;
+}
+
+/**
+ * Close a file: give back blocks preallocated for appends
+ */
+int ext2_release(vfs_inode_t* inode, vfs_file_t* file) {
+    (void)file;
+    if (!inode || !inode->i_private) {
+        return VFS_SUCCESS;
+    }
+    
+    ext2_fs_info_t* fs_info = (ext2_fs_info_t*)inode->i_sb->s_fs_info;
+    ext2_inode_info_t* ext2_info = (ext2_inode_info_t*)inode->i_private;
+    ext2_groups_discard(&fs_info->groups, &ext2_info->prealloc);
+    return VFS_SUCCESS;
+}
+
+/* Block map ops: pointer blocks and allocation go through the inode's
+ * filesystem; ctx is the VFS inode */
+static int ext2_blockmap_read(void* ctx, uint32_t block, void* buffer) {
+    vfs_inode_t* inode = (vfs_inode_t*)ctx;
+    return ext2_read_block((ext2_fs_info_t*)inode->i_sb->s_fs_info, block, buffer);
+}
+
+static int ext2_blockmap_write(void* ctx, uint32_t block, const void* buffer) {
+    vfs_inode_t* inode = (vfs_inode_t*)ctx;
+    return ext2_write_block((ext2_fs_info_t*)inode->i_sb->s_fs_info, block, buffer);
+}
+
+static uint32_t ext2_blockmap_alloc(void* ctx, uint32_t goal) {
+    vfs_inode_t* inode = (vfs_inode_t*)ctx;
+    ext2_fs_info_t* fs_info = (ext2_fs_info_t*)inode->i_sb->s_fs_info;
+    ext2_inode_info_t* ext2_info = (ext2_inode_info_t*)inode->i_private;
+    
+    /* A file's first block goes into the inode's own group */
+    if (goal == 0) {
+        goal = fs_info->superblock.s_first_data_block +
+               ext2_info->block_group * fs_info->blocks_per_group;
+    }
+    return ext2_groups_alloc_block(&fs_info->groups, &ext2_info->prealloc, goal);
+}
+
+static void ext2_blockmap_ops_init(ext2_blockmap_ops_t* ops, vfs_inode_t* inode) {
+    ops->read_block = ext2_blockmap_read;
+    ops->write_block = ext2_blockmap_write;
+    ops->alloc_block = ext2_blockmap_alloc;
+    ops->alloc = kmalloc;
+    ops->free = kfree;
+    ops->ctx = inode;
+}
+
+/**
+ * Map a file block: 1 mapped, 0 hole, or an EXT2_ERROR_* code. *run gets
+ * how many consecutive disk blocks start at *phys_block, at most max_blocks.
+ */
+static int ext2_bmap(vfs_inode_t* inode, uint64_t file_block, uint32_t max_blocks, bool create,
+                     uint64_t* phys_block, uint32_t* run) {
+    ext2_inode_info_t* ext2_info = (ext2_inode_info_t*)inode->i_private;
+    
+    *run = 1;
+    if (ext2_info->is_extent_based) {
+        int result = ext4_ext_get_blocks(inode, file_block, max_blocks, phys_block, create);
+        if (result > 0) {
+            *run = (uint32_t)result;
+        }
+        return (result > 0 && *phys_block != 0) ? 1 : 0;
+    }
+    
+    /* Direct and indirect pointers, through the per-inode cache */
+    ext2_blockmap_ops_t ops;
+    ext2_blockmap_ops_init(&ops, inode);
+    uint32_t disk_block;
+    int result = ext2_blockmap_map(&ext2_info->block_map, &ops, file_block, max_blocks, create,
+                                   &disk_block, run);
+    switch (result) {
+    case EXT2_BLOCKMAP_OK:
+        *phys_block = disk_block;
+        return disk_block != 0 ? 1 : 0;
+    case EXT2_BLOCKMAP_ENOSPC:
+        return EXT2_ERROR_NO_SPACE;
+    case EXT2_BLOCKMAP_ENOMEM:
+        return EXT2_ERROR_NO_MEMORY;
+    case EXT2_BLOCKMAP_EFBIG:
+        return EXT2_ERROR_INVALID;
+    default:
+        return EXT2_ERROR_IO;
+    }
+}
+
+/**
+ * Read file bytes [pos, pos + count) from disk
+ */
+static ssize_t ext2_read_range(vfs_inode_t* inode, char* buffer, size_t count, uint64_t pos) {
     /* Check bounds */
-    if (*pos >= inode->i_size) {
+    if (pos >= inode->i_size) {
         return 0;  /* EOF */
     }
     
-    if (*pos + count > inode->i_size) {
-        count = inode->i_size - *pos;
+    if (pos + count > inode->i_size) {
+        count = inode->i_size - pos;
     }
     
     ext2_fs_info_t* fs_info = (ext2_fs_info_t*)inode->i_sb->s_fs_info;
@@ -643,41 +819,40 @@ ssize_t ext2_read(vfs_file_t* file, char* buffer, size_t count, uint64_t* pos) {
     uint32_t block_size = fs_info->block_size;
     
     while (bytes_read < count) {
-        uint64_t file_block = (*pos + bytes_read) / block_size;
-        uint32_t block_offset = (*pos + bytes_read) % block_size;
+        uint64_t file_block = (pos + bytes_read) / block_size;
+        uint32_t block_offset = (pos + bytes_read) % block_size;
         uint32_t to_read = block_size - block_offset;
         
         if (to_read > count - bytes_read) {
             to_read = count - bytes_read;
         }
         
-        /* Get physical block number */
+        /* Get physical block number, and how many follow it on disk */
         uint64_t phys_block;
-        int result;
-        
-        if (ext2_info->is_extent_based) {
-            result = ext4_ext_get_blocks(inode, file_block, 1, &phys_block, false);
-        } else {
-            /* Use traditional block mapping */
-            if (file_block < 12) {
-                /* Direct blocks */
-                phys_block = ext2_info->raw_inode.i_block[file_block];
-            } else {
-                /* TODO: Implement indirect block handling */
-                printf("[EXT2] Indirect blocks not yet implemented\n");
-                break;
-            }
-            result = (phys_block != 0) ? 1 : 0;
+        uint32_t run;
+        uint32_t whole = (count - bytes_read) / block_size;
+        int mapped = ext2_bmap(inode, file_block, whole ? whole : 1, false, &phys_block, &run);
+        if (mapped < 0) {
+            break;
         }
         
-        if (result <= 0 || phys_block == 0) {
+        if (mapped == 0) {
             /* Sparse block - fill with zeros */
             memset(buffer + bytes_read, 0, to_read);
+        } else if (block_offset == 0 && whole > 0) {
+            /* Whole blocks: the contiguous run in one request */
+            if (run > whole) {
+                run = whole;
+            }
+            if (ext2_read_blocks(fs_info, phys_block, run, buffer + bytes_read) != EXT2_SUCCESS) {
+                break;
+            }
+            bytes_read += (size_t)run * block_size;
+            continue;
         } else {
             /* Read block from disk */
             uint8_t block_buffer[block_size];
-            result = ext2_read_block(fs_info, phys_block, block_buffer);
-            if (result != EXT2_SUCCESS) {
+            if (ext2_read_block(fs_info, phys_block, block_buffer) != EXT2_SUCCESS) {
                 break;
             }
             
@@ -688,23 +863,13 @@ ssize_t ext2_read(vfs_file_t* file, char* buffer, size_t count, uint64_t* pos) {
         bytes_read += to_read;
     }
     
-    *pos += bytes_read;
     return bytes_read;
 }
 
 /**
- * Write to a file
+ * Write file bytes [pos, pos + count) to disk, allocating blocks as needed
  */
-ssize_t ext2_write(vfs_file_t* file, const char* buffer, size_t count, uint64_t* pos) {
-    if (!file || !buffer || !pos) {
-        return -1;
-    }
-    
-    vfs_inode_t* inode = file->f_inode;
-    if (!inode) {
-        return -1;
-    }
-    
+static ssize_t ext2_write_range(vfs_inode_t* inode, const char* buffer, size_t count, uint64_t pos) {
     ext2_fs_info_t* fs_info = (ext2_fs_info_t*)inode->i_sb->s_fs_info;
     ext2_inode_info_t* ext2_info = (ext2_inode_info_t*)inode->i_private;
     
@@ -714,52 +879,34 @@ ssize_t ext2_write(vfs_file_t* file, const char* buffer, size_t count, uint64_t*
     
     size_t bytes_written = 0;
     uint32_t block_size = fs_info->block_size;
+    bool inode_dirty = false;
     
     while (bytes_written < count) {
-        uint64_t file_block = (*pos + bytes_written) / block_size;
-        uint32_t block_offset = (*pos + bytes_written) % block_size;
+        uint64_t file_block = (pos + bytes_written) / block_size;
+        uint32_t block_offset = (pos + bytes_written) % block_size;
         uint32_t to_write = block_size - block_offset;
         
         if (to_write > count - bytes_written) {
             to_write = count - bytes_written;
         }
         
-        /* Get physical block number */
+        /* Get physical block number, allocating it in a hole */
         uint64_t phys_block;
-        int result;
-        
-        if (ext2_info->is_extent_based) {
-            result = ext4_ext_get_blocks(inode, file_block, 1, &phys_block, true);
-        } else {
-            /* Use traditional block mapping */
-            if (file_block < 12) {
-                /* Direct blocks */
-                phys_block = ext2_info->raw_inode.i_block[file_block];
-                if (phys_block == 0) {
-                    /* Allocate new block */
-                    phys_block = ext2_alloc_block(fs_info, 0);
-                    if (phys_block == 0) {
-                        break;  /* No space */
-                    }
-                    ext2_info->raw_inode.i_block[file_block] = phys_block;
-                }
-                result = 1;
-            } else {
-                /* TODO: Implement indirect block handling */
-                printf("[EXT2] Indirect blocks not yet implemented\n");
-                break;
-            }
+        uint32_t run;
+        bool partial = block_offset != 0 || to_write != block_size;
+        int mapped = ext2_bmap(inode, file_block, 1, false, &phys_block, &run);
+        bool fresh = mapped == 0;
+        if (fresh) {
+            mapped = ext2_bmap(inode, file_block, 1, true, &phys_block, &run);
         }
-        
-        if (result <= 0 || phys_block == 0) {
-            break;  /* Failed to get block */
+        if (mapped <= 0) {
+            break;  /* No space, or the block cannot be mapped */
         }
         
-        /* Read existing block if partial write */
+        /* Read existing block if partial write; a new block starts zeroed */
         uint8_t block_buffer[block_size];
-        if (block_offset != 0 || to_write != block_size) {
-            result = ext2_read_block(fs_info, phys_block, block_buffer);
-            if (result != EXT2_SUCCESS) {
+        if (partial) {
+            if (fresh || ext2_read_block(fs_info, phys_block, block_buffer) != EXT2_SUCCESS) {
                 memset(block_buffer, 0, block_size);
             }
         }
@@ -768,27 +915,111 @@ ssize_t ext2_write(vfs_file_t* file, const char* buffer, size_t count, uint64_t*
         memcpy(block_buffer + block_offset, buffer + bytes_written, to_write);
         
         /* Write block back to disk */
-        result = ext2_write_block(fs_info, phys_block, block_buffer);
-        if (result != EXT2_SUCCESS) {
+        if (ext2_write_block(fs_info, phys_block, block_buffer) != EXT2_SUCCESS) {
             break;
         }
         
         bytes_written += to_write;
     }
     
-    /* Update file size if we extended it */
-    if (*pos + bytes_written > inode->i_size) {
-        inode->i_size = *pos + bytes_written;
+    /* New pointers in the inode itself */
+    if (ext2_info->block_map.i_block_dirty) {
+        ext2_info->block_map.i_block_dirty = false;
+        inode_dirty = true;
+    }
+    
+    /* Update file size if we extended it. The page cache grows i_size when
+     * the write is cached, so the on-disk size can lag it too. */
+    if (pos + bytes_written > inode->i_size) {
+        inode->i_size = pos + bytes_written;
+    }
+    if (ext2_info->raw_inode.i_size_lo != (uint32_t)inode->i_size) {
         ext2_info->raw_inode.i_size_lo = inode->i_size;
-        
-        /* Write updated inode to disk */
+        inode_dirty = true;
+    }
+    
+    /* Write updated inode to disk */
+    if (inode_dirty) {
         ext2_write_inode(fs_info, inode->i_ino, &ext2_info->raw_inode);
     }
     
-    *pos += bytes_written;
     return bytes_written;
 }
 
+/* ================================
+ * Page Cache Operations
+ * ================================ */
+
+/**
+ * Fill a page cache page from disk
+ */
+static int ext2_readpage(void* host, uint64_t index, void* page) {
+    return ext2_readpages(host, index, 1, page);
+}
+
+/**
+ * Fill consecutive pages for readahead; contiguous blocks go to the device
+ * as one request
+ */
+static int ext2_readpages(void* host, uint64_t index, uint32_t nr, void* buffer) {
+    vfs_inode_t* inode = (vfs_inode_t*)host;
+    uint64_t pos = index << PAGE_CACHE_SHIFT;
+    if (pos >= inode->i_size) {
+        return EXT2_SUCCESS;
+    }
+    
+    uint64_t want = (uint64_t)nr << PAGE_CACHE_SHIFT;
+    size_t count = inode->i_size - pos < want ? inode->i_size - pos : want;
+    if (ext2_read_range(inode, (char*)buffer, count, pos) != (ssize_t)count) {
+        return EXT2_ERROR_IO;
+    }
+    return EXT2_SUCCESS;
+}
+
+/**
+ * Write a dirty page back; blocks are allocated here, not when the write
+ * was cached
+ */
+static int ext2_writepage(void* host, uint64_t index, const void* page) {
+    vfs_inode_t* inode = (vfs_inode_t*)host;
+    uint64_t pos = index << PAGE_CACHE_SHIFT;
+    if (pos >= inode->i_size) {
+        return EXT2_SUCCESS;  /* Truncated away */
+    }
+    
+    size_t count = inode->i_size - pos < PAGE_CACHE_SIZE ? inode->i_size - pos : PAGE_CACHE_SIZE;
+    if (ext2_write_range(inode, (const char*)page, count, pos) != (ssize_t)count) {
+        return EXT2_ERROR_IO;
+    }
+    return EXT2_SUCCESS;
+}
+
+/**
+ * Files stop where the block pointers run out, or at 4 GiB since only
+ * i_size_lo is kept
+ */
+static size_t ext2_write_limit(void* host, uint64_t pos, size_t len) {
+    vfs_inode_t* inode = (vfs_inode_t*)host;
+    ext2_fs_info_t* fs_info = (ext2_fs_info_t*)inode->i_sb->s_fs_info;
+    ext2_inode_info_t* ext2_info = (ext2_inode_info_t*)inode->i_private;
+    
+    if (!fs_info || !ext2_info) {
+        return 0;
+    }
+    if (ext2_info->is_extent_based) {
+        return len;
+    }
+    
+    uint64_t limit = ext2_blockmap_max_blocks(fs_info->block_size) * fs_info->block_size;
+    if (limit > 0xFFFFFFFFULL) {
+        limit = 0xFFFFFFFFULL;
+    }
+    if (pos >= limit) {
+        return 0;
+    }
+    return limit - pos < len ? (size_t)(limit - pos) : len;
+}
+
 /**
  * Read directory entries
  */
@@ -817,17 +1048,13 @@ int ext2_readdir(vfs_file_t* file, vfs_dirent_t* dirent) {
     }
     
     /* Get physical block */
-    ext2_inode_info_t* ext2_info = (ext2_inode_info_t*)inode->i_private;
-    uint32_t phys_block;
-    
-    if (dir_block < 12) {
-        phys_block = ext2_info->raw_inode.i_block[dir_block];
-    } else {
-        /* TODO: Handle indirect blocks */
-        return VFS_ERROR_NOT_SUPPORTED;
+    uint64_t phys_block;
+    uint32_t run;
+    int mapped = ext2_bmap(inode, dir_block, 1, false, &phys_block, &run);
+    if (mapped < 0) {
+        return VFS_ERROR_IO_ERROR;
     }
-    
-    if (phys_block == 0) {
+    if (mapped == 0) {
         return VFS_ERROR_NOT_FOUND;
     }
     
@@ -888,6 +1115,13 @@ int ext2_readdir(vfs_file_t* file, vfs_dirent_t* dirent) {
  * Read a block from disk
  */
 int ext2_read_block(ext2_fs_info_t* fs, uint64_t block, void* buffer) {
+    return ext2_read_blocks(fs, block, 1, buffer);
+}
+
+/**
+ * Read consecutive blocks from disk in one device request
+ */
+int ext2_read_blocks(ext2_fs_info_t* fs, uint64_t block, uint32_t count, void* buffer) {
     if (!fs || !buffer) {
         return EXT2_ERROR_INVALID;
     }
@@ -895,11 +1129,11 @@ int ext2_read_block(ext2_fs_info_t* fs, uint64_t block, void* buffer) {
     ext2_block_device_t* dev = (ext2_block_device_t*)fs->block_device;
     if (!dev || !dev->read_blocks) {
         /* For now, simulate reading by filling with test data */
-        memset(buffer, 0xAA, fs->block_size);
+        memset(buffer, 0xAA, (size_t)count * fs->block_size);
         return EXT2_SUCCESS;
     }
     
-    return dev->read_blocks(dev->private_data, block, 1, buffer);
+    return dev->read_blocks(dev->private_data, block, count, buffer);
 }
 
 /**
@@ -1102,6 +1336,56 @@ static int ext2_read_group_descriptors(ext2_fs_info_t* fs) {
     }
     
     printf("[EXT2] Loaded %u group descriptors\n", fs->groups_count);
+    
+    int result = ext2_load_groups(fs);
+    if (result != EXT2_SUCCESS) {
+        kfree(fs->group_desc);
+        fs->group_desc = NULL;
+    }
+    return result;
+}
+
+/* Group allocator ops: bitmap blocks go through this filesystem */
+static int ext2_groups_read(void* ctx, uint32_t block, void* buffer) {
+    return ext2_read_block((ext2_fs_info_t*)ctx, block, buffer);
+}
+
+static int ext2_groups_write(void* ctx, uint32_t block, const void* buffer) {
+    return ext2_write_block((ext2_fs_info_t*)ctx, block, buffer);
+}
+
+/**
+ * Set up the group allocator from the superblock and descriptors. Bitmaps
+ * are read on first use.
+ */
+static int ext2_load_groups(ext2_fs_info_t* fs) {
+    const ext2_superblock_t* sb = &fs->superblock;
+    ext2_groups_geometry_t geo;
+    geo.block_size = fs->block_size;
+    geo.blocks_count = sb->s_blocks_count_lo;
+    geo.first_data_block = sb->s_first_data_block;
+    geo.blocks_per_group = fs->blocks_per_group;
+    geo.inodes_per_group = fs->inodes_per_group;
+    geo.inodes_count = sb->s_inodes_count;
+    geo.first_ino = sb->s_rev_level == 0 ? EXT2_FIRST_INO : sb->s_first_ino;
+    geo.groups_count = fs->groups_count;
+    
+    ext2_groups_ops_t ops;
+    ops.read_block = ext2_groups_read;
+    ops.write_block = ext2_groups_write;
+    ops.alloc = kmalloc;
+    ops.free = kfree;
+    ops.ctx = fs;
+    
+    if (ext2_groups_init(&fs->groups, &geo, &ops) != EXT2_GROUPS_OK) {
+        return EXT2_ERROR_NO_MEMORY;
+    }
+    for (uint32_t i = 0; i < fs->groups_count; i++) {
+        const ext2_group_desc_t* gd = &fs->group_desc[i];
+        ext2_groups_set(&fs->groups, i, gd->bg_block_bitmap_lo, gd->bg_inode_bitmap_lo,
+                        gd->bg_free_blocks_count_lo, gd->bg_free_inodes_count_lo,
+                        gd->bg_used_dirs_count_lo);
+    }
     return EXT2_SUCCESS;
 }
 
@@ -1145,34 +1429,42 @@ static uint64_t ext2_get_block_64(const ext2_group_desc_t* gd, uint32_t field) {
     return gd->bg_inode_table_lo;  /* For now, just return inode table */
 }
 
-/* Stub implementations for missing functions */
+/* ================================
+ * Block and Inode Allocation
+ * ================================ */
 
+/**
+ * Allocate a block near `goal`; 0 when the volume is full
+ */
 uint32_t ext2_alloc_block(ext2_fs_info_t* fs, uint32_t goal) {
-    /* TODO: Implement block allocation */
-    (void)fs;
-    (void)goal;
-    return 1;  /* Dummy block number */
+    if (!fs) {
+        return 0;
+    }
+    return ext2_groups_alloc_block(&fs->groups, NULL, goal);
 }
 
 void ext2_free_block(ext2_fs_info_t* fs, uint32_t block) {
-    /* TODO: Implement block deallocation */
-    (void)fs;
-    (void)block;
+    if (!fs) {
+        return;
+    }
+    ext2_groups_free_block(&fs->groups, block);
 }
 
+/**
+ * Allocate an inode for a child of `dir_ino`; 0 when none is left
+ */
 uint32_t ext2_alloc_inode(ext2_fs_info_t* fs, uint32_t dir_ino, uint16_t mode) {
-    /* TODO: Implement inode allocation */
-    (void)fs;
-    (void)dir_ino;
-    (void)mode;
-    static uint32_t next_ino = EXT2_FIRST_INO;
-    return next_ino++;
+    if (!fs) {
+        return 0;
+    }
+    return ext2_groups_alloc_inode(&fs->groups, dir_ino, (mode & EXT2_S_IFMT) == EXT2_S_IFDIR);
 }
 
 void ext2_free_inode(ext2_fs_info_t* fs, uint32_t inode_num) {
-    /* TODO: Implement inode deallocation */
-    (void)fs;
-    (void)inode_num;
+    if (!fs) {
+        return;
+    }
+    ext2_groups_free_inode(&fs->groups, inode_num, false);
 }
 
 int ext2_find_entry(vfs_inode_t* dir, const char* name, uint32_t* inode_num) {
@@ -0,0 +1,325 @@
+/* IKOS ext2 Block Map
+ * See include/ext2_blockmap.h. Callers serialize access per inode.
+ */
+
+#include "ext2_blockmap.h"
+
+static void zero_bytes(void* dst, size_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    for (size_t i = 0; i < n; i++) {
+        d[i] = 0;
+    }
+}
+
+/**
+ * Initialize an empty cache
+ */
+void ext2_blockmap_init(ext2_blockmap_t* map, uint32_t* i_block, uint32_t block_size) {
+    if (!map) {
+        return;
+    }
+    zero_bytes(map, sizeof(*map));
+    map->i_block = i_block;
+    map->block_size = block_size;
+}
+
+uint64_t ext2_blockmap_max_blocks(uint32_t block_size) {
+    uint64_t p = block_size / 4;
+    uint64_t max = EXT2_BLOCKMAP_NDIR + p + p * p + p * p * p;
+    return max > 0xFFFFFFFFULL ? 0xFFFFFFFFULL : max;
+}
+
+/**
+ * Pointer indices from the inode down to the data pointer of file block
+ * `block`; returns the depth (1 direct .. 4 triple), or 0 out of range
+ */
+static int block_to_path(uint32_t block_size, uint64_t block, uint32_t offsets[4]) {
+    uint64_t p = block_size / 4;
+
+    if (block < EXT2_BLOCKMAP_NDIR) {
+        offsets[0] = (uint32_t)block;
+        return 1;
+    }
+    block -= EXT2_BLOCKMAP_NDIR;
+    if (block < p) {
+        offsets[0] = EXT2_BLOCKMAP_IND;
+        offsets[1] = (uint32_t)block;
+        return 2;
+    }
+    block -= p;
+    if (block < p * p) {
+        offsets[0] = EXT2_BLOCKMAP_DIND;
+        offsets[1] = (uint32_t)(block / p);
+        offsets[2] = (uint32_t)(block % p);
+        return 3;
+    }
+    block -= p * p;
+    if (block < p * p * p) {
+        offsets[0] = EXT2_BLOCKMAP_TIND;
+        offsets[1] = (uint32_t)(block / (p * p));
+        offsets[2] = (uint32_t)((block / p) % p);
+        offsets[3] = (uint32_t)(block % p);
+        return 4;
+    }
+    return 0;
+}
+
+/* ================================
+ * Pointer Block Cache
+ * ================================ */
+
+/**
+ * Pointers of disk block `block`, read on a miss. `fresh` installs a zeroed
+ * block without reading it (just allocated). The slot holding `pin` is not
+ * reused, so a caller can keep using its parent's pointers.
+ */
+static uint32_t* ind_get(ext2_blockmap_t* map, const ext2_blockmap_ops_t* ops, uint32_t block,
+                         bool fresh, uint32_t pin, int* err) {
+    ext2_blockmap_ind_t* victim = NULL;
+
+    for (uint32_t i = 0; i < EXT2_BLOCKMAP_IND_CACHE; i++) {
+        ext2_blockmap_ind_t* slot = &map->ind[i];
+        if (slot->block == block && slot->block != 0) {
+            slot->last_used = ++map->clock;
+            if (fresh) {
+                zero_bytes(slot->pointers, map->block_size);
+            }
+            return slot->pointers;
+        }
+        if (slot->block != 0 && slot->block == pin) {
+            continue;
+        }
+        if (!victim || slot->block == 0 ||
+            (victim->block != 0 && slot->last_used < victim->last_used)) {
+            victim = slot;
+        }
+    }
+
+    if (!victim->pointers) {
+        victim->pointers = (uint32_t*)ops->alloc(map->block_size);
+        if (!victim->pointers) {
+            *err = EXT2_BLOCKMAP_ENOMEM;
+            return NULL;
+        }
+    }
+
+    victim->block = 0;
+    if (fresh) {
+        zero_bytes(victim->pointers, map->block_size);
+    } else {
+        map->stats.ind_reads++;
+        if (ops->read_block(ops->ctx, block, victim->pointers) != 0) {
+            *err = EXT2_BLOCKMAP_EIO;
+            return NULL;
+        }
+    }
+    victim->block = block;
+    victim->last_used = ++map->clock;
+    return victim->pointers;
+}
+
+/* ================================
+ * Runs
+ * ================================ */
+
+/* Index of the run holding file block `block`, or -1 */
+static int extent_find(const ext2_blockmap_t* map, uint64_t block) {
+    uint32_t lo = 0;
+    uint32_t hi = map->nextents;
+
+    /* Last run starting at or before the block */
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (map->extents[mid].file_block <= block) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return -1;
+    }
+
+    const ext2_blockmap_extent_t* e = &map->extents[lo - 1];
+    return block < (uint64_t)e->file_block + e->length ? (int)(lo - 1) : -1;
+}
+
+static void extent_remove(ext2_blockmap_t* map, uint32_t i) {
+    for (; i + 1 < map->nextents; i++) {
+        map->extents[i] = map->extents[i + 1];
+    }
+    map->nextents--;
+}
+
+/**
+ * Remember a resolved run, merging it with its neighbours. When the table
+ * is full it is emptied and refilled by the lookups that follow.
+ */
+static void extent_insert(ext2_blockmap_t* map, uint32_t file_block, uint32_t disk_block,
+                          uint32_t length) {
+    uint32_t i = 0;
+    while (i < map->nextents && map->extents[i].file_block < file_block) {
+        i++;
+    }
+
+    /* Stop where the next known run begins */
+    if (i < map->nextents && file_block + length > map->extents[i].file_block) {
+        length = map->extents[i].file_block - file_block;
+    }
+    if (length == 0) {
+        return;
+    }
+
+    ext2_blockmap_extent_t* prev = i > 0 ? &map->extents[i - 1] : NULL;
+    ext2_blockmap_extent_t* next = i < map->nextents ? &map->extents[i] : NULL;
+
+    if (prev && prev->file_block + prev->length == file_block &&
+        prev->disk_block + prev->length == disk_block) {
+        prev->length += length;
+        if (next && prev->file_block + prev->length == next->file_block &&
+            prev->disk_block + prev->length == next->disk_block) {
+            prev->length += next->length;
+            extent_remove(map, i);
+        }
+        return;
+    }
+    if (next && file_block + length == next->file_block &&
+        disk_block + length == next->disk_block) {
+        next->file_block = file_block;
+        next->disk_block = disk_block;
+        next->length += length;
+        return;
+    }
+
+    if (map->nextents == EXT2_BLOCKMAP_EXTENTS) {
+        map->nextents = 0;
+        i = 0;
+    }
+    for (uint32_t j = map->nextents; j > i; j--) {
+        map->extents[j] = map->extents[j - 1];
+    }
+    map->extents[i].file_block = file_block;
+    map->extents[i].disk_block = disk_block;
+    map->extents[i].length = length;
+    map->nextents++;
+}
+
+/* ================================
+ * Lookup
+ * ================================ */
+
+/**
+ * Map a file block, walking the pointer tree on a cache miss
+ */
+int ext2_blockmap_map(ext2_blockmap_t* map, const ext2_blockmap_ops_t* ops, uint64_t file_block,
+                      uint32_t max_blocks, bool create, uint32_t* disk_block, uint32_t* run) {
+    if (!map || !ops || !map->i_block || !disk_block || !run) {
+        return EXT2_BLOCKMAP_EIO;
+    }
+    *disk_block = 0;
+    *run = 1;
+    if (max_blocks == 0) {
+        max_blocks = 1;
+    }
+    map->stats.lookups++;
+
+    int found = extent_find(map, file_block);
+    if (found >= 0) {
+        const ext2_blockmap_extent_t* e = &map->extents[found];
+        uint32_t offset = (uint32_t)(file_block - e->file_block);
+        uint32_t left = e->length - offset;
+        *disk_block = e->disk_block + offset;
+        *run = left < max_blocks ? left : max_blocks;
+        map->stats.extent_hits++;
+        return EXT2_BLOCKMAP_OK;
+    }
+
+    uint32_t offsets[4];
+    int depth = block_to_path(map->block_size, file_block, offsets);
+    if (depth == 0) {
+        return EXT2_BLOCKMAP_EFBIG;
+    }
+
+    uint32_t* pointers = map->i_block;
+    uint32_t parent = 0;                /* Disk block holding `pointers`; 0 = the inode */
+    uint32_t block = 0;
+    int err = EXT2_BLOCKMAP_OK;
+
+    for (int level = 0; level < depth; level++) {
+        uint32_t slot = offsets[level];
+        bool leaf = level == depth - 1;
+        block = pointers[slot];
+
+        if (block == 0) {
+            if (!create) {
+                return EXT2_BLOCKMAP_OK;  /* A hole */
+            }
+
+            /* Near the previous pointer in this block, else after the parent */
+            uint32_t goal = (slot > 0 && pointers[slot - 1]) ? pointers[slot - 1] + 1 :
+                            (parent ? parent + 1 : 0);
+            block = ops->alloc_block(ops->ctx, goal);
+            if (block == 0) {
+                return EXT2_BLOCKMAP_ENOSPC;
+            }
+            map->stats.allocations++;
+
+            /* A new pointer block goes to disk zeroed before anything points at it */
+            if (!leaf) {
+                uint32_t* fresh = ind_get(map, ops, block, true, parent, &err);
+                if (!fresh) {
+                    return err;
+                }
+                if (ops->write_block(ops->ctx, block, fresh) != 0) {
+                    return EXT2_BLOCKMAP_EIO;
+                }
+            }
+
+            pointers[slot] = block;
+            if (parent == 0) {
+                map->i_block_dirty = true;
+            } else if (ops->write_block(ops->ctx, parent, pointers) != 0) {
+                return EXT2_BLOCKMAP_EIO;
+            }
+        }
+
+        if (!leaf) {
+            pointers = ind_get(map, ops, block, false, 0, &err);
+            if (!pointers) {
+                return err;
+            }
+            parent = block;
+        }
+    }
+
+    /* Extend the run over following pointers in the same block */
+    uint32_t last = offsets[depth - 1];
+    uint32_t limit = depth == 1 ? EXT2_BLOCKMAP_NDIR : map->block_size / 4;
+    uint32_t count = 1;
+    while (count < max_blocks && last + count < limit && pointers[last + count] == block + count) {
+        count++;
+    }
+
+    extent_insert(map, (uint32_t)file_block, block, count);
+    *disk_block = block;
+    *run = count;
+    return EXT2_BLOCKMAP_OK;
+}
+
+/**
+ * Drop the runs and pointer blocks
+ */
+void ext2_blockmap_invalidate(ext2_blockmap_t* map, const ext2_blockmap_ops_t* ops) {
+    if (!map) {
+        return;
+    }
+    map->nextents = 0;
+    for (uint32_t i = 0; i < EXT2_BLOCKMAP_IND_CACHE; i++) {
+        if (map->ind[i].pointers && ops) {
+            ops->free(map->ind[i].pointers);
+        }
+        map->ind[i].pointers = NULL;
+        map->ind[i].block = 0;
+        map->ind[i].last_used = 0;
+    }
+}
@@ -0,0 +1,487 @@
+/* IKOS ext2 Group Allocator
+ * See include/ext2_groups.h. Callers serialize access per filesystem.
+ */
+
+#include "ext2_groups.h"
+
+static void zero_bytes(void* dst, size_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    for (size_t i = 0; i < n; i++) {
+        d[i] = 0;
+    }
+}
+
+/* ================================
+ * Bitmaps
+ * ================================ */
+
+static bool bit_test(const uint8_t* bits, uint32_t bit) {
+    return (bits[bit / 8] >> (bit % 8)) & 1;
+}
+
+static void bit_set(uint8_t* bits, uint32_t bit) {
+    bits[bit / 8] |= (uint8_t)(1 << (bit % 8));
+}
+
+static void bit_clear(uint8_t* bits, uint32_t bit) {
+    bits[bit / 8] &= (uint8_t)~(1 << (bit % 8));
+}
+
+/* First clear bit in [from, limit), or limit */
+static uint32_t find_clear(const uint8_t* bits, uint32_t from, uint32_t limit) {
+    uint32_t bit = from;
+    while (bit < limit) {
+        if (bit % 8 == 0 && bits[bit / 8] == 0xFF) {
+            bit += 8;  /* Whole byte in use */
+            continue;
+        }
+        if (!bit_test(bits, bit)) {
+            return bit;
+        }
+        bit++;
+    }
+    return limit;
+}
+
+/* First byte-aligned run of 8 clear bits in [from, limit), or limit */
+static uint32_t find_clear_byte(const uint8_t* bits, uint32_t from, uint32_t limit) {
+    for (uint32_t byte = (from + 7) / 8; (byte + 1) * 8 <= limit; byte++) {
+        if (bits[byte] == 0) {
+            return byte * 8;
+        }
+    }
+    return limit;
+}
+
+/* Cached bitmap at disk block `block`, read on first use */
+static uint8_t* bitmap_load(ext2_groups_t* groups, uint8_t** cached, uint32_t block) {
+    if (*cached) {
+        return *cached;
+    }
+    uint8_t* bits = (uint8_t*)groups->ops.alloc(groups->geo.block_size);
+    if (!bits) {
+        return NULL;
+    }
+    groups->stats.bitmap_reads++;
+    if (groups->ops.read_block(groups->ops.ctx, block, bits) != 0) {
+        groups->ops.free(bits);
+        return NULL;
+    }
+    *cached = bits;
+    return bits;
+}
+
+static uint8_t* group_blocks(ext2_groups_t* groups, uint32_t group) {
+    ext2_group_t* g = &groups->groups[group];
+    return bitmap_load(groups, &g->blocks, g->block_bitmap);
+}
+
+static uint8_t* group_inodes(ext2_groups_t* groups, uint32_t group) {
+    ext2_group_t* g = &groups->groups[group];
+    return bitmap_load(groups, &g->inodes, g->inode_bitmap);
+}
+
+/* Blocks in a group; the last one may be short */
+static uint32_t group_size(const ext2_groups_t* groups, uint32_t group) {
+    const ext2_groups_geometry_t* geo = &groups->geo;
+    uint32_t start = group * geo->blocks_per_group;
+    uint32_t total = geo->blocks_count - geo->first_data_block;
+    uint32_t left = total > start ? total - start : 0;
+    return left < geo->blocks_per_group ? left : geo->blocks_per_group;
+}
+
+/* ================================
+ * Setup
+ * ================================ */
+
+int ext2_groups_init(ext2_groups_t* groups, const ext2_groups_geometry_t* geo,
+                     const ext2_groups_ops_t* ops) {
+    if (!groups || !geo || !ops || geo->groups_count == 0 ||
+        geo->blocks_per_group == 0 || geo->inodes_per_group == 0) {
+        return EXT2_GROUPS_EIO;
+    }
+    zero_bytes(groups, sizeof(*groups));
+    groups->geo = *geo;
+    groups->ops = *ops;
+
+    size_t size = geo->groups_count * sizeof(ext2_group_t);
+    groups->groups = (ext2_group_t*)ops->alloc(size);
+    if (!groups->groups) {
+        return EXT2_GROUPS_ENOMEM;
+    }
+    zero_bytes(groups->groups, size);
+    return EXT2_GROUPS_OK;
+}
+
+void ext2_groups_set(ext2_groups_t* groups, uint32_t group, uint32_t block_bitmap,
+                     uint32_t inode_bitmap, uint32_t free_blocks, uint32_t free_inodes,
+                     uint32_t used_dirs) {
+    if (!groups || !groups->groups || group >= groups->geo.groups_count) {
+        return;
+    }
+    ext2_group_t* g = &groups->groups[group];
+    groups->free_blocks -= g->free_blocks;
+    groups->free_inodes -= g->free_inodes;
+
+    g->block_bitmap = block_bitmap;
+    g->inode_bitmap = inode_bitmap;
+    g->free_blocks = free_blocks;
+    g->free_inodes = free_inodes;
+    g->used_dirs = used_dirs;
+
+    groups->free_blocks += free_blocks;
+    groups->free_inodes += free_inodes;
+}
+
+/* ================================
+ * Blocks
+ * ================================ */
+
+static void block_take(ext2_groups_t* groups, uint32_t group, uint8_t* bits, uint32_t bit) {
+    ext2_group_t* g = &groups->groups[group];
+    bit_set(bits, bit);
+    g->free_blocks--;
+    groups->free_blocks--;
+    g->blocks_dirty = true;
+    g->counts_dirty = true;
+}
+
+/* Free bit to use in a group, searching from `start`; `near` tries the
+ * goal and its neighbourhood first. Returns the group size if full. */
+static uint32_t block_pick(const uint8_t* bits, uint32_t start, uint32_t size, bool near) {
+    if (near) {
+        if (!bit_test(bits, start)) {
+            return start;
+        }
+        uint32_t end = start + EXT2_GROUPS_NEAR_SCAN < size ? start + EXT2_GROUPS_NEAR_SCAN : size;
+        uint32_t bit = find_clear(bits, start, end);
+        if (bit < end) {
+            return bit;
+        }
+    }
+
+    /* A fresh run leaves room for the file to grow */
+    uint32_t bit = find_clear_byte(bits, start, size);
+    if (bit < size) {
+        return bit;
+    }
+    bit = find_clear(bits, start, size);
+    if (bit < size) {
+        return bit;
+    }
+    bit = find_clear(bits, 0, start);
+    return bit < start ? bit : size;
+}
+
+/* Reserve up to EXT2_GROUPS_PREALLOC free blocks straight after `block` */
+static void window_reserve(ext2_groups_t* groups, ext2_prealloc_t* window, uint32_t block) {
+    const ext2_groups_geometry_t* geo = &groups->geo;
+    uint32_t group = (block - geo->first_data_block) / geo->blocks_per_group;
+    uint32_t bit = (block - geo->first_data_block) % geo->blocks_per_group;
+    uint32_t size = group_size(groups, group);
+    uint8_t* bits = groups->groups[group].blocks;
+
+    window->next = block + 1;
+    window->count = 0;
+    while (window->count < EXT2_GROUPS_PREALLOC && bit + 1 + window->count < size &&
+           !bit_test(bits, bit + 1 + window->count)) {
+        block_take(groups, group, bits, bit + 1 + window->count);
+        window->count++;
+    }
+
+    /* Track it so a sync can give it back */
+    if (window->count > 0 && !window->listed) {
+        window->link = groups->windows;
+        groups->windows = window;
+        window->listed = true;
+    }
+}
+
+uint32_t ext2_groups_alloc_block(ext2_groups_t* groups, ext2_prealloc_t* window, uint32_t goal) {
+    if (!groups || !groups->groups) {
+        return 0;
+    }
+    const ext2_groups_geometry_t* geo = &groups->geo;
+
+    /* Appending: the window already holds the block */
+    if (window && window->count > 0) {
+        if (goal == 0 || goal == window->next) {
+            groups->stats.block_allocs++;
+            groups->stats.prealloc_hits++;
+            if (goal) {
+                groups->stats.goal_hits++;
+            }
+            window->count--;
+            return window->next++;
+        }
+        ext2_groups_discard(groups, window);
+    }
+
+    if (groups->free_blocks == 0) {
+        return 0;
+    }
+    if (goal < geo->first_data_block || goal >= geo->blocks_count) {
+        goal = geo->first_data_block;
+    }
+    uint32_t goal_group = (goal - geo->first_data_block) / geo->blocks_per_group;
+    uint32_t goal_bit = (goal - geo->first_data_block) % geo->blocks_per_group;
+
+    for (uint32_t i = 0; i < geo->groups_count; i++) {
+        uint32_t group = (goal_group + i) % geo->groups_count;
+        uint32_t size = group_size(groups, group);
+        if (groups->groups[group].free_blocks == 0 || size == 0) {
+            continue;
+        }
+        uint8_t* bits = group_blocks(groups, group);
+        if (!bits) {
+            continue;
+        }
+
+        uint32_t start = (i == 0 && goal_bit < size) ? goal_bit : 0;
+        uint32_t bit = block_pick(bits, start, size, i == 0);
+        if (bit >= size) {
+            continue;  /* Count was stale */
+        }
+
+        block_take(groups, group, bits, bit);
+        uint32_t block = geo->first_data_block + group * geo->blocks_per_group + bit;
+        groups->stats.block_allocs++;
+        if (block == goal) {
+            groups->stats.goal_hits++;
+        }
+        if (window) {
+            window_reserve(groups, window, block);
+        }
+        return block;
+    }
+    return 0;
+}
+
+void ext2_groups_free_block(ext2_groups_t* groups, uint32_t block) {
+    if (!groups || !groups->groups) {
+        return;
+    }
+    const ext2_groups_geometry_t* geo = &groups->geo;
+    if (block < geo->first_data_block || block >= geo->blocks_count) {
+        return;
+    }
+
+    uint32_t group = (block - geo->first_data_block) / geo->blocks_per_group;
+    uint32_t bit = (block - geo->first_data_block) % geo->blocks_per_group;
+    uint8_t* bits = group_blocks(groups, group);
+    if (!bits || !bit_test(bits, bit)) {
+        return;
+    }
+
+    ext2_group_t* g = &groups->groups[group];
+    bit_clear(bits, bit);
+    g->free_blocks++;
+    groups->free_blocks++;
+    g->blocks_dirty = true;
+    g->counts_dirty = true;
+}
+
+void ext2_groups_discard(ext2_groups_t* groups, ext2_prealloc_t* window) {
+    if (!groups || !window) {
+        return;
+    }
+    for (uint32_t i = 0; i < window->count; i++) {
+        ext2_groups_free_block(groups, window->next + i);
+    }
+    window->count = 0;
+
+    if (window->listed) {
+        ext2_prealloc_t** pp = &groups->windows;
+        while (*pp && *pp != window) {
+            pp = &(*pp)->link;
+        }
+        if (*pp) {
+            *pp = window->link;
+        }
+        window->link = NULL;
+        window->listed = false;
+    }
+}
+
+/* ================================
+ * Inodes
+ * ================================ */
+
+/* Take the first free inode of a group, or return 0 */
+static uint32_t inode_take(ext2_groups_t* groups, uint32_t group, bool is_dir) {
+    const ext2_groups_geometry_t* geo = &groups->geo;
+    ext2_group_t* g = &groups->groups[group];
+    if (g->free_inodes == 0) {
+        return 0;
+    }
+    uint8_t* bits = group_inodes(groups, group);
+    if (!bits) {
+        return 0;
+    }
+
+    /* Reserved inodes sit at the start of group 0 */
+    uint32_t start = (group == 0 && geo->first_ino > 1) ? geo->first_ino - 1 : 0;
+    uint32_t bit = find_clear(bits, start, geo->inodes_per_group);
+    if (bit >= geo->inodes_per_group) {
+        return 0;
+    }
+
+    bit_set(bits, bit);
+    g->free_inodes--;
+    groups->free_inodes--;
+    if (is_dir) {
+        g->used_dirs++;
+    }
+    g->inodes_dirty = true;
+    g->counts_dirty = true;
+    return group * geo->inodes_per_group + bit + 1;
+}
+
+/* Directories: most free blocks among groups with at least the average
+ * free inodes */
+static uint32_t dir_group(const ext2_groups_t* groups, uint32_t parent_group) {
+    uint32_t count = groups->geo.groups_count;
+    uint32_t average = groups->free_inodes / count;
+    uint32_t best = count;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t group = (parent_group + i) % count;
+        const ext2_group_t* g = &groups->groups[group];
+        if (g->free_inodes == 0 || g->free_inodes < average) {
+            continue;
+        }
+        if (best == count || g->free_blocks > groups->groups[best].free_blocks) {
+            best = group;
+        }
+    }
+    return best;
+}
+
+/* Files: the parent's group, else quadratic probing from it */
+static uint32_t file_group(const ext2_groups_t* groups, uint32_t parent_group) {
+    uint32_t count = groups->geo.groups_count;
+    const ext2_group_t* g = &groups->groups[parent_group];
+    if (g->free_inodes > 0 && g->free_blocks > 0) {
+        return parent_group;
+    }
+
+    for (uint32_t step = 1; step < count; step <<= 1) {
+        uint32_t group = (parent_group + step) % count;
+        g = &groups->groups[group];
+        if (g->free_inodes > 0 && g->free_blocks > 0) {
+            return group;
+        }
+    }
+    return count;
+}
+
+uint32_t ext2_groups_alloc_inode(ext2_groups_t* groups, uint32_t parent_ino, bool is_dir) {
+    if (!groups || !groups->groups || groups->free_inodes == 0) {
+        return 0;
+    }
+    const ext2_groups_geometry_t* geo = &groups->geo;
+
+    uint32_t parent_group = parent_ino ? (parent_ino - 1) / geo->inodes_per_group : 0;
+    if (parent_group >= geo->groups_count) {
+        parent_group = 0;
+    }
+
+    uint32_t group = is_dir ? dir_group(groups, parent_group) : file_group(groups, parent_group);
+    if (group < geo->groups_count) {
+        uint32_t ino = inode_take(groups, group, is_dir);
+        if (ino) {
+            return ino;
+        }
+    }
+
+    /* Anywhere with a free inode */
+    for (uint32_t i = 0; i < geo->groups_count; i++) {
+        uint32_t ino = inode_take(groups, (parent_group + i) % geo->groups_count, is_dir);
+        if (ino) {
+            return ino;
+        }
+    }
+    return 0;
+}
+
+void ext2_groups_free_inode(ext2_groups_t* groups, uint32_t ino, bool is_dir) {
+    if (!groups || !groups->groups) {
+        return;
+    }
+    const ext2_groups_geometry_t* geo = &groups->geo;
+    if (ino < geo->first_ino || ino > geo->inodes_count) {
+        return;
+    }
+
+    uint32_t group = (ino - 1) / geo->inodes_per_group;
+    uint32_t bit = (ino - 1) % geo->inodes_per_group;
+    uint8_t* bits = group_inodes(groups, group);
+    if (!bits || !bit_test(bits, bit)) {
+        return;
+    }
+
+    ext2_group_t* g = &groups->groups[group];
+    bit_clear(bits, bit);
+    g->free_inodes++;
+    groups->free_inodes++;
+    if (is_dir && g->used_dirs > 0) {
+        g->used_dirs--;
+    }
+    g->inodes_dirty = true;
+    g->counts_dirty = true;
+}
+
+/* ================================
+ * Writeback
+ * ================================ */
+
+int ext2_groups_sync(ext2_groups_t* groups) {
+    if (!groups || !groups->groups) {
+        return EXT2_GROUPS_OK;
+    }
+
+    /* Reserved blocks are not in use: the on-disk bitmaps and counts must
+     * not claim them. An open appender simply reserves a new window. */
+    while (groups->windows) {
+        ext2_groups_discard(groups, groups->windows);
+    }
+
+    int result = EXT2_GROUPS_OK;
+    for (uint32_t i = 0; i < groups->geo.groups_count; i++) {
+        ext2_group_t* g = &groups->groups[i];
+        if (g->blocks_dirty && g->blocks) {
+            groups->stats.bitmap_writes++;
+            if (groups->ops.write_block(groups->ops.ctx, g->block_bitmap, g->blocks) == 0) {
+                g->blocks_dirty = false;
+            } else {
+                result = EXT2_GROUPS_EIO;
+            }
+        }
+        if (g->inodes_dirty && g->inodes) {
+            groups->stats.bitmap_writes++;
+            if (groups->ops.write_block(groups->ops.ctx, g->inode_bitmap, g->inodes) == 0) {
+                g->inodes_dirty = false;
+            } else {
+                result = EXT2_GROUPS_EIO;
+            }
+        }
+    }
+    return result;
+}
+
+void ext2_groups_destroy(ext2_groups_t* groups) {
+    if (!groups || !groups->groups) {
+        return;
+    }
+    for (uint32_t i = 0; i < groups->geo.groups_count; i++) {
+        if (groups->groups[i].blocks) {
+            groups->ops.free(groups->groups[i].blocks);
+        }
+        if (groups->groups[i].inodes) {
+            groups->ops.free(groups->groups[i].inodes);
+        }
+    }
+    groups->ops.free(groups->groups);
+    groups->groups = NULL;
+    groups->windows = NULL;
+}
@@ -4,6 +4,7 @@
 
 #include "fat.h"
 #include "vfs.h"
+#include "blk_queue.h"
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
@@ -60,6 +61,18 @@ static void debug_print(const char* format, ...);
 extern void* kmalloc(size_t size);
 extern void kfree(void* ptr);
 
+/* Extent map ops: the chain comes from the cached FAT table */
+static uint32_t fat_extent_next(void* ctx, uint32_t cluster) {
+    return fat_next_cluster((fat_fs_info_t*)ctx, cluster);
+}
+
+static void fat_extent_ops_init(fat_extent_ops_t* ops, fat_fs_info_t* fat_info) {
+    ops->next_cluster = fat_extent_next;
+    ops->alloc = kmalloc;
+    ops->free = kfree;
+    ops->ctx = fat_info;
+}
+
 /* FAT filesystem operations tables */
 static vfs_superblock_operations_t fat_super_ops = {
     .alloc_inode = fat_alloc_inode,
@@ -78,6 +91,22 @@ static vfs_inode_operations_t fat_dir_inode_ops = {
     .setattr = NULL,  /* Not implemented yet */
 };
 
+static ssize_t fat_read_range(vfs_inode_t* inode, fat_cursor_t* cursor,
+                              char* buffer, size_t count, uint64_t pos);
+static ssize_t fat_write_range(vfs_inode_t* inode, fat_cursor_t* cursor,
+                               const char* buffer, size_t count, uint64_t pos);
+static int fat_readpage(void* host, uint64_t index, void* page);
+static int fat_readpages(void* host, uint64_t index, uint32_t nr, void* buffer);
+static int fat_writepage(void* host, uint64_t index, const void* page);
+static size_t fat_write_limit(void* host, uint64_t pos, size_t len);
+
+static const page_cache_aops_t fat_aops = {
+    .readpage = fat_readpage,
+    .writepage = fat_writepage,
+    .write_limit = fat_write_limit,
+    .readpages = fat_readpages,
+};
+
 static vfs_file_operations_t fat_file_ops = {
     .read = fat_read,
     .write = fat_write,
@@ -205,9 +234,7 @@ vfs_superblock_t* fat_mount(vfs_filesystem_t* fs, uint32_t flags,
     vfs_superblock_t* sb = (vfs_superblock_t*)kmalloc(sizeof(vfs_superblock_t));
     if (!sb) {
         debug_print("FAT: Failed to allocate superblock\n");
-        if (fat_info->fat_table) {
-            kfree(fat_info->fat_table);
-        }
+        fat_unload_fat_table(fat_info);
         kfree(fat_info);
         return NULL;
     }
@@ -224,9 +251,7 @@ vfs_superblock_t* fat_mount(vfs_filesystem_t* fs, uint32_t flags,
     vfs_inode_t* root_inode = fat_alloc_inode(sb);
     if (!root_inode) {
         debug_print("FAT: Failed to create root inode\n");
-        if (fat_info->fat_table) {
-            kfree(fat_info->fat_table);
-        }
+        fat_unload_fat_table(fat_info);
         kfree(fat_info);
         kfree(sb);
         return NULL;
@@ -250,9 +275,7 @@ vfs_superblock_t* fat_mount(vfs_filesystem_t* fs, uint32_t flags,
     if (!root_dentry) {
         debug_print("FAT: Failed to create root dentry\n");
         fat_destroy_inode(root_inode);
-        if (fat_info->fat_table) {
-            kfree(fat_info->fat_table);
-        }
+        fat_unload_fat_table(fat_info);
         kfree(fat_info);
         kfree(sb);
         return NULL;
@@ -285,9 +308,7 @@ void fat_kill_sb(vfs_superblock_t* sb) {
         }
         
         /* Free FAT table */
-        if (fat_info->fat_table) {
-            kfree(fat_info->fat_table);
-        }
+        fat_unload_fat_table(fat_info);
         
         kfree(fat_info);
     }
@@ -335,6 +356,7 @@ vfs_inode_t* fat_alloc_inode(vfs_superblock_t* sb) {
     fat_info->current_cluster = 0;
     fat_info->cluster_offset = 0;
     fat_info->is_directory = false;
+    fat_extent_map_init(&fat_info->extents);
     
     inode->i_private = fat_info;
     return inode;
@@ -350,6 +372,7 @@ void fat_destroy_inode(vfs_inode_t* inode) {
     
     fat_inode_info_t* fat_info = (fat_inode_info_t*)inode->i_private;
     if (fat_info) {
+        fat_invalidate_extents(fat_info);
         kfree(fat_info);
     }
     
@@ -424,11 +447,59 @@ int fat_load_fat_table(fat_fs_info_t* fat_info) {
         return FAT_ERROR_IO_ERROR;
     }
     
+    /* Free-cluster map (indexed by cluster number) and dirty-sector map */
+    uint32_t cluster_bits = fat_info->total_clusters + 2;
+    uint64_t* free_words = (uint64_t*)kmalloc(FAT_BITMAP_WORDS(cluster_bits) * sizeof(uint64_t));
+    uint64_t* dirty_words = (uint64_t*)kmalloc(FAT_BITMAP_WORDS(fat_info->fat_size) * sizeof(uint64_t));
+    if (!free_words || !dirty_words) {
+        if (free_words) {
+            kfree(free_words);
+        }
+        if (dirty_words) {
+            kfree(dirty_words);
+        }
+        kfree(fat_info->fat_table);
+        fat_info->fat_table = NULL;
+        return FAT_ERROR_NO_MEMORY;
+    }
+    
+    fat_bitmap_init(&fat_info->free_map, free_words, cluster_bits);
+    fat_bitmap_init(&fat_info->dirty_map, dirty_words, fat_info->fat_size);
+    for (uint32_t cluster = 2; cluster < cluster_bits; cluster++) {
+        if (fat_get_cluster_value(fat_info, cluster) == FAT_CLUSTER_FREE) {
+            fat_bitmap_set(&fat_info->free_map, cluster);
+        }
+    }
+    fat_info->free_map.hint = 2;
+    
     fat_info->fat_dirty = false;
-    debug_print("FAT: Loaded FAT table (%u bytes)\n", fat_info->fat_table_size);
+    debug_print("FAT: Loaded FAT table (%u bytes, %u free clusters)\n",
+                fat_info->fat_table_size, fat_info->free_map.set_count);
     return FAT_SUCCESS;
 }
 
+/**
+ * Free the cached FAT table and its maps
+ */
+void fat_unload_fat_table(fat_fs_info_t* fat_info) {
+    if (!fat_info) {
+        return;
+    }
+    
+    if (fat_info->fat_table) {
+        kfree(fat_info->fat_table);
+        fat_info->fat_table = NULL;
+    }
+    if (fat_info->free_map.words) {
+        kfree(fat_info->free_map.words);
+        fat_info->free_map.words = NULL;
+    }
+    if (fat_info->dirty_map.words) {
+        kfree(fat_info->dirty_map.words);
+        fat_info->dirty_map.words = NULL;
+    }
+}
+
 /**
  * Write FAT table back to disk
  */
@@ -437,17 +508,32 @@ int fat_write_fat_table(fat_fs_info_t* fat_info) {
         return FAT_SUCCESS;
     }
     
-    /* Write to all FAT copies */
-    for (uint32_t i = 0; i < fat_info->num_fats; i++) {
-        uint32_t fat_start_sector = fat_info->reserved_sectors + (i * fat_info->fat_size);
-        if (fat_write_sectors(fat_info, fat_start_sector, fat_info->fat_size,
-                              fat_info->fat_table) != FAT_SUCCESS) {
-            return FAT_ERROR_IO_ERROR;
+    /* Write each run of changed sectors to all FAT copies, plugged so the
+     * runs of every copy go out merged and in disk order */
+    fat_block_device_t* dev = (fat_block_device_t*)fat_info->block_device;
+    uint32_t written = 0;
+    uint32_t len;
+    blk_plug(dev);
+    for (uint32_t run = fat_bitmap_next_run(&fat_info->dirty_map, 0, &len);
+         run != FAT_BITMAP_NONE;
+         run = fat_bitmap_next_run(&fat_info->dirty_map, run + len, &len)) {
+        const uint8_t* data = fat_info->fat_table + run * fat_info->sector_size;
+        for (uint32_t i = 0; i < fat_info->num_fats; i++) {
+            uint32_t fat_start_sector = fat_info->reserved_sectors + (i * fat_info->fat_size);
+            if (fat_write_sectors(fat_info, fat_start_sector + run, len, data) != FAT_SUCCESS) {
+                blk_unplug(dev);
+                return FAT_ERROR_IO_ERROR;
+            }
         }
+        written += len;
+    }
+    if (blk_unplug(dev) != 0) {
+        return FAT_ERROR_IO_ERROR;
     }
     
+    fat_bitmap_reset(&fat_info->dirty_map);
     fat_info->fat_dirty = false;
-    debug_print("FAT: Wrote FAT table to disk\n");
+    debug_print("FAT: Wrote %u FAT sectors to disk\n", written);
     return FAT_SUCCESS;
 }
 
@@ -500,6 +586,15 @@ int fat_set_cluster_value(fat_fs_info_t* fat_info, uint32_t cluster, uint32_t va
         return FAT_ERROR_UNSUPPORTED_TYPE;
     }
     
+    /* Keep the free map in step and remember which sector changed */
+    if (value == FAT_CLUSTER_FREE) {
+        fat_bitmap_set(&fat_info->free_map, cluster);
+    } else {
+        fat_bitmap_clear(&fat_info->free_map, cluster);
+    }
+    uint32_t entry_size = fat_info->type == FAT_TYPE_FAT16 ? 2 : 4;
+    fat_bitmap_set(&fat_info->dirty_map, cluster * entry_size / fat_info->sector_size);
+    
     fat_info->fat_dirty = true;
     return FAT_SUCCESS;
 }
@@ -512,13 +607,96 @@ uint32_t fat_find_free_cluster(fat_fs_info_t* fat_info) {
         return 0;
     }
     
-    for (uint32_t cluster = 2; cluster < fat_info->total_clusters + 2; cluster++) {
-        if (fat_get_cluster_value(fat_info, cluster) == FAT_CLUSTER_FREE) {
-            return cluster;
+    uint32_t got;
+    uint32_t cluster = fat_bitmap_find_run(&fat_info->free_map, 1, &got);
+    if (cluster == FAT_BITMAP_NONE) {
+        return 0;  /* No free clusters */
+    }
+    
+    return cluster;
+}
+
+/**
+ * Append num_clusters free clusters to the chain ending at start_cluster
+ * (0 starts a new chain). Clusters are taken in runs, as long as the free
+ * map allows, so the file stays contiguous. owner, the file whose chain
+ * this is (NULL for none), has its extent map dropped.
+ * Returns the first new cluster, or a negative FAT error.
+ */
+int fat_allocate_cluster_chain(fat_fs_info_t* fat_info, fat_inode_info_t* owner,
+                               uint32_t start_cluster, uint32_t num_clusters) {
+    if (!fat_info || !fat_info->fat_table || num_clusters == 0) {
+        return FAT_ERROR_INVALID_CLUSTER;
+    }
+    if (fat_info->free_map.set_count < num_clusters) {
+        return FAT_ERROR_NO_SPACE;
+    }
+    
+    uint32_t eof_value = fat_info->type == FAT_TYPE_FAT16 ? FAT_CLUSTER_EOF16 : FAT_CLUSTER_EOF32;
+    uint32_t first = 0;
+    uint32_t prev = start_cluster;
+    
+    fat_invalidate_extents(owner);
+    
+    while (num_clusters > 0) {
+        uint32_t got;
+        uint32_t run = fat_bitmap_find_run(&fat_info->free_map, num_clusters, &got);
+        if (run == FAT_BITMAP_NONE) {
+            break;
         }
+        
+        /* Link the run in order, ending in EOF */
+        for (uint32_t cluster = run; cluster < run + got; cluster++) {
+            fat_set_cluster_value(fat_info, cluster, eof_value);
+            if (prev) {
+                fat_set_cluster_value(fat_info, prev, cluster);
+            }
+            if (!first) {
+                first = cluster;
+            }
+            prev = cluster;
+        }
+        num_clusters -= got;
+    }
+    
+    if (num_clusters > 0) {
+        /* Out of space part way: give back what this call took */
+        if (first) {
+            fat_free_cluster_chain(fat_info, NULL, first);
+            if (start_cluster) {
+                fat_set_cluster_value(fat_info, start_cluster, eof_value);
+            }
+        }
+        return FAT_ERROR_NO_SPACE;
     }
     
-    return 0;  /* No free clusters */
+    return (int)first;
+}
+
+/**
+ * Free every cluster of the chain starting at start_cluster; owner, the
+ * file it belongs to (NULL for none), has its extent map dropped
+ */
+int fat_free_cluster_chain(fat_fs_info_t* fat_info, fat_inode_info_t* owner,
+                           uint32_t start_cluster) {
+    if (!fat_info || !fat_info->fat_table || start_cluster < 2) {
+        return FAT_ERROR_INVALID_CLUSTER;
+    }
+    
+    fat_invalidate_extents(owner);
+    
+    uint32_t cluster = start_cluster;
+    uint32_t freed = 0;
+    while (cluster >= 2 && cluster < fat_info->total_clusters + 2) {
+        if (freed++ > fat_info->total_clusters) {
+            return FAT_ERROR_CLUSTER_CHAIN;  /* Loop in the chain */
+        }
+        uint32_t next = fat_next_cluster(fat_info, cluster);
+        fat_set_cluster_value(fat_info, cluster, FAT_CLUSTER_FREE);
+        cluster = next;
+    }
+    
+    return FAT_SUCCESS;
 }
 
 /* ================================
@@ -553,6 +731,45 @@ uint32_t fat_next_cluster(fat_fs_info_t* fat_info, uint32_t cluster) {
     return next;
 }
 
+/**
+ * Disk cluster holding cluster `index` of a file, or 0 past its end. The
+ * inode's extent map is built on first use; *run (if not NULL) receives
+ * the number of consecutive clusters from there on.
+ */
+uint32_t fat_file_cluster(fat_fs_info_t* fat_info, fat_inode_info_t* inode_info,
+                          fat_cursor_t* cursor, uint32_t index, uint32_t* run) {
+    if (!fat_info || !inode_info) {
+        return 0;
+    }
+    
+    if (!inode_info->extents.valid) {
+        fat_extent_ops_t ops;
+        fat_extent_ops_init(&ops, fat_info);
+        if (fat_extent_map_build(&inode_info->extents, inode_info->first_cluster,
+                                 fat_info->total_clusters, &ops) != FAT_SUCCESS) {
+            return 0;
+        }
+        if (cursor) {
+            fat_cursor_reset(cursor);
+        }
+    }
+    
+    return fat_extent_lookup(&inode_info->extents, cursor, index, run);
+}
+
+/**
+ * Drop a file's extent map after its cluster chain changed
+ */
+void fat_invalidate_extents(fat_inode_info_t* inode_info) {
+    if (!inode_info) {
+        return;
+    }
+    
+    fat_extent_ops_t ops;
+    fat_extent_ops_init(&ops, NULL);
+    fat_extent_map_clear(&inode_info->extents, &ops);
+}
+
 /**
  * Check if cluster is free
  */
@@ -713,6 +930,7 @@ vfs_dentry_t* fat_lookup(vfs_inode_t* dir, vfs_dentry_t* dentry) {
     } else {
         inode->i_op = NULL;
         inode->i_fop = &fat_file_ops;
+        vfs_inode_set_aops(inode, &fat_aops);
     }
     
     new_dentry->d_inode = inode;
@@ -873,6 +1091,7 @@ int fat_open(vfs_inode_t* inode, vfs_file_t* file) {
     file_info->current_cluster = inode_info->first_cluster;
     file_info->cluster_offset = 0;
     file_info->file_position = 0;
+    fat_cursor_reset(&file_info->cursor);
     
     /* Store file info in VFS file structure */
     file->f_private_data = file_info;
@@ -898,98 +1117,90 @@ int fat_release(vfs_inode_t* inode, vfs_file_t* file) {
 }
 
 /**
- * Read from a FAT file
+ * Read file bytes [pos, pos + count) through the cluster cursor
  */
-ssize_t fat_read(vfs_file_t* file, char* buffer, size_t count, uint64_t* pos) {
-    if (!file || !buffer || !pos) {
-        return VFS_ERROR_INVALID_PARAM;
-    }
-    
-    vfs_inode_t* inode = file->f_inode;
+static ssize_t fat_read_range(vfs_inode_t* inode, fat_cursor_t* cursor,
+                              char* buffer, size_t count, uint64_t pos) {
     fat_inode_info_t* inode_info = (fat_inode_info_t*)inode->i_private;
-    fat_file_info_t* file_info = (fat_file_info_t*)file->f_private_data;
     fat_fs_info_t* fat_info = (fat_fs_info_t*)inode->i_sb->s_fs_info;
     
-    if (!inode_info || !file_info || !fat_info) {
-        return VFS_ERROR_INVALID_PARAM;
-    }
-    
     /* Check bounds */
-    if (*pos >= inode->i_size) {
+    if (pos >= inode->i_size) {
         return 0;  /* EOF */
     }
     
     /* Adjust count if it goes beyond file size */
-    if (*pos + count > inode->i_size) {
-        count = inode->i_size - *pos;
+    if (pos + count > inode->i_size) {
+        count = inode->i_size - pos;
     }
     
     size_t bytes_read = 0;
-    uint32_t current_cluster = inode_info->first_cluster;
-    
-    /* Skip to the correct cluster for the current position */
-    uint32_t cluster_num = *pos / fat_info->cluster_size;
-    for (uint32_t i = 0; i < cluster_num && current_cluster != 0; i++) {
-        current_cluster = fat_next_cluster(fat_info, current_cluster);
-    }
-    
-    if (current_cluster == 0) {
-        return VFS_ERROR_IO_ERROR;
-    }
-    
-    uint32_t cluster_offset = *pos % fat_info->cluster_size;
-    
-    while (bytes_read < count && current_cluster != 0) {
-        /* Read cluster */
-        uint8_t cluster_data[fat_info->cluster_size];
-        uint32_t sector = fat_cluster_to_sector(fat_info, current_cluster);
+    uint32_t index = pos / fat_info->cluster_size;
+    uint32_t cluster_offset = pos % fat_info->cluster_size;
+    
+    while (bytes_read < count) {
+        uint32_t run;
+        uint32_t cluster = fat_file_cluster(fat_info, inode_info, cursor, index, &run);
+        if (cluster == 0) {
+            if (bytes_read == 0) {
+                return VFS_ERROR_IO_ERROR;
+            }
+            break;  /* Chain shorter than the file size */
+        }
+        
+        uint32_t sector = fat_cluster_to_sector(fat_info, cluster);
+        size_t remaining = count - bytes_read;
         
+        /* Whole clusters: as much of the run as fits, in one request */
+        if (cluster_offset == 0 && remaining >= fat_info->cluster_size) {
+            uint32_t clusters = remaining / fat_info->cluster_size;
+            if (clusters > run) {
+                clusters = run;
+            }
+            
+            if (fat_read_sectors(fat_info, sector, clusters * fat_info->sectors_per_cluster,
+                                 buffer + bytes_read) != FAT_SUCCESS) {
+                return VFS_ERROR_IO_ERROR;
+            }
+            
+            bytes_read += (size_t)clusters * fat_info->cluster_size;
+            index += clusters;
+            continue;
+        }
+        
+        /* Partial cluster at either end of the request */
+        uint8_t cluster_data[fat_info->cluster_size];
         if (fat_read_sectors(fat_info, sector, fat_info->sectors_per_cluster,
                              cluster_data) != FAT_SUCCESS) {
             return VFS_ERROR_IO_ERROR;
         }
         
-        /* Copy data from cluster */
         size_t bytes_to_copy = fat_info->cluster_size - cluster_offset;
-        if (bytes_to_copy > count - bytes_read) {
-            bytes_to_copy = count - bytes_read;
+        if (bytes_to_copy > remaining) {
+            bytes_to_copy = remaining;
         }
         
         memcpy(buffer + bytes_read, cluster_data + cluster_offset, bytes_to_copy);
         bytes_read += bytes_to_copy;
         cluster_offset = 0;  /* Reset offset for subsequent clusters */
-        
-        /* Move to next cluster */
-        current_cluster = fat_next_cluster(fat_info, current_cluster);
+        index++;
     }
     
-    *pos += bytes_read;
     return bytes_read;
 }
 
 /**
- * Write to a FAT file
+ * Write file bytes [pos, pos + count) within the existing file size
  */
-ssize_t fat_write(vfs_file_t* file, const char* buffer, size_t count, uint64_t* pos) {
-    if (!file || !buffer || !pos) {
-        return VFS_ERROR_INVALID_PARAM;
-    }
-    
-    /* For now, implement a simple write that doesn't expand files */
-    /* This is a basic implementation - full implementation would handle file expansion */
-    
-    vfs_inode_t* inode = file->f_inode;
+static ssize_t fat_write_range(vfs_inode_t* inode, fat_cursor_t* cursor,
+                               const char* buffer, size_t count, uint64_t pos) {
     fat_inode_info_t* inode_info = (fat_inode_info_t*)inode->i_private;
-    fat_file_info_t* file_info = (fat_file_info_t*)file->f_private_data;
     fat_fs_info_t* fat_info = (fat_fs_info_t*)inode->i_sb->s_fs_info;
     
-    if (!inode_info || !file_info || !fat_info) {
-        return VFS_ERROR_INVALID_PARAM;
-    }
-    
-    /* Basic write implementation - write within existing file size */
-    if (*pos + count > inode->i_size) {
-        count = inode->i_size > *pos ? inode->i_size - *pos : 0;
+    /* For now, implement a simple write that doesn't expand files */
+    /* This is a basic implementation - full implementation would handle file expansion */
+    if (pos + count > inode->i_size) {
+        count = inode->i_size > pos ? inode->i_size - pos : 0;
     }
     
     if (count == 0) {
@@ -997,19 +1208,14 @@ ssize_t fat_write(vfs_file_t* file, const char* buffer, size_t count, uint64_t*
     }
     
     size_t bytes_written = 0;
-    uint32_t current_cluster = inode_info->first_cluster;
-    
-    /* Skip to the correct cluster for the current position */
-    uint32_t cluster_num = *pos / fat_info->cluster_size;
-    for (uint32_t i = 0; i < cluster_num && current_cluster != 0; i++) {
-        current_cluster = fat_next_cluster(fat_info, current_cluster);
-    }
+    uint32_t index = pos / fat_info->cluster_size;
+    uint32_t current_cluster = fat_file_cluster(fat_info, inode_info, cursor, index, NULL);
     
     if (current_cluster == 0) {
         return VFS_ERROR_IO_ERROR;
     }
     
-    uint32_t cluster_offset = *pos % fat_info->cluster_size;
+    uint32_t cluster_offset = pos % fat_info->cluster_size;
     
     while (bytes_written < count && current_cluster != 0) {
         /* Read cluster first (for partial writes) */
@@ -1039,13 +1245,126 @@ ssize_t fat_write(vfs_file_t* file, const char* buffer, size_t count, uint64_t*
         cluster_offset = 0;  /* Reset offset for subsequent clusters */
         
         /* Move to next cluster */
-        current_cluster = fat_next_cluster(fat_info, current_cluster);
+        current_cluster = fat_file_cluster(fat_info, inode_info, cursor, ++index, NULL);
     }
     
-    *pos += bytes_written;
     return bytes_written;
 }
 
+/**
+ * Read from a FAT file
+ */
+ssize_t fat_read(vfs_file_t* file, char* buffer, size_t count, uint64_t* pos) {
+    if (!file || !buffer || !pos) {
+        return VFS_ERROR_INVALID_PARAM;
+    }
+    
+    vfs_inode_t* inode = file->f_inode;
+    fat_inode_info_t* inode_info = (fat_inode_info_t*)inode->i_private;
+    fat_file_info_t* file_info = (fat_file_info_t*)file->f_private_data;
+    fat_fs_info_t* fat_info = (fat_fs_info_t*)inode->i_sb->s_fs_info;
+    
+    if (!inode_info || !file_info || !fat_info) {
+        return VFS_ERROR_INVALID_PARAM;
+    }
+    
+    ssize_t bytes_read = fat_read_range(inode, &file_info->cursor, buffer, count, *pos);
+    if (bytes_read <= 0) {
+        return bytes_read;
+    }
+    
+    *pos += bytes_read;
+    file_info->file_position = *pos;
+    file_info->current_cluster = file_info->cursor.disk_cluster;
+    file_info->cluster_offset = *pos % fat_info->cluster_size;
+    return bytes_read;
+}
+
+/**
+ * Write to a FAT file
+ */
+ssize_t fat_write(vfs_file_t* file, const char* buffer, size_t count, uint64_t* pos) {
+    if (!file || !buffer || !pos) {
+        return VFS_ERROR_INVALID_PARAM;
+    }
+    
+    vfs_inode_t* inode = file->f_inode;
+    fat_inode_info_t* inode_info = (fat_inode_info_t*)inode->i_private;
+    fat_file_info_t* file_info = (fat_file_info_t*)file->f_private_data;
+    fat_fs_info_t* fat_info = (fat_fs_info_t*)inode->i_sb->s_fs_info;
+    
+    if (!inode_info || !file_info || !fat_info) {
+        return VFS_ERROR_INVALID_PARAM;
+    }
+    
+    ssize_t bytes_written = fat_write_range(inode, &file_info->cursor, buffer, count, *pos);
+    if (bytes_written > 0) {
+        *pos += bytes_written;
+    }
+    return bytes_written;
+}
+
+/* ================================
+ * Page Cache Operations
+ * ================================ */
+
+/**
+ * Fill a page cache page from the file's clusters
+ */
+static int fat_readpage(void* host, uint64_t index, void* page) {
+    return fat_readpages(host, index, 1, page);
+}
+
+/**
+ * Fill consecutive pages for readahead; each cluster run is one read
+ */
+static int fat_readpages(void* host, uint64_t index, uint32_t nr, void* buffer) {
+    vfs_inode_t* inode = (vfs_inode_t*)host;
+    uint64_t pos = index << PAGE_CACHE_SHIFT;
+    if (pos >= inode->i_size) {
+        return FAT_SUCCESS;
+    }
+    
+    fat_cursor_t cursor;
+    fat_cursor_reset(&cursor);
+    uint64_t want = (uint64_t)nr << PAGE_CACHE_SHIFT;
+    size_t count = inode->i_size - pos < want ? inode->i_size - pos : want;
+    if (fat_read_range(inode, &cursor, (char*)buffer, count, pos) != (ssize_t)count) {
+        return FAT_ERROR_IO_ERROR;
+    }
+    return FAT_SUCCESS;
+}
+
+/**
+ * Write a dirty page back to the file's clusters
+ */
+static int fat_writepage(void* host, uint64_t index, const void* page) {
+    vfs_inode_t* inode = (vfs_inode_t*)host;
+    uint64_t pos = index << PAGE_CACHE_SHIFT;
+    if (pos >= inode->i_size) {
+        return FAT_SUCCESS;
+    }
+    
+    fat_cursor_t cursor;
+    fat_cursor_reset(&cursor);
+    size_t count = inode->i_size - pos < PAGE_CACHE_SIZE ? inode->i_size - pos : PAGE_CACHE_SIZE;
+    if (fat_write_range(inode, &cursor, (const char*)page, count, pos) != (ssize_t)count) {
+        return FAT_ERROR_IO_ERROR;
+    }
+    return FAT_SUCCESS;
+}
+
+/**
+ * Files do not grow yet: writes stop at the current size
+ */
+static size_t fat_write_limit(void* host, uint64_t pos, size_t len) {
+    vfs_inode_t* inode = (vfs_inode_t*)host;
+    if (pos >= inode->i_size) {
+        return 0;
+    }
+    return inode->i_size - pos < len ? (size_t)(inode->i_size - pos) : len;
+}
+
 /**
  * Seek in a FAT file
  */
@@ -1070,6 +1389,24 @@ uint64_t fat_llseek(vfs_file_t* file, uint64_t offset, int whence) {
             return VFS_ERROR_INVALID_PARAM;
     }
     
+    /* Move the cursor now so the next read starts without a search */
+    fat_file_info_t* file_info = (fat_file_info_t*)file->f_private_data;
+    vfs_inode_t* inode = file->f_inode;
+    if (file_info && inode && inode->i_private && new_pos < inode->i_size) {
+        fat_fs_info_t* fat_info = (fat_fs_info_t*)inode->i_sb->s_fs_info;
+        if (fat_info && fat_info->cluster_size) {
+            file_info->current_cluster = fat_file_cluster(fat_info,
+                                                          (fat_inode_info_t*)inode->i_private,
+                                                          &file_info->cursor,
+                                                          new_pos / fat_info->cluster_size,
+                                                          NULL);
+            file_info->cluster_offset = new_pos % fat_info->cluster_size;
+        }
+    }
+    if (file_info) {
+        file_info->file_position = new_pos;
+    }
+    
     file->f_pos = new_pos;
     return new_pos;
 }
@@ -0,0 +1,172 @@
+/* IKOS FAT Bitmaps
+ * See include/fat_bitmap.h. Callers serialize access per filesystem.
+ */
+
+#include "fat_bitmap.h"
+
+/**
+ * Initialize with every bit clear
+ */
+void fat_bitmap_init(fat_bitmap_t* bm, uint64_t* words, uint32_t nbits) {
+    if (!bm) {
+        return;
+    }
+    bm->words = words;
+    bm->nbits = nbits;
+    bm->hint = 0;
+    fat_bitmap_reset(bm);
+}
+
+void fat_bitmap_set(fat_bitmap_t* bm, uint32_t bit) {
+    if (!bm || bit >= bm->nbits) {
+        return;
+    }
+    uint64_t mask = 1ULL << (bit % 64);
+    if (!(bm->words[bit / 64] & mask)) {
+        bm->words[bit / 64] |= mask;
+        bm->set_count++;
+    }
+}
+
+void fat_bitmap_clear(fat_bitmap_t* bm, uint32_t bit) {
+    if (!bm || bit >= bm->nbits) {
+        return;
+    }
+    uint64_t mask = 1ULL << (bit % 64);
+    if (bm->words[bit / 64] & mask) {
+        bm->words[bit / 64] &= ~mask;
+        bm->set_count--;
+    }
+}
+
+bool fat_bitmap_test(const fat_bitmap_t* bm, uint32_t bit) {
+    if (!bm || bit >= bm->nbits) {
+        return false;
+    }
+    return (bm->words[bit / 64] >> (bit % 64)) & 1;
+}
+
+/**
+ * Clear every bit
+ */
+void fat_bitmap_reset(fat_bitmap_t* bm) {
+    if (!bm) {
+        return;
+    }
+    for (uint32_t i = 0; i < FAT_BITMAP_WORDS(bm->nbits); i++) {
+        bm->words[i] = 0;
+    }
+    bm->set_count = 0;
+}
+
+/**
+ * First set bit at or after `from`
+ */
+uint32_t fat_bitmap_next_set(const fat_bitmap_t* bm, uint32_t from) {
+    if (!bm || from >= bm->nbits) {
+        return FAT_BITMAP_NONE;
+    }
+
+    uint32_t w = from / 64;
+    uint64_t word = bm->words[w] & (~0ULL << (from % 64));
+    uint32_t nwords = FAT_BITMAP_WORDS(bm->nbits);
+
+    while (!word) {
+        if (++w == nwords) {
+            return FAT_BITMAP_NONE;
+        }
+        word = bm->words[w];
+    }
+
+    uint32_t bit = w * 64 + (uint32_t)__builtin_ctzll(word);
+    return bit < bm->nbits ? bit : FAT_BITMAP_NONE;
+}
+
+/**
+ * First clear bit at or after `from` (nbits if none)
+ */
+static uint32_t next_clear(const fat_bitmap_t* bm, uint32_t from) {
+    if (from >= bm->nbits) {
+        return bm->nbits;
+    }
+
+    uint32_t w = from / 64;
+    uint64_t word = ~bm->words[w] & (~0ULL << (from % 64));
+    uint32_t nwords = FAT_BITMAP_WORDS(bm->nbits);
+
+    while (!word) {
+        if (++w == nwords) {
+            return bm->nbits;
+        }
+        word = ~bm->words[w];
+    }
+
+    uint32_t bit = w * 64 + (uint32_t)__builtin_ctzll(word);
+    return bit < bm->nbits ? bit : bm->nbits;
+}
+
+/**
+ * Next run of set bits at or after `from`
+ */
+uint32_t fat_bitmap_next_run(const fat_bitmap_t* bm, uint32_t from, uint32_t* len) {
+    uint32_t start = fat_bitmap_next_set(bm, from);
+    if (start == FAT_BITMAP_NONE) {
+        if (len) {
+            *len = 0;
+        }
+        return FAT_BITMAP_NONE;
+    }
+    if (len) {
+        *len = next_clear(bm, start) - start;
+    }
+    return start;
+}
+
+/**
+ * Next-fit search for `want` consecutive set bits
+ */
+uint32_t fat_bitmap_find_run(fat_bitmap_t* bm, uint32_t want, uint32_t* got) {
+    if (got) {
+        *got = 0;
+    }
+    if (!bm || want == 0 || bm->set_count == 0) {
+        return FAT_BITMAP_NONE;
+    }
+
+    uint32_t best = FAT_BITMAP_NONE;
+    uint32_t best_len = 0;
+    uint32_t start_at = bm->hint < bm->nbits ? bm->hint : 0;
+
+    /* Hint to the end, then the beginning up to the hint */
+    for (int pass = 0; pass < 2 && best_len < want; pass++) {
+        uint32_t pos = pass == 0 ? start_at : 0;
+        uint32_t limit = pass == 0 ? bm->nbits : start_at;
+
+        while (pos < limit) {
+            uint32_t len;
+            uint32_t run = fat_bitmap_next_run(bm, pos, &len);
+            if (run == FAT_BITMAP_NONE || run >= limit) {
+                break;
+            }
+            if (len > best_len) {
+                best = run;
+                best_len = len;
+                if (best_len >= want) {
+                    break;
+                }
+            }
+            pos = run + len;
+        }
+    }
+
+    if (best == FAT_BITMAP_NONE) {
+        return FAT_BITMAP_NONE;
+    }
+
+    uint32_t take = best_len < want ? best_len : want;
+    bm->hint = best + take;
+    if (got) {
+        *got = take;
+    }
+    return best;
+}
@@ -0,0 +1,167 @@
+/* IKOS FAT Extent Map
+ * See include/fat_extent.h. Callers serialize access per inode.
+ */
+
+#include "fat_extent.h"
+#include "fat.h"
+
+/**
+ * Initialize an empty map
+ */
+void fat_extent_map_init(fat_extent_map_t* map) {
+    if (!map) {
+        return;
+    }
+    map->extents = NULL;
+    map->count = 0;
+    map->total_clusters = 0;
+    map->valid = false;
+}
+
+/**
+ * Count the clusters and runs of a chain, or return false if it is longer
+ * than allowed
+ */
+static bool count_runs(uint32_t first_cluster, uint32_t max_clusters,
+                       const fat_extent_ops_t* ops, uint32_t* runs, uint32_t* clusters) {
+    uint32_t cluster = first_cluster;
+    uint32_t prev = 0;
+    *runs = 0;
+    *clusters = 0;
+
+    while (cluster != 0) {
+        if (*clusters == max_clusters) {
+            return false;
+        }
+        if (*clusters == 0 || cluster != prev + 1) {
+            (*runs)++;
+        }
+        (*clusters)++;
+        prev = cluster;
+        cluster = ops->next_cluster(ops->ctx, cluster);
+    }
+    return true;
+}
+
+/**
+ * Walk the chain into runs
+ */
+int fat_extent_map_build(fat_extent_map_t* map, uint32_t first_cluster,
+                         uint32_t max_clusters, const fat_extent_ops_t* ops) {
+    if (!map || !ops || !ops->next_cluster) {
+        return FAT_ERROR_INVALID_CLUSTER;
+    }
+
+    fat_extent_map_clear(map, ops);
+
+    uint32_t runs, clusters;
+    if (!count_runs(first_cluster, max_clusters, ops, &runs, &clusters)) {
+        return FAT_ERROR_CLUSTER_CHAIN;
+    }
+
+    if (runs > 0) {
+        map->extents = (fat_extent_t*)ops->alloc(runs * sizeof(fat_extent_t));
+        if (!map->extents) {
+            return FAT_ERROR_NO_MEMORY;
+        }
+    }
+
+    uint32_t cluster = first_cluster;
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < clusters; i++) {
+        fat_extent_t* last = n ? &map->extents[n - 1] : NULL;
+        if (last && cluster == last->disk_cluster + last->length) {
+            last->length++;
+        } else {
+            map->extents[n].file_cluster = i;
+            map->extents[n].disk_cluster = cluster;
+            map->extents[n].length = 1;
+            n++;
+        }
+        cluster = ops->next_cluster(ops->ctx, cluster);
+    }
+
+    map->count = n;
+    map->total_clusters = clusters;
+    map->valid = true;
+    return FAT_SUCCESS;
+}
+
+/**
+ * Free the runs and mark the map invalid
+ */
+void fat_extent_map_clear(fat_extent_map_t* map, const fat_extent_ops_t* ops) {
+    if (!map) {
+        return;
+    }
+    if (map->extents && ops && ops->free) {
+        ops->free(map->extents);
+    }
+    fat_extent_map_init(map);
+}
+
+/**
+ * Start a cursor at the beginning of the file
+ */
+void fat_cursor_reset(fat_cursor_t* cursor) {
+    if (!cursor) {
+        return;
+    }
+    cursor->extent = 0;
+    cursor->file_cluster = 0;
+    cursor->disk_cluster = 0;
+}
+
+static bool extent_holds(const fat_extent_t* extent, uint32_t index) {
+    return index >= extent->file_cluster && index - extent->file_cluster < extent->length;
+}
+
+/**
+ * Disk cluster holding file cluster `index`
+ */
+uint32_t fat_extent_lookup(const fat_extent_map_t* map, fat_cursor_t* cursor,
+                           uint32_t index, uint32_t* run) {
+    if (!map || !map->valid || index >= map->total_clusters) {
+        return 0;
+    }
+
+    uint32_t e = map->count;
+
+    /* Same run as last time, or the one after it: sequential access */
+    if (cursor && cursor->extent < map->count) {
+        if (extent_holds(&map->extents[cursor->extent], index)) {
+            e = cursor->extent;
+        } else if (cursor->extent + 1 < map->count &&
+                   extent_holds(&map->extents[cursor->extent + 1], index)) {
+            e = cursor->extent + 1;
+        }
+    }
+
+    /* Otherwise the last run starting at or before index */
+    if (e == map->count) {
+        uint32_t lo = 0, hi = map->count;
+        while (hi - lo > 1) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (map->extents[mid].file_cluster <= index) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        e = lo;
+    }
+
+    const fat_extent_t* extent = &map->extents[e];
+    uint32_t offset = index - extent->file_cluster;
+    uint32_t disk_cluster = extent->disk_cluster + offset;
+
+    if (run) {
+        *run = extent->length - offset;
+    }
+    if (cursor) {
+        cursor->extent = e;
+        cursor->file_cluster = index;
+        cursor->disk_cluster = disk_cluster;
+    }
+    return disk_cluster;
+}
@@ -0,0 +1,180 @@
+/* IKOS Threading - Futex wait queues
+ *
+ * See include/futex.h. Each bucket is protected by its own spinlock; no
+ * operation ever holds two bucket locks.
+ */
+
+#include "futex.h"
+
+static inline void bucket_lock(futex_bucket_t* bucket) {
+    while (__sync_lock_test_and_set(&bucket->lock, 1)) {
+        __asm__ volatile("pause");
+    }
+}
+
+static inline void bucket_unlock(futex_bucket_t* bucket) {
+    __sync_lock_release(&bucket->lock);
+}
+
+static inline bool waiter_matches(const futex_waiter_t* w, uint64_t space, uint64_t addr) {
+    return w->space == space && w->addr == addr;
+}
+
+static void bucket_unlink(futex_bucket_t* bucket, futex_waiter_t* waiter) {
+    if (waiter->prev) {
+        waiter->prev->next = waiter->next;
+    } else {
+        bucket->head = waiter->next;
+    }
+    if (waiter->next) {
+        waiter->next->prev = waiter->prev;
+    } else {
+        bucket->tail = waiter->prev;
+    }
+    waiter->next = waiter->prev = 0;
+    waiter->queued = false;
+    bucket->count--;
+}
+
+static void bucket_link(futex_bucket_t* bucket, futex_waiter_t* waiter,
+                        uint64_t space, uint64_t addr, void* owner) {
+    waiter->space = space;
+    waiter->addr = addr;
+    waiter->owner = owner;
+    waiter->bucket = bucket;
+    waiter->next = 0;
+    waiter->prev = bucket->tail;
+    if (bucket->tail) {
+        bucket->tail->next = waiter;
+    } else {
+        bucket->head = waiter;
+    }
+    bucket->tail = waiter;
+    waiter->queued = true;
+    bucket->count++;
+}
+
+void futex_table_init(futex_table_t* table) {
+    if (!table) {
+        return;
+    }
+    for (uint32_t i = 0; i < FUTEX_HASH_SIZE; i++) {
+        table->buckets[i].lock = 0;
+        table->buckets[i].count = 0;
+        table->buckets[i].head = 0;
+        table->buckets[i].tail = 0;
+    }
+    table->stats = (futex_stats_t){0};
+}
+
+futex_bucket_t* futex_hash(futex_table_t* table, uint64_t space, uint64_t addr) {
+    /* Words are 4-byte aligned; mix the space in so equal addresses in
+     * different processes land in different buckets. */
+    uint64_t key = (addr >> 2) ^ (space * 0x9E3779B97F4A7C15ULL);
+    key *= 0x9E3779B97F4A7C15ULL;
+    return &table->buckets[key >> (64 - FUTEX_HASH_BITS)];
+}
+
+int futex_queue(futex_table_t* table, futex_waiter_t* waiter, uint64_t space,
+                uint64_t addr, const volatile uint32_t* word, uint32_t expected,
+                void* owner) {
+    if (!table || !waiter || !word || (addr & 3)) {
+        return FUTEX_ERR_PARAM;
+    }
+
+    futex_bucket_t* bucket = futex_hash(table, space, addr);
+    bucket_lock(bucket);
+
+    /* The waker changes the word before taking this lock, so reading it
+     * under the lock decides the race: either we see the new value and
+     * back out, or we are queued before the wake looks. */
+    if (*word != expected) {
+        table->stats.wait_again++;
+        bucket_unlock(bucket);
+        return FUTEX_ERR_AGAIN;
+    }
+
+    bucket_link(bucket, waiter, space, addr, owner);
+    table->stats.waits++;
+
+    bucket_unlock(bucket);
+    return FUTEX_OK;
+}
+
+void futex_enqueue(futex_table_t* table, futex_waiter_t* waiter, uint64_t space,
+                   uint64_t addr, void* owner) {
+    if (!table || !waiter || waiter->queued) {
+        return;
+    }
+
+    futex_bucket_t* bucket = futex_hash(table, space, addr);
+    bucket_lock(bucket);
+    bucket_link(bucket, waiter, space, addr, owner);
+    table->stats.requeues++;
+    bucket_unlock(bucket);
+}
+
+bool futex_unqueue(futex_table_t* table, futex_waiter_t* waiter) {
+    if (!table || !waiter || !waiter->bucket) {
+        return false;
+    }
+
+    futex_bucket_t* bucket = waiter->bucket;
+    bucket_lock(bucket);
+    bool was_queued = waiter->queued;
+    if (was_queued) {
+        bucket_unlink(bucket, waiter);
+    }
+    bucket_unlock(bucket);
+    return was_queued;
+}
+
+uint32_t futex_wake(futex_table_t* table, uint64_t space, uint64_t addr,
+                    uint32_t count, futex_wake_fn wake) {
+    if (!table || count == 0) {
+        return 0;
+    }
+
+    futex_bucket_t* bucket = futex_hash(table, space, addr);
+    uint32_t woken = 0;
+
+    bucket_lock(bucket);
+    futex_waiter_t* w = bucket->head;
+    while (w && woken < count) {
+        futex_waiter_t* next = w->next;
+        if (waiter_matches(w, space, addr)) {
+            bucket_unlink(bucket, w);
+            if (wake) {
+                wake(w->owner);
+            }
+            woken++;
+        }
+        w = next;
+    }
+    if (woken) {
+        table->stats.wakes += woken;
+    } else {
+        table->stats.empty_wakes++;
+    }
+    bucket_unlock(bucket);
+
+    return woken;
+}
+
+uint32_t futex_waiters(futex_table_t* table, uint64_t space, uint64_t addr) {
+    if (!table) {
+        return 0;
+    }
+
+    futex_bucket_t* bucket = futex_hash(table, space, addr);
+    uint32_t n = 0;
+
+    bucket_lock(bucket);
+    for (futex_waiter_t* w = bucket->head; w; w = w->next) {
+        if (waiter_matches(w, space, addr)) {
+            n++;
+        }
+    }
+    bucket_unlock(bucket);
+    return n;
+}
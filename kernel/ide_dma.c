@@ -0,0 +1,219 @@
+/* IKOS IDE DMA
+ * See include/ide_dma.h.
+ */
+
+#include "ide_dma.h"
+
+#define IDE_DMA_SECTOR_SIZE     512
+
+/* ================================
+ * PRD tables
+ * ================================ */
+
+int ide_dma_build_prd(ide_prd_t* prd, uint32_t max, const void* buffer, uint32_t bytes,
+                      const ide_dma_ops_t* ops) {
+    if (!prd || !buffer || !ops || !ops->virt_to_phys || bytes == 0 || max == 0) {
+        return IDE_DMA_EINVAL;
+    }
+    /* The bus master moves words */
+    if (((uintptr_t)buffer & 1) || (bytes & 1)) {
+        return IDE_DMA_ERANGE;
+    }
+
+    uint32_t used = 0;
+    uint64_t start = 0;             /* Open entry: physical start and length */
+    uint32_t length = 0;
+    uint32_t offset = 0;
+
+    while (offset < bytes) {
+        const uint8_t* virt = (const uint8_t*)buffer + offset;
+        uint32_t chunk = IDE_DMA_PAGE_SIZE - (uint32_t)((uintptr_t)virt & (IDE_DMA_PAGE_SIZE - 1));
+        if (chunk > bytes - offset) {
+            chunk = bytes - offset;
+        }
+
+        uint64_t phys = ops->virt_to_phys(ops->ctx, virt);
+        if (phys == IDE_DMA_NO_PHYS || phys + chunk > 0x100000000ULL) {
+            return IDE_DMA_ERANGE;
+        }
+
+        /* A chunk lies within one frame, so it never crosses 64 KiB itself;
+         * it extends the open entry when it follows on in the same 64 KiB */
+        bool extends = length > 0 && start + length == phys &&
+                       (start / IDE_DMA_PRD_BOUNDARY) == ((phys + chunk - 1) / IDE_DMA_PRD_BOUNDARY);
+        if (extends) {
+            length += chunk;
+        } else {
+            if (length > 0) {
+                if (used == max) {
+                    return IDE_DMA_ERANGE;
+                }
+                prd[used].phys = (uint32_t)start;
+                prd[used].bytes = (uint16_t)length;     /* 64 KiB wraps to 0 */
+                prd[used].flags = 0;
+                used++;
+            }
+            start = phys;
+            length = chunk;
+        }
+        offset += chunk;
+    }
+
+    if (used == max) {
+        return IDE_DMA_ERANGE;
+    }
+    prd[used].phys = (uint32_t)start;
+    prd[used].bytes = (uint16_t)length;
+    prd[used].flags = IDE_DMA_PRD_EOT;
+    return (int)(used + 1);
+}
+
+/* ================================
+ * Request queue
+ * ================================ */
+
+void ide_dma_channel_init(ide_dma_channel_t* ch, ide_prd_t* prd, uint32_t prd_phys, bool enabled,
+                          const ide_dma_ops_t* ops) {
+    if (!ch || !ops) {
+        return;
+    }
+    ch->prd = prd;
+    ch->prd_phys = prd_phys;
+    ch->enabled = enabled && prd != NULL;
+    ch->dispatching = false;
+    ch->defer_pio = false;
+    ch->active = NULL;
+    ch->pio = NULL;
+    ch->pio_running = false;
+    ch->head = NULL;
+    ch->tail = NULL;
+    ch->ops = *ops;
+    ch->stats = (ide_dma_stats_t){ 0 };
+}
+
+static void complete_request(ide_dma_channel_t* ch, ide_dma_request_t* req, int status) {
+    req->status = status;
+    if (status == IDE_DMA_OK) {
+        ch->stats.bytes += (uint64_t)req->count * IDE_DMA_SECTOR_SIZE;
+    } else {
+        ch->stats.errors++;
+    }
+    req->complete = true;
+    if (req->done) {
+        req->done(req);
+    }
+}
+
+/* Try to put `req` on the bus master; false sends it to PIO */
+static bool start_dma(ide_dma_channel_t* ch, ide_dma_request_t* req) {
+    if (!ch->enabled || !ch->ops.start || !ch->ops.finish) {
+        return false;
+    }
+    int entries = ide_dma_build_prd(ch->prd, IDE_DMA_PRD_MAX, req->buffer,
+                                    (uint32_t)req->count * IDE_DMA_SECTOR_SIZE, &ch->ops);
+    if (entries < 0) {
+        return false;
+    }
+    if (ch->ops.start(ch->ops.ctx, req, ch->prd_phys) != IDE_DMA_OK) {
+        return false;
+    }
+    ch->stats.dma_requests++;
+    ch->stats.prd_entries += (uint64_t)entries;
+    return true;
+}
+
+/**
+ * Start queued requests until one is left running on the bus master.
+ * Completion callbacks may submit more; those only queue while we loop.
+ */
+static void start_next(ide_dma_channel_t* ch) {
+    ch->dispatching = true;
+    while (!ch->active && !ch->pio && ch->head) {
+        ide_dma_request_t* req = ch->head;
+        ch->head = req->next;
+        if (!ch->head) {
+            ch->tail = NULL;
+        }
+        req->next = NULL;
+
+        if (start_dma(ch, req)) {
+            ch->active = req;
+            break;
+        }
+
+        req->used_pio = true;
+        ch->stats.pio_requests++;
+        if (ch->defer_pio) {
+            ch->pio = req;
+            break;
+        }
+        int status = ch->ops.pio ? ch->ops.pio(ch->ops.ctx, req) : IDE_DMA_EIO;
+        complete_request(ch, req, status == IDE_DMA_OK ? IDE_DMA_OK : IDE_DMA_EIO);
+    }
+    ch->dispatching = false;
+}
+
+int ide_dma_submit(ide_dma_channel_t* ch, ide_dma_request_t* req) {
+    if (!ch || !req || !req->buffer || req->drive > 1 || req->count == 0 ||
+        req->count > IDE_DMA_MAX_SECTORS) {
+        return IDE_DMA_EINVAL;
+    }
+
+    req->next = NULL;
+    req->status = IDE_DMA_OK;
+    req->used_pio = false;
+    req->complete = false;
+    if (ch->tail) {
+        ch->tail->next = req;
+    } else {
+        ch->head = req;
+    }
+    ch->tail = req;
+
+    if (!ch->active && !ch->pio && !ch->dispatching) {
+        start_next(ch);
+    }
+    return IDE_DMA_OK;
+}
+
+void ide_dma_interrupt(ide_dma_channel_t* ch) {
+    if (!ch) {
+        return;
+    }
+    ide_dma_request_t* req = ch->active;
+    if (!req) {
+        ch->stats.spurious++;
+        return;
+    }
+
+    int status = ch->ops.finish(ch->ops.ctx, req);
+    ch->active = NULL;
+    complete_request(ch, req, status == IDE_DMA_OK ? IDE_DMA_OK : IDE_DMA_EIO);
+    if (!ch->dispatching) {
+        start_next(ch);
+    }
+}
+
+ide_dma_request_t* ide_dma_pio_take(ide_dma_channel_t* ch) {
+    if (!ch || !ch->pio || ch->pio_running) {
+        return NULL;
+    }
+    ch->pio_running = true;
+    return ch->pio;
+}
+
+void ide_dma_pio_done(ide_dma_channel_t* ch, ide_dma_request_t* req, int status) {
+    if (!ch || !req || ch->pio != req || !ch->pio_running) {
+        return;
+    }
+    ch->pio = NULL;
+    ch->pio_running = false;
+    complete_request(ch, req, status == IDE_DMA_OK ? IDE_DMA_OK : IDE_DMA_EIO);
+    if (!ch->dispatching) {
+        start_next(ch);
+    }
+}
+
+bool ide_dma_busy(const ide_dma_channel_t* ch) {
+    return ch && (ch->active || ch->pio || ch->head);
+}
@@ -8,6 +8,9 @@
 #include "ide_driver.h"
 #include "device_manager.h"
 #include "memory.h"
+#include "timer_wheel.h"
+#include "pci.h"
+#include "vmm.h"
 #include <string.h>
 
 /* ================================
@@ -17,6 +20,10 @@
 static bool g_ide_driver_initialized = false;
 static ide_stats_t g_ide_stats = {0};
 static ide_device_t* g_ide_devices[4] = {0}; /* Primary master/slave, Secondary master/slave */
+static ide_device_t* g_ide_irq_devices[2] = {0}; /* Channels completing DMA by IRQ */
+
+/* PRD tables, one per channel; 512-byte aligned so none crosses 64 KiB */
+static ide_prd_t g_ide_prd_tables[2][IDE_DMA_PRD_MAX] __attribute__((aligned(512)));
 
 /* ================================
  * Low-level I/O Functions
@@ -32,6 +39,10 @@ static inline uint8_t inb(uint16_t port) {
     return data;
 }
 
+static inline void outl(uint16_t port, uint32_t data) {
+    __asm__ volatile("outl %0, %1" : : "a"(data), "Nd"(port));
+}
+
 static inline void outw(uint16_t port, uint16_t data) {
     __asm__ volatile("outw %0, %1" : : "a"(data), "Nd"(port));
 }
@@ -47,6 +58,17 @@ static void debug_print(const char* format, ...) {
     (void)format;
 }
 
+/* Interrupts off around channel state shared with the IRQ */
+static inline uint64_t ide_irq_save(void) {
+    uint64_t flags;
+    __asm__ volatile("pushfq; popq %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+static inline void ide_irq_restore(uint64_t flags) {
+    __asm__ volatile("pushq %0; popfq" : : "r"(flags) : "memory", "cc");
+}
+
 /* Simple delay function */
 static void ide_delay(void) {
     for (volatile int i = 0; i < 4; i++) {
@@ -116,9 +138,12 @@ void ide_write_data(ide_device_t* ide_dev, uint16_t value) {
 int ide_wait_ready(ide_device_t* ide_dev, uint32_t timeout_ms) {
     if (!ide_dev) return IDE_ERROR_INVALID_PARAM;
     
+    /* Bounded by the kernel clock; the iteration count is a backstop for
+     * polling before the timer interrupt is running */
+    uint64_t deadline = ktimer_now() + ktimer_ms_to_ticks(timeout_ms);
     uint32_t timeout = timeout_ms * 1000; /* Convert to microseconds */
     
-    while (timeout-- > 0) {
+    while (timeout-- > 0 && ktimer_now() <= deadline) {
         uint8_t status = ide_read_reg(ide_dev, IDE_REG_STATUS);
         
         if (!(status & IDE_STATUS_BSY) && (status & IDE_STATUS_DRDY)) {
@@ -138,9 +163,10 @@ int ide_wait_ready(ide_device_t* ide_dev, uint32_t timeout_ms) {
 int ide_wait_drq(ide_device_t* ide_dev, uint32_t timeout_ms) {
     if (!ide_dev) return IDE_ERROR_INVALID_PARAM;
     
+    uint64_t deadline = ktimer_now() + ktimer_ms_to_ticks(timeout_ms);
     uint32_t timeout = timeout_ms * 1000;
     
-    while (timeout-- > 0) {
+    while (timeout-- > 0 && ktimer_now() <= deadline) {
         uint8_t status = ide_read_reg(ide_dev, IDE_REG_STATUS);
         
         if (status & IDE_STATUS_ERR) {
@@ -534,6 +560,256 @@ int ide_flush_cache(ide_device_t* ide_dev, uint8_t drive) {
     return IDE_SUCCESS;
 }
 
+/* ================================
+ * Bus-Master DMA
+ * ================================ */
+
+static uint64_t ide_dma_hw_virt_to_phys(void* ctx, const void* addr) {
+    (void)ctx;
+    uint64_t phys = vmm_get_physical_addr(vmm_get_current_space(), (uint64_t)(uintptr_t)addr);
+    return phys ? phys : IDE_DMA_NO_PHYS;
+}
+
+/**
+ * Program the bus master and issue READ DMA / WRITE DMA
+ */
+static int ide_dma_hw_start(void* ctx, const ide_dma_request_t* req, uint32_t prd_phys) {
+    ide_device_t* ide_dev = (ide_device_t*)ctx;
+    const ide_drive_info_t* info = &ide_dev->drives[req->drive];
+    if (!ide_dev->bm_base || !info->present || !info->dma_supported) {
+        return IDE_DMA_EINVAL;
+    }
+    
+    uint16_t bm = ide_dev->bm_base;
+    uint8_t direction = req->write ? 0 : IDE_BM_CMD_READ;
+    outb(bm + IDE_BM_REG_COMMAND, 0);
+    outl(bm + IDE_BM_REG_PRDT, prd_phys);
+    outb(bm + IDE_BM_REG_STATUS, IDE_BM_STATUS_ERROR | IDE_BM_STATUS_IRQ);
+    outb(bm + IDE_BM_REG_COMMAND, direction);
+    
+    if (ide_setup_lba(ide_dev, req->drive, req->lba, req->count) != IDE_SUCCESS) {
+        return IDE_DMA_EINVAL;
+    }
+    if (ide_wait_ready(ide_dev, 1000) != IDE_SUCCESS) {
+        return IDE_DMA_EIO;
+    }
+    
+    /* The drive raises its IRQ when the transfer is done */
+    ide_write_ctrl(ide_dev, 0);
+    ide_write_reg(ide_dev, IDE_REG_COMMAND, req->write ? IDE_CMD_WRITE_DMA : IDE_CMD_READ_DMA);
+    outb(bm + IDE_BM_REG_COMMAND, direction | IDE_BM_CMD_START);
+    return IDE_DMA_OK;
+}
+
+/**
+ * Stop the bus master after its interrupt and collect the outcome
+ */
+static int ide_dma_hw_finish(void* ctx, const ide_dma_request_t* req) {
+    ide_device_t* ide_dev = (ide_device_t*)ctx;
+    uint16_t bm = ide_dev->bm_base;
+    
+    uint8_t bm_status = inb(bm + IDE_BM_REG_STATUS);
+    outb(bm + IDE_BM_REG_COMMAND, 0);
+    /* Reading the status register also acknowledges the drive's IRQ */
+    uint8_t status = ide_read_reg(ide_dev, IDE_REG_STATUS);
+    outb(bm + IDE_BM_REG_STATUS, IDE_BM_STATUS_ERROR | IDE_BM_STATUS_IRQ);
+    
+    if ((bm_status & (IDE_BM_STATUS_ERROR | IDE_BM_STATUS_ACTIVE)) ||
+        (status & (IDE_STATUS_ERR | IDE_STATUS_DF))) {
+        g_ide_stats.dma_errors++;
+        if (req->write) {
+            g_ide_stats.write_errors++;
+        } else {
+            g_ide_stats.read_errors++;
+        }
+        return IDE_DMA_EIO;
+    }
+    
+    g_ide_stats.dma_transfers++;
+    if (req->write) {
+        g_ide_stats.total_writes++;
+        g_ide_stats.bytes_written += req->count * 512;
+    } else {
+        g_ide_stats.total_reads++;
+        g_ide_stats.bytes_read += req->count * 512;
+    }
+    return IDE_DMA_OK;
+}
+
+static int ide_dma_hw_pio(void* ctx, ide_dma_request_t* req) {
+    ide_device_t* ide_dev = (ide_device_t*)ctx;
+    int rc = req->write
+        ? ide_write_sectors(ide_dev, req->drive, req->lba, req->count, req->buffer)
+        : ide_read_sectors(ide_dev, req->drive, req->lba, req->count, req->buffer);
+    return rc == IDE_SUCCESS ? IDE_DMA_OK : IDE_DMA_EIO;
+}
+
+static const ide_dma_ops_t ide_dma_hw_ops = {
+    .virt_to_phys = ide_dma_hw_virt_to_phys,
+    .start = ide_dma_hw_start,
+    .finish = ide_dma_hw_finish,
+    .pio = ide_dma_hw_pio,
+    .ctx = NULL,
+};
+
+/**
+ * Use the bus master at bm_base (already offset for the channel)
+ */
+int ide_enable_dma(ide_device_t* ide_dev, uint16_t bm_base) {
+    if (!ide_dev || !ide_dev->initialized || bm_base == 0) {
+        return IDE_ERROR_INVALID_PARAM;
+    }
+    if (ide_dma_busy(&ide_dev->dma)) {
+        return IDE_ERROR_NOT_READY;
+    }
+    
+    uint32_t channel = ide_dev->controller.is_primary ? 0 : 1;
+    ide_prd_t* prd = g_ide_prd_tables[channel];
+    uint64_t prd_phys = ide_dma_hw_virt_to_phys(NULL, prd);
+    if (prd_phys == IDE_DMA_NO_PHYS || prd_phys >= 0x100000000ULL) {
+        return IDE_ERROR_IO_ERROR;
+    }
+    
+    ide_dev->bm_base = bm_base;
+    ide_dma_ops_t ops = ide_dma_hw_ops;
+    ops.ctx = ide_dev;
+    ide_dma_channel_init(&ide_dev->dma, prd, (uint32_t)prd_phys, true, &ops);
+    ide_dev->dma.defer_pio = true;
+    g_ide_irq_devices[channel] = ide_dev;
+    
+    /* Let the drive interrupt; PIO commands poll and ignore it */
+    ide_write_ctrl(ide_dev, 0);
+    debug_print("IDE: Bus-master DMA at 0x%x\n", bm_base);
+    return IDE_SUCCESS;
+}
+
+/**
+ * Find the PCI IDE function, enable bus mastering and use it for this channel
+ */
+int ide_setup_dma(ide_device_t* ide_dev) {
+    if (!ide_dev || !ide_dev->initialized) {
+        return IDE_ERROR_INVALID_PARAM;
+    }
+    
+    for (uint8_t slot = 0; slot < 32; slot++) {
+        for (uint8_t function = 0; function < 8; function++) {
+            if (!pci_device_exists(0, slot, function)) {
+                continue;
+            }
+            pci_device_info_t info;
+            if (pci_get_device_info(0, slot, function, &info) != PCI_SUCCESS ||
+                info.class_code != IDE_PCI_CLASS || info.subclass != IDE_PCI_SUBCLASS) {
+                continue;
+            }
+            
+            uint64_t bm = pci_get_bar_address(&info, IDE_PCI_BM_BAR);
+            if (bm == 0 || !pci_is_bar_io(&info, IDE_PCI_BM_BAR)) {
+                return IDE_ERROR_NOT_READY;
+            }
+            pci_set_bus_master(&info, true);
+            if (!ide_dev->controller.is_primary) {
+                bm += IDE_BM_SECONDARY;
+            }
+            return ide_enable_dma(ide_dev, (uint16_t)bm);
+        }
+    }
+    return IDE_ERROR_NOT_READY;
+}
+
+/* Run the channel's parked PIO requests with interrupts on: up to 256
+ * sectors through the data port is far too long to hold them off */
+static void ide_run_pio(ide_device_t* ide_dev) {
+    for (;;) {
+        uint64_t flags = ide_irq_save();
+        ide_dma_request_t* req = ide_dma_pio_take(&ide_dev->dma);
+        ide_irq_restore(flags);
+        if (!req) {
+            return;
+        }
+        
+        int status = ide_dma_hw_pio(ide_dev, req);
+        flags = ide_irq_save();
+        ide_dma_pio_done(&ide_dev->dma, req, status);
+        ide_irq_restore(flags);
+    }
+}
+
+/**
+ * Queue a transfer; it completes from the IRQ, or at once by PIO
+ */
+int ide_submit(ide_device_t* ide_dev, ide_dma_request_t* req) {
+    if (!ide_dev || !req || req->drive > 1) {
+        return IDE_ERROR_INVALID_PARAM;
+    }
+    if (!ide_dev->drives[req->drive].present) {
+        return IDE_ERROR_NO_DRIVE;
+    }
+    
+    uint64_t flags = ide_irq_save();
+    int rc = ide_dma_submit(&ide_dev->dma, req);
+    ide_irq_restore(flags);
+    ide_run_pio(ide_dev);
+    return rc == IDE_DMA_OK ? IDE_SUCCESS : IDE_ERROR_INVALID_PARAM;
+}
+
+/* Complete the channel's transfer if the bus master says it is done */
+static void ide_dma_poll(ide_device_t* ide_dev, bool force) {
+    uint64_t flags = ide_irq_save();
+    if (ide_dev->dma.active &&
+        (force || (inb(ide_dev->bm_base + IDE_BM_REG_STATUS) & IDE_BM_STATUS_IRQ))) {
+        ide_dma_interrupt(&ide_dev->dma);
+    }
+    ide_irq_restore(flags);
+}
+
+/**
+ * Wait for a submitted request. The bus master moves the data; this only
+ * watches for completion, in case the IRQ is masked or not routed.
+ */
+int ide_wait_request(ide_device_t* ide_dev, ide_dma_request_t* req) {
+    if (!ide_dev || !req) {
+        return IDE_ERROR_INVALID_PARAM;
+    }
+    
+    /* Bounded by the kernel clock; the iteration count is a backstop for
+     * waiting before the timer interrupt is running */
+    uint64_t deadline = ktimer_now() + ktimer_ms_to_ticks(5000);
+    uint32_t timeout = 5000 * 1000;
+    while (!req->complete) {
+        if (ktimer_now() > deadline || timeout-- == 0) {
+            /* Give up on the active transfer; finish reports the failure */
+            ide_dma_poll(ide_dev, true);
+            if (!req->complete) {
+                return IDE_ERROR_TIMEOUT;
+            }
+            break;
+        }
+        /* The IRQ may have parked a request for PIO behind ours */
+        ide_run_pio(ide_dev);
+        ide_dma_poll(ide_dev, false);
+        __asm__ volatile("pause");
+    }
+    return req->status == IDE_DMA_OK ? IDE_SUCCESS : IDE_ERROR_IO_ERROR;
+}
+
+/**
+ * Channel interrupt: complete the active transfer and start the next
+ */
+void ide_irq(uint8_t irq) {
+    ide_device_t* ide_dev = g_ide_irq_devices[irq == 15 ? 1 : 0];
+    if (!ide_dev) {
+        return;
+    }
+    if (!ide_dev->dma.active) {
+        /* A PIO command's interrupt: acknowledge the drive */
+        ide_read_reg(ide_dev, IDE_REG_STATUS);
+        return;
+    }
+    if (inb(ide_dev->bm_base + IDE_BM_REG_STATUS) & IDE_BM_STATUS_IRQ) {
+        ide_dma_interrupt(&ide_dev->dma);
+    }
+}
+
 /* ================================
  * Controller Management
  * ================================ */
@@ -552,6 +828,13 @@ int ide_init_controller(ide_device_t* ide_dev, uint16_t io_base, uint16_t ctrl_b
     ide_dev->controller.irq = irq;
     ide_dev->controller.is_primary = (io_base == IDE_PRIMARY_BASE);
     
+    /* PIO only until ide_setup_dma() finds a bus master */
+    ide_dev->bm_base = 0;
+    ide_dma_ops_t ops = ide_dma_hw_ops;
+    ops.ctx = ide_dev;
+    ide_dma_channel_init(&ide_dev->dma, NULL, 0, false, &ops);
+    ide_dev->dma.defer_pio = true;
+    
     /* Reset controller */
     ide_reset_controller(ide_dev);
     
@@ -17,6 +17,7 @@ void handle_page_fault(interrupt_frame_t* frame);
 void handle_general_protection_fault(interrupt_frame_t* frame);
 void handle_double_fault(interrupt_frame_t* frame);
 char scancode_to_ascii(uint8_t scancode);
+void ide_irq(uint8_t irq);
 void debug_print(const char* format, ...);
 
 /* Timer interrupt counter */
@@ -155,6 +156,11 @@ void handle_irq(interrupt_frame_t* frame) {
             handle_keyboard_irq(frame);
             break;
             
+        case IRQ_PRIMARY_ATA:
+        case IRQ_SECONDARY_ATA:
+            ide_irq(irq_no);
+            break;
+            
         default:
             debug_print("Unhandled IRQ: %d\n", irq_no);
             break;
@@ -0,0 +1,272 @@
+/* IKOS LZ4 block codec
+ *
+ * See include/lz4.h. Implements the LZ4 block format:
+ *
+ *   sequence := token [literal-length-ext] literals offset [match-length-ext]
+ *   token    := (literal length : 4 bits) << 4 | (match length - 4 : 4 bits)
+ *
+ * A 4-bit field of 15 is continued by bytes of 255 and a final byte < 255.
+ * The last sequence carries literals only. Per the format, the last match
+ * must start at least MFLIMIT bytes before the end of the input and the last
+ * LASTLITERALS bytes are always literals.
+ */
+
+#include "lz4.h"
+
+#define MINMATCH        4
+#define LASTLITERALS    5
+#define MFLIMIT         12
+#define ML_BITS         4
+#define ML_MASK         ((1U << ML_BITS) - 1)
+#define RUN_MASK        ((1U << (8 - ML_BITS)) - 1)
+#define SKIP_TRIGGER    6       /* Start skipping ahead after 2^6 misses */
+#define WILDCOPY_SLACK  8
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    __builtin_memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash4(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+static inline void copy_bytes(uint8_t* d, const uint8_t* s, size_t n) {
+    while (n--) {
+        *d++ = *s++;
+    }
+}
+
+/* Copy in 8-byte strides up to e; may write up to 7 bytes past e. Safe for
+ * overlapping match copies as long as d - s >= 8. */
+static inline void wildcopy8(uint8_t* d, const uint8_t* s, const uint8_t* e) {
+    do {
+        __builtin_memcpy(d, s, 8);
+        d += 8;
+        s += 8;
+    } while (d < e);
+}
+
+/* Emit a length continuation (value already reduced by the 4-bit field). */
+static inline uint8_t* write_length(uint8_t* op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+/* ========================== Compression ========================== */
+
+int lz4_compress_block(const void* src, size_t src_size,
+                       void* dst, size_t dst_capacity,
+                       lz4_workmem_t* workmem) {
+    if (!src || !dst || !workmem || src_size > LZ4_MAX_INPUT_SIZE) {
+        return LZ4_ERROR_INVALID;
+    }
+
+    const uint8_t* const base = (const uint8_t*)src;
+    const uint8_t* const iend = base + src_size;
+    const uint8_t* ip = base;
+    const uint8_t* anchor = base;
+    uint8_t* const ostart = (uint8_t*)dst;
+    uint8_t* const oend = ostart + dst_capacity;
+    uint8_t* op = ostart;
+    size_t lit;
+
+    if (src_size < MFLIMIT + 1) {
+        goto last_literals;   /* Too short to hold a match */
+    }
+
+    const uint8_t* const mflimit = iend - MFLIMIT;
+    const uint8_t* const matchlimit = iend - LASTLITERALS;
+    uint16_t* const table = workmem->table;
+
+    /* Stale table entries are harmless: every candidate is verified against
+     * the input and must lie strictly before ip. */
+    table[hash4(read32(ip))] = 0;
+    ip++;
+
+    for (;;) {
+        const uint8_t* ref;
+        uint32_t attempts = 1U << SKIP_TRIGGER;
+
+        /* Find a 4-byte match, stepping faster through incompressible data. */
+        for (;;) {
+            if (ip > mflimit) {
+                goto last_literals;
+            }
+            uint32_t seq = read32(ip);
+            uint32_t h = hash4(seq);
+            ref = base + table[h];
+            table[h] = (uint16_t)(ip - base);
+            if (ref < ip && read32(ref) == seq) {
+                break;
+            }
+            ip += attempts++ >> SKIP_TRIGGER;
+        }
+
+        /* Extend the match backwards into pending literals. */
+        while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+            ip--;
+            ref--;
+        }
+
+        /* Token, literal run and offset. */
+        lit = (size_t)(ip - anchor);
+        if ((size_t)(oend - op) < 1 + lit / 255 + 1 + lit + 2) {
+            return LZ4_ERROR_NOSPACE;
+        }
+        uint8_t* token = op++;
+        if (lit >= RUN_MASK) {
+            *token = (uint8_t)(RUN_MASK << ML_BITS);
+            op = write_length(op, lit - RUN_MASK);
+        } else {
+            *token = (uint8_t)(lit << ML_BITS);
+        }
+        copy_bytes(op, anchor, lit);
+        op += lit;
+
+        uint16_t offset = (uint16_t)(ip - ref);
+        *op++ = (uint8_t)(offset & 0xFF);
+        *op++ = (uint8_t)(offset >> 8);
+
+        /* Extend the match forwards; the last LASTLITERALS bytes stay literal. */
+        const uint8_t* mp = ip + MINMATCH;
+        const uint8_t* rp = ref + MINMATCH;
+        while (mp < matchlimit && *mp == *rp) {
+            mp++;
+            rp++;
+        }
+        size_t ml = (size_t)(mp - ip) - MINMATCH;
+        if (ml >= ML_MASK) {
+            if ((size_t)(oend - op) < 1 + (ml - ML_MASK) / 255) {
+                return LZ4_ERROR_NOSPACE;
+            }
+            *token |= (uint8_t)ML_MASK;
+            op = write_length(op, ml - ML_MASK);
+        } else {
+            *token |= (uint8_t)ml;
+        }
+
+        ip = mp;
+        anchor = ip;
+        if (ip > mflimit) {
+            break;
+        }
+
+        /* Seed the table with a position inside the match just emitted. */
+        table[hash4(read32(ip - 2))] = (uint16_t)(ip - 2 - base);
+    }
+
+last_literals:
+    lit = (size_t)(iend - anchor);
+    if ((size_t)(oend - op) < 1 + (lit >= RUN_MASK ? 1 + (lit - RUN_MASK) / 255 : 0) + lit) {
+        return LZ4_ERROR_NOSPACE;
+    }
+    if (lit >= RUN_MASK) {
+        *op++ = (uint8_t)(RUN_MASK << ML_BITS);
+        op = write_length(op, lit - RUN_MASK);
+    } else {
+        *op++ = (uint8_t)(lit << ML_BITS);
+    }
+    copy_bytes(op, anchor, lit);
+    op += lit;
+
+    return (int)(op - ostart);
+}
+
+/* ========================== Decompression ========================== */
+
+int lz4_decompress_block(const void* src, size_t src_size,
+                         void* dst, size_t dst_capacity) {
+    if (!src || !dst || src_size == 0) {
+        return LZ4_ERROR_INVALID;
+    }
+
+    const uint8_t* ip = (const uint8_t*)src;
+    const uint8_t* const iend = ip + src_size;
+    uint8_t* const ostart = (uint8_t*)dst;
+    uint8_t* const oend = ostart + dst_capacity;
+    uint8_t* op = ostart;
+
+    for (;;) {
+        uint32_t token = *ip++;
+
+        /* Literal run */
+        size_t lit = token >> ML_BITS;
+        if (lit == RUN_MASK) {
+            uint32_t s;
+            do {
+                if (ip >= iend) {
+                    return LZ4_ERROR_CORRUPT;
+                }
+                s = *ip++;
+                lit += s;
+            } while (s == 255);
+        }
+        if ((size_t)(iend - ip) < lit) {
+            return LZ4_ERROR_CORRUPT;
+        }
+        if ((size_t)(oend - op) < lit) {
+            return LZ4_ERROR_NOSPACE;
+        }
+        if (lit > 0) {
+            if ((size_t)(iend - ip) >= lit + WILDCOPY_SLACK &&
+                (size_t)(oend - op) >= lit + WILDCOPY_SLACK) {
+                wildcopy8(op, ip, op + lit);
+            } else {
+                copy_bytes(op, ip, lit);
+            }
+        }
+        ip += lit;
+        op += lit;
+
+        /* The final sequence ends with its literals. */
+        if (ip == iend) {
+            break;
+        }
+
+        /* Match */
+        if (iend - ip < 2) {
+            return LZ4_ERROR_CORRUPT;
+        }
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - ostart)) {
+            return LZ4_ERROR_CORRUPT;
+        }
+
+        size_t ml = token & ML_MASK;
+        if (ml == ML_MASK) {
+            uint32_t s;
+            do {
+                if (ip >= iend) {
+                    return LZ4_ERROR_CORRUPT;
+                }
+                s = *ip++;
+                ml += s;
+            } while (s == 255);
+        }
+        ml += MINMATCH;
+        if ((size_t)(oend - op) < ml) {
+            return LZ4_ERROR_NOSPACE;
+        }
+
+        const uint8_t* match = op - offset;
+        if (offset >= 8 && (size_t)(oend - op) >= ml + WILDCOPY_SLACK) {
+            wildcopy8(op, match, op + ml);
+        } else {
+            copy_bytes(op, match, ml);   /* Short offsets replicate a pattern */
+        }
+        op += ml;
+
+        if (ip >= iend) {
+            return LZ4_ERROR_CORRUPT;   /* A block must end with literals */
+        }
+    }
+
+    return (int)(op - ostart);
+}
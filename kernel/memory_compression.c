@@ -4,6 +4,7 @@
 
 #include "memory_advanced.h"
 #include "memory.h"
+#include "lz4.h"
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -32,7 +33,7 @@
 
 /* Compressed page entry */
 typedef struct compressed_page_entry {
-    void*                       original_page;      /* Original page pointer */
+    void*                       original_page;      /* Lookup key (page pointer or caller key) */
     void*                       compressed_data;    /* Compressed data */
     uint32_t                    original_size;      /* Original size */
     uint32_t                    compressed_size;    /* Compressed size */
@@ -40,6 +41,7 @@ typedef struct compressed_page_entry {
     uint64_t                    access_time;        /* Last access time */
     uint32_t                    access_count;       /* Access frequency */
     bool                        dirty;              /* Modified since compression */
+    bool                        writeback;          /* Off the LRU, being written back */
     
     /* Hash table linkage */
     struct compressed_page_entry* hash_next;
@@ -86,6 +88,16 @@ typedef struct compression_pool {
     uint64_t                    bytes_saved;        /* Bytes saved by compression */
     uint32_t                    avg_compression_ratio; /* Average compression ratio */
     
+    /* Keyed store/load (compressed tier in front of swap) */
+    uint64_t                    stores;             /* Pages accepted by pool_store_page */
+    uint64_t                    store_rejects;      /* Incompressible or no room */
+    uint64_t                    load_hits;          /* Faults served from the pool */
+    uint64_t                    load_misses;        /* Faults that had to go to swap */
+    uint64_t                    writebacks;         /* Cold entries written back */
+    uint64_t                    writeback_failures; /* Writeback hook refused */
+    compression_writeback_t     writeback;          /* Where evicted entries go */
+    void*                       writeback_ctx;
+    
     /* Configuration */
     uint32_t                    max_compression_time; /* Max compression time (μs) */
     uint32_t                    min_compression_ratio; /* Min compression ratio */
@@ -186,6 +198,15 @@ static inline uint64_t get_timestamp_us(void) {
     return ++counter;
 }
 
+static compression_algorithm_t* find_algorithm(uint32_t id) {
+    for (uint32_t i = 0; i < num_algorithms; i++) {
+        if (compression_algorithms[i].id == id && compression_algorithms[i].available) {
+            return &compression_algorithms[i];
+        }
+    }
+    return NULL;
+}
+
 static uint32_t hash_page_address(void* page) {
     uintptr_t addr = (uintptr_t)page;
     /* Simple hash function */
@@ -202,119 +223,42 @@ static void debug_print(const char* format, ...) {
     va_end(args);
 }
 
-/* ========================== Simple Compression Implementations ========================== */
+/* ========================== Compression Codecs ========================== */
 
 /**
- * Simple LZ4-like compression (simplified implementation)
+ * LZ4 page compression. Output capacity is capped at *output_size, so a page
+ * that does not shrink below it fails instead of being stored expanded.
  */
-static int simple_lz4_compress(const void* input, size_t input_size,
-                              void* output, size_t* output_size) {
+static int lz4_page_compress(const void* input, size_t input_size,
+                            void* output, size_t* output_size) {
     if (!input || !output || !output_size || input_size == 0) {
         return -1;
     }
     
-    const uint8_t* src = (const uint8_t*)input;
-    uint8_t* dst = (uint8_t*)output;
-    size_t src_pos = 0;
-    size_t dst_pos = 0;
-    size_t max_dst = *output_size;
-    
-    /* Simple compression: look for repeated bytes */
-    while (src_pos < input_size && dst_pos < max_dst - 2) {
-        uint8_t current = src[src_pos];
-        size_t run_length = 1;
-        
-        /* Count consecutive identical bytes */
-        while (src_pos + run_length < input_size && 
-               src[src_pos + run_length] == current && 
-               run_length < 255) {
-            run_length++;
-        }
-        
-        if (run_length >= 3) {
-            /* Encode as run-length */
-            dst[dst_pos++] = 0xFF;  /* Escape marker */
-            dst[dst_pos++] = (uint8_t)run_length;
-            dst[dst_pos++] = current;
-            src_pos += run_length;
-        } else {
-            /* Copy literal bytes */
-            if (current == 0xFF) {
-                /* Escape the escape marker */
-                dst[dst_pos++] = 0xFF;
-                dst[dst_pos++] = 0x00;
-                dst[dst_pos++] = current;
-            } else {
-                dst[dst_pos++] = current;
-            }
-            src_pos++;
-        }
-    }
-    
-    /* Copy remaining bytes if any */
-    while (src_pos < input_size && dst_pos < max_dst) {
-        uint8_t current = src[src_pos++];
-        if (current == 0xFF && dst_pos < max_dst - 2) {
-            dst[dst_pos++] = 0xFF;
-            dst[dst_pos++] = 0x00;
-            dst[dst_pos++] = current;
-        } else if (dst_pos < max_dst) {
-            dst[dst_pos++] = current;
-        }
+    lz4_workmem_t workmem;  /* 2KB match table; contents need no reset */
+    int result = lz4_compress_block(input, input_size, output, *output_size, &workmem);
+    if (result <= 0) {
+        return -1;
     }
     
-    *output_size = dst_pos;
-    
-    /* Return success if we achieved some compression */
-    return (dst_pos < input_size) ? 0 : -1;
+    *output_size = (size_t)result;
+    return 0;
 }
 
 /**
- * Simple LZ4-like decompression
+ * LZ4 page decompression. The block must expand to exactly *output_size bytes.
  */
-static int simple_lz4_decompress(const void* input, size_t input_size,
-                                void* output, size_t* output_size) {
+static int lz4_page_decompress(const void* input, size_t input_size,
+                              void* output, size_t* output_size) {
     if (!input || !output || !output_size || input_size == 0) {
         return -1;
     }
     
-    const uint8_t* src = (const uint8_t*)input;
-    uint8_t* dst = (uint8_t*)output;
-    size_t src_pos = 0;
-    size_t dst_pos = 0;
-    size_t max_dst = *output_size;
-    
-    while (src_pos < input_size && dst_pos < max_dst) {
-        if (src[src_pos] == 0xFF && src_pos + 1 < input_size) {
-            if (src[src_pos + 1] == 0x00) {
-                /* Escaped literal 0xFF */
-                if (src_pos + 2 < input_size) {
-                    dst[dst_pos++] = src[src_pos + 2];
-                    src_pos += 3;
-                } else {
-                    break;
-                }
-            } else {
-                /* Run-length encoded */
-                if (src_pos + 2 < input_size) {
-                    uint8_t length = src[src_pos + 1];
-                    uint8_t value = src[src_pos + 2];
-                    
-                    for (int i = 0; i < length && dst_pos < max_dst; i++) {
-                        dst[dst_pos++] = value;
-                    }
-                    src_pos += 3;
-                } else {
-                    break;
-                }
-            }
-        } else {
-            /* Literal byte */
-            dst[dst_pos++] = src[src_pos++];
-        }
+    int result = lz4_decompress_block(input, input_size, output, *output_size);
+    if (result < 0 || (size_t)result != *output_size) {
+        return -1;
     }
     
-    *output_size = dst_pos;
     return 0;
 }
 
@@ -470,6 +414,26 @@ static void lru_add_head(compression_pool_t* pool, compressed_page_entry_t* entr
     pool->lru_head = entry;
 }
 
+/**
+ * Add entry to tail of LRU list (next to be evicted)
+ */
+static void lru_add_tail(compression_pool_t* pool, compressed_page_entry_t* entry) {
+    if (!pool || !entry) {
+        return;
+    }
+    
+    entry->lru_prev = pool->lru_tail;
+    entry->lru_next = NULL;
+    
+    if (pool->lru_tail) {
+        pool->lru_tail->lru_next = entry;
+    } else {
+        pool->lru_head = entry;
+    }
+    
+    pool->lru_tail = entry;
+}
+
 /**
  * Remove entry from LRU list
  */
@@ -498,7 +462,7 @@ static void lru_remove_entry(compression_pool_t* pool, compressed_page_entry_t*
  * Move entry to head of LRU list
  */
 static void lru_touch_entry(compression_pool_t* pool, compressed_page_entry_t* entry) {
-    if (!pool || !entry) {
+    if (!pool || !entry || entry->writeback) {
         return;
     }
     
@@ -517,10 +481,10 @@ static void lru_touch_entry(compression_pool_t* pool, compressed_page_entry_t* e
 /**
  * Create a new compression pool
  */
-static compression_pool_t* create_compression_pool(const char* name, 
-                                                  uint32_t algorithm,
-                                                  size_t memory_size,
-                                                  uint32_t max_pages) {
+static compression_pool_t* alloc_compression_pool(const char* name, 
+                                                 uint32_t algorithm,
+                                                 size_t memory_size,
+                                                 uint32_t max_pages) {
     if (!name || memory_size == 0 || max_pages == 0) {
         return NULL;
     }
@@ -623,49 +587,115 @@ static compressed_page_entry_t* find_lru_victim(compression_pool_t* pool) {
     return pool->lru_tail;
 }
 
+static int decompress_page_internal(compression_pool_t* pool,
+                                   compressed_page_entry_t* entry,
+                                   void* output_page);
+
 /**
- * Evict least recently used page
+ * Unlink an entry and release its compressed data
  */
-static int evict_lru_page(compression_pool_t* pool) {
-    compressed_page_entry_t* victim = find_lru_victim(pool);
-    if (!victim) {
-        return -1;
-    }
-    
+static void drop_entry(compression_pool_t* pool, compressed_page_entry_t* entry) {
     /* Remove from hash table and LRU list */
-    hash_remove_entry(pool, victim);
-    lru_remove_entry(pool, victim);
+    hash_remove_entry(pool, entry);
+    lru_remove_entry(pool, entry);
     
     /* Update pool statistics */
     pool->compressed_pages--;
-    pool->used_size -= victim->compressed_size;
-    pool->free_size += victim->compressed_size;
+    pool->used_size -= entry->compressed_size;
+    pool->free_size += entry->compressed_size;
     
     /* Free compressed data */
-    if (victim->compressed_data) {
-        kfree(victim->compressed_data);
+    if (entry->compressed_data) {
+        kfree(entry->compressed_data);
     }
     
-    kfree(victim);
+    kfree(entry);
+}
+
+/**
+ * Evict least recently used page. Caller holds the pool lock.
+ *
+ * With a writeback hook installed the victim is decompressed and handed to it
+ * first (e.g. written to its swap slot); if that fails the victim goes back to
+ * the LRU tail and the eviction fails, so a page is never silently lost.
+ *
+ * The hook does I/O, so the pool lock is dropped around it. The victim is
+ * taken off the LRU but stays in the hash table marked writeback, and
+ * find_settled_entry() makes loads, stores and invalidations of its key wait
+ * until it is gone. A slot therefore cannot be freed and reused while its old
+ * contents are still on the way to it.
+ */
+static int evict_lru_page(compression_pool_t* pool) {
+    compressed_page_entry_t* victim = find_lru_victim(pool);
+    if (!victim) {
+        return -1;
+    }
+    
+    if (pool->writeback) {
+        void* buf = kmalloc(PAGE_SIZE, GFP_KERNEL);
+        if (!buf || decompress_page_internal(pool, victim, buf) != 0) {
+            if (buf) {
+                kfree(buf);
+            }
+            pool->writeback_failures++;
+            return -1;
+        }
+        
+        lru_remove_entry(pool, victim);
+        victim->writeback = true;
+        
+        pool_unlock(pool);
+        int rc = pool->writeback((uint64_t)(uintptr_t)victim->original_page,
+                                 buf, pool->writeback_ctx);
+        pool_lock(pool);
+        
+        kfree(buf);
+        victim->writeback = false;
+        if (rc != 0) {
+            lru_add_tail(pool, victim);
+            pool->writeback_failures++;
+            return -1;
+        }
+        pool->writebacks++;
+    }
+    
+    drop_entry(pool, victim);
     
     debug_print("Compression: Evicted LRU page from pool %s\n", pool->name);
     
     return 0;
 }
 
+/**
+ * Look up key, waiting out any writeback of its entry. Caller holds the
+ * pool lock, which is dropped while waiting.
+ */
+static compressed_page_entry_t* find_settled_entry(compression_pool_t* pool, void* key) {
+    compressed_page_entry_t* entry = hash_find_entry(pool, key);
+    
+    while (entry && entry->writeback) {
+        pool_unlock(pool);
+        __asm__ volatile("pause");
+        pool_lock(pool);
+        entry = hash_find_entry(pool, key);
+    }
+    
+    return entry;
+}
+
 /* ========================== Compression Operations ========================== */
 
 /**
  * Compress a page
  */
-static int compress_page_internal(compression_pool_t* pool, void* page,
+static int compress_page_internal(compression_pool_t* pool, void* key, void* page,
                                  compressed_page_entry_t** out_entry) {
-    if (!pool || !page || !out_entry) {
+    if (!pool || !key || !page || !out_entry) {
         return -1;
     }
     
     /* Check if page is already compressed */
-    compressed_page_entry_t* existing = hash_find_entry(pool, page);
+    compressed_page_entry_t* existing = hash_find_entry(pool, key);
     if (existing) {
         lru_touch_entry(pool, existing);
         *out_entry = existing;
@@ -690,14 +720,17 @@ static int compress_page_internal(compression_pool_t* pool, void* page,
         algorithm_used = COMPRESSION_NONE;
         debug_print("Compression: Zero page detected\n");
     } else {
-        /* Try configured algorithm */
+        /* Try the pool's configured algorithm */
+        compression_algorithm_t* algo = find_algorithm(pool->algorithm);
         compressed_size = MAX_COMPRESSION_SIZE;
         
-        if (pool->algorithm == COMPRESSION_LZ4) {
-            if (simple_lz4_compress(page, PAGE_SIZE, compressed_data, &compressed_size) == 0) {
-                algorithm_used = COMPRESSION_LZ4;
-            }
+        if (!algo || !algo->compress || algo->id == COMPRESSION_NONE ||
+            algo->compress(page, PAGE_SIZE, compressed_data, &compressed_size) != 0) {
+            kfree(compressed_data);
+            compression_stats.compression_failures++;
+            return -1;  /* Page did not fit in MAX_COMPRESSION_SIZE */
         }
+        algorithm_used = algo->id;
         
         /* Check compression ratio */
         uint32_t ratio = (compressed_size * 100) / PAGE_SIZE;
@@ -732,7 +765,7 @@ static int compress_page_internal(compression_pool_t* pool, void* page,
         return -1;
     }
     
-    entry->original_page = page;
+    entry->original_page = key;
     entry->compressed_data = compressed_data;
     entry->original_size = PAGE_SIZE;
     entry->compressed_size = compressed_size;
@@ -776,23 +809,11 @@ static int decompress_page_internal(compression_pool_t* pool,
     size_t output_size = PAGE_SIZE;
     int result = -1;
     
-    /* Decompress based on algorithm */
-    switch (entry->algorithm) {
-        case COMPRESSION_NONE:
-            result = zero_page_decompress(entry->compressed_data, 
-                                        entry->compressed_size,
-                                        output_page, &output_size);
-            break;
-            
-        case COMPRESSION_LZ4:
-            result = simple_lz4_decompress(entry->compressed_data,
-                                         entry->compressed_size,
-                                         output_page, &output_size);
-            break;
-            
-        default:
-            result = -1;
-            break;
+    /* Decompress with the algorithm the entry was stored with */
+    compression_algorithm_t* algo = find_algorithm(entry->algorithm);
+    if (algo && algo->decompress) {
+        result = algo->decompress(entry->compressed_data, entry->compressed_size,
+                                  output_page, &output_size);
     }
     
     uint64_t decompression_time = get_timestamp_us() - start_time;
@@ -831,8 +852,8 @@ int memory_compression_init(void) {
         
         switch (algo->id) {
             case COMPRESSION_LZ4:
-                algo->compress = simple_lz4_compress;
-                algo->decompress = simple_lz4_decompress;
+                algo->compress = lz4_page_compress;
+                algo->decompress = lz4_page_decompress;
                 algo->available = true;
                 break;
                 
@@ -938,7 +959,7 @@ int create_compression_pool(const char* name, uint32_t algorithm,
     }
     
     /* Create pool */
-    compression_pool_t* pool = create_compression_pool(name, algorithm, memory_size, max_pages);
+    compression_pool_t* pool = alloc_compression_pool(name, algorithm, memory_size, max_pages);
     if (!pool) {
         compression_global_lock_release();
         return -1;
@@ -1020,7 +1041,7 @@ int compress_page(int pool_id, void* page) {
     pool_lock(pool);
     
     compressed_page_entry_t* entry = NULL;
-    int result = compress_page_internal(pool, page, &entry);
+    int result = compress_page_internal(pool, page, page, &entry);
     
     if (result == 0) {
         compression_stats.total_compressions++;
@@ -1093,6 +1114,188 @@ bool is_page_compressed(int pool_id, void* page) {
     return compressed;
 }
 
+/**
+ * Install the hook that receives cold entries evicted from a pool
+ */
+int compression_pool_set_writeback(int pool_id, compression_writeback_t writeback, void* ctx) {
+    if (!compression_enabled || pool_id < 0 || pool_id >= MAX_COMPRESSED_POOLS) {
+        return -1;
+    }
+    
+    compression_pool_t* pool = compression_pools[pool_id];
+    if (!pool) {
+        return -1;
+    }
+    
+    pool_lock(pool);
+    pool->writeback = writeback;
+    pool->writeback_ctx = ctx;
+    
+    pool_unlock(pool);
+    
+    return 0;
+}
+
+/**
+ * Evict up to nr entries, coldest first, through the writeback hook
+ *
+ * Returns the number evicted.
+ */
+uint32_t compression_pool_shrink(int pool_id, uint32_t nr) {
+    if (!compression_enabled || pool_id < 0 || pool_id >= MAX_COMPRESSED_POOLS) {
+        return 0;
+    }
+    
+    compression_pool_t* pool = compression_pools[pool_id];
+    if (!pool) {
+        return 0;
+    }
+    
+    uint32_t evicted = 0;
+    pool_lock(pool);
+    while (evicted < nr && evict_lru_page(pool) == 0) {
+        evicted++;
+    }
+    pool_unlock(pool);
+    
+    return evicted;
+}
+
+/**
+ * Store a copy of page in the pool under key
+ *
+ * Any previous entry for key is replaced. When the pool is over its page or
+ * byte budget, least recently stored entries are evicted through the
+ * writeback hook to make room.
+ */
+int pool_store_page(int pool_id, uint64_t key, const void* page) {
+    if (!compression_enabled || pool_id < 0 || pool_id >= MAX_COMPRESSED_POOLS ||
+        key == 0 || !page) {
+        return -1;
+    }
+    
+    compression_pool_t* pool = compression_pools[pool_id];
+    if (!pool || !(pool->state & POOL_ACTIVE)) {
+        return -1;
+    }
+    
+    pool_lock(pool);
+    
+    void* hkey = (void*)(uintptr_t)key;
+    compressed_page_entry_t* stale = find_settled_entry(pool, hkey);
+    if (stale) {
+        drop_entry(pool, stale);
+    }
+    
+    compressed_page_entry_t* entry = NULL;
+    int result = compress_page_internal(pool, hkey, (void*)page, &entry);
+    
+    if (result == 0) {
+        pool->stores++;
+        compression_stats.total_compressions++;
+        compression_stats.bytes_compressed += PAGE_SIZE;
+        compression_stats.bytes_saved += (PAGE_SIZE - entry->compressed_size);
+    } else {
+        pool->store_rejects++;
+    }
+    
+    pool_unlock(pool);
+    
+    return result;
+}
+
+/**
+ * Decompress the entry for key into output and remove it from the pool
+ *
+ * Returns -1 on a miss; the caller then reads the page from backing store.
+ */
+int pool_load_page(int pool_id, uint64_t key, void* output) {
+    if (!compression_enabled || pool_id < 0 || pool_id >= MAX_COMPRESSED_POOLS ||
+        key == 0 || !output) {
+        return -1;
+    }
+    
+    compression_pool_t* pool = compression_pools[pool_id];
+    if (!pool || !(pool->state & POOL_ACTIVE)) {
+        return -1;
+    }
+    
+    pool_lock(pool);
+    
+    compressed_page_entry_t* entry = find_settled_entry(pool, (void*)(uintptr_t)key);
+    if (!entry) {
+        pool->load_misses++;
+        pool_unlock(pool);
+        return -1;
+    }
+    
+    int result = decompress_page_internal(pool, entry, output);
+    if (result == 0) {
+        pool->load_hits++;
+        compression_stats.total_decompressions++;
+        compression_stats.bytes_decompressed += PAGE_SIZE;
+        drop_entry(pool, entry);   /* The page is resident again */
+    }
+    
+    pool_unlock(pool);
+    
+    return result;
+}
+
+/**
+ * Drop the entry for key, if any (its backing slot was freed)
+ */
+void pool_invalidate_page(int pool_id, uint64_t key) {
+    if (!compression_enabled || pool_id < 0 || pool_id >= MAX_COMPRESSED_POOLS || key == 0) {
+        return;
+    }
+    
+    compression_pool_t* pool = compression_pools[pool_id];
+    if (!pool) {
+        return;
+    }
+    
+    pool_lock(pool);
+    compressed_page_entry_t* entry = find_settled_entry(pool, (void*)(uintptr_t)key);
+    if (entry) {
+        drop_entry(pool, entry);
+    }
+    pool_unlock(pool);
+}
+
+/**
+ * Per-pool statistics
+ */
+int get_compression_pool_stats(int pool_id, compression_pool_stats_t* stats) {
+    if (!compression_enabled || pool_id < 0 || pool_id >= MAX_COMPRESSED_POOLS || !stats) {
+        return -1;
+    }
+    
+    compression_pool_t* pool = compression_pools[pool_id];
+    if (!pool) {
+        return -1;
+    }
+    
+    pool_lock(pool);
+    
+    stats->stored_pages = pool->compressed_pages;
+    stats->max_pages = pool->max_pages;
+    stats->pool_bytes = pool->used_size;
+    stats->budget_bytes = pool->memory_size;
+    stats->stores = pool->stores;
+    stats->store_rejects = pool->store_rejects;
+    stats->load_hits = pool->load_hits;
+    stats->load_misses = pool->load_misses;
+    stats->writebacks = pool->writebacks;
+    stats->writeback_failures = pool->writeback_failures;
+    stats->compression_ratio = pool->compressed_pages ?
+        (uint32_t)((pool->used_size * 100) / ((uint64_t)pool->compressed_pages * PAGE_SIZE)) : 0;
+    
+    pool_unlock(pool);
+    
+    return 0;
+}
+
 /**
  * Get compression statistics
  */
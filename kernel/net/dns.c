@@ -22,6 +22,7 @@
 #include "net/network.h"
 #include "memory.h"
 #include "string.h"
+#include "timer_wheel.h"
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -40,6 +41,12 @@ static uint32_t cache_entry_count = 0;
 static uint16_t query_id_counter = 1;
 static int dns_socket = -1;
 
+/* Periodic cache sweep. The timer only flags the sweep as due; the next cache
+ * operation performs it, so entries are never freed from interrupt context. */
+static ktimer_t dns_sweep_timer;
+static volatile bool dns_sweep_due = false;
+static void dns_sweep_tick(void* data);
+
 /* DNS Server List */
 #define MAX_DNS_SERVERS 8
 static ip_addr_t dns_servers[MAX_DNS_SERVERS];
@@ -83,6 +90,8 @@ int dns_init(void) {
     /* Initialize cache */
     dns_cache_head = NULL;
     cache_entry_count = 0;
+    ktimer_init(&dns_sweep_timer, dns_sweep_tick, NULL);
+    ktimer_start_periodic(&dns_sweep_timer, (uint64_t)DNS_CACHE_SWEEP_SECS * KTIMER_HZ);
     
     /* Initialize pending queries */
     pending_queries = NULL;
@@ -113,6 +122,7 @@ void dns_cleanup(void) {
     }
     
     /* Clear cache */
+    ktimer_cancel_sync(&dns_sweep_timer);
     dns_cache_clear();
     
     /* Cancel pending queries */
@@ -429,11 +439,25 @@ int dns_packet_extract_answer(const uint8_t* packet, size_t packet_size,
  * DNS Cache Management
  * ================================ */
 
+static void dns_sweep_tick(void* data) {
+    (void)data;
+    dns_sweep_due = true;
+}
+
+/* Run a sweep the timer has asked for */
+static void dns_cache_sweep_if_due(void) {
+    if (dns_sweep_due) {
+        dns_sweep_due = false;
+        dns_cache_cleanup_expired();
+    }
+}
+
 int dns_cache_add(const char* name, uint16_t type, uint16_t class,
                  uint32_t ttl, const void* data, uint16_t data_len) {
     if (!dns_config.cache_enabled || !name || !data) {
         return DNS_ERROR_INVALID;
     }
+    dns_cache_sweep_if_due();
     
     if (cache_entry_count >= dns_config.cache_max_entries) {
         /* Remove oldest entry */
@@ -478,6 +502,7 @@ int dns_cache_lookup(const char* name, uint16_t type, uint16_t class,
         return DNS_ERROR_INVALID;
     }
     
+    dns_cache_sweep_if_due();
     uint32_t current_time = dns_get_timestamp();
     dns_cache_entry_t* entry = dns_cache_head;
     
@@ -654,9 +679,8 @@ bool dns_is_valid_hostname(const char* hostname) {
 }
 
 uint32_t dns_get_timestamp(void) {
-    /* Simplified timestamp - in real implementation would use system timer */
-    static uint32_t counter = 0;
-    return ++counter;
+    /* Seconds since boot, to compare against TTLs */
+    return (uint32_t)(ktimer_now() / KTIMER_HZ);
 }
 
 uint16_t dns_generate_id(void) {
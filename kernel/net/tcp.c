@@ -53,6 +53,7 @@ static uint16_t next_ephemeral_port = TCP_EPHEMERAL_PORT_MIN;
 #define TCP_MIN_RTO 200             /* Minimum RTO */
 #define TCP_MAX_RTO 60000           /* Maximum RTO */
 #define TCP_MSL 30000               /* Maximum segment lifetime */
+#define TCP_MAX_RETRIES 12          /* RTO expiries before the connection is dropped */
 
 /*
  * TCP Window and Buffer Constants
@@ -73,6 +74,10 @@ static void tcp_send_segment(tcp_socket_t* socket, uint8_t flags,
 static void tcp_process_segment(tcp_socket_t* socket, tcp_header_t* header, 
                                const void* data, uint16_t data_len);
 static void tcp_update_rto(tcp_socket_t* socket, uint32_t rtt);
+static void tcp_arm_retransmit(tcp_socket_t* socket);
+static void tcp_retransmit_timeout(void* data);
+static void tcp_retransmit_if_due(tcp_socket_t* socket);
+static void tcp_acknowledge(tcp_socket_t* socket, uint32_t ack);
 
 /**
  * Initialize TCP protocol subsystem
@@ -104,8 +109,8 @@ tcp_socket_t* tcp_socket_create(void) {
     socket->remote_addr.addr = 0;
     
     /* Initialize sequence number management */
-    socket->snd.una = 0;
     socket->snd.nxt = 1000; /* Initial sequence number */
+    socket->snd.una = socket->snd.nxt;
     socket->snd.wnd = TCP_DEFAULT_WINDOW_SIZE;
     socket->snd.up = 0;
     socket->snd.wl1 = 0;
@@ -135,7 +140,8 @@ tcp_socket_t* tcp_socket_create(void) {
     socket->backoff = 0;
     
     /* Initialize timers */
-    socket->retrans_timer = 0;
+    ktimer_init(&socket->retrans_timer, tcp_retransmit_timeout, socket);
+    socket->retransmit_due = false;
     socket->keepalive_timer = 0;
     socket->timewait_timer = 0;
     
@@ -249,8 +255,12 @@ tcp_socket_t* tcp_socket_accept(tcp_socket_t* listen_socket) {
  * Send data over TCP connection
  */
 int tcp_socket_send(tcp_socket_t* socket, const void* data, size_t len) {
-    if (!socket || socket->state != TCP_ESTABLISHED) {
-        return -1; /* Invalid socket or not connected */
+    if (!socket) {
+        return -1;
+    }
+    tcp_retransmit_if_due(socket);
+    if (socket->state != TCP_ESTABLISHED) {
+        return -1; /* Not connected */
     }
     
     if (!data || len == 0) {
@@ -280,8 +290,12 @@ int tcp_socket_send(tcp_socket_t* socket, const void* data, size_t len) {
  * Receive data from TCP connection
  */
 int tcp_socket_recv(tcp_socket_t* socket, void* buffer, size_t len) {
-    if (!socket || socket->state != TCP_ESTABLISHED) {
-        return -1; /* Invalid socket or not connected */
+    if (!socket) {
+        return -1;
+    }
+    tcp_retransmit_if_due(socket);
+    if (socket->state != TCP_ESTABLISHED) {
+        return -1; /* Not connected */
     }
     
     if (!buffer || len == 0) {
@@ -388,6 +402,10 @@ static void tcp_deallocate_socket(tcp_socket_t* socket) {
     if (socket && socket >= tcp_connections && 
         socket < tcp_connections + MAX_TCP_CONNECTIONS) {
         
+        /* No retransmission may fire on a recycled control block */
+        ktimer_cancel_sync(&socket->retrans_timer);
+        socket->retransmit_due = false;
+        
         /* Free buffers if allocated */
         if (socket->send_buffer) {
             netbuf_free(socket->send_buffer);
@@ -484,6 +502,13 @@ static void tcp_send_segment(tcp_socket_t* socket, uint8_t flags,
         socket->snd.nxt++;
     }
     
+    /* Anything that occupies sequence space must be acknowledged: start the
+     * RTO unless one is already running (RFC 6298 5.1) */
+    if ((data_len > 0 || (flags & (TCP_FLAG_SYN | TCP_FLAG_FIN))) &&
+        !ktimer_pending(&socket->retrans_timer)) {
+        tcp_arm_retransmit(socket);
+    }
+    
     /* Update statistics */
     socket->packets_sent++;
 }
@@ -501,6 +526,16 @@ static void tcp_process_segment(tcp_socket_t* socket, tcp_header_t* header,
         return;
     }
     
+    /* New acknowledgment: everything up to ack_num has arrived */
+    if ((header->flags & TCP_FLAG_ACK) &&
+        (int32_t)(header->ack_num - socket->snd.una) > 0 &&
+        (int32_t)(header->ack_num - socket->snd.nxt) <= 0) {
+        tcp_acknowledge(socket, header->ack_num);
+    }
+    
+    /* An RTO that expired for data this ACK covers resends nothing */
+    tcp_retransmit_if_due(socket);
+    
     /* Process based on current state */
     switch (socket->state) {
         case TCP_LISTEN:
@@ -578,3 +613,125 @@ static void tcp_update_rto(tcp_socket_t* socket, uint32_t rtt) {
         socket->rto = TCP_MAX_RTO;
     }
 }
+
+/**
+ * Start the retransmission timer for the current RTO, doubled per backoff
+ */
+static void tcp_arm_retransmit(tcp_socket_t* socket) {
+    uint32_t timeout = socket->rto;
+    for (uint32_t i = 0; i < socket->backoff && timeout < TCP_MAX_RTO; i++) {
+        timeout *= 2;
+    }
+    if (timeout > TCP_MAX_RTO) {
+        timeout = TCP_MAX_RTO;
+    }
+    ktimer_start(&socket->retrans_timer, ktimer_ms_to_ticks(timeout));
+}
+
+/**
+ * Restart or stop the retransmission timer after the send window moved
+ */
+void tcp_reset_retransmission_timer(tcp_socket_t* sock) {
+    if (!sock) {
+        return;
+    }
+    if (sock->snd.una != sock->snd.nxt) {
+        tcp_arm_retransmit(sock);
+    } else {
+        ktimer_cancel(&sock->retrans_timer);
+    }
+}
+
+/**
+ * Handle an acknowledgment that advances snd.una
+ */
+static void tcp_acknowledge(tcp_socket_t* socket, uint32_t ack) {
+    socket->snd.una = ack;
+    socket->backoff = 0;
+    tcp_reset_retransmission_timer(socket);
+}
+
+/**
+ * Resend the oldest unacknowledged segment
+ *
+ * Only control segments can be rebuilt: payload is not kept once sent, so
+ * unacknowledged data is left to the retry limit.
+ */
+int tcp_retransmit_segment(tcp_socket_t* sock) {
+    if (!sock) {
+        return -1;
+    }
+    
+    uint8_t flags;
+    switch (sock->state) {
+        case TCP_SYN_SENT:
+            flags = TCP_FLAG_SYN;
+            break;
+        case TCP_SYN_RCVD:
+            flags = TCP_FLAG_SYN | TCP_FLAG_ACK;
+            break;
+        case TCP_FIN_WAIT_1:
+        case TCP_CLOSING:
+        case TCP_LAST_ACK:
+            flags = TCP_FLAG_FIN | TCP_FLAG_ACK;
+            break;
+        default:
+            return -1;
+    }
+    
+    /* Resend from the oldest unacknowledged sequence number */
+    uint32_t nxt = sock->snd.nxt;
+    sock->snd.nxt = sock->snd.una;
+    tcp_send_segment(sock, flags, NULL, 0);
+    sock->snd.nxt = nxt;
+    sock->retrans_count++;
+    return 0;
+}
+
+/**
+ * Retransmission timer expiry (timer-interrupt context)
+ *
+ * Resending goes through the IP layer and changes snd.nxt and the state,
+ * which the send and input paths also do without a lock, so the IRQ only
+ * flags the socket; tcp_retransmit_if_due() does the work.
+ */
+static void tcp_retransmit_timeout(void* data) {
+    tcp_socket_t* socket = (tcp_socket_t*)data;
+    socket->retransmit_due = true;
+}
+
+/**
+ * Resend or give up on a socket whose RTO has expired
+ */
+static void tcp_retransmit_if_due(tcp_socket_t* socket) {
+    if (!socket->retransmit_due) {
+        return;
+    }
+    socket->retransmit_due = false;
+    
+    if (socket->snd.una == socket->snd.nxt) {
+        return; /* Acknowledged since the timer fired */
+    }
+    
+    if (++socket->backoff > TCP_MAX_RETRIES) {
+        /* Peer unreachable: give up on the connection */
+        tcp_set_state(socket, TCP_CLOSED);
+        return;
+    }
+    
+    /* Back off before resending so the resend does not restart a fresh RTO */
+    tcp_arm_retransmit(socket);
+    tcp_retransmit_segment(socket);
+}
+
+/**
+ * Run the retransmissions whose timers have fired
+ */
+void tcp_timer_tick(void) {
+    if (!connection_pool_initialized) {
+        return;
+    }
+    for (int i = 0; i < MAX_TCP_CONNECTIONS; i++) {
+        tcp_retransmit_if_due(&tcp_connections[i]);
+    }
+}
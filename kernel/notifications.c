@@ -34,6 +34,10 @@ static gui_window_t* g_notification_panel = NULL;
 static gui_widget_t* g_notification_list = NULL;
 static bool g_panel_visible = false;
 
+/* Set from timer context when any notification's expiry timer fires; the
+ * expiry itself is applied from notification_update_display(). */
+static volatile bool g_timeouts_fired = false;
+
 /* Callback management */
 static notification_event_callback_t g_event_callbacks[NOTIFICATION_MAX_SUBSCRIBERS];
 static void* g_event_callback_data[NOTIFICATION_MAX_SUBSCRIBERS];
@@ -51,6 +55,12 @@ static uint32_t g_alert_callback_count = 0;
  * Internal Helper Functions
  * ================================ */
 
+static void notification_timeout_fired(void* data) {
+    notification_t* notification = (notification_t*)data;
+    notification->timeout_fired = true;
+    g_timeouts_fired = true;
+}
+
 static notification_t* allocate_notification(void) {
     notification_t* notification = (notification_t*)kmalloc(sizeof(notification_t));
     if (notification) {
@@ -58,6 +68,7 @@ static notification_t* allocate_notification(void) {
         notification->id = g_next_notification_id++;
         notification->created_time = get_current_time();
         notification->state = NOTIFICATION_STATE_PENDING;
+        ktimer_init(&notification->expiry_timer, notification_timeout_fired, notification);
     }
     return notification;
 }
@@ -65,6 +76,8 @@ static notification_t* allocate_notification(void) {
 static void free_notification(notification_t* notification) {
     if (!notification) return;
     
+    ktimer_cancel_sync(&notification->expiry_timer);
+    
     /* Destroy GUI window if exists */
     if (notification->window) {
         gui_destroy_window(notification->window);
@@ -157,6 +170,15 @@ static void set_notification_state(notification_t* notification, notification_st
     notification_state_t old_state = notification->state;
     notification->state = new_state;
     
+    /* Run the display timeout only while visible */
+    if (old_state == NOTIFICATION_STATE_VISIBLE) {
+        ktimer_cancel(&notification->expiry_timer);
+    }
+    if (new_state == NOTIFICATION_STATE_VISIBLE && notification->timeout_ms > 0) {
+        notification->timeout_fired = false;
+        ktimer_start(&notification->expiry_timer, ktimer_ms_to_ticks(notification->timeout_ms));
+    }
+    
     /* Update timestamps */
     time_t current_time = get_current_time();
     switch (new_state) {
@@ -337,20 +359,20 @@ static void update_notification_panel(void) {
  * ================================ */
 
 static void check_notification_timeouts(void) {
-    time_t current_time = get_current_time();
-    notification_t* notification = g_active_notifications;
+    /* Nothing to do unless an expiry timer has fired since the last pass */
+    if (!g_timeouts_fired) {
+        return;
+    }
+    g_timeouts_fired = false;
     
+    notification_t* notification = g_active_notifications;
     while (notification) {
         notification_t* next = notification->next;
         
-        if (notification->timeout_ms > 0 && 
-            notification->state == NOTIFICATION_STATE_VISIBLE &&
-            notification->shown_time > 0) {
-            
-            uint64_t elapsed_ms = (current_time - notification->shown_time) * 1000;
-            if (elapsed_ms >= notification->timeout_ms) {
-                set_notification_state(notification, NOTIFICATION_STATE_EXPIRED);
-            }
+        if (notification->timeout_fired &&
+            notification->state == NOTIFICATION_STATE_VISIBLE) {
+            notification->timeout_fired = false;
+            set_notification_state(notification, NOTIFICATION_STATE_EXPIRED);
         }
         
         notification = next;
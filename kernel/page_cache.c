@@ -0,0 +1,828 @@
+/* IKOS Page Cache
+ * See include/page_cache.h. Callers serialize access per cache.
+ */
+
+#include "page_cache.h"
+
+static void copy_bytes(void* dst, const void* src, size_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+    for (size_t i = 0; i < n; i++) {
+        d[i] = s[i];
+    }
+}
+
+static void zero_bytes(void* dst, size_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    for (size_t i = 0; i < n; i++) {
+        d[i] = 0;
+    }
+}
+
+/* ================================
+ * Radix Tree
+ * ================================ */
+
+/* Indices a tree of this height can hold */
+static uint64_t radix_capacity(uint32_t height) {
+    return height == 0 ? 0 : 1ULL << (height * PAGE_CACHE_RADIX_SHIFT);
+}
+
+static uint32_t radix_slot(uint64_t index, uint32_t level) {
+    return (uint32_t)(index >> ((level - 1) * PAGE_CACHE_RADIX_SHIFT)) &
+           (PAGE_CACHE_RADIX_SLOTS - 1);
+}
+
+static page_cache_node_t* radix_node_alloc(page_cache_t* cache) {
+    page_cache_node_t* node = (page_cache_node_t*)cache->ops.alloc(sizeof(page_cache_node_t));
+    if (node) {
+        zero_bytes(node, sizeof(*node));
+    }
+    return node;
+}
+
+static page_cache_page_t* radix_lookup(const page_cache_mapping_t* mapping, uint64_t index) {
+    page_cache_node_t* node = mapping->root;
+    if (!node || index >= radix_capacity(mapping->height)) {
+        return NULL;
+    }
+
+    for (uint32_t level = mapping->height; level > 1; level--) {
+        node = (page_cache_node_t*)node->slots[radix_slot(index, level)];
+        if (!node) {
+            return NULL;
+        }
+    }
+    return (page_cache_page_t*)node->slots[radix_slot(index, 1)];
+}
+
+static int radix_insert(page_cache_mapping_t* mapping, uint64_t index, page_cache_page_t* page) {
+    page_cache_t* cache = mapping->cache;
+
+    /* Grow until the index fits: the old root becomes slot 0 of a new one */
+    while (!mapping->root || index >= radix_capacity(mapping->height)) {
+        if (mapping->height == PAGE_CACHE_RADIX_MAX_HEIGHT) {
+            return PAGE_CACHE_ENOSPC;
+        }
+        page_cache_node_t* node = radix_node_alloc(cache);
+        if (!node) {
+            return PAGE_CACHE_ENOMEM;
+        }
+        if (mapping->root) {
+            node->slots[0] = mapping->root;
+            node->count = 1;
+        }
+        mapping->root = node;
+        mapping->height++;
+    }
+
+    page_cache_node_t* node = mapping->root;
+    for (uint32_t level = mapping->height; level > 1; level--) {
+        uint32_t slot = radix_slot(index, level);
+        if (!node->slots[slot]) {
+            page_cache_node_t* child = radix_node_alloc(cache);
+            if (!child) {
+                return PAGE_CACHE_ENOMEM;
+            }
+            node->slots[slot] = child;
+            node->count++;
+        }
+        node = (page_cache_node_t*)node->slots[slot];
+    }
+
+    node->slots[radix_slot(index, 1)] = page;
+    node->count++;
+    return PAGE_CACHE_OK;
+}
+
+static void radix_delete(page_cache_mapping_t* mapping, uint64_t index) {
+    page_cache_t* cache = mapping->cache;
+    page_cache_node_t* path[PAGE_CACHE_RADIX_MAX_HEIGHT + 1];
+    page_cache_node_t* node = mapping->root;
+    if (!node || index >= radix_capacity(mapping->height)) {
+        return;
+    }
+
+    /* path[level] is the node at that level on the way down */
+    for (uint32_t level = mapping->height; level > 1; level--) {
+        path[level] = node;
+        node = (page_cache_node_t*)node->slots[radix_slot(index, level)];
+        if (!node) {
+            return;
+        }
+    }
+    path[1] = node;
+
+    uint32_t slot = radix_slot(index, 1);
+    if (!node->slots[slot]) {
+        return;
+    }
+    node->slots[slot] = NULL;
+    node->count--;
+
+    /* Free nodes left empty, bottom up */
+    for (uint32_t level = 1; level <= mapping->height && path[level]->count == 0; level++) {
+        cache->ops.free(path[level]);
+        if (level == mapping->height) {
+            mapping->root = NULL;
+            mapping->height = 0;
+            return;
+        }
+        page_cache_node_t* parent = path[level + 1];
+        parent->slots[radix_slot(index, level + 1)] = NULL;
+        parent->count--;
+    }
+
+    /* Shrink while everything lives under slot 0 of the root */
+    while (mapping->height > 1 && mapping->root->count == 1 && mapping->root->slots[0]) {
+        page_cache_node_t* old = mapping->root;
+        mapping->root = (page_cache_node_t*)old->slots[0];
+        mapping->height--;
+        cache->ops.free(old);
+    }
+}
+
+/* First page at or after `from` below this node; `from` counts from the
+ * node's first index */
+static page_cache_page_t* radix_next_in(page_cache_node_t* node, uint32_t level, uint64_t from) {
+    uint32_t shift = (level - 1) * PAGE_CACHE_RADIX_SHIFT;
+    uint64_t below = from & ((1ULL << shift) - 1);
+
+    for (uint32_t slot = (uint32_t)(from >> shift); slot < PAGE_CACHE_RADIX_SLOTS; slot++) {
+        void* child = node->slots[slot];
+        if (child) {
+            if (level == 1) {
+                return (page_cache_page_t*)child;
+            }
+            page_cache_page_t* page = radix_next_in((page_cache_node_t*)child, level - 1, below);
+            if (page) {
+                return page;
+            }
+        }
+        below = 0;
+    }
+    return NULL;
+}
+
+/* Free nodes with no pages below them (left by an insert that ran out of
+ * memory part way down) */
+static void radix_free_nodes(page_cache_t* cache, page_cache_node_t* node, uint32_t level) {
+    if (level > 1) {
+        for (uint32_t slot = 0; slot < PAGE_CACHE_RADIX_SLOTS; slot++) {
+            if (node->slots[slot]) {
+                radix_free_nodes(cache, (page_cache_node_t*)node->slots[slot], level - 1);
+            }
+        }
+    }
+    cache->ops.free(node);
+}
+
+static page_cache_page_t* radix_next(const page_cache_mapping_t* mapping, uint64_t from) {
+    if (!mapping->root || from >= radix_capacity(mapping->height)) {
+        return NULL;
+    }
+    return radix_next_in(mapping->root, mapping->height, from);
+}
+
+/* ================================
+ * LRU and Dirty Tracking
+ * ================================ */
+
+static bool mapping_evictable(const page_cache_mapping_t* mapping) {
+    return mapping->aops && mapping->aops->readpage;
+}
+
+static void lru_unlink(page_cache_t* cache, page_cache_page_t* page) {
+    if (page->lru_prev) {
+        page->lru_prev->lru_next = page->lru_next;
+    } else if (cache->lru_head == page) {
+        cache->lru_head = page->lru_next;
+    }
+    if (page->lru_next) {
+        page->lru_next->lru_prev = page->lru_prev;
+    } else if (cache->lru_tail == page) {
+        cache->lru_tail = page->lru_prev;
+    }
+    page->lru_prev = NULL;
+    page->lru_next = NULL;
+}
+
+static void lru_push(page_cache_t* cache, page_cache_page_t* page) {
+    page->lru_prev = NULL;
+    page->lru_next = cache->lru_head;
+    if (cache->lru_head) {
+        cache->lru_head->lru_prev = page;
+    } else {
+        cache->lru_tail = page;
+    }
+    cache->lru_head = page;
+}
+
+static void set_dirty(page_cache_page_t* page) {
+    page_cache_mapping_t* mapping = page->mapping;
+    if ((page->flags & PAGE_CACHE_DIRTY) || !mapping->aops->writepage) {
+        return;
+    }
+    page->flags |= PAGE_CACHE_DIRTY;
+    mapping->cache->nrdirty++;
+
+    if (mapping->nrdirty++ == 0) {
+        page_cache_t* cache = mapping->cache;
+        mapping->dirty_prev = NULL;
+        mapping->dirty_next = cache->dirty_head;
+        if (cache->dirty_head) {
+            cache->dirty_head->dirty_prev = mapping;
+        }
+        cache->dirty_head = mapping;
+    }
+}
+
+static void clear_dirty(page_cache_page_t* page) {
+    page_cache_mapping_t* mapping = page->mapping;
+    if (!(page->flags & PAGE_CACHE_DIRTY)) {
+        return;
+    }
+    page->flags &= ~PAGE_CACHE_DIRTY;
+    mapping->cache->nrdirty--;
+
+    if (--mapping->nrdirty == 0) {
+        page_cache_t* cache = mapping->cache;
+        if (mapping->dirty_prev) {
+            mapping->dirty_prev->dirty_next = mapping->dirty_next;
+        } else {
+            cache->dirty_head = mapping->dirty_next;
+        }
+        if (mapping->dirty_next) {
+            mapping->dirty_next->dirty_prev = mapping->dirty_prev;
+        }
+        mapping->dirty_prev = NULL;
+        mapping->dirty_next = NULL;
+    }
+}
+
+/* ================================
+ * Pages
+ * ================================ */
+
+static void page_delete(page_cache_page_t* page) {
+    page_cache_mapping_t* mapping = page->mapping;
+    page_cache_t* cache = mapping->cache;
+
+    clear_dirty(page);
+    if (mapping_evictable(mapping)) {
+        lru_unlink(cache, page);
+    }
+    radix_delete(mapping, page->index);
+    mapping->nrpages--;
+    cache->nrpages--;
+
+    /* An actor still reads it: the last unpin frees it */
+    if (page->pins) {
+        page->flags |= PAGE_CACHE_DETACHED;
+        return;
+    }
+    cache->ops.free_page(cache->ops.ctx, page->data);
+    cache->ops.free(page);
+}
+
+static void page_unpin(page_cache_t* cache, page_cache_page_t* page) {
+    if (--page->pins == 0 && (page->flags & PAGE_CACHE_DETACHED)) {
+        cache->ops.free_page(cache->ops.ctx, page->data);
+        cache->ops.free(page);
+    }
+}
+
+static int page_write_back(page_cache_page_t* page) {
+    page_cache_mapping_t* mapping = page->mapping;
+    mapping->cache->stats.writebacks++;
+    if (mapping->aops->writepage(mapping->host, page->index, page->data) != 0) {
+        return PAGE_CACHE_EIO;  /* Stays dirty */
+    }
+    clear_dirty(page);
+    return PAGE_CACHE_OK;
+}
+
+/* A zeroed page at `index`, making room first if the cache is full */
+static page_cache_page_t* page_new(page_cache_mapping_t* mapping, uint64_t index, int* err) {
+    page_cache_t* cache = mapping->cache;
+
+    if (cache->max_pages && cache->nrpages >= cache->max_pages) {
+        page_cache_shrink(cache, 1);
+    }
+
+    page_cache_page_t* page = (page_cache_page_t*)cache->ops.alloc(sizeof(page_cache_page_t));
+    if (!page) {
+        *err = PAGE_CACHE_ENOMEM;
+        return NULL;
+    }
+    page->data = cache->ops.alloc_page(cache->ops.ctx);
+    if (!page->data) {
+        cache->ops.free(page);
+        *err = PAGE_CACHE_ENOMEM;
+        return NULL;
+    }
+    zero_bytes(page->data, PAGE_CACHE_SIZE);
+    page->mapping = mapping;
+    page->index = index;
+    page->flags = 0;
+    page->pins = 0;
+    page->lru_prev = NULL;
+    page->lru_next = NULL;
+
+    int result = radix_insert(mapping, index, page);
+    if (result != PAGE_CACHE_OK) {
+        cache->ops.free_page(cache->ops.ctx, page->data);
+        cache->ops.free(page);
+        *err = result;
+        return NULL;
+    }
+
+    mapping->nrpages++;
+    cache->nrpages++;
+    if (mapping_evictable(mapping)) {
+        lru_push(cache, page);
+    }
+    return page;
+}
+
+/* Page `index`, from the tree or new; a new page is filled from the file
+ * when `fill` is set. A hit marks the page referenced if `mark` is set,
+ * except for the first use of a read-ahead page, which stands in for the
+ * fill. */
+static page_cache_page_t* page_get(page_cache_mapping_t* mapping, uint64_t index,
+                                   bool fill, bool mark, int* err) {
+    page_cache_t* cache = mapping->cache;
+    page_cache_page_t* page = radix_lookup(mapping, index);
+    if (page) {
+        cache->stats.hits++;
+        if (page->flags & PAGE_CACHE_READAHEAD) {
+            page->flags &= ~PAGE_CACHE_READAHEAD;
+        } else if (mark) {
+            page->flags |= PAGE_CACHE_REFERENCED;
+        }
+        return page;
+    }
+
+    cache->stats.misses++;
+    page = page_new(mapping, index, err);
+    if (!page) {
+        return NULL;
+    }
+
+    if (fill && mapping->aops->readpage) {
+        cache->stats.fills++;
+        if (mapping->aops->readpage(mapping->host, index, page->data) != 0) {
+            page_delete(page);
+            *err = PAGE_CACHE_EIO;
+            return NULL;
+        }
+    }
+    return page;
+}
+
+/* ================================
+ * Public Interface
+ * ================================ */
+
+void page_cache_init(page_cache_t* cache, const page_cache_ops_t* ops, uint32_t max_pages) {
+    if (!cache) {
+        return;
+    }
+    zero_bytes(cache, sizeof(*cache));
+    if (ops) {
+        cache->ops = *ops;
+    }
+    cache->max_pages = max_pages;
+}
+
+void page_cache_mapping_init(page_cache_mapping_t* mapping, page_cache_t* cache,
+                             const page_cache_aops_t* aops, void* host, void* owner) {
+    if (!mapping) {
+        return;
+    }
+    zero_bytes(mapping, sizeof(*mapping));
+    mapping->cache = cache;
+    mapping->aops = aops;
+    mapping->host = host;
+    mapping->owner = owner;
+}
+
+page_cache_page_t* page_cache_find(page_cache_mapping_t* mapping, uint64_t index) {
+    if (!page_cache_mapping_cached(mapping)) {
+        return NULL;
+    }
+    return radix_lookup(mapping, index);
+}
+
+/* ================================
+ * Readahead
+ * ================================ */
+
+/* Fill pages [index, index + nr), all absent, with one readpages call. On
+ * any failure the new pages are dropped; the reader fills them on demand
+ * and sees the error then. */
+static void ra_fill_run(page_cache_mapping_t* mapping, uint64_t index, uint32_t nr) {
+    page_cache_t* cache = mapping->cache;
+    page_cache_page_t* pages[PAGE_CACHE_RA_MAX_PAGES];
+    uint32_t got = 0;
+
+    uint8_t* bounce = (uint8_t*)cache->ops.alloc((size_t)nr * PAGE_CACHE_SIZE);
+    if (!bounce) {
+        return;
+    }
+    while (got < nr) {
+        int err;
+        pages[got] = page_new(mapping, index + got, &err);
+        if (!pages[got]) {
+            break;
+        }
+        got++;
+    }
+
+    bool ok = false;
+    if (got > 0) {
+        zero_bytes(bounce, (size_t)got * PAGE_CACHE_SIZE);
+        cache->stats.fills++;
+        ok = mapping->aops->readpages(mapping->host, index, got, bounce) == 0;
+    }
+    for (uint32_t i = 0; i < got; i++) {
+        if (ok) {
+            copy_bytes(pages[i]->data, bounce + (size_t)i * PAGE_CACHE_SIZE, PAGE_CACHE_SIZE);
+            pages[i]->flags |= PAGE_CACHE_READAHEAD;
+        } else {
+            page_delete(pages[i]);
+        }
+    }
+    if (ok) {
+        cache->stats.readahead += got;
+    }
+    cache->ops.free(bounce);
+}
+
+/* Bring pages [start, start + nr) into the cache, skipping ones present */
+static void ra_submit(page_cache_mapping_t* mapping, uint64_t start, uint32_t nr,
+                      uint64_t size) {
+    page_cache_t* cache = mapping->cache;
+    uint64_t end_page = (size + PAGE_CACHE_SIZE - 1) >> PAGE_CACHE_SHIFT;
+    if (start >= end_page) {
+        return;
+    }
+    if (nr > end_page - start) {
+        nr = (uint32_t)(end_page - start);
+    }
+
+    uint64_t index = start;
+    while (index < start + nr) {
+        if (radix_lookup(mapping, index)) {
+            index++;
+            continue;
+        }
+
+        uint64_t run = index;
+        while (run < start + nr && !radix_lookup(mapping, run)) {
+            run++;
+        }
+
+        if (mapping->aops->readpages) {
+            ra_fill_run(mapping, index, (uint32_t)(run - index));
+        } else {
+            for (uint64_t i = index; i < run; i++) {
+                int err;
+                page_cache_page_t* page = page_new(mapping, i, &err);
+                if (!page) {
+                    break;
+                }
+                cache->stats.fills++;
+                if (mapping->aops->readpage(mapping->host, i, page->data) != 0) {
+                    page_delete(page);
+                    break;
+                }
+                page->flags |= PAGE_CACHE_READAHEAD;
+                cache->stats.readahead++;
+            }
+        }
+        index = run;
+    }
+}
+
+/* Move the window for a read of pages [first, last] */
+static void ra_update(page_cache_mapping_t* mapping, page_cache_ra_t* ra,
+                      uint64_t first, uint64_t last, uint64_t size) {
+    page_cache_t* cache = mapping->cache;
+    bool sequential = first == ra->next_index || first + 1 == ra->next_index;
+    ra->next_index = last + 1;
+
+    if (!sequential) {
+        ra->size = 0;
+        ra->async_size = 0;
+        return;
+    }
+
+    /* Keep the window well inside the page budget so it cannot evict itself */
+    uint32_t max = PAGE_CACHE_RA_MAX_PAGES;
+    if (cache->max_pages && max > cache->max_pages / 4) {
+        max = cache->max_pages / 4;
+    }
+    if (max == 0) {
+        return;
+    }
+
+    if (ra->size == 0 || first >= ra->start + ra->size) {
+        /* New stream: cover the request with room to spare */
+        uint64_t req = last - first + 1;
+        uint64_t want = req * 4;
+        if (want < PAGE_CACHE_RA_MIN_PAGES) {
+            want = PAGE_CACHE_RA_MIN_PAGES;
+        }
+        ra->start = first;
+        ra->size = want > max ? max : (uint32_t)want;
+        ra->async_size = req < ra->size ? ra->size - (uint32_t)req : ra->size;
+    } else if (last >= ra->start + ra->size - ra->async_size) {
+        /* The reader reached the async part: read the next, larger window */
+        uint32_t next = ra->size * 2;
+        ra->start += ra->size;
+        ra->size = next > max ? max : next;
+        ra->async_size = ra->size;
+    } else {
+        return;
+    }
+
+    ra_submit(mapping, ra->start, ra->size, size);
+}
+
+void page_cache_ra_init(page_cache_ra_t* ra) {
+    if (ra) {
+        zero_bytes(ra, sizeof(*ra));
+    }
+}
+
+/**
+ * Read through the cache
+ */
+int64_t page_cache_read(page_cache_mapping_t* mapping, uint64_t pos, void* buffer,
+                        size_t count, uint64_t size) {
+    return page_cache_read_ra(mapping, NULL, pos, buffer, count, size);
+}
+
+/**
+ * Read through the cache, reading ahead for sequential files
+ */
+/* Read actor that copies into the caller's buffer; ctx is the cursor */
+static int64_t copy_actor(void* ctx, const void* data, size_t len) {
+    uint8_t** cursor = (uint8_t**)ctx;
+    copy_bytes(*cursor, data, len);
+    *cursor += len;
+    return (int64_t)len;
+}
+
+int64_t page_cache_read_ra(page_cache_mapping_t* mapping, page_cache_ra_t* ra, uint64_t pos,
+                           void* buffer, size_t count, uint64_t size) {
+    if (!buffer) {
+        return PAGE_CACHE_EIO;
+    }
+    uint8_t* cursor = (uint8_t*)buffer;
+    return page_cache_read_actor(mapping, ra, pos, count, size, copy_actor, &cursor);
+}
+
+int64_t page_cache_read_actor(page_cache_mapping_t* mapping, page_cache_ra_t* ra, uint64_t pos,
+                              size_t count, uint64_t size, page_cache_actor_t actor, void* ctx) {
+    if (!page_cache_mapping_cached(mapping) || !actor) {
+        return PAGE_CACHE_EIO;
+    }
+    if (pos >= size) {
+        return 0;
+    }
+    if (count > size - pos) {
+        count = (size_t)(size - pos);
+    }
+    page_cache_t* cache = mapping->cache;
+
+    /* A sequential reader continuing in the page it last stopped in is not
+     * using it again; marking it would keep a streamed file's pages ahead
+     * of the pages read for it */
+    uint64_t resume = ra ? ra->next_index - 1 : UINT64_MAX;
+    if (ra && count > 0 && mapping->aops->readpage) {
+        ra_update(mapping, ra, pos >> PAGE_CACHE_SHIFT,
+                  (pos + count - 1) >> PAGE_CACHE_SHIFT, size);
+    }
+
+    size_t done = 0;
+    while (done < count) {
+        uint64_t index = (pos + done) >> PAGE_CACHE_SHIFT;
+        uint32_t offset = (uint32_t)((pos + done) & (PAGE_CACHE_SIZE - 1));
+        size_t n = PAGE_CACHE_SIZE - offset;
+        if (n > count - done) {
+            n = count - done;
+        }
+
+        int err = PAGE_CACHE_OK;
+        page_cache_page_t* page = page_get(mapping, index, true, index != resume, &err);
+        if (!page) {
+            return done ? (int64_t)done : err;
+        }
+
+        /* The actor sees the cached bytes themselves */
+        page->pins++;
+        int64_t used = actor(ctx, (uint8_t*)page->data + offset, n);
+        page_unpin(cache, page);
+        if (used < 0) {
+            return done ? (int64_t)done : used;
+        }
+        done += (size_t)used;
+        if ((size_t)used < n) {
+            break;
+        }
+    }
+    return (int64_t)done;
+}
+
+/**
+ * Write into the cache, leaving the pages dirty
+ */
+int64_t page_cache_write(page_cache_mapping_t* mapping, uint64_t pos, const void* buffer,
+                         size_t count, uint64_t size) {
+    if (!page_cache_mapping_cached(mapping) || !buffer) {
+        return PAGE_CACHE_EIO;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    if (mapping->aops->write_limit) {
+        count = mapping->aops->write_limit(mapping->host, pos, count);
+        if (count == 0) {
+            return PAGE_CACHE_ENOSPC;
+        }
+    }
+
+    size_t done = 0;
+    while (done < count) {
+        uint64_t index = (pos + done) >> PAGE_CACHE_SHIFT;
+        uint32_t offset = (uint32_t)((pos + done) & (PAGE_CACHE_SIZE - 1));
+        size_t n = PAGE_CACHE_SIZE - offset;
+        if (n > count - done) {
+            n = count - done;
+        }
+
+        /* A page overwritten whole, or lying past the end, needs no read */
+        bool whole = offset == 0 && n == PAGE_CACHE_SIZE;
+        bool fill = !whole && (index << PAGE_CACHE_SHIFT) < size;
+
+        int err = PAGE_CACHE_OK;
+        page_cache_page_t* page = page_get(mapping, index, fill, true, &err);
+        if (!page) {
+            return done ? (int64_t)done : err;
+        }
+        copy_bytes((uint8_t*)page->data + offset, (const uint8_t*)buffer + done, n);
+        set_dirty(page);
+        done += n;
+    }
+    return (int64_t)done;
+}
+
+/**
+ * Write back a mapping's dirty pages
+ */
+int page_cache_writeback(page_cache_mapping_t* mapping) {
+    if (!page_cache_mapping_cached(mapping)) {
+        return PAGE_CACHE_OK;
+    }
+
+    int result = PAGE_CACHE_OK;
+    uint64_t from = 0;
+    while (mapping->nrdirty > 0) {
+        page_cache_page_t* page = radix_next(mapping, from);
+        if (!page) {
+            break;
+        }
+        from = page->index + 1;
+        if ((page->flags & PAGE_CACHE_DIRTY) && page_write_back(page) != PAGE_CACHE_OK) {
+            result = PAGE_CACHE_EIO;  /* Keep going; report the failure */
+        }
+    }
+    return result;
+}
+
+/**
+ * Write back every dirty mapping of an owner
+ */
+int page_cache_sync(page_cache_t* cache, void* owner) {
+    if (!cache) {
+        return PAGE_CACHE_OK;
+    }
+
+    int result = PAGE_CACHE_OK;
+    page_cache_mapping_t* mapping = cache->dirty_head;
+    while (mapping) {
+        page_cache_mapping_t* next = mapping->dirty_next;
+        if ((!owner || mapping->owner == owner) &&
+            page_cache_writeback(mapping) != PAGE_CACHE_OK) {
+            result = PAGE_CACHE_EIO;
+        }
+        mapping = next;
+    }
+    return result;
+}
+
+/**
+ * Drop pages past a new, smaller size
+ */
+void page_cache_truncate(page_cache_mapping_t* mapping, uint64_t size) {
+    if (!page_cache_mapping_cached(mapping)) {
+        return;
+    }
+
+    uint64_t first = (size + PAGE_CACHE_SIZE - 1) >> PAGE_CACHE_SHIFT;
+    page_cache_page_t* page;
+    while ((page = radix_next(mapping, first)) != NULL) {
+        page_delete(page);
+    }
+
+    uint32_t offset = (uint32_t)(size & (PAGE_CACHE_SIZE - 1));
+    if (offset) {
+        page = radix_lookup(mapping, size >> PAGE_CACHE_SHIFT);
+        if (page) {
+            zero_bytes((uint8_t*)page->data + offset, PAGE_CACHE_SIZE - offset);
+        }
+    }
+}
+
+void page_cache_mapping_release(page_cache_mapping_t* mapping) {
+    if (!mapping || !mapping->cache) {
+        return;
+    }
+    page_cache_page_t* page;
+    while ((page = radix_next(mapping, 0)) != NULL) {
+        page_delete(page);
+    }
+    if (mapping->root) {
+        radix_free_nodes(mapping->cache, mapping->root, mapping->height);
+        mapping->root = NULL;
+        mapping->height = 0;
+    }
+}
+
+/**
+ * Drop an unmounted filesystem's pages
+ */
+void page_cache_invalidate_owner(page_cache_t* cache, void* owner) {
+    if (!cache) {
+        return;
+    }
+    page_cache_page_t* page = cache->lru_head;
+    while (page) {
+        page_cache_page_t* next = page->lru_next;
+        if (page->mapping->owner == owner) {
+            page_delete(page);
+        }
+        page = next;
+    }
+}
+
+/**
+ * Evict from the cold end of the LRU
+ */
+uint32_t page_cache_shrink(page_cache_t* cache, uint32_t nr_pages) {
+    if (!cache) {
+        return 0;
+    }
+
+    uint32_t evicted = 0;
+    uint32_t budget = nr_pages * PAGE_CACHE_EVICT_SCAN;
+    while (evicted < nr_pages && budget-- > 0 && cache->lru_tail) {
+        page_cache_page_t* page = cache->lru_tail;
+
+        /* Second chance for pages used since the last pass; none for pages
+         * an actor is reading */
+        if (page->pins) {
+            lru_unlink(cache, page);
+            lru_push(cache, page);
+            continue;
+        }
+        if (page->flags & PAGE_CACHE_REFERENCED) {
+            page->flags &= ~PAGE_CACHE_REFERENCED;
+            lru_unlink(cache, page);
+            lru_push(cache, page);
+            continue;
+        }
+
+        if ((page->flags & PAGE_CACHE_DIRTY) && page_write_back(page) != PAGE_CACHE_OK) {
+            lru_unlink(cache, page);
+            lru_push(cache, page);
+            continue;
+        }
+
+        page_delete(page);
+        cache->stats.evictions++;
+        evicted++;
+    }
+    return evicted;
+}
+
+void page_cache_get_stats(const page_cache_t* cache, page_cache_stats_t* stats) {
+    if (!cache || !stats) {
+        return;
+    }
+    *stats = cache->stats;
+    stats->pages = cache->nrpages;
+    stats->dirty = cache->nrdirty;
+}
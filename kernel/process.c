@@ -4,6 +4,7 @@
 
 #include "process.h"
 #include "elf.h"
+#include "elf_image_cache.h"
 #include "vmm.h"
 #include "interrupts.h"
 #include "vfs.h"
@@ -30,7 +31,8 @@ process_t* current_process = NULL;
 static process_t* allocate_process(void);
 static void free_process(process_t* proc);
 static int setup_process_memory_layout(process_t* proc);
-static int load_elf_into_process(process_t* proc, const void* elf_data, size_t size);
+static int load_elf_into_process(process_t* proc, const elf_image_key_t* key,
+                                 const void* elf_data, size_t size);
 static uint32_t allocate_pid(void);
 
 /**
@@ -67,6 +69,22 @@ process_t* process_create_from_elf(const char* name, void* elf_data, size_t size
         return NULL;
     }
     
+    /* No file behind the bytes: identical images share by content */
+    elf_image_key_t key;
+    elf_image_key_from_data(&key, elf_data, size);
+    return process_create_from_image(name, &key, elf_data, size);
+}
+
+/**
+ * Create a new process from an executable image named by key. elf_data may
+ * be NULL when the image cache already holds it (see elf_image_cached()).
+ */
+process_t* process_create_from_image(const char* name, const elf_image_key_t* key,
+                                     const void* elf_data, size_t size) {
+    if (!name || !key) {
+        return NULL;
+    }
+    
     /* Allocate process structure */
     process_t* proc = allocate_process();
     if (!proc) {
@@ -93,7 +111,7 @@ process_t* process_create_from_elf(const char* name, void* elf_data, size_t size
     }
     
     /* Load ELF into process memory */
-    if (load_elf_into_process(proc, elf_data, size) != 0) {
+    if (load_elf_into_process(proc, key, elf_data, size) != 0) {
         debug_print("Failed to load ELF for process %s\n", name);
         free_process(proc);
         return NULL;
@@ -193,107 +211,21 @@ static int setup_process_memory_layout(process_t* proc) {
 }
 
 /**
- * Load ELF executable into process memory
+ * Map an ELF executable into process memory. Segments are backed by the
+ * shared image cache and paged in on first touch, so nothing is copied
+ * here and instances of one binary share their text.
  */
-static int load_elf_into_process(process_t* proc, const void* elf_data, size_t size) {
-    const elf64_header_t* header = (const elf64_header_t*)elf_data;
-    
-    /* Verify it's a 64-bit ELF */
-    if (!ELF_IS_64BIT(header)) {
-        debug_print("Only 64-bit ELF files supported\n");
-        return -1;
-    }
-    
-    if (!ELF_IS_EXECUTABLE(header)) {
-        debug_print("ELF file is not executable\n");
+static int load_elf_into_process(process_t* proc, const elf_image_key_t* key,
+                                 const void* elf_data, size_t size) {
+    uint64_t entry_point;
+    if (elf_map_image(proc->address_space, key, elf_data, size, &entry_point) != 0) {
+        debug_print("Failed to map ELF image\n");
         return -1;
     }
     
-    /* Set entry point */
-    proc->context.rip = header->e_entry;
-    
-    /* Load program segments */
-    const elf64_program_header_t* phdrs = (const elf64_program_header_t*)
-        ((const char*)elf_data + header->e_phoff);
-    
-    for (int i = 0; i < header->e_phnum; i++) {
-        const elf64_program_header_t* phdr = &phdrs[i];
-        
-        if (phdr->p_type != PT_LOAD) {
-            continue; /* Skip non-loadable segments */
-        }
-        
-        /* Validate segment is within user space */
-        if (phdr->p_vaddr < USER_SPACE_START || 
-            phdr->p_vaddr + phdr->p_memsz > USER_SPACE_END) {
-            debug_print("ELF segment outside user space\n");
-            return -1;
-        }
-        
-        /* Calculate number of pages needed */
-        uint64_t start_page = phdr->p_vaddr & ~(PAGE_SIZE - 1);
-        uint64_t end_page = (phdr->p_vaddr + phdr->p_memsz + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
-        size_t num_pages = (end_page - start_page) / PAGE_SIZE;
-        
-        /* Allocate and map pages */
-        for (size_t page = 0; page < num_pages; page++) {
-            uint64_t vaddr = start_page + (page * PAGE_SIZE);
-            
-            /* Allocate physical page */
-            uint64_t paddr = vmm_alloc_page();
-            if (paddr == 0) {
-                debug_print("Failed to allocate page for ELF segment\n");
-                return -1;
-            }
-            
-            /* Determine page flags based on segment permissions */
-            uint32_t flags = VMM_FLAG_USER;
-            if (phdr->p_flags & PF_W) {
-                flags |= VMM_FLAG_WRITE;
-            }
-            if (phdr->p_flags & PF_X) {
-                flags |= VMM_FLAG_EXEC;
-            }
-            
-            /* Map the page */
-            if (vmm_map_page(proc->address_space, vaddr, paddr, flags) != 0) {
-                debug_print("Failed to map ELF segment page\n");
-                return -1;
-            }
-        }
-        
-        /* Copy segment data */
-        if (phdr->p_filesz > 0) {
-            /* Switch to process address space temporarily */
-            vm_space_t* old_space = vmm_get_current_space();
-            vmm_switch_address_space(proc->address_space);
-            
-            /* Copy data from ELF file */
-            const char* src = (const char*)elf_data + phdr->p_offset;
-            char* dst = (char*)phdr->p_vaddr;
-            
-            for (size_t j = 0; j < phdr->p_filesz; j++) {
-                dst[j] = src[j];
-            }
-            
-            /* Zero out BSS section if needed */
-            if (phdr->p_memsz > phdr->p_filesz) {
-                for (size_t j = phdr->p_filesz; j < phdr->p_memsz; j++) {
-                    dst[j] = 0;
-                }
-            }
-            
-            /* Switch back to kernel address space */
-            vmm_switch_address_space(old_space);
-        }
-        
-        debug_print("Loaded ELF segment at 0x%lX (size: %lu)\n", 
-                   phdr->p_vaddr, phdr->p_memsz);
-    }
-    
     /* Initialize CPU context for user mode */
     memset(&proc->context, 0, sizeof(proc->context));
-    proc->context.rip = header->e_entry;
+    proc->context.rip = entry_point;
     proc->context.rsp = USER_STACK_TOP - 16; /* Leave some space on stack */
     proc->context.rflags = 0x202; /* Interrupts enabled, reserved bit set */
     proc->context.cs = 0x1B; /* User code segment (GDT entry 3, DPL 3) */
@@ -304,7 +236,7 @@ static int load_elf_into_process(process_t* proc, const void* elf_data, size_t s
     proc->context.ss = 0x23;
     proc->context.cr3 = (uint64_t)proc->address_space;
     
-    debug_print("ELF loaded successfully, entry point: 0x%lX\n", header->e_entry);
+    debug_print("ELF loaded successfully, entry point: 0x%lX\n", entry_point);
     return 0;
 }
 
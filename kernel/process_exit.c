@@ -16,6 +16,10 @@
 extern process_t* current_process;
 extern process_stats_t process_statistics;
 
+/* From thread_syscalls.c */
+extern int thread_cleanup_process_threads(process_t* proc);
+extern void vfork_release(process_t* child);
+
 /* Process exit statistics */
 static struct {
     uint64_t total_exits;           /* Total processes that have exited */
@@ -72,12 +76,22 @@ void process_exit(process_t* proc, int exit_code) {
     process_cleanup_timers(proc);
     process_cleanup_signals(proc);
     
+    /* Step 3b: Reap the process's other threads */
+    thread_cleanup_process_threads(proc);
+    
     /* Step 4: Handle child processes */
     process_reparent_children(proc);
     
     /* Step 5: Notify parent */
     process_notify_parent(proc, exit_code);
     
+    /* Step 5b: A vfork child exiting without exec hands back the memory
+     * it borrowed; it is the parent's to free, not ours */
+    if (proc->vfork_parent) {
+        proc->address_space = NULL;
+        vfork_release(proc);
+    }
+    
     /* Step 6: Clean up memory (but keep process structure for zombie state) */
     process_cleanup_memory(proc);
     
@@ -135,7 +149,11 @@ void process_force_kill(process_t* proc) {
     /* Skip normal cleanup for emergency termination */
     proc->state = PROCESS_STATE_TERMINATED;
     
-    /* Basic cleanup only */
+    /* Basic cleanup only; a vfork child's memory is its parent's */
+    if (proc->vfork_parent) {
+        proc->address_space = NULL;
+        vfork_release(proc);
+    }
     if (proc->address_space) {
         vmm_destroy_address_space(proc->address_space);
         proc->address_space = NULL;
@@ -5,6 +5,7 @@
 #include "process_manager.h"
 #include "process.h"
 #include "elf.h"
+#include "elf_image_cache.h"
 #include "vmm.h"
 #include "interrupts.h"
 #include <stdint.h>
@@ -229,7 +230,20 @@ int pm_create_process(const pm_create_params_t* params, uint32_t* pid_out) {
  * Create process from ELF data
  */
 int pm_create_process_from_elf(const char* name, void* elf_data, size_t elf_size, uint32_t* pid_out) {
-    if (!g_pm_initialized || !name || !elf_data || elf_size == 0 || !pid_out) {
+    if (!elf_data || elf_size == 0) {
+        return PM_ERROR_INVALID_PARAM;
+    }
+    return pm_create_process_from_image(name, NULL, elf_data, elf_size, pid_out);
+}
+
+/**
+ * Create process from an executable named by its file identity. With a key,
+ * elf_data may be NULL if the image cache already holds the image; without
+ * one the image is identified by its bytes.
+ */
+int pm_create_process_from_image(const char* name, const elf_image_key_t* key,
+                                 void* elf_data, size_t elf_size, uint32_t* pid_out) {
+    if (!g_pm_initialized || !name || !pid_out || (!key && !elf_data)) {
         return PM_ERROR_INVALID_PARAM;
     }
     
@@ -250,7 +264,8 @@ int pm_create_process_from_elf(const char* name, void* elf_data, size_t elf_size
     }
     
     /* Create process from ELF */
-    process_t* process = process_create_from_elf(name, elf_data, elf_size);
+    process_t* process = key ? process_create_from_image(name, key, elf_data, elf_size)
+                             : process_create_from_elf(name, elf_data, elf_size);
     if (!process) {
         pm_table_free_pid(pid);
         PM_UNLOCK();
@@ -14,10 +14,9 @@
 #define RAMFS_MAX_FILE_SIZE (64 * 1024)  /* 64KB max file size */
 
 /* RAM filesystem structures */
+/* File data lives in the inode's page cache mapping. With no readpage the
+ * cache holds the only copy, so those pages are never evicted. */
 typedef struct ramfs_inode_info {
-    uint8_t* data;
-    size_t size;
-    size_t capacity;
     bool is_directory;
 } ramfs_inode_info_t;
 
@@ -41,6 +40,7 @@ static int ramfs_open(vfs_inode_t* inode, vfs_file_t* file);
 static int ramfs_release(vfs_inode_t* inode, vfs_file_t* file);
 static ssize_t ramfs_read(vfs_file_t* file, char* buffer, size_t count, loff_t* pos);
 static ssize_t ramfs_write(vfs_file_t* file, const char* buffer, size_t count, loff_t* pos);
+static size_t ramfs_write_limit(void* host, uint64_t pos, size_t len);
 
 /* Function declarations for memory allocation */
 extern void* kmalloc(size_t size);
@@ -74,6 +74,12 @@ static vfs_file_operations_t ramfs_file_ops = {
     .mmap = NULL,  /* Not implemented */
 };
 
+static const page_cache_aops_t ramfs_aops = {
+    .readpage = NULL,  /* No backing store */
+    .writepage = NULL,
+    .write_limit = ramfs_write_limit,
+};
+
 /* RAM filesystem type */
 static vfs_filesystem_t ramfs_fs_type = {
     .name = "ramfs",
@@ -219,9 +225,6 @@ static vfs_inode_t* ramfs_alloc_inode(vfs_superblock_t* sb) {
     
     /* Initialize private data */
     memset(info, 0, sizeof(ramfs_inode_info_t));
-    info->data = NULL;
-    info->size = 0;
-    info->capacity = 0;
     info->is_directory = false;
     
     inode->i_private = info;
@@ -248,10 +251,6 @@ static void ramfs_destroy_inode(vfs_inode_t* inode) {
     
     ramfs_inode_info_t* info = (ramfs_inode_info_t*)inode->i_private;
     if (info) {
-        /* Free data buffer */
-        if (info->data) {
-            kfree(info->data);
-        }
         kfree(info);
     }
     
@@ -318,6 +317,7 @@ static int ramfs_create(vfs_inode_t* dir, const char* name, uint32_t mode) {
     inode->i_mode = VFS_FILE_TYPE_REGULAR;
     inode->i_op = NULL;  /* Regular files don't have inode operations */
     inode->i_fop = &ramfs_file_ops;
+    vfs_inode_set_aops(inode, &ramfs_aops);
     
     return VFS_SUCCESS;
 }
@@ -400,24 +400,13 @@ static ssize_t ramfs_read(vfs_file_t* file, char* buffer, size_t count, loff_t*
         return VFS_ERROR_IS_DIRECTORY;
     }
     
-    /* Check bounds */
-    if (*pos >= (loff_t)info->size) {
-        return 0;  /* EOF */
-    }
-    
-    /* Adjust count if it goes beyond file size */
-    if (*pos + count > info->size) {
-        count = info->size - *pos;
-    }
-    
-    /* Copy data */
-    if (info->data && count > 0) {
-        memcpy(buffer, info->data + *pos, count);
-        *pos += count;
-        return count;
+    int64_t result = page_cache_read(&inode->i_data, *pos, buffer, count, inode->i_size);
+    if (result < 0) {
+        return VFS_ERROR_NO_MEMORY;
     }
     
-    return 0;
+    *pos += result;
+    return result;
 }
 
 /**
@@ -435,45 +424,36 @@ static ssize_t ramfs_write(vfs_file_t* file, const char* buffer, size_t count, l
         return VFS_ERROR_IS_DIRECTORY;
     }
     
-    /* Check if we need to expand the buffer */
+    /* Check the size limit */
     size_t new_size = *pos + count;
     if (new_size > RAMFS_MAX_FILE_SIZE) {
         return VFS_ERROR_NO_SPACE;
     }
     
-    if (new_size > info->capacity) {
-        /* Allocate new buffer */
-        size_t new_capacity = (new_size + 4095) & ~4095;  /* Round up to 4K */
-        if (new_capacity > RAMFS_MAX_FILE_SIZE) {
-            new_capacity = RAMFS_MAX_FILE_SIZE;
-        }
-        
-        uint8_t* new_data = (uint8_t*)kmalloc(new_capacity);
-        if (!new_data) {
-            return VFS_ERROR_NO_MEMORY;
-        }
-        
-        /* Copy existing data */
-        if (info->data && info->size > 0) {
-            memcpy(new_data, info->data, info->size);
-            kfree(info->data);
-        }
-        
-        info->data = new_data;
-        info->capacity = new_capacity;
-    }
-    
     /* Write data */
-    memcpy(info->data + *pos, buffer, count);
-    *pos += count;
+    int64_t result = page_cache_write(&inode->i_data, *pos, buffer, count, inode->i_size);
+    if (result < 0) {
+        return result == PAGE_CACHE_ENOSPC ? VFS_ERROR_NO_SPACE : VFS_ERROR_NO_MEMORY;
+    }
+    *pos += result;
     
     /* Update file size */
-    if (new_size > info->size) {
-        info->size = new_size;
-        inode->i_size = new_size;
+    if ((uint64_t)*pos > inode->i_size) {
+        inode->i_size = *pos;
     }
     
-    return count;
+    return result;
+}
+
+/**
+ * Files stop at RAMFS_MAX_FILE_SIZE
+ */
+static size_t ramfs_write_limit(void* host, uint64_t pos, size_t len) {
+    (void)host;
+    if (pos >= RAMFS_MAX_FILE_SIZE) {
+        return 0;
+    }
+    return RAMFS_MAX_FILE_SIZE - pos < len ? (size_t)(RAMFS_MAX_FILE_SIZE - pos) : len;
 }
 
 /* ================================
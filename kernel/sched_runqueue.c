@@ -0,0 +1,129 @@
+/* IKOS Preemptive Task Scheduler - Per-CPU run queue
+ *
+ * See include/sched_runqueue.h. Pure data structure; the scheduler holds the
+ * owning CPU's lock around every call.
+ */
+
+#include "sched_runqueue.h"
+#include "scheduler.h"
+
+static inline void level_set(sched_runqueue_t* rq, uint8_t level) {
+    rq->bitmap[level >> 6] |= 1ULL << (level & 63);
+}
+
+static inline void level_clear(sched_runqueue_t* rq, uint8_t level) {
+    rq->bitmap[level >> 6] &= ~(1ULL << (level & 63));
+}
+
+void sched_rq_init(sched_runqueue_t* rq, uint32_t cpu) {
+    if (!rq) {
+        return;
+    }
+    for (uint32_t i = 0; i < SCHED_PRIO_LEVELS; i++) {
+        rq->head[i] = 0;
+        rq->tail[i] = 0;
+    }
+    for (uint32_t i = 0; i < SCHED_BITMAP_WORDS; i++) {
+        rq->bitmap[i] = 0;
+    }
+    rq->nr_ready = 0;
+    rq->cpu = cpu;
+}
+
+void sched_rq_enqueue(sched_runqueue_t* rq, task_t* task, uint8_t level) {
+    if (!rq || !task || task->on_rq) {
+        return;
+    }
+
+    task->next = 0;
+    task->prev = rq->tail[level];
+    if (rq->tail[level]) {
+        rq->tail[level]->next = task;
+    } else {
+        rq->head[level] = task;
+        level_set(rq, level);
+    }
+    rq->tail[level] = task;
+
+    task->rq_level = level;
+    task->cpu = rq->cpu;
+    task->on_rq = true;
+    rq->nr_ready++;
+}
+
+void sched_rq_dequeue(sched_runqueue_t* rq, task_t* task) {
+    if (!rq || !task || !task->on_rq) {
+        return;
+    }
+
+    uint8_t level = task->rq_level;
+    if (task->prev) {
+        task->prev->next = task->next;
+    } else {
+        rq->head[level] = task->next;
+    }
+    if (task->next) {
+        task->next->prev = task->prev;
+    } else {
+        rq->tail[level] = task->prev;
+    }
+    if (!rq->head[level]) {
+        level_clear(rq, level);
+    }
+
+    task->next = task->prev = 0;
+    task->on_rq = false;
+    rq->nr_ready--;
+}
+
+int sched_rq_highest_level(const sched_runqueue_t* rq) {
+    if (!rq) {
+        return -1;
+    }
+    for (uint32_t w = 0; w < SCHED_BITMAP_WORDS; w++) {
+        if (rq->bitmap[w]) {
+            return (int)(w * 64 + (uint32_t)__builtin_ctzll(rq->bitmap[w]));
+        }
+    }
+    return -1;
+}
+
+task_t* sched_rq_peek(const sched_runqueue_t* rq) {
+    int level = sched_rq_highest_level(rq);
+    return level < 0 ? 0 : rq->head[level];
+}
+
+task_t* sched_rq_pop(sched_runqueue_t* rq) {
+    task_t* task = sched_rq_peek(rq);
+    if (task) {
+        sched_rq_dequeue(rq, task);
+    }
+    return task;
+}
+
+uint32_t sched_rq_find_busiest(const sched_runqueue_t* rqs, uint32_t n,
+                               uint32_t self, uint32_t min_ready) {
+    uint32_t busiest = n;
+    uint32_t most = 0;
+    if (!rqs) {
+        return n;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        if (i == self || rqs[i].nr_ready < min_ready) {
+            continue;
+        }
+        if (busiest == n || rqs[i].nr_ready > most) {
+            busiest = i;
+            most = rqs[i].nr_ready;
+        }
+    }
+    return busiest;
+}
+
+task_t* sched_rq_steal(sched_runqueue_t* src, uint32_t dst_cpu) {
+    task_t* task = sched_rq_pop(src);
+    if (task) {
+        task->cpu = dst_cpu;
+    }
+    return task;
+}
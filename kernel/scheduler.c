@@ -1,11 +1,16 @@
 /* IKOS Preemptive Task Scheduler Implementation
  * Provides Round Robin and Priority-based preemptive scheduling
+ *
+ * Every CPU owns a run queue, its current and idle task, its statistics and
+ * its deterministic-preemption record. A CPU that would otherwise go idle
+ * pulls a task from the busiest other queue.
  */
 
 #include "scheduler.h"
 #include "memory.h"
 #include "interrupts.h"
 #include "sched_record.h"
+#include "timer_wheel.h"
 #include <string.h>
 
 /* Orthogonal persistence (#117): drive the periodic checkpoint trigger from
@@ -19,32 +24,60 @@ extern bool checkpoint_tick(void);
 extern uint64_t checkpoint_current_epoch(void);
 
 #define SCHED_REC_MAX_POINTS 256
-static uint64_t g_sched_points[SCHED_REC_MAX_POINTS];
-static sched_record_t g_sched_rec;
-static uint64_t g_sched_lclock = 0;   /* logical clock since the current epoch */
+
+/* Per-CPU scheduler state */
+typedef struct sched_cpu {
+    task_t* current;                /* Task running on this CPU */
+    task_t* idle;                   /* This CPU's idle task */
+    volatile int lock;              /* Protects run_queues[cpu] */
+    bool online;                    /* Taking ticks and scheduling */
+    scheduler_stats_t stats;
+    
+    /* Deterministic preemption (#162): each CPU records its own switches */
+    sched_record_t rec;
+    uint64_t points[SCHED_REC_MAX_POINTS];
+    uint64_t lclock;                /* logical clock since the current epoch */
+} sched_cpu_t;
+
+static sched_cpu_t sched_cpus[SCHED_MAX_CPUS];
+static sched_runqueue_t run_queues[SCHED_MAX_CPUS];
+static uint32_t online_cpu_count = 0;
 
 /* Global scheduler state */
-static task_t* current_task = NULL;
-static task_t* idle_task = NULL;
 static task_t* task_list[MAX_TASKS];
 static uint32_t next_pid = 1;
 static bool scheduler_enabled = false;
-static scheduler_stats_t stats;
+static scheduler_stats_t stats;     /* Sum over CPUs, see get_scheduler_stats() */
+
+/* In round-robin mode every task shares one queue level, so each queue is a
+ * single FIFO; the priority policy queues a task at its own priority. */
+#define RR_QUEUE_LEVEL  PRIORITY_NORMAL
 
-/* Ready queues for different priorities */
-static task_t* ready_queues[256] = {0};  /* One queue per priority level */
-static task_t* round_robin_queue = NULL;
+/* IA32_TSC_AUX holds the CPU index so RDTSCP can report it */
+#define MSR_TSC_AUX     0xC0000103
+
+/* CPUID 0x80000001 EDX: RDTSCP and IA32_TSC_AUX are implemented */
+#define CPUID_EXT_FEATURES      0x80000001
+#define CPUID_EDX_RDTSCP        (1U << 27)
+
+/* Without RDTSCP there is no cheap way to tell CPUs apart, so the
+ * scheduler stays on the boot CPU */
+static bool have_rdtscp = false;
 
 /* Scheduler policy and configuration */
 static sched_policy_t current_policy = SCHED_ROUND_ROBIN;
 static uint32_t default_time_slice = TIME_SLICE_DEFAULT;
 
 /* Timer frequency (Hz) */
-#define TIMER_FREQUENCY 1000
+#define TIMER_FREQUENCY KTIMER_HZ
 
 /* Forward declarations */
 static void idle_task_func(void);
 static task_t* create_idle_task(void);
+static int init_cpu(uint32_t cpu);
+static task_t* steal_task(uint32_t cpu);
+static bool load_balance_allowed(void);
+static bool detect_rdtscp(void);
 static void save_context(task_t* task);
 static void restore_context(task_t* task);
 
@@ -55,25 +88,28 @@ int scheduler_init(sched_policy_t policy, uint32_t time_slice) {
     // Initialize scheduler state
     memset(&stats, 0, sizeof(scheduler_stats_t));
     memset(task_list, 0, sizeof(task_list));
-    memset(ready_queues, 0, sizeof(ready_queues));
+    memset(sched_cpus, 0, sizeof(sched_cpus));
+    online_cpu_count = 0;
     
     current_policy = policy;
     default_time_slice = time_slice;
     stats.policy = policy;
     stats.time_slice = time_slice;
 
-    /* Deterministic preemption starts OFF: identical behavior to before, until
-     * a record or replay run enables it (#162). */
-    sched_record_init(&g_sched_rec, SCHED_REC_OFF, g_sched_points, SCHED_REC_MAX_POINTS);
-    g_sched_lclock = 0;
+    for (uint32_t cpu = 0; cpu < SCHED_MAX_CPUS; cpu++) {
+        sched_rq_init(&run_queues[cpu], cpu);
+        /* Deterministic preemption starts OFF: identical behavior to before,
+         * until a record or replay run enables it (#162). */
+        sched_record_init(&sched_cpus[cpu].rec, SCHED_REC_OFF,
+                          sched_cpus[cpu].points, SCHED_REC_MAX_POINTS);
+    }
 
-    // Create idle task
-    idle_task = create_idle_task();
-    if (!idle_task) {
+    // The boot CPU is CPU 0 (IA32_TSC_AUX resets to 0)
+    have_rdtscp = detect_rdtscp();
+    if (init_cpu(0) != 0) {
         return -1;
     }
     
-    current_task = idle_task;
     scheduler_enabled = false;
     
     // Setup timer interrupt for preemption
@@ -91,6 +127,52 @@ void scheduler_start(void) {
     enable_interrupts();
 }
 
+/**
+ * Bring the calling CPU online as `cpu`
+ */
+int scheduler_cpu_online(uint32_t cpu) {
+    if (cpu == 0 || cpu >= SCHED_MAX_CPUS || sched_cpus[cpu].online || !have_rdtscp) {
+        return -1;
+    }
+    
+    // Let RDTSCP identify this CPU from now on
+    __asm__ volatile("wrmsr" : : "c"(MSR_TSC_AUX), "a"(cpu), "d"(0));
+    
+    return init_cpu(cpu);
+}
+
+/**
+ * Index of the CPU executing this code
+ */
+uint32_t scheduler_this_cpu(void) {
+    if (!have_rdtscp) {
+        return 0;
+    }
+    uint32_t aux;
+    __asm__ volatile("rdtscp" : "=c"(aux) : : "rax", "rdx");
+    return aux < SCHED_MAX_CPUS ? aux : 0;
+}
+
+/**
+ * Whether the CPU implements RDTSCP (and so IA32_TSC_AUX)
+ */
+static bool detect_rdtscp(void) {
+    uint32_t eax, ebx, ecx, edx;
+    __asm__ volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0x80000000U));
+    if (eax < CPUID_EXT_FEATURES) {
+        return false;
+    }
+    __asm__ volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(CPUID_EXT_FEATURES));
+    return (edx & CPUID_EDX_RDTSCP) != 0;
+}
+
+/**
+ * Number of CPUs the scheduler is running on
+ */
+uint32_t scheduler_online_cpus(void) {
+    return online_cpu_count;
+}
+
 /**
  * Stop the scheduler
  */
@@ -137,6 +219,18 @@ task_t* task_create(const char* name, void* entry_point, uint8_t priority, uint3
         return NULL;
     }
     
+    // Start on the least loaded CPU; under record/replay keep tasks where
+    // they were created so placement cannot depend on timing
+    task->cpu = scheduler_this_cpu();
+    if (load_balance_allowed()) {
+        for (uint32_t cpu = 0; cpu < SCHED_MAX_CPUS; cpu++) {
+            if (sched_cpus[cpu].online &&
+                run_queues[cpu].nr_ready < run_queues[task->cpu].nr_ready) {
+                task->cpu = cpu;
+            }
+        }
+    }
+    
     // Initialize context
     memset(&task->context, 0, sizeof(task->context));
     task->context.rip = (uint64_t)entry_point;
@@ -161,7 +255,7 @@ task_t* task_create(const char* name, void* entry_point, uint8_t priority, uint3
  */
 int task_destroy(uint32_t pid) {
     task_t* task = task_get_by_pid(pid);
-    if (!task || task == idle_task) {
+    if (!task || pid == 0) {
         return -1; // Can't destroy idle task or non-existent task
     }
     
@@ -180,7 +274,7 @@ int task_destroy(uint32_t pid) {
     }
     
     // If this is the current task, schedule next
-    if (task == current_task) {
+    if (task == task_get_current()) {
         task->state = TASK_TERMINATED;
         schedule();
     }
@@ -199,7 +293,7 @@ void schedule(void) {
         return;
     }
     
-    task_t* prev_task = current_task;
+    task_t* prev_task = sched_cpus[scheduler_this_cpu()].current;
     task_t* next_task = scheduler_pick_next();
     
     if (next_task != prev_task) {
@@ -211,47 +305,66 @@ void schedule(void) {
  * Timer interrupt handler - called every timer tick
  */
 void scheduler_tick(void) {
-    stats.total_interrupts++;
+    uint32_t cpu = scheduler_this_cpu();
+    sched_cpu_t* c = &sched_cpus[cpu];
+    c->stats.total_interrupts++;
 
     /* Periodic orthogonal-persistence checkpoint (#117). Runs every tick so the
      * cadence holds even while the CPU is otherwise idle; it self-gates on the
-     * configured interval and skips if a checkpoint is still being written. */
-    checkpoint_tick();
+     * configured interval and skips if a checkpoint is still being written.
+     * The boot CPU alone drives it, so the cadence does not scale with CPUs. */
+    if (cpu == 0) {
+        checkpoint_tick();
+        /* Kernel timers: sleeps, timeouts and periodic work. One CPU drives
+         * the wheel so every timer sees a single clock. */
+        ktimer_tick();
+    }
 
+    task_t* current_task = c->current;
     if (!scheduler_enabled || !current_task) {
         return;
     }
     
     // Update current task time
     current_task->cpu_time++;
+    if (current_task == c->idle) {
+        c->stats.idle_ticks++;
+    }
 
     /* Deterministic preemption (#162): advance the per-epoch logical clock and
      * route the preemption decision through the record/replay filter. In OFF
      * mode (the default) the natural round-robin decision passes through
      * unchanged; RECORD notes the switch point; REPLAY forces switches at the
      * recorded points so real tick timing cannot perturb the schedule. */
-    if (g_sched_rec.mode != SCHED_REC_OFF) {
+    if (c->rec.mode != SCHED_REC_OFF) {
         uint64_t epoch = checkpoint_current_epoch();
-        if (epoch != g_sched_rec.epoch) {
-            sched_record_begin_epoch(&g_sched_rec, epoch);
-            g_sched_lclock = 0;
+        if (epoch != c->rec.epoch) {
+            sched_record_begin_epoch(&c->rec, epoch);
+            c->lclock = 0;
         }
     }
-    g_sched_lclock++;
+    c->lclock++;
 
     // Decrement time slice for current task
     if (current_task->time_slice > 0) {
         current_task->time_slice--;
     }
 
-    // Preempt when Round Robin's slice expires, filtered for deterministic replay
+    // Preempt when Round Robin's slice expires, or leave idle as soon as
+    // there is work to pull; filtered for deterministic replay
     bool want = (current_policy == SCHED_ROUND_ROBIN && current_task->time_slice == 0);
-    if (sched_record_decide(&g_sched_rec, want, g_sched_lclock)) {
+    if (current_task == c->idle && !want) {
+        want = run_queues[cpu].nr_ready > 0 ||
+               (load_balance_allowed() &&
+                sched_rq_find_busiest(run_queues, SCHED_MAX_CPUS, cpu, 1) < SCHED_MAX_CPUS);
+    }
+    if (sched_record_decide(&c->rec, want, c->lclock)) {
         // Reset time slice
         current_task->time_slice = current_task->quantum;
 
-        // Move to end of ready queue and schedule
-        if (current_task->state == TASK_RUNNING) {
+        // Move to end of ready queue and schedule; the idle task is never
+        // queued, it is what a CPU runs when its queue is empty
+        if (current_task->state == TASK_RUNNING && current_task != c->idle) {
             current_task->state = TASK_READY;
             ready_queue_add(current_task);
         }
@@ -265,15 +378,33 @@ void scheduler_tick(void) {
  * preemption points. Default mode is OFF, so these have no effect until called.
  */
 void scheduler_preempt_set_mode(sched_rec_mode_t mode) {
-    sched_record_set_mode(&g_sched_rec, mode);
+    for (uint32_t cpu = 0; cpu < SCHED_MAX_CPUS; cpu++) {
+        sched_record_set_mode(&sched_cpus[cpu].rec, mode);
+    }
 }
 
 uint32_t scheduler_preempt_points(const uint64_t** out) {
-    return sched_record_points(&g_sched_rec, out);
+    return scheduler_preempt_points_cpu(0, out);
 }
 
 int scheduler_preempt_load(uint64_t epoch, const uint64_t* pts, uint32_t n) {
-    return sched_record_load(&g_sched_rec, epoch, pts, n);
+    return scheduler_preempt_load_cpu(0, epoch, pts, n);
+}
+
+uint32_t scheduler_preempt_points_cpu(uint32_t cpu, const uint64_t** out) {
+    if (cpu >= SCHED_MAX_CPUS) {
+        if (out) *out = NULL;
+        return 0;
+    }
+    return sched_record_points(&sched_cpus[cpu].rec, out);
+}
+
+int scheduler_preempt_load_cpu(uint32_t cpu, uint64_t epoch,
+                               const uint64_t* pts, uint32_t n) {
+    if (cpu >= SCHED_MAX_CPUS) {
+        return SCHED_REC_ERR_PARAM;
+    }
+    return sched_record_load(&sched_cpus[cpu].rec, epoch, pts, n);
 }
 
 /**
@@ -296,7 +427,7 @@ task_t* scheduler_pick_next(void) {
     
     // Fallback to idle task if no other task available
     if (!next_task) {
-        next_task = idle_task;
+        next_task = sched_cpus[scheduler_this_cpu()].idle;
     }
     
     return next_task;
@@ -313,15 +444,9 @@ task_t* rr_pick_next(void) {
  * Priority-based scheduler - pick highest priority ready task
  */
 task_t* priority_pick_next(void) {
-    // Find highest priority ready task
-    for (int priority = PRIORITY_HIGHEST; priority <= PRIORITY_LOWEST; priority++) {
-        if (ready_queues[priority] != NULL) {
-            task_t* task = ready_queues[priority];
-            ready_queue_remove(task);
-            return task;
-        }
-    }
-    return NULL;
+    // Tasks are queued at their priority, so the queue's bitmap pick is
+    // already the highest priority ready task
+    return ready_queue_next();
 }
 
 /**
@@ -332,7 +457,8 @@ void context_switch(task_t* prev, task_t* next) {
         return;
     }
     
-    stats.total_switches++;
+    uint32_t cpu = scheduler_this_cpu();
+    sched_cpus[cpu].stats.total_switches++;
     
     // Save previous task context
     if (prev && prev->state == TASK_RUNNING) {
@@ -342,7 +468,8 @@ void context_switch(task_t* prev, task_t* next) {
     }
     
     // Set new current task
-    current_task = next;
+    sched_cpus[cpu].current = next;
+    next->cpu = cpu;
     next->state = TASK_RUNNING;
     next->switches++;
     
@@ -350,6 +477,28 @@ void context_switch(task_t* prev, task_t* next) {
     restore_context(next);
 }
 
+/**
+ * Take a CPU's run queue lock with interrupts off: the timer tick takes
+ * the same lock, and must not find it held by the code it interrupted.
+ * Returns the RFLAGS to hand back to rq_unlock().
+ */
+static uint64_t rq_lock(uint32_t cpu) {
+    uint64_t flags;
+    __asm__ volatile("pushfq; popq %0; cli" : "=r"(flags) : : "memory");
+    while (__sync_lock_test_and_set(&sched_cpus[cpu].lock, 1)) {
+        __asm__ volatile("pause");
+    }
+    return flags;
+}
+
+/**
+ * Release a CPU's run queue lock and restore the interrupt flag
+ */
+static void rq_unlock(uint32_t cpu, uint64_t flags) {
+    __sync_lock_release(&sched_cpus[cpu].lock);
+    __asm__ volatile("pushq %0; popfq" : : "r"(flags) : "memory", "cc");
+}
+
 /**
  * Add task to ready queue
  */
@@ -358,29 +507,18 @@ void ready_queue_add(task_t* task) {
         return;
     }
     
-    if (current_policy == SCHED_PRIORITY) {
-        // Add to priority-specific queue
-        uint8_t priority = task->priority;
-        task->next = ready_queues[priority];
-        if (ready_queues[priority]) {
-            ready_queues[priority]->prev = task;
-        }
-        ready_queues[priority] = task;
-        task->prev = NULL;
-    } else {
-        // Add to round robin queue
-        if (round_robin_queue == NULL) {
-            round_robin_queue = task;
-            task->next = task->prev = task; // Circular list
-        } else {
-            task->next = round_robin_queue;
-            task->prev = round_robin_queue->prev;
-            round_robin_queue->prev->next = task;
-            round_robin_queue->prev = task;
-        }
+    // Requeue on the CPU the task last ran on, while it is still cache-warm
+    uint32_t cpu = task->cpu;
+    if (cpu >= SCHED_MAX_CPUS || !sched_cpus[cpu].online) {
+        cpu = scheduler_this_cpu();
     }
     
-    stats.ready_tasks++;
+    uint8_t level = (current_policy == SCHED_PRIORITY) ? task->priority : RR_QUEUE_LEVEL;
+    
+    uint64_t flags = rq_lock(cpu);
+    sched_rq_enqueue(&run_queues[cpu], task, level);
+    sched_cpus[cpu].stats.ready_tasks = run_queues[cpu].nr_ready;
+    rq_unlock(cpu, flags);
 }
 
 /**
@@ -391,50 +529,40 @@ void ready_queue_remove(task_t* task) {
         return;
     }
     
-    if (current_policy == SCHED_PRIORITY) {
-        // Remove from priority queue
-        uint8_t priority = task->priority;
-        if (ready_queues[priority] == task) {
-            ready_queues[priority] = task->next;
-        }
-        if (task->prev) {
-            task->prev->next = task->next;
+    // A steal can move the task between reading task->cpu and locking
+    for (;;) {
+        uint32_t cpu = task->cpu;
+        if (cpu >= SCHED_MAX_CPUS) {
+            return;
         }
-        if (task->next) {
-            task->next->prev = task->prev;
-        }
-    } else {
-        // Remove from round robin queue
-        if (task->next == task) {
-            // Only task in queue
-            round_robin_queue = NULL;
-        } else {
-            task->prev->next = task->next;
-            task->next->prev = task->prev;
-            if (round_robin_queue == task) {
-                round_robin_queue = task->next;
-            }
+        
+        uint64_t flags = rq_lock(cpu);
+        if (task->cpu == cpu) {
+            sched_rq_dequeue(&run_queues[cpu], task);
+            sched_cpus[cpu].stats.ready_tasks = run_queues[cpu].nr_ready;
+            rq_unlock(cpu, flags);
+            return;
         }
+        rq_unlock(cpu, flags);
     }
-    
-    task->next = task->prev = NULL;
-    stats.ready_tasks--;
 }
 
 /**
  * Get next task from ready queue
  */
 task_t* ready_queue_next(void) {
-    if (current_policy == SCHED_PRIORITY) {
-        return priority_pick_next();
-    }
+    uint32_t cpu = scheduler_this_cpu();
     
-    if (round_robin_queue == NULL) {
-        return NULL;
+    uint64_t flags = rq_lock(cpu);
+    task_t* task = sched_rq_pop(&run_queues[cpu]);
+    sched_cpus[cpu].stats.ready_tasks = run_queues[cpu].nr_ready;
+    rq_unlock(cpu, flags);
+    
+    // Nothing local: pull work rather than idle
+    if (!task) {
+        task = steal_task(cpu);
     }
     
-    task_t* task = round_robin_queue;
-    ready_queue_remove(task);
     return task;
 }
 
@@ -442,7 +570,7 @@ task_t* ready_queue_next(void) {
  * Get current running task
  */
 task_t* task_get_current(void) {
-    return current_task;
+    return sched_cpus[scheduler_this_cpu()].current;
 }
 
 /**
@@ -461,7 +589,9 @@ task_t* task_get_by_pid(uint32_t pid) {
  * System call: yield CPU voluntarily
  */
 void sys_yield(void) {
-    if (current_task && current_task != idle_task) {
+    sched_cpu_t* c = &sched_cpus[scheduler_this_cpu()];
+    task_t* current_task = c->current;
+    if (current_task && current_task != c->idle) {
         current_task->state = TASK_READY;
         ready_queue_add(current_task);
         schedule();
@@ -469,12 +599,103 @@ void sys_yield(void) {
 }
 
 /**
- * Get scheduler statistics
+ * Get scheduler statistics, summed over all online CPUs
  */
 scheduler_stats_t* get_scheduler_stats(void) {
+    stats.total_switches = 0;
+    stats.total_interrupts = 0;
+    stats.ready_tasks = 0;
+    stats.idle_ticks = 0;
+    stats.steals = 0;
+    stats.stolen = 0;
+    
+    for (uint32_t cpu = 0; cpu < SCHED_MAX_CPUS; cpu++) {
+        if (!sched_cpus[cpu].online) {
+            continue;
+        }
+        scheduler_stats_t* s = &sched_cpus[cpu].stats;
+        stats.total_switches += s->total_switches;
+        stats.total_interrupts += s->total_interrupts;
+        stats.ready_tasks += s->ready_tasks;
+        stats.idle_ticks += s->idle_ticks;
+        stats.steals += s->steals;
+        stats.stolen += s->stolen;
+    }
+    
     return &stats;
 }
 
+/**
+ * Get one CPU's scheduler statistics
+ */
+scheduler_stats_t* get_cpu_scheduler_stats(uint32_t cpu) {
+    if (cpu >= SCHED_MAX_CPUS || !sched_cpus[cpu].online) {
+        return NULL;
+    }
+    return &sched_cpus[cpu].stats;
+}
+
+/**
+ * Set up a CPU's idle task and statistics and mark it online
+ */
+static int init_cpu(uint32_t cpu) {
+    sched_cpu_t* c = &sched_cpus[cpu];
+    
+    c->idle = create_idle_task();
+    if (!c->idle) {
+        return -1;
+    }
+    c->idle->cpu = cpu;
+    c->current = c->idle;
+    
+    memset(&c->stats, 0, sizeof(c->stats));
+    c->stats.policy = current_policy;
+    c->stats.time_slice = default_time_slice;
+    c->lclock = 0;
+    
+    c->online = true;
+    online_cpu_count++;
+    return 0;
+}
+
+/**
+ * Whether tasks may move between CPUs. Record and replay pin tasks to the
+ * CPU they were created on: placement by load would depend on timing, and
+ * each CPU's recorded switch points only reproduce its own queue.
+ */
+static bool load_balance_allowed(void) {
+    return online_cpu_count > 1 && sched_cpus[0].rec.mode == SCHED_REC_OFF;
+}
+
+/**
+ * Pull the next task for an idle CPU from the busiest other run queue
+ */
+static task_t* steal_task(uint32_t cpu) {
+    if (!load_balance_allowed()) {
+        return NULL;
+    }
+    
+    // Unlocked read of the queue lengths is only a hint; the steal itself
+    // runs under the source queue's lock
+    uint32_t src = sched_rq_find_busiest(run_queues, SCHED_MAX_CPUS, cpu, 1);
+    if (src >= SCHED_MAX_CPUS) {
+        return NULL;
+    }
+    
+    uint64_t flags = rq_lock(src);
+    task_t* task = sched_rq_steal(&run_queues[src], cpu);
+    sched_cpus[src].stats.ready_tasks = run_queues[src].nr_ready;
+    if (task) {
+        sched_cpus[src].stats.stolen++;
+    }
+    rq_unlock(src, flags);
+    
+    if (task) {
+        sched_cpus[cpu].stats.steals++;
+    }
+    return task;
+}
+
 /**
  * Create idle task
  */
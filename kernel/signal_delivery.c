@@ -197,6 +197,42 @@ static const uint64_t g_coalescable_signals =
 /* Signals that cannot be blocked */
 static const uint64_t g_unblockable_signals = (1ULL << SIGKILL) | (1ULL << SIGSTOP);
 
+/* Delivery order: signals of each standard priority class, then RT signals */
+#define SIGNAL_DELIVERY_LEVELS  (SIGNAL_PRIORITY_LOW + 2)
+static uint64_t g_delivery_order[SIGNAL_DELIVERY_LEVELS];
+static bool g_delivery_order_built = false;
+
+/**
+ * Group signals by priority class for find-first-set selection
+ */
+static void build_delivery_order(void) {
+    if (g_delivery_order_built) {
+        return;
+    }
+    for (int signal = 1; signal < SIGNAL_STD_COUNT; signal++) {
+        uint8_t priority = g_signal_priorities[signal];
+        if (priority <= SIGNAL_PRIORITY_LOW) {
+            g_delivery_order[priority] |= 1ULL << signal;
+        }
+    }
+    /* RT priority rises as the number falls, which ctz already gives */
+    g_delivery_order[SIGNAL_PRIORITY_LOW + 1] = SIGNAL_RT_MASK;
+    g_delivery_order_built = true;
+}
+
+/**
+ * Signals the process currently blocks
+ */
+static uint64_t signal_blocked_mask(process_t* proc) {
+    uint64_t blocked = proc->signal_mask;
+
+    if (proc->signal_delivery_state) {
+        blocked |= ((signal_delivery_state_t*)proc->signal_delivery_state)->blocked_mask;
+    }
+
+    return blocked & ~g_unblockable_signals;
+}
+
 /* ========================== Signal Delivery Core Functions ========================== */
 
 /**
@@ -211,6 +247,7 @@ int signal_delivery_init(void) {
     /* Set default limits */
     g_signal_manager.max_concurrent_deliveries = 100;
     g_signal_manager.delivery_enabled = true;
+    build_delivery_order();
     
     KLOG_INFO("Signal delivery subsystem initialized");
     return 0;
@@ -246,24 +283,8 @@ int signal_delivery_init_process(process_t* proc) {
     /* Initialize state */
     state->max_pending = SIGNAL_MAX_PENDING;
     kernel_spinlock_init(&state->state_lock);
-    
-    /* Create signal queues for all signals */
-    for (int i = 1; i < 64; i++) {
-        bool is_rt = signal_is_realtime(i);
-        uint32_t max_size = is_rt ? SIGNAL_QUEUE_MAX_SIZE : 64;
-        
-        state->queues[i] = signal_queue_create(i, max_size, is_rt);
-        if (!state->queues[i]) {
-            /* Cleanup on failure */
-            for (int j = 1; j < i; j++) {
-                if (state->queues[j]) {
-                    signal_queue_destroy(state->queues[j]);
-                }
-            }
-            kfree(state);
-            return -1;
-        }
-    }
+    signal_pending_init(&state->pending);
+    build_delivery_order();
     
     /* Attach to process */
     proc->signal_delivery_state = state;
@@ -282,13 +303,6 @@ void signal_delivery_cleanup_process(process_t* proc) {
     
     signal_delivery_state_t* state = (signal_delivery_state_t*)proc->signal_delivery_state;
     
-    /* Destroy all signal queues */
-    for (int i = 1; i < 64; i++) {
-        if (state->queues[i]) {
-            signal_queue_destroy(state->queues[i]);
-        }
-    }
-    
     /* Free state structure */
     kfree(state);
     proc->signal_delivery_state = NULL;
@@ -310,20 +324,6 @@ int signal_generate(process_t* target_proc, int signal, const siginfo_t* info,
         return -1;
     }
     
-    /* Check if signal is blocked (unless forced or unblockable) */
-    if (!(flags & SIGNAL_DELIVER_FORCE) && !signal_can_deliver(target_proc, signal)) {
-        if (signal_is_blocked(target_proc, signal)) {
-            /* Signal is blocked, add to pending mask but don't queue for non-RT signals */
-            if (!signal_is_realtime(signal)) {
-                spin_lock(&state->state_lock);
-                state->pending_mask |= (1ULL << signal);
-                spin_unlock(&state->state_lock);
-                g_signal_manager.global_stats.signals_blocked++;
-                return 0;
-            }
-        }
-    }
-    
     /* Create signal info if not provided */
     siginfo_t signal_info;
     if (info) {
@@ -335,49 +335,42 @@ int signal_generate(process_t* target_proc, int signal, const siginfo_t* info,
     /* Set timestamp */
     signal_info.si_timestamp = get_current_time_us();
     
-    /* Get signal priority */
-    uint8_t priority = signal_get_priority(signal);
+    /* Standard signals coalesce into one bit; RT signals take a slot */
+    spin_lock(&state->state_lock);
+    int result = -1;
+    if (state->total_pending < state->max_pending) {
+        result = signal_pending_add(&state->pending, signal, &signal_info);
+    }
+    if (result == SIGNAL_PENDING_QUEUED) {
+        state->total_pending++;
+    }
+    spin_unlock(&state->state_lock);
     
-    /* Enqueue signal */
-    signal_queue_t* queue = state->queues[signal];
-    if (!queue) {
+    if (result < 0) {
+        g_signal_manager.global_stats.signals_discarded++;
+        g_signal_manager.global_stats.queue_overflows++;
         return -1;
     }
     
-    /* Check for coalescing */
-    if ((flags & SIGNAL_DELIVER_COALESCE) && signal_can_coalesce(signal)) {
-        /* For coalescable signals, check if already pending */
-        spin_lock(&state->state_lock);
-        if (state->pending_mask & (1ULL << signal)) {
-            /* Signal already pending, coalesce */
-            spin_unlock(&state->state_lock);
-            g_signal_manager.global_stats.signals_coalesced++;
-            return 0;
-        }
-        spin_unlock(&state->state_lock);
+    if (result == SIGNAL_PENDING_COALESCED) {
+        g_signal_manager.global_stats.signals_coalesced++;
+        return 0;
     }
     
-    /* Enqueue the signal */
-    int result = signal_queue_enqueue(queue, signal, &signal_info, priority, flags);
-    if (result == 0) {
-        /* Update pending mask and counts */
-        spin_lock(&state->state_lock);
-        state->pending_mask |= (1ULL << signal);
-        state->total_pending++;
-        spin_unlock(&state->state_lock);
-        
-        /* Update global statistics */
-        g_signal_manager.global_stats.signals_generated++;
-        
-        /* Trigger delivery if process is ready */
-        if (!(flags & SIGNAL_DELIVER_QUEUE) && target_proc->state == PROCESS_RUNNING) {
-            signal_deliver_pending(target_proc);
-        }
-    } else {
-        g_signal_manager.global_stats.signals_discarded++;
+    g_signal_manager.global_stats.signals_generated++;
+    
+    /* A blocked signal stays pending until the mask changes */
+    if (!(flags & SIGNAL_DELIVER_FORCE) && signal_is_blocked(target_proc, signal)) {
+        g_signal_manager.global_stats.signals_blocked++;
+        return 0;
     }
     
-    return result;
+    /* Trigger delivery if process is ready */
+    if (!(flags & SIGNAL_DELIVER_QUEUE) && target_proc->state == PROCESS_RUNNING) {
+        signal_deliver_pending(target_proc);
+    }
+    
+    return 0;
 }
 
 /**
@@ -400,44 +393,31 @@ int signal_deliver_pending(process_t* proc) {
     state->delivery_active = true;
     spin_unlock(&state->state_lock);
     
-    /* Deliver signals in priority order */
-    for (int priority = SIGNAL_PRIORITY_CRITICAL; priority <= SIGNAL_PRIORITY_RT_BASE + 31; priority++) {
-        /* Check each signal at this priority level */
-        for (int signal = 1; signal < 64; signal++) {
-            if (signal_get_priority(signal) != priority) {
-                continue;
-            }
-            
-            /* Skip if signal not pending */
-            if (!(state->pending_mask & (1ULL << signal))) {
-                continue;
-            }
-            
-            /* Skip if signal is blocked */
-            if (signal_is_blocked(proc, signal)) {
-                continue;
-            }
-            
-            /* Deliver the signal */
-            siginfo_t info;
-            if (signal_queue_dequeue(state->queues[signal], &info) > 0) {
-                if (signal_deliver_immediate(proc, signal, &info, 0) == 0) {
-                    delivered_count++;
-                    
-                    /* Update pending mask if queue is now empty */
-                    uint32_t queue_count;
-                    if (signal_queue_get_stats(state->queues[signal], &queue_count, NULL) == 0 && queue_count == 0) {
-                        spin_lock(&state->state_lock);
-                        state->pending_mask &= ~(1ULL << signal);
-                        state->total_pending--;
-                        spin_unlock(&state->state_lock);
-                    }
-                } else {
-                    /* Delivery failed, re-queue the signal */
-                    signal_queue_enqueue(state->queues[signal], signal, &info, 
-                                        signal_get_priority(signal), 0);
-                }
-            }
+    /* Deliver signals in priority order; a failed one waits for the next pass */
+    uint64_t allowed = ~signal_blocked_mask(proc);
+    for (;;) {
+        siginfo_t info;
+        
+        spin_lock(&state->state_lock);
+        int signal = signal_pending_select(&state->pending, allowed,
+                                           g_delivery_order, SIGNAL_DELIVERY_LEVELS);
+        if (signal) {
+            signal_pending_peek(&state->pending, signal, &info);
+        }
+        spin_unlock(&state->state_lock);
+        
+        if (!signal) {
+            break;
+        }
+        
+        if (signal_deliver_immediate(proc, signal, &info, 0) == 0) {
+            spin_lock(&state->state_lock);
+            signal_pending_take(&state->pending, signal, NULL);
+            state->total_pending--;
+            spin_unlock(&state->state_lock);
+            delivered_count++;
+        } else {
+            allowed &= ~(1ULL << signal);
         }
     }
     
@@ -451,6 +431,41 @@ int signal_deliver_pending(process_t* proc) {
     return delivered_count;
 }
 
+/**
+ * Check if a signal is pending for a process
+ */
+bool signal_is_pending(process_t* proc, int signal) {
+    if (!proc || !proc->signal_delivery_state) {
+        return false;
+    }
+    
+    signal_delivery_state_t* state = (signal_delivery_state_t*)proc->signal_delivery_state;
+    return signal_pending_has(&state->pending, signal);
+}
+
+/**
+ * Get next pending signal for delivery
+ */
+int signal_get_next_pending(process_t* proc, siginfo_t* info) {
+    if (!proc || !proc->signal_delivery_state || !info) {
+        return 0;
+    }
+    
+    signal_delivery_state_t* state = (signal_delivery_state_t*)proc->signal_delivery_state;
+    uint64_t allowed = ~signal_blocked_mask(proc);
+    
+    spin_lock(&state->state_lock);
+    int signal = signal_pending_select(&state->pending, allowed,
+                                       g_delivery_order, SIGNAL_DELIVERY_LEVELS);
+    if (signal) {
+        signal_pending_take(&state->pending, signal, info);
+        state->total_pending--;
+    }
+    spin_unlock(&state->state_lock);
+    
+    return signal;
+}
+
 /**
  * Deliver a specific signal immediately
  */
@@ -491,150 +506,6 @@ int signal_deliver_immediate(process_t* proc, int signal, const siginfo_t* info,
     return result;
 }
 
-/* ========================== Signal Queue Management ========================== */
-
-/**
- * Create a signal queue for a specific signal
- */
-signal_queue_t* signal_queue_create(int signal, uint32_t max_size, bool is_realtime) {
-    signal_queue_t* queue = (signal_queue_t*)kmalloc(sizeof(signal_queue_t));
-    if (!queue) {
-        return NULL;
-    }
-    
-    memset(queue, 0, sizeof(signal_queue_t));
-    queue->max_size = max_size;
-    queue->priority = signal_get_priority(signal);
-    queue->is_realtime = is_realtime;
-    kernel_spinlock_init(&queue->lock);
-    
-    return queue;
-}
-
-/**
- * Destroy a signal queue
- */
-void signal_queue_destroy(signal_queue_t* queue) {
-    if (!queue) {
-        return;
-    }
-    
-    /* Clear all entries */
-    signal_queue_clear(queue);
-    
-    /* Free the queue */
-    kfree(queue);
-}
-
-/**
- * Enqueue a signal entry
- */
-int signal_queue_enqueue(signal_queue_t* queue, int signal, const siginfo_t* info,
-                        uint8_t priority, uint32_t flags) {
-    if (!queue || !info) {
-        return -1;
-    }
-    
-    spin_lock(&queue->lock);
-    
-    /* Check queue capacity */
-    if (queue->count >= queue->max_size) {
-        spin_unlock(&queue->lock);
-        g_signal_manager.global_stats.queue_overflows++;
-        return -1;
-    }
-    
-    /* Allocate new entry */
-    signal_queue_entry_t* entry = signal_alloc_entry();
-    if (!entry) {
-        spin_unlock(&queue->lock);
-        return -1;
-    }
-    
-    /* Initialize entry */
-    entry->signal = signal;
-    entry->info = *info;
-    entry->priority = priority;
-    entry->flags = flags;
-    entry->timestamp = get_current_time_us();
-    entry->next = NULL;
-    entry->prev = NULL;
-    
-    /* Insert in priority order */
-    int result = signal_queue_insert_ordered(queue, entry);
-    if (result == 0) {
-        queue->count++;
-    } else {
-        signal_free_entry(entry);
-    }
-    
-    spin_unlock(&queue->lock);
-    return result;
-}
-
-/**
- * Dequeue the next signal entry
- */
-int signal_queue_dequeue(signal_queue_t* queue, siginfo_t* info) {
-    if (!queue || !info) {
-        return 0;
-    }
-    
-    spin_lock(&queue->lock);
-    
-    if (!queue->head) {
-        spin_unlock(&queue->lock);
-        return 0;
-    }
-    
-    /* Get first entry */
-    signal_queue_entry_t* entry = queue->head;
-    int signal = entry->signal;
-    *info = entry->info;
-    
-    /* Remove from queue */
-    queue->head = entry->next;
-    if (queue->head) {
-        queue->head->prev = NULL;
-    } else {
-        queue->tail = NULL;
-    }
-    queue->count--;
-    
-    /* Free entry */
-    signal_free_entry(entry);
-    
-    spin_unlock(&queue->lock);
-    return signal;
-}
-
-/**
- * Clear all entries from a signal queue
- */
-int signal_queue_clear(signal_queue_t* queue) {
-    if (!queue) {
-        return 0;
-    }
-    
-    spin_lock(&queue->lock);
-    
-    int cleared = 0;
-    signal_queue_entry_t* entry = queue->head;
-    while (entry) {
-        signal_queue_entry_t* next = entry->next;
-        signal_free_entry(entry);
-        entry = next;
-        cleared++;
-    }
-    
-    queue->head = NULL;
-    queue->tail = NULL;
-    queue->count = 0;
-    
-    spin_unlock(&queue->lock);
-    return cleared;
-}
-
 /* ========================== Signal Priority and Utility Functions ========================== */
 
 /**
@@ -670,13 +541,7 @@ bool signal_is_blocked(process_t* proc, int signal) {
         return false;
     }
     
-    /* Check process signal mask */
-    signal_delivery_state_t* state = (signal_delivery_state_t*)proc->signal_delivery_state;
-    if (!state) {
-        return false;
-    }
-    
-    return (state->blocked_mask & (1ULL << signal)) != 0;
+    return (signal_blocked_mask(proc) & (1ULL << signal)) != 0;
 }
 
 /**
@@ -775,70 +640,6 @@ void signal_set_child_info(siginfo_t* info, pid_t child_pid, int exit_status,
     info->si_stime = stime;
 }
 
-/* ========================== Memory Management ========================== */
-
-/**
- * Allocate a signal queue entry
- */
-signal_queue_entry_t* signal_alloc_entry(void) {
-    signal_queue_entry_t* entry = (signal_queue_entry_t*)kmalloc(sizeof(signal_queue_entry_t));
-    if (entry) {
-        memset(entry, 0, sizeof(signal_queue_entry_t));
-    }
-    return entry;
-}
-
-/**
- * Free a signal queue entry
- */
-void signal_free_entry(signal_queue_entry_t* entry) {
-    if (entry) {
-        kfree(entry);
-    }
-}
-
-/**
- * Insert entry into queue maintaining priority order
- */
-int signal_queue_insert_ordered(signal_queue_t* queue, signal_queue_entry_t* entry) {
-    if (!queue || !entry) {
-        return -1;
-    }
-    
-    /* Empty queue */
-    if (!queue->head) {
-        queue->head = entry;
-        queue->tail = entry;
-        return 0;
-    }
-    
-    /* Insert at head if higher priority */
-    if (entry->priority < queue->head->priority) {
-        entry->next = queue->head;
-        queue->head->prev = entry;
-        queue->head = entry;
-        return 0;
-    }
-    
-    /* Find insertion point */
-    signal_queue_entry_t* current = queue->head;
-    while (current->next && current->next->priority <= entry->priority) {
-        current = current->next;
-    }
-    
-    /* Insert after current */
-    entry->next = current->next;
-    entry->prev = current;
-    if (current->next) {
-        current->next->prev = entry;
-    } else {
-        queue->tail = entry;
-    }
-    current->next = entry;
-    
-    return 0;
-}
-
 /* ========================== Statistics and Monitoring ========================== */
 
 /**
@@ -0,0 +1,185 @@
+/* IKOS Pending Signal Set
+ * Bitmap for standard signals, preallocated FIFO slots for realtime ones.
+ * No allocation and no locking here: the caller holds the owning state lock.
+ */
+
+#include "signal_delivery.h"
+
+#define RT_INDEX(signal)    ((signal) - SIGNAL_STD_COUNT)
+
+static bool pending_signal_valid(int signal) {
+    return signal >= 1 && signal < 64;
+}
+
+/**
+ * Initialize an empty pending set
+ */
+void signal_pending_init(signal_pending_t* set) {
+    if (!set) {
+        return;
+    }
+
+    set->mask = 0;
+    for (int i = 0; i < SIGNAL_MAX_RT_SIGNALS; i++) {
+        set->rt_head[i] = SIGNAL_RT_SLOT_NONE;
+        set->rt_tail[i] = SIGNAL_RT_SLOT_NONE;
+        set->rt_count[i] = 0;
+    }
+
+    /* Thread every slot onto the free list */
+    for (uint16_t i = 0; i < SIGNAL_RT_QUEUE_SIZE; i++) {
+        set->rt_slots[i].next = (i + 1 < SIGNAL_RT_QUEUE_SIZE) ? i + 1 : SIGNAL_RT_SLOT_NONE;
+    }
+    set->rt_free = 0;
+    set->rt_queued = 0;
+}
+
+/**
+ * Mark a signal pending
+ */
+int signal_pending_add(signal_pending_t* set, int signal, const siginfo_t* info) {
+    if (!set || !info || !pending_signal_valid(signal)) {
+        return -1;
+    }
+
+    uint64_t bit = 1ULL << signal;
+
+    if (signal < SIGNAL_STD_COUNT) {
+        if (set->mask & bit) {
+            return SIGNAL_PENDING_COALESCED;
+        }
+        set->std_info[signal] = *info;
+        set->mask |= bit;
+        return SIGNAL_PENDING_QUEUED;
+    }
+
+    uint16_t slot = set->rt_free;
+    if (slot == SIGNAL_RT_SLOT_NONE) {
+        return -1;
+    }
+    set->rt_free = set->rt_slots[slot].next;
+
+    int rt = RT_INDEX(signal);
+    set->rt_slots[slot].info = *info;
+    set->rt_slots[slot].next = SIGNAL_RT_SLOT_NONE;
+    if (set->rt_tail[rt] == SIGNAL_RT_SLOT_NONE) {
+        set->rt_head[rt] = slot;
+    } else {
+        set->rt_slots[set->rt_tail[rt]].next = slot;
+    }
+    set->rt_tail[rt] = slot;
+    set->rt_count[rt]++;
+    set->rt_queued++;
+    set->mask |= bit;
+    return SIGNAL_PENDING_QUEUED;
+}
+
+/**
+ * Check whether a signal is pending
+ */
+bool signal_pending_has(const signal_pending_t* set, int signal) {
+    if (!set) {
+        return false;
+    }
+    if (signal == 0) {
+        return set->mask != 0;
+    }
+    return pending_signal_valid(signal) && (set->mask & (1ULL << signal)) != 0;
+}
+
+/**
+ * Number of pending instances of a signal
+ */
+uint32_t signal_pending_count(const signal_pending_t* set, int signal) {
+    if (!signal_pending_has(set, signal) || signal == 0) {
+        return 0;
+    }
+    return signal < SIGNAL_STD_COUNT ? 1 : set->rt_count[RT_INDEX(signal)];
+}
+
+/**
+ * Choose the next signal to deliver
+ */
+int signal_pending_select(const signal_pending_t* set, uint64_t allowed,
+                          const uint64_t* order, int levels) {
+    if (!set) {
+        return 0;
+    }
+
+    uint64_t ready = set->mask & allowed;
+    if (!ready) {
+        return 0;
+    }
+
+    for (int i = 0; i < levels; i++) {
+        uint64_t candidates = ready & order[i];
+        if (candidates) {
+            return __builtin_ctzll(candidates);
+        }
+    }
+
+    /* Signals no class mentions go last, lowest number first */
+    return __builtin_ctzll(ready);
+}
+
+/**
+ * Copy the oldest pending instance of a signal without removing it
+ */
+int signal_pending_peek(const signal_pending_t* set, int signal, siginfo_t* info) {
+    if (!info || signal == 0 || !signal_pending_has(set, signal)) {
+        return 0;
+    }
+
+    if (signal < SIGNAL_STD_COUNT) {
+        *info = set->std_info[signal];
+    } else {
+        *info = set->rt_slots[set->rt_head[RT_INDEX(signal)]].info;
+    }
+    return signal;
+}
+
+/**
+ * Remove the oldest pending instance of a signal
+ */
+int signal_pending_take(signal_pending_t* set, int signal, siginfo_t* info) {
+    if (signal == 0 || !signal_pending_has(set, signal)) {
+        return 0;
+    }
+
+    if (signal < SIGNAL_STD_COUNT) {
+        if (info) {
+            *info = set->std_info[signal];
+        }
+        set->mask &= ~(1ULL << signal);
+        return signal;
+    }
+
+    int rt = RT_INDEX(signal);
+    uint16_t slot = set->rt_head[rt];
+    if (info) {
+        *info = set->rt_slots[slot].info;
+    }
+
+    set->rt_head[rt] = set->rt_slots[slot].next;
+    if (set->rt_head[rt] == SIGNAL_RT_SLOT_NONE) {
+        set->rt_tail[rt] = SIGNAL_RT_SLOT_NONE;
+        set->mask &= ~(1ULL << signal);
+    }
+    set->rt_count[rt]--;
+    set->rt_queued--;
+
+    set->rt_slots[slot].next = set->rt_free;
+    set->rt_free = slot;
+    return signal;
+}
+
+/**
+ * Drop every pending instance of a signal
+ */
+int signal_pending_discard(signal_pending_t* set, int signal) {
+    int removed = 0;
+    while (signal_pending_take(set, signal, NULL)) {
+        removed++;
+    }
+    return removed;
+}
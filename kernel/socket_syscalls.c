@@ -12,6 +12,7 @@
 #include "../include/net/udp.h"
 #include "../include/process.h"
 #include "../include/memory.h"
+#include "../include/vfs.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -57,6 +58,9 @@ int socket_syscall_init(void) {
     register_syscall_handler(SYS_GETSOCKOPT, (syscall_handler_t)sys_getsockopt);
     register_syscall_handler(SYS_GETSOCKNAME, (syscall_handler_t)sys_getsockname);
     register_syscall_handler(SYS_GETPEERNAME, (syscall_handler_t)sys_getpeername);
+    register_syscall_handler(SYS_READV, (syscall_handler_t)sys_readv);
+    register_syscall_handler(SYS_WRITEV, (syscall_handler_t)sys_writev);
+    register_syscall_handler(SYS_SENDFILE, (syscall_handler_t)sys_sendfile);
     
     socket_subsystem_initialized = true;
     printf("Socket subsystem initialized successfully\n");
@@ -83,6 +87,9 @@ void socket_syscall_cleanup(void) {
     unregister_syscall_handler(SYS_GETSOCKOPT);
     unregister_syscall_handler(SYS_GETSOCKNAME);
     unregister_syscall_handler(SYS_GETPEERNAME);
+    unregister_syscall_handler(SYS_READV);
+    unregister_syscall_handler(SYS_WRITEV);
+    unregister_syscall_handler(SYS_SENDFILE);
     
     /* Cleanup socket descriptor table */
     socket_table_cleanup();
@@ -492,6 +499,121 @@ long sys_recv(int sockfd, void* buf, size_t len, int flags) {
     return result;
 }
 
+long sys_readv(int fd, const vfs_iovec_t* iov, int iovcnt) {
+    if (!iov || iovcnt < 0 || iovcnt > VFS_MAX_IOV ||
+        !validate_user_buffer(iov, (size_t)iovcnt * sizeof(vfs_iovec_t), false)) {
+        socket_set_errno(SOCKET_ERROR);
+        return SOCKET_ERROR;
+    }
+    
+    /* Files go through the VFS */
+    if (!socket_fd_to_socket(fd)) {
+        return vfs_readv(fd, iov, iovcnt);
+    }
+    
+    /* Sockets fill one segment per receive, stopping when one comes up short */
+    long total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len == 0) {
+            continue;
+        }
+        long result = sys_recv(fd, iov[i].iov_base, iov[i].iov_len, 0);
+        if (result < 0) {
+            return total ? total : result;
+        }
+        total += result;
+        if ((size_t)result < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+long sys_writev(int fd, const vfs_iovec_t* iov, int iovcnt) {
+    if (!iov || iovcnt < 0 || iovcnt > VFS_MAX_IOV ||
+        !validate_user_buffer(iov, (size_t)iovcnt * sizeof(vfs_iovec_t), false)) {
+        socket_set_errno(SOCKET_ERROR);
+        return SOCKET_ERROR;
+    }
+    
+    if (!socket_fd_to_socket(fd)) {
+        return vfs_writev(fd, iov, iovcnt);
+    }
+    
+    long total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len == 0) {
+            continue;
+        }
+        long result = sys_send(fd, iov[i].iov_base, iov[i].iov_len, 0);
+        if (result < 0) {
+            return total ? total : result;
+        }
+        total += result;
+        if ((size_t)result < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+/* Destination of a sendfile: each cached page is handed to the protocol */
+typedef struct sendfile_ctx {
+    socket_t* sock;
+    int error;              /* Last send error, as the protocol returned it */
+} sendfile_ctx_t;
+
+static int64_t sendfile_actor(void* ctx, const void* data, size_t len) {
+    sendfile_ctx_t* sf = (sendfile_ctx_t*)ctx;
+    int result = sf->sock->ops->send(sf->sock, data, len, 0);
+    if (result < 0) {
+        sf->error = result;
+        return result;
+    }
+    g_socket_stats.bytes_sent += result;
+    g_socket_stats.packets_sent++;
+    return result;
+}
+
+long sys_sendfile(int out_fd, int in_fd, uint64_t* offset, size_t count) {
+    /* Only sockets can take a file's pages directly */
+    socket_t* sock = socket_fd_to_socket(out_fd);
+    if (!sock) {
+        socket_set_errno(SOCKET_EBADF);
+        return SOCKET_EBADF;
+    }
+    if (!sock->ops || !sock->ops->send) {
+        socket_set_errno(SOCKET_ENOTSOCK);
+        return SOCKET_ENOTSOCK;
+    }
+    if (offset && !validate_user_buffer(offset, sizeof(uint64_t), true)) {
+        socket_set_errno(SOCKET_ERROR);
+        return SOCKET_ERROR;
+    }
+    if (!vfs_get_file(in_fd)) {
+        socket_set_errno(SOCKET_EBADF);
+        return SOCKET_EBADF;
+    }
+    
+    /* The page cache feeds the protocol without a copy through user space */
+    sendfile_ctx_t sf = { sock, 0 };
+    ssize_t result = vfs_read_actor(in_fd, offset, count, sendfile_actor, &sf);
+    if (result < 0) {
+        if (!sf.error) {
+            socket_set_errno(SOCKET_ERROR);
+            return SOCKET_ERROR;
+        }
+        if (sf.error == SOCKET_EAGAIN && socket_is_nonblocking(sock)) {
+            socket_set_errno(SOCKET_EAGAIN);
+            return SOCKET_EAGAIN;
+        }
+        socket_set_errno(network_error_to_socket_error(sf.error));
+        return network_error_to_socket_error(sf.error);
+    }
+    
+    return result;
+}
+
 long sys_sendto(int sockfd, const void* buf, size_t len, int flags,
                 const void* dest_addr, uint32_t addrlen) {
     /* Validate socket file descriptor */
@@ -0,0 +1,284 @@
+/* IKOS Demand Paging - Block-device swap area
+ *
+ * See include/swap_device.h.
+ */
+
+#include "swap_device.h"
+#include <stddef.h>
+
+/* Freestanding helpers provided by the kernel. */
+extern void* kmalloc(size_t size);
+extern void  kfree(void* ptr);
+extern void* memset(void* ptr, int value, size_t size);
+extern void* memcpy(void* dest, const void* src, size_t size);
+
+/* ========================== Slot bitmap ========================== */
+
+static inline bool slot_used(const swap_device_t* swap, uint32_t slot) {
+    return (swap->bitmap[slot >> 6] >> (slot & 63)) & 1;
+}
+
+static inline void slot_set(swap_device_t* swap, uint32_t slot) {
+    swap->bitmap[slot >> 6] |= 1ULL << (slot & 63);
+}
+
+static inline void slot_clear(swap_device_t* swap, uint32_t slot) {
+    swap->bitmap[slot >> 6] &= ~(1ULL << (slot & 63));
+}
+
+/* Find `len` consecutive free slots in [lo, hi). Fully allocated bitmap words
+ * are skipped 64 slots at a time. */
+static bool scan_free_run(const swap_device_t* swap, uint32_t lo, uint32_t hi,
+                          uint32_t len, uint32_t* out) {
+    uint32_t run = 0;
+    uint32_t s = lo;
+    while (s < hi) {
+        if ((s & 63) == 0 && hi - s >= 64 && swap->bitmap[s >> 6] == ~0ULL) {
+            run = 0;
+            s += 64;
+            continue;
+        }
+        if (slot_used(swap, s)) {
+            run = 0;
+        } else if (++run == len) {
+            *out = s + 1 - len;
+            return true;
+        }
+        s++;
+    }
+    return false;
+}
+
+static inline bool in_batch(const swap_device_t* swap, uint32_t slot) {
+    return swap->batch_count && slot >= swap->batch_start &&
+           slot < swap->batch_start + swap->batch_count;
+}
+
+static inline bool in_readahead(const swap_device_t* swap, uint32_t slot) {
+    return swap->ra_count && slot >= swap->ra_start &&
+           slot < swap->ra_start + swap->ra_count;
+}
+
+/* ========================== Setup ========================== */
+
+int swap_device_init(swap_device_t* swap, fat_block_device_t* dev,
+                     uint32_t first_sector, uint32_t pages) {
+    if (!swap || !dev || !dev->read_sectors || !dev->write_sectors || pages == 0 ||
+        dev->sector_size == 0 || dev->sector_size > SWAP_PAGE_SIZE ||
+        SWAP_PAGE_SIZE % dev->sector_size != 0) {
+        return SWAP_ERR_PARAM;
+    }
+
+    uint32_t spp = SWAP_PAGE_SIZE / dev->sector_size;
+    if ((uint64_t)first_sector + (uint64_t)pages * spp > dev->total_sectors) {
+        return SWAP_ERR_PARAM;
+    }
+
+    memset(swap, 0, sizeof(*swap));
+    swap->dev = dev;
+    swap->first_sector = first_sector;
+    swap->sectors_per_page = spp;
+    swap->pages = pages;
+    swap->free_pages = pages;
+
+    size_t bitmap_bytes = ((size_t)(pages + 63) / 64) * sizeof(uint64_t);
+    swap->bitmap = (uint64_t*)kmalloc(bitmap_bytes);
+    swap->batch_buf = (uint8_t*)kmalloc(SWAP_BATCH_PAGES * SWAP_PAGE_SIZE);
+    swap->ra_buf = (uint8_t*)kmalloc(SWAP_READAHEAD_PAGES * SWAP_PAGE_SIZE);
+    if (!swap->bitmap || !swap->batch_buf || !swap->ra_buf) {
+        if (swap->bitmap) kfree(swap->bitmap);
+        if (swap->batch_buf) kfree(swap->batch_buf);
+        if (swap->ra_buf) kfree(swap->ra_buf);
+        memset(swap, 0, sizeof(*swap));
+        return SWAP_ERR_NOMEM;
+    }
+    memset(swap->bitmap, 0, bitmap_bytes);
+
+    swap->initialized = true;
+    return SWAP_OK;
+}
+
+void swap_device_release(swap_device_t* swap) {
+    if (!swap || !swap->initialized) {
+        return;
+    }
+    swap_flush(swap);
+    kfree(swap->bitmap);
+    kfree(swap->batch_buf);
+    kfree(swap->ra_buf);
+    memset(swap, 0, sizeof(*swap));
+}
+
+/* ========================== Slot allocation ========================== */
+
+int swap_slot_alloc(swap_device_t* swap, uint32_t* slot) {
+    if (!swap || !swap->initialized || !slot) {
+        return SWAP_ERR_PARAM;
+    }
+    if (swap->free_pages == 0) {
+        return SWAP_ERR_FULL;
+    }
+
+    uint32_t s;
+
+    /* Keep filling the open cluster. */
+    while (swap->cluster_next < swap->cluster_end) {
+        s = swap->cluster_next++;
+        if (!slot_used(swap, s)) {
+            goto take;
+        }
+    }
+
+    /* Open a new cluster at the next fully free run, searching forward from
+     * the previous one so the area fills in address order. */
+    if (swap->pages >= SWAP_CLUSTER_PAGES &&
+        (scan_free_run(swap, swap->scan_hint, swap->pages, SWAP_CLUSTER_PAGES, &s) ||
+         scan_free_run(swap, 0, swap->scan_hint, SWAP_CLUSTER_PAGES, &s))) {
+        swap->cluster_next = s + 1;
+        swap->cluster_end = s + SWAP_CLUSTER_PAGES;
+        swap->scan_hint = swap->cluster_end < swap->pages ? swap->cluster_end : 0;
+        swap->stats.cluster_allocs++;
+        goto take;
+    }
+
+    /* Too fragmented for a whole cluster: take any free slot. */
+    if (scan_free_run(swap, swap->scan_hint, swap->pages, 1, &s) ||
+        scan_free_run(swap, 0, swap->scan_hint, 1, &s)) {
+        swap->scan_hint = s + 1 < swap->pages ? s + 1 : 0;
+        goto take;
+    }
+
+    return SWAP_ERR_FULL;
+
+take:
+    slot_set(swap, s);
+    swap->free_pages--;
+    *slot = s;
+    return SWAP_OK;
+}
+
+void swap_slot_free(swap_device_t* swap, uint32_t slot) {
+    if (!swap || !swap->initialized || slot >= swap->pages || !slot_used(swap, slot)) {
+        return;
+    }
+    /* Cached copies stay valid until the slot is rewritten; swap_write_page()
+     * drops them then. Freeing right after swap-in must not discard the rest
+     * of the readahead window. */
+    slot_clear(swap, slot);
+    swap->free_pages++;
+}
+
+bool swap_slot_in_use(const swap_device_t* swap, uint32_t slot) {
+    return swap && swap->initialized && slot < swap->pages && slot_used(swap, slot);
+}
+
+/* ========================== Writeout ========================== */
+
+int swap_flush(swap_device_t* swap) {
+    if (!swap || !swap->initialized) {
+        return SWAP_ERR_PARAM;
+    }
+    if (swap->batch_count == 0) {
+        return SWAP_OK;
+    }
+
+    fat_block_device_t* d = swap->dev;
+    uint32_t sector = swap->first_sector + swap->batch_start * swap->sectors_per_page;
+    uint32_t count = swap->batch_count * swap->sectors_per_page;
+    if (d->write_sectors(d->private_data, sector, count, swap->batch_buf) != 0) {
+        /* Keep the batch so the caller can retry; reads still see it. */
+        swap->stats.io_errors++;
+        return SWAP_ERR_IO;
+    }
+
+    swap->stats.write_commands++;
+    swap->stats.pages_written += swap->batch_count;
+    swap->batch_count = 0;
+    return SWAP_OK;
+}
+
+int swap_write_page(swap_device_t* swap, uint32_t slot, const void* page) {
+    if (!swap || !swap->initialized || !page || slot >= swap->pages ||
+        !slot_used(swap, slot)) {
+        return SWAP_ERR_PARAM;
+    }
+
+    /* The readahead copy of this slot is about to go stale. */
+    if (in_readahead(swap, slot)) {
+        swap->ra_count = 0;
+    }
+
+    if (in_batch(swap, slot)) {
+        memcpy(swap->batch_buf + (size_t)(slot - swap->batch_start) * SWAP_PAGE_SIZE,
+               page, SWAP_PAGE_SIZE);
+        return SWAP_OK;
+    }
+
+    /* Only a page extending the current run joins the batch. */
+    if (swap->batch_count &&
+        (slot != swap->batch_start + swap->batch_count ||
+         swap->batch_count == SWAP_BATCH_PAGES)) {
+        int rc = swap_flush(swap);
+        if (rc != SWAP_OK) {
+            return rc;
+        }
+    }
+
+    if (swap->batch_count == 0) {
+        swap->batch_start = slot;
+    }
+    memcpy(swap->batch_buf + (size_t)swap->batch_count * SWAP_PAGE_SIZE,
+           page, SWAP_PAGE_SIZE);
+    swap->batch_count++;
+    return SWAP_OK;
+}
+
+/* ========================== Swap-in ========================== */
+
+int swap_read_page(swap_device_t* swap, uint32_t slot, void* page) {
+    if (!swap || !swap->initialized || !page || slot >= swap->pages ||
+        !slot_used(swap, slot)) {
+        return SWAP_ERR_PARAM;
+    }
+
+    if (in_batch(swap, slot)) {
+        memcpy(page, swap->batch_buf + (size_t)(slot - swap->batch_start) * SWAP_PAGE_SIZE,
+               SWAP_PAGE_SIZE);
+        swap->stats.batch_hits++;
+        return SWAP_OK;
+    }
+
+    if (in_readahead(swap, slot)) {
+        memcpy(page, swap->ra_buf + (size_t)(slot - swap->ra_start) * SWAP_PAGE_SIZE,
+               SWAP_PAGE_SIZE);
+        swap->stats.readahead_hits++;
+        return SWAP_OK;
+    }
+
+    /* Read the slot plus the allocated slots that follow it. The window stops
+     * at a free slot (nothing worth reading) or a slot still in the write
+     * batch (its disk copy is stale). */
+    uint32_t n = 1;
+    while (n < SWAP_READAHEAD_PAGES && slot + n < swap->pages &&
+           slot_used(swap, slot + n) && !in_batch(swap, slot + n)) {
+        n++;
+    }
+
+    fat_block_device_t* d = swap->dev;
+    uint32_t sector = swap->first_sector + slot * swap->sectors_per_page;
+    if (d->read_sectors(d->private_data, sector, n * swap->sectors_per_page,
+                        swap->ra_buf) != 0) {
+        swap->ra_count = 0;
+        swap->stats.io_errors++;
+        return SWAP_ERR_IO;
+    }
+
+    swap->ra_start = slot;
+    swap->ra_count = n;
+    swap->stats.read_commands++;
+    swap->stats.pages_read += n;
+    swap->stats.readahead_pages += n - 1;
+
+    memcpy(page, swap->ra_buf, SWAP_PAGE_SIZE);
+    return SWAP_OK;
+}
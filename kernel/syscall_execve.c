@@ -179,12 +179,11 @@ static int handle_close_on_exec(process_t* proc) {
     
     /* Close file descriptors marked with FD_CLOEXEC */
     for (int i = 0; i < MAX_OPEN_FILES; i++) {
-        if (proc->fds[i].in_use && (proc->fds[i].flags & FD_CLOEXEC)) {
-            /* Close the file descriptor */
-            proc->fds[i].in_use = false;
+        if (proc->fds[i].fd >= 0 && (proc->fds[i].flags & FD_CLOEXEC)) {
+            vfs_close(proc->fds[i].fd);
+            proc->fds[i].fd = -1;
             proc->fds[i].flags = 0;
-            proc->fds[i].file_ptr = NULL;
-            /* TODO: Actual file closing implementation */
+            proc->fds[i].offset = 0;
         }
     }
     
@@ -264,6 +263,16 @@ void destroy_exec_context(exec_context_t* ctx) {
 
 /* ========================== Main Execve Implementation ========================== */
 
+/**
+ * Give a vfork child back its parent's address space after a failed exec
+ */
+static void restore_borrowed_space(process_t* proc, vm_space_t* borrowed) {
+    if (borrowed) {
+        vmm_destroy_address_space(proc->address_space);
+        proc->address_space = borrowed;
+    }
+}
+
 /**
  * Execve system call implementation
  */
@@ -303,8 +312,23 @@ long sys_execve(const char* path, char* const argv[], char* const envp[]) {
     strncpy(saved_name, proc->name, MAX_PROCESS_NAME - 1);
     strncpy(saved_cmdline, proc->cmdline, MAX_COMMAND_LINE - 1);
     
+    /* A vfork child is still running on its parent's memory: build the new
+     * image in a fresh address space instead of clearing the borrowed one */
+    vm_space_t* borrowed = NULL;
+    if (proc->vfork_parent) {
+        borrowed = proc->address_space;
+        proc->address_space = vmm_create_address_space(proc->pid);
+        if (!proc->address_space) {
+            proc->address_space = borrowed;
+            destroy_exec_context(exec_ctx);
+            g_lifecycle_stats.failed_execs++;
+            return -ENOMEM;
+        }
+    }
+    
     /* Clear existing memory space */
     if (clear_process_memory(proc) != 0) {
+        restore_borrowed_space(proc, borrowed);
         destroy_exec_context(exec_ctx);
         g_lifecycle_stats.failed_execs++;
         return -ENOMEM;
@@ -317,6 +341,7 @@ long sys_execve(const char* path, char* const argv[], char* const envp[]) {
         proc->context = saved_context;
         strncpy(proc->name, saved_name, MAX_PROCESS_NAME - 1);
         strncpy(proc->cmdline, saved_cmdline, MAX_COMMAND_LINE - 1);
+        restore_borrowed_space(proc, borrowed);
         destroy_exec_context(exec_ctx);
         g_lifecycle_stats.failed_execs++;
         return -ENOEXEC;
@@ -332,6 +357,7 @@ long sys_execve(const char* path, char* const argv[], char* const envp[]) {
         proc->context = saved_context;
         strncpy(proc->name, saved_name, MAX_PROCESS_NAME - 1);
         strncpy(proc->cmdline, saved_cmdline, MAX_COMMAND_LINE - 1);
+        restore_borrowed_space(proc, borrowed);
         destroy_exec_context(exec_ctx);
         g_lifecycle_stats.failed_execs++;
         return -E2BIG;
@@ -342,6 +368,11 @@ long sys_execve(const char* path, char* const argv[], char* const envp[]) {
         /* Continue anyway - this is not fatal */
     }
     
+    /* The parent's memory is no longer in use: let it run again */
+    if (borrowed) {
+        vfork_release(proc);
+    }
+    
     /* Update process information */
     strncpy(proc->name, path, MAX_PROCESS_NAME - 1);
     snprintf(proc->cmdline, MAX_COMMAND_LINE - 1, "%s", path);
@@ -466,7 +497,6 @@ int vmm_unmap_page(vm_space_t* space, uint64_t virtual_addr) {
 #define USER_DATA_SEGMENT   0x20
 #define SIG_DFL             ((void*)0)
 #define SIG_IGN             ((void*)1)
-#define FD_CLOEXEC          1
 #define PAGE_SIZE           4096
 #define ENAMETOOLONG        36
 
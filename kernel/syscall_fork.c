@@ -8,13 +8,14 @@
 #include "string.h"
 #include "vmm.h"
 #include "scheduler.h"
+#include "vfs.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
 
 /* ========================== Global State ========================== */
 
-static process_lifecycle_stats_t g_lifecycle_stats = {0};
+process_lifecycle_stats_t g_lifecycle_stats = {0};
 static uint32_t g_next_pid = 1000;  /* Start PIDs from 1000 */
 
 /* ========================== Helper Functions ========================== */
@@ -34,21 +35,14 @@ static int copy_process_memory_cow(process_t* parent, process_t* child) {
         return -EINVAL;
     }
     
-    /* Copy page directory structure */
-    if (vmm_clone_address_space(parent->address_space, &child->address_space) != 0) {
+    /* Share the parent's leaf page tables copy-on-write. No page is
+     * visited here; pages are write-protected lazily, a table at a time,
+     * when either side first writes under it. */
+    child->address_space = vmm_copy_address_space(parent->address_space, child->pid);
+    if (!child->address_space) {
         return -ENOMEM;
     }
     
-    /* Mark all writable pages as copy-on-write */
-    uint64_t addr = parent->virtual_memory_start;
-    while (addr < parent->virtual_memory_end) {
-        if (vmm_is_page_present(parent->address_space, addr)) {
-            /* Mark as copy-on-write in both parent and child */
-            mark_page_cow(addr);
-        }
-        addr += PAGE_SIZE;
-    }
-    
     /* Copy memory layout information */
     child->virtual_memory_start = parent->virtual_memory_start;
     child->virtual_memory_end = parent->virtual_memory_end;
@@ -70,14 +64,12 @@ static int copy_fd_table(process_t* parent, process_t* child) {
         return -EINVAL;
     }
     
-    /* Copy file descriptor array */
+    /* Copy file descriptor array; each copy holds its own reference,
+     * so either side closing leaves the other's descriptor open */
     for (int i = 0; i < MAX_OPEN_FILES; i++) {
-        if (parent->fds[i].in_use) {
+        child->fds[i].fd = -1;
+        if (parent->fds[i].fd >= 0 && vfs_retain(parent->fds[i].fd) == VFS_SUCCESS) {
             child->fds[i] = parent->fds[i];
-            /* Increment reference count for shared files */
-            if (parent->fds[i].file_ptr) {
-                /* TODO: Implement file reference counting */
-            }
         }
     }
     
@@ -421,11 +413,6 @@ process_t* get_current_process(void) {
 }
 
 /* VMM placeholders */
-int vmm_clone_address_space(vm_space_t* parent, vm_space_t** child) {
-    /* Placeholder - should clone virtual memory space */
-    return 0;
-}
-
 int vmm_set_page_cow(uint64_t virtual_addr) {
     /* Placeholder - should mark page as copy-on-write */
     return 0;
@@ -0,0 +1,388 @@
+/* IKOS Spawn and Vfork System Calls
+ * Process creation that skips duplicating the caller's address space:
+ * spawn() loads an executable straight into a new process, vfork() lends
+ * the parent's memory to a child that is about to exec or exit anyway.
+ */
+
+#include "syscall_process.h"
+#include "process.h"
+#include "process_manager.h"
+#include "elf.h"
+#include "elf_image_cache.h"
+#include "memory.h"
+#include "string.h"
+#include "vmm.h"
+#include "vfs.h"
+#include <errno.h>
+
+/* ========================== Constants ========================== */
+
+#define SPAWN_MAX_IMAGE_SIZE    (16*1024*1024)  /* Largest executable spawn loads */
+
+#ifndef SIG_DFL
+#define SIG_DFL                 ((void*)0)
+#define SIG_IGN                 ((void*)1)
+#endif
+
+extern process_lifecycle_stats_t g_lifecycle_stats;
+extern void schedule_next_process(void);
+
+/* ========================== Helper Functions ========================== */
+
+/**
+ * Last path component, for the process name
+ */
+static const char* spawn_basename(const char* path) {
+    const char* name = path;
+    for (const char* p = path; *p; p++) {
+        if (*p == '/' && p[1]) {
+            name = p + 1;
+        }
+    }
+    return name;
+}
+
+/**
+ * Read a whole executable into a kernel buffer
+ */
+static int read_executable(const char* path, size_t size, void** image_out) {
+    void* image = kmalloc(size);
+    if (!image) {
+        return -ENOMEM;
+    }
+
+    int fd = vfs_open(path, VFS_O_RDONLY, 0);
+    if (fd < 0) {
+        kfree(image);
+        return -EACCES;
+    }
+
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = vfs_read(fd, (char*)image + done, size - done);
+        if (n <= 0) {
+            break;
+        }
+        done += (size_t)n;
+    }
+    vfs_close(fd);
+
+    if (done != size || elf_validate(image) != 0) {
+        kfree(image);
+        return -ENOEXEC;
+    }
+
+    *image_out = image;
+    return 0;
+}
+
+/**
+ * Create the process from the executable at path. Instances of one binary
+ * share a cached image, so the file is only read when the cache lacks it.
+ */
+static int spawn_image(const char* path, uint32_t* pid) {
+    vfs_stat_t st;
+    if (vfs_stat(path, &st) != VFS_SUCCESS) {
+        return -ENOENT;
+    }
+    if (st.st_mode != VFS_FILE_TYPE_REGULAR || st.st_size == 0 ||
+        st.st_size > SPAWN_MAX_IMAGE_SIZE) {
+        return -ENOEXEC;
+    }
+
+    elf_image_key_t key = {
+        .dev = st.st_dev,
+        .ino = st.st_ino,
+        .mtime = st.st_mtime,
+        .size = st.st_size,
+    };
+
+    /* A second pass reads the file if the image was evicted after the lookup */
+    for (int attempt = 0; attempt < 2; attempt++) {
+        void* image = NULL;
+        if (attempt > 0 || !elf_image_cached(&key)) {
+            int ret = read_executable(path, st.st_size, &image);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+
+        int ret = pm_create_process_from_image(spawn_basename(path), &key, image,
+                                               image ? st.st_size : 0, pid);
+        if (image) {
+            kfree(image);
+        }
+        if (ret == PM_SUCCESS) {
+            return 0;
+        }
+        if (ret == PM_ERROR_TABLE_FULL || ret == PM_ERROR_RESOURCE_LIMIT) {
+            return -EAGAIN;
+        }
+        if (image) {
+            break;
+        }
+    }
+    return -ENOEXEC;
+}
+
+/**
+ * Give the child its own hold on each of the parent's descriptors. On an
+ * exec boundary (spawn) descriptors marked FD_CLOEXEC are left behind.
+ */
+static void inherit_fds(process_t* parent, process_t* child, bool exec) {
+    for (int i = 0; i < MAX_OPEN_FILES; i++) {
+        file_descriptor_t* src = &parent->fds[i];
+
+        child->fds[i].fd = -1;
+        child->fds[i].path[0] = '\0';
+
+        if (src->fd < 0 || (exec && (src->flags & FD_CLOEXEC))) {
+            continue;
+        }
+        if (vfs_retain(src->fd) != VFS_SUCCESS) {
+            continue;  /* Stale slot: nothing to inherit */
+        }
+        child->fds[i] = *src;
+    }
+    child->next_fd = parent->next_fd;
+}
+
+/**
+ * Drop a descriptor from one process's table
+ */
+static int close_child_fd(process_t* proc, int fd) {
+    for (int i = 0; i < MAX_OPEN_FILES; i++) {
+        if (proc->fds[i].fd == fd) {
+            vfs_close(fd);
+            proc->fds[i].fd = -1;
+            proc->fds[i].flags = 0;
+            proc->fds[i].offset = 0;
+            proc->fds[i].path[0] = '\0';
+            return 0;
+        }
+    }
+    return -EBADF;
+}
+
+/**
+ * Check the file actions before anything is created
+ */
+static int validate_spawn_attr(process_t* parent, const spawn_attr_t* attr) {
+    if (attr->action_count > SPAWN_MAX_FILE_ACTIONS) {
+        return -EINVAL;
+    }
+
+    for (uint32_t i = 0; i < attr->action_count; i++) {
+        const spawn_file_action_t* action = &attr->actions[i];
+        switch (action->op) {
+            case SPAWN_FA_CLOSE:
+                if (action->fd < 0) {
+                    return -EBADF;
+                }
+                break;
+            case SPAWN_FA_OPEN:
+                if (!action->path) {
+                    return -EFAULT;
+                }
+                break;
+            default:
+                return -EINVAL;
+        }
+    }
+
+    (void)parent;
+    return 0;
+}
+
+/**
+ * Run the file actions in order against the child's table
+ */
+static int apply_file_actions(process_t* child, spawn_attr_t* attr) {
+    for (uint32_t i = 0; i < attr->action_count; i++) {
+        spawn_file_action_t* action = &attr->actions[i];
+        if (action->op == SPAWN_FA_CLOSE) {
+            if (close_child_fd(child, action->fd) != 0) {
+                return -EBADF;
+            }
+        } else {
+            int fd = process_open_file(child, action->path, (int)action->oflag);
+            if (fd < 0) {
+                return -ENOENT;
+            }
+            action->fd = fd;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Signal state across an exec boundary: handlers reset to default except
+ * ignored signals, which stay ignored unless attr asks for the default.
+ */
+static void setup_spawn_signals(process_t* parent, process_t* child,
+                                const spawn_attr_t* attr) {
+    for (int i = 0; i < 32; i++) {
+        bool ignored = parent->signal_handlers[i] == (void*)SIG_IGN;
+        if (ignored && attr && (attr->flags & SPAWN_SETSIGDEF) &&
+            (attr->sigdefault & (1ULL << i))) {
+            ignored = false;
+        }
+        child->signal_handlers[i] = ignored ? (void*)SIG_IGN : (void*)SIG_DFL;
+    }
+
+    child->signal_mask = (attr && (attr->flags & SPAWN_SETSIGMASK)) ?
+                         attr->sigmask : parent->signal_mask;
+    child->pending_signals = 0;
+}
+
+/* ========================== Spawn ========================== */
+
+/**
+ * Spawn system call implementation
+ */
+long sys_spawn(const char* path, char* const argv[], char* const envp[],
+               spawn_attr_t* attr) {
+    process_t* parent = process_get_current();
+    if (!parent) {
+        g_lifecycle_stats.failed_spawns++;
+        return -ESRCH;
+    }
+
+    g_lifecycle_stats.total_spawns++;
+
+    if (!path || !argv) {
+        g_lifecycle_stats.failed_spawns++;
+        return -EFAULT;
+    }
+
+    int ret = validate_executable(path);
+    if (ret == 0 && attr) {
+        ret = validate_spawn_attr(parent, attr);
+    }
+    if (ret != 0) {
+        g_lifecycle_stats.failed_spawns++;
+        return ret;
+    }
+
+    /* Load the program into a brand-new process */
+    uint32_t pid;
+    ret = spawn_image(path, &pid);
+    if (ret != 0) {
+        g_lifecycle_stats.failed_spawns++;
+        return ret;
+    }
+
+    process_t* child = pm_get_process(pid);
+    if (!child) {
+        g_lifecycle_stats.failed_spawns++;
+        return -ESRCH;
+    }
+
+    if (child->parent != parent) {
+        child->parent = parent;
+        child->ppid = parent->pid;
+        add_child_process(parent, child);
+    }
+
+    /* Descriptors: inherit, then the caller's actions */
+    inherit_fds(parent, child, true);
+    if (attr) {
+        ret = apply_file_actions(child, attr);
+    }
+    if (ret == 0) {
+        ret = setup_process_args_env(child, argv, envp);
+    }
+    if (ret != 0) {
+        pm_terminate_process(pid, 127);
+        g_lifecycle_stats.failed_spawns++;
+        return ret;
+    }
+
+    setup_spawn_signals(parent, child, attr);
+    strncpy(child->cmdline, path, MAX_COMMAND_LINE - 1);
+    child->cmdline[MAX_COMMAND_LINE - 1] = '\0';
+
+    g_lifecycle_stats.successful_spawns++;
+    return child->pid;
+}
+
+/* ========================== Vfork ========================== */
+
+/**
+ * Vfork system call implementation
+ */
+long sys_vfork(void) {
+    process_t* parent = process_get_current();
+    if (!parent) {
+        return -ESRCH;
+    }
+
+    g_lifecycle_stats.total_vforks++;
+
+    process_t* child = (process_t*)kmalloc(sizeof(process_t));
+    if (!child) {
+        return -ENOMEM;
+    }
+    memset(child, 0, sizeof(process_t));
+
+    child->pid = pm_table_allocate_pid();
+    strncpy(child->name, parent->name, MAX_PROCESS_NAME - 1);
+    strncpy(child->cmdline, parent->cmdline, MAX_COMMAND_LINE - 1);
+    child->priority = parent->priority;
+    child->time_slice = parent->time_slice;
+
+    /* Borrow the parent's memory: no page table is touched at all */
+    child->address_space = parent->address_space;
+    child->virtual_memory_start = parent->virtual_memory_start;
+    child->virtual_memory_end = parent->virtual_memory_end;
+    child->heap_start = parent->heap_start;
+    child->heap_end = parent->heap_end;
+    child->stack_start = parent->stack_start;
+    child->stack_end = parent->stack_end;
+    child->entry_point = parent->entry_point;
+    child->stack_size = parent->stack_size;
+    child->vfork_parent = parent;
+
+    inherit_fds(parent, child, false);
+    for (int i = 0; i < 32; i++) {
+        child->signal_handlers[i] = parent->signal_handlers[i];
+    }
+    child->signal_mask = parent->signal_mask;
+
+    /* Child resumes where the parent trapped, seeing 0 */
+    child->context = parent->context;
+    child->context.rax = 0;
+
+    child->parent = parent;
+    child->ppid = parent->pid;
+    add_child_process(parent, child);
+
+    child->state = PROCESS_STATE_READY;
+    process_add_to_ready_queue(child);
+
+    /* The child is using our stack: stay off the CPU until it lets go */
+    parent->state = PROCESS_STATE_BLOCKED;
+    process_remove_from_ready_queue(parent);
+    while (child->vfork_parent == parent) {
+        schedule_next_process();
+    }
+
+    return child->pid;
+}
+
+/**
+ * Resume the parent of a vfork child. Called once the child no longer
+ * uses the parent's memory: after execve() gave it its own address space,
+ * or on exit (which must not free the borrowed one).
+ */
+void vfork_release(process_t* child) {
+    if (!child || !child->vfork_parent) {
+        return;
+    }
+
+    process_t* parent = child->vfork_parent;
+    child->vfork_parent = NULL;
+
+    parent->state = PROCESS_STATE_READY;
+    process_add_to_ready_queue(parent);
+}
@@ -19,11 +19,13 @@ int syscall_init(void);
 #define SYS_OPEN        2
 #define SYS_CLOSE       3
 #define SYS_FORK        57
+#define SYS_VFORK       58
 #define SYS_EXECVE      59
 #define SYS_GETPID      39
 #define SYS_GETPPID     110
 #define SYS_WAIT        61
 #define SYS_WAITPID     247
+#define SYS_SPAWN       248
 
 /* Window Manager syscalls */
 #define SYS_WM_REGISTER_APP     500
@@ -104,6 +106,11 @@ long handle_system_call(interrupt_frame_t* frame) {
             result = sys_fork();
             break;
             
+        case SYS_VFORK:
+            /* Child borrows the parent's memory until execve or exit */
+            result = sys_vfork();
+            break;
+            
         case SYS_EXECVE:
             /* Implement execve system call */
             {
@@ -132,6 +139,17 @@ long handle_system_call(interrupt_frame_t* frame) {
             }
             break;
             
+        case SYS_SPAWN:
+            /* Create a process straight from an executable */
+            {
+                char* path = (char*)frame->rdi;
+                char** argv = (char**)frame->rsi;
+                char** envp = (char**)frame->rdx;
+                spawn_attr_t* attr = (spawn_attr_t*)frame->r10;
+                result = sys_spawn(path, argv, envp, attr);
+            }
+            break;
+            
         /* Window Manager System Calls */
         case SYS_WM_REGISTER_APP:
             result = sys_wm_register_app((const char*)frame->rdi);
@@ -101,6 +101,12 @@ process_t* process_create_from_elf(const char* name, void* elf_data, size_t size
     return &fake_elf_process;
 }
 
+process_t* process_create_from_image(const char* name, const struct elf_image_key* key,
+                                     const void* elf_data, size_t size) {
+    (void)key; /* Unused */
+    return process_create_from_elf(name, (void*)elf_data, size);
+}
+
 process_t* process_get_current(void) {
     static process_t fake_current = {0};
     fake_current.pid = 1;
@@ -17,8 +17,11 @@
  * Global Threading State
  * ================================ */
 
-/* Thread management */
-static kthread_t* thread_table[MAX_THREADS_PER_PROCESS * MAX_PROCESSES];
+/* Thread management: live threads are indexed by TID in a chained hash.
+ * TIDs are handed out sequentially, so the low bits spread them evenly. */
+#define TID_HASH_BITS 10
+#define TID_HASH_SIZE (1U << TID_HASH_BITS)
+static kthread_t* tid_hash[TID_HASH_SIZE];
 static uint32_t next_tid = 1;
 static uint32_t active_thread_count = 0;
 static kthread_t* current_thread = NULL;
@@ -33,16 +36,15 @@ static kspinlock_t* spinlock_table[MAX_CONDITION_VARS_PER_PROCESS * MAX_PROCESSE
 
 /* Object ID counters */
 static uint32_t next_mutex_id = 1;
-static uint32_t next_cond_id = 1;
-static uint32_t next_sem_id = 1;
-static uint32_t next_rwlock_id = 1;
-static uint32_t next_barrier_id = 1;
 static uint32_t next_spinlock_id = 1;
 
 /* Thread-local storage */
 static tls_key_t tls_keys[MAX_TLS_KEYS_GLOBAL];
 static uint32_t next_tls_key = 0;
 
+/* Futex wait queues, keyed by user address */
+static futex_table_t futex_table;
+
 /* Statistics */
 static thread_kernel_stats_t kernel_stats;
 
@@ -69,41 +71,119 @@ static uint32_t allocate_tid(void) {
     return __sync_fetch_and_add(&next_tid, 1);
 }
 
+static inline kthread_t** tid_bucket(uint32_t tid) {
+    return &tid_hash[tid & (TID_HASH_SIZE - 1)];
+}
+
 /* Find thread by TID */
 static kthread_t* find_thread_by_tid(uint32_t tid) {
-    for (int i = 0; i < MAX_THREADS_PER_PROCESS * MAX_PROCESSES; i++) {
-        if (thread_table[i] && thread_table[i]->tid == tid) {
-            return thread_table[i];
+    for (kthread_t* thread = *tid_bucket(tid); thread; thread = thread->tid_next) {
+        if (thread->tid == tid) {
+            return thread;
         }
     }
     return NULL;
 }
 
-/* Add thread to global table */
+/* Index a new thread by TID and link it on its process's thread list */
 static int add_thread_to_table(kthread_t* thread) {
-    for (int i = 0; i < MAX_THREADS_PER_PROCESS * MAX_PROCESSES; i++) {
-        if (thread_table[i] == NULL) {
-            thread_table[i] = thread;
-            return 0;
+    process_t* proc = thread->process;
+    if (proc && proc->thread_count >= MAX_THREADS_PER_PROCESS) {
+        return THREAD_ENOMEM;
+    }
+
+    kthread_t** bucket = tid_bucket(thread->tid);
+    thread->tid_next = *bucket;
+    *bucket = thread;
+
+    if (proc) {
+        thread->prev = NULL;
+        thread->next = proc->threads;
+        if (proc->threads) {
+            proc->threads->prev = thread;
         }
+        proc->threads = thread;
+        proc->thread_count++;
     }
-    return THREAD_ENOMEM;
+    return 0;
 }
 
-/* Remove thread from global table */
+/* Drop a thread from the TID index and its process's thread list */
 static void remove_thread_from_table(kthread_t* thread) {
-    for (int i = 0; i < MAX_THREADS_PER_PROCESS * MAX_PROCESSES; i++) {
-        if (thread_table[i] == thread) {
-            thread_table[i] = NULL;
+    for (kthread_t** link = tid_bucket(thread->tid); *link; link = &(*link)->tid_next) {
+        if (*link == thread) {
+            *link = thread->tid_next;
             break;
         }
     }
+    thread->tid_next = NULL;
+
+    process_t* proc = thread->process;
+    if (proc) {
+        if (thread->prev) {
+            thread->prev->next = thread->next;
+        } else if (proc->threads == thread) {
+            proc->threads = thread->next;
+        }
+        if (thread->next) {
+            thread->next->prev = thread->prev;
+        }
+        proc->thread_count--;
+    }
+    thread->next = thread->prev = NULL;
 }
 
-/* Get current system time in nanoseconds */
+/* Get current system time in nanoseconds since boot, from the kernel tick */
 static uint64_t get_system_time_ns(void) {
-    static uint64_t fake_time = 0;
-    return __sync_fetch_and_add(&fake_time, 1000000); // 1ms increments
+    return ktimer_now() * (1000000000ULL / KTIMER_HZ);
+}
+
+/* Wait timer callback: flag the timeout and make the sleeper runnable. It
+ * stays on whatever queue it slept on; the sleeper unqueues itself and, if a
+ * real wake did not beat the timer, reports the timeout. */
+static void thread_timeout(void* data) {
+    kthread_t* thread = (kthread_t*)data;
+    thread->timed_out = true;
+    thread_ready(thread);
+}
+
+/* Absent, or a well-formed absolute time */
+static bool timeout_valid(const struct timespec* abstime) {
+    return !abstime || (abstime->tv_sec >= 0 && abstime->tv_nsec >= 0 &&
+                        abstime->tv_nsec < 1000000000L);
+}
+
+/* Arm the current thread's wait timer for an absolute deadline on the
+ * kernel clock (get_system_time_ns). No-op without a deadline; the caller
+ * has checked it with timeout_valid(). */
+static void arm_wait_timeout(kthread_t* thread, const struct timespec* abstime) {
+    thread->timed_out = false;
+    if (!abstime) {
+        return;
+    }
+
+    /* Time left until the deadline, rounded up to whole ticks; a past
+     * deadline fires next tick. Seconds far enough out to overflow the
+     * nanosecond count just wait as long as the timer allows. */
+    uint64_t ns_per_tick = 1000000000ULL / KTIMER_HZ;
+    uint64_t now_ns = get_system_time_ns();
+    uint64_t deadline_ns = UINT64_MAX;
+    if ((uint64_t)abstime->tv_sec < UINT64_MAX / 1000000000ULL) {
+        deadline_ns = (uint64_t)abstime->tv_sec * 1000000000ULL + (uint64_t)abstime->tv_nsec;
+    }
+    uint64_t ticks = 1;
+    if (deadline_ns > now_ns) {
+        uint64_t left_ns = deadline_ns - now_ns;
+        ticks = left_ns / ns_per_tick + (left_ns % ns_per_tick != 0);
+    }
+    ktimer_start(&thread->wait_timer, ticks);
+}
+
+/* Disarm after waking; returns true if the timer fired. Waits out a callback
+ * running on another CPU so it cannot ready the thread later. */
+static bool disarm_wait_timeout(kthread_t* thread) {
+    ktimer_cancel_sync(&thread->wait_timer);
+    return thread->timed_out;
 }
 
 /* ================================
@@ -112,7 +192,7 @@ static uint64_t get_system_time_ns(void) {
 
 int thread_system_init(void) {
     /* Initialize all tables */
-    memset(thread_table, 0, sizeof(thread_table));
+    memset(tid_hash, 0, sizeof(tid_hash));
     memset(mutex_table, 0, sizeof(mutex_table));
     memset(cond_table, 0, sizeof(cond_table));
     memset(sem_table, 0, sizeof(sem_table));
@@ -120,6 +200,7 @@ int thread_system_init(void) {
     memset(barrier_table, 0, sizeof(barrier_table));
     memset(spinlock_table, 0, sizeof(spinlock_table));
     memset(tls_keys, 0, sizeof(tls_keys));
+    futex_table_init(&futex_table);
     
     /* Initialize statistics */
     memset(&kernel_stats, 0, sizeof(kernel_stats));
@@ -163,6 +244,7 @@ int sys_thread_create(void* (*start_routine)(void*), void* arg, uint32_t* tid,
     thread->arg = arg;
     thread->process = proc;
     thread->creation_time = get_system_time_ns();
+    ktimer_init(&thread->wait_timer, thread_timeout, thread);
     
     /* Set default name */
     snprintf(thread->name, THREAD_NAME_MAX, "thread_%u", thread->tid);
@@ -386,12 +468,15 @@ int sys_thread_sleep(uint64_t nanoseconds) {
         return THREAD_ESRCH;
     }
     
-    /* For simplicity, just yield for now */
-    /* In a real implementation, we would set up a timer */
+    /* Off the run queue until the wait timer readies us again */
+    uint64_t ns_per_tick = 1000000000ULL / KTIMER_HZ;
+    current->timed_out = false;
     current->state = KTHREAD_STATE_SLEEPING;
+    ktimer_start(&current->wait_timer, (nanoseconds + ns_per_tick - 1) / ns_per_tick);
     schedule();
-    
-    return THREAD_SUCCESS;
+
+    /* Back early only if something else (cancellation) readied us */
+    return disarm_wait_timeout(current) ? THREAD_SUCCESS : THREAD_EINTR;
 }
 
 int sys_thread_cancel(uint32_t tid) {
@@ -451,7 +536,7 @@ int sys_mutex_init(uint32_t* mutex_id, const pthread_mutexattr_t* attr) {
     
     /* Initialize mutex */
     memset(mutex, 0, sizeof(kmutex_t));
-    mutex->magic = 0x4D555458; // "MUTX"
+    mutex->magic = KMUTEX_MAGIC;
     mutex->type = attr ? attr->type : PTHREAD_MUTEX_NORMAL;
     mutex->creation_time = get_system_time_ns();
     
@@ -657,6 +742,97 @@ int sys_mutex_unlock(uint32_t mutex_id) {
     return THREAD_SUCCESS;
 }
 
+/* ================================
+ * Futex Syscalls
+ * ================================ */
+
+/* Private futexes are keyed by process, so threads of one process share
+ * queues; shared ones by physical address, so every mapping of the word
+ * finds the same queue. The low bit keeps the two key spaces apart. */
+static int futex_key(kthread_t* thread, uint32_t* uaddr, uint32_t flags,
+                     uint64_t* space, uint64_t* addr) {
+    uint64_t virt = (uint64_t)(uintptr_t)uaddr;
+    if (!uaddr || (virt & 3)) {
+        return THREAD_EINVAL;
+    }
+
+    if (flags & FUTEX_PRIVATE) {
+        *space = ((uint64_t)thread->pid << 1) | 1;
+        *addr = virt;
+        return THREAD_SUCCESS;
+    }
+
+    vm_space_t* vs = thread->process ? thread->process->address_space : NULL;
+    uint64_t phys = vmm_get_physical_addr(vs, virt);
+    if (!phys) {
+        return THREAD_EINVAL;
+    }
+    *space = 0;
+    *addr = phys;
+    return THREAD_SUCCESS;
+}
+
+/* Wake callback: runs with the futex bucket lock held */
+static void futex_ready_thread(void* owner) {
+    thread_wake((kthread_t*)owner);
+}
+
+int sys_futex_wait(uint32_t* uaddr, uint32_t expected, const struct timespec* abstime,
+                   uint32_t flags) {
+    kthread_t* current = thread_get_current();
+    if (!current) {
+        return THREAD_ESRCH;
+    }
+
+    uint64_t space, addr;
+    int result = futex_key(current, uaddr, flags, &space, &addr);
+    if (result != THREAD_SUCCESS) {
+        return result;
+    }
+
+    /* Mark blocked before queueing so a wake that lands before schedule()
+     * leaves us runnable instead of being lost. */
+    if (!timeout_valid(abstime)) {
+        return THREAD_EINVAL;
+    }
+    arm_wait_timeout(current, abstime);
+    current->state = KTHREAD_STATE_BLOCKED;
+    current->blocking_on = uaddr;
+    current->blocking_type = SYS_FUTEX_WAIT;
+
+    if (futex_queue(&futex_table, &current->futex_wait, space, addr,
+                    uaddr, expected, current) != FUTEX_OK) {
+        disarm_wait_timeout(current);
+        current->state = KTHREAD_STATE_RUNNING;
+        current->blocking_on = NULL;
+        return THREAD_EAGAIN;
+    }
+
+    schedule();
+
+    /* Back either because we were woken or for another reason (timeout);
+     * in the latter case we must not stay linked on the queue. */
+    bool timed_out = disarm_wait_timeout(current);
+    bool still_queued = futex_unqueue(&futex_table, &current->futex_wait);
+    current->blocking_on = NULL;
+    return (still_queued && timed_out) ? THREAD_ETIMEDOUT : THREAD_SUCCESS;
+}
+
+int sys_futex_wake(uint32_t* uaddr, uint32_t count, uint32_t flags) {
+    kthread_t* current = thread_get_current();
+    if (!current) {
+        return THREAD_ESRCH;
+    }
+
+    uint64_t space, addr;
+    int result = futex_key(current, uaddr, flags, &space, &addr);
+    if (result != THREAD_SUCCESS) {
+        return result;
+    }
+
+    return (int)futex_wake(&futex_table, space, addr, count, futex_ready_thread);
+}
+
 /* ================================
  * Thread Management Helper Functions
  * ================================ */
@@ -667,6 +843,99 @@ kthread_t* thread_get_current(void) {
     return current_thread;
 }
 
+kthread_t* thread_get_by_tid(uint32_t tid) {
+    acquire_threading_lock();
+    kthread_t* thread = find_thread_by_tid(tid);
+    release_threading_lock();
+    return thread;
+}
+
+int sys_thread_list(uint32_t* threads, size_t max_count) {
+    kthread_t* current = thread_get_current();
+    if (!current || !current->process) {
+        return THREAD_ESRCH;
+    }
+    if (!threads && max_count > 0) {
+        return THREAD_EINVAL;
+    }
+
+    /* Walks only the caller's own process */
+    acquire_threading_lock();
+    size_t n = 0;
+    for (kthread_t* thread = current->process->threads; thread && n < max_count;
+         thread = thread->next) {
+        threads[n++] = thread->tid;
+    }
+    release_threading_lock();
+    return (int)n;
+}
+
+/* Take a thread off whatever it is sleeping on. Threading lock held. */
+static void unlink_from_wait(kthread_t* thread) {
+    void* object = thread->blocking_on;
+
+    ktimer_cancel_sync(&thread->wait_timer);
+    futex_unqueue(&futex_table, &thread->futex_wait);
+    if (!object) {
+        return;
+    }
+    switch (thread->blocking_type) {
+        case SYS_COND_WAIT:
+            wait_queue_remove(&((kcond_t*)object)->waiters, thread);
+            break;
+        case SYS_SEM_WAIT:
+            wait_queue_remove(&((ksem_t*)object)->waiters, thread);
+            break;
+        case SYS_RWLOCK_RDLOCK:
+            wait_queue_remove(&((krwlock_t*)object)->read_waiters, thread);
+            break;
+        case SYS_RWLOCK_WRLOCK:
+            wait_queue_remove(&((krwlock_t*)object)->write_waiters, thread);
+            break;
+        case SYS_BARRIER_WAIT:
+            wait_queue_remove(&((kbarrier_t*)object)->waiters, thread);
+            break;
+        default:
+            break;
+    }
+    thread->blocking_on = NULL;
+}
+
+int thread_cleanup_process_threads(process_t* proc) {
+    if (!proc) {
+        return THREAD_EINVAL;
+    }
+
+    /* Process exit: reap every thread but the caller, found through the
+     * process's own list rather than a scan of all threads. */
+    kthread_t* current = thread_get_current();
+    acquire_threading_lock();
+
+    kthread_t* thread = proc->threads;
+    while (thread) {
+        kthread_t* next = thread->next;
+        if (thread != current) {
+            bool live = thread->state != KTHREAD_STATE_ZOMBIE &&
+                        thread->state != KTHREAD_STATE_TERMINATED;
+            unlink_from_wait(thread);
+            thread->state = KTHREAD_STATE_TERMINATED;
+            remove_thread_from_table(thread);
+            thread_cleanup_stack(thread);
+            kfree(thread);
+
+            kernel_stats.threads_destroyed++;
+            if (live) {
+                kernel_stats.active_threads--;
+                active_thread_count--;
+            }
+        }
+        thread = next;
+    }
+
+    release_threading_lock();
+    return THREAD_SUCCESS;
+}
+
 int thread_setup_stack(kthread_t* thread, size_t stack_size) {
     if (stack_size < THREAD_STACK_MIN) {
         stack_size = THREAD_STACK_MIN;
@@ -709,39 +978,183 @@ int thread_schedule_kernel(kthread_t* thread) {
 }
 
 /* ================================
- * Synchronization Object Management
+ * Wait Queues
  * ================================ */
 
-int mutex_add_waiter(kmutex_t* mutex, kthread_t* thread) {
+void wait_queue_init(kwait_queue_t* queue) {
+    queue->head = NULL;
+    queue->tail = NULL;
+    queue->count = 0;
+}
+
+void wait_queue_add(kwait_queue_t* queue, kthread_t* thread) {
     /* Add to end of wait queue */
     thread->blocker_next = NULL;
-    if (mutex->wait_queue_tail) {
-        mutex->wait_queue_tail->blocker_next = thread;
+    if (queue->tail) {
+        queue->tail->blocker_next = thread;
     } else {
-        mutex->wait_queue_head = thread;
+        queue->head = thread;
     }
-    mutex->wait_queue_tail = thread;
-    mutex->waiters_count++;
-    return THREAD_SUCCESS;
+    queue->tail = thread;
+    queue->count++;
 }
 
-kthread_t* mutex_remove_waiter(kmutex_t* mutex) {
+kthread_t* wait_queue_pop(kwait_queue_t* queue) {
     /* Remove from front of wait queue */
-    kthread_t* waiter = mutex->wait_queue_head;
+    kthread_t* waiter = queue->head;
     if (waiter) {
-        mutex->wait_queue_head = waiter->blocker_next;
-        if (mutex->wait_queue_head == NULL) {
-            mutex->wait_queue_tail = NULL;
+        queue->head = waiter->blocker_next;
+        if (queue->head == NULL) {
+            queue->tail = NULL;
         }
         waiter->blocker_next = NULL;
-        mutex->waiters_count--;
+        queue->count--;
     }
     return waiter;
 }
 
+bool wait_queue_remove(kwait_queue_t* queue, kthread_t* thread) {
+    kthread_t* prev = NULL;
+    for (kthread_t* t = queue->head; t; prev = t, t = t->blocker_next) {
+        if (t != thread) {
+            continue;
+        }
+        if (prev) {
+            prev->blocker_next = t->blocker_next;
+        } else {
+            queue->head = t->blocker_next;
+        }
+        if (queue->tail == t) {
+            queue->tail = prev;
+        }
+        t->blocker_next = NULL;
+        queue->count--;
+        return true;
+    }
+    return false;
+}
+
+void thread_ready(kthread_t* thread) {
+    /* Only the first of a waker and a wait timeout may requeue the thread */
+    if (__sync_bool_compare_and_swap(&thread->state, KTHREAD_STATE_BLOCKED, KTHREAD_STATE_READY) ||
+        __sync_bool_compare_and_swap(&thread->state, KTHREAD_STATE_SLEEPING, KTHREAD_STATE_READY)) {
+        thread_schedule_kernel(thread);
+    }
+}
+
+void thread_wake(kthread_t* thread) {
+    thread->blocking_on = NULL;
+    thread_ready(thread);
+}
+
+uint32_t wait_queue_wake(kwait_queue_t* queue, uint32_t count) {
+    uint32_t woken = 0;
+    while (woken < count) {
+        kthread_t* thread = wait_queue_pop(queue);
+        if (!thread) {
+            break;
+        }
+        thread_wake(thread);
+        woken++;
+    }
+    return woken;
+}
+
+/* Queue the current thread on `queue`, blocked on `object`. Called with the
+ * threading lock held; follow with sleep_on(). */
+static void block_current(kthread_t* current, kwait_queue_t* queue,
+                          void* object, uint32_t type) {
+    current->state = KTHREAD_STATE_BLOCKED;
+    current->blocking_on = object;
+    current->blocking_type = type;
+    wait_queue_add(queue, current);
+}
+
+/* Drop the threading lock, sleep, and retake it. Wakers hand over whatever
+ * the sleeper was waiting for before calling thread_wake(), so a normal
+ * return means the operation completed. Returns false if the thread came
+ * back without being woken (e.g. cancellation), after unqueueing it. */
+static bool sleep_on(kthread_t* current, kwait_queue_t* queue) {
+    release_threading_lock();
+    schedule();
+    acquire_threading_lock();
+
+    if (current->blocking_on == NULL) {
+        return true;
+    }
+    wait_queue_remove(queue, current);
+    current->blocking_on = NULL;
+    current->state = KTHREAD_STATE_RUNNING;
+    return false;
+}
+
+/* ================================
+ * Synchronization Object Management
+ * ================================ */
+
+int mutex_add_waiter(kmutex_t* mutex, kthread_t* thread) {
+    wait_queue_add(&mutex->waiters, thread);
+    return THREAD_SUCCESS;
+}
+
+kthread_t* mutex_remove_waiter(kmutex_t* mutex) {
+    return wait_queue_pop(&mutex->waiters);
+}
+
+int cond_add_waiter(kcond_t* cond, kthread_t* thread) {
+    wait_queue_add(&cond->waiters, thread);
+    return THREAD_SUCCESS;
+}
+
+kthread_t* cond_remove_waiter(kcond_t* cond) {
+    return wait_queue_pop(&cond->waiters);
+}
+
+int sem_add_waiter(ksem_t* sem, kthread_t* thread) {
+    wait_queue_add(&sem->waiters, thread);
+    return THREAD_SUCCESS;
+}
+
+kthread_t* sem_remove_waiter(ksem_t* sem) {
+    return wait_queue_pop(&sem->waiters);
+}
+
+int rwlock_add_reader_waiter(krwlock_t* rwlock, kthread_t* thread) {
+    wait_queue_add(&rwlock->read_waiters, thread);
+    return THREAD_SUCCESS;
+}
+
+int rwlock_add_writer_waiter(krwlock_t* rwlock, kthread_t* thread) {
+    wait_queue_add(&rwlock->write_waiters, thread);
+    return THREAD_SUCCESS;
+}
+
 int thread_wake_all_waiters(void* sync_object) {
-    /* Implementation depends on sync object type */
-    /* For now, just return success */
+    if (!sync_object) {
+        return THREAD_EINVAL;
+    }
+
+    /* Every kernel sync object starts with its magic */
+    switch (*(uint32_t*)sync_object) {
+        case KMUTEX_MAGIC:
+            wait_queue_wake(&((kmutex_t*)sync_object)->waiters, UINT32_MAX);
+            break;
+        case KCOND_MAGIC:
+            wait_queue_wake(&((kcond_t*)sync_object)->waiters, UINT32_MAX);
+            break;
+        case KSEM_MAGIC:
+            wait_queue_wake(&((ksem_t*)sync_object)->waiters, UINT32_MAX);
+            break;
+        case KRWLOCK_MAGIC:
+            wait_queue_wake(&((krwlock_t*)sync_object)->read_waiters, UINT32_MAX);
+            wait_queue_wake(&((krwlock_t*)sync_object)->write_waiters, UINT32_MAX);
+            break;
+        case KBARRIER_MAGIC:
+            wait_queue_wake(&((kbarrier_t*)sync_object)->waiters, UINT32_MAX);
+            break;
+        default:
+            return THREAD_EINVAL;
+    }
     return THREAD_SUCCESS;
 }
 
@@ -792,7 +1205,7 @@ int sys_thread_stats(pthread_stats_t* stats) {
     stats->total_threads_created = kernel_stats.threads_created;
     stats->active_threads = kernel_stats.active_threads;
     stats->context_switches = kernel_stats.context_switches;
-    stats->mutex_contentions = kernel_stats.mutex_operations;
+    stats->mutex_contentions = kernel_stats.mutex_operations + futex_table.stats.waits;
     stats->condition_signals = kernel_stats.cond_operations;
     stats->semaphore_operations = kernel_stats.sem_operations;
     stats->total_cpu_time = kernel_stats.total_cpu_time;
@@ -816,75 +1229,669 @@ bool thread_validate_mutex_id(uint32_t mutex_id) {
 }
 
 /* ================================
- * Placeholder implementations for remaining syscalls
+ * Blocking Synchronization Objects
  * ================================ */
 
-/* Condition variables - simplified implementations */
-int sys_cond_init(uint32_t* cond_id, const pthread_condattr_t* attr) {
-    *cond_id = __sync_fetch_and_add(&next_cond_id, 1);
-    kernel_stats.cond_operations++;
-    return THREAD_SUCCESS;
-}
+#define TABLE_SLOTS(table) (sizeof(table) / sizeof((table)[0]))
 
-int sys_cond_destroy(uint32_t cond_id) { 
-    kernel_stats.cond_operations++;
-    return THREAD_SUCCESS; 
+/* Store a new object in the first free slot of an ID table (slot 0 is never
+ * used, so 0 is not a valid ID). Returns the ID, or 0 if the table is full. */
+static uint32_t install_object(void** table, uint32_t slots, void* object) {
+    for (uint32_t i = 1; i < slots; i++) {
+        if (table[i] == NULL) {
+            table[i] = object;
+            return i;
+        }
+    }
+    return 0;
 }
 
-int sys_cond_wait(uint32_t cond_id, uint32_t mutex_id) { 
-    kernel_stats.cond_operations++;
-    return THREAD_SUCCESS; 
+/* Object for an ID, checked against the expected magic */
+static void* lookup_object(void** table, uint32_t slots, uint32_t id, uint32_t magic) {
+    if (id == 0 || id >= slots || table[id] == NULL) {
+        return NULL;
+    }
+    return *(uint32_t*)table[id] == magic ? table[id] : NULL;
 }
 
-int sys_cond_signal(uint32_t cond_id) { 
-    kernel_stats.cond_operations++;
-    return THREAD_SUCCESS; 
-}
+#define COND_LOOKUP(id)    ((kcond_t*)lookup_object((void**)cond_table, TABLE_SLOTS(cond_table), id, KCOND_MAGIC))
+#define SEM_LOOKUP(id)     ((ksem_t*)lookup_object((void**)sem_table, TABLE_SLOTS(sem_table), id, KSEM_MAGIC))
+#define RWLOCK_LOOKUP(id)  ((krwlock_t*)lookup_object((void**)rwlock_table, TABLE_SLOTS(rwlock_table), id, KRWLOCK_MAGIC))
+#define BARRIER_LOOKUP(id) ((kbarrier_t*)lookup_object((void**)barrier_table, TABLE_SLOTS(barrier_table), id, KBARRIER_MAGIC))
+
+/* ================================
+ * Condition Variable Syscalls
+ * ================================ */
+
+int sys_cond_init(uint32_t* cond_id, const pthread_condattr_t* attr) {
+    if (!cond_id) {
+        return THREAD_EINVAL;
+    }
+
+    kcond_t* cond = (kcond_t*)kmalloc(sizeof(kcond_t));
+    if (!cond) {
+        return THREAD_ENOMEM;
+    }
+    memset(cond, 0, sizeof(kcond_t));
+    cond->magic = KCOND_MAGIC;
+    cond->creation_time = get_system_time_ns();
+    wait_queue_init(&cond->waiters);
 
-int sys_cond_broadcast(uint32_t cond_id) { 
+    acquire_threading_lock();
+    uint32_t id = install_object((void**)cond_table, TABLE_SLOTS(cond_table), cond);
     kernel_stats.cond_operations++;
-    return THREAD_SUCCESS; 
-}
+    release_threading_lock();
 
-/* Semaphores - simplified implementations */
-int sys_sem_init(uint32_t* sem_id, int pshared, unsigned int value) {
-    *sem_id = __sync_fetch_and_add(&next_sem_id, 1);
-    kernel_stats.sem_operations++;
+    if (id == 0) {
+        kfree(cond);
+        return THREAD_ENOMEM;
+    }
+    *cond_id = id;
     return THREAD_SUCCESS;
 }
 
-int sys_sem_destroy(uint32_t sem_id) { 
-    kernel_stats.sem_operations++;
-    return THREAD_SUCCESS; 
-}
+int sys_cond_destroy(uint32_t cond_id) {
+    acquire_threading_lock();
 
-int sys_sem_wait(uint32_t sem_id) { 
-    kernel_stats.sem_operations++;
-    return THREAD_SUCCESS; 
-}
+    kcond_t* cond = COND_LOOKUP(cond_id);
+    if (!cond) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+    if (cond->waiters.count > 0) {
+        release_threading_lock();
+        return THREAD_EBUSY;
+    }
 
-int sys_sem_post(uint32_t sem_id) { 
-    kernel_stats.sem_operations++;
-    return THREAD_SUCCESS; 
-}
+    cond_table[cond_id] = NULL;
+    kernel_stats.cond_operations++;
+    release_threading_lock();
 
-/* Simplified implementations for other sync primitives */
-int sys_rwlock_init(uint32_t* rwlock_id, const pthread_rwlockattr_t* attr) {
-    *rwlock_id = __sync_fetch_and_add(&next_rwlock_id, 1);
-    kernel_stats.rwlock_operations++;
+    kfree(cond);
     return THREAD_SUCCESS;
 }
 
-int sys_rwlock_destroy(uint32_t rwlock_id) { 
-    kernel_stats.rwlock_operations++;
-    return THREAD_SUCCESS; 
+/* Release a futex mutex on its owner's behalf; same protocol as
+ * pthread_mutex_unlock() in user/pthread.c. */
+static void futex_mutex_release(uint32_t* word, uint64_t space, uint64_t addr) {
+    if (__atomic_exchange_n(word, 0, __ATOMIC_RELEASE) == 2) {
+        futex_wake(&futex_table, space, addr, 1, futex_ready_thread);
+    }
 }
 
-int sys_barrier_init(uint32_t* barrier_id, const pthread_barrierattr_t* attr, unsigned int count) {
-    *barrier_id = __sync_fetch_and_add(&next_barrier_id, 1);
-    return THREAD_SUCCESS;
+int sys_cond_wait(uint32_t cond_id, uint32_t* mutex_word, uint32_t flags) {
+    return sys_cond_timedwait(cond_id, mutex_word, flags, NULL);
 }
 
+int sys_cond_timedwait(uint32_t cond_id, uint32_t* mutex_word, uint32_t flags,
+                       const struct timespec* abstime) {
+    kthread_t* current = thread_get_current();
+    if (!current) {
+        return THREAD_ESRCH;
+    }
+
+    uint64_t space, addr;
+    int result = futex_key(current, mutex_word, flags, &space, &addr);
+    if (result != THREAD_SUCCESS) {
+        return result;
+    }
+
+    if (!timeout_valid(abstime)) {
+        return THREAD_EINVAL;
+    }
+
+    acquire_threading_lock();
+
+    kcond_t* cond = COND_LOOKUP(cond_id);
+    if (!cond) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+
+    /* All concurrent waiters must use the same mutex */
+    if (cond->waiters.count > 0 &&
+        (cond->mutex_space != space || cond->mutex_addr != addr)) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+    cond->mutex_word = mutex_word;
+    cond->mutex_pid = current->pid;
+    cond->mutex_space = space;
+    cond->mutex_addr = addr;
+
+    block_current(current, &cond->waiters, cond, SYS_COND_WAIT);
+    arm_wait_timeout(current, abstime);
+    kernel_stats.cond_operations++;
+
+    /* Unlock only once queued, so a signal sent right after the caller's
+     * mutex is released cannot be missed. */
+    futex_mutex_release(mutex_word, space, addr);
+    release_threading_lock();
+
+    schedule();
+
+    /* Woken by a signal, by the mutex after a requeuing broadcast, by the
+     * timeout, or back early: in every case leave no queue entry behind.
+     * Only a waiter still on the condition's own queue missed its signal.
+     * The caller retakes its mutex in user space. */
+    bool timed_out = disarm_wait_timeout(current);
+    futex_unqueue(&futex_table, &current->futex_wait);
+    acquire_threading_lock();
+    if (current->blocking_on == cond) {
+        wait_queue_remove(&cond->waiters, current);
+        current->blocking_on = NULL;
+        current->state = KTHREAD_STATE_RUNNING;
+        result = timed_out ? THREAD_ETIMEDOUT : THREAD_SUCCESS;
+    }
+    release_threading_lock();
+
+    return result;
+}
+
+int sys_cond_signal(uint32_t cond_id) {
+    acquire_threading_lock();
+
+    kcond_t* cond = COND_LOOKUP(cond_id);
+    if (!cond) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+
+    wait_queue_wake(&cond->waiters, 1);
+    kernel_stats.cond_operations++;
+
+    release_threading_lock();
+    return THREAD_SUCCESS;
+}
+
+/* Broadcast wakes one waiter and moves the rest straight onto the mutex's
+ * futex queue: only one of them could take the mutex anyway, and each
+ * unlock now wakes the next instead of all of them racing for it at once. */
+int sys_cond_broadcast(uint32_t cond_id) {
+    kthread_t* current = thread_get_current();
+
+    acquire_threading_lock();
+
+    kcond_t* cond = COND_LOOKUP(cond_id);
+    if (!cond) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+
+    cond->broadcast_seq++;
+    kernel_stats.cond_operations++;
+
+    if (wait_queue_wake(&cond->waiters, 1) == 0 || cond->waiters.count == 0) {
+        release_threading_lock();
+        return THREAD_SUCCESS;
+    }
+
+    /* The mutex word can only be touched from the address space it was
+     * recorded in; otherwise fall back to waking everyone. */
+    if (!current || current->pid != cond->mutex_pid) {
+        wait_queue_wake(&cond->waiters, UINT32_MAX);
+        release_threading_lock();
+        return THREAD_SUCCESS;
+    }
+
+    /* Mark the mutex contended so whoever unlocks it wakes the next of the
+     * requeued threads. If it is free, the thread just woken will mark it
+     * when it locks. */
+    __sync_bool_compare_and_swap(cond->mutex_word, 1, 2);
+
+    kthread_t* thread;
+    while ((thread = wait_queue_pop(&cond->waiters)) != NULL) {
+        thread->blocking_on = cond->mutex_word;
+        thread->blocking_type = SYS_FUTEX_WAIT;
+        futex_enqueue(&futex_table, &thread->futex_wait, cond->mutex_space,
+                      cond->mutex_addr, thread);
+        kernel_stats.cond_requeues++;
+    }
+
+    release_threading_lock();
+    return THREAD_SUCCESS;
+}
+
+/* ================================
+ * Semaphore Syscalls
+ * ================================ */
+
+int sys_sem_init(uint32_t* sem_id, int pshared, unsigned int value) {
+    if (!sem_id || value > KSEM_VALUE_MAX) {
+        return THREAD_EINVAL;
+    }
+    (void)pshared;
+
+    ksem_t* sem = (ksem_t*)kmalloc(sizeof(ksem_t));
+    if (!sem) {
+        return THREAD_ENOMEM;
+    }
+    memset(sem, 0, sizeof(ksem_t));
+    sem->magic = KSEM_MAGIC;
+    sem->value = value;
+    sem->max_value = KSEM_VALUE_MAX;
+    sem->creation_time = get_system_time_ns();
+    wait_queue_init(&sem->waiters);
+
+    acquire_threading_lock();
+    uint32_t id = install_object((void**)sem_table, TABLE_SLOTS(sem_table), sem);
+    kernel_stats.sem_operations++;
+    release_threading_lock();
+
+    if (id == 0) {
+        kfree(sem);
+        return THREAD_ENOMEM;
+    }
+    *sem_id = id;
+    return THREAD_SUCCESS;
+}
+
+int sys_sem_destroy(uint32_t sem_id) {
+    acquire_threading_lock();
+
+    ksem_t* sem = SEM_LOOKUP(sem_id);
+    if (!sem) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+    if (sem->waiters.count > 0) {
+        release_threading_lock();
+        return THREAD_EBUSY;
+    }
+
+    sem_table[sem_id] = NULL;
+    kernel_stats.sem_operations++;
+    release_threading_lock();
+
+    kfree(sem);
+    return THREAD_SUCCESS;
+}
+
+int sys_sem_wait(uint32_t sem_id) {
+    return sys_sem_timedwait(sem_id, NULL);
+}
+
+int sys_sem_timedwait(uint32_t sem_id, const struct timespec* abs_timeout) {
+    kthread_t* current = thread_get_current();
+    if (!current) {
+        return THREAD_ESRCH;
+    }
+    if (!timeout_valid(abs_timeout)) {
+        return THREAD_EINVAL;
+    }
+
+    acquire_threading_lock();
+
+    ksem_t* sem = SEM_LOOKUP(sem_id);
+    if (!sem) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+    kernel_stats.sem_operations++;
+
+    if (sem->value > 0) {
+        sem->value--;
+        release_threading_lock();
+        return THREAD_SUCCESS;
+    }
+
+    /* sys_sem_post hands its unit straight to us rather than incrementing */
+    block_current(current, &sem->waiters, sem, SYS_SEM_WAIT);
+    arm_wait_timeout(current, abs_timeout);
+    bool woken = sleep_on(current, &sem->waiters);
+    bool timed_out = disarm_wait_timeout(current);
+
+    release_threading_lock();
+    if (woken) {
+        return THREAD_SUCCESS;
+    }
+    return timed_out ? THREAD_ETIMEDOUT : THREAD_EINTR;
+}
+
+int sys_sem_trywait(uint32_t sem_id) {
+    acquire_threading_lock();
+
+    ksem_t* sem = SEM_LOOKUP(sem_id);
+    if (!sem) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+    kernel_stats.sem_operations++;
+
+    if (sem->value == 0) {
+        release_threading_lock();
+        return THREAD_EAGAIN;
+    }
+    sem->value--;
+
+    release_threading_lock();
+    return THREAD_SUCCESS;
+}
+
+int sys_sem_post(uint32_t sem_id) {
+    acquire_threading_lock();
+
+    ksem_t* sem = SEM_LOOKUP(sem_id);
+    if (!sem) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+    kernel_stats.sem_operations++;
+
+    /* Wake exactly one sleeper and give it the unit directly, so a newly
+     * arriving sem_wait cannot steal it and send the sleeper back to sleep. */
+    if (wait_queue_wake(&sem->waiters, 1) == 0) {
+        if (sem->value >= sem->max_value) {
+            release_threading_lock();
+            return THREAD_EAGAIN;
+        }
+        sem->value++;
+    }
+
+    release_threading_lock();
+    return THREAD_SUCCESS;
+}
+
+int sys_sem_getvalue(uint32_t sem_id, int* sval) {
+    if (!sval) {
+        return THREAD_EINVAL;
+    }
+
+    acquire_threading_lock();
+
+    ksem_t* sem = SEM_LOOKUP(sem_id);
+    if (!sem) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+    *sval = (int)sem->value;
+
+    release_threading_lock();
+    return THREAD_SUCCESS;
+}
+
+/* ================================
+ * Read-Write Lock Syscalls
+ * ================================ */
+
+/*
+ * Phase-fair: a reader may not join while a writer holds the lock or is
+ * waiting for it, and when a writer releases it every reader queued at that
+ * moment is admitted together before the next writer. Readers therefore
+ * cannot starve writers, and a stream of writers cannot starve readers.
+ * Ownership is handed over before waking, so woken threads never retry.
+ */
+
+/* Give the lock to the next phase after it became free */
+static void rwlock_grant(krwlock_t* rwlock, bool writer_released) {
+    if (writer_released && rwlock->read_waiters.count > 0) {
+        rwlock->readers += rwlock->read_waiters.count;
+        wait_queue_wake(&rwlock->read_waiters, UINT32_MAX);
+        return;
+    }
+
+    kthread_t* writer = wait_queue_pop(&rwlock->write_waiters);
+    if (writer) {
+        rwlock->writers = 1;
+        rwlock->writer_tid = writer->tid;
+        thread_wake(writer);
+    } else if (rwlock->read_waiters.count > 0) {
+        rwlock->readers += rwlock->read_waiters.count;
+        wait_queue_wake(&rwlock->read_waiters, UINT32_MAX);
+    }
+}
+
+static bool rwlock_can_read(const krwlock_t* rwlock) {
+    return rwlock->writers == 0 && rwlock->write_waiters.count == 0;
+}
+
+static bool rwlock_can_write(const krwlock_t* rwlock) {
+    return rwlock->writers == 0 && rwlock->readers == 0;
+}
+
+int sys_rwlock_init(uint32_t* rwlock_id, const pthread_rwlockattr_t* attr) {
+    if (!rwlock_id) {
+        return THREAD_EINVAL;
+    }
+
+    krwlock_t* rwlock = (krwlock_t*)kmalloc(sizeof(krwlock_t));
+    if (!rwlock) {
+        return THREAD_ENOMEM;
+    }
+    memset(rwlock, 0, sizeof(krwlock_t));
+    rwlock->magic = KRWLOCK_MAGIC;
+    rwlock->creation_time = get_system_time_ns();
+    wait_queue_init(&rwlock->read_waiters);
+    wait_queue_init(&rwlock->write_waiters);
+
+    acquire_threading_lock();
+    uint32_t id = install_object((void**)rwlock_table, TABLE_SLOTS(rwlock_table), rwlock);
+    kernel_stats.rwlock_operations++;
+    release_threading_lock();
+
+    if (id == 0) {
+        kfree(rwlock);
+        return THREAD_ENOMEM;
+    }
+    *rwlock_id = id;
+    return THREAD_SUCCESS;
+}
+
+int sys_rwlock_destroy(uint32_t rwlock_id) {
+    acquire_threading_lock();
+
+    krwlock_t* rwlock = RWLOCK_LOOKUP(rwlock_id);
+    if (!rwlock) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+    if (rwlock->readers || rwlock->writers ||
+        rwlock->read_waiters.count || rwlock->write_waiters.count) {
+        release_threading_lock();
+        return THREAD_EBUSY;
+    }
+
+    rwlock_table[rwlock_id] = NULL;
+    kernel_stats.rwlock_operations++;
+    release_threading_lock();
+
+    kfree(rwlock);
+    return THREAD_SUCCESS;
+}
+
+/* Shared body of the four lock calls */
+static int rwlock_lock(uint32_t rwlock_id, bool write, bool try_only) {
+    kthread_t* current = thread_get_current();
+    if (!current) {
+        return THREAD_ESRCH;
+    }
+
+    acquire_threading_lock();
+
+    krwlock_t* rwlock = RWLOCK_LOOKUP(rwlock_id);
+    if (!rwlock) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+    kernel_stats.rwlock_operations++;
+
+    if (rwlock->writers && rwlock->writer_tid == current->tid) {
+        release_threading_lock();
+        return THREAD_EDEADLK;
+    }
+
+    if (write ? rwlock_can_write(rwlock) : rwlock_can_read(rwlock)) {
+        if (write) {
+            rwlock->writers = 1;
+            rwlock->writer_tid = current->tid;
+        } else {
+            rwlock->readers++;
+        }
+        release_threading_lock();
+        return THREAD_SUCCESS;
+    }
+
+    if (try_only) {
+        release_threading_lock();
+        return THREAD_EBUSY;
+    }
+
+    kwait_queue_t* queue = write ? &rwlock->write_waiters : &rwlock->read_waiters;
+    block_current(current, queue, rwlock, write ? SYS_RWLOCK_WRLOCK : SYS_RWLOCK_RDLOCK);
+    bool woken = sleep_on(current, queue);
+
+    /* A writer that gives up may have been what held readers back */
+    if (!woken && write && rwlock->writers == 0 && rwlock->write_waiters.count == 0 &&
+        rwlock->read_waiters.count > 0) {
+        rwlock_grant(rwlock, true);
+    }
+
+    release_threading_lock();
+    return woken ? THREAD_SUCCESS : THREAD_EINTR;
+}
+
+int sys_rwlock_rdlock(uint32_t rwlock_id) {
+    return rwlock_lock(rwlock_id, false, false);
+}
+
+int sys_rwlock_wrlock(uint32_t rwlock_id) {
+    return rwlock_lock(rwlock_id, true, false);
+}
+
+int sys_rwlock_tryrdlock(uint32_t rwlock_id) {
+    return rwlock_lock(rwlock_id, false, true);
+}
+
+int sys_rwlock_trywrlock(uint32_t rwlock_id) {
+    return rwlock_lock(rwlock_id, true, true);
+}
+
+int sys_rwlock_unlock(uint32_t rwlock_id) {
+    kthread_t* current = thread_get_current();
+    if (!current) {
+        return THREAD_ESRCH;
+    }
+
+    acquire_threading_lock();
+
+    krwlock_t* rwlock = RWLOCK_LOOKUP(rwlock_id);
+    if (!rwlock) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+    kernel_stats.rwlock_operations++;
+
+    if (rwlock->writers) {
+        if (rwlock->writer_tid != current->tid) {
+            release_threading_lock();
+            return THREAD_EPERM;
+        }
+        rwlock->writers = 0;
+        rwlock->writer_tid = 0;
+        rwlock_grant(rwlock, true);
+    } else if (rwlock->readers > 0) {
+        if (--rwlock->readers == 0) {
+            rwlock_grant(rwlock, false);
+        }
+    } else {
+        release_threading_lock();
+        return THREAD_EPERM;
+    }
+
+    release_threading_lock();
+    return THREAD_SUCCESS;
+}
+
+/* ================================
+ * Barrier Syscalls
+ * ================================ */
+
+int sys_barrier_init(uint32_t* barrier_id, const pthread_barrierattr_t* attr, unsigned int count) {
+    if (!barrier_id || count == 0) {
+        return THREAD_EINVAL;
+    }
+
+    kbarrier_t* barrier = (kbarrier_t*)kmalloc(sizeof(kbarrier_t));
+    if (!barrier) {
+        return THREAD_ENOMEM;
+    }
+    memset(barrier, 0, sizeof(kbarrier_t));
+    barrier->magic = KBARRIER_MAGIC;
+    barrier->count = count;
+    barrier->creation_time = get_system_time_ns();
+    wait_queue_init(&barrier->waiters);
+
+    acquire_threading_lock();
+    uint32_t id = install_object((void**)barrier_table, TABLE_SLOTS(barrier_table), barrier);
+    release_threading_lock();
+
+    if (id == 0) {
+        kfree(barrier);
+        return THREAD_ENOMEM;
+    }
+    *barrier_id = id;
+    return THREAD_SUCCESS;
+}
+
+int sys_barrier_destroy(uint32_t barrier_id) {
+    acquire_threading_lock();
+
+    kbarrier_t* barrier = BARRIER_LOOKUP(barrier_id);
+    if (!barrier) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+    if (barrier->waiting > 0) {
+        release_threading_lock();
+        return THREAD_EBUSY;
+    }
+
+    barrier_table[barrier_id] = NULL;
+    release_threading_lock();
+
+    kfree(barrier);
+    return THREAD_SUCCESS;
+}
+
+int sys_barrier_wait(uint32_t barrier_id) {
+    kthread_t* current = thread_get_current();
+    if (!current) {
+        return THREAD_ESRCH;
+    }
+
+    acquire_threading_lock();
+
+    kbarrier_t* barrier = BARRIER_LOOKUP(barrier_id);
+    if (!barrier) {
+        release_threading_lock();
+        return THREAD_EINVAL;
+    }
+
+    /* The last arrival releases everyone in one pass and starts the next
+     * generation */
+    if (++barrier->waiting == barrier->count) {
+        barrier->waiting = 0;
+        barrier->generation++;
+        wait_queue_wake(&barrier->waiters, UINT32_MAX);
+        release_threading_lock();
+        return KBARRIER_SERIAL_THREAD;
+    }
+
+    block_current(current, &barrier->waiters, barrier, SYS_BARRIER_WAIT);
+    if (!sleep_on(current, &barrier->waiters)) {
+        barrier->waiting--;
+        release_threading_lock();
+        return THREAD_EINTR;
+    }
+
+    release_threading_lock();
+    return THREAD_SUCCESS;
+}
+
+/* ================================
+ * Placeholder implementations for remaining syscalls
+ * ================================ */
+
 int sys_spinlock_init(uint32_t* lock_id, int pshared) {
     *lock_id = __sync_fetch_and_add(&next_spinlock_id, 1);
     kernel_stats.spinlock_operations++;
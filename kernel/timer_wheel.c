@@ -0,0 +1,269 @@
+/* IKOS Kernel Timers - Hierarchical timer wheel
+ *
+ * See include/timer_wheel.h. One spinlock per wheel; callbacks run with it
+ * dropped. The kernel wheel is advanced from the boot CPU's tick, which only
+ * try-locks it: if the interrupted code holds the lock the tick is skipped
+ * and the next one catches up, so no tick is ever lost.
+ */
+
+#include "timer_wheel.h"
+
+static timer_wheel_t kernel_wheel;
+static volatile uint64_t kernel_ticks;
+
+static inline void wheel_lock(timer_wheel_t* wheel) {
+    while (__sync_lock_test_and_set(&wheel->lock, 1)) {
+        __asm__ volatile("pause");
+    }
+}
+
+static inline bool wheel_trylock(timer_wheel_t* wheel) {
+    return __sync_lock_test_and_set(&wheel->lock, 1) == 0;
+}
+
+static inline void wheel_unlock(timer_wheel_t* wheel) {
+    __sync_lock_release(&wheel->lock);
+}
+
+static inline void timer_link(ktimer_t** head, ktimer_t* timer) {
+    timer->next = *head;
+    if (*head) {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+static inline void timer_unlink(ktimer_t* timer) {
+    *timer->pprev = timer->next;
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = 0;
+    timer->pprev = 0;
+}
+
+/* File a timer on the slot its expiry falls in, relative to the next tick
+ * to be processed. Already-due timers go on that tick's slot. */
+static void wheel_place(timer_wheel_t* wheel, ktimer_t* timer) {
+    uint64_t base = wheel->now + 1;
+    uint64_t expires = timer->expires < base ? base : timer->expires;
+    uint64_t delta = expires - base;
+
+    if (delta > TIMER_WHEEL_MAX_DELAY) {
+        /* Park it in the top level; it is re-filed when that slot cascades */
+        delta = TIMER_WHEEL_MAX_DELAY;
+        expires = base + delta;
+    }
+
+    uint32_t level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= (1ULL << (TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    uint32_t slot = (uint32_t)(expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    timer_link(&wheel->slots[level][slot], timer);
+}
+
+/* Re-file every timer on one upper-level slot over the levels below it */
+static void wheel_cascade(timer_wheel_t* wheel, uint32_t level, uint32_t slot) {
+    ktimer_t* timer = wheel->slots[level][slot];
+    wheel->slots[level][slot] = 0;
+    while (timer) {
+        ktimer_t* next = timer->next;
+        timer->next = 0;
+        timer->pprev = 0;
+        wheel_place(wheel, timer);
+        wheel->stats.cascaded++;
+        timer = next;
+    }
+}
+
+static bool wheel_cancel_locked(timer_wheel_t* wheel, ktimer_t* timer) {
+    if (!timer->pprev) {
+        return false;
+    }
+    timer_unlink(timer);
+    wheel->pending--;
+    wheel->stats.cancelled++;
+    return true;
+}
+
+/* Process ticks up to `now`. Called and returns with the lock held. */
+static uint32_t wheel_run(timer_wheel_t* wheel, uint64_t now) {
+    uint32_t fired = 0;
+
+    while (wheel->now < now) {
+        uint64_t tick = wheel->now + 1;
+        uint32_t index = (uint32_t)tick & TIMER_WHEEL_MASK;
+
+        /* Level 0 wrapped: pull the next slot of each level down, as far up
+         * as the wrap carries. */
+        if (index == 0) {
+            for (uint32_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+                uint32_t slot = (uint32_t)(tick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+                wheel_cascade(wheel, level, slot);
+                if (slot != 0) {
+                    break;
+                }
+            }
+        }
+
+        /* Take the whole slot in one go. Its timers stay cancellable while
+         * the batch runs: they remain linked, on a list headed here. */
+        ktimer_t* batch = wheel->slots[0][index];
+        wheel->slots[0][index] = 0;
+        if (batch) {
+            batch->pprev = &batch;
+        }
+        wheel->now = tick;
+
+        while (batch) {
+            ktimer_t* timer = batch;
+            timer_unlink(timer);
+            wheel->pending--;
+
+            /* Re-arm before the callback so the callback can cancel it */
+            if (timer->period) {
+                timer->expires = tick + timer->period;
+                wheel_place(wheel, timer);
+                wheel->pending++;
+            }
+
+            wheel->running = timer;
+            wheel_unlock(wheel);
+            if (timer->fn) {
+                timer->fn(timer->data);
+            }
+            wheel_lock(wheel);
+            wheel->running = 0;
+
+            wheel->stats.expired++;
+            fired++;
+        }
+    }
+
+    return fired;
+}
+
+void timer_wheel_init(timer_wheel_t* wheel, uint64_t now) {
+    if (!wheel) {
+        return;
+    }
+    for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (uint32_t slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            wheel->slots[level][slot] = 0;
+        }
+    }
+    wheel->lock = 0;
+    wheel->now = now;
+    wheel->pending = 0;
+    wheel->running = 0;
+    wheel->stats = (timer_wheel_stats_t){0};
+}
+
+void ktimer_init(ktimer_t* timer, ktimer_fn fn, void* data) {
+    if (!timer) {
+        return;
+    }
+    timer->expires = 0;
+    timer->period = 0;
+    timer->fn = fn;
+    timer->data = data;
+    timer->next = 0;
+    timer->pprev = 0;
+}
+
+void timer_wheel_add(timer_wheel_t* wheel, ktimer_t* timer, uint64_t delay, uint64_t period) {
+    if (!wheel || !timer) {
+        return;
+    }
+
+    wheel_lock(wheel);
+    if (timer->pprev) {
+        timer_unlink(timer);
+        wheel->pending--;
+    }
+    timer->expires = wheel->now + (delay ? delay : 1);
+    timer->period = period;
+    wheel_place(wheel, timer);
+    wheel->pending++;
+    wheel->stats.started++;
+    wheel_unlock(wheel);
+}
+
+bool timer_wheel_cancel(timer_wheel_t* wheel, ktimer_t* timer) {
+    if (!wheel || !timer) {
+        return false;
+    }
+
+    wheel_lock(wheel);
+    bool was_pending = wheel_cancel_locked(wheel, timer);
+    wheel_unlock(wheel);
+    return was_pending;
+}
+
+uint32_t timer_wheel_advance(timer_wheel_t* wheel, uint64_t now) {
+    if (!wheel) {
+        return 0;
+    }
+
+    wheel_lock(wheel);
+    uint32_t fired = wheel_run(wheel, now);
+    wheel_unlock(wheel);
+    return fired;
+}
+
+/* ================================
+ * Kernel wheel
+ * ================================ */
+
+uint64_t ktimer_now(void) {
+    return kernel_ticks;
+}
+
+void ktimer_start(ktimer_t* timer, uint64_t delay) {
+    timer_wheel_add(&kernel_wheel, timer, delay, 0);
+}
+
+void ktimer_start_periodic(ktimer_t* timer, uint64_t period) {
+    timer_wheel_add(&kernel_wheel, timer, period, period ? period : 1);
+}
+
+bool ktimer_cancel(ktimer_t* timer) {
+    return timer_wheel_cancel(&kernel_wheel, timer);
+}
+
+bool ktimer_cancel_sync(ktimer_t* timer) {
+    if (!timer) {
+        return false;
+    }
+
+    for (;;) {
+        wheel_lock(&kernel_wheel);
+        if (kernel_wheel.running != timer) {
+            bool was_pending = wheel_cancel_locked(&kernel_wheel, timer);
+            wheel_unlock(&kernel_wheel);
+            return was_pending;
+        }
+        wheel_unlock(&kernel_wheel);
+        __asm__ volatile("pause");
+    }
+}
+
+void ktimer_tick(void) {
+    uint64_t now = __sync_add_and_fetch(&kernel_ticks, 1);
+
+    if (!wheel_trylock(&kernel_wheel)) {
+        return;
+    }
+    wheel_run(&kernel_wheel, now);
+    wheel_unlock(&kernel_wheel);
+}
+
+timer_wheel_stats_t ktimer_get_stats(void) {
+    wheel_lock(&kernel_wheel);
+    timer_wheel_stats_t stats = kernel_wheel.stats;
+    wheel_unlock(&kernel_wheel);
+    return stats;
+}
@@ -87,6 +87,7 @@ mm_struct_t* mm_alloc(void) {
     
     /* Initialize address space layout */
     mm->task_size = 0x800000000000ULL;     /* 128TB user space */
+    vm_itree_init(&mm->mm_rb, 0, mm->task_size);
     mm->start_code = 0x400000;             /* 4MB start */
     mm->end_code = 0x400000;
     mm->start_data = 0x600000;             /* 6MB start */
@@ -184,6 +185,9 @@ mm_struct_t* mm_copy(mm_struct_t* oldmm) {
         new_vma->vm_next = NULL;
         new_vma->vm_prev = prev;
         
+        /* Source VMAs are sorted and disjoint, so this always appends */
+        vm_itree_insert(&mm->mm_rb, &new_vma->vm_rb, new_vma->vm_start, new_vma->vm_end);
+        
         /* Link into list */
         if (prev) {
             prev->vm_next = new_vma;
@@ -224,6 +228,10 @@ int mm_init(mm_struct_t* mm, struct process* task) {
 
 /* ========================== VMA Management ========================== */
 
+static inline vm_area_struct_t* rb_to_vma(vm_itree_node_t* node) {
+    return node ? VM_ITREE_ENTRY(node, vm_area_struct_t, vm_rb) : NULL;
+}
+
 vm_area_struct_t* find_vma(mm_struct_t* mm, uint64_t addr) {
     vm_area_struct_t* vma;
     
@@ -237,18 +245,13 @@ vm_area_struct_t* find_vma(mm_struct_t* mm, uint64_t addr) {
         return vma;
     }
     
-    /* Linear search through VMA list */
-    for (vma = mm->mmap; vma; vma = vma->vm_next) {
-        if (addr < vma->vm_end) {
-            if (addr >= vma->vm_start) {
-                mm->mmap_cache = vma;
-                return vma;
-            }
-            break;
-        }
+    /* O(log n) lookup in the VMA index */
+    vma = rb_to_vma(vm_itree_find(&mm->mm_rb, addr));
+    if (vma) {
+        mm->mmap_cache = vma;
     }
     
-    return NULL;
+    return vma;
 }
 
 vm_area_struct_t* find_vma_prev(mm_struct_t* mm, uint64_t addr, vm_area_struct_t** prev) {
@@ -260,54 +263,38 @@ vm_area_struct_t* find_vma_prev(mm_struct_t* mm, uint64_t addr, vm_area_struct_t
     if (vma) {
         *prev = vma->vm_prev;
     } else {
-        /* Find the last VMA before addr */
-        for (vma = mm->mmap; vma; vma = vma->vm_next) {
-            if (addr < vma->vm_start) {
-                break;
-            }
-            *prev = vma;
-        }
+        /* The last VMA before addr precedes the first one above it */
+        vm_area_struct_t* above = rb_to_vma(vm_itree_lower_bound(&mm->mm_rb, addr));
+        *prev = above ? above->vm_prev : rb_to_vma(vm_itree_last(&mm->mm_rb));
     }
     
     return vma;
 }
 
 vm_area_struct_t* find_vma_intersection(mm_struct_t* mm, uint64_t start, uint64_t end) {
-    vm_area_struct_t* vma;
-    
-    for (vma = mm->mmap; vma; vma = vma->vm_next) {
-        if (vma->vm_end <= start) {
-            continue;
-        }
-        if (vma->vm_start >= end) {
-            break;
-        }
-        return vma; /* Found intersection */
+    if (!mm) {
+        return NULL;
     }
     
-    return NULL;
+    return rb_to_vma(vm_itree_first_overlap(&mm->mm_rb, start, end));
 }
 
-int insert_vm_area(mm_struct_t* mm, vm_area_struct_t* vma) {
+/* Index a VMA and link it into the sorted list, without memory accounting. */
+static int vma_link(mm_struct_t* mm, vm_area_struct_t* vma) {
     vm_area_struct_t* prev_vma, *next_vma;
     
     if (!mm || !vma) {
         return -USMM_EINVAL;
     }
     
-    /* Check for overlaps */
-    if (find_vma_intersection(mm, vma->vm_start, vma->vm_end)) {
+    /* Index the VMA; the tree rejects overlaps */
+    if (vm_itree_insert(&mm->mm_rb, &vma->vm_rb, vma->vm_start, vma->vm_end) != VM_ITREE_OK) {
         return -USMM_EINVAL;
     }
     
-    /* Find insertion point */
-    prev_vma = NULL;
-    for (next_vma = mm->mmap; next_vma; next_vma = next_vma->vm_next) {
-        if (vma->vm_start < next_vma->vm_start) {
-            break;
-        }
-        prev_vma = next_vma;
-    }
+    /* Link into the list next to its tree neighbours */
+    prev_vma = rb_to_vma(vm_itree_prev(&vma->vm_rb));
+    next_vma = prev_vma ? prev_vma->vm_next : mm->mmap;
     
     /* Insert into list */
     vma->vm_prev = prev_vma;
@@ -326,6 +313,18 @@ int insert_vm_area(mm_struct_t* mm, vm_area_struct_t* vma) {
     
     mm->map_count++;
     
+    return USMM_SUCCESS;
+}
+
+int insert_vm_area(mm_struct_t* mm, vm_area_struct_t* vma) {
+    if (!mm || !vma) {
+        return -USMM_EINVAL;
+    }
+    
+    if (vma_link(mm, vma) != USMM_SUCCESS) {
+        return -USMM_EINVAL;
+    }
+    
     /* Update accounting */
     uint64_t pages = (vma->vm_end - vma->vm_start) >> 12;
     atomic64_add(pages, &mm->total_vm);
@@ -348,7 +347,9 @@ int remove_vm_area(mm_struct_t* mm, vm_area_struct_t* vma) {
         return -USMM_EINVAL;
     }
     
-    /* Remove from list */
+    /* Remove from index and list */
+    vm_itree_remove(&mm->mm_rb, &vma->vm_rb);
+    
     if (vma->vm_prev) {
         vma->vm_prev->vm_next = vma->vm_next;
     } else {
@@ -383,6 +384,58 @@ int remove_vm_area(mm_struct_t* mm, vm_area_struct_t* vma) {
     return USMM_SUCCESS;
 }
 
+/* Move a linked VMA's bounds in place without reordering it. */
+static int vma_set_bounds(mm_struct_t* mm, vm_area_struct_t* vma, uint64_t start, uint64_t end) {
+    if (vm_itree_resize(&mm->mm_rb, &vma->vm_rb, start, end) != VM_ITREE_OK) {
+        return -USMM_EINVAL;
+    }
+    vma->vm_start = start;
+    vma->vm_end = end;
+    return USMM_SUCCESS;
+}
+
+int split_vma(mm_struct_t* mm, vm_area_struct_t* vma, uint64_t addr, int new_below) {
+    vm_area_struct_t* new_vma;
+    uint64_t old_start, old_end, old_pgoff;
+    
+    if (!mm || !vma || addr <= vma->vm_start || addr >= vma->vm_end || (addr & 0xFFF)) {
+        return -USMM_EINVAL;
+    }
+    
+    new_vma = kmem_cache_alloc(vma_cache, GFP_KERNEL);
+    if (!new_vma) {
+        return -USMM_ENOMEM;
+    }
+    
+    *new_vma = *vma;
+    old_start = vma->vm_start;
+    old_end = vma->vm_end;
+    old_pgoff = vma->vm_pgoff;
+    
+    /* Shrink the original first so the new half fits in the freed range */
+    if (new_below) {
+        vma_set_bounds(mm, vma, addr, old_end);
+        vma->vm_pgoff += (addr - old_start) >> 12;
+        new_vma->vm_start = old_start;
+        new_vma->vm_end = addr;
+    } else {
+        vma_set_bounds(mm, vma, old_start, addr);
+        new_vma->vm_start = addr;
+        new_vma->vm_end = old_end;
+        new_vma->vm_pgoff += (addr - old_start) >> 12;
+    }
+    
+    /* The two halves cover the same pages, so skip insert's accounting */
+    if (vma_link(mm, new_vma) != USMM_SUCCESS) {
+        vma_set_bounds(mm, vma, old_start, old_end);
+        vma->vm_pgoff = old_pgoff;
+        kmem_cache_free(vma_cache, new_vma);
+        return -USMM_ENOMEM;
+    }
+    
+    return USMM_SUCCESS;
+}
+
 /* ========================== Memory Mapping Implementation ========================== */
 
 void* sys_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) {
@@ -496,7 +549,7 @@ int sys_munmap(void* addr, size_t length) {
     end_addr = start_addr + length;
     
     /* Find and remove intersecting VMAs */
-    vma = find_vma(mm, start_addr);
+    vma = find_vma_intersection(mm, start_addr, end_addr);
     while (vma && vma->vm_start < end_addr) {
         next = vma->vm_next;
         
@@ -506,19 +559,15 @@ int sys_munmap(void* addr, size_t length) {
             kmem_cache_free(vma_cache, vma);
         } else if (vma->vm_start < start_addr && vma->vm_end > end_addr) {
             /* VMA spans the unmapped region - split into two */
-            vm_area_struct_t* new_vma = kmem_cache_alloc(vma_cache, GFP_KERNEL);
-            if (new_vma) {
-                *new_vma = *vma;
-                new_vma->vm_start = end_addr;
-                vma->vm_end = start_addr;
-                insert_vm_area(mm, new_vma);
+            if (split_vma(mm, vma, end_addr, 0) == USMM_SUCCESS) {
+                vma_set_bounds(mm, vma, vma->vm_start, start_addr);
             }
         } else if (vma->vm_start < start_addr) {
             /* Partial overlap - trim end */
-            vma->vm_end = start_addr;
+            vma_set_bounds(mm, vma, vma->vm_start, start_addr);
         } else if (vma->vm_end > end_addr) {
             /* Partial overlap - trim start */
-            vma->vm_start = end_addr;
+            vma_set_bounds(mm, vma, end_addr, vma->vm_end);
         }
         
         vma = next;
@@ -527,6 +576,60 @@ int sys_munmap(void* addr, size_t length) {
     return USMM_SUCCESS;
 }
 
+int sys_mprotect(void* addr, size_t length, int prot) {
+    struct process* current = get_current_process();
+    mm_struct_t* mm;
+    vm_area_struct_t* vma;
+    uint64_t start_addr, end_addr;
+    uint32_t new_flags;
+    
+    if (!current || !current->mm) {
+        return -USMM_EFAULT;
+    }
+    
+    mm = current->mm;
+    start_addr = (uint64_t)addr;
+    if (start_addr & 0xFFF) {
+        return -USMM_EINVAL;
+    }
+    end_addr = start_addr + ((length + 0xFFF) & ~0xFFF);
+    new_flags = prot_to_vm_flags(prot);
+    
+    /* Split the VMAs at the range edges, then retag everything in between */
+    vma = find_vma_intersection(mm, start_addr, end_addr);
+    if (!vma) {
+        return -USMM_ENOMEM;
+    }
+    if (vma->vm_start < start_addr) {
+        if (split_vma(mm, vma, start_addr, 0) != USMM_SUCCESS) {
+            return -USMM_ENOMEM;
+        }
+        vma = vma->vm_next;
+    }
+    
+    while (vma && vma->vm_start < end_addr) {
+        if (vma->vm_end > end_addr && split_vma(mm, vma, end_addr, 0) != USMM_SUCCESS) {
+            return -USMM_ENOMEM;
+        }
+        vma->vm_flags = (vma->vm_flags & ~(VM_READ | VM_WRITE | VM_EXEC)) | new_flags;
+        vma->vm_prot = prot;
+        vma = vma->vm_next;
+    }
+
+    /* Pages already faulted in carry their own permissions; PROT_NONE
+     * drops the user bit so any access from ring 3 faults */
+    if (current->address_space) {
+        uint32_t pte_flags = 0;
+        if (prot != PROT_NONE) pte_flags |= VMM_FLAG_USER | VMM_FLAG_READ;
+        if (prot & PROT_WRITE) pte_flags |= VMM_FLAG_WRITE;
+        if (prot & PROT_EXEC) pte_flags |= VMM_FLAG_EXEC;
+        vmm_protect_pages(current->address_space, start_addr, end_addr, pte_flags);
+    }
+
+    global_usmm_stats.mprotect_calls++;
+    return USMM_SUCCESS;
+}
+
 /* ========================== Protection and Utility Functions ========================== */
 
 uint32_t prot_to_vm_flags(int prot) {
@@ -565,7 +668,6 @@ uint64_t arch_get_unmapped_area(struct file* file, uint64_t addr, uint64_t len,
                                uint64_t pgoff, uint32_t flags) {
     struct process* current = get_current_process();
     mm_struct_t* mm;
-    vm_area_struct_t* vma;
     uint64_t start_addr;
     
     if (!current || !current->mm) {
@@ -583,20 +685,8 @@ uint64_t arch_get_unmapped_area(struct file* file, uint64_t addr, uint64_t len,
     addr = (addr + 0xFFF) & ~0xFFF;
     len = (len + 0xFFF) & ~0xFFF;
     
-    /* Find free area */
-    start_addr = addr;
-    for (vma = mm->mmap; vma; vma = vma->vm_next) {
-        if (start_addr + len <= vma->vm_start) {
-            /* Found a gap */
-            return start_addr;
-        }
-        if (start_addr < vma->vm_end) {
-            start_addr = vma->vm_end;
-        }
-    }
-    
-    /* Check if we have space at the end */
-    if (start_addr + len <= mm->task_size) {
+    /* Lowest gap at or above addr, found via the subtree gap augmentation */
+    if (vm_itree_find_gap(&mm->mm_rb, len, addr, mm->task_size, &start_addr)) {
         return start_addr;
     }
     
@@ -11,6 +11,8 @@
 
 /* Function declarations */
 static void debug_print(const char* format, ...);
+void* kmalloc(size_t size);
+void kfree(void* ptr);
 
 /* Global VFS state */
 static bool vfs_initialized = false;
@@ -26,22 +28,84 @@ static bool vfs_fd_used[VFS_MAX_OPEN_FILES];
 /* VFS statistics */
 static vfs_stats_t vfs_statistics = {0};
 
+/* Page cache shared by every mounted filesystem */
+static page_cache_t vfs_page_cache;
+
+/* Dentry cache: every cached name, hashed by (parent, name) */
+static dcache_t vfs_dcache;
+
 /* VFS locks (simple spinlocks for now) */
 static volatile int vfs_mount_lock = 0;
 static volatile int vfs_fd_lock = 0;
 static volatile int vfs_fs_lock = 0;
+static volatile int vfs_cache_lock = 0;
+static volatile int vfs_dcache_lock = 0;
 
 /* Helper macros */
 #define VFS_LOCK(lock) while (__sync_lock_test_and_set(&(lock), 1)) { /* spin */ }
 #define VFS_UNLOCK(lock) __sync_lock_release(&(lock))
+#define VFS_DENTRY(entry) ((vfs_dentry_t*)((char*)(entry) - offsetof(vfs_dentry_t, d_hash)))
 
 /* Forward declarations */
 static int vfs_create_root_dentry(void);
-static vfs_dentry_t* vfs_dentry_cache_lookup(vfs_dentry_t* parent, const char* name);
+static vfs_dentry_t* vfs_walk_component(vfs_dentry_t* parent, const char* name, uint32_t len);
+static void vfs_dentry_free_locked(vfs_dentry_t* dentry);
 static int vfs_add_mount(vfs_mount_t* mount);
 static void vfs_remove_mount(vfs_mount_t* mount);
 static char* vfs_strdup(const char* str);
 static void vfs_strfree(char* str);
+static ssize_t vfs_cache_error(int64_t result);
+
+/* Page cache memory */
+static void* vfs_cache_alloc_page(void* ctx) {
+    (void)ctx;
+    return kmalloc(PAGE_CACHE_SIZE);
+}
+
+static void vfs_cache_free_page(void* ctx, void* page) {
+    (void)ctx;
+    kfree(page);
+}
+
+static const page_cache_ops_t vfs_cache_ops = {
+    .alloc_page = vfs_cache_alloc_page,
+    .free_page = vfs_cache_free_page,
+    .alloc = kmalloc,
+    .free = kfree,
+};
+
+/* An unused dentry evicted from the cache: drop its inode and free it */
+static void vfs_dcache_evict(void* ctx, dcache_entry_t* entry) {
+    (void)ctx;
+    vfs_dentry_t* dentry = VFS_DENTRY(entry);
+    
+    /* Out of the parent's child list; the parent is still cached */
+    if (dentry->d_parent && dentry->d_parent != dentry) {
+        vfs_dentry_t** link = &dentry->d_parent->d_child;
+        while (*link && *link != dentry) {
+            link = &(*link)->d_sibling;
+        }
+        if (*link) {
+            *link = dentry->d_sibling;
+        }
+    }
+    
+    vfs_inode_t* inode = dentry->d_inode;
+    if (inode) {
+        if (inode->i_count > 1) {
+            inode->i_count--;
+        } else {
+            vfs_free_inode(inode);
+        }
+    }
+    kfree(dentry);
+}
+
+static const dcache_ops_t vfs_dcache_ops = {
+    .evict = vfs_dcache_evict,
+    .alloc = kmalloc,
+    .free = kfree,
+};
 
 /* ================================
  * VFS Core Functions
@@ -77,6 +141,15 @@ int vfs_init(void) {
     vfs_mount_lock = 0;
     vfs_fd_lock = 0;
     vfs_fs_lock = 0;
+    vfs_cache_lock = 0;
+    vfs_dcache_lock = 0;
+    
+    page_cache_init(&vfs_page_cache, &vfs_cache_ops, VFS_PAGE_CACHE_MAX_PAGES);
+    if (dcache_init(&vfs_dcache, &vfs_dcache_ops, DCACHE_DEFAULT_BUCKETS,
+                    VFS_DCACHE_MAX_UNUSED) != DCACHE_OK) {
+        debug_print("VFS: Failed to allocate the dentry cache\n");
+        return VFS_ERROR_NO_MEMORY;
+    }
     
     /* Create root dentry */
     if (vfs_create_root_dentry() != VFS_SUCCESS) {
@@ -110,6 +183,9 @@ void vfs_shutdown(void) {
     
     VFS_UNLOCK(vfs_fd_lock);
     
+    /* Write cached data back while the filesystems are still there */
+    vfs_sync();
+    
     /* Unmount all filesystems */
     VFS_LOCK(vfs_mount_lock);
     vfs_mount_t* mount = vfs_mounts;
@@ -125,6 +201,7 @@ void vfs_shutdown(void) {
         vfs_free_dentry(vfs_root_dentry);
         vfs_root_dentry = NULL;
     }
+    dcache_destroy(&vfs_dcache);
     
     vfs_initialized = false;
     debug_print("VFS: Virtual File System shutdown complete\n");
@@ -313,9 +390,20 @@ int vfs_umount(const char* dir_name) {
     /* Remove from mount list */
     vfs_remove_mount(mount);
     
-    /* Clean up mount point */
+    /* Clean up mount point; the mount held its lookup reference */
     if (mount->mnt_mountpoint) {
         mount->mnt_mountpoint->d_mounted = NULL;
+        if (mount->mnt_mountpoint != vfs_root_dentry) {
+            vfs_dput(mount->mnt_mountpoint);
+        }
+    }
+    
+    /* Write back and drop its cached pages before the inodes go away */
+    if (mount->mnt_sb) {
+        vfs_sync_fs(mount->mnt_sb);
+        VFS_LOCK(vfs_cache_lock);
+        page_cache_invalidate_owner(&vfs_page_cache, mount->mnt_sb);
+        VFS_UNLOCK(vfs_cache_lock);
     }
     
     /* Kill superblock */
@@ -394,13 +482,15 @@ int vfs_open(const char* path, uint32_t flags, uint32_t mode) {
     
     /* Check if it's a directory and O_DIRECTORY is required */
     if ((flags & VFS_O_DIRECTORY) && dentry->d_inode->i_mode != VFS_FILE_TYPE_DIRECTORY) {
+        vfs_dput(dentry);
         vfs_free_fd(fd);
         return VFS_ERROR_NOT_DIRECTORY;
     }
     
-    /* Allocate file structure */
+    /* Allocate file structure; it keeps the lookup's dentry reference */
     vfs_file_t* file = (vfs_file_t*)kmalloc(sizeof(vfs_file_t));
     if (!file) {
+        vfs_dput(dentry);
         vfs_free_fd(fd);
         return VFS_ERROR_NO_MEMORY;
     }
@@ -414,11 +504,13 @@ int vfs_open(const char* path, uint32_t flags, uint32_t mode) {
     file->f_mode = mode;
     file->f_pos = 0;
     file->f_count = 1;
+    page_cache_ra_init(&file->f_ra);
     
     /* Call filesystem-specific open */
     if (file->f_op && file->f_op->open) {
         int result = file->f_op->open(file->f_inode, file);
         if (result != VFS_SUCCESS) {
+            vfs_dput(dentry);
             kfree(file);
             vfs_free_fd(fd);
             return result;
@@ -453,12 +545,20 @@ int vfs_close(int fd) {
     
     vfs_file_t* file = vfs_fd_table[fd];
     
+    /* Other processes still hold this descriptor (vfs_retain) */
+    if (file->f_count > 1) {
+        file->f_count--;
+        VFS_UNLOCK(vfs_fd_lock);
+        return VFS_SUCCESS;
+    }
+    
     /* Call filesystem-specific release */
     if (file->f_op && file->f_op->release) {
         file->f_op->release(file->f_inode, file);
     }
     
     /* Free file structure */
+    vfs_dput(file->f_dentry);
     kfree(file);
     
     /* Clear descriptor table entry */
@@ -472,6 +572,28 @@ int vfs_close(int fd) {
     return VFS_SUCCESS;
 }
 
+/**
+ * Take another reference to an open descriptor, for a process inheriting
+ * it. Each holder closes it once; the file is released by the last close.
+ */
+int vfs_retain(int fd) {
+    if (!vfs_initialized || fd < 0 || fd >= VFS_MAX_OPEN_FILES) {
+        return VFS_ERROR_INVALID_PARAM;
+    }
+    
+    VFS_LOCK(vfs_fd_lock);
+    
+    vfs_file_t* file = vfs_fd_used[fd] ? vfs_fd_table[fd] : NULL;
+    if (!file) {
+        VFS_UNLOCK(vfs_fd_lock);
+        return VFS_ERROR_INVALID_PARAM;
+    }
+    file->f_count++;
+    
+    VFS_UNLOCK(vfs_fd_lock);
+    return VFS_SUCCESS;
+}
+
 /**
  * Read from a file
  */
@@ -490,12 +612,27 @@ ssize_t vfs_read(int fd, void* buffer, size_t count) {
         return VFS_ERROR_PERMISSION;
     }
     
-    /* Call filesystem-specific read */
-    if (!file->f_op || !file->f_op->read) {
-        return VFS_ERROR_NOT_SUPPORTED;
+    ssize_t result;
+    vfs_inode_t* inode = file->f_inode;
+    
+    if (inode && page_cache_mapping_cached(&inode->i_data)) {
+        /* Served from the page cache, filled from the filesystem on a miss
+         * and ahead of sequential readers */
+        VFS_LOCK(vfs_cache_lock);
+        result = vfs_cache_error(page_cache_read_ra(&inode->i_data, &file->f_ra, file->f_pos,
+                                                    buffer, count, inode->i_size));
+        VFS_UNLOCK(vfs_cache_lock);
+        if (result > 0) {
+            file->f_pos += result;
+        }
+    } else {
+        /* Call filesystem-specific read */
+        if (!file->f_op || !file->f_op->read) {
+            return VFS_ERROR_NOT_SUPPORTED;
+        }
+        result = file->f_op->read(file, (char*)buffer, count, &file->f_pos);
     }
     
-    ssize_t result = file->f_op->read(file, (char*)buffer, count, &file->f_pos);
     if (result > 0) {
         vfs_statistics.total_reads++;
         vfs_statistics.bytes_read += result;
@@ -522,12 +659,34 @@ ssize_t vfs_write(int fd, const void* buffer, size_t count) {
         return VFS_ERROR_PERMISSION;
     }
     
-    /* Call filesystem-specific write */
-    if (!file->f_op || !file->f_op->write) {
-        return VFS_ERROR_NOT_SUPPORTED;
+    ssize_t result;
+    vfs_inode_t* inode = file->f_inode;
+    
+    if (inode && page_cache_mapping_cached(&inode->i_data)) {
+        /* Into the page cache; the filesystem sees it at writeback */
+        VFS_LOCK(vfs_cache_lock);
+        result = vfs_cache_error(page_cache_write(&inode->i_data, file->f_pos, buffer,
+                                                  count, inode->i_size));
+        if (result > 0) {
+            file->f_pos += result;
+            if (file->f_pos > inode->i_size) {
+                inode->i_size = file->f_pos;
+            }
+        }
+        if (result > 0 && (file->f_flags & VFS_O_SYNC)) {
+            if (page_cache_writeback(&inode->i_data) != PAGE_CACHE_OK) {
+                result = VFS_ERROR_IO_ERROR;
+            }
+        }
+        VFS_UNLOCK(vfs_cache_lock);
+    } else {
+        /* Call filesystem-specific write */
+        if (!file->f_op || !file->f_op->write) {
+            return VFS_ERROR_NOT_SUPPORTED;
+        }
+        result = file->f_op->write(file, (const char*)buffer, count, &file->f_pos);
     }
     
-    ssize_t result = file->f_op->write(file, (const char*)buffer, count, &file->f_pos);
     if (result > 0) {
         vfs_statistics.total_writes++;
         vfs_statistics.bytes_written += result;
@@ -536,6 +695,274 @@ ssize_t vfs_write(int fd, const void* buffer, size_t count) {
     return result;
 }
 
+/**
+ * Read into each segment in turn, stopping at the first short read
+ */
+ssize_t vfs_readv(int fd, const vfs_iovec_t* iov, int iovcnt) {
+    if (!iov || iovcnt < 0 || iovcnt > VFS_MAX_IOV) {
+        return VFS_ERROR_INVALID_PARAM;
+    }
+
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len == 0) {
+            continue;
+        }
+        ssize_t result = vfs_read(fd, iov[i].iov_base, iov[i].iov_len);
+        if (result < 0) {
+            return total ? total : result;
+        }
+        total += result;
+        if ((size_t)result < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+/**
+ * Write each segment in turn, stopping at the first short write
+ */
+ssize_t vfs_writev(int fd, const vfs_iovec_t* iov, int iovcnt) {
+    if (!iov || iovcnt < 0 || iovcnt > VFS_MAX_IOV) {
+        return VFS_ERROR_INVALID_PARAM;
+    }
+
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len == 0) {
+            continue;
+        }
+        ssize_t result = vfs_write(fd, iov[i].iov_base, iov[i].iov_len);
+        if (result < 0) {
+            return total ? total : result;
+        }
+        total += result;
+        if ((size_t)result < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+/* The caller's actor, with its error kept apart from page cache errors */
+typedef struct vfs_actor_call {
+    page_cache_actor_t actor;
+    void* ctx;
+    int64_t error;
+} vfs_actor_call_t;
+
+/* Runs with vfs_cache_lock held and the page pinned: the actor may block
+ * (a socket send), so it runs with the lock dropped */
+static int64_t vfs_actor_trampoline(void* ctx, const void* data, size_t len) {
+    vfs_actor_call_t* call = (vfs_actor_call_t*)ctx;
+    VFS_UNLOCK(vfs_cache_lock);
+    int64_t used = call->actor(call->ctx, data, len);
+    VFS_LOCK(vfs_cache_lock);
+    if (used < 0) {
+        call->error = used;
+    }
+    return used;
+}
+
+/**
+ * Feed a file to an actor without copying it out of the page cache
+ */
+ssize_t vfs_read_actor(int fd, uint64_t* offset, size_t count, page_cache_actor_t actor, void* ctx) {
+    if (!vfs_initialized || fd < 0 || fd >= VFS_MAX_OPEN_FILES || !actor) {
+        return VFS_ERROR_INVALID_PARAM;
+    }
+
+    vfs_file_t* file = vfs_get_file(fd);
+    if (!file) {
+        return VFS_ERROR_INVALID_PARAM;
+    }
+    if (!(file->f_flags & (VFS_O_RDONLY | VFS_O_RDWR))) {
+        return VFS_ERROR_PERMISSION;
+    }
+
+    uint64_t* pos = offset ? offset : &file->f_pos;
+    vfs_inode_t* inode = file->f_inode;
+    ssize_t result;
+
+    if (inode && page_cache_mapping_cached(&inode->i_data)) {
+        /* An explicit offset does not disturb the file's readahead state */
+        vfs_actor_call_t call = { actor, ctx, 0 };
+        VFS_LOCK(vfs_cache_lock);
+        int64_t n = page_cache_read_actor(&inode->i_data, offset ? NULL : &file->f_ra, *pos,
+                                          count, inode->i_size, vfs_actor_trampoline, &call);
+        VFS_UNLOCK(vfs_cache_lock);
+        result = (n < 0 && call.error) ? (ssize_t)call.error : vfs_cache_error(n);
+        if (result > 0) {
+            *pos += result;
+        }
+    } else {
+        if (!file->f_op || !file->f_op->read) {
+            return VFS_ERROR_NOT_SUPPORTED;
+        }
+        char* bounce = (char*)kmalloc(PAGE_CACHE_SIZE);
+        if (!bounce) {
+            return VFS_ERROR_NO_MEMORY;
+        }
+
+        result = 0;
+        while ((size_t)result < count) {
+            size_t chunk = count - (size_t)result;
+            if (chunk > PAGE_CACHE_SIZE) {
+                chunk = PAGE_CACHE_SIZE;
+            }
+            uint64_t at = *pos;
+            ssize_t got = file->f_op->read(file, bounce, chunk, &at);
+            if (got <= 0) {
+                if (result == 0) {
+                    result = got;
+                }
+                break;
+            }
+            int64_t used = actor(ctx, bounce, (size_t)got);
+            if (used < 0) {
+                if (result == 0) {
+                    result = (ssize_t)used;
+                }
+                break;
+            }
+            /* Only what the actor took counts as read */
+            *pos += (uint64_t)used;
+            result += used;
+            if (used < got || (size_t)got < chunk) {
+                break;
+            }
+        }
+        kfree(bounce);
+    }
+
+    if (result > 0) {
+        vfs_statistics.total_reads++;
+        vfs_statistics.bytes_read += result;
+    }
+
+    return result;
+}
+
+/**
+ * Write a file's cached data back to its filesystem
+ */
+int vfs_fsync(int fd) {
+    if (!vfs_initialized) {
+        return VFS_ERROR_INVALID_PARAM;
+    }
+    
+    vfs_file_t* file = vfs_get_file(fd);
+    if (!file) {
+        return VFS_ERROR_INVALID_PARAM;
+    }
+    
+    if (file->f_inode) {
+        VFS_LOCK(vfs_cache_lock);
+        int result = page_cache_writeback(&file->f_inode->i_data);
+        VFS_UNLOCK(vfs_cache_lock);
+        if (result != PAGE_CACHE_OK) {
+            return VFS_ERROR_IO_ERROR;
+        }
+    }
+    
+    if (file->f_op && file->f_op->fsync) {
+        return file->f_op->fsync(file);
+    }
+    return VFS_SUCCESS;
+}
+
+/* ================================
+ * Page Cache
+ * ================================ */
+
+/**
+ * Serve a regular file's reads and writes from the page cache
+ */
+void vfs_inode_set_aops(vfs_inode_t* inode, const page_cache_aops_t* aops) {
+    if (!inode || inode->i_mode != VFS_FILE_TYPE_REGULAR) {
+        return;
+    }
+    inode->i_data.aops = aops;
+}
+
+/**
+ * Write back a filesystem's dirty pages, then its own metadata
+ */
+int vfs_sync_fs(vfs_superblock_t* sb) {
+    if (!sb) {
+        return VFS_ERROR_INVALID_PARAM;
+    }
+    
+    VFS_LOCK(vfs_cache_lock);
+    int result = page_cache_sync(&vfs_page_cache, sb);
+    VFS_UNLOCK(vfs_cache_lock);
+    
+    int fs_result = VFS_SUCCESS;
+    if (sb->s_op && sb->s_op->sync_fs) {
+        fs_result = sb->s_op->sync_fs(sb);
+    }
+    
+    if (result != PAGE_CACHE_OK) {
+        return VFS_ERROR_IO_ERROR;
+    }
+    return fs_result;
+}
+
+/**
+ * Sync every mounted filesystem
+ */
+int vfs_sync(void) {
+    int result = VFS_SUCCESS;
+    
+    VFS_LOCK(vfs_mount_lock);
+    for (vfs_mount_t* mount = vfs_mounts; mount; mount = mount->mnt_next) {
+        if (mount->mnt_sb && vfs_sync_fs(mount->mnt_sb) != VFS_SUCCESS) {
+            result = VFS_ERROR_IO_ERROR;
+        }
+    }
+    VFS_UNLOCK(vfs_mount_lock);
+    
+    return result;
+}
+
+/**
+ * Give cached pages back under memory pressure (called by reclaim)
+ */
+uint32_t vfs_page_cache_shrink(uint32_t nr_pages) {
+    if (!vfs_initialized) {
+        return 0;
+    }
+    
+    VFS_LOCK(vfs_cache_lock);
+    uint32_t freed = page_cache_shrink(&vfs_page_cache, nr_pages);
+    VFS_UNLOCK(vfs_cache_lock);
+    return freed;
+}
+
+void vfs_get_page_cache_stats(page_cache_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    
+    VFS_LOCK(vfs_cache_lock);
+    page_cache_get_stats(&vfs_page_cache, stats);
+    VFS_UNLOCK(vfs_cache_lock);
+}
+
+static ssize_t vfs_cache_error(int64_t result) {
+    switch (result) {
+        case PAGE_CACHE_ENOMEM:
+            return VFS_ERROR_NO_MEMORY;
+        case PAGE_CACHE_EIO:
+            return VFS_ERROR_IO_ERROR;
+        case PAGE_CACHE_ENOSPC:
+            return VFS_ERROR_NO_SPACE;
+        default:
+            return (ssize_t)result;
+    }
+}
+
 /* ================================
  * Helper Functions
  * ================================ */
@@ -610,9 +1037,13 @@ static void debug_print(const char* format, ...) {
  * ================================ */
 
 /**
- * Lookup a path and return the dentry
+ * Lookup a path and return the dentry, with a reference the caller drops
+ * with vfs_dput(). Components are matched in place in `path`; each one is
+ * a hash probe of the dentry cache, and only a name the cache has never
+ * seen reaches the filesystem.
  */
 vfs_dentry_t* vfs_path_lookup(const char* path, uint32_t flags) {
+    (void)flags;
     if (!vfs_initialized || !path) {
         return NULL;
     }
@@ -624,43 +1055,146 @@ vfs_dentry_t* vfs_path_lookup(const char* path, uint32_t flags) {
     if (!current) {
         return NULL;
     }
+    VFS_LOCK(vfs_dcache_lock);
+    dcache_get(&vfs_dcache, &current->d_hash);
+    VFS_UNLOCK(vfs_dcache_lock);
+    
+    const char* p = path;
+    for (;;) {
+        /* Step onto a filesystem mounted here */
+        vfs_mount_t* mount = current->d_mounted;
+        if (mount && mount->mnt_root && mount->mnt_root != current) {
+            vfs_dentry_t* root = mount->mnt_root;
+            VFS_LOCK(vfs_dcache_lock);
+            dcache_get(&vfs_dcache, &root->d_hash);
+            dcache_put(&vfs_dcache, &current->d_hash);
+            VFS_UNLOCK(vfs_dcache_lock);
+            current = root;
+            continue;
+        }
+        
+        while (*p == '/') {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        
+        const char* name = p;
+        while (*p != '\0' && *p != '/') {
+            p++;
+        }
+        uint32_t len = (uint32_t)(p - name);
+        
+        if (len == 1 && name[0] == '.') {
+            continue;
+        }
+        
+        vfs_dentry_t* next;
+        if (len == 2 && name[0] == '.' && name[1] == '.') {
+            next = current->d_parent ? current->d_parent : current;
+            VFS_LOCK(vfs_dcache_lock);
+            dcache_get(&vfs_dcache, &next->d_hash);
+            VFS_UNLOCK(vfs_dcache_lock);
+        } else if (len >= VFS_MAX_FILENAME_LENGTH) {
+            next = NULL;
+        } else {
+            next = vfs_walk_component(current, name, len);
+        }
+        
+        vfs_dput(current);
+        if (!next) {
+            debug_print("VFS: Path component of '%s' not found\n", path);
+            return NULL;
+        }
+        current = next;
+    }
     
-    /* Handle absolute path */
-    if (path[0] == '/') {
-        path++; /* Skip leading slash */
+    return current;
+}
+
+/**
+ * Child `name` (len bytes, not terminated) of `parent`, with a reference,
+ * or NULL if it does not exist. A miss asks the filesystem and caches the
+ * answer either way.
+ */
+static vfs_dentry_t* vfs_walk_component(vfs_dentry_t* parent, const char* name, uint32_t len) {
+    uint32_t hash = dcache_hash(&parent->d_hash, name, len);
+    
+    VFS_LOCK(vfs_dcache_lock);
+    dcache_entry_t* entry = dcache_lookup(&vfs_dcache, &parent->d_hash, name, len, hash);
+    if (entry && entry->negative) {
+        dcache_put(&vfs_dcache, entry);
+        VFS_UNLOCK(vfs_dcache_lock);
+        return NULL;
+    }
+    VFS_UNLOCK(vfs_dcache_lock);
+    if (entry) {
+        return VFS_DENTRY(entry);
     }
     
-    /* If path is just "/", return root */
-    if (path[0] == '\0') {
-        return current;
+    vfs_inode_t* dir = parent->d_inode;
+    if (!dir || !dir->i_op || !dir->i_op->lookup) {
+        return NULL;
     }
     
-    /* Parse path components */
-    char path_copy[VFS_MAX_PATH];
-    strncpy(path_copy, path, sizeof(path_copy) - 1);
-    path_copy[sizeof(path_copy) - 1] = '\0';
+    /* The filesystem looks the name up with the cache unlocked */
+    vfs_dentry_t* dentry = vfs_alloc_dentry(NULL);
+    if (!dentry) {
+        return NULL;
+    }
+    memcpy(dentry->d_name, name, len);
+    dentry->d_name[len] = '\0';
+    dentry->d_hash.len = len;
+    dentry->d_parent = parent;
     
-    char* token = strtok(path_copy, "/");
-    while (token) {
-        /* Look for child dentry */
-        vfs_dentry_t* child = vfs_dentry_cache_lookup(current, token);
-        if (!child) {
-            /* Try to create dentry via filesystem */
-            if (current->d_inode && current->d_inode->i_op && current->d_inode->i_op->lookup) {
-                child = current->d_inode->i_op->lookup(current->d_inode, token);
-            }
-            
-            if (!child) {
-                debug_print("VFS: Path component '%s' not found\n", token);
-                return NULL;
-            }
+    vfs_dentry_t* found = dir->i_op->lookup(dir, dentry);
+    if (found && found != dentry) {
+        /* The filesystem built its own dentry: keep its inode only */
+        dentry->d_inode = found->d_inode;
+        found->d_inode = NULL;
+        vfs_free_dentry(found);
+    }
+    
+    VFS_LOCK(vfs_dcache_lock);
+    
+    /* Someone else may have cached the name meanwhile */
+    entry = dcache_lookup(&vfs_dcache, &parent->d_hash, name, len, hash);
+    if (entry) {
+        VFS_UNLOCK(vfs_dcache_lock);
+        if (dentry->d_inode) {
+            vfs_free_inode(dentry->d_inode);
         }
-        
-        current = child;
-        token = strtok(NULL, "/");
+        kfree(dentry);
+        VFS_LOCK(vfs_dcache_lock);
+    } else {
+        dentry->d_sibling = parent->d_child;
+        parent->d_child = dentry;
+        dcache_add(&vfs_dcache, &parent->d_hash, &dentry->d_hash, hash, dentry->d_inode == NULL);
+        entry = &dentry->d_hash;
     }
     
-    return current;
+    if (entry->negative) {
+        dcache_put(&vfs_dcache, entry);
+        entry = NULL;
+    }
+    VFS_UNLOCK(vfs_dcache_lock);
+    return entry ? VFS_DENTRY(entry) : NULL;
+}
+
+/**
+ * Lookup one name under a directory; the dentry comes with a reference
+ */
+vfs_dentry_t* vfs_dentry_lookup(vfs_dentry_t* parent, const char* name) {
+    if (!vfs_initialized || !parent || !name) {
+        return NULL;
+    }
+    
+    size_t len = strlen(name);
+    if (len == 0 || len >= VFS_MAX_FILENAME_LENGTH) {
+        return NULL;
+    }
+    return vfs_walk_component(parent, name, (uint32_t)len);
 }
 
 /* ================================
@@ -688,62 +1222,105 @@ vfs_dentry_t* vfs_alloc_dentry(const char* name) {
     dentry->d_inode = NULL;
     dentry->d_parent = NULL;
     dentry->d_mounted = NULL;
-    dentry->d_subdirs = NULL;
-    dentry->d_next = NULL;
+    dentry->d_child = NULL;
+    dentry->d_sibling = NULL;
+    dcache_entry_init(&dentry->d_hash, dentry->d_name, (uint32_t)strlen(dentry->d_name));
     
     return dentry;
 }
 
 /**
- * Free a dentry
+ * Free a dentry and its cached children
  */
 void vfs_free_dentry(vfs_dentry_t* dentry) {
     if (!dentry) {
         return;
     }
     
+    VFS_LOCK(vfs_dcache_lock);
+    vfs_dentry_free_locked(dentry);
+    VFS_UNLOCK(vfs_dcache_lock);
+}
+
+static void vfs_dentry_free_locked(vfs_dentry_t* dentry) {
     /* Free child dentries */
-    vfs_dentry_t* child = dentry->d_subdirs;
-    while (child) {
-        vfs_dentry_t* next = child->d_next;
-        vfs_free_dentry(child);
-        child = next;
+    while (dentry->d_child) {
+        vfs_dentry_t* child = dentry->d_child;
+        dentry->d_child = child->d_sibling;
+        child->d_parent = NULL;
+        vfs_dentry_free_locked(child);
+    }
+    
+    /* Out of the parent's list and the cache */
+    vfs_dentry_t* parent = dentry->d_parent;
+    if (parent && parent != dentry) {
+        vfs_dentry_t** link = &parent->d_child;
+        while (*link && *link != dentry) {
+            link = &(*link)->d_sibling;
+        }
+        if (*link) {
+            *link = dentry->d_sibling;
+        }
     }
+    dcache_remove(&vfs_dcache, &dentry->d_hash);
     
     /* Free the dentry itself */
     kfree(dentry);
 }
 
 /**
- * Add a child dentry
+ * Add a child dentry; it is cached under the parent, negative when it has
+ * no inode
  */
 void vfs_dentry_add_child(vfs_dentry_t* parent, vfs_dentry_t* child) {
     if (!parent || !child) {
         return;
     }
     
+    VFS_LOCK(vfs_dcache_lock);
     child->d_parent = parent;
-    child->d_next = parent->d_subdirs;
-    parent->d_subdirs = child;
+    child->d_sibling = parent->d_child;
+    parent->d_child = child;
+    uint32_t hash = dcache_hash(&parent->d_hash, child->d_name, child->d_hash.len);
+    dcache_add(&vfs_dcache, &parent->d_hash, &child->d_hash, hash, child->d_inode == NULL);
+    VFS_UNLOCK(vfs_dcache_lock);
 }
 
 /**
- * Simple dentry cache lookup
+ * Drop a dentry reference; unused dentries stay cached until evicted
  */
-static vfs_dentry_t* vfs_dentry_cache_lookup(vfs_dentry_t* parent, const char* name) {
-    if (!parent || !name) {
-        return NULL;
+void vfs_dput(vfs_dentry_t* dentry) {
+    if (!dentry) {
+        return;
     }
     
-    vfs_dentry_t* child = parent->d_subdirs;
-    while (child) {
-        if (strcmp(child->d_name, name) == 0) {
-            return child;
-        }
-        child = child->d_next;
+    VFS_LOCK(vfs_dcache_lock);
+    dcache_put(&vfs_dcache, &dentry->d_hash);
+    VFS_UNLOCK(vfs_dcache_lock);
+}
+
+/**
+ * Evict unused dentries (called by reclaim)
+ */
+uint32_t vfs_dcache_shrink(uint32_t nr_dentries) {
+    if (!vfs_initialized) {
+        return 0;
     }
     
-    return NULL;
+    VFS_LOCK(vfs_dcache_lock);
+    uint32_t evicted = dcache_shrink(&vfs_dcache, nr_dentries);
+    VFS_UNLOCK(vfs_dcache_lock);
+    return evicted;
+}
+
+void vfs_get_dcache_stats(dcache_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    
+    VFS_LOCK(vfs_dcache_lock);
+    *stats = vfs_dcache.stats;
+    VFS_UNLOCK(vfs_dcache_lock);
 }
 
 /* ================================
@@ -775,6 +1352,7 @@ vfs_inode_t* vfs_alloc_inode(vfs_superblock_t* sb) {
     inode->i_op = NULL;
     inode->i_fop = NULL;
     inode->i_private = NULL;
+    page_cache_mapping_init(&inode->i_data, &vfs_page_cache, NULL, inode, sb);
     
     /* Set timestamps to current time (placeholder) */
     inode->i_atime = 0;
@@ -792,6 +1370,14 @@ void vfs_free_inode(vfs_inode_t* inode) {
         return;
     }
     
+    /* Cached data goes back to the filesystem before the inode goes */
+    if (inode->i_data.cache) {
+        VFS_LOCK(vfs_cache_lock);
+        page_cache_writeback(&inode->i_data);
+        page_cache_mapping_release(&inode->i_data);
+        VFS_UNLOCK(vfs_cache_lock);
+    }
+    
     /* Call filesystem-specific cleanup */
     if (inode->i_sb && inode->i_sb->s_op && inode->i_sb->s_op->destroy_inode) {
         inode->i_sb->s_op->destroy_inode(inode);
@@ -0,0 +1,556 @@
+/* IKOS Virtual Memory - Augmented interval tree for address-space lookup
+ *
+ * See include/vm_interval_tree.h. A parent-linked red-black tree with NULL
+ * leaves. The augmentation (subtree_gap) is kept exact by recomputing the two
+ * nodes touched by every rotation and by propagating to the root from each
+ * node whose own gap or position changed; both are O(log n).
+ */
+
+#include "vm_interval_tree.h"
+
+#define VM_ITREE_RED    0
+#define VM_ITREE_BLACK  1
+
+static inline bool is_red(const vm_itree_node_t* n) {
+    return n && n->color == VM_ITREE_RED;
+}
+
+static inline uint64_t max_u64(uint64_t a, uint64_t b) {
+    return a > b ? a : b;
+}
+
+static inline uint64_t min_u64(uint64_t a, uint64_t b) {
+    return a < b ? a : b;
+}
+
+/* ========================== Augmentation ========================== */
+
+static void recalc(vm_itree_node_t* n) {
+    uint64_t g = n->gap;
+    if (n->left) {
+        g = max_u64(g, n->left->subtree_gap);
+    }
+    if (n->right) {
+        g = max_u64(g, n->right->subtree_gap);
+    }
+    n->subtree_gap = g;
+}
+
+static void propagate(vm_itree_node_t* n) {
+    while (n) {
+        recalc(n);
+        n = n->parent;
+    }
+}
+
+/* Recompute n->gap from its in-order predecessor (or the tree's low bound). */
+static void refresh_gap(const vm_itree_t* tree, vm_itree_node_t* n) {
+    vm_itree_node_t* prev = vm_itree_prev(n);
+    uint64_t base = prev ? prev->end : tree->low;
+    n->gap = n->start > base ? n->start - base : 0;
+}
+
+/* ========================== Rotations ========================== */
+
+static void replace_child(vm_itree_t* tree, vm_itree_node_t* parent,
+                          vm_itree_node_t* old, vm_itree_node_t* new_node) {
+    if (!parent) {
+        tree->root = new_node;
+    } else if (parent->left == old) {
+        parent->left = new_node;
+    } else {
+        parent->right = new_node;
+    }
+}
+
+static void rotate_left(vm_itree_t* tree, vm_itree_node_t* x) {
+    vm_itree_node_t* y = x->right;
+    x->right = y->left;
+    if (y->left) {
+        y->left->parent = x;
+    }
+    y->parent = x->parent;
+    replace_child(tree, x->parent, x, y);
+    y->left = x;
+    x->parent = y;
+    recalc(x);
+    recalc(y);
+}
+
+static void rotate_right(vm_itree_t* tree, vm_itree_node_t* x) {
+    vm_itree_node_t* y = x->left;
+    x->left = y->right;
+    if (y->right) {
+        y->right->parent = x;
+    }
+    y->parent = x->parent;
+    replace_child(tree, x->parent, x, y);
+    y->right = x;
+    x->parent = y;
+    recalc(x);
+    recalc(y);
+}
+
+/* ========================== Navigation ========================== */
+
+static vm_itree_node_t* subtree_min(vm_itree_node_t* n) {
+    while (n && n->left) {
+        n = n->left;
+    }
+    return n;
+}
+
+static vm_itree_node_t* subtree_max(vm_itree_node_t* n) {
+    while (n && n->right) {
+        n = n->right;
+    }
+    return n;
+}
+
+vm_itree_node_t* vm_itree_first(const vm_itree_t* tree) {
+    return tree ? subtree_min(tree->root) : NULL;
+}
+
+vm_itree_node_t* vm_itree_last(const vm_itree_t* tree) {
+    return tree ? subtree_max(tree->root) : NULL;
+}
+
+vm_itree_node_t* vm_itree_next(const vm_itree_node_t* node) {
+    if (!node) {
+        return NULL;
+    }
+    if (node->right) {
+        return subtree_min(node->right);
+    }
+    const vm_itree_node_t* n = node;
+    vm_itree_node_t* p = n->parent;
+    while (p && n == p->right) {
+        n = p;
+        p = p->parent;
+    }
+    return p;
+}
+
+vm_itree_node_t* vm_itree_prev(const vm_itree_node_t* node) {
+    if (!node) {
+        return NULL;
+    }
+    if (node->left) {
+        return subtree_max(node->left);
+    }
+    const vm_itree_node_t* n = node;
+    vm_itree_node_t* p = n->parent;
+    while (p && n == p->left) {
+        n = p;
+        p = p->parent;
+    }
+    return p;
+}
+
+/* ========================== Lookup ========================== */
+
+void vm_itree_init(vm_itree_t* tree, uint64_t low, uint64_t high) {
+    if (!tree) {
+        return;
+    }
+    tree->root = NULL;
+    tree->low = low;
+    tree->high = high;
+    tree->count = 0;
+}
+
+vm_itree_node_t* vm_itree_lower_bound(const vm_itree_t* tree, uint64_t addr) {
+    if (!tree) {
+        return NULL;
+    }
+    vm_itree_node_t* n = tree->root;
+    vm_itree_node_t* best = NULL;
+    while (n) {
+        if (addr < n->end) {
+            best = n;
+            if (addr >= n->start) {
+                break;
+            }
+            n = n->left;
+        } else {
+            n = n->right;
+        }
+    }
+    return best;
+}
+
+vm_itree_node_t* vm_itree_find(const vm_itree_t* tree, uint64_t addr) {
+    vm_itree_node_t* n = vm_itree_lower_bound(tree, addr);
+    return (n && addr >= n->start) ? n : NULL;
+}
+
+vm_itree_node_t* vm_itree_first_overlap(const vm_itree_t* tree,
+                                        uint64_t start, uint64_t end) {
+    if (start >= end) {
+        return NULL;
+    }
+    vm_itree_node_t* n = vm_itree_lower_bound(tree, start);
+    return (n && n->start < end) ? n : NULL;
+}
+
+/* ========================== Insertion ========================== */
+
+static void insert_fixup(vm_itree_t* tree, vm_itree_node_t* z) {
+    while (is_red(z->parent)) {
+        vm_itree_node_t* p = z->parent;
+        vm_itree_node_t* g = p->parent;
+        if (p == g->left) {
+            vm_itree_node_t* u = g->right;
+            if (is_red(u)) {
+                p->color = VM_ITREE_BLACK;
+                u->color = VM_ITREE_BLACK;
+                g->color = VM_ITREE_RED;
+                z = g;
+                continue;
+            }
+            if (z == p->right) {
+                rotate_left(tree, p);
+                z = p;
+                p = z->parent;
+            }
+            p->color = VM_ITREE_BLACK;
+            g->color = VM_ITREE_RED;
+            rotate_right(tree, g);
+        } else {
+            vm_itree_node_t* u = g->left;
+            if (is_red(u)) {
+                p->color = VM_ITREE_BLACK;
+                u->color = VM_ITREE_BLACK;
+                g->color = VM_ITREE_RED;
+                z = g;
+                continue;
+            }
+            if (z == p->left) {
+                rotate_right(tree, p);
+                z = p;
+                p = z->parent;
+            }
+            p->color = VM_ITREE_BLACK;
+            g->color = VM_ITREE_RED;
+            rotate_left(tree, g);
+        }
+    }
+    tree->root->color = VM_ITREE_BLACK;
+}
+
+int vm_itree_insert(vm_itree_t* tree, vm_itree_node_t* node,
+                    uint64_t start, uint64_t end) {
+    if (!tree || !node || start >= end) {
+        return VM_ITREE_EINVAL;
+    }
+
+    /* Descend to the leaf position, remembering the in-order neighbours. */
+    vm_itree_node_t* parent = NULL;
+    vm_itree_node_t* pred = NULL;
+    vm_itree_node_t* succ = NULL;
+    vm_itree_node_t* n = tree->root;
+    while (n) {
+        parent = n;
+        if (start < n->start) {
+            succ = n;
+            n = n->left;
+        } else {
+            pred = n;
+            n = n->right;
+        }
+    }
+    if ((pred && pred->end > start) || (succ && succ->start < end)) {
+        return VM_ITREE_EOVERLAP;
+    }
+
+    node->start = start;
+    node->end = end;
+    node->left = NULL;
+    node->right = NULL;
+    node->parent = parent;
+    node->color = VM_ITREE_RED;
+    uint64_t base = pred ? pred->end : tree->low;
+    node->gap = start > base ? start - base : 0;
+    node->subtree_gap = node->gap;
+
+    if (!parent) {
+        tree->root = node;
+    } else if (start < parent->start) {
+        parent->left = node;
+    } else {
+        parent->right = node;
+    }
+
+    /* The successor's gap now starts at our end. */
+    propagate(node);
+    if (succ) {
+        succ->gap = succ->start - end;
+        propagate(succ);
+    }
+
+    insert_fixup(tree, node);
+    tree->count++;
+    return VM_ITREE_OK;
+}
+
+/* ========================== Removal ========================== */
+
+static void transplant(vm_itree_t* tree, vm_itree_node_t* u, vm_itree_node_t* v) {
+    replace_child(tree, u->parent, u, v);
+    if (v) {
+        v->parent = u->parent;
+    }
+}
+
+static void remove_fixup(vm_itree_t* tree, vm_itree_node_t* x, vm_itree_node_t* parent) {
+    while (x != tree->root && !is_red(x)) {
+        if (x == parent->left) {
+            vm_itree_node_t* w = parent->right;
+            if (is_red(w)) {
+                w->color = VM_ITREE_BLACK;
+                parent->color = VM_ITREE_RED;
+                rotate_left(tree, parent);
+                w = parent->right;
+            }
+            if (!is_red(w->left) && !is_red(w->right)) {
+                w->color = VM_ITREE_RED;
+                x = parent;
+                parent = x->parent;
+                continue;
+            }
+            if (!is_red(w->right)) {
+                w->left->color = VM_ITREE_BLACK;
+                w->color = VM_ITREE_RED;
+                rotate_right(tree, w);
+                w = parent->right;
+            }
+            w->color = parent->color;
+            parent->color = VM_ITREE_BLACK;
+            if (w->right) {
+                w->right->color = VM_ITREE_BLACK;
+            }
+            rotate_left(tree, parent);
+            x = tree->root;
+            break;
+        } else {
+            vm_itree_node_t* w = parent->left;
+            if (is_red(w)) {
+                w->color = VM_ITREE_BLACK;
+                parent->color = VM_ITREE_RED;
+                rotate_right(tree, parent);
+                w = parent->left;
+            }
+            if (!is_red(w->left) && !is_red(w->right)) {
+                w->color = VM_ITREE_RED;
+                x = parent;
+                parent = x->parent;
+                continue;
+            }
+            if (!is_red(w->left)) {
+                w->right->color = VM_ITREE_BLACK;
+                w->color = VM_ITREE_RED;
+                rotate_left(tree, w);
+                w = parent->left;
+            }
+            w->color = parent->color;
+            parent->color = VM_ITREE_BLACK;
+            if (w->left) {
+                w->left->color = VM_ITREE_BLACK;
+            }
+            rotate_right(tree, parent);
+            x = tree->root;
+            break;
+        }
+    }
+    if (x) {
+        x->color = VM_ITREE_BLACK;
+    }
+}
+
+void vm_itree_remove(vm_itree_t* tree, vm_itree_node_t* z) {
+    if (!tree || !z) {
+        return;
+    }
+
+    vm_itree_node_t* pred = vm_itree_prev(z);
+    vm_itree_node_t* succ = vm_itree_next(z);
+
+    vm_itree_node_t* x;
+    vm_itree_node_t* x_parent;
+    uint8_t removed_color = z->color;
+
+    if (!z->left) {
+        x = z->right;
+        x_parent = z->parent;
+        transplant(tree, z, z->right);
+    } else if (!z->right) {
+        x = z->left;
+        x_parent = z->parent;
+        transplant(tree, z, z->left);
+    } else {
+        /* Two children: splice out the successor and put it in z's place. */
+        vm_itree_node_t* y = succ;
+        removed_color = y->color;
+        x = y->right;
+        if (y->parent == z) {
+            x_parent = y;
+        } else {
+            x_parent = y->parent;
+            transplant(tree, y, y->right);
+            y->right = z->right;
+            y->right->parent = y;
+        }
+        transplant(tree, z, y);
+        y->left = z->left;
+        y->left->parent = y;
+        y->color = z->color;
+    }
+
+    /* The successor's gap now extends back to the predecessor's end. */
+    if (succ) {
+        uint64_t base = pred ? pred->end : tree->low;
+        succ->gap = succ->start > base ? succ->start - base : 0;
+    }
+    propagate(x_parent);
+    propagate(succ);
+
+    if (removed_color == VM_ITREE_BLACK) {
+        remove_fixup(tree, x, x_parent);
+    }
+
+    z->parent = z->left = z->right = NULL;
+    tree->count--;
+}
+
+int vm_itree_resize(vm_itree_t* tree, vm_itree_node_t* node,
+                    uint64_t start, uint64_t end) {
+    if (!tree || !node || start >= end) {
+        return VM_ITREE_EINVAL;
+    }
+    vm_itree_node_t* pred = vm_itree_prev(node);
+    vm_itree_node_t* succ = vm_itree_next(node);
+    if ((pred && pred->end > start) || (succ && succ->start < end)) {
+        return VM_ITREE_EOVERLAP;
+    }
+
+    /* Neighbours bound the new interval, so the key order is unchanged and
+     * only this node's gap and its successor's gap move. */
+    node->start = start;
+    node->end = end;
+    refresh_gap(tree, node);
+    propagate(node);
+    if (succ) {
+        succ->gap = succ->start - end;
+        propagate(succ);
+    }
+    return VM_ITREE_OK;
+}
+
+/* ========================== Gap search ========================== */
+
+static bool gap_search(const vm_itree_node_t* n, uint64_t len,
+                       uint64_t floor, uint64_t ceiling, uint64_t* out) {
+    if (!n || n->subtree_gap < len) {
+        return false;
+    }
+
+    /* Gaps in the left subtree end at or before n->start; they can only be
+     * usable if n->start is above the floor. */
+    if (n->start > floor && gap_search(n->left, len, floor, ceiling, out)) {
+        return true;
+    }
+
+    uint64_t lo = max_u64(n->start - n->gap, floor);
+    uint64_t hi = min_u64(n->start, ceiling);
+    if (hi > lo && hi - lo >= len) {
+        *out = lo;
+        return true;
+    }
+
+    /* Gaps in the right subtree begin at or after n->end. */
+    if (n->end >= ceiling) {
+        return false;
+    }
+    return gap_search(n->right, len, floor, ceiling, out);
+}
+
+bool vm_itree_find_gap(const vm_itree_t* tree, uint64_t len,
+                       uint64_t floor, uint64_t ceiling, uint64_t* out) {
+    if (!tree || !out || len == 0) {
+        return false;
+    }
+    floor = max_u64(floor, tree->low);
+    ceiling = min_u64(ceiling, tree->high);
+    if (floor >= ceiling || ceiling - floor < len) {
+        return false;
+    }
+
+    if (gap_search(tree->root, len, floor, ceiling, out)) {
+        return true;
+    }
+
+    /* Trailing gap above the last interval. */
+    vm_itree_node_t* last = vm_itree_last(tree);
+    uint64_t lo = last ? max_u64(last->end, floor) : floor;
+    if (lo < ceiling && ceiling - lo >= len) {
+        *out = lo;
+        return true;
+    }
+    return false;
+}
+
+/* ========================== Validation ========================== */
+
+/* Returns the black height of the subtree, or -1 on any violation. */
+static int validate_subtree(const vm_itree_node_t* n, const vm_itree_node_t* parent) {
+    if (!n) {
+        return 1;
+    }
+    if (n->parent != parent || n->start >= n->end) {
+        return -1;
+    }
+    if (is_red(n) && (is_red(n->left) || is_red(n->right))) {
+        return -1;
+    }
+    if ((n->left && n->left->end > n->start) ||
+        (n->right && n->right->start < n->end)) {
+        return -1;
+    }
+    uint64_t g = n->gap;
+    if (n->left) g = max_u64(g, n->left->subtree_gap);
+    if (n->right) g = max_u64(g, n->right->subtree_gap);
+    if (g != n->subtree_gap) {
+        return -1;
+    }
+    int lh = validate_subtree(n->left, n);
+    int rh = validate_subtree(n->right, n);
+    if (lh < 0 || rh < 0 || lh != rh) {
+        return -1;
+    }
+    return lh + (n->color == VM_ITREE_BLACK ? 1 : 0);
+}
+
+bool vm_itree_validate(const vm_itree_t* tree) {
+    if (!tree) {
+        return false;
+    }
+    if (is_red(tree->root) || validate_subtree(tree->root, NULL) < 0) {
+        return false;
+    }
+
+    /* In-order: strictly ordered, non-overlapping, gaps match neighbours. */
+    uint32_t seen = 0;
+    uint64_t prev_end = tree->low;
+    for (vm_itree_node_t* n = vm_itree_first(tree); n; n = vm_itree_next(n)) {
+        if (seen && n->start < prev_end) {
+            return false;
+        }
+        uint64_t expect = n->start > prev_end ? n->start - prev_end : 0;
+        if (n->gap != expect) {
+            return false;
+        }
+        prev_end = n->end;
+        seen++;
+    }
+    return seen == tree->count;
+}
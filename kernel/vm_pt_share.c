@@ -0,0 +1,109 @@
+/* IKOS Virtual Memory - Leaf page tables shared across fork
+ *
+ * See include/vm_pt_share.h. Callers serialize changes to one address space;
+ * a table shared by several spaces is only written by vm_pt_unshare(), which
+ * never makes an entry more permissive, so sharers reading it concurrently
+ * see either the old entry or a write-protected one.
+ */
+
+#include "vm_pt_share.h"
+
+#define PTE_ADDR_MASK   0x000FFFFFFFFFF000ULL
+
+static inline uint64_t entry_phys(pte_t entry) {
+    return entry & PTE_ADDR_MASK;
+}
+
+uint32_t vm_pt_share_fork(vm_pt_share_t* pt, pte_t* src_pd, pte_t* dst_pd,
+                          uint32_t first, uint32_t last) {
+    if (!pt || !src_pd || !dst_pd) {
+        return 0;
+    }
+    if (last > VM_PT_ENTRIES) {
+        last = VM_PT_ENTRIES;
+    }
+
+    uint32_t shared = 0;
+    for (uint32_t i = first; i < last; i++) {
+        pte_t pde = src_pd[i];
+        if (!(pde & PAGE_PRESENT)) {
+            continue;
+        }
+
+        if (pde & PAGE_LARGE) {
+            uint64_t base = entry_phys(pde);
+            for (uint32_t f = 0; f < HUGE_PAGE_FRAMES; f++) {
+                (*pt->ref_count(base + (uint64_t)f * PAGE_SIZE))++;
+            }
+            pt->stats.huge_shared++;
+        } else {
+            (*pt->ref_count(entry_phys(pde)))++;
+            pde |= PAGE_PT_SHARED;
+            pt->stats.shared++;
+        }
+
+        pde &= ~(pte_t)PAGE_WRITABLE;
+        src_pd[i] = pde;
+        dst_pd[i] = pde;
+        shared++;
+    }
+    return shared;
+}
+
+int vm_pt_unshare(vm_pt_share_t* pt, pte_t* pde) {
+    if (!pt || !pde || !vm_pt_is_shared(*pde)) {
+        return VM_PT_OK;
+    }
+
+    uint64_t old_phys = entry_phys(*pde);
+    uint32_t* old_refs = pt->ref_count(old_phys);
+    pte_t flags = (*pde & ~PTE_ADDR_MASK & ~(pte_t)PAGE_PT_SHARED) | PAGE_WRITABLE;
+
+    if (*old_refs <= 1) {
+        *pde = old_phys | flags;
+        pt->stats.reused++;
+        return VM_PT_OK;
+    }
+
+    uint64_t new_phys = pt->alloc_table();
+    if (!new_phys) {
+        return VM_PT_ENOMEM;
+    }
+
+    pte_t* old_table = pt->table(old_phys);
+    pte_t* new_table = pt->table(new_phys);
+    for (uint32_t i = 0; i < VM_PT_ENTRIES; i++) {
+        pte_t entry = old_table[i];
+        if (entry & PAGE_PRESENT) {
+            if (entry & PAGE_WRITABLE) {
+                /* The frame now has two mappers that can diverge */
+                entry &= ~(pte_t)PAGE_WRITABLE;
+                old_table[i] = entry;
+            }
+            (*pt->ref_count(entry_phys(entry)))++;
+        }
+        new_table[i] = entry;
+    }
+
+    (*old_refs)--;
+    *pde = new_phys | flags;
+    pt->stats.copied++;
+    return VM_PT_OK;
+}
+
+bool vm_pt_drop(vm_pt_share_t* pt, pte_t* pde) {
+    if (!pt || !pde || !vm_pt_is_shared(*pde)) {
+        return false;
+    }
+
+    uint32_t* refs = pt->ref_count(entry_phys(*pde));
+    if (*refs <= 1) {
+        vm_pt_unshare(pt, pde);
+        return false;
+    }
+
+    (*refs)--;
+    *pde = 0;
+    pt->stats.dropped++;
+    return true;
+}
@@ -3,6 +3,8 @@
  */
 
 #include "vmm.h"
+#include "vm_pt_share.h"
+#include "elf.h"
 #include "memory.h"
 #include "scheduler.h"
 #include <string.h>
@@ -17,6 +19,10 @@ static page_frame_t* free_frames = NULL;
 static page_frame_t* frame_database = NULL;
 static uint64_t total_frames = 0;
 static uint64_t free_frame_count = 0;
+static uint64_t huge_scan_hint = 0;     /* Where the next contiguous search starts */
+
+/* page_frame_t.flags */
+#define FRAME_FREE          0x01        /* Frame is on the free list */
 
 /* VMM statistics */
 static vmm_stats_t vmm_statistics;
@@ -31,6 +37,20 @@ static void free_page_table(pte_t* table);
 static uint64_t pte_to_phys(pte_t entry);
 static pte_t phys_to_pte(uint64_t phys, uint32_t flags);
 static int map_page_internal(vm_space_t* space, uint64_t virt, uint64_t phys, uint32_t flags);
+static int split_huge_entry(pte_t* pde, uint64_t virt);
+static int fault_huge_page(vm_space_t* space, vm_region_t* region, uint64_t fault_addr,
+                           uint32_t page_flags);
+static pte_t* pt_share_table(uint64_t phys);
+static uint32_t* pt_share_ref_count(uint64_t phys);
+static uint64_t pt_share_alloc_table(void);
+static int unshare_entry(pte_t* pde);
+
+/* Leaf tables shared across fork, counted in the frame database */
+static vm_pt_share_t pt_share = {
+    .table = pt_share_table,
+    .ref_count = pt_share_ref_count,
+    .alloc_table = pt_share_alloc_table,
+};
 
 /**
  * Initialize the Virtual Memory Manager
@@ -103,6 +123,9 @@ vm_space_t* vmm_create_address_space(uint32_t pid) {
     space->checkpoint_epoch = 0;
     space->snapshot_map_index = 0;
     
+    // Empty region index; gap search places mappings within user space
+    vm_itree_init(&space->region_tree, USER_VIRTUAL_BASE, USER_VIRTUAL_END);
+    
     // Initialize address space layout
     space->heap_start = USER_HEAP_BASE;
     space->heap_end = USER_HEAP_BASE;
@@ -136,8 +159,9 @@ void vmm_destroy_address_space(vm_space_t* space) {
         vm_region_t* next = region->next;
         
         // Unmap all pages in the region
-        for (uint64_t addr = region->start_addr; addr < region->end_addr; addr += PAGE_SIZE) {
-            vmm_unmap_page(space, addr);
+        vmm_unmap_range(space, region->start_addr, region->end_addr);
+        if (region->image) {
+            elf_image_put(region->image);
         }
         
         kfree(region);
@@ -198,9 +222,9 @@ vm_region_t* vmm_create_region(vm_space_t* space, uint64_t start, uint64_t size,
     start = vmm_align_down(start, PAGE_SIZE);
     uint64_t end = vmm_align_up(start + size, PAGE_SIZE);
     
-    // Check for overlap with existing regions
-    vm_region_t* existing = vmm_find_region(space, start);
-    if (existing && start < existing->end_addr) {
+    // Reject overlap with existing regions (the tree insert below also
+    // catches it, but checking first avoids a wasted allocation)
+    if (vm_itree_first_overlap(&space->region_tree, start, end)) {
         return NULL; // Overlap
     }
     
@@ -220,24 +244,24 @@ vm_region_t* vmm_create_region(vm_space_t* space, uint64_t start, uint64_t size,
         strncpy(region->name, name, sizeof(region->name) - 1);
     }
     
-    // Insert into region list (sorted by address)
-    if (!space->regions || start < space->regions->start_addr) {
-        region->next = space->regions;
-        if (space->regions) {
-            space->regions->prev = region;
-        }
-        space->regions = region;
+    // Index the region, then link it into the sorted list right after its
+    // tree predecessor
+    if (vm_itree_insert(&space->region_tree, &region->tree_node, start, end) != VM_ITREE_OK) {
+        kfree(region);
+        return NULL;
+    }
+    
+    vm_itree_node_t* prev_node = vm_itree_prev(&region->tree_node);
+    vm_region_t* prev = prev_node ? VM_ITREE_ENTRY(prev_node, vm_region_t, tree_node) : NULL;
+    region->prev = prev;
+    region->next = prev ? prev->next : space->regions;
+    if (region->next) {
+        region->next->prev = region;
+    }
+    if (prev) {
+        prev->next = region;
     } else {
-        vm_region_t* current = space->regions;
-        while (current->next && current->next->start_addr < start) {
-            current = current->next;
-        }
-        region->next = current->next;
-        region->prev = current;
-        if (current->next) {
-            current->next->prev = region;
-        }
-        current->next = region;
+        space->regions = region;
     }
     
     space->region_count++;
@@ -253,15 +277,8 @@ vm_region_t* vmm_find_region(vm_space_t* space, uint64_t addr) {
         return NULL;
     }
     
-    vm_region_t* region = space->regions;
-    while (region) {
-        if (addr >= region->start_addr && addr < region->end_addr) {
-            return region;
-        }
-        region = region->next;
-    }
-    
-    return NULL;
+    vm_itree_node_t* node = vm_itree_find(&space->region_tree, addr);
+    return node ? VM_ITREE_ENTRY(node, vm_region_t, tree_node) : NULL;
 }
 
 /**
@@ -277,6 +294,7 @@ uint64_t vmm_alloc_page(void) {
     free_frame_count--;
     
     frame->ref_count = 1;
+    frame->flags &= ~FRAME_FREE;
     frame->next = NULL;
     
     vmm_statistics.allocated_pages++;
@@ -306,6 +324,7 @@ void vmm_free_page(uint64_t phys_addr) {
     
     if (frame->ref_count == 0) {
         // Add to free list
+        frame->flags |= FRAME_FREE;
         frame->next = free_frames;
         free_frames = frame;
         free_frame_count++;
@@ -315,6 +334,139 @@ void vmm_free_page(uint64_t phys_addr) {
     }
 }
 
+/**
+ * Frame descriptor (reference count, owner) for a physical address
+ */
+page_frame_t* vmm_get_frame(uint64_t phys_addr) {
+    uint64_t frame_num = PAGE_FRAME(phys_addr);
+    if (!frame_database || frame_num >= total_frames) {
+        return NULL;
+    }
+    return &frame_database[frame_num];
+}
+
+/**
+ * Number of mappings holding a frame; 0 for frames outside the database
+ */
+uint32_t vmm_frame_ref_count(uint64_t phys_addr) {
+    page_frame_t* frame = vmm_get_frame(phys_addr);
+    return frame ? frame->ref_count : 0;
+}
+
+/**
+ * Allocate a huge page: HUGE_PAGE_FRAMES contiguous frames, 2MB aligned.
+ * Each frame gets its own reference, so the run can later be split and
+ * freed 4KB at a time.
+ */
+uint64_t vmm_alloc_huge_page(void) {
+    if (free_frame_count < HUGE_PAGE_FRAMES) {
+        return 0;
+    }
+    
+    // Look for an aligned run of free frames, resuming after the last hit
+    uint64_t runs = total_frames / HUGE_PAGE_FRAMES;
+    uint64_t base = 0;
+    bool found = false;
+    for (uint64_t n = 0; n < runs && !found; n++) {
+        uint64_t run = (huge_scan_hint + n) % runs;
+        base = run * HUGE_PAGE_FRAMES;
+        found = true;
+        for (uint64_t i = 0; i < HUGE_PAGE_FRAMES; i++) {
+            if (!(frame_database[base + i].flags & FRAME_FREE)) {
+                found = false;
+                break;
+            }
+        }
+    }
+    if (!found) {
+        return 0;
+    }
+    huge_scan_hint = base / HUGE_PAGE_FRAMES + 1;
+    
+    // Claim the run, then drop it from the free list in a single pass
+    for (uint64_t i = 0; i < HUGE_PAGE_FRAMES; i++) {
+        frame_database[base + i].flags &= ~FRAME_FREE;
+        frame_database[base + i].ref_count = 1;
+    }
+    page_frame_t** link = &free_frames;
+    while (*link) {
+        if (!((*link)->flags & FRAME_FREE)) {
+            *link = (*link)->next;
+        } else {
+            link = &(*link)->next;
+        }
+    }
+    for (uint64_t i = 0; i < HUGE_PAGE_FRAMES; i++) {
+        frame_database[base + i].next = NULL;
+    }
+    
+    free_frame_count -= HUGE_PAGE_FRAMES;
+    vmm_statistics.allocated_pages += HUGE_PAGE_FRAMES;
+    vmm_statistics.free_pages -= HUGE_PAGE_FRAMES;
+    vmm_statistics.huge_allocs++;
+    
+    return FRAME_ADDR(base);
+}
+
+/**
+ * Drop one reference on every frame of a huge page
+ */
+void vmm_free_huge_page(uint64_t phys_addr) {
+    phys_addr = vmm_align_down(phys_addr, HUGE_PAGE_SIZE);
+    for (uint64_t i = 0; i < HUGE_PAGE_FRAMES; i++) {
+        vmm_free_page(phys_addr + i * PAGE_SIZE);
+    }
+}
+
+/**
+ * Map a 2MB page with a single PD entry
+ */
+int vmm_map_huge_page(vm_space_t* space, uint64_t virt_addr, uint64_t phys_addr, uint32_t flags) {
+    if (!space || (virt_addr & (HUGE_PAGE_SIZE - 1)) || (phys_addr & (HUGE_PAGE_SIZE - 1))) {
+        return VMM_ERROR_INVALID_ADDR;
+    }
+    
+    pte_t* pde = vmm_get_page_table(space, virt_addr, PD_LEVEL, true);
+    if (!pde) {
+        return VMM_ERROR_NOMEM;
+    }
+    
+    // Either a huge page or a page table already covers this span
+    if (*pde & PAGE_PRESENT) {
+        return VMM_ERROR_EXISTS;
+    }
+    
+    *pde = phys_to_pte(phys_addr, flags | PAGE_LARGE);
+    vmm_flush_tlb_page(virt_addr);
+    
+    vmm_statistics.huge_pages++;
+    return VMM_SUCCESS;
+}
+
+/**
+ * Get the PD entry mapping virt_addr if it is a huge mapping, else NULL
+ */
+pte_t* vmm_get_huge_entry(vm_space_t* space, uint64_t virt_addr) {
+    pte_t* pde = vmm_get_page_table(space, virt_addr, PD_LEVEL, false);
+    if (!pde || !(*pde & PAGE_PRESENT) || !(*pde & PAGE_LARGE)) {
+        return NULL;
+    }
+    return pde;
+}
+
+/**
+ * Replace the huge mapping covering virt_addr with a page table of 4KB
+ * entries for the same frames and permissions
+ */
+int vmm_split_huge_page(vm_space_t* space, uint64_t virt_addr) {
+    pte_t* pde = vmm_get_huge_entry(space, virt_addr);
+    if (!pde) {
+        return VMM_ERROR_NOT_FOUND;
+    }
+    
+    return split_huge_entry(pde, virt_addr);
+}
+
 /**
  * Map a virtual page to physical page
  */
@@ -336,12 +488,28 @@ int vmm_unmap_page(vm_space_t* space, uint64_t virt_addr) {
     
     virt_addr = vmm_align_down(virt_addr, PAGE_SIZE);
     
+    // Unmapping part of a huge page splits it first
+    pte_t* pde = vmm_get_huge_entry(space, virt_addr);
+    if (pde) {
+        int result = split_huge_entry(pde, virt_addr);
+        if (result != VMM_SUCCESS) {
+            return result;
+        }
+    }
+    
     // Get page table entry
     pte_t* pte = vmm_get_page_table(space, virt_addr, PT_LEVEL, false);
     if (!pte || !(*pte & PAGE_PRESENT)) {
         return VMM_ERROR_NOT_FOUND;
     }
     
+    // Never clear an entry other spaces still see through a shared table
+    int result = vmm_unshare_page_table(space, virt_addr);
+    if (result != VMM_SUCCESS) {
+        return result;
+    }
+    pte = vmm_get_page_table(space, virt_addr, PT_LEVEL, false);
+    
     // Free physical page
     uint64_t phys_addr = pte_to_phys(*pte);
     vmm_free_page(phys_addr);
@@ -355,6 +523,47 @@ int vmm_unmap_page(vm_space_t* space, uint64_t virt_addr) {
     return VMM_SUCCESS;
 }
 
+/**
+ * Unmap every page in [start, end). Huge pages entirely inside the range
+ * are dropped whole; one straddling an edge is split.
+ */
+int vmm_unmap_range(vm_space_t* space, uint64_t start, uint64_t end) {
+    if (!space) {
+        return VMM_ERROR_INVALID_ADDR;
+    }
+    
+    start = vmm_align_down(start, PAGE_SIZE);
+    end = vmm_align_up(end, PAGE_SIZE);
+    
+    uint64_t addr = start;
+    while (addr < end) {
+        pte_t* pde = vmm_get_huge_entry(space, addr);
+        if (pde && !(addr & (HUGE_PAGE_SIZE - 1)) && addr + HUGE_PAGE_SIZE <= end) {
+            vmm_free_huge_page(pte_to_phys(*pde));
+            *pde = 0;
+            vmm_flush_tlb_page(addr);
+            vmm_statistics.huge_pages--;
+            addr += HUGE_PAGE_SIZE;
+            continue;
+        }
+        
+        // A whole shared leaf table is released without copying it
+        if (!(addr & (HUGE_PAGE_SIZE - 1)) && addr + HUGE_PAGE_SIZE <= end) {
+            pde = vmm_get_page_table(space, addr, PD_LEVEL, false);
+            if (pde && vm_pt_drop(&pt_share, pde)) {
+                vmm_flush_tlb();
+                addr += HUGE_PAGE_SIZE;
+                continue;
+            }
+        }
+        
+        vmm_unmap_page(space, addr);
+        addr += PAGE_SIZE;
+    }
+    
+    return VMM_SUCCESS;
+}
+
 /**
  * Get physical address for virtual address
  */
@@ -363,6 +572,11 @@ uint64_t vmm_get_physical_addr(vm_space_t* space, uint64_t virt_addr) {
         return 0;
     }
     
+    pte_t* pde = vmm_get_huge_entry(space, virt_addr);
+    if (pde) {
+        return pte_to_phys(*pde) + (virt_addr & (HUGE_PAGE_SIZE - 1));
+    }
+    
     pte_t* pte = vmm_get_page_table(space, virt_addr, PT_LEVEL, false);
     if (!pte || !(*pte & PAGE_PRESENT)) {
         return 0;
@@ -384,15 +598,21 @@ void* vmm_alloc_virtual(vm_space_t* space, uint64_t size, uint32_t flags) {
     
     size = vmm_align_up(size, PAGE_SIZE);
     
-    // Find free virtual address space
-    uint64_t start_addr = USER_VIRTUAL_BASE;
-    if (space->regions) {
-        // Simple allocation after last region
-        vm_region_t* last = space->regions;
-        while (last->next) {
-            last = last->next;
-        }
-        start_addr = vmm_align_up(last->end_addr, PAGE_SIZE);
+    // Huge-page regions want a 2MB-aligned start, so ask for enough slack
+    // to align the lowest fitting gap
+    uint64_t slack = 0;
+    if ((flags & VMM_FLAG_HUGE) && size >= HUGE_PAGE_SIZE) {
+        slack = HUGE_PAGE_SIZE - PAGE_SIZE;
+    }
+    
+    // Find the lowest free virtual range that fits
+    uint64_t start_addr;
+    if (!vm_itree_find_gap(&space->region_tree, size + slack, USER_VIRTUAL_BASE,
+                           USER_VIRTUAL_END, &start_addr)) {
+        return NULL;
+    }
+    if (slack) {
+        start_addr = vmm_align_up(start_addr, HUGE_PAGE_SIZE);
     }
     
     // Create region
@@ -404,7 +624,27 @@ void* vmm_alloc_virtual(vm_space_t* space, uint64_t size, uint32_t flags) {
     
     // Allocate and map pages if not lazy
     if (!(flags & VMM_FLAG_LAZY)) {
-        for (uint64_t addr = start_addr; addr < start_addr + size; addr += PAGE_SIZE) {
+        uint32_t page_flags = PAGE_PRESENT | PAGE_WRITABLE;
+        if (flags & VMM_FLAG_USER) {
+            page_flags |= PAGE_USER;
+        }
+        
+        uint64_t addr = start_addr;
+        while (addr < start_addr + size) {
+            // Whole aligned 2MB spans go in as one PD entry when frames allow
+            if ((flags & VMM_FLAG_HUGE) && !(addr & (HUGE_PAGE_SIZE - 1)) &&
+                addr + HUGE_PAGE_SIZE <= start_addr + size) {
+                uint64_t huge = vmm_alloc_huge_page();
+                if (huge && vmm_map_huge_page(space, addr, huge, page_flags) == VMM_SUCCESS) {
+                    addr += HUGE_PAGE_SIZE;
+                    continue;
+                }
+                if (huge) {
+                    vmm_free_huge_page(huge);
+                }
+                vmm_statistics.huge_fallbacks++;
+            }
+            
             uint64_t phys = vmm_alloc_page();
             if (!phys) {
                 // Cleanup on failure
@@ -412,16 +652,12 @@ void* vmm_alloc_virtual(vm_space_t* space, uint64_t size, uint32_t flags) {
                 return NULL;
             }
             
-            uint32_t page_flags = PAGE_PRESENT | PAGE_WRITABLE;
-            if (flags & VMM_FLAG_USER) {
-                page_flags |= PAGE_USER;
-            }
-            
             if (vmm_map_page(space, addr, phys, page_flags) != VMM_SUCCESS) {
                 vmm_free_page(phys);
                 vmm_free_virtual(space, (void*)start_addr, addr - start_addr);
                 return NULL;
             }
+            addr += PAGE_SIZE;
         }
     }
     
@@ -440,9 +676,7 @@ void vmm_free_virtual(vm_space_t* space, void* addr, uint64_t size) {
     uint64_t end = vmm_align_up(start + size, PAGE_SIZE);
     
     // Unmap all pages in range
-    for (uint64_t virt = start; virt < end; virt += PAGE_SIZE) {
-        vmm_unmap_page(space, virt);
-    }
+    vmm_unmap_range(space, start, end);
     
     // Remove region
     vmm_destroy_region(space, start);
@@ -480,6 +714,19 @@ pte_t* vmm_get_page_table(vm_space_t* space, uint64_t virt_addr, int level, bool
             uint64_t phys = vmm_get_physical_addr(kernel_space, (uint64_t)new_table);
             table[index] = phys_to_pte(phys, PAGE_PRESENT | PAGE_WRITABLE | PAGE_USER);
             entry = table[index];
+        } else if (current_level == PD_LEVEL && (entry & PAGE_LARGE)) {
+            // A huge page maps this span; there is no page table below it
+            // unless the caller wants one built
+            if (!create || split_huge_entry(&table[index], addr) != VMM_SUCCESS) {
+                return NULL;
+            }
+            entry = table[index];
+        } else if (create && level == PT_LEVEL && vm_pt_is_shared(entry)) {
+            // The caller is about to change an entry: take a private copy
+            if (unshare_entry(&table[index]) != VMM_SUCCESS) {
+                return NULL;
+            }
+            entry = table[index];
         }
         
         table = (pte_t*)pte_to_phys(entry);
@@ -529,6 +776,16 @@ int vmm_handle_page_fault(page_fault_info_t* fault_info) {
         return VMM_ERROR_PERM_DENIED;
     }
     
+    // Executable images are paged in from the shared image cache; a write
+    // to data faults again on the now-present page and takes the COW path
+    if (region->image && !fault_info->is_present) {
+        int result = elf_image_fault(space, region, fault_addr);
+        if (result == VMM_SUCCESS) {
+            vmm_statistics.minor_faults++;
+        }
+        return result;
+    }
+    
     // Handle copy-on-write
     if (fault_info->is_write && (region->flags & VMM_FLAG_COW)) {
         return vmm_handle_cow_fault(space, fault_addr);
@@ -537,15 +794,22 @@ int vmm_handle_page_fault(page_fault_info_t* fault_info) {
     // Handle lazy allocation
     if (region->flags & VMM_FLAG_LAZY) {
         uint64_t page_addr = vmm_align_down(fault_addr, PAGE_SIZE);
+        uint32_t page_flags = PAGE_PRESENT;
+        if (region->flags & VMM_FLAG_WRITE) page_flags |= PAGE_WRITABLE;
+        if (region->flags & VMM_FLAG_USER) page_flags |= PAGE_USER;
+        
+        // Populate the whole 2MB span at once where the region allows it
+        if ((region->flags & VMM_FLAG_HUGE) &&
+            fault_huge_page(space, region, fault_addr, page_flags) == VMM_SUCCESS) {
+            vmm_statistics.minor_faults++;
+            return VMM_SUCCESS;
+        }
+        
         uint64_t phys = vmm_alloc_page();
         if (!phys) {
             return VMM_ERROR_NOMEM;
         }
         
-        uint32_t page_flags = PAGE_PRESENT;
-        if (region->flags & VMM_FLAG_WRITE) page_flags |= PAGE_WRITABLE;
-        if (region->flags & VMM_FLAG_USER) page_flags |= PAGE_USER;
-        
         int result = vmm_map_page(space, page_addr, phys, page_flags);
         if (result != VMM_SUCCESS) {
             vmm_free_page(phys);
@@ -606,6 +870,7 @@ int vmm_init_physical_memory(uint64_t memory_size) {
         
         // Add to free list (skip first 1MB for kernel/BIOS)
         if (i >= 256) { // Skip first 1MB
+            frame_database[i].flags = FRAME_FREE;
             frame_database[i].next = free_frames;
             free_frames = &frame_database[i];
             free_frame_count++;
@@ -639,6 +904,10 @@ void vmm_flush_tlb_page(uint64_t virt_addr) {
  */
 vmm_stats_t* vmm_get_stats(void) {
     vmm_statistics.memory_usage = (vmm_statistics.allocated_pages * PAGE_SIZE);
+    vmm_statistics.pt_shared = pt_share.stats.shared;
+    vmm_statistics.pt_copied = pt_share.stats.copied;
+    vmm_statistics.pt_reused = pt_share.stats.reused;
+    vmm_statistics.pt_dropped = pt_share.stats.dropped;
     return &vmm_statistics;
 }
 
@@ -757,3 +1026,142 @@ static int map_page_internal(vm_space_t* space, uint64_t virt, uint64_t phys, ui
     
     return VMM_SUCCESS;
 }
+
+/**
+ * Split a huge PD entry into a page table of 4KB entries with the same
+ * frames and permissions. Software bits such as PAGE_SNAPSHOT_COW carry
+ * over to every 4KB entry.
+ */
+static int split_huge_entry(pte_t* pde, uint64_t virt) {
+    pte_t* table = allocate_page_table();
+    if (!table) {
+        return VMM_ERROR_NOMEM;
+    }
+    
+    uint64_t base = pte_to_phys(*pde) & ~(HUGE_PAGE_SIZE - 1);
+    uint32_t flags = (uint32_t)(*pde & 0xFFF) & ~PAGE_LARGE;
+    pte_t nx = *pde & PAGE_NX;
+    
+    for (uint64_t i = 0; i < HUGE_PAGE_FRAMES; i++) {
+        table[i] = phys_to_pte(base + i * PAGE_SIZE, flags) | nx;
+    }
+    
+    uint64_t phys = vmm_get_physical_addr(kernel_space, (uint64_t)table);
+    *pde = phys_to_pte(phys, PAGE_PRESENT | PAGE_WRITABLE | PAGE_USER);
+    
+    // One invlpg drops the whole 2MB translation
+    vmm_flush_tlb_page(vmm_align_down(virt, HUGE_PAGE_SIZE));
+    
+    vmm_statistics.huge_pages--;
+    vmm_statistics.huge_splits++;
+    return VMM_SUCCESS;
+}
+
+/**
+ * Back the 2MB span around fault_addr with a huge page. Fails, leaving the
+ * caller to map 4KB, if the span leaves the region, already has a page
+ * table, or no contiguous frames are free.
+ */
+static int fault_huge_page(vm_space_t* space, vm_region_t* region, uint64_t fault_addr,
+                           uint32_t page_flags) {
+    uint64_t base = vmm_align_down(fault_addr, HUGE_PAGE_SIZE);
+    if (base < region->start_addr || base + HUGE_PAGE_SIZE > region->end_addr) {
+        return VMM_ERROR_INVALID_ADDR;
+    }
+    
+    pte_t* pde = vmm_get_page_table(space, base, PD_LEVEL, false);
+    if (pde && (*pde & PAGE_PRESENT)) {
+        return VMM_ERROR_EXISTS;
+    }
+    
+    uint64_t phys = vmm_alloc_huge_page();
+    if (!phys) {
+        vmm_statistics.huge_fallbacks++;
+        return VMM_ERROR_NOMEM;
+    }
+    
+    int result = vmm_map_huge_page(space, base, phys, page_flags);
+    if (result != VMM_SUCCESS) {
+        vmm_free_huge_page(phys);
+        vmm_statistics.huge_fallbacks++;
+    }
+    return result;
+}
+
+/**
+ * Share the parent's user leaf tables with a freshly created child space.
+ * Upper levels are private to each space; only PML4/PDPT entries that lead
+ * to a page directory are visited, so the cost is one step per PD entry.
+ */
+int vmm_share_page_tables(vm_space_t* dest, vm_space_t* src) {
+    if (!dest || !src) {
+        return VMM_ERROR_INVALID_ADDR;
+    }
+    
+    // Lower half only: the kernel half is already common to every space
+    for (uint64_t i = 0; i < 256; i++) {
+        if (!(src->pml4_virt[i] & PAGE_PRESENT)) {
+            continue;
+        }
+        
+        for (uint64_t j = 0; j < VM_PT_ENTRIES; j++) {
+            uint64_t base = (i << 39) | (j << 30);
+            pte_t* pdpte = vmm_get_page_table(src, base, PDPT_LEVEL, false);
+            if (!pdpte || !(*pdpte & PAGE_PRESENT) || (*pdpte & PAGE_LARGE)) {
+                continue;
+            }
+            
+            pte_t* src_pd = vmm_get_page_table(src, base, PD_LEVEL, false);
+            pte_t* dest_pd = vmm_get_page_table(dest, base, PD_LEVEL, true);
+            if (!src_pd || !dest_pd) {
+                return VMM_ERROR_NOMEM;
+            }
+            
+            vm_pt_share_fork(&pt_share, src_pd, dest_pd, 0, VM_PT_ENTRIES);
+        }
+    }
+    
+    // The parent's writable translations are stale now
+    vmm_flush_tlb();
+    return VMM_SUCCESS;
+}
+
+/**
+ * Give a space its own copy of the leaf table covering virt_addr, if that
+ * table is shared with another space
+ */
+int vmm_unshare_page_table(vm_space_t* space, uint64_t virt_addr) {
+    if (!space) {
+        return VMM_ERROR_INVALID_ADDR;
+    }
+    
+    pte_t* pde = vmm_get_page_table(space, virt_addr, PD_LEVEL, false);
+    if (!pde || !vm_pt_is_shared(*pde)) {
+        return VMM_SUCCESS;
+    }
+    return unshare_entry(pde);
+}
+
+/**
+ * Unshare one PD entry and drop the span's stale read-only translations
+ */
+static int unshare_entry(pte_t* pde) {
+    if (vm_pt_unshare(&pt_share, pde) != VM_PT_OK) {
+        return VMM_ERROR_NOMEM;
+    }
+    vmm_flush_tlb();
+    return VMM_SUCCESS;
+}
+
+static pte_t* pt_share_table(uint64_t phys) {
+    return (pte_t*)(phys + KERNEL_VIRTUAL_BASE);
+}
+
+static uint32_t* pt_share_ref_count(uint64_t phys) {
+    return &frame_database[PAGE_FRAME(phys)].ref_count;
+}
+
+static uint64_t pt_share_alloc_table(void) {
+    pte_t* table = allocate_page_table();
+    return table ? (uint64_t)table - KERNEL_VIRTUAL_BASE : 0;
+}
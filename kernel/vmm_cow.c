@@ -3,13 +3,10 @@
  */
 
 #include "vmm.h"
+#include "elf.h"
 #include "memory.h"
 #include <string.h>
 
-/* Forward declarations for functions defined in vmm.c */
-extern page_frame_t* frame_database;
-extern uint64_t total_frames;
-
 /* Helper functions - static definitions to avoid conflicts */
 static uint64_t cow_pte_to_phys(pte_t entry) {
     return entry & 0xFFFFFFFFFFFFF000ULL;
@@ -29,6 +26,37 @@ int vmm_handle_cow_fault(vm_space_t* space, uint64_t fault_addr) {
     
     uint64_t page_addr = vmm_align_down(fault_addr, PAGE_SIZE);
     
+    // A huge page that no other space shares can simply be made writable;
+    // a shared one is split and only the faulting 4KB page is copied
+    pte_t* pde = vmm_get_huge_entry(space, page_addr);
+    if (pde) {
+        uint64_t base = cow_pte_to_phys(*pde);
+        bool shared = false;
+        for (uint64_t i = 0; i < HUGE_PAGE_FRAMES && !shared; i++) {
+            page_frame_t* frame = vmm_get_frame(base + i * PAGE_SIZE);
+            shared = !frame || frame->ref_count != 1;
+        }
+        
+        if (!shared) {
+            *pde |= PAGE_WRITABLE;
+            vmm_flush_tlb_page(vmm_align_down(page_addr, HUGE_PAGE_SIZE));
+            vmm_get_stats()->huge_cow_reuses++;
+            return VMM_SUCCESS;
+        }
+        
+        int result = vmm_split_huge_page(space, page_addr);
+        if (result != VMM_SUCCESS) {
+            return result;
+        }
+    }
+    
+    // First write under a table still shared since fork: take a private
+    // copy of the table, then resolve the page itself below
+    int result = vmm_unshare_page_table(space, page_addr);
+    if (result != VMM_SUCCESS) {
+        return result;
+    }
+    
     // Get current page table entry
     pte_t* pte = vmm_get_page_table(space, page_addr, PT_LEVEL, false);
     if (!pte || !(*pte & PAGE_PRESENT)) {
@@ -38,13 +66,11 @@ int vmm_handle_cow_fault(vm_space_t* space, uint64_t fault_addr) {
     uint64_t old_phys = cow_pte_to_phys(*pte);
     
     // Get frame reference
-    uint32_t frame_num = PAGE_FRAME(old_phys);
-    if (frame_num >= total_frames) {
+    page_frame_t* frame = vmm_get_frame(old_phys);
+    if (!frame) {
         return VMM_ERROR_INVALID_ADDR;
     }
     
-    page_frame_t* frame = &frame_database[frame_num];
-    
     // If reference count is 1, just remove COW flag
     if (frame->ref_count == 1) {
         *pte |= PAGE_WRITABLE;
@@ -87,6 +113,33 @@ int vmm_map_cow_page(vm_space_t* dst_space, vm_space_t* src_space,
     
     uint64_t page_addr = vmm_align_down(virt_addr, PAGE_SIZE);
     
+    // Share a source huge page whole: one read-only PD entry in each space
+    pte_t* src_pde = vmm_get_huge_entry(src_space, page_addr);
+    if (src_pde) {
+        uint64_t huge_addr = vmm_align_down(page_addr, HUGE_PAGE_SIZE);
+        if (vmm_get_huge_entry(dst_space, huge_addr)) {
+            return VMM_SUCCESS; // Already shared via another page in the span
+        }
+        
+        uint64_t phys_addr = cow_pte_to_phys(*src_pde);
+        *src_pde &= ~PAGE_WRITABLE;
+        vmm_flush_tlb_page(huge_addr);
+        
+        // The low flag bits go through vmm_map_huge_page; NX (bit 63) does not fit
+        pte_t cow_flags = *src_pde & (0xFFF | PAGE_NO_EXECUTE) & ~(pte_t)PAGE_LARGE;
+        int result = vmm_map_huge_page(dst_space, huge_addr, phys_addr, (uint32_t)(cow_flags & 0xFFF));
+        if (result != VMM_SUCCESS) {
+            return result;
+        }
+        *vmm_get_huge_entry(dst_space, huge_addr) |= cow_flags & PAGE_NO_EXECUTE;
+        
+        for (uint64_t i = 0; i < HUGE_PAGE_FRAMES; i++) {
+            vmm_get_frame(phys_addr + i * PAGE_SIZE)->ref_count++;
+        }
+        
+        return VMM_SUCCESS;
+    }
+    
     // Get source page table entry
     pte_t* src_pte = vmm_get_page_table(src_space, page_addr, PT_LEVEL, false);
     if (!src_pte || !(*src_pte & PAGE_PRESENT)) {
@@ -107,60 +160,78 @@ int vmm_map_cow_page(vm_space_t* dst_space, vm_space_t* src_space,
     }
     
     // Increase reference count
-    uint32_t frame_num = PAGE_FRAME(phys_addr);
-    page_frame_t* frame = &frame_database[frame_num];
-    frame->ref_count++;
+    vmm_get_frame(phys_addr)->ref_count++;
     
     return VMM_SUCCESS;
 }
 
 /**
- * Copy entire address space (for fork)
+ * Make dest a copy-on-write copy of src (for fork). dest must be a freshly
+ * created space. Regions are duplicated; pages are not visited at all: the
+ * leaf page tables are shared (see vmm_share_page_tables), so the cost is
+ * proportional to the number of page tables, not the number of pages.
  */
-vm_space_t* vmm_copy_address_space(vm_space_t* src_space, uint32_t new_pid) {
-    if (!src_space) {
-        return NULL;
-    }
-    
-    // Create new address space
-    vm_space_t* dst_space = vmm_create_address_space(new_pid);
-    if (!dst_space) {
-        return NULL;
+int vmm_clone_address_space(vm_space_t* dest, vm_space_t* src) {
+    if (!dest || !src) {
+        return VMM_ERROR_INVALID_ADDR;
     }
     
-    // Copy all regions
-    vm_region_t* region = src_space->regions;
-    while (region) {
-        // Create corresponding region in destination
-        vm_region_t* new_region = vmm_create_region(dst_space, 
+    for (vm_region_t* region = src->regions; region; region = region->next) {
+        // Both sides take the COW path on their next write
+        if (region->flags & VMM_FLAG_WRITE) {
+            region->flags |= VMM_FLAG_COW;
+        }
+        
+        vm_region_t* new_region = vmm_create_region(dest,
                                                     region->start_addr,
                                                     region->end_addr - region->start_addr,
-                                                    region->flags | VMM_FLAG_COW,
+                                                    region->flags,
                                                     region->type,
                                                     region->name);
         if (!new_region) {
-            vmm_destroy_address_space(dst_space);
-            return NULL;
+            return VMM_ERROR_NOMEM;
         }
         
-        // Copy pages with COW semantics
-        for (uint64_t addr = region->start_addr; addr < region->end_addr; addr += PAGE_SIZE) {
-            if (vmm_get_physical_addr(src_space, addr) != 0) {
-                int result = vmm_map_cow_page(dst_space, src_space, addr, region->flags);
-                if (result != VMM_SUCCESS) {
-                    // Continue with best effort
-                }
-            }
+        // Executable pages keep coming from the same shared image
+        new_region->file_offset = region->file_offset;
+        new_region->image = region->image;
+        if (new_region->image) {
+            elf_image_get(new_region->image);
         }
-        
-        region = region->next;
+    }
+    
+    int result = vmm_share_page_tables(dest, src);
+    if (result != VMM_SUCCESS) {
+        return result;
     }
     
     // Copy memory layout information
-    dst_space->heap_start = src_space->heap_start;
-    dst_space->heap_end = src_space->heap_end;
-    dst_space->stack_start = src_space->stack_start;
-    dst_space->mmap_start = src_space->mmap_start;
+    dest->heap_start = src->heap_start;
+    dest->heap_end = src->heap_end;
+    dest->stack_start = src->stack_start;
+    dest->mmap_start = src->mmap_start;
+    
+    return VMM_SUCCESS;
+}
+
+/**
+ * Copy entire address space (for fork)
+ */
+vm_space_t* vmm_copy_address_space(vm_space_t* src_space, uint32_t new_pid) {
+    if (!src_space) {
+        return NULL;
+    }
+    
+    // Create new address space
+    vm_space_t* dst_space = vmm_create_address_space(new_pid);
+    if (!dst_space) {
+        return NULL;
+    }
+    
+    if (vmm_clone_address_space(dst_space, src_space) != VMM_SUCCESS) {
+        vmm_destroy_address_space(dst_space);
+        return NULL;
+    }
     
     return dst_space;
 }
@@ -3,6 +3,7 @@
  */
 
 #include "vmm.h"
+#include "elf.h"
 #include "memory.h"
 #include <string.h>
 
@@ -20,11 +21,11 @@ int vmm_destroy_region(vm_space_t* space, uint64_t addr) {
     }
     
     // Unmap all pages in region
-    for (uint64_t virt = region->start_addr; virt < region->end_addr; virt += PAGE_SIZE) {
-        vmm_unmap_page(space, virt);
-    }
+    vmm_unmap_range(space, region->start_addr, region->end_addr);
+    
+    // Remove from the index and the linked list
+    vm_itree_remove(&space->region_tree, &region->tree_node);
     
-    // Remove from linked list
     if (region->prev) {
         region->prev->next = region->next;
     } else {
@@ -36,11 +37,51 @@ int vmm_destroy_region(vm_space_t* space, uint64_t addr) {
     }
     
     space->region_count--;
+    if (region->image) {
+        elf_image_put(region->image);
+    }
     kfree(region);
     
     return VMM_SUCCESS;
 }
 
+/**
+ * Move a region's bounds in place, keeping the region index consistent.
+ * The new range must stay between the region's neighbours.
+ */
+int vmm_set_region_bounds(vm_space_t* space, vm_region_t* region, uint64_t start, uint64_t end) {
+    if (!space || !region || start >= end) {
+        return VMM_ERROR_INVALID_ADDR;
+    }
+    
+    if (vm_itree_resize(&space->region_tree, &region->tree_node, start, end) != VM_ITREE_OK) {
+        return VMM_ERROR_EXISTS;
+    }
+    
+    region->start_addr = start;
+    region->end_addr = end;
+    
+    return VMM_SUCCESS;
+}
+
+/**
+ * Grow or shrink a region to new_size bytes from its start
+ */
+int vmm_expand_region(vm_space_t* space, vm_region_t* region, uint64_t new_size) {
+    if (!space || !region || new_size == 0) {
+        return VMM_ERROR_INVALID_SIZE;
+    }
+    
+    uint64_t new_end = vmm_align_up(region->start_addr + new_size, PAGE_SIZE);
+    
+    // Unmap pages that fall off the end when shrinking
+    if (new_end < region->end_addr) {
+        vmm_unmap_range(space, new_end, region->end_addr);
+    }
+    
+    return vmm_set_region_bounds(space, region, region->start_addr, new_end);
+}
+
 /**
  * Split a memory region at specified address
  */
@@ -66,9 +107,19 @@ int vmm_split_region(vm_space_t* space, uint64_t split_addr) {
     // Copy region data
     *upper_region = *region;
     upper_region->start_addr = split_addr;
+    if (upper_region->image) {
+        elf_image_get(upper_region->image);
+    }
     
-    // Update original region
-    region->end_addr = split_addr;
+    // Shrink the original, then index the upper part in the freed range
+    uint64_t old_end = region->end_addr;
+    vmm_set_region_bounds(space, region, region->start_addr, split_addr);
+    if (vm_itree_insert(&space->region_tree, &upper_region->tree_node,
+                        split_addr, old_end) != VM_ITREE_OK) {
+        vmm_set_region_bounds(space, region, region->start_addr, old_end);
+        kfree(upper_region);
+        return VMM_ERROR_FAULT;
+    }
     
     // Insert upper region after original
     upper_region->next = region->next;
@@ -94,12 +145,15 @@ int vmm_merge_regions(vm_space_t* space, vm_region_t* region1, vm_region_t* regi
     // Ensure regions are adjacent and compatible
     if (region1->end_addr != region2->start_addr ||
         region1->flags != region2->flags ||
-        region1->type != region2->type) {
+        region1->type != region2->type ||
+        region1->image != region2->image) {
         return VMM_ERROR_INVALID_ADDR;
     }
     
-    // Extend first region
-    region1->end_addr = region2->end_addr;
+    // Drop the second region from the index and extend the first over it
+    uint64_t merged_end = region2->end_addr;
+    vm_itree_remove(&space->region_tree, &region2->tree_node);
+    vmm_set_region_bounds(space, region1, region1->start_addr, merged_end);
     
     // Remove second region from list
     if (region2->prev) {
@@ -110,11 +164,80 @@ int vmm_merge_regions(vm_space_t* space, vm_region_t* region1, vm_region_t* regi
     }
     
     space->region_count--;
+    if (region2->image) {
+        elf_image_put(region2->image);
+    }
     kfree(region2);
     
     return VMM_SUCCESS;
 }
 
+/**
+ * Replace the permission bits of a present entry. The frame, PAGE_LARGE,
+ * caching and accessed/dirty bits and the software bits stay; a page still
+ * tagged PAGE_SNAPSHOT_COW stays read-only so its next write still faults.
+ */
+static pte_t protect_entry(pte_t entry, uint64_t page_flags) {
+    const pte_t perms = PAGE_PRESENT | PAGE_WRITABLE | PAGE_USER | PAGE_NX;
+    if (entry & PAGE_SNAPSHOT_COW) {
+        page_flags &= ~(uint64_t)PAGE_WRITABLE;
+    }
+    // A frame shared copy-on-write stays read-only too; the COW fault
+    // gives this space its own copy before the write
+    page_frame_t* frame = vmm_get_frame(entry & 0x000FFFFFFFFFF000ULL);
+    if (frame && frame->ref_count > 1) {
+        page_flags &= ~(uint64_t)PAGE_WRITABLE;
+    }
+    return (entry & ~perms) | page_flags;
+}
+
+/**
+ * Apply VMM_FLAG_* protection to the pages already mapped in [start, end)
+ */
+int vmm_protect_pages(vm_space_t* space, uint64_t start, uint64_t end, uint32_t new_flags) {
+    if (!space || start >= end) {
+        return VMM_ERROR_INVALID_ADDR;
+    }
+    
+    uint64_t page_flags = PAGE_PRESENT;
+    if (new_flags & VMM_FLAG_WRITE) page_flags |= PAGE_WRITABLE;
+    if (new_flags & VMM_FLAG_USER) page_flags |= PAGE_USER;
+    if (!(new_flags & VMM_FLAG_EXEC)) page_flags |= PAGE_NX;
+    
+    uint64_t page_addr = vmm_align_down(start, PAGE_SIZE);
+    end = vmm_align_up(end, PAGE_SIZE);
+    while (page_addr < end) {
+        // A huge page wholly inside the range keeps its PD entry; one
+        // that straddles the edge is split below
+        pte_t* pde = vmm_get_huge_entry(space, page_addr);
+        if (pde && !(page_addr & (HUGE_PAGE_SIZE - 1)) &&
+            page_addr + HUGE_PAGE_SIZE <= end) {
+            *pde = protect_entry(*pde, page_flags);
+            vmm_flush_tlb_page(page_addr);
+            page_addr += HUGE_PAGE_SIZE;
+            continue;
+        }
+        
+        pte_t* pte = vmm_get_page_table(space, page_addr, PT_LEVEL, pde != NULL);
+        // A table fork still shares is copied first, so the change stays
+        // in this space
+        if (pte && (*pte & PAGE_PRESENT)) {
+            int result = vmm_unshare_page_table(space, page_addr);
+            if (result != VMM_SUCCESS) {
+                return result;
+            }
+            pte = vmm_get_page_table(space, page_addr, PT_LEVEL, false);
+        }
+        if (pte && (*pte & PAGE_PRESENT)) {
+            *pte = protect_entry(*pte, page_flags);
+            vmm_flush_tlb_page(page_addr);
+        }
+        page_addr += PAGE_SIZE;
+    }
+    
+    return VMM_SUCCESS;
+}
+
 /**
  * Change protection flags for a memory region
  */
@@ -156,17 +279,9 @@ int vmm_protect_region(vm_space_t* space, uint64_t addr, uint64_t size, uint32_t
         region->flags = new_flags;
         
         // Update page table entries for mapped pages
-        for (uint64_t page_addr = region_start; page_addr < region_end; page_addr += PAGE_SIZE) {
-            pte_t* pte = vmm_get_page_table(space, page_addr, PT_LEVEL, false);
-            if (pte && (*pte & PAGE_PRESENT)) {
-                uint32_t page_flags = PAGE_PRESENT;
-                if (new_flags & VMM_FLAG_WRITE) page_flags |= PAGE_WRITABLE;
-                if (new_flags & VMM_FLAG_USER) page_flags |= PAGE_USER;
-                if (!(new_flags & VMM_FLAG_EXEC)) page_flags |= PAGE_NX;
-                
-                *pte = (*pte & 0xFFFFFFFFFFFFF000ULL) | page_flags;
-                vmm_flush_tlb_page(page_addr);
-            }
+        int result = vmm_protect_pages(space, region_start, region_end, new_flags);
+        if (result != VMM_SUCCESS) {
+            return result;
         }
         
         current_addr = region_end;
@@ -195,16 +310,13 @@ void* vmm_expand_heap(vm_space_t* space, int64_t increment) {
         return (void*)-1; // Underflow
     }
     
-    // Find heap region
-    vm_region_t* heap_region = NULL;
-    vm_region_t* region = space->regions;
-    while (region) {
-        if (region->type == VMM_REGION_HEAP && 
-            old_heap_end >= region->start_addr && old_heap_end <= region->end_addr) {
-            heap_region = region;
-            break;
-        }
-        region = region->next;
+    // Find the heap region containing (or ending exactly at) the break
+    vm_region_t* heap_region = vmm_find_region(space, old_heap_end);
+    if ((!heap_region || heap_region->type != VMM_REGION_HEAP) && old_heap_end > 0) {
+        heap_region = vmm_find_region(space, old_heap_end - 1);
+    }
+    if (heap_region && heap_region->type != VMM_REGION_HEAP) {
+        heap_region = NULL;
     }
     
     if (increment > 0) {
@@ -251,7 +363,10 @@ void* vmm_expand_heap(vm_space_t* space, int64_t increment) {
                     }
                 } else {
                     // Extend existing region
-                    heap_region->end_addr = vmm_align_up(new_heap_end, PAGE_SIZE);
+                    if (vmm_set_region_bounds(space, heap_region, heap_region->start_addr,
+                                              vmm_align_up(new_heap_end, PAGE_SIZE)) != VMM_SUCCESS) {
+                        return (void*)-1; // Would run into the next region
+                    }
                 }
             }
         }
@@ -262,15 +377,14 @@ void* vmm_expand_heap(vm_space_t* space, int64_t increment) {
         
         if (pages_to_free > 0) {
             // Free pages
-            for (uint64_t addr = vmm_align_up(new_heap_end, PAGE_SIZE); 
-                 addr < vmm_align_up(old_heap_end, PAGE_SIZE); 
-                 addr += PAGE_SIZE) {
-                vmm_unmap_page(space, addr);
-            }
+            vmm_unmap_range(space, vmm_align_up(new_heap_end, PAGE_SIZE),
+                            vmm_align_up(old_heap_end, PAGE_SIZE));
             
             // Shrink region if needed
-            if (heap_region && vmm_align_up(new_heap_end, PAGE_SIZE) < heap_region->end_addr) {
-                heap_region->end_addr = vmm_align_up(new_heap_end, PAGE_SIZE);
+            if (heap_region && vmm_align_up(new_heap_end, PAGE_SIZE) < heap_region->end_addr &&
+                vmm_align_up(new_heap_end, PAGE_SIZE) > heap_region->start_addr) {
+                vmm_set_region_bounds(space, heap_region, heap_region->start_addr,
+                                      vmm_align_up(new_heap_end, PAGE_SIZE));
             }
         }
     }
@@ -295,41 +409,20 @@ void* vmm_mmap(vm_space_t* space, void* addr, uint64_t size, uint32_t prot, uint
         start_addr = vmm_align_down((uint64_t)addr, PAGE_SIZE);
         
         // Check if address range is available
-        for (uint64_t check_addr = start_addr; check_addr < start_addr + size; check_addr += PAGE_SIZE) {
-            if (vmm_find_region(space, check_addr)) {
-                if (!(flags & VMM_MMAP_FIXED)) {
-                    // Find alternative address
-                    start_addr = 0;
-                    break;
-                } else {
-                    return (void*)-1; // Fixed mapping failed
-                }
+        if (vm_itree_first_overlap(&space->region_tree, start_addr, start_addr + size)) {
+            if (!(flags & VMM_MMAP_FIXED)) {
+                // Find alternative address
+                start_addr = 0;
+            } else {
+                return (void*)-1; // Fixed mapping failed
             }
         }
     }
     
     if (!addr || start_addr == 0) {
-        // Find suitable address
-        start_addr = space->mmap_start;
-        
-        // Simple allocation - find first available space
-        while (start_addr + size < USER_STACK_TOP - 0x10000) { // Leave space for stack
-            bool available = true;
-            for (uint64_t check_addr = start_addr; check_addr < start_addr + size; check_addr += PAGE_SIZE) {
-                if (vmm_find_region(space, check_addr)) {
-                    available = false;
-                    break;
-                }
-            }
-            
-            if (available) {
-                break;
-            }
-            
-            start_addr += PAGE_SIZE;
-        }
-        
-        if (start_addr + size >= USER_STACK_TOP - 0x10000) {
+        // Lowest free gap at or above the mmap cursor, leaving space for stack
+        if (!vm_itree_find_gap(&space->region_tree, size, space->mmap_start,
+                               USER_STACK_TOP - 0x10000, &start_addr)) {
             return (void*)-1; // No space available
         }
     }
@@ -386,39 +479,33 @@ int vmm_munmap(vm_space_t* space, void* addr, uint64_t size) {
     uint64_t start_addr = vmm_align_down((uint64_t)addr, PAGE_SIZE);
     uint64_t end_addr = vmm_align_up((uint64_t)addr + size, PAGE_SIZE);
     
-    // Unmap pages and destroy regions in range
-    for (uint64_t current_addr = start_addr; current_addr < end_addr; ) {
-        vm_region_t* region = vmm_find_region(space, current_addr);
-        if (!region) {
-            current_addr += PAGE_SIZE;
-            continue;
-        }
+    // Walk only the regions that intersect the range
+    vm_itree_node_t* node = vm_itree_first_overlap(&space->region_tree, start_addr, end_addr);
+    while (node && node->start < end_addr) {
+        vm_region_t* region = VM_ITREE_ENTRY(node, vm_region_t, tree_node);
+        node = vm_itree_next(node);
         
-        uint64_t region_start = (current_addr > region->start_addr) ? current_addr : region->start_addr;
+        uint64_t region_start = (start_addr > region->start_addr) ? start_addr : region->start_addr;
         uint64_t region_end = (end_addr < region->end_addr) ? end_addr : region->end_addr;
         
-        // Unmap pages in this region
-        for (uint64_t page_addr = region_start; page_addr < region_end; page_addr += PAGE_SIZE) {
-            vmm_unmap_page(space, page_addr);
-        }
+        // Unmap pages in this region (splits huge pages cut by the range)
+        vmm_unmap_range(space, region_start, region_end);
         
         // Handle partial unmapping
         if (region_start == region->start_addr && region_end == region->end_addr) {
             // Remove entire region
-            vmm_destroy_region(space, current_addr);
+            vmm_destroy_region(space, region_start);
         } else if (region_start == region->start_addr) {
             // Remove from start
-            region->start_addr = region_end;
+            vmm_set_region_bounds(space, region, region_end, region->end_addr);
         } else if (region_end == region->end_addr) {
             // Remove from end
-            region->end_addr = region_start;
+            vmm_set_region_bounds(space, region, region->start_addr, region_start);
         } else {
             // Split region
             vmm_split_region(space, region_end);
-            region->end_addr = region_start;
+            vmm_set_region_bounds(space, region, region->start_addr, region_start);
         }
-        
-        current_addr = region_end;
     }
     
     return VMM_SUCCESS;
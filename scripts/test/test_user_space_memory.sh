@@ -65,6 +65,7 @@ log_info "Building functional test suite..."
 gcc $CFLAGS -o "$BUILD_DIR/test_usmm_functional" \
     "$TESTS_DIR/test_user_space_memory.c" \
     "$TESTS_DIR/usmm_stubs.c" \
+    kernel/vm_interval_tree.c \
     $LDFLAGS
 
 if [ $? -eq 0 ]; then
@@ -79,6 +80,7 @@ log_info "Building performance test suite..."
 gcc $CFLAGS -o "$BUILD_DIR/test_usmm_performance" \
     "$TESTS_DIR/test_user_space_memory_performance.c" \
     "$TESTS_DIR/usmm_stubs.c" \
+    kernel/vm_interval_tree.c \
     $LDFLAGS
 
 if [ $? -eq 0 ]; then
@@ -48,12 +48,15 @@ void  kfree(void* p) { free(p); }
 
 #include "checkpoint.h"       /* checkpoint + snapshot_store + fat_block_device_t */
 #include "checkpoint_ide.h"   /* checkpoint_ide_bind (the durable-store adapter) */
+#include "ide_dma.h"          /* ide_dma_request_t, as the adapter submits it */
 
 /* ----- Engine link stubs (empty process list; the counter page is driven
  * through capture explicitly, as in test_persistence_e2e). ----- */
 pte_t* vmm_get_page_table(vm_space_t* s, uint64_t a, int l, bool c) { (void)s;(void)a;(void)l;(void)c; return 0; }
 vm_space_t* vmm_get_current_space(void) { return 0; }
 void vmm_flush_tlb_page(uint64_t a) { (void)a; }
+int vmm_unshare_page_table(vm_space_t* s, uint64_t a) { (void)s; (void)a; return 0; }
+uint32_t vmm_frame_ref_count(uint64_t p) { (void)p; return 1; }
 uint64_t vmm_get_physical_addr(vm_space_t* s, uint64_t a) { (void)s;(void)a; return 0; }
 vm_space_t* vmm_create_address_space(uint32_t pid) { (void)pid; return 0; }
 uint64_t vmm_alloc_page(void) { return 0; }
@@ -89,6 +92,21 @@ int ide_write_sectors(void* dev, uint8_t drive, uint64_t lba, uint16_t count, co
     return IDE_SUCCESS;
 }
 
+/* checkpoint_ide.c submits a request and waits for it; the mock leaves it
+ * pending at submit and does the transfer in the wait. */
+int ide_submit(void* dev, ide_dma_request_t* req) {
+    (void)dev;
+    req->complete = false;
+    return IDE_SUCCESS;
+}
+int ide_wait_request(void* dev, ide_dma_request_t* req) {
+    int rc = req->write
+        ? ide_write_sectors(dev, req->drive, req->lba, req->count, req->buffer)
+        : ide_read_sectors(dev, req->drive, req->lba, req->count, req->buffer);
+    req->complete = true;
+    return rc;
+}
+
 /* The counter lives at offset 0 of one persisted page. */
 #define COUNTER_PID   1
 #define COUNTER_VADDR 0x400000ULL
@@ -0,0 +1,285 @@
+/* Host-side unit test for the block request queue.
+ *
+ * Verifies:
+ *   1. Unplugged, every write goes straight to the device.
+ *   2. A plugged checkpoint stream (1 metadata + 8 page sectors per record)
+ *      reaches the device as a few requests of max_sectors, only at unplug.
+ *   3. Back merges, front merges and a write bridging two requests; nested
+ *      plugs dispatch only at the outermost unplug.
+ *   4. A write over queued sectors replaces them, and reads while plugged
+ *      see queued data.
+ *   5. Dispatch sweeps upward from the head and wraps; a request past its
+ *      deadline goes first.
+ *   6. A failed dispatch is reported by unplug once; a full queue dispatches
+ *      on its own; without memory a write goes through after the queue.
+ *   7. Latencies land in their log2 buckets.
+ *
+ * Build: gcc -I../include -o test_blk_queue test_blk_queue.c ../kernel/blk_queue.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+typedef __SIZE_TYPE__ size_t;
+extern int printf(const char*, ...);
+extern void* malloc(size_t);
+extern void free(void*);
+
+#include "blk_queue.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+/* ---- Simulated disk: every command costs `cost` ticks ---- */
+#define SECTOR      512
+#define DISK        4096
+
+static uint8_t disk[DISK * SECTOR];
+static uint64_t ticks;
+static uint64_t cost = 1;
+static uint32_t cmd_sector[256], cmd_count[256];
+static int commands;
+static uint32_t fail_sector = 0xFFFFFFFFU;
+
+static int disk_read(void* dev, uint32_t sector, uint32_t count, void* buf) {
+    (void)dev;
+    ticks += cost;
+    for (uint32_t i = 0; i < count * SECTOR; i++) ((uint8_t*)buf)[i] = disk[sector * SECTOR + i];
+    return 0;
+}
+
+static int disk_write(void* dev, uint32_t sector, uint32_t count, const void* buf) {
+    (void)dev;
+    ticks += cost;
+    if (commands < 256) {
+        cmd_sector[commands] = sector;
+        cmd_count[commands] = count;
+    }
+    commands++;
+    if (fail_sector >= sector && fail_sector < sector + count) return -1;
+    for (uint32_t i = 0; i < count * SECTOR; i++) disk[sector * SECTOR + i] = ((const uint8_t*)buf)[i];
+    return 0;
+}
+
+static fat_block_device_t lower = { disk_read, disk_write, SECTOR, DISK, 0, 0, 0 };
+
+static uint64_t sim_now(void* ctx) { (void)ctx; return ticks; }
+
+static int live_allocs;
+static bool out_of_memory;
+static void* sim_alloc(size_t n) {
+    if (out_of_memory) return 0;
+    live_allocs++;
+    return malloc(n);
+}
+static void sim_free(void* p) { live_allocs--; free(p); }
+
+static const blk_queue_ops_t ops = { sim_now, sim_alloc, sim_free, 0 };
+
+/* Sector contents: byte i of sector s written in generation g */
+static uint8_t pattern(uint32_t s, uint32_t i, uint32_t g) { return (uint8_t)(s * 3 + i + g * 101); }
+
+static void fill(uint8_t* buf, uint32_t sector, uint32_t count, uint32_t gen) {
+    for (uint32_t s = 0; s < count; s++)
+        for (uint32_t i = 0; i < SECTOR; i++) buf[s * SECTOR + i] = pattern(sector + s, i, gen);
+}
+
+static bool holds(const uint8_t* buf, uint32_t sector, uint32_t count, uint32_t gen) {
+    for (uint32_t s = 0; s < count; s++)
+        for (uint32_t i = 0; i < SECTOR; i++)
+            if (buf[s * SECTOR + i] != pattern(sector + s, i, gen)) return false;
+    return true;
+}
+
+static bool on_disk(uint32_t sector, uint32_t count, uint32_t gen) {
+    return holds(disk + sector * SECTOR, sector, count, gen);
+}
+
+static int put(fat_block_device_t* dev, uint32_t sector, uint32_t count, uint32_t gen) {
+    static uint8_t buf[256 * SECTOR];
+    fill(buf, sector, count, gen);
+    return dev->write_sectors(dev->private_data, sector, count, buf);
+}
+
+static void reset(void) {
+    for (uint32_t i = 0; i < DISK * SECTOR; i++) disk[i] = 0;
+    commands = 0;
+    ticks = 0;
+    cost = 1;
+    fail_sector = 0xFFFFFFFFU;
+}
+
+int main(void) {
+    printf("=== Block queue unit test ===\n");
+    static uint8_t buf[256 * SECTOR];
+
+    /* --- 1. Write-through --- */
+    {
+        reset();
+        blk_queue_t q;
+        blk_queue_init(&q, &lower, &ops);
+        fat_block_device_t* dev = &q.dev;
+        put(dev, 10, 1, 1);
+        put(dev, 11, 1, 1);
+        CHECK(commands == 2 && on_disk(10, 2, 1), "unplugged writes reach the device at once");
+        CHECK(dev->sector_size == SECTOR && dev->total_sectors == DISK, "geometry passed up");
+        blk_queue_destroy(&q);
+    }
+
+    /* --- 2. Plugged checkpoint stream --- */
+    {
+        reset();
+        blk_queue_t q;
+        blk_queue_init(&q, &lower, &ops);
+        fat_block_device_t* dev = &q.dev;
+        blk_plug(dev);
+        for (uint32_t r = 0; r < 32; r++) {
+            put(dev, 200 + r * 9, 1, 2);
+            put(dev, 201 + r * 9, 8, 2);
+        }
+        CHECK(commands == 0 && q.depth == 3, "nothing reaches the device while plugged");
+        int rc = blk_unplug(dev);
+        printf("  64 writes of 32 records: %d device commands (%u, %u, %u sectors)\n", commands,
+               cmd_count[0], cmd_count[1], cmd_count[2]);
+        CHECK(rc == BLK_QUEUE_OK && commands == 3 && cmd_count[0] == 127 && cmd_count[1] == 126,
+              "merged into requests of up to max_sectors");
+        CHECK(on_disk(200, 288, 2), "data correct after unplug");
+        CHECK(q.stats.back_merges == 61 && q.stats.writes == 64, "merges counted");
+        blk_queue_destroy(&q);
+        CHECK(live_allocs == 0, "nothing leaked");
+    }
+
+    /* --- 3. Front merges, bridging, nesting --- */
+    {
+        reset();
+        blk_queue_t q;
+        blk_queue_init(&q, &lower, &ops);
+        fat_block_device_t* dev = &q.dev;
+        blk_plug(dev);
+        blk_plug(dev);
+        put(dev, 10, 2, 3);
+        put(dev, 14, 2, 3);
+        CHECK(q.depth == 2, "separate ranges are separate requests");
+        put(dev, 12, 2, 3);
+        CHECK(q.depth == 1 && q.head->sector == 10 && q.head->count == 6,
+              "a write between two requests joins them");
+        put(dev, 8, 2, 3);
+        CHECK(q.depth == 1 && q.head->sector == 8 && q.stats.front_merges == 1,
+              "a write ending where a request starts is prepended");
+        CHECK(blk_unplug(dev) == BLK_QUEUE_OK && commands == 0, "the inner unplug dispatches nothing");
+        blk_unplug(dev);
+        CHECK(commands == 1 && cmd_sector[0] == 8 && cmd_count[0] == 8 && on_disk(8, 8, 3),
+              "one command for the joined range");
+        blk_queue_destroy(&q);
+    }
+
+    /* --- 4. Overwrites and reads --- */
+    {
+        reset();
+        blk_queue_t q;
+        blk_queue_init(&q, &lower, &ops);
+        fat_block_device_t* dev = &q.dev;
+        put(dev, 96, 16, 4);
+        commands = 0;
+        blk_plug(dev);
+        put(dev, 100, 8, 5);
+        put(dev, 104, 8, 6);
+        CHECK(q.depth == 1 && q.head->count == 12 && q.stats.overwrites == 1,
+              "overlapping writes share one request");
+
+        dev->read_sectors(dev->private_data, 96, 16, buf);
+        CHECK(holds(buf, 96, 4, 4) && holds(buf + 4 * SECTOR, 100, 4, 5) && holds(buf + 8 * SECTOR, 104, 8, 6),
+              "reads see queued data over the disk");
+        blk_unplug(dev);
+        CHECK(commands == 1 && on_disk(100, 4, 5) && on_disk(104, 8, 6), "the newest data reaches the disk");
+        blk_queue_destroy(&q);
+    }
+
+    /* --- 5. Elevator and deadline --- */
+    {
+        reset();
+        blk_queue_t q;
+        blk_queue_init(&q, &lower, &ops);
+        fat_block_device_t* dev = &q.dev;
+        put(dev, 399, 1, 7);            /* The head is now at 400 */
+        commands = 0;
+        blk_plug(dev);
+        put(dev, 900, 1, 7);
+        put(dev, 100, 1, 7);
+        put(dev, 500, 1, 7);
+        put(dev, 300, 1, 7);
+        blk_unplug(dev);
+        CHECK(commands == 4 && cmd_sector[0] == 500 && cmd_sector[1] == 900 &&
+              cmd_sector[2] == 100 && cmd_sector[3] == 300, "one upward sweep from the head, then wrap");
+
+        commands = 0;
+        ticks = 0;
+        blk_plug(dev);
+        put(dev, 50, 1, 8);
+        ticks = 500;
+        put(dev, 2000, 1, 8);
+        put(dev, 1000, 1, 8);
+        blk_unplug(dev);
+        CHECK(cmd_sector[0] == 50 && cmd_sector[1] == 1000 && q.stats.expired == 1,
+              "an expired request goes before the sweep");
+        blk_queue_destroy(&q);
+    }
+
+    /* --- 6. Errors, a full queue, no memory --- */
+    {
+        reset();
+        blk_queue_t q;
+        blk_queue_init(&q, &lower, &ops);
+        fat_block_device_t* dev = &q.dev;
+        blk_plug(dev);
+        put(dev, 10, 1, 9);
+        put(dev, 20, 1, 9);
+        fail_sector = 10;
+        CHECK(blk_unplug(dev) == BLK_QUEUE_EIO && on_disk(20, 1, 9) && q.stats.errors == 1,
+              "unplug reports the failed dispatch; the rest are written");
+        fail_sector = 0xFFFFFFFFU;
+        blk_plug(dev);
+        put(dev, 30, 1, 9);
+        CHECK(blk_unplug(dev) == BLK_QUEUE_OK, "the error is reported once");
+
+        commands = 0;
+        blk_plug(dev);
+        for (uint32_t i = 0; i < BLK_QUEUE_MAX_REQUESTS; i++) put(dev, i * 2, 1, 10);
+        CHECK(commands == BLK_QUEUE_MAX_REQUESTS && q.depth == 0, "a full queue dispatches itself");
+
+        put(dev, 1000, 4, 10);
+        out_of_memory = true;
+        put(dev, 1002, 4, 11);
+        out_of_memory = false;
+        CHECK(on_disk(1000, 2, 10) && on_disk(1002, 4, 11) && q.depth == 0,
+              "without memory the queue goes out, then the write");
+        blk_unplug(dev);
+        blk_queue_destroy(&q);
+        CHECK(live_allocs == 0, "nothing leaked");
+    }
+
+    /* --- 7. Latency histograms --- */
+    {
+        reset();
+        blk_queue_t q;
+        blk_queue_init(&q, &lower, &ops);
+        fat_block_device_t* dev = &q.dev;
+        cost = 0;
+        put(dev, 1, 1, 12);             /* 0 ticks: bucket 0 */
+        cost = 5;
+        put(dev, 2, 1, 12);             /* 5 ticks: [4, 8) is bucket 3 */
+        cost = 1 << 20;
+        dev->read_sectors(dev->private_data, 1, 1, buf);    /* Past the last bucket */
+        blk_queue_stats_t st;
+        blk_queue_get_stats(&q, &st);
+        CHECK(st.write_latency[0] == 1 && st.write_latency[3] == 1, "write latencies bucketed by log2");
+        CHECK(st.read_latency[BLK_LATENCY_BUCKETS - 1] == 1, "slow reads land in the last bucket");
+        blk_queue_destroy(&q);
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
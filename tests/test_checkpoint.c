@@ -67,6 +67,8 @@ pte_t* vmm_get_page_table(vm_space_t* space, uint64_t virt_addr, int level, bool
 }
 vm_space_t* vmm_get_current_space(void) { return 0; }
 void vmm_flush_tlb_page(uint64_t virt_addr) { (void)virt_addr; g_flushes++; }
+int vmm_unshare_page_table(vm_space_t* s, uint64_t a) { (void)s; (void)a; return 0; }
+uint32_t vmm_frame_ref_count(uint64_t p) { (void)p; return 1; }
 uint64_t vmm_get_physical_addr(vm_space_t* space, uint64_t virt_addr) {
     (void)space; (void)virt_addr; return 0; /* clean-page walk unused here */
 }
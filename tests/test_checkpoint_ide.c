@@ -3,8 +3,9 @@
  * checkpoint_ide_bind() adapts an IDE drive to fat_block_device_t. This test
  * binds a MOCK ide backend (an in-memory disk) and drives a real snapshot store
  * through it - begin/add_page/commit then load/next - proving the adapter
- * correctly bridges store sector I/O to ide_read_sectors/ide_write_sectors,
- * including the sector->LBA and count mapping.
+ * correctly bridges store sector I/O to IDE requests (ide_submit, then
+ * ide_wait_request), including the sector->LBA and count mapping and the
+ * split of long transfers into requests the controller can take.
  *
  * Build: gcc -I../include -o test_checkpoint_ide test_checkpoint_ide.c \
  *            ../kernel/checkpoint_ide.c ../kernel/snapshot_store.c
@@ -26,6 +27,7 @@ void  kfree(void* p) { free(p); }
 
 #include "checkpoint_ide.h"
 #include "snapshot_store.h"
+#include "ide_dma.h"
 
 /* ---- Mock IDE backend: an in-memory disk addressed by LBA. ---- */
 #define IDE_SECTORS 2048
@@ -51,6 +53,21 @@ int ide_write_sectors(void* dev, uint8_t drive, uint64_t lba, uint16_t count, co
     return IDE_SUCCESS;
 }
 
+/* checkpoint_ide.c submits a request and waits for it; the mock leaves it
+ * pending at submit and does the transfer in the wait. */
+int ide_submit(void* dev, ide_dma_request_t* req) {
+    (void)dev;
+    req->complete = false;
+    return IDE_SUCCESS;
+}
+int ide_wait_request(void* dev, ide_dma_request_t* req) {
+    int rc = req->write
+        ? ide_write_sectors(dev, req->drive, req->lba, req->count, req->buffer)
+        : ide_read_sectors(dev, req->drive, req->lba, req->count, req->buffer);
+    req->complete = true;
+    return rc;
+}
+
 static int failures = 0;
 #define CHECK(cond, msg) do { \
     if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
@@ -77,6 +94,12 @@ int main(void) {
     dev->read_sectors(dev->private_data, 17, 1, sec);
     CHECK(g_last_lba == 17 && g_last_count == 1, "sector maps to LBA/count");
 
+    /* A transfer longer than one command goes out as several requests. */
+    static uint8_t big[300 * 512];
+    CHECK(dev->read_sectors(dev->private_data, 100, 300, big) == 0 &&
+          g_last_lba == 100 + IDE_DMA_MAX_SECTORS && g_last_count == 300 - IDE_DMA_MAX_SECTORS,
+          "long transfer split at IDE_DMA_MAX_SECTORS");
+
     /* Drive a full checkpoint through the adapter. */
     snapshot_store_t store;
     CHECK(snapshot_store_init(&store, dev, 0, 256) == SNAPSHOT_OK, "store init over IDE");
@@ -7,6 +7,8 @@
  *   2. On restore, a read-only record (CHECKPOINT_REC_READONLY) is re-mapped
  *      WITHOUT write permission, while an ordinary page is mapped writable, and
  *      both pages' contents land in their frames.
+ *   3. A read-only page persisted once with an alias record (text shared by
+ *      several processes) is restored read-only into every listed mapping.
  *
  * Build: gcc -I../include -o test_checkpoint_readonly test_checkpoint_readonly.c \
  *            ../kernel/checkpoint.c ../kernel/snapshot_store.c \
@@ -37,18 +39,38 @@ pte_t* vmm_get_page_table(vm_space_t* s, uint64_t a, int l, bool c) {
 }
 vm_space_t* vmm_get_current_space(void) { return 0; }
 void vmm_flush_tlb_page(uint64_t a) { (void)a; }
-uint64_t vmm_get_physical_addr(vm_space_t* s, uint64_t a) { (void)s; (void)a; return 0; }
+int vmm_unshare_page_table(vm_space_t* s, uint64_t a) { (void)s; (void)a; return 0; }
+uint32_t vmm_frame_ref_count(uint64_t p) { (void)p; return 1; }
 vm_space_t* vmm_create_address_space(uint32_t pid) { (void)pid; return (vm_space_t*)&g_fake_space; }
 uint64_t vmm_alloc_page(void) { return (uint64_t)(uintptr_t)malloc(PAGE_SIZE); }
 
 #define MAXMAP 8
 static struct { uint64_t virt; uint64_t phys; uint32_t flags; } g_maps[MAXMAP];
 static int g_map_n;
+/* Every restored space is the same stand-in: the first mapping wins */
+uint64_t vmm_get_physical_addr(vm_space_t* s, uint64_t a) {
+    (void)s;
+    for (int i = 0; i < g_map_n; i++) {
+        if (g_maps[i].virt == a) return g_maps[i].phys;
+    }
+    return 0;
+}
 int vmm_map_page(vm_space_t* s, uint64_t v, uint64_t p, uint32_t f) {
     (void)s;
     if (g_map_n < MAXMAP) { g_maps[g_map_n].virt = v; g_maps[g_map_n].phys = p; g_maps[g_map_n].flags = f; g_map_n++; }
     return 0;
 }
+/* Release the frames restore allocated; aliases share their owner's frame */
+static void free_mapped_frames(void) {
+    for (int i = 0; i < g_map_n; i++) {
+        bool first = true;
+        for (int j = 0; j < i; j++) {
+            if (g_maps[j].phys == g_maps[i].phys) first = false;
+        }
+        if (first) free((void*)(uintptr_t)g_maps[i].phys);
+    }
+    g_map_n = 0;
+}
 struct process;
 int pm_get_process_list(uint32_t* p, uint32_t m, uint32_t* c) {
     (void)p; (void)m; if (c) *c = 0; return 0;
@@ -134,6 +156,39 @@ int main(void) {
     if (irw >= 0) CHECK(memcmp((void*)(uintptr_t)g_maps[irw].phys, rwp, SNAPSHOT_PAGE_SIZE) == 0, "writable page contents restored");
     if (iro >= 0) CHECK(memcmp((void*)(uintptr_t)g_maps[iro].phys, rop, SNAPSHOT_PAGE_SIZE) == 0, "read-only page contents restored");
 
+    /* === 3. One persisted copy, restored into every mapping === */
+    printf("Test 3: alias records restore shared read-only pages\n");
+    checkpoint_alias_page_t aliases;
+    memset(&aliases, 0, sizeof(aliases));
+    aliases.count = 2;
+    aliases.entries[0].pid = 8;
+    aliases.entries[0].virt_addr = RO_VADDR;
+    aliases.entries[1].pid = 9;
+    aliases.entries[1].virt_addr = RO_VADDR;
+    uint8_t alias_page[SNAPSHOT_PAGE_SIZE];
+    memset(alias_page, 0, sizeof(alias_page));
+    memcpy(alias_page, &aliases, sizeof(aliases));
+
+    snapshot_store_begin(&store, 4, &w);
+    snapshot_writer_add_page(&w, 7, RO_VADDR, CHECKPOINT_REC_READONLY, rop);
+    snapshot_writer_add_page(&w, 7, RO_VADDR, CHECKPOINT_REC_READONLY | CHECKPOINT_REC_ALIAS,
+                             alias_page);
+    snapshot_store_commit(&w);
+
+    checkpoint_init();
+    free_mapped_frames();
+    restored = checkpoint_restore_boot(&store);
+    CHECK(restored >= 0, "restore with an alias record succeeds");
+    CHECK(g_map_n == 3, "page mapped for its owner and both aliases");
+    bool all_ro = g_map_n == 3, all_same = g_map_n == 3;
+    for (int i = 0; i < g_map_n; i++) {
+        if (g_maps[i].virt != RO_VADDR || (g_maps[i].flags & PAGE_WRITABLE)) all_ro = false;
+        if (memcmp((void*)(uintptr_t)g_maps[i].phys, rop, SNAPSHOT_PAGE_SIZE) != 0) all_same = false;
+    }
+    CHECK(all_ro, "every mapping is read-only at the shared address");
+    CHECK(all_same, "every mapping holds the persisted contents");
+    free_mapped_frames();
+
     printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
            failures, failures == 1 ? "" : "s");
     return failures ? 1 : 0;
@@ -34,6 +34,8 @@ pte_t* vmm_get_page_table(vm_space_t* s, uint64_t a, int l, bool c) {
 }
 vm_space_t* vmm_get_current_space(void) { return 0; }
 void vmm_flush_tlb_page(uint64_t a) { (void)a; }
+int vmm_unshare_page_table(vm_space_t* s, uint64_t a) { (void)s; (void)a; return 0; }
+uint32_t vmm_frame_ref_count(uint64_t p) { (void)p; return 1; }
 uint64_t vmm_get_physical_addr(vm_space_t* s, uint64_t a) { (void)s; (void)a; return 0; }
 vm_space_t* vmm_create_address_space(uint32_t pid) { (void)pid; return 0; }
 uint64_t vmm_alloc_page(void) { return 0; }
@@ -0,0 +1,207 @@
+/* Host-side unit test for the dentry cache.
+ *
+ * Verifies:
+ *   1. A cached name is found under its own parent only, by exact length;
+ *      the hit takes a reference.
+ *   2. 5000 names in one directory stay in short hash chains.
+ *   3. A negative entry answers the lookup and is counted as such.
+ *   4. Unused entries past max_unused are evicted coldest first; an entry
+ *      looked up again leaves the LRU and survives.
+ *   5. A directory with cached children is never evicted before them;
+ *      removing an entry drops its parent reference; shrink empties the LRU.
+ *
+ * Build: gcc -I../include -o test_dcache test_dcache.c ../kernel/dcache.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+typedef __SIZE_TYPE__ size_t;
+extern int printf(const char*, ...);
+extern int snprintf(char*, size_t, const char*, ...);
+extern void* malloc(size_t);
+extern void free(void*);
+extern size_t strlen(const char*);
+
+#include "dcache.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+/* ---- Entries embedded in plain nodes, as the VFS embeds them in dentries ---- */
+typedef struct node {
+    dcache_entry_t entry;               /* First member: the entry is the node */
+    char name[32];
+    int evict_order;                    /* 0 = still cached */
+} node_t;
+
+static int evict_count;
+static void sim_evict(void* ctx, dcache_entry_t* entry) {
+    (void)ctx;
+    ((node_t*)entry)->evict_order = ++evict_count;
+}
+
+static int live_allocs;
+static void* sim_alloc(size_t n) { live_allocs++; return malloc(n); }
+static void sim_free(void* p) { live_allocs--; free(p); }
+
+static const dcache_ops_t ops = { sim_evict, sim_alloc, sim_free, 0 };
+
+static void node_init(node_t* n, const char* name) {
+    snprintf(n->name, sizeof(n->name), "%s", name);
+    n->evict_order = 0;
+    dcache_entry_init(&n->entry, n->name, (uint32_t)strlen(n->name));
+}
+
+/* Cache `n` under `parent`, keeping the caller's reference */
+static void add(dcache_t* dc, node_t* parent, node_t* n, bool negative) {
+    dcache_entry_t* p = parent ? &parent->entry : NULL;
+    dcache_add(dc, p, &n->entry, dcache_hash(p, n->name, n->entry.len), negative);
+}
+
+static node_t* lookup(dcache_t* dc, node_t* parent, const char* name, uint32_t len) {
+    dcache_entry_t* p = parent ? &parent->entry : NULL;
+    return (node_t*)dcache_lookup(dc, p, name, len, dcache_hash(p, name, len));
+}
+
+int main(void) {
+    printf("=== dentry cache unit test ===\n");
+
+    /* --- 1. Keys --- */
+    {
+        dcache_t dc;
+        dcache_init(&dc, &ops, 64, 100);
+        node_t root, etc, bin, etc_bin;
+        node_init(&root, "/");
+        node_init(&etc, "etc");
+        node_init(&bin, "bin");
+        node_init(&etc_bin, "bin");
+        add(&dc, &root, &etc, false);
+        add(&dc, &root, &bin, false);
+        add(&dc, &etc, &etc_bin, false);
+
+        /* Components are matched in place: "bin/ls" is not terminated after "bin" */
+        const char* path = "bin/ls";
+        node_t* got = lookup(&dc, &root, path, 3);
+        CHECK(got == &bin && bin.entry.refs == 2, "found in place, with a reference taken");
+        CHECK(lookup(&dc, &etc, "bin", 3) == &etc_bin, "the same name under another parent is another entry");
+        CHECK(lookup(&dc, &root, "bi", 2) == NULL && lookup(&dc, &root, "bins", 4) == NULL,
+              "prefixes and longer names miss");
+        CHECK(dc.stats.hits == 2 && dc.stats.misses == 2, "hits and misses counted");
+        CHECK(root.entry.refs == 3 && etc.entry.refs == 2, "children hold their parent");
+        dcache_destroy(&dc);
+    }
+
+    /* --- 2. A large directory --- */
+    {
+        dcache_t dc;
+        dcache_init(&dc, &ops, DCACHE_DEFAULT_BUCKETS, 10000);
+        static node_t files[5000];
+        node_t dir;
+        node_init(&dir, "big");
+        char name[32];
+        for (int i = 0; i < 5000; i++) {
+            snprintf(name, sizeof(name), "file%04d.o", i);
+            node_init(&files[i], name);
+            add(&dc, &dir, &files[i], false);
+        }
+
+        bool all = true;
+        for (int i = 0; i < 5000; i++) {
+            snprintf(name, sizeof(name), "file%04d.o", i);
+            if (lookup(&dc, &dir, name, (uint32_t)strlen(name)) != &files[i]) all = false;
+        }
+        uint32_t longest = 0;
+        for (uint32_t b = 0; b <= dc.mask; b++) {
+            uint32_t len = 0;
+            for (dcache_entry_t* e = dc.buckets[b]; e; e = e->hash_next) len++;
+            if (len > longest) longest = len;
+        }
+        printf("  5000 names over %u buckets: longest chain %u\n", dc.mask + 1, longest);
+        CHECK(all, "every name found");
+        CHECK(longest <= 16, "chains stay short");
+        dcache_destroy(&dc);
+    }
+
+    /* --- 3. Negative entries --- */
+    {
+        dcache_t dc;
+        dcache_init(&dc, &ops, 64, 100);
+        node_t root, missing;
+        node_init(&root, "/");
+        node_init(&missing, "cc");
+        add(&dc, &root, &missing, true);
+        dcache_put(&dc, &missing.entry);
+
+        node_t* got = lookup(&dc, &root, "cc", 2);
+        CHECK(got == &missing && got->entry.negative, "a missing name is answered from the cache");
+        CHECK(dc.stats.negative_hits == 1, "negative hit counted");
+        dcache_destroy(&dc);
+    }
+
+    /* --- 4. LRU eviction --- */
+    {
+        dcache_t dc;
+        dcache_init(&dc, &ops, 64, 4);
+        evict_count = 0;
+        node_t root, n[10];
+        node_init(&root, "/");
+        char name[8];
+        for (int i = 0; i < 10; i++) {
+            snprintf(name, sizeof(name), "n%d", i);
+            node_init(&n[i], name);
+            add(&dc, &root, &n[i], false);
+        }
+
+        /* n[0] stays in use; the rest are released in order */
+        for (int i = 1; i < 10; i++) {
+            dcache_put(&dc, &n[i].entry);
+            if (i == 3) {
+                lookup(&dc, &root, "n1", 2);  /* Back in use */
+            }
+        }
+        CHECK(dc.nr_unused == 4 && evict_count == 4, "unused entries held to max_unused");
+        CHECK(n[2].evict_order == 1 && n[3].evict_order == 2 && n[4].evict_order == 3,
+              "coldest evicted first");
+        CHECK(n[0].evict_order == 0 && n[1].evict_order == 0, "entries in use are never evicted");
+        CHECK(lookup(&dc, &root, "n2", 2) == NULL && dc.nr_entries == 6,
+              "evicted names are gone from the table");
+        dcache_destroy(&dc);
+    }
+
+    /* --- 5. Parents, removal, shrink --- */
+    {
+        dcache_t dc;
+        dcache_init(&dc, &ops, 64, 100);
+        evict_count = 0;
+        node_t root, dir, a, b;
+        node_init(&root, "/");
+        node_init(&dir, "usr");
+        node_init(&a, "a");
+        node_init(&b, "b");
+        add(&dc, &root, &dir, false);
+        add(&dc, &dir, &a, false);
+        add(&dc, &dir, &b, false);
+        dcache_put(&dc, &dir.entry);
+        CHECK(dc.nr_unused == 0, "a directory with cached children is not on the LRU");
+
+        dcache_remove(&dc, &b.entry);
+        CHECK(dir.entry.refs == 1 && lookup(&dc, &dir, "b", 1) == NULL,
+              "removal unhashes and drops the parent reference");
+
+        dcache_put(&dc, &a.entry);
+        uint32_t evicted = dcache_shrink(&dc, 100);
+        CHECK(evicted == 2 && a.evict_order == 1 && dir.evict_order == 2,
+              "shrink evicts the child, then the directory it freed");
+        CHECK(root.entry.refs == 1 && dc.nr_entries == 0 && dc.nr_unused == 0,
+              "the cache is empty and the root unpinned");
+        dcache_destroy(&dc);
+        CHECK(live_allocs == 0, "nothing leaked");
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
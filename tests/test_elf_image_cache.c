@@ -0,0 +1,278 @@
+/* Host-side unit test for the shared ELF image cache.
+ *
+ * Verifies:
+ *   1. An executable is parsed into its PT_LOAD segments once; a second load
+ *      by the same key hits without the file, a rewritten file misses.
+ *   2. Pages are filled from the file on first fault, zero past the file
+ *      bytes, and later faults share the same frame with a reference each.
+ *   3. Pure .bss pages are left to the caller; addresses outside the image
+ *      are rejected.
+ *   4. Released images stay cached with their frames; the least recently
+ *      used idle image is evicted past the limit, freeing frames nobody maps
+ *      and leaving mapped ones alive.
+ *   5. Malformed executables are rejected without leaking memory.
+ *   6. Content keys tell identical bytes from changed ones.
+ *   7. Many instances of one binary use one set of text frames.
+ *
+ * Build: gcc -I../include -o test_elf_image_cache test_elf_image_cache.c ../kernel/elf_image_cache.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+typedef __SIZE_TYPE__ size_t;
+extern int printf(const char*, ...);
+extern void* malloc(size_t);
+extern void free(void*);
+extern void* memset(void*, int, size_t);
+extern int memcmp(const void*, const void*, size_t);
+
+#include "elf_image_cache.h"
+#include "elf.h"
+#include "vmm.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+/* ---- Simulated physical memory: frame n lives at phys (n + 1) * PAGE_SIZE ---- */
+#define NFRAMES 512
+static uint8_t frame_mem[NFRAMES][PAGE_SIZE];
+static uint32_t frame_refs[NFRAMES];
+static uint32_t frames_live;
+
+static uint32_t frame_index(uint64_t phys) { return (uint32_t)(phys / PAGE_SIZE) - 1; }
+
+static uint64_t sim_alloc_frame(void) {
+    for (uint32_t i = 0; i < NFRAMES; i++) {
+        if (frame_refs[i] == 0) {
+            frame_refs[i] = 1;
+            frames_live++;
+            memset(frame_mem[i], 0, PAGE_SIZE);
+            return (uint64_t)(i + 1) * PAGE_SIZE;
+        }
+    }
+    return 0;
+}
+static void sim_get_frame(uint64_t phys) { frame_refs[frame_index(phys)]++; }
+static void sim_put_frame(uint64_t phys) {
+    if (--frame_refs[frame_index(phys)] == 0) frames_live--;
+}
+static void* sim_frame_ptr(uint64_t phys) { return frame_mem[frame_index(phys)]; }
+
+static int live_allocs;
+static void* sim_alloc(size_t n) { live_allocs++; return malloc(n); }
+static void sim_free(void* p) { live_allocs--; free(p); }
+
+static const elf_image_ops_t ops = {
+    sim_alloc_frame, sim_get_frame, sim_put_frame, sim_frame_ptr, sim_alloc, sim_free
+};
+
+/* ---- Test executable: text (3 pages) and data (1 page of file, then .bss) ---- */
+#define TEXT_VADDR  0x400000ULL
+#define TEXT_SIZE   0x2100ULL
+#define DATA_VADDR  0x403000ULL
+#define DATA_OFF    0x3000ULL
+#define DATA_FILESZ 0x800ULL
+#define DATA_MEMSZ  0x2800ULL
+#define FILE_SIZE   (DATA_OFF + DATA_FILESZ)
+
+static uint8_t file[FILE_SIZE];
+
+static void build_file(uint8_t seed) {
+    memset(file, 0, sizeof(file));
+    for (uint64_t i = 0; i < FILE_SIZE; i++) file[i] = (uint8_t)(i * 7 + seed);
+
+    elf64_header_t* h = (elf64_header_t*)file;
+    memset(h, 0, sizeof(*h));
+    h->e_ident[0] = 0x7F; h->e_ident[1] = 'E'; h->e_ident[2] = 'L'; h->e_ident[3] = 'F';
+    h->e_ident[4] = ELF_CLASS_64;
+    h->e_ident[5] = ELF_DATA_LSB;
+    h->e_type = ELF_TYPE_EXEC;
+    h->e_machine = ELF_MACHINE_X86_64;
+    h->e_version = ELF_VERSION_CURRENT;
+    h->e_entry = TEXT_VADDR + 0x100;
+    h->e_phoff = sizeof(elf64_header_t);
+    h->e_phentsize = sizeof(elf64_program_header_t);
+    h->e_phnum = 2;
+
+    elf64_program_header_t* ph = (elf64_program_header_t*)(file + h->e_phoff);
+    memset(ph, 0, 2 * sizeof(*ph));
+    ph[0].p_type = PT_LOAD; ph[0].p_flags = PF_R | PF_X;
+    ph[0].p_offset = 0; ph[0].p_vaddr = TEXT_VADDR;
+    ph[0].p_filesz = TEXT_SIZE; ph[0].p_memsz = TEXT_SIZE;
+    ph[1].p_type = PT_LOAD; ph[1].p_flags = PF_R | PF_W;
+    ph[1].p_offset = DATA_OFF; ph[1].p_vaddr = DATA_VADDR;
+    ph[1].p_filesz = DATA_FILESZ; ph[1].p_memsz = DATA_MEMSZ;
+}
+
+static elf_image_key_t key_for(uint64_t ino, uint64_t mtime) {
+    elf_image_key_t k = { 1, ino, mtime, FILE_SIZE };
+    return k;
+}
+
+static elf_image_cache_t cache;
+
+int main(void) {
+    printf("=== ELF image cache unit test ===\n");
+    build_file(3);
+    elf_image_cache_init(&cache, &ops);
+
+    /* --- 1. Parse once, hit by key --- */
+    elf_image_t* a = 0;
+    elf_image_t* b = 0;
+    elf_image_key_t k1 = key_for(42, 1000);
+    {
+        CHECK(elf_image_acquire(&cache, &k1, file, FILE_SIZE, &a) == ELF_IMAGE_OK && a,
+              "first load parses the file");
+        CHECK(a->segment_count == 2 && a->entry == TEXT_VADDR + 0x100, "segments and entry recorded");
+        CHECK(a->segments[0].page_count == 3 && a->segments[1].page_count == 3,
+              "segment page counts cover memsz");
+        CHECK(elf_image_acquire(&cache, &k1, 0, 0, &b) == ELF_IMAGE_OK && b == a && a->users == 2,
+              "same key hits without the file");
+
+        elf_image_key_t k2 = key_for(42, 1001);
+        elf_image_t* c = 0;
+        CHECK(elf_image_acquire(&cache, &k2, 0, 0, &c) == ELF_IMAGE_EFAULT,
+              "rewritten file misses when not supplied");
+        CHECK(cache.stats.hits == 1 && cache.stats.misses == 1, "hit and miss counted");
+    }
+
+    /* --- 2. Fill on first fault, share afterwards --- */
+    uint64_t t0 = 0, t0b = 0, t2 = 0, d0 = 0;
+    {
+        CHECK(elf_image_page(&cache, a, TEXT_VADDR + 0x123, &t0) == ELF_IMAGE_OK && t0,
+              "text page filled on first fault");
+        CHECK(memcmp(sim_frame_ptr(t0), file, PAGE_SIZE) == 0, "holds the file bytes");
+        CHECK(elf_image_page(&cache, a, TEXT_VADDR, &t0b) == ELF_IMAGE_OK && t0b == t0,
+              "second fault shares the frame");
+        CHECK(frame_refs[frame_index(t0)] == 3, "cache plus one reference per mapping");
+        CHECK(cache.stats.page_fills == 1 && cache.stats.page_shares == 1, "fill and share counted");
+
+        elf_image_page(&cache, a, TEXT_VADDR + 2 * PAGE_SIZE, &t2);
+        uint8_t* p = (uint8_t*)sim_frame_ptr(t2);
+        bool tail_zero = true;
+        for (uint64_t i = TEXT_SIZE - 2 * PAGE_SIZE; i < PAGE_SIZE; i++) if (p[i]) tail_zero = false;
+        CHECK(memcmp(p, file + 2 * PAGE_SIZE, TEXT_SIZE - 2 * PAGE_SIZE) == 0 && tail_zero,
+              "last text page: file bytes then zeros");
+
+        elf_image_page(&cache, a, DATA_VADDR, &d0);
+        p = (uint8_t*)sim_frame_ptr(d0);
+        CHECK(memcmp(p, file + DATA_OFF, DATA_FILESZ) == 0 && p[DATA_FILESZ] == 0 &&
+              p[PAGE_SIZE - 1] == 0, "data page: file bytes then .bss zeros");
+    }
+
+    /* --- 3. Pure .bss and outside addresses --- */
+    {
+        uint64_t phys = 123;
+        CHECK(elf_image_page(&cache, a, DATA_VADDR + PAGE_SIZE, &phys) == ELF_IMAGE_OK && phys == 0,
+              "pure .bss page left to the caller");
+        CHECK(elf_image_page(&cache, a, DATA_VADDR + 3 * PAGE_SIZE, &phys) == ELF_IMAGE_EFAULT,
+              "address past the image rejected");
+        CHECK(elf_image_segment_at(a, TEXT_VADDR - 1) == 0, "address before the image has no segment");
+    }
+
+    /* --- 4. Idle list and eviction --- */
+    {
+        /* Drop the mappings made above except t0's first, then both users */
+        sim_put_frame(t0b); sim_put_frame(t2); sim_put_frame(d0);
+        elf_image_release(&cache, a);
+        elf_image_release(&cache, b);
+        CHECK(a->users == 0 && cache.idle_count == 1, "unused image parked on the idle list");
+
+        elf_image_t* again = 0;
+        uint64_t fills = cache.stats.page_fills, phys = 0;
+        elf_image_acquire(&cache, &k1, 0, 0, &again);
+        elf_image_page(&cache, again, TEXT_VADDR + 2 * PAGE_SIZE, &phys);
+        CHECK(again == a && cache.idle_count == 0 && cache.stats.page_fills == fills && phys == t2,
+              "revived image keeps its frames");
+        sim_put_frame(phys);
+        elf_image_release(&cache, again);
+
+        /* Fill the idle list past its limit with other images */
+        for (uint32_t i = 0; i < ELF_IMAGE_CACHE_MAX_IDLE; i++) {
+            elf_image_key_t k = key_for(100 + i, 0);
+            elf_image_t* img = 0;
+            elf_image_acquire(&cache, &k, file, FILE_SIZE, &img);
+            elf_image_release(&cache, img);
+        }
+        CHECK(cache.stats.evictions == 1 && cache.idle_count == ELF_IMAGE_CACHE_MAX_IDLE,
+              "least recently used idle image evicted");
+        CHECK(elf_image_acquire(&cache, &k1, 0, 0, &again) == ELF_IMAGE_EFAULT,
+              "evicted image is gone");
+        CHECK(frame_refs[frame_index(t0)] == 1 && frame_refs[frame_index(t2)] == 0,
+              "mapped frame survives eviction, unmapped one is freed");
+        sim_put_frame(t0);
+
+        elf_image_cache_shrink(&cache);
+        CHECK(cache.image_count == 0 && frames_live == 0 && live_allocs == 0,
+              "shrink frees every idle image");
+    }
+
+    /* --- 5. Malformed executables --- */
+    {
+        elf_image_t* img = 0;
+        elf_image_key_t k = key_for(7, 0);
+
+        file[0] = 0;
+        CHECK(elf_image_acquire(&cache, &k, file, FILE_SIZE, &img) == ELF_IMAGE_ENOEXEC, "bad magic");
+        build_file(3);
+
+        elf64_program_header_t* ph = (elf64_program_header_t*)(file + sizeof(elf64_header_t));
+        ph[1].p_filesz = FILE_SIZE;
+        CHECK(elf_image_acquire(&cache, &k, file, FILE_SIZE, &img) == ELF_IMAGE_ENOEXEC,
+              "segment past end of file");
+        ph[1].p_filesz = DATA_MEMSZ + 1;
+        ph[1].p_offset = 0;
+        CHECK(elf_image_acquire(&cache, &k, file, FILE_SIZE, &img) == ELF_IMAGE_ENOEXEC,
+              "filesz larger than memsz");
+        build_file(3);
+
+        CHECK(elf_image_acquire(&cache, &k, file, 16, &img) == ELF_IMAGE_ENOEXEC, "truncated header");
+        CHECK(cache.image_count == 0 && live_allocs == 0, "nothing cached or leaked");
+    }
+
+    /* --- 6. Content keys --- */
+    {
+        elf_image_key_t x, y, z;
+        elf_image_key_from_data(&x, file, FILE_SIZE);
+        elf_image_key_from_data(&y, file, FILE_SIZE);
+        file[FILE_SIZE - 1] ^= 1;
+        elf_image_key_from_data(&z, file, FILE_SIZE);
+        file[FILE_SIZE - 1] ^= 1;
+        CHECK(x.dev == ELF_IMAGE_DEV_ANON && x.ino == y.ino && x.size == FILE_SIZE,
+              "identical bytes give the same key");
+        CHECK(x.ino != z.ino, "a changed byte gives another key");
+    }
+
+    /* --- 7. Many instances, one copy of the text --- */
+    {
+        enum { INSTANCES = 100 };
+        static elf_image_t* inst[INSTANCES];
+        static uint64_t maps[INSTANCES][3];
+        elf_image_key_t k = key_for(9, 9);
+        bool shared = true;
+
+        for (int i = 0; i < INSTANCES; i++) {
+            elf_image_acquire(&cache, &k, i == 0 ? file : 0, i == 0 ? FILE_SIZE : 0, &inst[i]);
+            for (int p = 0; p < 3; p++) {
+                elf_image_page(&cache, inst[i], TEXT_VADDR + (uint64_t)p * PAGE_SIZE, &maps[i][p]);
+                if (maps[i][p] != maps[0][p]) shared = false;
+            }
+        }
+        CHECK(shared && frames_live == 3, "100 instances map the same 3 text frames");
+        CHECK(cache.stats.misses == 18, "parsed once for all of them");
+
+        for (int i = 0; i < INSTANCES; i++) {
+            for (int p = 0; p < 3; p++) sim_put_frame(maps[i][p]);
+            elf_image_release(&cache, inst[i]);
+        }
+        elf_image_cache_shrink(&cache);
+        CHECK(frames_live == 0 && live_allocs == 0, "everything released");
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,215 @@
+/* Host-side unit test for the ext2 block map.
+ *
+ * Verifies:
+ *   1. Blocks on every side of the direct / indirect / double / triple
+ *      boundaries are allocated with the right pointer blocks, map back to
+ *      the same disk blocks when walked again from disk, and blocks past the
+ *      triple indirect range are refused.
+ *   2. Holes read as 0 and allocate nothing; new pointer blocks reach the
+ *      disk zeroed; i_block_dirty is set only when the inode's own pointers
+ *      change.
+ *   3. A large, mostly contiguous file maps in one lookup per run, reading
+ *      each pointer block once; a second pass is answered from the runs.
+ *   4. Lookups under the same pointer block share one disk read, and
+ *      invalidating frees everything.
+ *
+ * Build: gcc -I../include -o test_ext2_blockmap test_ext2_blockmap.c ../kernel/ext2_blockmap.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+typedef __SIZE_TYPE__ size_t;
+extern int printf(const char*, ...);
+extern void* malloc(size_t);
+extern void free(void*);
+
+#include "ext2_blockmap.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+/* ---- Sparse in-memory disk of 1 KiB blocks (256 pointers per block) ---- */
+#define BLOCK_SIZE 1024
+#define NBLOCKS (1u << 20)
+static uint8_t* disk[NBLOCKS];
+static uint8_t used[NBLOCKS];
+static uint32_t next_free = 100;
+static uint32_t disk_reads, disk_writes;
+
+static int sim_read(void* ctx, uint32_t block, void* buffer) {
+    (void)ctx;
+    uint8_t* b = (uint8_t*)buffer;
+    disk_reads++;
+    for (uint32_t i = 0; i < BLOCK_SIZE; i++) b[i] = disk[block] ? disk[block][i] : 0xEE;
+    return 0;
+}
+
+static int sim_write(void* ctx, uint32_t block, const void* buffer) {
+    (void)ctx;
+    const uint8_t* b = (const uint8_t*)buffer;
+    disk_writes++;
+    if (!disk[block]) disk[block] = (uint8_t*)malloc(BLOCK_SIZE);
+    for (uint32_t i = 0; i < BLOCK_SIZE; i++) disk[block][i] = b[i];
+    return 0;
+}
+
+/* The goal if it is free, else the next free block */
+static uint32_t sim_alloc_block(void* ctx, uint32_t goal) {
+    (void)ctx;
+    uint32_t b = (goal && goal < NBLOCKS && !used[goal]) ? goal : next_free;
+    while (b < NBLOCKS && used[b]) b++;
+    if (b >= NBLOCKS) return 0;
+    used[b] = 1;
+    if (b >= next_free) next_free = b + 1;
+    return b;
+}
+
+static int live_allocs;
+static void* sim_alloc(size_t n) { live_allocs++; return malloc(n); }
+static void sim_free(void* p) { live_allocs--; free(p); }
+
+static const ext2_blockmap_ops_t ops = { sim_read, sim_write, sim_alloc_block, sim_alloc, sim_free, 0 };
+
+static uint32_t map1(ext2_blockmap_t* m, uint64_t fb, bool create, int* rc) {
+    uint32_t disk_block, run;
+    *rc = ext2_blockmap_map(m, &ops, fb, 1, create, &disk_block, &run);
+    return disk_block;
+}
+
+int main(void) {
+    printf("=== ext2 block map unit test ===\n");
+    const uint64_t P = BLOCK_SIZE / 4;
+
+    /* --- 1. Boundaries --- */
+    {
+        uint32_t i_block[15] = { 0 };
+        ext2_blockmap_t m;
+        ext2_blockmap_init(&m, i_block, BLOCK_SIZE);
+
+        uint64_t fbs[] = { 0, 11, 12, 12 + P - 1, 12 + P, 12 + P + P * P - 1,
+                           12 + P + P * P, 12 + P + P * P + P * P * P - 1 };
+        uint32_t got[8];
+        bool ok = true;
+        int rc;
+        for (int i = 0; i < 8; i++) {
+            got[i] = map1(&m, fbs[i], true, &rc);
+            if (rc != EXT2_BLOCKMAP_OK || got[i] == 0) ok = false;
+        }
+        CHECK(ok, "blocks allocated across all four levels");
+        /* Pointer blocks: IND; DIND + 2 children; TIND + 2 children + 2 grandchildren */
+        CHECK(m.stats.allocations == 8 + 1 + 3 + 5, "exactly the pointer blocks the paths need");
+        CHECK(i_block[12] && i_block[13] && i_block[14], "indirect roots set in the inode");
+
+        ext2_blockmap_invalidate(&m, &ops);
+        ok = true;
+        for (int i = 0; i < 8; i++) {
+            if (map1(&m, fbs[i], false, &rc) != got[i] || rc != EXT2_BLOCKMAP_OK) ok = false;
+        }
+        CHECK(ok, "walking again from disk finds the same blocks");
+
+        uint64_t max = ext2_blockmap_max_blocks(BLOCK_SIZE);
+        CHECK(max == 12 + P + P * P + P * P * P, "max blocks for 1 KiB blocks");
+        map1(&m, max, true, &rc);
+        CHECK(rc == EXT2_BLOCKMAP_EFBIG, "past the triple indirect range is refused");
+        ext2_blockmap_invalidate(&m, &ops);
+        CHECK(live_allocs == 0, "invalidate frees the pointer blocks");
+    }
+
+    /* --- 2. Holes, zeroed pointer blocks, inode dirtiness --- */
+    {
+        uint32_t i_block[15] = { 0 };
+        ext2_blockmap_t m;
+        ext2_blockmap_init(&m, i_block, BLOCK_SIZE);
+        int rc;
+
+        CHECK(map1(&m, 500, false, &rc) == 0 && rc == EXT2_BLOCKMAP_OK && m.stats.allocations == 0,
+              "a hole reads as 0 and allocates nothing");
+
+        map1(&m, 20, true, &rc);
+        CHECK(m.i_block_dirty, "new indirect root dirties the inode");
+        m.i_block_dirty = false;
+        map1(&m, 21, true, &rc);
+        CHECK(!m.i_block_dirty, "a new pointer inside the indirect block does not");
+
+        ext2_blockmap_invalidate(&m, &ops);
+        CHECK(map1(&m, 22, false, &rc) == 0 && rc == EXT2_BLOCKMAP_OK,
+              "untouched slots of a new pointer block read back as holes");
+        ext2_blockmap_invalidate(&m, &ops);
+    }
+
+    /* --- 3. Streaming a large file --- */
+    {
+        uint32_t i_block[15] = { 0 };
+        ext2_blockmap_t m;
+        ext2_blockmap_init(&m, i_block, BLOCK_SIZE);
+        const uint32_t nblocks = 4000;
+        static uint32_t expect[4000];
+        int rc;
+
+        bool ok = true;
+        for (uint32_t fb = 0; fb < nblocks; fb++) {
+            expect[fb] = map1(&m, fb, true, &rc);
+            if (!expect[fb]) ok = false;
+        }
+        CHECK(ok, "4000-block file written");
+        ext2_blockmap_invalidate(&m, &ops);
+        m.stats.lookups = m.stats.ind_reads = m.stats.extent_hits = 0;
+
+        uint32_t lookups = 0;
+        ok = true;
+        for (uint32_t fb = 0; fb < nblocks; ) {
+            uint32_t disk_block, run;
+            ext2_blockmap_map(&m, &ops, fb, nblocks - fb, false, &disk_block, &run);
+            for (uint32_t i = 0; i < run && ok; i++) ok = disk_block + i == expect[fb + i];
+            fb += run;
+            lookups++;
+        }
+        printf("  4000 blocks: %u lookups, %llu pointer block reads, %u runs cached\n",
+               lookups, (unsigned long long)m.stats.ind_reads, m.nextents);
+        CHECK(ok, "runs agree with the blocks written");
+        /* One run per pointer block that interrupts the layout */
+        CHECK(lookups <= 20, "one lookup per run instead of per block");
+        CHECK(m.stats.ind_reads <= 18, "each pointer block read once");
+
+        uint64_t reads = m.stats.ind_reads;
+        ok = true;
+        for (uint32_t fb = 0; fb < nblocks && ok; fb += 7) {
+            ok = map1(&m, fb, false, &rc) == expect[fb];
+        }
+        CHECK(ok && m.stats.ind_reads == reads, "second pass served from the runs");
+        ext2_blockmap_invalidate(&m, &ops);
+    }
+
+    /* --- 4. Pointer block cache --- */
+    {
+        uint32_t i_block[15] = { 0 };
+        ext2_blockmap_t m;
+        ext2_blockmap_init(&m, i_block, BLOCK_SIZE);
+        int rc;
+
+        /* Scattered blocks under one double indirect child */
+        uint64_t base = 12 + P + 3 * P;
+        for (uint64_t i = 0; i < P; i += 16) {
+            next_free += 5;  /* Break contiguity */
+            map1(&m, base + i, true, &rc);
+        }
+        ext2_blockmap_invalidate(&m, &ops);
+        disk_reads = 0;
+        for (uint64_t i = P - 16; ; i -= 16) {
+            map1(&m, base + i, false, &rc);
+            if (i == 0) break;
+        }
+        CHECK(disk_reads == 2, "16 lookups read the double indirect block and its child once");
+        ext2_blockmap_invalidate(&m, &ops);
+        CHECK(live_allocs == 0, "nothing leaked");
+    }
+
+    for (uint32_t i = 0; i < NBLOCKS; i++) free(disk[i]);
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
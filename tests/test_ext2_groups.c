@@ -0,0 +1,291 @@
+/* Host-side unit test for the ext2 group allocator.
+ *
+ * Verifies:
+ *   1. Successive allocations with the previous block + 1 as goal come out
+ *      contiguous; a taken goal falls to the next free block nearby, and
+ *      past the near scan to the start of a free 8-block run.
+ *   2. A full group spills into the next one, wrapping around, and nothing
+ *      is handed out past the end of a short last group.
+ *   3. Two files appending in turn get runs of blocks from their
+ *      preallocation windows instead of alternating blocks; discarding a
+ *      window gives its blocks back.
+ *   4. Files land in their directory's group, or one found by probing from
+ *      it; new directories go to the emptiest group; reserved inodes are
+ *      never returned.
+ *   5. A full volume returns 0; sync writes only the dirty bitmaps and the
+ *      free counts always match the bitmaps; destroy frees everything.
+ *
+ * Build: gcc -I../include -o test_ext2_groups test_ext2_groups.c ../kernel/ext2_groups.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+typedef __SIZE_TYPE__ size_t;
+extern int printf(const char*, ...);
+extern void* malloc(size_t);
+extern void free(void*);
+
+#include "ext2_groups.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+/* ---- 1 KiB blocks, 4 groups of 256 blocks, the last one 100 long ---- */
+#define BLOCK_SIZE 1024
+#define BPG 256
+#define IPG 64
+#define NGROUPS 4
+#define FIRST_DATA 1
+#define NBLOCKS (FIRST_DATA + 3 * BPG + 100)
+#define META 10                 /* Bitmaps and inode table at the start of each group */
+
+static uint8_t disk[NBLOCKS][BLOCK_SIZE];
+static uint32_t disk_writes;
+
+static int sim_read(void* ctx, uint32_t block, void* buffer) {
+    (void)ctx;
+    uint8_t* b = (uint8_t*)buffer;
+    for (uint32_t i = 0; i < BLOCK_SIZE; i++) b[i] = disk[block][i];
+    return 0;
+}
+
+static int sim_write(void* ctx, uint32_t block, const void* buffer) {
+    (void)ctx;
+    const uint8_t* b = (const uint8_t*)buffer;
+    disk_writes++;
+    for (uint32_t i = 0; i < BLOCK_SIZE; i++) disk[block][i] = b[i];
+    return 0;
+}
+
+static int live_allocs;
+static void* sim_alloc(size_t n) { live_allocs++; return malloc(n); }
+static void sim_free(void* p) { live_allocs--; free(p); }
+
+static const ext2_groups_ops_t ops = { sim_read, sim_write, sim_alloc, sim_free, 0 };
+
+static uint32_t group_start(uint32_t g) { return FIRST_DATA + g * BPG; }
+static uint32_t group_len(uint32_t g) { return g == NGROUPS - 1 ? 100 : BPG; }
+
+/* Fresh volume: the first META blocks of each group in use, no inodes */
+static void setup(ext2_groups_t* gs) {
+    for (uint32_t b = 0; b < NBLOCKS; b++)
+        for (uint32_t i = 0; i < BLOCK_SIZE; i++) disk[b][i] = 0;
+
+    ext2_groups_geometry_t geo = { BLOCK_SIZE, NBLOCKS, FIRST_DATA, BPG, IPG,
+                                   NGROUPS * IPG, 11, NGROUPS };
+    ext2_groups_init(gs, &geo, &ops);
+    for (uint32_t g = 0; g < NGROUPS; g++) {
+        uint32_t bb = group_start(g), ib = group_start(g) + 1;
+        disk[bb][0] = 0xFF;
+        disk[bb][1] = 0x03;
+        uint32_t free_inodes = g == 0 ? IPG - 10 : IPG;
+        ext2_groups_set(gs, g, bb, ib, group_len(g) - META, free_inodes, 0);
+    }
+    disk_writes = 0;
+}
+
+static bool disk_bit(uint32_t bitmap_block, uint32_t bit) {
+    return (disk[bitmap_block][bit / 8] >> (bit % 8)) & 1;
+}
+
+/* Free counts agree with the cached bitmaps and with the totals */
+static bool counts_consistent(const ext2_groups_t* gs) {
+    uint32_t total = 0;
+    for (uint32_t g = 0; g < NGROUPS; g++) {
+        const ext2_group_t* grp = &gs->groups[g];
+        if (grp->blocks) {
+            uint32_t used = 0;
+            for (uint32_t b = 0; b < group_len(g); b++) used += (grp->blocks[b / 8] >> (b % 8)) & 1;
+            if (group_len(g) - used != grp->free_blocks) return false;
+        }
+        total += grp->free_blocks;
+    }
+    return total == gs->free_blocks;
+}
+
+int main(void) {
+    printf("=== ext2 group allocator unit test ===\n");
+
+    /* --- 1. Goals --- */
+    {
+        ext2_groups_t gs;
+        setup(&gs);
+
+        uint32_t first = ext2_groups_alloc_block(&gs, NULL, 0);
+        CHECK(first == group_start(0) + META, "no goal: first free block of the volume");
+
+        bool contiguous = true;
+        uint32_t prev = first;
+        for (int i = 0; i < 20; i++) {
+            uint32_t b = ext2_groups_alloc_block(&gs, NULL, prev + 1);
+            if (b != prev + 1) contiguous = false;
+            prev = b;
+        }
+        CHECK(contiguous && gs.stats.goal_hits == 20, "previous block + 1 keeps a file contiguous");
+
+        CHECK(ext2_groups_alloc_block(&gs, NULL, first) == prev + 1,
+              "a taken goal falls to the next free block nearby");
+
+        /* Group 1: bits META..99 taken except bit 90, beyond the near scan */
+        uint32_t base = group_start(1);
+        for (uint32_t bit = META; bit < 100; bit++) ext2_groups_alloc_block(&gs, NULL, base + bit);
+        ext2_groups_free_block(&gs, base + 90);
+        CHECK(ext2_groups_alloc_block(&gs, NULL, base + META) == base + 104,
+              "past the near scan: the start of a free 8-block run");
+        CHECK(ext2_groups_alloc_block(&gs, NULL, base + 100) == base + 100,
+              "the goal itself when free");
+        CHECK(counts_consistent(&gs), "free counts match the bitmaps");
+
+        ext2_groups_destroy(&gs);
+        CHECK(live_allocs == 0, "destroy frees the bitmaps");
+    }
+
+    /* --- 2. Spilling across groups --- */
+    {
+        ext2_groups_t gs;
+        setup(&gs);
+
+        uint32_t last = group_start(NGROUPS - 1);
+        bool in_range = true;
+        for (uint32_t i = 0; i < group_len(NGROUPS - 1) - META; i++) {
+            uint32_t b = ext2_groups_alloc_block(&gs, NULL, last);
+            if (b < last || b >= NBLOCKS) in_range = false;
+        }
+        CHECK(in_range && gs.groups[NGROUPS - 1].free_blocks == 0,
+              "the short last group fills without going past the volume");
+
+        uint32_t b = ext2_groups_alloc_block(&gs, NULL, last + 5);
+        CHECK(b == group_start(0) + 16, "a full group spills into the next, wrapping around, at a free run");
+        CHECK(counts_consistent(&gs), "free counts match the bitmaps");
+        ext2_groups_destroy(&gs);
+    }
+
+    /* --- 3. Preallocation windows --- */
+    {
+        ext2_groups_t gs;
+        setup(&gs);
+
+        ext2_prealloc_t wa = { 0, 0 }, wb = { 0, 0 };
+        uint32_t goal = group_start(2) + META;
+        uint32_t a[18], b[18];
+        a[0] = ext2_groups_alloc_block(&gs, &wa, goal);
+        b[0] = ext2_groups_alloc_block(&gs, &wb, goal);
+        for (int i = 1; i < 18; i++) {
+            a[i] = ext2_groups_alloc_block(&gs, &wa, a[i - 1] + 1);
+            b[i] = ext2_groups_alloc_block(&gs, &wb, b[i - 1] + 1);
+        }
+
+        uint32_t runs_a = 1, runs_b = 1;
+        for (int i = 1; i < 18; i++) {
+            if (a[i] != a[i - 1] + 1) runs_a++;
+            if (b[i] != b[i - 1] + 1) runs_b++;
+        }
+        printf("  18 interleaved appends each: %u and %u runs\n", runs_a, runs_b);
+        CHECK(runs_a <= 2 && runs_b <= 2, "interleaved appenders get runs, not alternating blocks");
+        CHECK(gs.stats.prealloc_hits >= 32, "appends served from the windows");
+
+        ext2_groups_alloc_block(&gs, &wa, a[17] + 1);
+        uint32_t free_before = gs.free_blocks;
+        uint32_t held = wa.count + wb.count;
+        ext2_groups_discard(&gs, &wa);
+        ext2_groups_discard(&gs, &wb);
+        CHECK(held > 0 && gs.free_blocks == free_before + held && wa.count == 0,
+              "discarding gives the window back");
+        CHECK(counts_consistent(&gs), "free counts match the bitmaps");
+
+        /* Allocating elsewhere drops the old window */
+        ext2_prealloc_t wc = { 0, 0 };
+        uint32_t c = ext2_groups_alloc_block(&gs, &wc, group_start(1) + 50);
+        free_before = gs.free_blocks;
+        held = wc.count;
+        ext2_groups_alloc_block(&gs, &wc, group_start(0) + 50);
+        CHECK(c == group_start(1) + 50 && gs.free_blocks == free_before + held - 1 - wc.count,
+              "a seek releases the window before reserving a new one");
+        ext2_groups_discard(&gs, &wc);
+        CHECK(counts_consistent(&gs), "free counts match the bitmaps");
+
+        /* A sync while windows are held writes only the blocks in use */
+        ext2_prealloc_t wd = { 0, 0 };
+        free_before = gs.free_blocks;
+        ext2_groups_alloc_block(&gs, &wd, group_start(3) + 50);
+        held = wd.count;
+        CHECK(ext2_groups_sync(&gs) == EXT2_GROUPS_OK, "sync with a window held");
+        CHECK(held > 0 && wd.count == 0 && !wd.listed && gs.windows == NULL &&
+              gs.free_blocks == free_before - 1,
+              "sync gives every window back first");
+        CHECK(counts_consistent(&gs), "free counts match the bitmaps");
+        ext2_groups_discard(&gs, &wd);
+        ext2_groups_destroy(&gs);
+    }
+
+    /* --- 4. Inode placement --- */
+    {
+        ext2_groups_t gs;
+        setup(&gs);
+
+        uint32_t ino = ext2_groups_alloc_inode(&gs, 2, false);
+        CHECK(ino == 11, "first inode after the reserved ones");
+
+        uint32_t parent = 2 * IPG + 5;
+        ino = ext2_groups_alloc_inode(&gs, parent, false);
+        CHECK((ino - 1) / IPG == 2, "a file goes into its directory's group");
+
+        /* Group 0 is the only one using blocks */
+        for (int i = 0; i < 30; i++) ext2_groups_alloc_block(&gs, NULL, group_start(0));
+        ino = ext2_groups_alloc_inode(&gs, 2, true);
+        CHECK((ino - 1) / IPG == 1 && gs.groups[1].used_dirs == 1,
+              "a directory goes to the group with the most free blocks");
+
+        /* Fill group 2's inodes: the next file probes to group 3 */
+        while (gs.groups[2].free_inodes > 0) ext2_groups_alloc_inode(&gs, parent, false);
+        ino = ext2_groups_alloc_inode(&gs, parent, false);
+        CHECK((ino - 1) / IPG == 3, "a full group probes onward");
+
+        ext2_groups_free_inode(&gs, ino, false);
+        ext2_groups_free_inode(&gs, 3, false);
+        CHECK(gs.groups[3].free_inodes == IPG && gs.groups[0].free_inodes == IPG - 10 - 1,
+              "freeing returns the inode; reserved inodes are left alone");
+        ext2_groups_destroy(&gs);
+    }
+
+    /* --- 5. Full volume, writeback --- */
+    {
+        ext2_groups_t gs;
+        setup(&gs);
+
+        uint32_t total = gs.free_blocks, got = 0;
+        bool in_range = true;
+        for (;;) {
+            uint32_t b = ext2_groups_alloc_block(&gs, NULL, got * 37 % NBLOCKS);
+            if (b == 0) break;
+            if (b < FIRST_DATA || b >= NBLOCKS) in_range = false;
+            got++;
+        }
+        CHECK(got == total && in_range && gs.free_blocks == 0, "every free block handed out once, then 0");
+
+        uint32_t inodes = 0;
+        while (ext2_groups_alloc_inode(&gs, 2, false)) inodes++;
+        CHECK(inodes == NGROUPS * IPG - 10, "every free inode handed out once, then 0");
+        ext2_groups_destroy(&gs);
+
+        setup(&gs);
+        uint32_t b = ext2_groups_alloc_block(&gs, NULL, group_start(1) + 20);
+        ext2_groups_sync(&gs);
+        CHECK(gs.stats.bitmap_writes == 1 && disk_writes == 1, "sync writes only the dirty bitmap");
+        CHECK(disk_bit(group_start(1), b - group_start(1)), "the allocation reached the disk bitmap");
+        CHECK(gs.groups[1].counts_dirty && !gs.groups[0].counts_dirty,
+              "counts_dirty flags the descriptor to update");
+
+        ext2_groups_sync(&gs);
+        CHECK(disk_writes == 1, "a clean sync writes nothing");
+        ext2_groups_destroy(&gs);
+        CHECK(live_allocs == 0, "nothing leaked");
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,300 @@
+/* Host-side unit test for FAT cluster allocation and FAT writeback.
+ *
+ * Verifies:
+ *   1. Bitmap set/clear/test keep an exact count; run iteration finds each
+ *      run of set bits once, across word boundaries.
+ *   2. Next-fit search starts at the hint, wraps once, prefers the first run
+ *      long enough and otherwise returns the longest one.
+ *   3. On a mounted FAT16 image, the free map matches the table, and
+ *      fat_find_free_cluster() serves consecutive clusters.
+ *   4. fat_allocate_cluster_chain() builds one contiguous run when it can,
+ *      links across used clusters when it cannot, appends to a chain, and
+ *      refuses requests larger than the free space; fat_free_cluster_chain()
+ *      returns every cluster.
+ *   5. Sync writes only the changed FAT sectors, merged into runs, to every
+ *      FAT copy, and the on-disk copies end up identical to the cache.
+ *
+ * Build: gcc -I../include -o test_fat_bitmap test_fat_bitmap.c \
+ *            ../kernel/fat_bitmap.c ../kernel/fat.c ../kernel/fat_extent.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+typedef __SIZE_TYPE__ size_t;
+extern int printf(const char*, ...);
+extern void* malloc(size_t);
+extern void free(void*);
+
+#include "fat.h"
+#include "fat_bitmap.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+/* ---- Kernel and VFS pieces fat.c links against ---- */
+void* kmalloc(size_t size) { return malloc(size); }
+void kfree(void* ptr) { free(ptr); }
+int vfs_register_filesystem(vfs_filesystem_t* fs) { (void)fs; return 0; }
+int vfs_unregister_filesystem(vfs_filesystem_t* fs) { (void)fs; return 0; }
+vfs_inode_t* vfs_alloc_inode(vfs_superblock_t* sb) { (void)sb; return 0; }
+void vfs_free_inode(vfs_inode_t* inode) { (void)inode; }
+vfs_dentry_t* vfs_alloc_dentry(const char* name) { (void)name; return 0; }
+void vfs_free_dentry(vfs_dentry_t* dentry) { (void)dentry; }
+void vfs_inode_set_aops(vfs_inode_t* inode, const page_cache_aops_t* aops) { (void)inode; (void)aops; }
+/* Declared in fat.h and referenced by the inode ops, not yet implemented */
+int fat_rmdir(vfs_inode_t* dir, vfs_dentry_t* dentry) { (void)dir; (void)dentry; return -1; }
+int fat_rename(vfs_inode_t* old_dir, vfs_dentry_t* old_dentry,
+               vfs_inode_t* new_dir, vfs_dentry_t* new_dentry) {
+    (void)old_dir; (void)old_dentry; (void)new_dir; (void)new_dentry; return -1;
+}
+
+/* ---- Simulated disk: reserved sector, two FAT copies, data ---- */
+#define SECTOR      512
+#define RESERVED    1
+#define FAT_SECTORS 32                      /* 8192 FAT16 entries */
+#define CLUSTERS    8000
+#define DISK_SECTORS (RESERVED + 2 * FAT_SECTORS + 16)
+
+static uint8_t disk[DISK_SECTORS][SECTOR];
+static uint32_t write_calls, sectors_written;
+
+static int disk_read(void* dev, uint32_t sector, uint32_t count, void* buffer) {
+    (void)dev;
+    uint8_t* out = (uint8_t*)buffer;
+    for (uint32_t i = 0; i < count; i++) {
+        if (sector + i >= DISK_SECTORS) return FAT_ERROR_IO_ERROR;
+        for (uint32_t b = 0; b < SECTOR; b++) out[i * SECTOR + b] = disk[sector + i][b];
+    }
+    return FAT_SUCCESS;
+}
+
+static int disk_write(void* dev, uint32_t sector, uint32_t count, const void* buffer) {
+    (void)dev;
+    const uint8_t* in = (const uint8_t*)buffer;
+    write_calls++;
+    for (uint32_t i = 0; i < count; i++) {
+        if (sector + i >= DISK_SECTORS) return FAT_ERROR_IO_ERROR;
+        for (uint32_t b = 0; b < SECTOR; b++) disk[sector + i][b] = in[i * SECTOR + b];
+        sectors_written++;
+    }
+    return FAT_SUCCESS;
+}
+
+static fat_block_device_t device = { disk_read, disk_write, SECTOR, DISK_SECTORS, 0, 0, 0 };
+
+static uint16_t disk_entry(int copy, uint32_t cluster) {
+    uint32_t off = cluster * 2;
+    const uint8_t* p = &disk[RESERVED + copy * FAT_SECTORS + off / SECTOR][off % SECTOR];
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void set_disk_entry(uint32_t cluster, uint16_t value) {
+    for (int copy = 0; copy < 2; copy++) {
+        uint32_t off = cluster * 2;
+        uint8_t* p = &disk[RESERVED + copy * FAT_SECTORS + off / SECTOR][off % SECTOR];
+        p[0] = value & 0xFF;
+        p[1] = value >> 8;
+    }
+}
+
+static fat_fs_info_t fs;
+
+static void mount_image(void) {
+    fat_unload_fat_table(&fs);     /* The previous mount's table and map */
+    for (uint32_t s = 0; s < DISK_SECTORS; s++)
+        for (uint32_t b = 0; b < SECTOR; b++) disk[s][b] = 0;
+    set_disk_entry(0, 0xFFF8);
+    set_disk_entry(1, 0xFFFF);
+    /* A few used clusters: 2..9 one file, 100 another, 104 a third */
+    for (uint32_t c = 2; c < 9; c++) set_disk_entry(c, (uint16_t)(c + 1));
+    set_disk_entry(9, 0xFFFF);
+    set_disk_entry(100, 0xFFFF);
+    set_disk_entry(104, 0xFFFF);
+
+    fs = (fat_fs_info_t){0};
+    fs.type = FAT_TYPE_FAT16;
+    fs.sector_size = SECTOR;
+    fs.sectors_per_cluster = 1;
+    fs.cluster_size = SECTOR;
+    fs.reserved_sectors = RESERVED;
+    fs.num_fats = 2;
+    fs.fat_size = FAT_SECTORS;
+    fs.total_clusters = CLUSTERS;
+    fs.block_device = &device;
+    fat_load_fat_table(&fs);
+}
+
+/* Length of the chain from `first`, or 0 if it does not end in EOF */
+static uint32_t chain_length(uint32_t first, bool* contiguous) {
+    uint32_t n = 0, c = first;
+    *contiguous = true;
+    while (c >= 2 && c < CLUSTERS + 2 && n <= CLUSTERS) {
+        n++;
+        uint32_t next = fat_get_cluster_value(&fs, c);
+        if (fat_is_cluster_eof(&fs, next)) return n;
+        if (next != c + 1) *contiguous = false;
+        c = next;
+    }
+    return 0;
+}
+
+int main(void) {
+    printf("=== FAT bitmap and allocation unit test ===\n");
+
+    /* --- 1. Bitmap basics --- */
+    {
+        static uint64_t words[FAT_BITMAP_WORDS(200)];
+        fat_bitmap_t bm;
+        fat_bitmap_init(&bm, words, 200);
+        fat_bitmap_set(&bm, 3); fat_bitmap_set(&bm, 3);
+        for (uint32_t b = 60; b < 70; b++) fat_bitmap_set(&bm, b);
+        fat_bitmap_set(&bm, 199);
+        fat_bitmap_set(&bm, 200);
+        CHECK(bm.set_count == 12 && fat_bitmap_test(&bm, 65) && !fat_bitmap_test(&bm, 70),
+              "set/test with exact count, out-of-range ignored");
+        fat_bitmap_clear(&bm, 3); fat_bitmap_clear(&bm, 3);
+        CHECK(bm.set_count == 11 && !fat_bitmap_test(&bm, 3), "clear is idempotent");
+
+        uint32_t len1, len2, len3;
+        uint32_t r1 = fat_bitmap_next_run(&bm, 0, &len1);
+        uint32_t r2 = fat_bitmap_next_run(&bm, r1 + len1, &len2);
+        uint32_t r3 = fat_bitmap_next_run(&bm, r2 + len2, &len3);
+        CHECK(r1 == 60 && len1 == 10 && r2 == 199 && len2 == 1 && r3 == FAT_BITMAP_NONE,
+              "runs found once, across a word boundary");
+    }
+
+    /* --- 2. Next-fit --- */
+    {
+        static uint64_t words[FAT_BITMAP_WORDS(1000)];
+        fat_bitmap_t bm;
+        fat_bitmap_init(&bm, words, 1000);
+        for (uint32_t b = 10; b < 14; b++) fat_bitmap_set(&bm, b);     /* 4 */
+        for (uint32_t b = 300; b < 308; b++) fat_bitmap_set(&bm, b);   /* 8 */
+        for (uint32_t b = 600; b < 620; b++) fat_bitmap_set(&bm, b);   /* 20 */
+
+        uint32_t got;
+        bm.hint = 0;
+        CHECK(fat_bitmap_find_run(&bm, 6, &got) == 300 && got == 6 && bm.hint == 306,
+              "first run long enough wins");
+        CHECK(fat_bitmap_find_run(&bm, 2, &got) == 306 && got == 2, "search resumes at the hint");
+        bm.hint = 700;
+        CHECK(fat_bitmap_find_run(&bm, 3, &got) == 10 && got == 3, "wraps past the end");
+        bm.hint = 0;
+        CHECK(fat_bitmap_find_run(&bm, 50, &got) == 600 && got == 20,
+              "no run long enough: longest returned");
+        fat_bitmap_reset(&bm);
+        CHECK(fat_bitmap_find_run(&bm, 1, &got) == FAT_BITMAP_NONE && got == 0, "empty map");
+    }
+
+    /* --- 3. Free map on a mounted image --- */
+    {
+        mount_image();
+        bool match = true;
+        for (uint32_t c = 2; c < CLUSTERS + 2; c++) {
+            if (fat_bitmap_test(&fs.free_map, c) != (fat_get_cluster_value(&fs, c) == 0)) match = false;
+        }
+        CHECK(match && fs.free_map.set_count == CLUSTERS - 10, "free map matches the table");
+
+        uint32_t a = fat_find_free_cluster(&fs);
+        fat_set_cluster_value(&fs, a, 0xFFFF);
+        uint32_t b = fat_find_free_cluster(&fs);
+        CHECK(a == 10 && b == 11 && !fat_bitmap_test(&fs.free_map, a), "next-fit hands out consecutive clusters");
+        fat_set_cluster_value(&fs, a, FAT_CLUSTER_FREE);
+        CHECK(fat_bitmap_test(&fs.free_map, a), "freeing sets the bit again");
+    }
+
+    /* --- 4. Chains --- */
+    {
+        mount_image();
+        bool contiguous;
+        int first = fat_allocate_cluster_chain(&fs, NULL, 0, 50);
+        CHECK(first == 10 && chain_length(10, &contiguous) == 50 && contiguous,
+              "50 clusters from the first gap that fits");
+
+        int big = fat_allocate_cluster_chain(&fs, NULL, 0, 300);
+        CHECK(big == 105 && chain_length(105, &contiguous) == 300 && contiguous,
+              "300 clusters skip the short gaps, one contiguous run");
+
+        int more = fat_allocate_cluster_chain(&fs, NULL, 404, 20);
+        CHECK(more == 405 && chain_length(105, &contiguous) == 320 && contiguous,
+              "append continues the run");
+
+        /* Fill the gaps before the file and use every other cluster after it:
+         * no free run is longer than one */
+        for (uint32_t c = 60; c < 105; c++) {
+            if (fat_get_cluster_value(&fs, c) == FAT_CLUSTER_FREE) fat_set_cluster_value(&fs, c, 0xFFFF);
+        }
+        for (uint32_t c = 425; c < CLUSTERS + 2; c += 2) fat_set_cluster_value(&fs, c, 0xFFFF);
+        fs.free_map.hint = 425;
+        int frag = fat_allocate_cluster_chain(&fs, NULL, 0, 40);
+        CHECK(frag == 426 && chain_length(426, &contiguous) == 40 && !contiguous,
+              "no run long enough: chain linked across the gaps");
+
+        uint32_t free_before = fs.free_map.set_count;
+        CHECK(fat_allocate_cluster_chain(&fs, NULL, 424, free_before + 1) == FAT_ERROR_NO_SPACE &&
+              fs.free_map.set_count == free_before &&
+              fat_is_cluster_eof(&fs, fat_get_cluster_value(&fs, 424)), "too large rejected, chain untouched");
+
+        CHECK(fat_free_cluster_chain(&fs, NULL, 105) == FAT_SUCCESS &&
+              fs.free_map.set_count == free_before + 320, "free returns every cluster");
+        CHECK(fat_get_cluster_value(&fs, 200) == FAT_CLUSTER_FREE, "entries cleared");
+
+        /* Changing a file's chain drops its extent map */
+        fat_inode_info_t owner = {0};
+        owner.first_cluster = (uint32_t)fat_allocate_cluster_chain(&fs, NULL, 0, 4);
+        uint32_t tail = fat_file_cluster(&fs, &owner, NULL, 3, NULL);
+        CHECK(tail != 0 && owner.extents.valid, "extent map built on first lookup");
+        int appended = fat_allocate_cluster_chain(&fs, &owner, tail, 1);
+        CHECK(appended > 0 && !owner.extents.valid &&
+              fat_file_cluster(&fs, &owner, NULL, 4, NULL) == (uint32_t)appended,
+              "append drops the owner's map; the rebuilt one has the new cluster");
+        CHECK(fat_free_cluster_chain(&fs, &owner, owner.first_cluster) == FAT_SUCCESS &&
+              !owner.extents.valid, "free drops it too");
+    }
+
+    /* --- 5. Writeback --- */
+    {
+        mount_image();
+        write_calls = sectors_written = 0;
+        CHECK(fat_write_fat_table(&fs) == FAT_SUCCESS && sectors_written == 0, "clean table writes nothing");
+
+        /* Touch entries in FAT sectors 0, 1 and 20 */
+        fat_set_cluster_value(&fs, 200, 0xFFFF);    /* sector 0 */
+        fat_set_cluster_value(&fs, 300, 0xFFFF);    /* sector 1 */
+        fat_set_cluster_value(&fs, 5200, 0xFFFF);   /* sector 20 */
+        CHECK(fs.dirty_map.set_count == 3, "three dirty sectors");
+        fat_write_fat_table(&fs);
+        CHECK(sectors_written == 6 && write_calls == 4,
+              "sync wrote 3 sectors to each copy, adjacent ones merged");
+        CHECK(disk_entry(0, 5200) == 0xFFFF && disk_entry(1, 5200) == 0xFFFF &&
+              disk_entry(1, 300) == 0xFFFF, "both copies updated");
+        CHECK(fs.dirty_map.set_count == 0 && !fs.fat_dirty, "dirty state cleared");
+
+        /* Append-heavy workload: the old scheme rewrote every copy in full per sync */
+        uint32_t last = 9;
+        sectors_written = 0;
+        for (int i = 0; i < 100; i++) {
+            int c = fat_allocate_cluster_chain(&fs, NULL, last, 1);
+            last = (uint32_t)c;
+            fat_write_fat_table(&fs);
+        }
+        printf("  100 appends with sync: %u sectors written (full rewrite: %u)\n",
+               sectors_written, 100u * 2 * FAT_SECTORS);
+        CHECK(sectors_written <= 100 * 2 * 2, "each sync writes only the touched sectors");
+
+        bool same = true;
+        for (uint32_t c = 0; c < CLUSTERS + 2; c++) {
+            uint16_t cached = ((uint16_t*)fs.fat_table)[c];
+            if (disk_entry(0, c) != cached || disk_entry(1, c) != cached) same = false;
+        }
+        CHECK(same, "on-disk copies match the cache");
+        fat_unload_fat_table(&fs);
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
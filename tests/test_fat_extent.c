@@ -0,0 +1,203 @@
+/* Host-side unit test for the FAT extent map.
+ *
+ * Verifies:
+ *   1. Empty and contiguous chains map to zero and one run.
+ *   2. A fragmented chain becomes one run per jump, and every lookup agrees
+ *      with walking the chain, including the run length left.
+ *   3. The cursor serves sequential and nearby lookups without searching,
+ *      and random seeks still land on the right cluster.
+ *   4. Looping chains and allocation failures are rejected without leaks;
+ *      clearing and rebuilding picks up a changed chain.
+ *   5. Reading a large file sequentially in small chunks follows the chain
+ *      once instead of once per read.
+ *
+ * Build: gcc -I../include -o test_fat_extent test_fat_extent.c ../kernel/fat_extent.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+typedef __SIZE_TYPE__ size_t;
+extern int printf(const char*, ...);
+extern void* malloc(size_t);
+extern void free(void*);
+
+#include "fat.h"
+#include "fat_extent.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+/* ---- In-memory FAT: fat[c] is the cluster after c, 0 at the end ---- */
+#define NCLUSTERS 8192
+static uint32_t fat[NCLUSTERS];
+static uint64_t next_calls;
+
+static uint32_t sim_next(void* ctx, uint32_t cluster) {
+    (void)ctx;
+    next_calls++;
+    return cluster < NCLUSTERS ? fat[cluster] : 0;
+}
+
+static int live_allocs;
+static bool fail_alloc;
+static void* sim_alloc(size_t n) {
+    if (fail_alloc) return 0;
+    live_allocs++;
+    return malloc(n);
+}
+static void sim_free(void* p) { live_allocs--; free(p); }
+
+static const fat_extent_ops_t ops = { sim_next, sim_alloc, sim_free, 0 };
+
+static void clear_fat(void) {
+    for (uint32_t i = 0; i < NCLUSTERS; i++) fat[i] = 0;
+}
+
+/* Link the given clusters into a chain */
+static void chain(const uint32_t* clusters, uint32_t n) {
+    for (uint32_t i = 0; i + 1 < n; i++) fat[clusters[i]] = clusters[i + 1];
+    fat[clusters[n - 1]] = 0;
+}
+
+/* Cluster `index` of the chain by walking it, 0 past the end */
+static uint32_t walk(uint32_t first, uint32_t index) {
+    uint32_t c = first;
+    for (uint32_t i = 0; i < index && c; i++) c = fat[c];
+    return c;
+}
+
+int main(void) {
+    printf("=== FAT extent map unit test ===\n");
+    fat_extent_map_t map;
+    fat_cursor_t cursor;
+    fat_extent_map_init(&map);
+
+    /* --- 1. Empty and contiguous --- */
+    {
+        clear_fat();
+        CHECK(fat_extent_map_build(&map, 0, NCLUSTERS, &ops) == FAT_SUCCESS &&
+              map.valid && map.count == 0 && fat_extent_lookup(&map, 0, 0, 0) == 0,
+              "empty file: valid map, no runs");
+
+        uint32_t c[10];
+        for (uint32_t i = 0; i < 10; i++) c[i] = 2 + i;
+        chain(c, 10);
+        uint32_t run = 0;
+        CHECK(fat_extent_map_build(&map, 2, NCLUSTERS, &ops) == FAT_SUCCESS && map.count == 1 &&
+              map.total_clusters == 10, "contiguous chain is one run");
+        CHECK(fat_extent_lookup(&map, 0, 7, &run) == 9 && run == 3, "lookup inside the run");
+        CHECK(fat_extent_lookup(&map, 0, 10, &run) == 0, "past the end");
+    }
+
+    /* --- 2. Fragmented chain --- */
+    {
+        clear_fat();
+        uint32_t c[] = { 10, 11, 12, 13, 14, 40, 41, 20, 21, 22, 23 };
+        chain(c, 11);
+        fat_extent_map_build(&map, 10, NCLUSTERS, &ops);
+        CHECK(map.count == 3 && map.total_clusters == 11, "one run per jump");
+        CHECK(map.extents[1].file_cluster == 5 && map.extents[1].disk_cluster == 40 &&
+              map.extents[1].length == 2, "runs record file index, disk cluster and length");
+
+        bool agree = true;
+        for (uint32_t i = 0; i < 11; i++) {
+            uint32_t run = 0;
+            uint32_t got = fat_extent_lookup(&map, 0, i, &run);
+            uint32_t expect_run = 0;
+            for (uint32_t j = i; j < 11 && c[j] == c[i] + (j - i); j++) expect_run++;
+            if (got != walk(10, i) || run != expect_run) agree = false;
+        }
+        CHECK(agree, "every lookup matches the chain walk");
+    }
+
+    /* --- 3. Cursor --- */
+    {
+        clear_fat();
+        /* Every other cluster: 1000 runs of one */
+        uint32_t c[1000];
+        for (uint32_t i = 0; i < 1000; i++) c[i] = 2 + 2 * i;
+        chain(c, 1000);
+        fat_extent_map_build(&map, 2, NCLUSTERS, &ops);
+        fat_cursor_reset(&cursor);
+
+        next_calls = 0;
+        bool seq = true;
+        for (uint32_t i = 0; i < 1000; i++) {
+            if (fat_extent_lookup(&map, &cursor, i, 0) != c[i] || cursor.extent != i) seq = false;
+        }
+        CHECK(seq && next_calls == 0, "sequential lookups follow the cursor, no chain walk");
+
+        bool random = true;
+        uint32_t x = 12345;
+        for (int i = 0; i < 5000; i++) {
+            x = x * 1103515245 + 12345;
+            uint32_t idx = (x >> 8) % 1000;
+            if (fat_extent_lookup(&map, &cursor, idx, 0) != c[idx] ||
+                cursor.file_cluster != idx || cursor.disk_cluster != c[idx]) random = false;
+        }
+        CHECK(random, "random seeks land on the right cluster");
+    }
+
+    /* --- 4. Corruption, failures, rebuild --- */
+    {
+        fat_extent_map_clear(&map, &ops);
+        CHECK(!map.valid && live_allocs == 0, "clear frees the runs");
+
+        clear_fat();
+        fat[5] = 6; fat[6] = 7; fat[7] = 5;
+        CHECK(fat_extent_map_build(&map, 5, NCLUSTERS, &ops) == FAT_ERROR_CLUSTER_CHAIN &&
+              !map.valid && live_allocs == 0, "looping chain rejected");
+
+        fat[7] = 0;
+        fail_alloc = true;
+        CHECK(fat_extent_map_build(&map, 5, NCLUSTERS, &ops) == FAT_ERROR_NO_MEMORY && !map.valid,
+              "allocation failure reported");
+        fail_alloc = false;
+
+        fat_extent_map_build(&map, 5, NCLUSTERS, &ops);
+        fat[7] = 100; fat[100] = 0;
+        fat_extent_map_clear(&map, &ops);
+        fat_extent_map_build(&map, 5, NCLUSTERS, &ops);
+        CHECK(map.count == 2 && fat_extent_lookup(&map, 0, 3, 0) == 100,
+              "rebuild after the chain grew");
+        fat_extent_map_clear(&map, &ops);
+    }
+
+    /* --- 5. Sequential small reads of a large file --- */
+    {
+        enum { CLUSTERS = 4096, CLUSTER_SIZE = 4096, CHUNK = 512 };
+        clear_fat();
+        /* Fragments of 16 clusters scattered across the disk */
+        static uint32_t c[CLUSTERS];
+        for (uint32_t i = 0; i < CLUSTERS; i++) c[i] = 2 + ((i / 16) * 37 % 256) * 16 + i % 16;
+        chain(c, CLUSTERS);
+
+        /* Old scheme: walk from the first cluster on every read */
+        uint64_t walk_steps = 0;
+        for (uint64_t pos = 0; pos < (uint64_t)CLUSTERS * CLUSTER_SIZE; pos += CHUNK) {
+            walk_steps += pos / CLUSTER_SIZE;
+        }
+
+        next_calls = 0;
+        fat_cursor_reset(&cursor);
+        bool ok = true;
+        for (uint64_t pos = 0; pos < (uint64_t)CLUSTERS * CLUSTER_SIZE; pos += CHUNK) {
+            if (!map.valid) fat_extent_map_build(&map, c[0], NCLUSTERS, &ops);
+            uint32_t idx = (uint32_t)(pos / CLUSTER_SIZE);
+            if (fat_extent_lookup(&map, &cursor, idx, 0) != c[idx]) ok = false;
+        }
+        printf("  chain steps: %llu per-read walk vs %llu with the extent map\n",
+               (unsigned long long)walk_steps, (unsigned long long)next_calls);
+        CHECK(ok && next_calls <= 2 * CLUSTERS, "chain followed once for the whole file");
+        CHECK(map.count == CLUSTERS / 16, "one run per fragment");
+        fat_extent_map_clear(&map, &ops);
+        CHECK(live_allocs == 0, "nothing leaked");
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,203 @@
+/* Host-side unit test for the futex wait-queue table.
+ *
+ * Verifies:
+ *   1. A wait whose word has already changed is refused and not queued.
+ *   2. Wakes are FIFO, bounded by the count, and call back with the owner.
+ *   3. Equal addresses in different address spaces never wake each other.
+ *   4. Unqueue reports whether a wake got there first.
+ *   5. Word addresses spread across the buckets.
+ *   6. The pthread mutex lock-word protocol (0 free, 1 locked, 2 contended)
+ *      only enters the table when a lock is actually contended.
+ *   7. Requeued condition-variable waiters are released one per unlock.
+ *
+ * Build: gcc -I../include -o test_futex test_futex.c ../kernel/futex.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+extern int printf(const char*, ...);
+
+#include "futex.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+/* Stand-in for a thread: records the order it was woken in */
+typedef struct {
+    int id;
+    int woken_at;
+    futex_waiter_t w;
+} sim_thread_t;
+
+static int wake_seq = 0;
+static void sim_wake(void* owner) {
+    ((sim_thread_t*)owner)->woken_at = ++wake_seq;
+}
+
+static futex_table_t table;
+
+/* The user/pthread.c protocol, with futex syscalls replaced by the table. */
+static int syscalls = 0;
+
+static bool sim_lock_fast(volatile uint32_t* word) {
+    return __sync_bool_compare_and_swap(word, 0, 1);
+}
+
+/* Returns true if the caller now owns the lock, false if it had to sleep */
+static bool sim_lock_slow(volatile uint32_t* word, sim_thread_t* t) {
+    if (__sync_lock_test_and_set(word, 2) == 0) {
+        return true;
+    }
+    syscalls++;
+    futex_queue(&table, &t->w, 1, (uint64_t)(uintptr_t)word, word, 2, t);
+    return false;
+}
+
+static void sim_unlock(volatile uint32_t* word) {
+    if (__sync_fetch_and_sub(word, 1) != 1) {
+        *word = 0;
+        syscalls++;
+        futex_wake(&table, 1, (uint64_t)(uintptr_t)word, 1, sim_wake);
+    }
+}
+
+int main(void) {
+    printf("=== Futex wait-queue unit test ===\n");
+    static volatile uint32_t words[1024];
+    sim_thread_t t[4];
+    for (int i = 0; i < 4; i++) t[i] = (sim_thread_t){ .id = i };
+
+    /* --- 1. Stale value --- */
+    {
+        futex_table_init(&table);
+        uint64_t a = (uint64_t)(uintptr_t)&words[0];
+        words[0] = 1;
+        CHECK(futex_queue(&table, &t[0].w, 1, a, &words[0], 2, &t[0]) == FUTEX_ERR_AGAIN &&
+              !t[0].w.queued && futex_waiters(&table, 1, a) == 0,
+              "changed word refuses the wait");
+        CHECK(futex_queue(&table, &t[0].w, 1, a + 1, &words[0], 1, &t[0]) == FUTEX_ERR_PARAM,
+              "unaligned address rejected");
+        CHECK(table.stats.wait_again == 1 && table.stats.waits == 0, "refusal counted");
+    }
+
+    /* --- 2. FIFO wake with a count --- */
+    {
+        futex_table_init(&table);
+        wake_seq = 0;
+        uint64_t a = (uint64_t)(uintptr_t)&words[1];
+        words[1] = 2;
+        for (int i = 0; i < 3; i++) {
+            t[i].woken_at = 0;
+            futex_queue(&table, &t[i].w, 1, a, &words[1], 2, &t[i]);
+        }
+        CHECK(futex_waiters(&table, 1, a) == 3, "three waiters queued");
+        CHECK(futex_wake(&table, 1, a, 1, sim_wake) == 1 && t[0].woken_at == 1 &&
+              t[1].woken_at == 0, "wake-one takes the oldest waiter");
+        CHECK(futex_wake(&table, 1, a, 10, sim_wake) == 2 && t[1].woken_at == 2 &&
+              t[2].woken_at == 3, "wake-all takes the rest in order");
+        CHECK(futex_wake(&table, 1, a, 1, sim_wake) == 0 && table.stats.empty_wakes == 1,
+              "wake with nobody queued is counted");
+    }
+
+    /* --- 3. Address spaces are separate --- */
+    {
+        futex_table_init(&table);
+        uint64_t a = (uint64_t)(uintptr_t)&words[2];
+        words[2] = 0;
+        futex_queue(&table, &t[0].w, 1, a, &words[2], 0, &t[0]);
+        futex_queue(&table, &t[1].w, 3, a, &words[2], 0, &t[1]);
+        CHECK(futex_wake(&table, 3, a, 10, sim_wake) == 1 && !t[1].w.queued && t[0].w.queued,
+              "wake in one space leaves the other queued");
+
+        /* --- 4. Unqueue --- */
+        CHECK(futex_unqueue(&table, &t[0].w) && futex_waiters(&table, 1, a) == 0,
+              "unqueue removes a still-queued waiter");
+        CHECK(!futex_unqueue(&table, &t[1].w), "unqueue after wake reports the wake won");
+    }
+
+    /* --- 5. Hash spread --- */
+    {
+        futex_table_init(&table);
+        bool used[FUTEX_HASH_SIZE] = {0};
+        uint32_t distinct = 0;
+        for (int i = 0; i < 1024; i++) {
+            uint32_t b = (uint32_t)(futex_hash(&table, 1, (uint64_t)(uintptr_t)&words[i]) -
+                                    table.buckets);
+            if (!used[b]) {
+                used[b] = true;
+                distinct++;
+            }
+        }
+        CHECK(distinct > FUTEX_HASH_SIZE * 3 / 4, "consecutive words spread over the buckets");
+    }
+
+    /* --- 6. Mutex protocol --- */
+    {
+        futex_table_init(&table);
+        wake_seq = 0;
+        volatile uint32_t* m = &words[8];
+        *m = 0;
+        syscalls = 0;
+
+        for (int i = 0; i < 1000; i++) {
+            sim_lock_fast(m);
+            sim_unlock(m);
+        }
+        CHECK(syscalls == 0 && *m == 0, "uncontended lock/unlock never enters the kernel");
+
+        /* A holds the lock; B and C contend and sleep. */
+        t[1].woken_at = t[2].woken_at = 0;
+        CHECK(sim_lock_fast(m), "A takes the free lock");
+        CHECK(!sim_lock_fast(m) && !sim_lock_slow(m, &t[1]), "B sleeps");
+        CHECK(!sim_lock_fast(m) && !sim_lock_slow(m, &t[2]), "C sleeps");
+        CHECK(*m == 2 && futex_waiters(&table, 1, (uint64_t)(uintptr_t)m) == 2,
+              "word marked contended with two sleepers");
+
+        sim_unlock(m);
+        CHECK(t[1].woken_at == 1 && t[2].woken_at == 0 && *m == 0, "A's unlock wakes only B");
+        CHECK(sim_lock_slow(m, &t[1]) && *m == 2, "B retakes it still marked contended");
+
+        sim_unlock(m);
+        CHECK(t[2].woken_at == 2, "B's unlock wakes C");
+        CHECK(sim_lock_slow(m, &t[2]), "C takes the lock");
+        int before = syscalls;
+        sim_unlock(m);
+        CHECK(syscalls == before + 1 && *m == 0 && table.stats.empty_wakes == 1,
+              "last unlock of a contended word costs one empty wake");
+    }
+
+    /* --- 7. Requeue on broadcast --- */
+    {
+        futex_table_init(&table);
+        wake_seq = 0;
+        volatile uint32_t* m = &words[9];
+        uint64_t a = (uint64_t)(uintptr_t)m;
+
+        /* Broadcaster holds the mutex; t[0] is woken, t[1..3] requeued. */
+        *m = 1;
+        __sync_bool_compare_and_swap(m, 1, 2);
+        for (int i = 1; i < 4; i++) {
+            t[i].woken_at = 0;
+            futex_enqueue(&table, &t[i].w, 1, a, &t[i]);
+        }
+        futex_enqueue(&table, &t[1].w, 1, a, &t[1]);
+        CHECK(futex_waiters(&table, 1, a) == 3 && table.stats.requeues == 3,
+              "requeued waiters land on the mutex queue once each");
+
+        sim_unlock(m);
+        CHECK(t[1].woken_at == 1 && t[2].woken_at == 0, "each unlock releases one requeued waiter");
+        CHECK(sim_lock_slow(m, &t[1]), "woken waiter takes the mutex");
+        sim_unlock(m);
+        CHECK(sim_lock_slow(m, &t[2]), "and hands it on");
+        sim_unlock(m);
+        CHECK(sim_lock_slow(m, &t[3]) && t[3].woken_at == 3 &&
+              futex_waiters(&table, 1, a) == 0, "until the queue drains");
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
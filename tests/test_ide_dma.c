@@ -0,0 +1,320 @@
+/* Host-side unit test for IDE bus-master DMA requests.
+ *
+ * Verifies:
+ *   1. PRD tables: physically adjacent pages share an entry, a 64 KiB entry
+ *      is written as 0, entries split at 64 KiB boundaries, scattered frames
+ *      get one entry each, and only the last carries end-of-table.
+ *   2. Odd, unmapped or high buffers, and too many entries, are refused.
+ *   3. One request at a time is on the bus master; the interrupt completes
+ *      it and starts the next, in submission order.
+ *   4. With DMA off, a failed start or an unmappable buffer the request is
+ *      done by PIO and completed at submit.
+ *   5. Failures complete the request with an error; interrupts with nothing
+ *      active are counted as spurious.
+ *   6. A completion callback may submit more work.
+ *
+ * Build: gcc -I../include -o test_ide_dma test_ide_dma.c ../kernel/ide_dma.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+typedef __SIZE_TYPE__ size_t;
+extern int printf(const char*, ...);
+
+#include "ide_dma.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+/* ---- Simulated memory: arena pages mapped to chosen frames ---- */
+#define PAGE        IDE_DMA_PAGE_SIZE
+#define PAGES       32
+#define UNMAPPED    0xFFFFFFFFFFFFFFFFULL
+
+static uint8_t arena[PAGES * PAGE] __attribute__((aligned(4096)));
+static uint64_t frame[PAGES];
+
+static void map_linear(uint64_t first) {
+    for (uint32_t i = 0; i < PAGES; i++) frame[i] = first + i;
+}
+
+static uint64_t sim_virt_to_phys(void* ctx, const void* addr) {
+    (void)ctx;
+    uintptr_t off = (uintptr_t)addr - (uintptr_t)arena;
+    if ((uintptr_t)addr < (uintptr_t)arena || off >= sizeof(arena)) return IDE_DMA_NO_PHYS;
+    if (frame[off / PAGE] == UNMAPPED) return IDE_DMA_NO_PHYS;
+    return frame[off / PAGE] * PAGE + off % PAGE;
+}
+
+/* ---- Simulated bus master ---- */
+static int starts, finishes, pios;
+static bool fail_start, fail_finish, fail_pio;
+static const ide_dma_request_t* running;
+static uint64_t started_lba[16];
+
+static int sim_start(void* ctx, const ide_dma_request_t* req, uint32_t prd_phys) {
+    (void)ctx; (void)prd_phys;
+    if (fail_start) return IDE_DMA_EIO;
+    if (starts < 16) started_lba[starts] = req->lba;
+    starts++;
+    running = req;
+    return IDE_DMA_OK;
+}
+
+static int sim_finish(void* ctx, const ide_dma_request_t* req) {
+    (void)ctx;
+    finishes++;
+    if (req != running) return IDE_DMA_EIO;
+    running = 0;
+    return fail_finish ? IDE_DMA_EIO : IDE_DMA_OK;
+}
+
+static int sim_pio(void* ctx, ide_dma_request_t* req) {
+    (void)ctx; (void)req;
+    pios++;
+    return fail_pio ? IDE_DMA_EIO : IDE_DMA_OK;
+}
+
+static const ide_dma_ops_t ops = { sim_virt_to_phys, sim_start, sim_finish, sim_pio, 0 };
+
+static ide_prd_t table[IDE_DMA_PRD_MAX];
+
+static void reset(void) {
+    starts = finishes = pios = 0;
+    fail_start = fail_finish = fail_pio = false;
+    running = 0;
+    map_linear(0x100);
+}
+
+/* Completion order, recorded by the callback */
+static uint64_t done_lba[16];
+static int done_count;
+static void record_done(ide_dma_request_t* req) {
+    if (done_count < 16) done_lba[done_count] = req->lba;
+    done_count++;
+}
+
+static void make(ide_dma_request_t* req, uint64_t lba, uint16_t count, void* buffer) {
+    *req = (ide_dma_request_t){ 0 };
+    req->lba = lba;
+    req->count = count;
+    req->buffer = buffer;
+    req->done = record_done;
+}
+
+/* Submits ctx (another request) from the first one's completion */
+static void chain_done(ide_dma_request_t* req) {
+    record_done(req);
+    ide_dma_request_t* next = (ide_dma_request_t*)req->ctx;
+    if (next) {
+        req->ctx = 0;
+        ide_dma_submit((ide_dma_channel_t*)next->ctx, next);
+    }
+}
+
+int main(void) {
+    printf("=== IDE DMA unit test ===\n");
+
+    /* --- 1. PRD tables --- */
+    {
+        reset();    /* Arena at 0x100000: 64 KiB aligned */
+        int n = ide_dma_build_prd(table, IDE_DMA_PRD_MAX, arena, 16 * PAGE, &ops);
+        CHECK(n == 1 && table[0].phys == 0x100000 && table[0].bytes == 0 &&
+              table[0].flags == IDE_DMA_PRD_EOT, "64 KiB of adjacent frames is one entry of 0 bytes");
+
+        n = ide_dma_build_prd(table, IDE_DMA_PRD_MAX, arena + 12 * PAGE, 8 * PAGE, &ops);
+        CHECK(n == 2 && table[0].phys == 0x10C000 && table[0].bytes == 0x4000 && table[0].flags == 0 &&
+              table[1].phys == 0x110000 && table[1].bytes == 0x4000 && table[1].flags == IDE_DMA_PRD_EOT,
+              "entries split at the 64 KiB boundary");
+
+        n = ide_dma_build_prd(table, IDE_DMA_PRD_MAX, arena + 100, 1024, &ops);
+        CHECK(n == 1 && table[0].phys == 0x100064 && table[0].bytes == 1024, "unaligned start inside a page");
+
+        for (uint32_t i = 0; i < 4; i++) frame[i] = 0x200 + (3 - i) * 2;
+        n = ide_dma_build_prd(table, IDE_DMA_PRD_MAX, arena, 4 * PAGE, &ops);
+        CHECK(n == 4 && table[0].phys == 0x206000 && table[3].phys == 0x200000 &&
+              table[2].bytes == PAGE && table[2].flags == 0 && table[3].flags == IDE_DMA_PRD_EOT,
+              "scattered frames get one entry each");
+    }
+
+    /* --- 2. Refused buffers --- */
+    {
+        reset();
+        CHECK(ide_dma_build_prd(table, IDE_DMA_PRD_MAX, arena + 1, 512, &ops) == IDE_DMA_ERANGE,
+              "odd address refused");
+        CHECK(ide_dma_build_prd(table, IDE_DMA_PRD_MAX, arena, 511, &ops) == IDE_DMA_ERANGE,
+              "odd length refused");
+        frame[2] = UNMAPPED;
+        CHECK(ide_dma_build_prd(table, IDE_DMA_PRD_MAX, arena, 4 * PAGE, &ops) == IDE_DMA_ERANGE,
+              "unmapped page refused");
+        frame[2] = 0x100000;
+        CHECK(ide_dma_build_prd(table, IDE_DMA_PRD_MAX, arena + 2 * PAGE, PAGE, &ops) == IDE_DMA_ERANGE,
+              "memory above 4 GiB refused");
+        for (uint32_t i = 0; i < PAGES; i++) frame[i] = 0x300 + i * 2;
+        CHECK(ide_dma_build_prd(table, 3, arena, 4 * PAGE, &ops) == IDE_DMA_ERANGE &&
+              ide_dma_build_prd(table, 4, arena, 4 * PAGE, &ops) == 4, "table size is respected");
+    }
+
+    /* --- 3. One request at a time --- */
+    {
+        reset();
+        done_count = 0;
+        ide_dma_channel_t ch;
+        ide_dma_channel_init(&ch, table, 0x9000, true, &ops);
+        ide_dma_request_t a, b, c;
+        make(&a, 10, 8, arena);
+        make(&b, 20, 8, arena + 8 * PAGE);
+        make(&c, 30, 8, arena + 16 * PAGE);
+        ide_dma_submit(&ch, &a);
+        ide_dma_submit(&ch, &b);
+        ide_dma_submit(&ch, &c);
+        CHECK(starts == 1 && ch.active == &a && !a.complete && ide_dma_busy(&ch),
+              "only the first request is started");
+
+        ide_dma_interrupt(&ch);
+        CHECK(a.complete && a.status == IDE_DMA_OK && !a.used_pio && ch.active == &b && starts == 2,
+              "the interrupt completes it and starts the next");
+        ide_dma_interrupt(&ch);
+        ide_dma_interrupt(&ch);
+        CHECK(!ide_dma_busy(&ch) && done_count == 3 && done_lba[0] == 10 && done_lba[1] == 20 &&
+              done_lba[2] == 30 && started_lba[2] == 30, "completed in submission order");
+        CHECK(ch.stats.dma_requests == 3 && ch.stats.prd_entries == 3 && ch.stats.bytes == 3 * 8 * 512,
+              "DMA counted");
+
+        ide_dma_request_t bad;
+        make(&bad, 0, 0, arena);
+        CHECK(ide_dma_submit(&ch, &bad) == IDE_DMA_EINVAL, "zero sectors refused");
+        bad.count = IDE_DMA_MAX_SECTORS + 1;
+        CHECK(ide_dma_submit(&ch, &bad) == IDE_DMA_EINVAL, "more than one command's sectors refused");
+        bad.count = 1;
+        bad.drive = 2;
+        CHECK(ide_dma_submit(&ch, &bad) == IDE_DMA_EINVAL, "no third drive on a channel");
+    }
+
+    /* --- 4. PIO fallback --- */
+    {
+        reset();
+        done_count = 0;
+        ide_dma_channel_t ch;
+        ide_dma_request_t a;
+        ide_dma_channel_init(&ch, 0, 0, true, &ops);
+        make(&a, 1, 1, arena);
+        ide_dma_submit(&ch, &a);
+        CHECK(a.complete && a.used_pio && pios == 1 && starts == 0 && done_count == 1,
+              "no PRD table: done by PIO at submit");
+
+        ide_dma_channel_init(&ch, table, 0x9000, true, &ops);
+        fail_start = true;
+        make(&a, 2, 1, arena);
+        ide_dma_submit(&ch, &a);
+        CHECK(a.complete && a.used_pio && a.status == IDE_DMA_OK && pios == 2,
+              "a refused start falls back to PIO");
+        fail_start = false;
+
+        frame[0] = UNMAPPED;
+        make(&a, 3, 1, arena);
+        ide_dma_submit(&ch, &a);
+        CHECK(a.complete && a.used_pio && pios == 3 && ch.stats.pio_requests == 2,
+              "an unmappable buffer falls back to PIO");
+    }
+
+    /* --- 5. Errors and spurious interrupts --- */
+    {
+        reset();
+        done_count = 0;
+        ide_dma_channel_t ch;
+        ide_dma_channel_init(&ch, table, 0x9000, true, &ops);
+        ide_dma_interrupt(&ch);
+        CHECK(ch.stats.spurious == 1 && finishes == 0, "an interrupt with nothing active is spurious");
+
+        ide_dma_request_t a, b;
+        make(&a, 1, 4, arena);
+        make(&b, 2, 4, arena);
+        ide_dma_submit(&ch, &a);
+        ide_dma_submit(&ch, &b);
+        fail_finish = true;
+        ide_dma_interrupt(&ch);
+        fail_finish = false;
+        CHECK(a.complete && a.status == IDE_DMA_EIO && ch.stats.errors == 1 && ch.active == &b,
+              "a failed transfer completes with an error; the next starts");
+        ide_dma_interrupt(&ch);
+        CHECK(b.status == IDE_DMA_OK && ch.stats.bytes == 4 * 512, "only good transfers counted as bytes");
+
+        ide_dma_channel_init(&ch, table, 0x9000, false, &ops);
+        fail_pio = true;
+        make(&a, 3, 1, arena);
+        ide_dma_submit(&ch, &a);
+        CHECK(a.complete && a.status == IDE_DMA_EIO && ch.stats.errors == 1, "PIO failures reported");
+    }
+
+    /* --- 6. Submitting from a completion --- */
+    {
+        reset();
+        done_count = 0;
+        ide_dma_channel_t ch;
+        ide_dma_channel_init(&ch, table, 0x9000, true, &ops);
+        ide_dma_request_t a, b, c;
+        make(&a, 1, 1, arena);
+        make(&b, 2, 1, arena);
+        make(&c, 3, 1, arena);
+        a.done = chain_done;
+        a.ctx = &c;
+        c.ctx = &ch;
+        ide_dma_submit(&ch, &a);
+        ide_dma_submit(&ch, &b);
+        ide_dma_interrupt(&ch);
+        CHECK(ch.active == &b && ch.head == &c && starts == 2, "work submitted from a callback queues");
+        ide_dma_interrupt(&ch);
+        ide_dma_interrupt(&ch);
+        CHECK(done_count == 3 && done_lba[2] == 3 && !ide_dma_busy(&ch), "and is started in turn");
+
+        /* PIO completions call back inside submit; the chained request must
+         * not recurse into dispatch */
+        ide_dma_channel_init(&ch, table, 0x9000, false, &ops);
+        done_count = 0;
+        make(&a, 1, 1, arena);
+        make(&c, 3, 1, arena);
+        a.done = chain_done;
+        a.ctx = &c;
+        c.ctx = &ch;
+        ide_dma_submit(&ch, &a);
+        CHECK(done_count == 2 && c.complete && c.used_pio && !ide_dma_busy(&ch),
+              "PIO chains complete without recursion");
+    }
+
+    /* --- 7. Deferred PIO --- */
+    {
+        reset();
+        done_count = 0;
+        ide_dma_channel_t ch;
+        ide_dma_channel_init(&ch, table, 0x9000, true, &ops);
+        ch.defer_pio = true;
+        ide_dma_request_t a, b;
+        frame[0] = UNMAPPED;
+        make(&a, 1, 1, arena);
+        make(&b, 2, 1, arena);
+        ide_dma_submit(&ch, &a);
+        ide_dma_submit(&ch, &b);
+        CHECK(!a.complete && a.used_pio && pios == 0 && ch.pio == &a && ch.head == &b &&
+              ide_dma_busy(&ch), "a PIO request is parked, not run, at submit");
+
+        ide_dma_request_t* req = ide_dma_pio_take(&ch);
+        CHECK(req == &a && ide_dma_pio_take(&ch) == NULL, "one caller takes it");
+        ide_dma_pio_done(&ch, req, ch.ops.pio(ch.ops.ctx, req));
+        CHECK(a.complete && a.status == IDE_DMA_OK && pios == 1 && done_count == 1 &&
+              ch.pio == &b, "done completes it and parks the next");
+
+        frame[0] = 0;
+        req = ide_dma_pio_take(&ch);
+        ide_dma_pio_done(&ch, req, IDE_DMA_EIO);
+        CHECK(b.complete && b.status == IDE_DMA_EIO && !ide_dma_busy(&ch),
+              "a failed deferred PIO is reported");
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
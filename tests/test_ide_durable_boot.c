@@ -32,6 +32,7 @@ void  kfree(void* p) { free(p); }
 #include "snapshot_store.h"
 #include "checkpoint_journal.h"
 #include "keyframe_store.h"
+#include "ide_dma.h"
 
 /* ---- Mock NON-VOLATILE IDE disk: an LBA-addressed buffer that survives a
  * simulated power cut (we simply do not clear it). ---- */
@@ -52,6 +53,21 @@ int ide_write_sectors(void* dev, uint8_t drive, uint64_t lba, uint16_t count, co
     return IDE_SUCCESS;
 }
 
+/* checkpoint_ide.c submits a request and waits for it; the mock leaves it
+ * pending at submit and does the transfer in the wait. */
+int ide_submit(void* dev, ide_dma_request_t* req) {
+    (void)dev;
+    req->complete = false;
+    return IDE_SUCCESS;
+}
+int ide_wait_request(void* dev, ide_dma_request_t* req) {
+    int rc = req->write
+        ? ide_write_sectors(dev, req->drive, req->lba, req->count, req->buffer)
+        : ide_read_sectors(dev, req->drive, req->lba, req->count, req->buffer);
+    req->complete = true;
+    return rc;
+}
+
 /* Fresh binding + block device over the IDE disk (as boot would produce). */
 static fat_block_device_t* bind_ide(fat_block_device_t* bdev,
                                     checkpoint_ide_binding_t* binding) {
@@ -0,0 +1,436 @@
+/* Host-side unit test for the VFS page cache.
+ *
+ * Verifies:
+ *   1. The radix tree holds pages at scattered indices, from 0 to past 2^30,
+ *      visits them in index order, and frees its nodes as pages go.
+ *   2. Reads go to the filesystem once per page; repeats are hits.
+ *   3. Writes stay in memory until writeback. Partly written pages holding
+ *      file data are read first, others are not. Writeback goes in index
+ *      order, and sync touches only the requested owner's files.
+ *   4. The page budget evicts cold pages first, gives recently read pages a
+ *      second chance, and writes dirty pages back before dropping them.
+ *   5. Files with no backing store stay cached whatever the budget.
+ *   6. Truncate drops pages past the end and zeroes the tail; releasing a
+ *      mapping, or invalidating an unmounted owner, frees everything.
+ *   7. Reading the same config file 100 times touches the disk once.
+ *   8. Streaming a file sequentially grows the readahead window to 512 KiB
+ *      and reads it in a handful of large requests; random reads get no
+ *      readahead; filesystems without readpages read ahead page by page.
+ *   9. A read actor is handed the cached pages themselves, one chunk per
+ *      page; a short consume stops the read and an error is passed back.
+ *
+ * Build: gcc -I../include -o test_page_cache test_page_cache.c ../kernel/page_cache.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+typedef __SIZE_TYPE__ size_t;
+extern int printf(const char*, ...);
+extern void* malloc(size_t);
+extern void free(void*);
+
+#include "page_cache.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+/* ---- Memory ---- */
+static int live_allocs, live_pages;
+static void* sim_alloc(size_t n) { live_allocs++; return malloc(n); }
+static void sim_free(void* p) { live_allocs--; free(p); }
+static void* sim_alloc_page(void* ctx) { (void)ctx; live_pages++; return malloc(PAGE_CACHE_SIZE); }
+static void sim_free_page(void* ctx, void* p) { (void)ctx; live_pages--; free(p); }
+
+static const page_cache_ops_t ops = { sim_alloc_page, sim_free_page, sim_alloc, sim_free, 0 };
+
+/* ---- Simulated files: byte i of file f is (i * 7 + f) & 0xFF on disk ---- */
+typedef struct sim_file {
+    int id;
+    uint64_t size;
+    uint8_t* disk;              /* Written-back contents */
+    uint32_t reads, writes;
+    uint32_t batches, max_batch;    /* readpages calls and largest */
+    uint64_t write_order[64];
+    bool fail_writes;
+} sim_file_t;
+
+static uint8_t disk_byte(int id, uint64_t i) { return (uint8_t)((i * 7 + id) & 0xFF); }
+
+static int sim_readpage(void* host, uint64_t index, void* page) {
+    sim_file_t* f = (sim_file_t*)host;
+    uint8_t* p = (uint8_t*)page;
+    f->reads++;
+    for (uint32_t i = 0; i < PAGE_CACHE_SIZE; i++) {
+        uint64_t off = index * PAGE_CACHE_SIZE + i;
+        if (off < f->size) p[i] = f->disk ? f->disk[off] : disk_byte(f->id, off);
+    }
+    return 0;
+}
+
+static int sim_writepage(void* host, uint64_t index, const void* page) {
+    sim_file_t* f = (sim_file_t*)host;
+    if (f->fail_writes) return -1;
+    if (f->writes < 64) f->write_order[f->writes] = index;
+    f->writes++;
+    if (f->disk) {
+        const uint8_t* p = (const uint8_t*)page;
+        for (uint32_t i = 0; i < PAGE_CACHE_SIZE; i++) {
+            uint64_t off = index * PAGE_CACHE_SIZE + i;
+            if (off < f->size) f->disk[off] = p[i];
+        }
+    }
+    return 0;
+}
+
+static int sim_readpages(void* host, uint64_t index, uint32_t nr, void* buffer) {
+    sim_file_t* f = (sim_file_t*)host;
+    uint8_t* p = (uint8_t*)buffer;
+    f->batches++;
+    if (nr > f->max_batch) f->max_batch = nr;
+    for (uint64_t i = 0; i < (uint64_t)nr * PAGE_CACHE_SIZE; i++) {
+        uint64_t off = index * PAGE_CACHE_SIZE + i;
+        if (off < f->size) p[i] = disk_byte(f->id, off);
+    }
+    return 0;
+}
+
+static const page_cache_aops_t disk_aops = { sim_readpage, sim_writepage, 0, 0 };
+static const page_cache_aops_t batch_aops = { sim_readpage, sim_writepage, 0, sim_readpages };
+static const page_cache_aops_t memory_aops = { 0, 0, 0, 0 };
+
+static int owner_a, owner_b;
+
+/* ---- Read actor that records what it was handed (sendfile) ---- */
+typedef struct sink {
+    const void* chunks[16];
+    size_t lens[16];
+    int calls;
+    size_t limit;               /* Consume at most this much per call */
+    int64_t fail;               /* Returned from the third call when set */
+} sink_t;
+
+static int64_t sink_actor(void* ctx, const void* data, size_t len) {
+    sink_t* s = (sink_t*)ctx;
+    if (s->fail && s->calls == 2) return s->fail;
+    if (s->calls < 16) {
+        s->chunks[s->calls] = data;
+        s->lens[s->calls] = len;
+    }
+    s->calls++;
+    return (int64_t)(len < s->limit ? len : s->limit);
+}
+
+/* Actor that truncates and shrinks under itself, as another thread could
+ * once the VFS drops its lock around the actor */
+typedef struct {
+    page_cache_mapping_t* mapping;
+    uint8_t first;
+    uint8_t last;
+    uint32_t evicted;
+} racing_t;
+
+static int64_t racing_actor(void* ctx, const void* data, size_t len) {
+    racing_t* r = (racing_t*)ctx;
+    const uint8_t* bytes = (const uint8_t*)data;
+    r->first = bytes[0];
+    page_cache_truncate(r->mapping, 0);
+    r->evicted = page_cache_shrink(r->mapping->cache, 4);
+    r->last = bytes[len - 1];
+    return (int64_t)len;
+}
+
+int main(void) {
+    printf("=== Page cache unit test ===\n");
+    static uint8_t buf[64 * 1024];
+
+    /* --- 1. Radix tree --- */
+    {
+        page_cache_t cache;
+        page_cache_mapping_t m;
+        sim_file_t f = { .id = 1, .size = 1ULL << 44 };
+        page_cache_init(&cache, &ops, 0);
+        page_cache_mapping_init(&m, &cache, &disk_aops, &f, &owner_a);
+
+        uint64_t idx[] = { 1ULL << 30, 0, 4095, 63, 64, 1ULL << 20, 4096 };
+        bool ok = true;
+        for (int i = 0; i < 7; i++) {
+            if (page_cache_write(&m, idx[i] * PAGE_CACHE_SIZE, "x", 1, f.size) != 1) ok = false;
+        }
+        CHECK(ok && m.nrpages == 7 && m.height == 6, "scattered pages inserted, tree six levels high");
+        CHECK(page_cache_find(&m, 4095) && page_cache_find(&m, 1ULL << 30) &&
+              !page_cache_find(&m, 65) && !page_cache_find(&m, 1ULL << 31), "lookups");
+
+        page_cache_writeback(&m);
+        uint64_t expect[] = { 0, 63, 64, 4095, 4096, 1ULL << 20, 1ULL << 30 };
+        bool ordered = f.writes == 7;
+        for (int i = 0; i < 7 && ordered; i++) ordered = f.write_order[i] == expect[i];
+        CHECK(ordered, "writeback visits pages in index order");
+
+        page_cache_truncate(&m, 4096ULL * PAGE_CACHE_SIZE);
+        CHECK(m.nrpages == 4 && m.height == 2, "truncate drops the far pages and lowers the tree");
+        page_cache_mapping_release(&m);
+        CHECK(m.nrpages == 0 && !m.root && live_allocs == 0 && live_pages == 0,
+              "release frees pages and nodes");
+    }
+
+    /* --- 2. Read-through --- */
+    {
+        page_cache_t cache;
+        page_cache_mapping_t m;
+        sim_file_t f = { .id = 2, .size = 10000 };
+        page_cache_init(&cache, &ops, 0);
+        page_cache_mapping_init(&m, &cache, &disk_aops, &f, &owner_a);
+
+        int64_t n = page_cache_read(&m, 100, buf, 20000, f.size);
+        bool match = n == 9900;
+        for (int64_t i = 0; i < n && match; i++) match = buf[i] == disk_byte(2, 100 + i);
+        CHECK(match && f.reads == 3, "read clamps to the size, one fill per page");
+
+        page_cache_read(&m, 0, buf, 10000, f.size);
+        page_cache_read(&m, 5000, buf, 10, f.size);
+        page_cache_stats_t st;
+        page_cache_get_stats(&cache, &st);
+        CHECK(f.reads == 3 && st.misses == 3 && st.hits == 4 && st.fills == 3, "repeat reads are hits");
+        CHECK(page_cache_read(&m, 10000, buf, 10, f.size) == 0, "read at the end returns 0");
+        page_cache_mapping_release(&m);
+    }
+
+    /* --- 3. Write-back --- */
+    {
+        page_cache_t cache;
+        page_cache_mapping_t a, b;
+        static uint8_t disk_a[3 * PAGE_CACHE_SIZE], disk_b[PAGE_CACHE_SIZE];
+        for (uint32_t i = 0; i < sizeof(disk_a); i++) disk_a[i] = disk_byte(3, i);
+        sim_file_t fa = { .id = 3, .size = 2 * PAGE_CACHE_SIZE + 100, .disk = disk_a };
+        sim_file_t fb = { .id = 4, .size = 0, .disk = disk_b };
+        page_cache_init(&cache, &ops, 0);
+        page_cache_mapping_init(&a, &cache, &disk_aops, &fa, &owner_a);
+        page_cache_mapping_init(&b, &cache, &disk_aops, &fb, &owner_b);
+
+        page_cache_write(&a, 10, "hello", 5, fa.size);
+        CHECK(fa.reads == 1 && fa.writes == 0 && a.nrdirty == 1, "partial write reads the page, writes nothing");
+
+        for (uint32_t i = 0; i < PAGE_CACHE_SIZE; i++) buf[i] = 0x5A;
+        page_cache_write(&a, PAGE_CACHE_SIZE, buf, PAGE_CACHE_SIZE, fa.size);
+        CHECK(fa.reads == 1, "whole-page overwrite needs no read");
+
+        page_cache_write(&b, 0, "new", 3, fb.size);
+        fb.size = 3;
+        CHECK(fb.reads == 0, "write past the end needs no read");
+
+        CHECK(page_cache_sync(&cache, &owner_b) == PAGE_CACHE_OK && fb.writes == 1 && fa.writes == 0 &&
+              disk_b[0] == 'n', "sync writes back only the requested owner");
+        page_cache_sync(&cache, NULL);
+        CHECK(fa.writes == 2 && disk_a[10] == 'h' && disk_a[9] == disk_byte(3, 9) &&
+              disk_a[PAGE_CACHE_SIZE + 7] == 0x5A && cache.nrdirty == 0 && !cache.dirty_head,
+              "sync all writes every dirty page, untouched bytes kept");
+
+        page_cache_write(&a, 0, "Z", 1, fa.size);
+        fa.fail_writes = true;
+        CHECK(page_cache_writeback(&a) == PAGE_CACHE_EIO && a.nrdirty == 1, "failed writeback stays dirty");
+        fa.fail_writes = false;
+        CHECK(page_cache_writeback(&a) == PAGE_CACHE_OK && disk_a[0] == 'Z', "retry succeeds");
+        page_cache_mapping_release(&a);
+        page_cache_mapping_release(&b);
+    }
+
+    /* --- 4. Eviction --- */
+    {
+        page_cache_t cache;
+        page_cache_mapping_t m;
+        sim_file_t f = { .id = 5, .size = 100 * PAGE_CACHE_SIZE };
+        page_cache_init(&cache, &ops, 8);
+        page_cache_mapping_init(&m, &cache, &disk_aops, &f, &owner_a);
+
+        for (uint64_t i = 0; i < 8; i++) page_cache_read(&m, i * PAGE_CACHE_SIZE, buf, 1, f.size);
+        page_cache_read(&m, 0, buf, 1, f.size);             /* Page 0 is hot */
+        page_cache_write(&m, PAGE_CACHE_SIZE, "d", 1, f.size); /* Page 1 is dirty */
+        for (uint64_t i = 8; i < 10; i++) page_cache_read(&m, i * PAGE_CACHE_SIZE, buf, 1, f.size);
+
+        CHECK(cache.nrpages == 8, "budget respected");
+        CHECK(page_cache_find(&m, 0) && page_cache_find(&m, 1) && !page_cache_find(&m, 2) &&
+              !page_cache_find(&m, 3), "recently used pages get a second chance, cold ones go");
+
+        for (uint64_t i = 10; i < 16; i++) page_cache_read(&m, i * PAGE_CACHE_SIZE, buf, 1, f.size);
+        CHECK(!page_cache_find(&m, 1) && f.writes == 1 && f.write_order[0] == 1,
+              "dirty page written back before eviction");
+
+        uint32_t got = page_cache_shrink(&cache, 100);
+        page_cache_stats_t st;
+        page_cache_get_stats(&cache, &st);
+        CHECK(got == 8 && cache.nrpages == 0 && live_pages == 0 && st.evictions == 16,
+              "shrink empties the cache under pressure");
+        page_cache_mapping_release(&m);
+    }
+
+    /* --- 5. No backing store --- */
+    {
+        page_cache_t cache;
+        page_cache_mapping_t m;
+        sim_file_t f = { .id = 6 };
+        page_cache_init(&cache, &ops, 2);
+        page_cache_mapping_init(&m, &cache, &memory_aops, &f, &owner_a);
+
+        for (uint64_t i = 0; i < 5; i++) page_cache_write(&m, i * 2 * PAGE_CACHE_SIZE, "r", 1, i * 2 * PAGE_CACHE_SIZE);
+        uint64_t size = 8 * PAGE_CACHE_SIZE + 1;
+        CHECK(page_cache_shrink(&cache, 10) == 0 && m.nrpages == 5 && cache.nrdirty == 0,
+              "memory-only pages are never evicted or dirty");
+        int64_t n = page_cache_read(&m, 2 * PAGE_CACHE_SIZE - 2, buf, 3, size);
+        CHECK(n == 3 && buf[0] == 0 && buf[1] == 0 && buf[2] == 'r', "holes read as zeros");
+        page_cache_mapping_release(&m);
+    }
+
+    /* --- 6. Truncate --- */
+    {
+        page_cache_t cache;
+        page_cache_mapping_t m;
+        sim_file_t f = { .id = 7, .size = 3 * PAGE_CACHE_SIZE };
+        page_cache_init(&cache, &ops, 0);
+        page_cache_mapping_init(&m, &cache, &disk_aops, &f, &owner_a);
+
+        page_cache_read(&m, 0, buf, 3 * PAGE_CACHE_SIZE, f.size);
+        page_cache_write(&m, 2 * PAGE_CACHE_SIZE, "x", 1, f.size);
+        page_cache_truncate(&m, PAGE_CACHE_SIZE + 10);
+        page_cache_page_t* last = page_cache_find(&m, 1);
+        CHECK(m.nrpages == 2 && m.nrdirty == 0 && last &&
+              ((uint8_t*)last->data)[9] == disk_byte(7, PAGE_CACHE_SIZE + 9) &&
+              ((uint8_t*)last->data)[10] == 0, "pages past the end dropped, tail zeroed");
+        page_cache_mapping_release(&m);
+
+        page_cache_mapping_t other;
+        sim_file_t g = { .id = 9, .size = 2 * PAGE_CACHE_SIZE };
+        page_cache_mapping_init(&m, &cache, &disk_aops, &f, &owner_a);
+        page_cache_mapping_init(&other, &cache, &disk_aops, &g, &owner_b);
+        page_cache_read(&m, 0, buf, 2 * PAGE_CACHE_SIZE, f.size);
+        page_cache_read(&other, 0, buf, 2 * PAGE_CACHE_SIZE, g.size);
+        page_cache_invalidate_owner(&cache, &owner_a);
+        CHECK(m.nrpages == 0 && !m.root && other.nrpages == 2, "invalidate drops one owner's pages");
+        page_cache_mapping_release(&other);
+        CHECK(live_allocs == 0 && live_pages == 0, "nothing leaked");
+    }
+
+    /* --- 7. Repeated small-file reads --- */
+    {
+        page_cache_t cache;
+        page_cache_mapping_t m;
+        sim_file_t f = { .id = 8, .size = 1500 };
+        page_cache_init(&cache, &ops, 256);
+        page_cache_mapping_init(&m, &cache, &disk_aops, &f, &owner_a);
+
+        for (int i = 0; i < 100; i++) {
+            uint64_t pos = 0;
+            int64_t n;
+            while ((n = page_cache_read(&m, pos, buf, 128, f.size)) > 0) pos += n;
+        }
+        page_cache_stats_t st;
+        page_cache_get_stats(&cache, &st);
+        printf("  100 reads of a 1500-byte config in 128-byte chunks: %u disk reads, %llu hits\n",
+               f.reads, (unsigned long long)st.hits);
+        CHECK(f.reads == 1, "disk touched only by the first read");
+        page_cache_mapping_release(&m);
+    }
+
+    /* --- 8. Readahead --- */
+    {
+        page_cache_t cache;
+        page_cache_mapping_t m;
+        page_cache_ra_t ra;
+        sim_file_t f = { .id = 9, .size = 4 * 1024 * 1024 };
+        page_cache_init(&cache, &ops, 4096);
+        page_cache_mapping_init(&m, &cache, &batch_aops, &f, &owner_a);
+        page_cache_ra_init(&ra);
+
+        bool ok = true;
+        uint64_t pos = 0;
+        int64_t n;
+        while ((n = page_cache_read_ra(&m, &ra, pos, buf, PAGE_CACHE_SIZE, f.size)) > 0) {
+            for (int64_t i = 0; i < n && ok; i++) ok = buf[i] == disk_byte(f.id, pos + i);
+            pos += n;
+        }
+        page_cache_stats_t st;
+        page_cache_get_stats(&cache, &st);
+        printf("  4 MiB read in 4 KiB steps: %u batched reads (largest %u pages), %u single-page reads\n",
+               f.batches, f.max_batch, f.reads);
+        CHECK(ok && pos == f.size, "streamed data is correct");
+        CHECK(f.reads == 0 && st.misses == 0, "every page was read ahead of the reader");
+        CHECK(f.batches <= 16 && f.max_batch == PAGE_CACHE_RA_MAX_PAGES,
+              "the window grows to 512 KiB and the file takes a few large reads");
+        page_cache_mapping_release(&m);
+
+        /* Random page reads away from the start: no window */
+        f.batches = 0;
+        f.reads = 0;
+        page_cache_mapping_init(&m, &cache, &batch_aops, &f, &owner_a);
+        page_cache_ra_init(&ra);
+        uint64_t pages[] = { 700, 13, 402, 99, 850, 5, 611 };
+        for (int i = 0; i < 7; i++) {
+            page_cache_read_ra(&m, &ra, pages[i] * PAGE_CACHE_SIZE, buf, 100, f.size);
+        }
+        CHECK(f.batches == 0 && f.reads == 7 && m.nrpages == 7, "random reads fill only what they touch");
+        page_cache_mapping_release(&m);
+
+        /* No readpages: readahead falls back to readpage, within the budget */
+        page_cache_t small;
+        sim_file_t g = { .id = 10, .size = 256 * PAGE_CACHE_SIZE };
+        page_cache_init(&small, &ops, 64);
+        page_cache_mapping_init(&m, &small, &disk_aops, &g, &owner_a);
+        page_cache_ra_init(&ra);
+        ok = true;
+        for (pos = 0; (n = page_cache_read_ra(&m, &ra, pos, buf, 1000, g.size)) > 0; pos += n) {
+            for (int64_t i = 0; i < n && ok; i++) ok = buf[i] == disk_byte(g.id, pos + i);
+        }
+        page_cache_get_stats(&small, &st);
+        CHECK(ok && g.reads == 256 && st.readahead == 256 && st.misses == 0,
+              "page-at-a-time readahead stays ahead of the reader");
+        CHECK(small.nrpages <= 64, "the window respects the page budget");
+        page_cache_mapping_release(&m);
+        CHECK(live_allocs == 0 && live_pages == 0, "nothing leaked");
+    }
+
+    /* --- 9. Read actor --- */
+    {
+        page_cache_t cache;
+        page_cache_mapping_t m;
+        sim_file_t f = { .id = 11, .size = 4 * PAGE_CACHE_SIZE };
+        page_cache_init(&cache, &ops, 64);
+        page_cache_mapping_init(&m, &cache, &disk_aops, &f, &owner_a);
+
+        sink_t s = { .limit = PAGE_CACHE_SIZE };
+        int64_t n = page_cache_read_actor(&m, 0, 100, 3 * PAGE_CACHE_SIZE, f.size, sink_actor, &s);
+        page_cache_page_t* p0 = page_cache_find(&m, 0);
+        page_cache_page_t* p1 = page_cache_find(&m, 1);
+        CHECK(n == 3 * PAGE_CACHE_SIZE && s.calls == 4, "one call per page touched");
+        CHECK(p0 && p1 && s.chunks[0] == (uint8_t*)p0->data + 100 && s.chunks[1] == p1->data,
+              "the actor sees the cached bytes in place");
+        CHECK(s.lens[0] == PAGE_CACHE_SIZE - 100 && s.lens[3] == 100, "chunks stop at page edges");
+
+        sink_t shorter = { .limit = 10 };
+        n = page_cache_read_actor(&m, 0, 0, 2 * PAGE_CACHE_SIZE, f.size, sink_actor, &shorter);
+        CHECK(n == 10 && shorter.calls == 1, "a short consume ends the read");
+
+        sink_t failing = { .limit = PAGE_CACHE_SIZE, .fail = -7 };
+        n = page_cache_read_actor(&m, 0, 0, 3 * PAGE_CACHE_SIZE, f.size, sink_actor, &failing);
+        CHECK(n == 2 * PAGE_CACHE_SIZE, "an error after some progress returns the progress");
+        failing.calls = 2;
+        n = page_cache_read_actor(&m, 0, 0, PAGE_CACHE_SIZE, f.size, sink_actor, &failing);
+        CHECK(n == -7, "an error before any progress is returned");
+
+        /* A page deleted while the actor reads it stays valid until it returns */
+        uint8_t expect[PAGE_CACHE_SIZE];
+        page_cache_read(&m, 0, expect, PAGE_CACHE_SIZE, f.size);
+        racing_t r = { .mapping = &m };
+        n = page_cache_read_actor(&m, 0, 0, PAGE_CACHE_SIZE, f.size, racing_actor, &r);
+        CHECK(n == PAGE_CACHE_SIZE && r.first == expect[0] &&
+              r.last == expect[PAGE_CACHE_SIZE - 1] && m.nrpages == 0,
+              "a pinned page survives a truncate until the actor is done");
+        page_cache_mapping_release(&m);
+        CHECK(live_allocs == 0 && live_pages == 0, "nothing leaked");
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
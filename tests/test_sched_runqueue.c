@@ -0,0 +1,157 @@
+/* Host-side unit test for the per-CPU run queue.
+ *
+ * Verifies:
+ *   1. Pick returns the highest-priority task, FIFO within a level, and the
+ *      level bitmap tracks exactly the non-empty levels.
+ *   2. Dequeue from the middle, head and tail of a level keeps the queue
+ *      consistent; double enqueue/dequeue are no-ops.
+ *   3. find_busiest skips the caller and short queues and breaks ties toward
+ *      the lowest CPU, so the choice is reproducible.
+ *   4. Stealing moves the longest-waiting top-priority task to the thief.
+ *   5. A simulated 4-CPU machine with all work queued on CPU 0 spreads it out
+ *      by stealing, and every task runs exactly once.
+ *
+ * Build: gcc -I../include -o test_sched_runqueue \
+ *            test_sched_runqueue.c ../kernel/sched_runqueue.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+extern int printf(const char*, ...);
+
+#include "scheduler.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+#define NTASKS 32
+static task_t tasks[NTASKS];
+
+static void reset_tasks(void) {
+    for (int i = 0; i < NTASKS; i++) {
+        tasks[i] = (task_t){0};
+        tasks[i].pid = (uint32_t)i + 1;
+    }
+}
+
+static bool bitmap_matches(const sched_runqueue_t* rq) {
+    for (uint32_t level = 0; level < SCHED_PRIO_LEVELS; level++) {
+        bool bit = (rq->bitmap[level >> 6] >> (level & 63)) & 1;
+        if (bit != (rq->head[level] != 0)) return false;
+    }
+    return true;
+}
+
+int main(void) {
+    printf("=== Per-CPU run queue unit test ===\n");
+    static sched_runqueue_t rq;
+
+    /* --- 1. Priority order and FIFO within a level --- */
+    {
+        reset_tasks();
+        sched_rq_init(&rq, 0);
+        CHECK(sched_rq_pop(&rq) == 0 && sched_rq_highest_level(&rq) == -1, "empty queue pops NULL");
+
+        sched_rq_enqueue(&rq, &tasks[0], PRIORITY_NORMAL);
+        sched_rq_enqueue(&rq, &tasks[1], PRIORITY_LOW);
+        sched_rq_enqueue(&rq, &tasks[2], PRIORITY_NORMAL);
+        sched_rq_enqueue(&rq, &tasks[3], PRIORITY_HIGH);
+        sched_rq_enqueue(&rq, &tasks[4], 200);   /* second bitmap word onwards */
+        CHECK(rq.nr_ready == 5 && bitmap_matches(&rq), "bitmap marks the four used levels");
+        CHECK(sched_rq_highest_level(&rq) == PRIORITY_HIGH, "highest level found");
+
+        task_t* order[5];
+        for (int i = 0; i < 5; i++) order[i] = sched_rq_pop(&rq);
+        CHECK(order[0] == &tasks[3] && order[1] == &tasks[0] && order[2] == &tasks[2] &&
+              order[3] == &tasks[1] && order[4] == &tasks[4],
+              "pops by priority, FIFO within a level");
+        CHECK(rq.nr_ready == 0 && bitmap_matches(&rq) && sched_rq_peek(&rq) == 0,
+              "drained queue clears every bit");
+    }
+
+    /* --- 2. Dequeue anywhere in a level --- */
+    {
+        reset_tasks();
+        sched_rq_init(&rq, 3);
+        for (int i = 0; i < 5; i++) sched_rq_enqueue(&rq, &tasks[i], 7);
+        CHECK(tasks[2].on_rq && tasks[2].cpu == 3 && tasks[2].rq_level == 7,
+              "enqueue records queue placement");
+
+        sched_rq_enqueue(&rq, &tasks[2], 9);
+        CHECK(rq.nr_ready == 5 && tasks[2].rq_level == 7, "double enqueue ignored");
+
+        sched_rq_dequeue(&rq, &tasks[2]);   /* middle */
+        sched_rq_dequeue(&rq, &tasks[0]);   /* head */
+        sched_rq_dequeue(&rq, &tasks[4]);   /* tail */
+        sched_rq_dequeue(&rq, &tasks[4]);   /* again */
+        CHECK(rq.nr_ready == 2 && !tasks[2].on_rq, "dequeue unlinks; repeat is a no-op");
+        CHECK(sched_rq_pop(&rq) == &tasks[1] && sched_rq_pop(&rq) == &tasks[3] &&
+              rq.nr_ready == 0 && bitmap_matches(&rq), "survivors keep their order");
+    }
+
+    /* --- 3. Busiest-queue selection --- */
+    {
+        static sched_runqueue_t rqs[4];
+        reset_tasks();
+        for (uint32_t c = 0; c < 4; c++) sched_rq_init(&rqs[c], c);
+        CHECK(sched_rq_find_busiest(rqs, 4, 0, 1) == 4, "no candidates when all empty");
+
+        for (int i = 0; i < 3; i++) sched_rq_enqueue(&rqs[1], &tasks[i], 10);
+        for (int i = 3; i < 6; i++) sched_rq_enqueue(&rqs[2], &tasks[i], 10);
+        sched_rq_enqueue(&rqs[3], &tasks[6], 10);
+        CHECK(sched_rq_find_busiest(rqs, 4, 0, 1) == 1, "tie goes to the lowest CPU");
+        CHECK(sched_rq_find_busiest(rqs, 4, 1, 1) == 2, "caller's own queue skipped");
+        CHECK(sched_rq_find_busiest(rqs, 4, 0, 4) == 4, "queues below min_ready ignored");
+
+        /* --- 4. Steal --- */
+        sched_rq_enqueue(&rqs[1], &tasks[7], 2);
+        task_t* t = sched_rq_steal(&rqs[1], 0);
+        CHECK(t == &tasks[7] && t->cpu == 0 && !t->on_rq && rqs[1].nr_ready == 3,
+              "steal takes the top-priority task and retargets it");
+        t = sched_rq_steal(&rqs[1], 0);
+        CHECK(t == &tasks[0], "then the longest-waiting task at the next level");
+    }
+
+    /* --- 5. Four CPUs balance by stealing --- */
+    {
+        static sched_runqueue_t rqs[4];
+        int runs[NTASKS] = {0};
+        int per_cpu[4] = {0};
+        reset_tasks();
+        for (uint32_t c = 0; c < 4; c++) sched_rq_init(&rqs[c], c);
+        for (int i = 0; i < NTASKS; i++) {
+            sched_rq_enqueue(&rqs[0], &tasks[i], (uint8_t)(PRIORITY_NORMAL + (i % 3)));
+        }
+
+        /* Each round every CPU runs one task: its own, or a stolen one. */
+        bool any = true;
+        while (any) {
+            any = false;
+            for (uint32_t c = 0; c < 4; c++) {
+                task_t* t = sched_rq_pop(&rqs[c]);
+                if (!t) {
+                    uint32_t src = sched_rq_find_busiest(rqs, 4, c, 1);
+                    t = src < 4 ? sched_rq_steal(&rqs[src], c) : 0;
+                }
+                if (t) {
+                    runs[t - tasks]++;
+                    per_cpu[c]++;
+                    any = true;
+                }
+            }
+        }
+
+        bool once = true;
+        for (int i = 0; i < NTASKS; i++) once = once && runs[i] == 1;
+        CHECK(once, "every task ran exactly once");
+        CHECK(per_cpu[0] == 8 && per_cpu[1] == 8 && per_cpu[2] == 8 && per_cpu[3] == 8,
+              "work spread evenly across idle CPUs");
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
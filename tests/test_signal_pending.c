@@ -0,0 +1,202 @@
+/* Host-side unit test for the pending signal set.
+ *
+ * Verifies:
+ *   1. Standard signals coalesce into one pending instance that keeps the
+ *      first sender's info, and taking it clears the bit.
+ *   2. Realtime signals queue every instance, FIFO per signal, and the
+ *      lowest-numbered one is selected first.
+ *   3. Selection follows the caller's priority classes and skips signals
+ *      outside the allowed mask.
+ *   4. The preallocated realtime slots run out cleanly, are reused after a
+ *      take, and discard drops every instance of a signal.
+ *   5. Peek leaves the set untouched; invalid signals are rejected.
+ *   6. A SIGCHLD storm and long add/take churn leave the set consistent.
+ *
+ * Build: gcc -I../include -o test_signal_pending test_signal_pending.c ../kernel/signal_pending.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+extern int printf(const char*, ...);
+extern void* memset(void*, int, unsigned long);
+
+#include "signal_delivery.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+#define SIG_KILL    9
+#define SIG_SEGV    11
+#define SIG_TERM    15
+#define SIG_CHLD    17
+#define SIG_STOP    19
+#define SIG_RT(n)   (32 + (n))
+
+/* Critical, high, normal, low, then realtime */
+static const uint64_t order[] = {
+    (1ULL << SIG_KILL) | (1ULL << SIG_STOP),
+    (1ULL << SIG_SEGV),
+    (1ULL << SIG_TERM),
+    (1ULL << SIG_CHLD),
+    SIGNAL_RT_MASK,
+};
+#define LEVELS  5
+
+static signal_pending_t set;
+
+static siginfo_t info_with(int signal, int value) {
+    siginfo_t info;
+    memset(&info, 0, sizeof(info));
+    info.si_signo = signal;
+    info.si_value.sival_int = value;
+    return info;
+}
+
+static int next(uint64_t allowed, int* value) {
+    siginfo_t info;
+    int signal = signal_pending_select(&set, allowed, order, LEVELS);
+    if (signal && signal_pending_take(&set, signal, &info) != signal) {
+        return -1;
+    }
+    if (signal && value) {
+        *value = info.si_value.sival_int;
+    }
+    return signal;
+}
+
+int main(void) {
+    printf("=== Pending signal set unit test ===\n");
+
+    /* --- 1. Standard signals coalesce --- */
+    {
+        signal_pending_init(&set);
+        siginfo_t a = info_with(SIG_CHLD, 1), b = info_with(SIG_CHLD, 2);
+        CHECK(signal_pending_add(&set, SIG_CHLD, &a) == SIGNAL_PENDING_QUEUED, "first SIGCHLD queued");
+        CHECK(signal_pending_add(&set, SIG_CHLD, &b) == SIGNAL_PENDING_COALESCED, "second one coalesced");
+        CHECK(signal_pending_count(&set, SIG_CHLD) == 1, "one instance pending");
+
+        int value = 0;
+        CHECK(next(~0ULL, &value) == SIG_CHLD && value == 1, "first sender's info delivered");
+        CHECK(!signal_pending_has(&set, SIG_CHLD) && set.mask == 0, "taking it clears the bit");
+    }
+
+    /* --- 2. Realtime queueing --- */
+    {
+        signal_pending_init(&set);
+        siginfo_t i1 = info_with(SIG_RT(2), 1), i2 = info_with(SIG_RT(1), 2), i3 = info_with(SIG_RT(2), 3);
+        signal_pending_add(&set, SIG_RT(2), &i1);
+        signal_pending_add(&set, SIG_RT(1), &i2);
+        signal_pending_add(&set, SIG_RT(2), &i3);
+        CHECK(signal_pending_count(&set, SIG_RT(2)) == 2 && set.rt_queued == 3,
+              "every realtime instance queued");
+
+        int v1 = 0, v2 = 0, v3 = 0;
+        int s1 = next(~0ULL, &v1), s2 = next(~0ULL, &v2), s3 = next(~0ULL, &v3);
+        CHECK(s1 == SIG_RT(1) && v1 == 2, "lowest realtime signal first");
+        CHECK(s2 == SIG_RT(2) && v2 == 1 && s3 == SIG_RT(2) && v3 == 3, "FIFO within a signal");
+        CHECK(set.mask == 0 && set.rt_queued == 0, "set empty afterwards");
+    }
+
+    /* --- 3. Priority classes and blocking --- */
+    {
+        signal_pending_init(&set);
+        int sigs[] = { SIG_RT(8), SIG_CHLD, SIG_TERM, SIG_SEGV };
+        for (int i = 0; i < 4; i++) {
+            siginfo_t info = info_with(sigs[i], i);
+            signal_pending_add(&set, sigs[i], &info);
+        }
+
+        uint64_t allowed = ~(1ULL << SIG_TERM);
+        int a = next(allowed, 0), b = next(allowed, 0), c = next(allowed, 0), d = next(allowed, 0);
+        CHECK(a == SIG_SEGV && b == SIG_CHLD && c == SIG_RT(8), "class order, blocked one skipped");
+        CHECK(d == 0 && signal_pending_has(&set, SIG_TERM), "blocked signal stays pending");
+        CHECK(next(~0ULL, 0) == SIG_TERM, "delivered once unblocked");
+
+        siginfo_t kill = info_with(SIG_KILL, 0), segv = info_with(SIG_SEGV, 0);
+        signal_pending_add(&set, SIG_SEGV, &segv);
+        signal_pending_add(&set, SIG_KILL, &kill);
+        CHECK(next(~0ULL, 0) == SIG_KILL, "critical class beats high");
+        signal_pending_discard(&set, SIG_SEGV);
+
+        siginfo_t odd = info_with(5, 0);
+        signal_pending_add(&set, 5, &odd);
+        CHECK(next(~0ULL, 0) == 5, "signal outside every class still selected");
+    }
+
+    /* --- 4. Slot exhaustion, reuse and discard --- */
+    {
+        signal_pending_init(&set);
+        siginfo_t info = info_with(SIG_RT(0), 0);
+        int queued = 0;
+        for (int i = 0; i < SIGNAL_RT_QUEUE_SIZE; i++) {
+            info.si_value.sival_int = i;
+            if (signal_pending_add(&set, SIG_RT(i % 4), &info) == SIGNAL_PENDING_QUEUED) queued++;
+        }
+        CHECK(queued == SIGNAL_RT_QUEUE_SIZE, "every slot usable");
+        CHECK(signal_pending_add(&set, SIG_RT(5), &info) == -1 && !signal_pending_has(&set, SIG_RT(5)),
+              "full set rejects another instance");
+        CHECK(signal_pending_add(&set, SIG_CHLD, &info) == SIGNAL_PENDING_QUEUED,
+              "standard signals need no slot");
+
+        signal_pending_take(&set, SIG_RT(3), 0);
+        CHECK(signal_pending_add(&set, SIG_RT(5), &info) == SIGNAL_PENDING_QUEUED, "freed slot reused");
+
+        CHECK(signal_pending_discard(&set, SIG_RT(0)) == SIGNAL_RT_QUEUE_SIZE / 4 &&
+              !signal_pending_has(&set, SIG_RT(0)), "discard drops every instance");
+        CHECK(set.rt_queued == SIGNAL_RT_QUEUE_SIZE - SIGNAL_RT_QUEUE_SIZE / 4,
+              "slot accounting matches");
+    }
+
+    /* --- 5. Peek and validation --- */
+    {
+        signal_pending_init(&set);
+        siginfo_t info = info_with(SIG_RT(4), 7), out;
+        signal_pending_add(&set, SIG_RT(4), &info);
+        CHECK(signal_pending_peek(&set, SIG_RT(4), &out) == SIG_RT(4) && out.si_value.sival_int == 7 &&
+              signal_pending_count(&set, SIG_RT(4)) == 1, "peek leaves the instance queued");
+        CHECK(signal_pending_add(&set, 0, &info) == -1 && signal_pending_add(&set, 64, &info) == -1,
+              "out-of-range signals rejected");
+        CHECK(signal_pending_has(&set, 0) && signal_pending_take(&set, SIG_TERM, 0) == 0,
+              "any-signal test and take of a non-pending signal");
+    }
+
+    /* --- 6. Storms and churn --- */
+    {
+        signal_pending_init(&set);
+        siginfo_t info = info_with(SIG_CHLD, 0);
+        int coalesced = 0;
+        for (int i = 0; i < 100000; i++) {
+            if (signal_pending_add(&set, SIG_CHLD, &info) == SIGNAL_PENDING_COALESCED) coalesced++;
+        }
+        CHECK(coalesced == 99999 && signal_pending_count(&set, SIG_CHLD) == 1,
+              "SIGCHLD storm keeps one pending instance");
+
+        bool ordered = true;
+        for (int i = 0; i < 100000; i++) {
+            siginfo_t rt = info_with(SIG_RT(i % 32), i);
+            signal_pending_add(&set, SIG_RT(i % 32), &rt);
+            if (i % 3 == 2) {
+                int value = 0, signal = next(SIGNAL_RT_MASK, &value);
+                if (signal == 0 || value % 32 != signal - 32) ordered = false;
+                next(SIGNAL_RT_MASK, 0);
+                next(SIGNAL_RT_MASK, 0);
+            }
+        }
+        CHECK(ordered && set.rt_queued == (100000 % 3), "add/take churn keeps instances matched");
+        while (next(~0ULL, 0) > 0) {}
+        CHECK(set.mask == 0 && set.rt_queued == 0, "drains to empty");
+
+        int refill = 0;
+        for (int i = 0; i < SIGNAL_RT_QUEUE_SIZE; i++) {
+            if (signal_pending_add(&set, SIG_RT(31), &info) == SIGNAL_PENDING_QUEUED) refill++;
+        }
+        CHECK(refill == SIGNAL_RT_QUEUE_SIZE, "free list intact after churn");
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
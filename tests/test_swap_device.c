@@ -0,0 +1,243 @@
+/* Host-side unit test for the block-device swap area.
+ *
+ * Uses an in-memory mock block device that counts commands to verify:
+ *   1. Consecutive allocations come from one cluster of adjacent slots.
+ *   2. Writes to adjacent slots reach the device as one multi-sector command.
+ *   3. A swap-in reads its neighbours ahead and serves them without I/O.
+ *   4. Pages still in the write batch are never read back stale from disk.
+ *   5. Allocation falls back to single slots when no cluster is free, and
+ *      device errors are reported rather than swallowed.
+ *
+ * Build: gcc -I../include -o test_swap_device test_swap_device.c
+ * (compiled standalone; provides its own kmalloc/kfree/mem* shims).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Declare the libc bits we use directly, rather than including <stdlib.h>/
+ * <string.h>/<stdio.h>. Those pull in <sys/types.h>, whose ssize_t typedef
+ * conflicts with the one in IKOS's vfs.h (reached via fat.h). */
+typedef __SIZE_TYPE__ size_t;
+extern void* malloc(size_t);
+extern void  free(void*);
+extern void* memcpy(void*, const void*, size_t);
+extern void* memset(void*, int, size_t);
+extern int   memcmp(const void*, const void*, size_t);
+extern int   printf(const char*, ...);
+
+void* kmalloc(size_t size) { return malloc(size); }
+void  kfree(void* ptr) { free(ptr); }
+
+#include "swap_device.h"
+#include "../kernel/swap_device.c"
+
+/* ----- Mock block device backed by a flat buffer ----- */
+
+#define SECTOR       512
+#define MOCK_SECTORS 4096          /* 2 MiB: 512 page slots */
+typedef struct {
+    uint8_t data[MOCK_SECTORS * SECTOR];
+    int reads, writes;             /* Commands issued */
+    bool fail_writes;
+} mock_dev_t;
+
+static int mock_read(void* dev, uint32_t sector, uint32_t count, void* buf) {
+    mock_dev_t* m = (mock_dev_t*)dev;
+    if (sector + count > MOCK_SECTORS) return -1;
+    memcpy(buf, m->data + (size_t)sector * SECTOR, (size_t)count * SECTOR);
+    m->reads++;
+    return 0;
+}
+
+static int mock_write(void* dev, uint32_t sector, uint32_t count, const void* buf) {
+    mock_dev_t* m = (mock_dev_t*)dev;
+    if (m->fail_writes || sector + count > MOCK_SECTORS) return -1;
+    memcpy(m->data + (size_t)sector * SECTOR, buf, (size_t)count * SECTOR);
+    m->writes++;
+    return 0;
+}
+
+static mock_dev_t g_mock;
+static fat_block_device_t g_bdev;
+
+static fat_block_device_t* make_dev(void) {
+    memset(&g_mock, 0, sizeof(g_mock));
+    g_bdev.read_sectors = mock_read;
+    g_bdev.write_sectors = mock_write;
+    g_bdev.sector_size = SECTOR;
+    g_bdev.total_sectors = MOCK_SECTORS;
+    g_bdev.private_data = &g_mock;
+    return &g_bdev;
+}
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+static void fill_page(uint8_t* p, uint32_t tag) {
+    for (int i = 0; i < SWAP_PAGE_SIZE; i++)
+        p[i] = (uint8_t)(tag * 13 + i);
+}
+
+static bool page_matches(const uint8_t* p, uint32_t tag) {
+    for (int i = 0; i < SWAP_PAGE_SIZE; i++)
+        if (p[i] != (uint8_t)(tag * 13 + i)) return false;
+    return true;
+}
+
+int main(void) {
+    static uint8_t page[SWAP_PAGE_SIZE];
+    const uint32_t base = 64, npages = 256;
+
+    printf("Test 1: clustered slot allocation\n");
+    {
+        swap_device_t swap;
+        CHECK(swap_device_init(&swap, make_dev(), MOCK_SECTORS - 8, 2) == SWAP_ERR_PARAM,
+              "area past end of device rejected");
+        CHECK(swap_device_init(&swap, make_dev(), base, npages) == SWAP_OK, "init");
+
+        uint32_t slots[SWAP_CLUSTER_PAGES + 1];
+        bool ok = true;
+        for (int i = 0; i <= SWAP_CLUSTER_PAGES; i++) {
+            ok = ok && swap_slot_alloc(&swap, &slots[i]) == SWAP_OK;
+        }
+        bool adjacent = true;
+        for (int i = 1; i < SWAP_CLUSTER_PAGES; i++) {
+            adjacent = adjacent && slots[i] == slots[i - 1] + 1;
+        }
+        CHECK(ok && adjacent, "one cluster yields adjacent slots");
+        CHECK(swap.stats.cluster_allocs == 2, "17th allocation opens a second cluster");
+        CHECK(swap.free_pages == npages - SWAP_CLUSTER_PAGES - 1, "free count tracks allocations");
+
+        swap_slot_free(&swap, slots[3]);
+        CHECK(!swap_slot_in_use(&swap, slots[3]) && swap.free_pages == npages - SWAP_CLUSTER_PAGES,
+              "free returns the slot");
+        swap_device_release(&swap);
+    }
+
+    printf("Test 2: batched writeout\n");
+    {
+        swap_device_t swap;
+        swap_device_init(&swap, make_dev(), base, npages);
+        uint32_t slots[SWAP_BATCH_PAGES + 4];
+        for (int i = 0; i < SWAP_BATCH_PAGES + 4; i++) {
+            swap_slot_alloc(&swap, &slots[i]);
+            fill_page(page, 100 + i);
+            swap_write_page(&swap, slots[i], page);
+        }
+        CHECK(g_mock.writes == 1 && swap.stats.pages_written == SWAP_BATCH_PAGES,
+              "a full batch of adjacent pages is one write command");
+        CHECK(swap_flush(&swap) == SWAP_OK && g_mock.writes == 2 &&
+              swap.stats.pages_written == SWAP_BATCH_PAGES + 4,
+              "flush issues the partial batch");
+        CHECK(page_matches(g_mock.data + (size_t)(base + slots[5] * 8) * SECTOR, 105),
+              "page lands at its slot's sectors");
+
+        /* A non-adjacent slot breaks the run. */
+        uint32_t a, b;
+        swap_slot_alloc(&swap, &a);
+        swap_slot_alloc(&swap, &b);
+        fill_page(page, 1);
+        swap_write_page(&swap, b, page);
+        swap_write_page(&swap, a, page);
+        CHECK(g_mock.writes == 3 && swap.batch_count == 1, "out-of-order slot flushes the run");
+        swap_device_release(&swap);
+        CHECK(g_mock.writes == 4, "release flushes pending writes");
+    }
+
+    printf("Test 3: readahead on swap-in\n");
+    {
+        swap_device_t swap;
+        swap_device_init(&swap, make_dev(), base, npages);
+        uint32_t slots[12];
+        for (int i = 0; i < 12; i++) {
+            swap_slot_alloc(&swap, &slots[i]);
+            fill_page(page, 200 + i);
+            swap_write_page(&swap, slots[i], page);
+        }
+        swap_flush(&swap);
+
+        int reads_before = g_mock.reads;
+        bool ok = true;
+        for (int i = 0; i < 12; i++) {
+            memset(page, 0, sizeof(page));
+            ok = ok && swap_read_page(&swap, slots[i], page) == SWAP_OK && page_matches(page, 200 + i);
+            swap_slot_free(&swap, slots[i]);   /* as demand paging does after swap-in */
+        }
+        CHECK(ok, "12 pages swap back in intact");
+        CHECK(g_mock.reads - reads_before == 2, "12 sequential faults cost 2 read commands");
+        CHECK(swap.stats.readahead_hits == 10 && swap.stats.readahead_pages == 10,
+              "neighbours are served from the readahead window");
+
+        /* A rewrite must invalidate the window. */
+        uint32_t s0, s1;
+        swap_slot_alloc(&swap, &s0);
+        swap_slot_alloc(&swap, &s1);
+        fill_page(page, 7);
+        swap_write_page(&swap, s0, page);
+        fill_page(page, 8);
+        swap_write_page(&swap, s1, page);
+        swap_flush(&swap);
+        swap_read_page(&swap, s0, page);
+        fill_page(page, 9);
+        swap_write_page(&swap, s1, page);
+        swap_flush(&swap);
+        swap_read_page(&swap, s1, page);
+        CHECK(page_matches(page, 9), "rewritten slot is not served from a stale window");
+        swap_device_release(&swap);
+    }
+
+    printf("Test 4: pending batch is never read stale\n");
+    {
+        swap_device_t swap;
+        swap_device_init(&swap, make_dev(), base, npages);
+        uint32_t s[3];
+        for (int i = 0; i < 3; i++) swap_slot_alloc(&swap, &s[i]);
+        fill_page(page, 40);
+        swap_write_page(&swap, s[0], page);
+        swap_flush(&swap);
+        fill_page(page, 41);
+        swap_write_page(&swap, s[1], page);
+        fill_page(page, 42);
+        swap_write_page(&swap, s[2], page);
+
+        swap_read_page(&swap, s[0], page);
+        CHECK(page_matches(page, 40) && swap.ra_count == 1,
+              "readahead stops before batched slots");
+        swap_read_page(&swap, s[2], page);
+        CHECK(page_matches(page, 42) && swap.stats.batch_hits == 1, "batched page served from memory");
+        swap_device_release(&swap);
+    }
+
+    printf("Test 5: fragmentation and errors\n");
+    {
+        swap_device_t swap;
+        swap_device_init(&swap, make_dev(), base, 32);
+        uint32_t s;
+        for (int i = 0; i < 32; i++) swap_slot_alloc(&swap, &s);
+        CHECK(swap_slot_alloc(&swap, &s) == SWAP_ERR_FULL, "full area reports SWAP_ERR_FULL");
+        swap_slot_free(&swap, 5);
+        swap_slot_free(&swap, 20);
+        CHECK(swap_slot_alloc(&swap, &s) == SWAP_OK && (s == 5 || s == 20),
+              "fragmented area still hands out single slots");
+
+        fill_page(page, 3);
+        g_mock.fail_writes = true;
+        swap_write_page(&swap, s, page);
+        CHECK(swap_flush(&swap) == SWAP_ERR_IO && swap.batch_count == 1 && swap.stats.io_errors == 1,
+              "failed flush is reported and the batch kept");
+        g_mock.fail_writes = false;
+        CHECK(swap_flush(&swap) == SWAP_OK, "retry succeeds");
+        CHECK(swap_read_page(&swap, 21, page) == SWAP_OK, "allocated slot readable");
+        swap_slot_free(&swap, 21);
+        CHECK(swap_read_page(&swap, 21, page) == SWAP_ERR_PARAM, "free slot rejected");
+        swap_device_release(&swap);
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
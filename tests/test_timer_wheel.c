@@ -0,0 +1,247 @@
+/* Host-side unit test for the hierarchical timer wheel.
+ *
+ * Verifies:
+ *   1. One-shot timers fire on exactly their tick, once, and a zero delay
+ *      means the next tick.
+ *   2. Cancel is O(1) from any position in a slot and reports whether the
+ *      timer was still pending.
+ *   3. Timers on every level fire on their exact tick after cascading, and a
+ *      delay past the top level still fires on time.
+ *   4. Periodic timers re-arm themselves and can be cancelled from their own
+ *      callback.
+ *   5. Callbacks may arm and cancel timers in the batch being expired.
+ *   6. A large random population fires in tick order with none lost, whether
+ *      advanced a tick at a time or in one jump.
+ *
+ * Build: gcc -I../include -o test_timer_wheel test_timer_wheel.c ../kernel/timer_wheel.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+extern int printf(const char*, ...);
+
+#include "timer_wheel.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+static timer_wheel_t wheel;
+
+/* Records when (and how often) it fired */
+typedef struct {
+    ktimer_t timer;
+    uint64_t fired_at;
+    uint32_t fires;
+} probe_t;
+
+static void probe_fire(void* data) {
+    probe_t* p = (probe_t*)data;
+    p->fired_at = wheel.now;
+    p->fires++;
+}
+
+static void probe_init(probe_t* p) {
+    p->fired_at = 0;
+    p->fires = 0;
+    ktimer_init(&p->timer, probe_fire, p);
+}
+
+/* Periodic timer that cancels itself on its third run */
+static void stop_after_three(void* data) {
+    probe_t* p = (probe_t*)data;
+    p->fires++;
+    if (p->fires == 3) {
+        timer_wheel_cancel(&wheel, &p->timer);
+    }
+}
+
+/* Batch interference: cancels `victim` and arms `spawn` */
+static probe_t batch_victim, batch_spawn;
+static void meddle(void* data) {
+    probe_t* p = (probe_t*)data;
+    p->fires++;
+    timer_wheel_cancel(&wheel, &batch_victim.timer);
+    timer_wheel_add(&wheel, &batch_spawn.timer, 0, 0);
+}
+
+/* Deterministic generator for the population test */
+static uint64_t rng_state = 0x2545F4914F6CDD1DULL;
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+#define NPOP 2000
+static probe_t pop[NPOP];
+static uint64_t pop_due[NPOP];
+static uint64_t last_fired;
+static bool in_order;
+
+static void pop_fire(void* data) {
+    probe_t* p = (probe_t*)data;
+    p->fired_at = wheel.now;
+    p->fires++;
+    if (wheel.now < last_fired) {
+        in_order = false;
+    }
+    last_fired = wheel.now;
+}
+
+static bool population_ok(void) {
+    for (int i = 0; i < NPOP; i++) {
+        if (pop[i].fires != 1 || pop[i].fired_at != pop_due[i]) return false;
+    }
+    return true;
+}
+
+static void population_arm(uint64_t start) {
+    timer_wheel_init(&wheel, start);
+    last_fired = 0;
+    in_order = true;
+    for (int i = 0; i < NPOP; i++) {
+        /* Mix of short, medium and long delays across all levels */
+        uint64_t span = (i % 4 == 0) ? 64 : (i % 4 == 1) ? 4096 : (i % 4 == 2) ? 262144 : 2000000;
+        uint64_t delay = 1 + rng_next() % span;
+        pop[i].fired_at = 0;
+        pop[i].fires = 0;
+        ktimer_init(&pop[i].timer, pop_fire, &pop[i]);
+        timer_wheel_add(&wheel, &pop[i].timer, delay, 0);
+        pop_due[i] = start + delay;
+    }
+}
+
+int main(void) {
+    printf("=== Timer wheel unit test ===\n");
+
+    /* --- 1. One-shot --- */
+    {
+        probe_t a, b;
+        timer_wheel_init(&wheel, 100);
+        probe_init(&a);
+        probe_init(&b);
+        timer_wheel_add(&wheel, &a.timer, 5, 0);
+        timer_wheel_add(&wheel, &b.timer, 0, 0);
+        CHECK(ktimer_pending(&a.timer) && wheel.pending == 2, "armed timers are pending");
+
+        CHECK(timer_wheel_advance(&wheel, 101) == 1 && b.fired_at == 101,
+              "zero delay fires on the next tick");
+        CHECK(timer_wheel_advance(&wheel, 104) == 0 && a.fires == 0, "nothing fires early");
+        CHECK(timer_wheel_advance(&wheel, 105) == 1 && a.fired_at == 105, "fires on its tick");
+        CHECK(timer_wheel_advance(&wheel, 200) == 0 && a.fires == 1 && !ktimer_pending(&a.timer) &&
+              wheel.pending == 0, "one-shot fires once");
+    }
+
+    /* --- 2. Cancel --- */
+    {
+        probe_t p[3];
+        timer_wheel_init(&wheel, 0);
+        for (int i = 0; i < 3; i++) {
+            probe_init(&p[i]);
+            timer_wheel_add(&wheel, &p[i].timer, 10, 0);   /* same slot */
+        }
+        CHECK(timer_wheel_cancel(&wheel, &p[1].timer), "cancel from the middle of a slot");
+        CHECK(timer_wheel_cancel(&wheel, &p[2].timer), "cancel the slot head");
+        CHECK(!timer_wheel_cancel(&wheel, &p[2].timer), "second cancel reports not pending");
+        timer_wheel_advance(&wheel, 10);
+        CHECK(p[0].fires == 1 && p[1].fires == 0 && p[2].fires == 0, "only the survivor fires");
+        CHECK(!timer_wheel_cancel(&wheel, &p[0].timer) && wheel.stats.cancelled == 2,
+              "cancel after expiry reports it already fired");
+
+        /* Re-arming a pending timer moves it */
+        probe_init(&p[0]);
+        timer_wheel_add(&wheel, &p[0].timer, 5, 0);
+        timer_wheel_add(&wheel, &p[0].timer, 50, 0);
+        timer_wheel_advance(&wheel, 59);
+        CHECK(p[0].fires == 0 && wheel.pending == 1, "re-arm replaces the earlier expiry");
+        timer_wheel_advance(&wheel, 60);
+        CHECK(p[0].fired_at == 60, "and fires at the new one");
+    }
+
+    /* --- 3. Every level, cascading --- */
+    {
+        static const uint64_t delays[] = { 63, 64, 65, 4095, 4096, 4097, 262143, 262144,
+                                           300001, TIMER_WHEEL_MAX_DELAY,
+                                           TIMER_WHEEL_MAX_DELAY + 12345 };
+        const int n = (int)(sizeof(delays) / sizeof(delays[0]));
+        probe_t p[sizeof(delays) / sizeof(delays[0])];
+        const uint64_t start = 1000037;   /* unaligned to any level */
+        timer_wheel_init(&wheel, start);
+        for (int i = 0; i < n; i++) {
+            probe_init(&p[i]);
+            timer_wheel_add(&wheel, &p[i].timer, delays[i], 0);
+        }
+
+        bool exact = true;
+        for (int i = 0; i < n; i++) {
+            timer_wheel_advance(&wheel, start + delays[i] - 1);
+            if (p[i].fires != 0) exact = false;
+            timer_wheel_advance(&wheel, start + delays[i]);
+            if (p[i].fires != 1 || p[i].fired_at != start + delays[i]) exact = false;
+        }
+        CHECK(exact, "timers on every level fire exactly on their tick");
+        CHECK(wheel.stats.cascaded > 0 && wheel.pending == 0, "upper levels were cascaded down");
+    }
+
+    /* --- 4. Periodic --- */
+    {
+        probe_t p;
+        timer_wheel_init(&wheel, 0);
+        probe_init(&p);
+        timer_wheel_add(&wheel, &p.timer, 10, 10);
+        timer_wheel_advance(&wheel, 35);
+        CHECK(p.fires == 3 && p.fired_at == 30 && ktimer_pending(&p.timer), "periodic re-arms");
+        timer_wheel_advance(&wheel, 1000);
+        CHECK(p.fires == 100, "keeps its phase over many periods");
+        timer_wheel_cancel(&wheel, &p.timer);
+
+        probe_t q = {0};
+        ktimer_init(&q.timer, stop_after_three, &q);
+        timer_wheel_add(&wheel, &q.timer, 1, 7);
+        timer_wheel_advance(&wheel, 2000);
+        CHECK(q.fires == 3 && !ktimer_pending(&q.timer) && wheel.pending == 0,
+              "callback can cancel its own periodic timer");
+    }
+
+    /* --- 5. Callbacks touching their own batch --- */
+    {
+        probe_t first = {0};
+        timer_wheel_init(&wheel, 0);
+        probe_init(&batch_victim);
+        probe_init(&batch_spawn);
+        ktimer_init(&first.timer, meddle, &first);
+        /* Linked at the slot head, so it runs before the victim */
+        timer_wheel_add(&wheel, &batch_victim.timer, 3, 0);
+        timer_wheel_add(&wheel, &first.timer, 3, 0);
+
+        CHECK(timer_wheel_advance(&wheel, 3) == 1 && batch_victim.fires == 0,
+              "callback can cancel a timer in the same batch");
+        CHECK(batch_spawn.fires == 0 && ktimer_pending(&batch_spawn.timer),
+              "a timer armed from a callback waits for the next tick");
+        timer_wheel_advance(&wheel, 4);
+        CHECK(batch_spawn.fired_at == 4, "then fires");
+    }
+
+    /* --- 6. Random population --- */
+    {
+        population_arm(77);
+        for (uint64_t t = 78; t <= 77 + 2000000; t++) {
+            timer_wheel_advance(&wheel, t);
+        }
+        CHECK(population_ok() && in_order, "ticked: every timer fired once, on time, in order");
+
+        population_arm(5);
+        uint32_t fired = timer_wheel_advance(&wheel, 5 + 2000000);
+        CHECK(fired == NPOP && population_ok() && in_order && wheel.pending == 0,
+              "jump: catching up fires the same timers on the same ticks");
+        CHECK(wheel.stats.expired == NPOP && wheel.stats.started == NPOP, "stats add up");
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
@@ -9,7 +9,7 @@
 #include <sys/time.h>
 
 /* Performance test configuration */
-#define PERF_VMA_COUNT 1000
+#define PERF_VMA_COUNT 100000
 #define PERF_MAPPING_COUNT 500
 #define PERF_SHM_COUNT 100
 #define PERF_COW_PAGES 1000
@@ -517,7 +517,7 @@ int main(void) {
 /* Simple malloc/free stubs if not available */
 #ifndef malloc
 void* malloc(size_t size) {
-    static char buffer[1024 * 1024]; /* 1MB static buffer */
+    static char buffer[64 * 1024 * 1024]; /* 64MB static buffer (100k VMAs) */
     static size_t offset = 0;
     
     if (offset + size > sizeof(buffer)) {
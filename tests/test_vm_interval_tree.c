@@ -0,0 +1,258 @@
+/* Host-side test for the augmented VM interval tree.
+ *
+ * Drives vm_interval_tree.c through randomized insert/resize/remove sequences
+ * and checks every query (find, lower_bound, first_overlap, find_gap) against
+ * a brute-force scan of the same intervals, validating the red-black and gap
+ * invariants along the way. Finishes with a 100k-node lookup/gap timing run.
+ *
+ * Build: gcc -I../include -o test_vm_interval_tree test_vm_interval_tree.c \
+ *            ../kernel/vm_interval_tree.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "vm_interval_tree.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+#define PAGE      0x1000ULL
+#define LOW       0x400000ULL
+#define HIGH      0x800000000ULL
+#define SLOTS     512
+
+/* An owner structure with the node embedded mid-struct, as vm_region_t does. */
+typedef struct {
+    uint32_t tag;
+    vm_itree_node_t node;
+    bool live;
+} owner_t;
+
+static owner_t owners[SLOTS];
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static uint64_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+/* Brute-force reference queries over the live owners. */
+static owner_t* ref_find(uint64_t addr) {
+    for (int i = 0; i < SLOTS; i++) {
+        if (owners[i].live && addr >= owners[i].node.start && addr < owners[i].node.end) {
+            return &owners[i];
+        }
+    }
+    return NULL;
+}
+
+static owner_t* ref_lower_bound(uint64_t addr) {
+    owner_t* best = NULL;
+    for (int i = 0; i < SLOTS; i++) {
+        if (owners[i].live && addr < owners[i].node.end &&
+            (!best || owners[i].node.start < best->node.start)) {
+            best = &owners[i];
+        }
+    }
+    return best;
+}
+
+static bool ref_range_free(uint64_t start, uint64_t end) {
+    for (int i = 0; i < SLOTS; i++) {
+        if (owners[i].live && owners[i].node.start < end && start < owners[i].node.end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool ref_find_gap(uint64_t len, uint64_t floor, uint64_t ceiling, uint64_t* out) {
+    /* Candidate starts are the floor and every interval end. */
+    bool found = false;
+    uint64_t best = 0;
+    uint64_t cand[SLOTS + 1];
+    int nc = 0;
+    cand[nc++] = floor;
+    for (int i = 0; i < SLOTS; i++) {
+        if (owners[i].live && owners[i].node.end >= floor) {
+            cand[nc++] = owners[i].node.end;
+        }
+    }
+    for (int i = 0; i < nc; i++) {
+        uint64_t a = cand[i];
+        if (a + len <= ceiling && ref_range_free(a, a + len) && (!found || a < best)) {
+            best = a;
+            found = true;
+        }
+    }
+    if (found) *out = best;
+    return found;
+}
+
+static int randomized_run(vm_itree_t* tree, int steps) {
+    int mismatches = 0;
+    for (int step = 0; step < steps; step++) {
+        int slot = (int)(rng() % SLOTS);
+        owner_t* o = &owners[slot];
+        uint64_t op = rng() % 10;
+
+        if (!o->live) {
+            uint64_t start = LOW + (rng() % 4096) * PAGE;
+            uint64_t len = (1 + rng() % 16) * PAGE;
+            int rc = vm_itree_insert(tree, &o->node, start, start + len);
+            bool expect = ref_range_free(start, start + len);
+            if ((rc == VM_ITREE_OK) != expect) mismatches++;
+            if (rc == VM_ITREE_OK) o->live = true;
+        } else if (op < 3) {
+            /* Trim or grow in place, bounded by the neighbours. */
+            vm_itree_node_t* prev = vm_itree_prev(&o->node);
+            vm_itree_node_t* next = vm_itree_next(&o->node);
+            uint64_t lo = prev ? prev->end : LOW;
+            uint64_t hi = next ? next->start : HIGH;
+            uint64_t s = o->node.start, e = o->node.end;
+            if (rng() & 1) {
+                if (s > lo) s -= PAGE;
+            } else if (e - s > PAGE) {
+                s += PAGE;
+            }
+            if (rng() & 1) {
+                if (e < hi) e += PAGE;
+            } else if (e - s > PAGE) {
+                e -= PAGE;
+            }
+            if (vm_itree_resize(tree, &o->node, s, e) != VM_ITREE_OK) mismatches++;
+        } else {
+            vm_itree_remove(tree, &o->node);
+            o->live = false;
+        }
+
+        if ((step % 64) == 0 && !vm_itree_validate(tree)) {
+            mismatches++;
+        }
+
+        uint64_t probe = LOW + (rng() % (4200 * PAGE));
+        vm_itree_node_t* n = vm_itree_find(tree, probe);
+        owner_t* want = ref_find(probe);
+        if ((n ? VM_ITREE_ENTRY(n, owner_t, node) : NULL) != want) mismatches++;
+
+        n = vm_itree_lower_bound(tree, probe);
+        want = ref_lower_bound(probe);
+        if ((n ? VM_ITREE_ENTRY(n, owner_t, node) : NULL) != want) mismatches++;
+
+        uint64_t len = (1 + rng() % 24) * PAGE;
+        uint64_t floor = LOW + (rng() % 4096) * PAGE;
+        uint64_t ceiling = floor + (rng() % 8192) * PAGE;
+        uint64_t got = 0, ref = 0;
+        bool g1 = vm_itree_find_gap(tree, len, floor, ceiling, &got);
+        bool g2 = ref_find_gap(len, floor, ceiling, &ref);
+        if (g1 != g2 || (g1 && got != ref)) mismatches++;
+    }
+    return mismatches;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(void) {
+    printf("Test: augmented VM interval tree\n");
+
+    vm_itree_t tree;
+    vm_itree_init(&tree, LOW, HIGH);
+
+    /* Basic placement and neighbours. */
+    CHECK(vm_itree_insert(&tree, &owners[0].node, LOW + 4 * PAGE, LOW + 8 * PAGE) == VM_ITREE_OK,
+          "insert [4,8)");
+    owners[0].live = true;
+    CHECK(vm_itree_insert(&tree, &owners[1].node, LOW + 12 * PAGE, LOW + 14 * PAGE) == VM_ITREE_OK,
+          "insert [12,14)");
+    owners[1].live = true;
+    CHECK(vm_itree_insert(&tree, &owners[2].node, LOW + 7 * PAGE, LOW + 9 * PAGE) == VM_ITREE_EOVERLAP,
+          "overlapping insert rejected");
+    CHECK(vm_itree_insert(&tree, &owners[2].node, LOW, LOW) == VM_ITREE_EINVAL,
+          "empty interval rejected");
+    CHECK(vm_itree_find(&tree, LOW + 5 * PAGE) == &owners[0].node, "find inside first interval");
+    CHECK(vm_itree_find(&tree, LOW + 8 * PAGE) == NULL, "end is exclusive");
+    CHECK(vm_itree_lower_bound(&tree, LOW + 9 * PAGE) == &owners[1].node, "lower_bound skips to next");
+    CHECK(VM_ITREE_ENTRY(vm_itree_first(&tree), owner_t, node) == &owners[0], "container recovery");
+
+    uint64_t a = 0;
+    CHECK(vm_itree_find_gap(&tree, 4 * PAGE, LOW, HIGH, &a) && a == LOW, "gap below first interval");
+    CHECK(vm_itree_find_gap(&tree, 5 * PAGE, LOW, HIGH, &a) && a == LOW + 14 * PAGE,
+          "large request goes above the last interval");
+    CHECK(vm_itree_find_gap(&tree, 3 * PAGE, LOW + 5 * PAGE, HIGH, &a) && a == LOW + 8 * PAGE,
+          "floor skips lower gaps");
+    CHECK(!vm_itree_find_gap(&tree, 5 * PAGE, LOW + 5 * PAGE, LOW + 16 * PAGE, &a),
+          "ceiling bounds the trailing gap");
+    CHECK(vm_itree_first_overlap(&tree, LOW + 9 * PAGE, LOW + 13 * PAGE) == &owners[1].node,
+          "first_overlap finds the straddled interval");
+
+    CHECK(vm_itree_resize(&tree, &owners[0].node, LOW + 4 * PAGE, LOW + 12 * PAGE) == VM_ITREE_OK,
+          "grow up to the neighbour");
+    CHECK(vm_itree_resize(&tree, &owners[0].node, LOW + 4 * PAGE, LOW + 13 * PAGE) == VM_ITREE_EOVERLAP,
+          "grow into the neighbour rejected");
+    CHECK(vm_itree_validate(&tree), "tree valid after resize");
+
+    vm_itree_remove(&tree, &owners[0].node);
+    owners[0].live = false;
+    CHECK(vm_itree_find_gap(&tree, 12 * PAGE, LOW, HIGH, &a) && a == LOW, "removal reopens the gap");
+    CHECK(vm_itree_validate(&tree) && tree.count == 1, "tree valid after remove");
+    vm_itree_remove(&tree, &owners[1].node);
+    owners[1].live = false;
+
+    /* Randomized differential run against brute force. */
+    int mismatches = randomized_run(&tree, 20000);
+    CHECK(mismatches == 0, "20000 random ops match brute-force reference");
+    CHECK(vm_itree_validate(&tree), "tree valid after random ops");
+
+    /* Scale: 100k intervals with a hole every 16th slot. */
+    enum { BIG = 100000 };
+    vm_itree_t big;
+    vm_itree_init(&big, LOW, HIGH);
+    owner_t* many = calloc(BIG, sizeof(owner_t));
+    int ins_fail = 0;
+    double t0 = now_sec();
+    for (int i = 0; i < BIG; i++) {
+        uint64_t s = LOW + (uint64_t)i * 2 * PAGE;
+        uint64_t e = s + ((i % 16) == 15 ? PAGE : 2 * PAGE);
+        if (vm_itree_insert(&big, &many[i].node, s, e) != VM_ITREE_OK) ins_fail++;
+    }
+    double t1 = now_sec();
+    int lookup_fail = 0;
+    for (int i = 0; i < BIG; i++) {
+        int k = (int)(rng() % BIG);
+        uint64_t addr = LOW + (uint64_t)k * 2 * PAGE + 0x10;
+        if (vm_itree_find(&big, addr) != &many[k].node) lookup_fail++;
+    }
+    double t2 = now_sec();
+    int gap_fail = 0;
+    for (int i = 0; i < 1000; i++) {
+        uint64_t floor = LOW + (rng() % BIG) * 2 * PAGE;
+        uint64_t got;
+        if (!vm_itree_find_gap(&big, PAGE, floor, HIGH, &got) || got < floor) gap_fail++;
+    }
+    double t3 = now_sec();
+    CHECK(ins_fail == 0, "100k inserts");
+    CHECK(lookup_fail == 0, "100k random lookups");
+    CHECK(gap_fail == 0, "1000 gap searches");
+    CHECK(vm_itree_validate(&big), "100k-node tree valid");
+    printf("  100k: insert %.1f ns/op, lookup %.1f ns/op, gap %.1f ns/op\n",
+           (t1 - t0) * 1e9 / BIG, (t2 - t1) * 1e9 / BIG, (t3 - t2) * 1e9 / 1000);
+    free(many);
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
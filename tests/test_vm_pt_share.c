@@ -0,0 +1,281 @@
+/* Host-side unit test and benchmark for leaf page tables shared across fork.
+ *
+ * Verifies:
+ *   1. Fork shares each leaf table by reference: both PD entries point at
+ *      the same table, write-protected, and no PTE or data frame is touched.
+ *   2. The first change in one space copies the table, adds a reference to
+ *      every mapped frame and write-protects them on both sides.
+ *   3. The last user takes the table back without copying.
+ *   4. A child that exits without writing drops its reference, leaving the
+ *      parent's PTEs writable with no per-page fault to come.
+ *   5. Forks of forks stack references on the same table.
+ *   6. Huge entries are shared frame by frame and never tagged.
+ *   7. Running out of memory while unsharing changes nothing.
+ *   8. Fork latency against address-space size: per-page copying grows with
+ *      the pages mapped, table sharing only with the tables.
+ *
+ * Build: gcc -O2 -I../include -o test_vm_pt_share test_vm_pt_share.c ../kernel/vm_pt_share.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "vm_pt_share.h"
+
+static int failures = 0;
+#define CHECK(cond, msg) do { \
+    if (!(cond)) { printf("  FAIL: %s\n", msg); failures++; } \
+    else { printf("  ok:   %s\n", msg); } \
+} while (0)
+
+/* Simulated physical memory: frames below TABLE_FRAMES are page-table
+ * pages backed by real storage; above that only reference counts exist. */
+#define TABLE_FRAMES    1200
+#define DATA_BASE       0x10000ULL         /* First data frame number */
+#define TOTAL_FRAMES    (DATA_BASE + 0x40000ULL + HUGE_PAGE_FRAMES * 4)
+
+static pte_t table_mem[TABLE_FRAMES][VM_PT_ENTRIES];
+static uint32_t refs[TOTAL_FRAMES];
+static uint32_t next_table;
+static bool alloc_fails;
+static uint64_t ref_lookups;
+
+static pte_t* sim_table(uint64_t phys) {
+    return table_mem[phys >> 12];
+}
+
+static uint32_t* sim_ref_count(uint64_t phys) {
+    ref_lookups++;
+    return &refs[phys >> 12];
+}
+
+static uint64_t sim_alloc_table(void) {
+    if (alloc_fails || next_table >= TABLE_FRAMES) {
+        return 0;
+    }
+    uint64_t frame = next_table++;
+    memset(table_mem[frame], 0, sizeof(table_mem[frame]));
+    refs[frame] = 1;
+    return frame << 12;
+}
+
+static vm_pt_share_t pt = {
+    .table = sim_table,
+    .ref_count = sim_ref_count,
+    .alloc_table = sim_alloc_table,
+};
+
+#define USER_RW     (PAGE_PRESENT | PAGE_WRITABLE | PAGE_USER)
+
+static void sim_reset(void) {
+    memset(refs, 0, sizeof(refs));
+    next_table = 1;                         /* Frame 0 stays unused */
+    alloc_fails = false;
+    pt.stats = (vm_pt_share_stats_t){0};
+}
+
+/* Fill PD entries [0, tables) with leaf tables whose every entry maps a
+ * writable data frame with one reference. */
+static void build_space(pte_t* pd, uint32_t tables) {
+    memset(pd, 0, VM_PT_ENTRIES * sizeof(pte_t));
+    uint64_t data = DATA_BASE;
+    for (uint32_t t = 0; t < tables; t++) {
+        uint64_t phys = sim_alloc_table();
+        pte_t* table = sim_table(phys);
+        for (uint32_t i = 0; i < VM_PT_ENTRIES; i++) {
+            table[i] = (data << 12) | USER_RW;
+            refs[data++] = 1;
+        }
+        pd[t] = phys | USER_RW;
+    }
+}
+
+static uint64_t pde_table(pte_t pde) {
+    return pde & 0x000FFFFFFFFFF000ULL;
+}
+
+/* Fork as the VMM did before table sharing: one step per mapped page */
+static void fork_per_page(pte_t* src_pd, pte_t* dst_pd, uint32_t tables) {
+    for (uint32_t t = 0; t < tables; t++) {
+        pte_t* src = sim_table(pde_table(src_pd[t]));
+        uint64_t phys = sim_alloc_table();
+        pte_t* dst = sim_table(phys);
+        for (uint32_t i = 0; i < VM_PT_ENTRIES; i++) {
+            if (src[i] & PAGE_PRESENT) {
+                src[i] &= ~(pte_t)PAGE_WRITABLE;
+                dst[i] = src[i];
+                (*sim_ref_count(src[i] & 0x000FFFFFFFFFF000ULL))++;
+            }
+        }
+        dst_pd[t] = phys | USER_RW;
+    }
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static pte_t parent[VM_PT_ENTRIES], child[VM_PT_ENTRIES], grandchild[VM_PT_ENTRIES];
+
+int main(void) {
+    printf("=== Shared leaf page table unit test ===\n");
+
+    /* --- 1. Fork shares tables --- */
+    {
+        sim_reset();
+        build_space(parent, 4);
+        memset(child, 0, sizeof(child));
+        uint64_t t0 = pde_table(parent[0]);
+        pte_t pte0 = sim_table(t0)[0];
+
+        ref_lookups = 0;
+        CHECK(vm_pt_share_fork(&pt, parent, child, 0, VM_PT_ENTRIES) == 4,
+              "fork shares every present PD entry");
+        CHECK(ref_lookups == 4, "one reference update per table, none per page");
+        CHECK(pde_table(child[0]) == t0 && refs[t0 >> 12] == 2, "child points at the parent's table");
+        CHECK(vm_pt_is_shared(parent[0]) && vm_pt_is_shared(child[0]) &&
+              !(parent[0] & PAGE_WRITABLE) && !(child[0] & PAGE_WRITABLE),
+              "both entries tagged and write-protected");
+        CHECK(sim_table(t0)[0] == pte0 && refs[DATA_BASE] == 1, "PTEs and data frames untouched");
+        CHECK(pt.stats.shared == 4, "sharing counted");
+    }
+
+    /* --- 2. First write in the child copies --- */
+    {
+        uint64_t t0 = pde_table(parent[0]);
+        sim_table(t0)[7] = 0x5A5A000ULL;      /* Not present: e.g. a swap entry */
+        sim_table(t0)[8] &= ~(pte_t)PAGE_WRITABLE;
+        uint32_t before = next_table;
+
+        CHECK(vm_pt_unshare(&pt, &child[0]) == VM_PT_OK && next_table == before + 1,
+              "child's first write allocates one table");
+        pte_t* copy = sim_table(pde_table(child[0]));
+        CHECK(pde_table(child[0]) != t0 && !vm_pt_is_shared(child[0]) &&
+              (child[0] & PAGE_WRITABLE), "child now owns a writable copy");
+        CHECK(refs[t0 >> 12] == 1 && vm_pt_is_shared(parent[0]), "original keeps one user");
+        CHECK(refs[DATA_BASE] == 2 && refs[DATA_BASE + 511] == 2, "mapped frames gained a reference");
+        CHECK(!(copy[0] & PAGE_WRITABLE) && !(sim_table(t0)[0] & PAGE_WRITABLE),
+              "writable entries write-protected on both sides");
+        CHECK(copy[7] == 0x5A5A000ULL && refs[0x5A5A] == 0, "non-present entries copied verbatim");
+        CHECK(vm_pt_unshare(&pt, &child[0]) == VM_PT_OK && pt.stats.copied == 1,
+              "unsharing a private table is a no-op");
+
+        /* --- 3. Last user takes it back --- */
+        before = next_table;
+        CHECK(vm_pt_unshare(&pt, &parent[0]) == VM_PT_OK && next_table == before &&
+              pde_table(parent[0]) == t0 && (parent[0] & PAGE_WRITABLE) &&
+              !vm_pt_is_shared(parent[0]), "parent reuses the original without copying");
+        CHECK(!(sim_table(t0)[0] & PAGE_WRITABLE) && pt.stats.reused == 1,
+              "its shared frames stay copy-on-write per page");
+    }
+
+    /* --- 4. Child exits without writing --- */
+    {
+        uint64_t t1 = pde_table(parent[1]);
+        CHECK(vm_pt_drop(&pt, &child[1]) && child[1] == 0 && refs[t1 >> 12] == 1,
+              "exiting child drops its reference");
+        CHECK(vm_pt_unshare(&pt, &parent[1]) == VM_PT_OK && pde_table(parent[1]) == t1 &&
+              (sim_table(t1)[0] & PAGE_WRITABLE) && refs[DATA_BASE + 512] == 1,
+              "parent's PTEs are writable again with no page copied");
+
+        /* Dropping the last user hands the table back instead */
+        uint64_t t2 = pde_table(parent[2]);
+        CHECK(vm_pt_drop(&pt, &child[2]), "child drops table 2");
+        CHECK(!vm_pt_drop(&pt, &parent[2]) && pde_table(parent[2]) == t2 &&
+              !vm_pt_is_shared(parent[2]), "last user's drop leaves it to unmap normally");
+        CHECK(pt.stats.dropped == 2, "drops counted");
+    }
+
+    /* --- 5. Fork of a fork --- */
+    {
+        uint64_t t3 = pde_table(parent[3]);
+        memset(grandchild, 0, sizeof(grandchild));
+        vm_pt_share_fork(&pt, child, grandchild, 3, 4);
+        CHECK(refs[t3 >> 12] == 3 && pde_table(grandchild[3]) == t3, "grandchild adds a third user");
+        CHECK(vm_pt_drop(&pt, &grandchild[3]) && vm_pt_drop(&pt, &child[3]) &&
+              refs[t3 >> 12] == 1, "references unwind one per exit");
+    }
+
+    /* --- 6. Huge entries --- */
+    {
+        sim_reset();
+        memset(parent, 0, sizeof(parent));
+        memset(child, 0, sizeof(child));
+        uint64_t base = DATA_BASE + 0x40000ULL;
+        for (uint64_t f = 0; f < HUGE_PAGE_FRAMES; f++) refs[base + f] = 1;
+        parent[5] = (base << 12) | USER_RW | PAGE_LARGE;
+
+        CHECK(vm_pt_share_fork(&pt, parent, child, 0, VM_PT_ENTRIES) == 1 &&
+              child[5] == parent[5] && !(child[5] & PAGE_WRITABLE), "huge entry shared read-only");
+        CHECK(refs[base] == 2 && refs[base + HUGE_PAGE_FRAMES - 1] == 2,
+              "every frame of the huge page gained a reference");
+        CHECK(!vm_pt_is_shared(child[5]) && vm_pt_unshare(&pt, &child[5]) == VM_PT_OK &&
+              child[5] == parent[5] && pt.stats.huge_shared == 1,
+              "huge entries are left to the huge COW path");
+    }
+
+    /* --- 7. Out of memory --- */
+    {
+        sim_reset();
+        build_space(parent, 1);
+        memset(child, 0, sizeof(child));
+        vm_pt_share_fork(&pt, parent, child, 0, 1);
+        pte_t saved_pde = child[0];
+        pte_t saved_pte = sim_table(pde_table(parent[0]))[0];
+        alloc_fails = true;
+        CHECK(vm_pt_unshare(&pt, &child[0]) == VM_PT_ENOMEM && child[0] == saved_pde &&
+              sim_table(pde_table(parent[0]))[0] == saved_pte && refs[DATA_BASE] == 1,
+              "failed copy leaves table, entries and counts alone");
+    }
+
+    /* --- 8. Fork latency against address-space size --- */
+    {
+        static const uint32_t sizes[] = { 1, 4, 16, 64, 256, 512 };   /* 2MB tables */
+        const int rounds = 20;
+        uint64_t page_ns = 0, share_ns = 0;
+        bool scales_with_tables = true;
+
+        printf("  %8s %8s %14s %14s\n", "space", "pages", "per-page ns", "shared ns");
+        for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            uint32_t tables = sizes[s];
+            page_ns = share_ns = 0;
+
+            for (int r = 0; r < rounds; r++) {
+                sim_reset();
+                build_space(parent, tables);
+                uint64_t start = now_ns();
+                fork_per_page(parent, child, tables);
+                page_ns += now_ns() - start;
+
+                sim_reset();
+                build_space(parent, tables);
+                ref_lookups = 0;
+                start = now_ns();
+                vm_pt_share_fork(&pt, parent, child, 0, VM_PT_ENTRIES);
+                share_ns += now_ns() - start;
+                if (ref_lookups != tables) {
+                    scales_with_tables = false;
+                }
+                /* Child exits, parent takes its tables back */
+                for (uint32_t t = 0; t < tables; t++) {
+                    vm_pt_drop(&pt, &child[t]);
+                    vm_pt_unshare(&pt, &parent[t]);
+                }
+            }
+            printf("  %6uMB %8u %14llu %14llu\n", tables * 2, tables * VM_PT_ENTRIES,
+                   (unsigned long long)(page_ns / rounds), (unsigned long long)(share_ns / rounds));
+        }
+        CHECK(scales_with_tables, "shared fork does one reference update per table");
+        CHECK(share_ns * 8 < page_ns, "1GB fork is far cheaper with shared tables");
+        CHECK(next_table == 513, "exit and reuse allocated no tables");
+    }
+
+    printf("\n%s (%d failure%s)\n", failures ? "FAILED" : "PASSED",
+           failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
@@ -304,6 +304,62 @@ static void test_copy_on_write(void) {
     vmm_destroy_address_space(child_space);
 }
 
+/**
+ * Test 2MB huge page mappings
+ */
+static void test_huge_pages(void) {
+    printf("\n=== Testing Huge Pages ===\n");
+    
+    vm_space_t* space = vmm_create_address_space(252627);
+    TEST_ASSERT(space != NULL, "Test address space creation");
+    
+    vmm_stats_t* stats = vmm_get_stats();
+    uint64_t huge_before = stats->huge_pages;
+    
+    // A 4MB huge allocation is placed 2MB aligned and backed by PD entries
+    uint64_t size = 2 * HUGE_PAGE_SIZE;
+    void* mem = vmm_alloc_virtual(space, size,
+                                  VMM_FLAG_READ | VMM_FLAG_WRITE | VMM_FLAG_USER | VMM_FLAG_HUGE);
+    TEST_ASSERT(mem != NULL, "Huge page allocation");
+    uint64_t base = (uint64_t)mem;
+    TEST_ASSERT((base & (HUGE_PAGE_SIZE - 1)) == 0, "Huge allocation is 2MB aligned");
+    TEST_ASSERT(vmm_get_huge_entry(space, base) != NULL, "Span mapped by a huge PD entry");
+    TEST_ASSERT(stats->huge_pages == huge_before + 2, "Huge page count updated");
+    
+    uint64_t phys = vmm_get_physical_addr(space, base);
+    TEST_ASSERT(vmm_get_physical_addr(space, base + 0x1234) == phys + 0x1234,
+                "Offsets resolve within the huge page");
+    
+    // Unmapping one 4KB page splits the huge page and leaves its neighbours
+    uint64_t splits_before = stats->huge_splits;
+    int result = vmm_unmap_page(space, base + PAGE_SIZE);
+    TEST_ASSERT(result == VMM_SUCCESS, "Partial unmap of a huge page");
+    TEST_ASSERT(stats->huge_splits == splits_before + 1, "Partial unmap splits the huge page");
+    TEST_ASSERT(vmm_get_huge_entry(space, base) == NULL, "Split span uses a page table");
+    TEST_ASSERT(vmm_get_physical_addr(space, base + PAGE_SIZE) == 0, "Unmapped page is gone");
+    TEST_ASSERT(vmm_get_physical_addr(space, base + 2 * PAGE_SIZE) == phys + 2 * PAGE_SIZE,
+                "Neighbouring pages keep their frames");
+    
+    // Fork shares the untouched huge page; a write splits only the child
+    vm_space_t* child = vmm_copy_address_space(space, 282930);
+    TEST_ASSERT(child != NULL, "Child address space creation");
+    uint64_t upper = base + HUGE_PAGE_SIZE;
+    TEST_ASSERT(vmm_get_huge_entry(child, upper) != NULL, "Child shares the huge page");
+    TEST_ASSERT(vmm_get_physical_addr(child, upper) == vmm_get_physical_addr(space, upper),
+                "Shared huge page maps the same frames");
+    
+    result = vmm_handle_cow_fault(child, upper + PAGE_SIZE);
+    TEST_ASSERT(result == VMM_SUCCESS, "COW fault on a shared huge page");
+    TEST_ASSERT(vmm_get_physical_addr(child, upper + PAGE_SIZE) !=
+                vmm_get_physical_addr(space, upper + PAGE_SIZE), "Written page copied");
+    TEST_ASSERT(vmm_get_physical_addr(child, upper) == vmm_get_physical_addr(space, upper),
+                "Unwritten pages still shared after the split");
+    
+    vmm_destroy_address_space(child);
+    vmm_free_virtual(space, mem, size);
+    vmm_destroy_address_space(space);
+}
+
 /**
  * Test memory mapping (mmap-like)
  */
@@ -434,6 +490,7 @@ void vmm_run_tests(void) {
     test_page_mapping();
     test_heap_expansion();
     test_copy_on_write();
+    test_huge_pages();
     test_memory_mapping();
     test_address_utilities();
     test_error_conditions();
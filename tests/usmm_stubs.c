@@ -36,6 +36,7 @@ mm_struct_t* mm_alloc(void) {
         mm->start_brk = 0x400000;
         mm->start_stack = 0x700000000000ULL;
         mm->mmap_base = 0x200000000000ULL;
+        vm_itree_init(&mm->mm_rb, 0, mm->task_size);
     }
     return mm;
 }
@@ -63,6 +64,7 @@ mm_struct_t* mm_copy(mm_struct_t* oldmm) {
         atomic_set(&mm->mm_count, 1);
         mm->mmap = NULL; /* Reset VMA list */
         mm->map_count = 0;
+        vm_itree_init(&mm->mm_rb, 0, mm->task_size);
     }
     return mm;
 }
@@ -72,6 +74,11 @@ mm_struct_t* mm_copy(mm_struct_t* oldmm) {
 int insert_vm_area(mm_struct_t* mm, vm_area_struct_t* vma) {
     if (!mm || !vma) return -USMM_EINVAL;
     
+    /* Index through the real interval tree so lookups are O(log n) */
+    if (vm_itree_insert(&mm->mm_rb, &vma->vm_rb, vma->vm_start, vma->vm_end) != VM_ITREE_OK) {
+        return -USMM_EINVAL;
+    }
+    
     vma->vm_mm = mm;
     vma->vm_next = mm->mmap;
     if (mm->mmap) {
@@ -87,6 +94,8 @@ int insert_vm_area(mm_struct_t* mm, vm_area_struct_t* vma) {
 int remove_vm_area(mm_struct_t* mm, vm_area_struct_t* vma) {
     if (!mm || !vma) return -USMM_EINVAL;
     
+    vm_itree_remove(&mm->mm_rb, &vma->vm_rb);
+    
     /* Remove from linked list */
     if (vma->vm_prev) {
         vma->vm_prev->vm_next = vma->vm_next;
@@ -106,27 +115,15 @@ int remove_vm_area(mm_struct_t* mm, vm_area_struct_t* vma) {
 vm_area_struct_t* find_vma(mm_struct_t* mm, uint64_t addr) {
     if (!mm) return NULL;
     
-    vm_area_struct_t* vma = mm->mmap;
-    while (vma) {
-        if (addr >= vma->vm_start && addr < vma->vm_end) {
-            return vma;
-        }
-        vma = vma->vm_next;
-    }
-    return NULL;
+    vm_itree_node_t* node = vm_itree_find(&mm->mm_rb, addr);
+    return node ? VM_ITREE_ENTRY(node, vm_area_struct_t, vm_rb) : NULL;
 }
 
 vm_area_struct_t* find_vma_intersection(mm_struct_t* mm, uint64_t start, uint64_t end) {
     if (!mm) return NULL;
     
-    vm_area_struct_t* vma = mm->mmap;
-    while (vma) {
-        if (!(end <= vma->vm_start || start >= vma->vm_end)) {
-            return vma;
-        }
-        vma = vma->vm_next;
-    }
-    return NULL;
+    vm_itree_node_t* node = vm_itree_first_overlap(&mm->mm_rb, start, end);
+    return node ? VM_ITREE_ENTRY(node, vm_area_struct_t, vm_rb) : NULL;
 }
 
 /* ========================== Memory Mapping System Calls ========================== */
@@ -12,6 +12,7 @@
 #include <sys/wait.h>
 #include <sys/types.h>
 #include <errno.h>
+#include <spawn.h>
 
 #include "ikos_shell.h"
 #include "fs_user_api.h"
@@ -469,30 +470,28 @@ int shell_cmd_help(int argc, char* argv[]) {
 int shell_execute_external(int argc, char* argv[]) {
     if (argc == 0) return -1;
     
-    pid_t pid = fork();
+    /* Spawn rather than fork+exec: the shell's address space is never
+     * copied just to be thrown away by the exec */
+    extern char** environ;
+    pid_t pid;
+    int err = posix_spawnp(&pid, argv[0], NULL, NULL, argv, environ);
     
-    if (pid == 0) {
-        /* Child process */
-        execvp(argv[0], argv);
-        
-        /* If execvp returns, there was an error */
+    if (err == ENOENT) {
         fprintf(stderr, "shell: %s: command not found\n", argv[0]);
-        exit(127);
-    } else if (pid > 0) {
-        /* Parent process */
-        int status;
-        waitpid(pid, &status, 0);
-        
-        if (WIFEXITED(status)) {
-            return WEXITSTATUS(status);
-        } else {
-            return -1;
-        }
-    } else {
-        /* Fork failed */
+        return 127;
+    } else if (err != 0) {
         shell_print_error("shell: failed to create process");
         return -1;
     }
+    
+    int status;
+    waitpid(pid, &status, 0);
+    
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    } else {
+        return -1;
+    }
 }
 
 /* ===== Environment Management ===== */
@@ -7,6 +7,7 @@
 
 #include "../include/pthread.h"
 #include "../include/syscalls.h"
+#include "../include/futex.h"
 #include <stdint.h>
 #include <string.h>
 #include <stdbool.h>
@@ -74,6 +75,31 @@ static inline long syscall4(long number, long arg1, long arg2, long arg3, long a
     return result;
 }
 
+/* Kernel threading calls return negated errno values */
+static inline int kernel_errno(long result) {
+    return result < 0 ? (int)-result : 0;
+}
+
+/* Kernel object behind a statically initialized cond or rwlock, created on
+ * first use. Racing creators keep whichever ID was installed first. */
+static uint32_t lazy_kernel_id(uint32_t* slot, long init_nr, long destroy_nr) {
+    uint32_t id = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (id != 0) {
+        return id;
+    }
+
+    uint32_t created = 0;
+    if (syscall2(init_nr, (long)&created, 0) != 0) {
+        return 0;
+    }
+    if (__atomic_compare_exchange_n(slot, &id, created, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return created;
+    }
+    syscall1(destroy_nr, created);
+    return id;
+}
+
 /* ================================
  * Thread-Local Storage
  * ================================ */
@@ -309,10 +335,74 @@ void pthread_testcancel(void) {
  * Mutex Functions
  * ================================ */
 
-static uint32_t get_mutex_kernel_id(pthread_mutex_t* mutex) {
-    /* In a real implementation, we would map user-space mutex to kernel ID */
-    /* For now, use a simple mapping */
-    return (uint32_t)(uintptr_t)mutex;
+/*
+ * Mutexes are futex-based: the lock lives in mutex->futex and the
+ * uncontended lock and unlock are a single atomic instruction each. The
+ * kernel is entered only when a thread has to sleep (SYS_FUTEX_WAIT) or
+ * an unlocker sees there are sleepers to wake (SYS_FUTEX_WAKE).
+ */
+
+/* Lock word states */
+#define MUTEX_UNLOCKED          0
+#define MUTEX_LOCKED            1
+#define MUTEX_CONTENDED         2       /* Locked, and someone may be asleep */
+
+/* Mutex flags */
+#define MUTEX_FLAG_INITIALIZED  0x1
+#define MUTEX_FLAG_SHARED       0x2     /* PTHREAD_PROCESS_SHARED */
+
+static inline long mutex_futex_flags(const pthread_mutex_t* mutex) {
+    return (mutex->flags & MUTEX_FLAG_SHARED) ? 0 : FUTEX_PRIVATE;
+}
+
+static inline bool mutex_try_acquire(pthread_mutex_t* mutex) {
+    uint32_t expected = MUTEX_UNLOCKED;
+    return __atomic_compare_exchange_n(&mutex->futex, &expected, MUTEX_LOCKED, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+/* Contended path: mark the word CONTENDED so the eventual unlocker knows to
+ * wake someone, and sleep in the kernel until we take it from UNLOCKED. */
+static int mutex_lock_slow(pthread_mutex_t* mutex, const struct timespec* abstime) {
+    uint32_t c = __atomic_exchange_n(&mutex->futex, MUTEX_CONTENDED, __ATOMIC_ACQUIRE);
+    while (c != MUTEX_UNLOCKED) {
+        long result = syscall4(SYS_FUTEX_WAIT, (long)&mutex->futex, MUTEX_CONTENDED,
+                               (long)abstime, mutex_futex_flags(mutex));
+        if (result == THREAD_ETIMEDOUT) {
+            return ETIMEDOUT;
+        }
+        c = __atomic_exchange_n(&mutex->futex, MUTEX_CONTENDED, __ATOMIC_ACQUIRE);
+    }
+    return 0;
+}
+
+/* Relock by the owner: recursive mutexes count it, the others refuse. */
+static int mutex_relock(pthread_mutex_t* mutex) {
+    if (mutex->type == PTHREAD_MUTEX_RECURSIVE) {
+        mutex->lock_count++;
+        return 0;
+    }
+    return EDEADLK;
+}
+
+static int mutex_lock_common(pthread_mutex_t* mutex, const struct timespec* abstime) {
+    pthread_lib_init();
+
+    /* Only the owner can see its own ID here, so the unlocked read is safe */
+    if (mutex->owner == current_thread_id && mutex->lock_count > 0) {
+        return mutex_relock(mutex);
+    }
+
+    if (!mutex_try_acquire(mutex)) {
+        int result = mutex_lock_slow(mutex, abstime);
+        if (result != 0) {
+            return result;
+        }
+    }
+
+    mutex->owner = current_thread_id;
+    mutex->lock_count = 1;
+    return 0;
 }
 
 int pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attr) {
@@ -320,49 +410,38 @@ int pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attr)
     
     pthread_lib_init();
     
-    /* Initialize mutex structure */
+    /* Initialize mutex structure; no kernel object is needed */
     mutex->magic = 0x4D555458; // "MUTX"
     mutex->type = attr ? attr->type : PTHREAD_MUTEX_NORMAL;
     mutex->owner = 0;
     mutex->lock_count = 0;
-    mutex->waiters = 0;
+    mutex->futex = MUTEX_UNLOCKED;
     mutex->wait_queue = NULL;
     mutex->creation_time = 0; /* Would get from kernel */
-    mutex->flags = 0;
-    
-    /* Create kernel mutex */
-    uint32_t kernel_id;
-    int result = syscall2(SYS_MUTEX_INIT, (long)&kernel_id, (long)attr);
-    if (result == 0) {
-        /* Store kernel ID somehow - for now, just mark as initialized */
-        mutex->flags |= 1; /* Initialized flag */
+    mutex->flags = MUTEX_FLAG_INITIALIZED;
+    if (attr && attr->pshared == PTHREAD_PROCESS_SHARED) {
+        mutex->flags |= MUTEX_FLAG_SHARED;
     }
     
-    return result;
+    return 0;
 }
 
 int pthread_mutex_destroy(pthread_mutex_t* mutex) {
     if (!mutex || mutex->magic != 0x4D555458) return EINVAL;
     
-    pthread_lib_init();
-    
-    uint32_t kernel_id = get_mutex_kernel_id(mutex);
-    int result = syscall1(SYS_MUTEX_DESTROY, kernel_id);
-    
-    if (result == 0) {
-        memset(mutex, 0, sizeof(*mutex));
+    /* Can't destroy a locked mutex */
+    if (__atomic_load_n(&mutex->futex, __ATOMIC_ACQUIRE) != MUTEX_UNLOCKED) {
+        return EBUSY;
     }
     
-    return result;
+    memset(mutex, 0, sizeof(*mutex));
+    return 0;
 }
 
 int pthread_mutex_lock(pthread_mutex_t* mutex) {
     if (!mutex || mutex->magic != 0x4D555458) return EINVAL;
     
-    pthread_lib_init();
-    
-    uint32_t kernel_id = get_mutex_kernel_id(mutex);
-    return syscall1(SYS_MUTEX_LOCK, kernel_id);
+    return mutex_lock_common(mutex, NULL);
 }
 
 int pthread_mutex_trylock(pthread_mutex_t* mutex) {
@@ -370,15 +449,17 @@ int pthread_mutex_trylock(pthread_mutex_t* mutex) {
     
     pthread_lib_init();
     
-    uint32_t kernel_id = get_mutex_kernel_id(mutex);
-    int result = syscall1(SYS_MUTEX_TRYLOCK, kernel_id);
+    if (mutex->owner == current_thread_id && mutex->lock_count > 0) {
+        return mutex->type == PTHREAD_MUTEX_RECURSIVE ? mutex_relock(mutex) : EBUSY;
+    }
     
-    /* Convert kernel errors to pthread errors */
-    if (result == THREAD_EBUSY) {
+    if (!mutex_try_acquire(mutex)) {
         return EBUSY;
     }
     
-    return result;
+    mutex->owner = current_thread_id;
+    mutex->lock_count = 1;
+    return 0;
 }
 
 int pthread_mutex_unlock(pthread_mutex_t* mutex) {
@@ -386,17 +467,33 @@ int pthread_mutex_unlock(pthread_mutex_t* mutex) {
     
     pthread_lib_init();
     
-    uint32_t kernel_id = get_mutex_kernel_id(mutex);
-    return syscall1(SYS_MUTEX_UNLOCK, kernel_id);
+    /* Must be owner to unlock */
+    if (mutex->owner != current_thread_id || mutex->lock_count == 0) {
+        return EPERM;
+    }
+    
+    /* Handle recursive mutexes */
+    if (mutex->type == PTHREAD_MUTEX_RECURSIVE && --mutex->lock_count > 0) {
+        return 0;
+    }
+    
+    mutex->owner = 0;
+    mutex->lock_count = 0;
+    
+    /* LOCKED -> UNLOCKED needs nothing else. From CONTENDED, release the
+     * word fully and wake one sleeper, which will retake it as CONTENDED. */
+    if (__atomic_fetch_sub(&mutex->futex, 1, __ATOMIC_RELEASE) != MUTEX_LOCKED) {
+        __atomic_store_n(&mutex->futex, MUTEX_UNLOCKED, __ATOMIC_RELEASE);
+        syscall3(SYS_FUTEX_WAKE, (long)&mutex->futex, 1, mutex_futex_flags(mutex));
+    }
+    
+    return 0;
 }
 
 int pthread_mutex_timedlock(pthread_mutex_t* mutex, const struct timespec* abstime) {
     if (!mutex || mutex->magic != 0x4D555458 || !abstime) return EINVAL;
     
-    pthread_lib_init();
-    
-    uint32_t kernel_id = get_mutex_kernel_id(mutex);
-    return syscall2(SYS_MUTEX_TIMEDLOCK, kernel_id, (long)abstime);
+    return mutex_lock_common(mutex, abstime);
 }
 
 /* ================================
@@ -458,10 +555,6 @@ int pthread_mutexattr_getpshared(const pthread_mutexattr_t* attr, int* pshared)
  * Condition Variable Functions
  * ================================ */
 
-static uint32_t get_cond_kernel_id(pthread_cond_t* cond) {
-    return (uint32_t)(uintptr_t)cond;
-}
-
 int pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr) {
     if (!cond) return EINVAL;
     
@@ -473,14 +566,16 @@ int pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr) {
     cond->creation_time = 0;
     cond->flags = 0;
     cond->broadcast_seq = 0;
+    cond->kernel_id = 0;
     
     uint32_t kernel_id;
-    int result = syscall2(SYS_COND_INIT, (long)&kernel_id, (long)attr);
+    long result = syscall2(SYS_COND_INIT, (long)&kernel_id, (long)attr);
     if (result == 0) {
+        cond->kernel_id = kernel_id;
         cond->flags |= 1; /* Initialized flag */
     }
     
-    return result;
+    return kernel_errno(result);
 }
 
 int pthread_cond_destroy(pthread_cond_t* cond) {
@@ -488,26 +583,62 @@ int pthread_cond_destroy(pthread_cond_t* cond) {
     
     pthread_lib_init();
     
-    uint32_t kernel_id = get_cond_kernel_id(cond);
-    int result = syscall1(SYS_COND_DESTROY, kernel_id);
+    if (cond->kernel_id != 0) {
+        long result = syscall1(SYS_COND_DESTROY, cond->kernel_id);
+        if (result != 0) {
+            return kernel_errno(result);
+        }
+    }
     
-    if (result == 0) {
-        memset(cond, 0, sizeof(*cond));
+    memset(cond, 0, sizeof(*cond));
+    return 0;
+}
+
+static int cond_wait_common(pthread_cond_t* cond, pthread_mutex_t* mutex,
+                            const struct timespec* abstime) {
+    pthread_lib_init();
+    
+    if (mutex->owner != current_thread_id || mutex->lock_count == 0) {
+        return EPERM;
     }
     
-    return result;
+    uint32_t cond_id = lazy_kernel_id(&cond->kernel_id, SYS_COND_INIT, SYS_COND_DESTROY);
+    if (cond_id == 0) {
+        return ENOMEM;
+    }
+    
+    /* The kernel releases the lock word once we are queued on the cond,
+     * so a signal between the unlock and the sleep is not lost. */
+    uint32_t lock_count = mutex->lock_count;
+    mutex->owner = 0;
+    mutex->lock_count = 0;
+    
+    long result = abstime ?
+        syscall4(SYS_COND_TIMEDWAIT, cond_id, (long)&mutex->futex,
+                 mutex_futex_flags(mutex), (long)abstime) :
+        syscall3(SYS_COND_WAIT, cond_id, (long)&mutex->futex, mutex_futex_flags(mutex));
+    
+    if (result != THREAD_SUCCESS && result != THREAD_ETIMEDOUT) {
+        /* Refused before the unlock: we still hold the mutex */
+        mutex->owner = current_thread_id;
+        mutex->lock_count = lock_count;
+        return kernel_errno(result);
+    }
+    
+    /* A broadcast may have requeued other waiters onto the mutex; take it
+     * as contended so our unlock wakes the next of them. */
+    mutex_lock_slow(mutex, NULL);
+    mutex->owner = current_thread_id;
+    mutex->lock_count = lock_count;
+    
+    return kernel_errno(result);
 }
 
 int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex) {
     if (!cond || cond->magic != 0x434F4E44 ||
         !mutex || mutex->magic != 0x4D555458) return EINVAL;
     
-    pthread_lib_init();
-    
-    uint32_t cond_id = get_cond_kernel_id(cond);
-    uint32_t mutex_id = get_mutex_kernel_id(mutex);
-    
-    return syscall2(SYS_COND_WAIT, cond_id, mutex_id);
+    return cond_wait_common(cond, mutex, NULL);
 }
 
 int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex,
@@ -515,30 +646,30 @@ int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex,
     if (!cond || cond->magic != 0x434F4E44 ||
         !mutex || mutex->magic != 0x4D555458 || !abstime) return EINVAL;
     
-    pthread_lib_init();
-    
-    uint32_t cond_id = get_cond_kernel_id(cond);
-    uint32_t mutex_id = get_mutex_kernel_id(mutex);
-    
-    return syscall3(SYS_COND_TIMEDWAIT, cond_id, mutex_id, (long)abstime);
+    return cond_wait_common(cond, mutex, abstime);
 }
 
 int pthread_cond_signal(pthread_cond_t* cond) {
     if (!cond || cond->magic != 0x434F4E44) return EINVAL;
     
-    pthread_lib_init();
+    /* No kernel object yet means nobody has ever waited */
+    uint32_t kernel_id = __atomic_load_n(&cond->kernel_id, __ATOMIC_ACQUIRE);
+    if (kernel_id == 0) {
+        return 0;
+    }
     
-    uint32_t kernel_id = get_cond_kernel_id(cond);
-    return syscall1(SYS_COND_SIGNAL, kernel_id);
+    return kernel_errno(syscall1(SYS_COND_SIGNAL, kernel_id));
 }
 
 int pthread_cond_broadcast(pthread_cond_t* cond) {
     if (!cond || cond->magic != 0x434F4E44) return EINVAL;
     
-    pthread_lib_init();
+    uint32_t kernel_id = __atomic_load_n(&cond->kernel_id, __ATOMIC_ACQUIRE);
+    if (kernel_id == 0) {
+        return 0;
+    }
     
-    uint32_t kernel_id = get_cond_kernel_id(cond);
-    return syscall1(SYS_COND_BROADCAST, kernel_id);
+    return kernel_errno(syscall1(SYS_COND_BROADCAST, kernel_id));
 }
 
 /* ================================
@@ -580,10 +711,6 @@ int pthread_condattr_getpshared(const pthread_condattr_t* attr, int* pshared) {
  * Semaphore Functions
  * ================================ */
 
-static uint32_t get_sem_kernel_id(sem_t* sem) {
-    return (uint32_t)(uintptr_t)sem;
-}
-
 int sem_init(sem_t* sem, int pshared, unsigned int value) {
     if (!sem || value > SEM_VALUE_MAX) return EINVAL;
     
@@ -596,81 +723,57 @@ int sem_init(sem_t* sem, int pshared, unsigned int value) {
     sem->wait_queue = NULL;
     sem->creation_time = 0;
     sem->flags = 0;
+    sem->kernel_id = 0;
     
     uint32_t kernel_id;
-    int result = syscall3(SYS_SEM_INIT, (long)&kernel_id, pshared, value);
+    long result = syscall3(SYS_SEM_INIT, (long)&kernel_id, pshared, value);
     if (result == 0) {
+        sem->kernel_id = kernel_id;
         sem->flags |= 1; /* Initialized flag */
     }
     
-    return result;
+    return kernel_errno(result);
 }
 
 int sem_destroy(sem_t* sem) {
     if (!sem || sem->magic != 0x53454D41) return EINVAL;
     
-    pthread_lib_init();
-    
-    uint32_t kernel_id = get_sem_kernel_id(sem);
-    int result = syscall1(SYS_SEM_DESTROY, kernel_id);
-    
+    long result = syscall1(SYS_SEM_DESTROY, sem->kernel_id);
     if (result == 0) {
         memset(sem, 0, sizeof(*sem));
     }
     
-    return result;
+    return kernel_errno(result);
 }
 
 int sem_wait(sem_t* sem) {
     if (!sem || sem->magic != 0x53454D41) return EINVAL;
     
-    pthread_lib_init();
-    
-    uint32_t kernel_id = get_sem_kernel_id(sem);
-    return syscall1(SYS_SEM_WAIT, kernel_id);
+    return kernel_errno(syscall1(SYS_SEM_WAIT, sem->kernel_id));
 }
 
 int sem_trywait(sem_t* sem) {
     if (!sem || sem->magic != 0x53454D41) return EINVAL;
     
-    pthread_lib_init();
-    
-    uint32_t kernel_id = get_sem_kernel_id(sem);
-    int result = syscall1(SYS_SEM_TRYWAIT, kernel_id);
-    
-    /* Convert kernel errors to standard errors */
-    if (result == THREAD_EAGAIN) {
-        return EAGAIN;
-    }
-    
-    return result;
+    return kernel_errno(syscall1(SYS_SEM_TRYWAIT, sem->kernel_id));
 }
 
 int sem_timedwait(sem_t* sem, const struct timespec* abs_timeout) {
     if (!sem || sem->magic != 0x53454D41 || !abs_timeout) return EINVAL;
     
-    pthread_lib_init();
-    
-    uint32_t kernel_id = get_sem_kernel_id(sem);
-    return syscall2(SYS_SEM_TIMEDWAIT, kernel_id, (long)abs_timeout);
+    return kernel_errno(syscall2(SYS_SEM_TIMEDWAIT, sem->kernel_id, (long)abs_timeout));
 }
 
 int sem_post(sem_t* sem) {
     if (!sem || sem->magic != 0x53454D41) return EINVAL;
     
-    pthread_lib_init();
-    
-    uint32_t kernel_id = get_sem_kernel_id(sem);
-    return syscall1(SYS_SEM_POST, kernel_id);
+    return kernel_errno(syscall1(SYS_SEM_POST, sem->kernel_id));
 }
 
 int sem_getvalue(sem_t* sem, int* sval) {
     if (!sem || sem->magic != 0x53454D41 || !sval) return EINVAL;
     
-    pthread_lib_init();
-    
-    uint32_t kernel_id = get_sem_kernel_id(sem);
-    return syscall2(SYS_SEM_GETVALUE, kernel_id, (long)sval);
+    return kernel_errno(syscall2(SYS_SEM_GETVALUE, sem->kernel_id, (long)sval));
 }
 
 /* Named semaphores - not implemented */
@@ -759,73 +862,96 @@ int pthread_list_threads(pthread_t* threads, size_t max_count) {
  * Simplified implementations for other functions
  * ================================ */
 
-/* Read-write locks - simplified */
+/* Read-write locks: sleep in the kernel, which admits readers and writers
+ * in alternating phases so neither side starves */
+static uint32_t rwlock_kernel_id(pthread_rwlock_t* rwlock) {
+    return lazy_kernel_id(&rwlock->kernel_id, SYS_RWLOCK_INIT, SYS_RWLOCK_DESTROY);
+}
+
+static int rwlock_call(pthread_rwlock_t* rwlock, long number) {
+    if (!rwlock || rwlock->magic != 0x52574C4B) return EINVAL;
+    
+    uint32_t kernel_id = rwlock_kernel_id(rwlock);
+    if (kernel_id == 0) return ENOMEM;
+    
+    return kernel_errno(syscall1(number, kernel_id));
+}
+
 int pthread_rwlock_init(pthread_rwlock_t* rwlock, const pthread_rwlockattr_t* attr) {
     if (!rwlock) return EINVAL;
     
+    memset(rwlock, 0, sizeof(*rwlock));
     rwlock->magic = 0x52574C4B; // "RWLK"
     uint32_t kernel_id;
-    return syscall2(SYS_RWLOCK_INIT, (long)&kernel_id, (long)attr);
+    long result = syscall2(SYS_RWLOCK_INIT, (long)&kernel_id, (long)attr);
+    if (result == 0) {
+        rwlock->kernel_id = kernel_id;
+    }
+    return kernel_errno(result);
 }
 
 int pthread_rwlock_destroy(pthread_rwlock_t* rwlock) {
     if (!rwlock || rwlock->magic != 0x52574C4B) return EINVAL;
     
-    uint32_t kernel_id = (uint32_t)(uintptr_t)rwlock;
-    return syscall1(SYS_RWLOCK_DESTROY, kernel_id);
+    if (rwlock->kernel_id != 0) {
+        long result = syscall1(SYS_RWLOCK_DESTROY, rwlock->kernel_id);
+        if (result != 0) {
+            return kernel_errno(result);
+        }
+    }
+    memset(rwlock, 0, sizeof(*rwlock));
+    return 0;
 }
 
 int pthread_rwlock_rdlock(pthread_rwlock_t* rwlock) {
-    if (!rwlock || rwlock->magic != 0x52574C4B) return EINVAL;
-    
-    uint32_t kernel_id = (uint32_t)(uintptr_t)rwlock;
-    return syscall1(SYS_RWLOCK_RDLOCK, kernel_id);
+    return rwlock_call(rwlock, SYS_RWLOCK_RDLOCK);
 }
 
 int pthread_rwlock_wrlock(pthread_rwlock_t* rwlock) {
-    if (!rwlock || rwlock->magic != 0x52574C4B) return EINVAL;
-    
-    uint32_t kernel_id = (uint32_t)(uintptr_t)rwlock;
-    return syscall1(SYS_RWLOCK_WRLOCK, kernel_id);
+    return rwlock_call(rwlock, SYS_RWLOCK_WRLOCK);
 }
 
 int pthread_rwlock_unlock(pthread_rwlock_t* rwlock) {
-    if (!rwlock || rwlock->magic != 0x52574C4B) return EINVAL;
-    
-    uint32_t kernel_id = (uint32_t)(uintptr_t)rwlock;
-    return syscall1(SYS_RWLOCK_UNLOCK, kernel_id);
+    return rwlock_call(rwlock, SYS_RWLOCK_UNLOCK);
 }
 
-/* Barriers - simplified */
+/* Barriers: the last thread to arrive releases the rest in one wake */
 int pthread_barrier_init(pthread_barrier_t* barrier, const pthread_barrierattr_t* attr,
                          unsigned int count) {
     if (!barrier || count == 0) return EINVAL;
     
+    memset(barrier, 0, sizeof(*barrier));
     barrier->magic = 0x42415252; // "BARR"
     barrier->count = count;
     uint32_t kernel_id;
-    return syscall3(SYS_BARRIER_INIT, (long)&kernel_id, (long)attr, count);
+    long result = syscall3(SYS_BARRIER_INIT, (long)&kernel_id, (long)attr, count);
+    if (result == 0) {
+        barrier->kernel_id = kernel_id;
+    }
+    return kernel_errno(result);
 }
 
 int pthread_barrier_destroy(pthread_barrier_t* barrier) {
     if (!barrier || barrier->magic != 0x42415252) return EINVAL;
     
-    uint32_t kernel_id = (uint32_t)(uintptr_t)barrier;
-    return syscall1(SYS_BARRIER_DESTROY, kernel_id);
+    long result = syscall1(SYS_BARRIER_DESTROY, barrier->kernel_id);
+    if (result == 0) {
+        memset(barrier, 0, sizeof(*barrier));
+    }
+    return kernel_errno(result);
 }
 
 int pthread_barrier_wait(pthread_barrier_t* barrier) {
     if (!barrier || barrier->magic != 0x42415252) return EINVAL;
     
-    uint32_t kernel_id = (uint32_t)(uintptr_t)barrier;
-    int result = syscall1(SYS_BARRIER_WAIT, kernel_id);
+    long result = syscall1(SYS_BARRIER_WAIT, barrier->kernel_id);
     
     /* Return special value for the last thread */
     if (result == 1) {
         return PTHREAD_BARRIER_SERIAL_THREAD;
     }
     
-    return result;
+    return kernel_errno(result);
 }
 
 /* Spinlocks - simplified */
@@ -922,15 +1048,11 @@ int pthread_barrierattr_destroy(pthread_barrierattr_t* attr) {
 
 /* Remaining read-write lock and barrier functions */
 int pthread_rwlock_tryrdlock(pthread_rwlock_t* rwlock) {
-    if (!rwlock || rwlock->magic != 0x52574C4B) return EINVAL;
-    uint32_t kernel_id = (uint32_t)(uintptr_t)rwlock;
-    return syscall1(SYS_RWLOCK_TRYRDLOCK, kernel_id);
+    return rwlock_call(rwlock, SYS_RWLOCK_TRYRDLOCK);
 }
 
 int pthread_rwlock_trywrlock(pthread_rwlock_t* rwlock) {
-    if (!rwlock || rwlock->magic != 0x52574C4B) return EINVAL;
-    uint32_t kernel_id = (uint32_t)(uintptr_t)rwlock;
-    return syscall1(SYS_RWLOCK_TRYWRLOCK, kernel_id);
+    return rwlock_call(rwlock, SYS_RWLOCK_TRYWRLOCK);
 }
 
 int pthread_rwlock_timedrdlock(pthread_rwlock_t* rwlock, const struct timespec* abstime) {